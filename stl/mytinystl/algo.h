@@ -96,12 +96,48 @@ size_t count_if(InputIter first, InputIter last, UnaryPredicate unary_pred)
 // 在[first, last)区间内找到等于 value 的元素，返回指向该元素的迭代器
 /*****************************************************************************************/
 template <typename InputIter, typename T>
-InputIter find(InputIter first, InputIter last, const T& value)
+InputIter find(InputIter first, InputIter last, const T& value);
+
+// 分段迭代器的版本：逐段查找，每一段都是一对指针
+template <typename InputIter, typename T>
+InputIter segmented_find(InputIter first, InputIter last, const T& value, m_true_type)
+{
+    typedef segmented_iterator_traits<InputIter> traits;
+    auto sfirst = traits::segment(first);
+    const auto slast = traits::segment(last);
+    if(sfirst == slast)
+    {
+        return traits::compose(sfirst, mystl::find(traits::local(first), traits::local(last), value));
+    }
+    auto cur = mystl::find(traits::local(first), traits::end(sfirst), value);
+    if(cur != traits::end(sfirst))
+    {
+        return traits::compose(sfirst, cur);
+    }
+    for(++sfirst; sfirst != slast; ++sfirst)
+    {
+        cur = mystl::find(traits::begin(sfirst), traits::end(sfirst), value);
+        if(cur != traits::end(sfirst))
+        {
+            return traits::compose(sfirst, cur);
+        }
+    }
+    return traits::compose(slast, mystl::find(traits::begin(slast), traits::local(last), value));
+}
+
+template <typename InputIter, typename T>
+InputIter segmented_find(InputIter first, InputIter last, const T& value, m_false_type)
 {
     while(first != last && *first != value)++first;
     return first;
 }
 
+template <typename InputIter, typename T>
+InputIter find(InputIter first, InputIter last, const T& value)
+{
+    return segmented_find(first, last, value, is_segmented_iterator<InputIter>{});
+}
+
 /*****************************************************************************************/
 // find_if
 // 在[first, last)区间内找到第一个令一元操作 unary_pred 为 true 的元素并返回指向该元素的迭代器
@@ -383,8 +419,26 @@ InputIter find_first_of(InputIter first1, InputIter last1, ForwardIter first2, F
 // 使用一个函数对象 f 对[first, last)区间内的每个元素执行一个 operator() 操作，但不能改变元素内容
 // f() 可返回一个值，但该值会被忽略
 /*****************************************************************************************/
+// 分段迭代器的版本：逐段执行，每一段都是一对指针
 template <typename InputIter, typename Function>
-Function for_each(InputIter first, InputIter last, Function f)
+Function segmented_for_each(InputIter first, InputIter last, Function f, m_true_type)
+{
+    typedef segmented_iterator_traits<InputIter> traits;
+    auto sfirst = traits::segment(first);
+    const auto slast = traits::segment(last);
+    auto cur = traits::local(first);
+    for(; sfirst != slast; ++sfirst, cur = traits::begin(sfirst))
+    {
+        for(auto end = traits::end(sfirst); cur != end; ++cur)
+            f(*cur);
+    }
+    for(auto end = traits::local(last); cur != end; ++cur)
+        f(*cur);
+    return f;
+}
+
+template <typename InputIter, typename Function>
+Function segmented_for_each(InputIter first, InputIter last, Function f, m_false_type)
 {
     for(; first != last; ++first)
     {
@@ -393,6 +447,12 @@ Function for_each(InputIter first, InputIter last, Function f)
     return f;
 }
 
+template <typename InputIter, typename Function>
+Function for_each(InputIter first, InputIter last, Function f)
+{
+    return segmented_for_each(first, last, f, is_segmented_iterator<InputIter>{});
+}
+
 /*****************************************************************************************/
 // adjacent_find
 // 找出第一对匹配的相邻元素，缺省使用 operator== 比较，如果找到返回一个迭代器，指向这对元素的第一个元素
@@ -1320,13 +1380,42 @@ RandomIter rotate_dispatch(RandomIter first, RandomIter middle, RandomIter last,
         mystl::swap_ranges(first, middle, middle);
         return result;
     }
+    // 分成 gcd(n, l) 个环，每个环上的元素依次向前挪动 l 个位置
     auto cycle_times = rgcd(n, l);
-    for(auto i = 0; i < cycle_times; ++i)
+    for(decltype(n) i = 0; i < cycle_times; ++i)
     {
-        auto tmp = *first;
+        auto tmp = mystl::move(*first);
         auto p = first;
-
+        if(l < r)
+        {
+            for(decltype(n) j = 0; j < r / cycle_times; ++j)
+            {
+                if(p > first + r)
+                {
+                    *p = mystl::move(*(p - r));
+                    p -= r;
+                }
+                *p = mystl::move(*(p + l));
+                p += l;
+            }
+        }
+        else
+        {
+            for(decltype(n) j = 0; j < l / cycle_times - 1; ++j)
+            {
+                if(p < last - l)
+                {
+                    *p = mystl::move(*(p + l));
+                    p += l;
+                }
+                *p = mystl::move(*(p - r));
+                p -= r;
+            }
+        }
+        *p = mystl::move(tmp);
+        ++first;
     }
+    return result;
 }
 
 template <typename ForwardIter>
@@ -1578,6 +1667,49 @@ OutputIter merge(InputIter1 first1, InputIter1 last1, InputIter2 first2, InputIt
     return mystl::copy(first2, last2, mystl::copy(first1, last1, result));
 }
 
+// move_merge
+// 与 merge 相同，但把元素移动而不是复制到 result，供 inplace_merge 与 stable_sort 在缓冲区与区间之间搬运元素
+template <typename InputIter1, typename InputIter2, typename OutputIter>
+OutputIter move_merge(InputIter1 first1, InputIter1 last1, InputIter2 first2, InputIter2 last2, OutputIter result)
+{
+    while(first1 != last1 && first2 != last2)
+    {
+        if(*first2 < *first1)
+        {
+            *result = mystl::move(*first2);
+            ++first2;
+        }
+        else
+        {
+            *result = mystl::move(*first1);
+            ++first1;
+        }
+        ++result;
+    }
+    return mystl::move(first2, last2, mystl::move(first1, last1, result));
+}
+
+template <typename InputIter1, typename InputIter2, typename OutputIter, typename Compared>
+OutputIter move_merge(InputIter1 first1, InputIter1 last1, InputIter2 first2, InputIter2 last2,
+                      OutputIter result, Compared comp)
+{
+    while(first1 != last1 && first2 != last2)
+    {
+        if(comp(*first2, *first1))
+        {
+            *result = mystl::move(*first2);
+            ++first2;
+        }
+        else
+        {
+            *result = mystl::move(*first1);
+            ++first1;
+        }
+        ++result;
+    }
+    return mystl::move(first2, last2, mystl::move(first1, last1, result));
+}
+
 /*****************************************************************************************/
 // inplace_merge
 // 把连接在一起的两个有序序列结合成单一序列并保持有序
@@ -1609,7 +1741,7 @@ void merge_without_buffer(BidirectionalIter first, BidirectionalIter middle, Bid
     {
         // 序列二较长，找到序列二的中点
         len22 = len2 >> 1;
-        mystl::advance(middle, len22);
+        mystl::advance(second_cut, len22);
         first_cut = mystl::upper_bound(first, middle, *second_cut);
         len11 = mystl::distance(first, first_cut);
     }
@@ -1622,22 +1754,22 @@ template <typename BidirectionalIter1, typename BidirectionalIter2>
 BidirectionalIter1 merge_backward(BidirectionalIter1 first1, BidirectionalIter1 last1,
                                     BidirectionalIter2 first2, BidirectionalIter2 last2, BidirectionalIter1 result)
 {
-    if(first1 == last1)return mystl::copy_backward(first2, last2, result);
-    if(first2 == last2)return mystl::copy_backward(first1, last1, result);
+    if(first1 == last1)return mystl::move_backward(first2, last2, result);
+    if(first2 == last2)return mystl::move_backward(first1, last1, result);
     --last1;
     --last2;
     while(true)
     {
         if(*last2 < *last1)
         {
-            *--result = *last1;
-            if(first1 == last1)return mystl::copy_backward(first2, ++last2, result);
+            *--result = mystl::move(*last1);
+            if(first1 == last1)return mystl::move_backward(first2, ++last2, result);
             --last1;
         }
         else
         {
-            *--result = *last2;
-            if(first2 == last2)return mystl::copy_backward(first1, ++last1, result);
+            *--result = mystl::move(*last2);
+            if(first2 == last2)return mystl::move_backward(first1, ++last1, result);
             --last2;
         }
     }
@@ -1650,15 +1782,15 @@ BidirectionalIter1 rotate_adaptive(BidirectionalIter1 first, BidirectionalIter1
     BidirectionalIter2 buffer_end;
     if(len1 > len2 && len2 <= buffer_size)
     {
-        buffer_end = mystl::copy(middle, last, buffer);
-        mystl::copy_backward(first, middle, last);
-        return mystl::copy(buffer, buffer_end, first);
+        buffer_end = mystl::move(middle, last, buffer);
+        mystl::move_backward(first, middle, last);
+        return mystl::move(buffer, buffer_end, first);
     }
     else if(len1 <= buffer_size)
     {
-        buffer_end = mystl::copy(first, middle, buffer);
-        mystl::copy(middle, last, first);
-        return mystl::copy_backward(buffer, buffer_end, last);
+        buffer_end = mystl::move(first, middle, buffer);
+        mystl::move(middle, last, first);
+        return mystl::move_backward(buffer, buffer_end, last);
     }
     else
     {
@@ -1674,12 +1806,12 @@ void merge_adaptive(BidirectionalIter first, BidirectionalIter middle, Bidirecti
     // 区间长度足够放进缓冲区
     if(len1 <= len2 && len1 <= buffer_size)
     {
-        Pointer buffer_end = mystl::copy(first, middle, buffer);
-        mystl::merge(buffer, buffer_end, middle, last, first);
+        Pointer buffer_end = mystl::move(first, middle, buffer);
+        mystl::move_merge(buffer, buffer_end, middle, last, first);
     }
     else if(len2 <= buffer_size)
     {
-        Pointer buffer_end = mystl::copy(middle, last, buffer);
+        Pointer buffer_end = mystl::move(middle, last, buffer);
         mystl::merge_backward(first, middle, buffer, buffer_end, last);
     }
     else
@@ -1760,7 +1892,7 @@ void merge_without_buffer(BidirectionalIter first, BidirectionalIter middle, Bid
     {
         // 序列二较长，找到序列二的中点
         len22 = len2 >> 1;
-        mystl::advance(middle, len22);
+        mystl::advance(second_cut, len22);
         first_cut = mystl::upper_bound(first, middle, *second_cut, comp);
         len11 = mystl::distance(first, first_cut);
     }
@@ -1773,22 +1905,22 @@ template <typename BidirectionalIter1, typename BidirectionalIter2, typename Com
 BidirectionalIter1 merge_backward(BidirectionalIter1 first1, BidirectionalIter1 last1,
                                     BidirectionalIter2 first2, BidirectionalIter2 last2, BidirectionalIter1 result, Compared comp)
 {
-    if(first1 == last1)return mystl::copy_backward(first2, last2, result);
-    if(first2 == last2)return mystl::copy_backward(first1, last1, result);
+    if(first1 == last1)return mystl::move_backward(first2, last2, result);
+    if(first2 == last2)return mystl::move_backward(first1, last1, result);
     --last1;
     --last2;
     while(true)
     {
         if(comp(*last2, *last1))
         {
-            *--result = *last1;
-            if(first1 == last1)return mystl::copy_backward(first2, ++last2, result);
+            *--result = mystl::move(*last1);
+            if(first1 == last1)return mystl::move_backward(first2, ++last2, result);
             --last1;
         }
         else
         {
-            *--result = *last2;
-            if(first2 == last2)return mystl::copy_backward(first1, ++last1, result);
+            *--result = mystl::move(*last2);
+            if(first2 == last2)return mystl::move_backward(first1, ++last1, result);
             --last2;
         }
     }
@@ -1802,12 +1934,12 @@ void merge_adaptive(BidirectionalIter first, BidirectionalIter middle, Bidirecti
     // 区间长度足够放进缓冲区
     if(len1 <= len2 && len1 <= buffer_size)
     {
-        Pointer buffer_end = mystl::copy(first, middle, buffer);
-        mystl::merge(buffer, buffer_end, middle, last, first);
+        Pointer buffer_end = mystl::move(first, middle, buffer);
+        mystl::move_merge(buffer, buffer_end, middle, last, first, comp);
     }
     else if(len2 <= buffer_size)
     {
-        Pointer buffer_end = mystl::copy(middle, last, buffer);
+        Pointer buffer_end = mystl::move(middle, last, buffer);
         mystl::merge_backward(first, middle, buffer, buffer_end, last, comp);
     }
     else
@@ -1821,14 +1953,14 @@ void merge_adaptive(BidirectionalIter first, BidirectionalIter middle, Bidirecti
         {
             len11 = len1 >> 1;
             mystl::advance(first_cut, len11);
-            second_cut = mystl::lower_bound(middle, last, *first_cut);
+            second_cut = mystl::lower_bound(middle, last, *first_cut, comp);
             len22 = mystl::distance(middle, second_cut);
         }
         else
         {
             len22 = len2 >> 1;
             mystl::advance(second_cut, len22);
-            first_cut = mystl::upper_bound(first, middle, *second_cut);
+            first_cut = mystl::upper_bound(first, middle, *second_cut, comp);
             len11 = mystl::distance(first, first_cut);
         }
         auto new_middle = mystl::rotate_adaptive(first_cut, middle, second_cut, len1 - len11, len22, buffer, buffer_size);
@@ -1872,7 +2004,7 @@ void partial_sort(RandomIter first, RandomIter middle, RandomIter last)
     {
         if(*i < *first)
         {
-            mystl::pop_heap_aux(first, middle, i, *i, distance_type(first));
+            mystl::pop_heap_aux(first, middle, i, mystl::move(*i), distance_type(first));
         }
     }
     mystl::sort_heap(first, middle);
@@ -1887,7 +2019,7 @@ void partial_sort(RandomIter first, RandomIter middle, RandomIter last, Compared
     {
         if(comp(*i, *first))
         {
-            mystl::pop_heap_aux(first, middle, i, *i, distance_type(first), comp);
+            mystl::pop_heap_aux(first, middle, i, mystl::move(*i), distance_type(first), comp);
         }
     }
     mystl::sort_heap(first, middle, comp);
@@ -1997,266 +2129,710 @@ partition_copy(InputIter first, InputIter last, OutputIter1 result_true, OutputI
 }
 
 /*****************************************************************************************/
-// sort
-// 将[first, last)内的元素以递增的方式排序
+// stable_partition
+// 行为与 partition 类似，但保持元素的原始相对位置，返回指向第一个判定为 false 的元素的迭代器
+// 申请到临时缓冲区时把判定为 false 的元素暂存到缓冲区，申请不到时分割递归，用 rotate 合并
 /*****************************************************************************************/
-constexpr static size_t kSmallSectionSize = 128;  // 小型区间的大小，在这个大小内采用插入排序
-
-// 用于控制分割恶化的情况
-template <typename Size>
-Size slg2(Size n)
+// 没有缓冲区的情况下分割，len 为区间长度，不为 0
+template <typename BidirectionalIter, typename UnaryPredicate, typename Distance>
+BidirectionalIter inplace_stable_partition(BidirectionalIter first, BidirectionalIter last,
+                                           UnaryPredicate unary_pred, Distance len)
 {
-    Size k = 0;
-    for(; n > 1; n >>= 1)++k;
-    return k;
+    if(len == 1)return unary_pred(*first) ? last : first;
+    auto middle = first;
+    mystl::advance(middle, len / 2);
+    auto left = mystl::inplace_stable_partition(first, middle, unary_pred, len / 2);
+    auto right = mystl::inplace_stable_partition(middle, last, unary_pred, len - len / 2);
+    return mystl::rotate(left, middle, right);
 }
 
-// 分割函数 unchecked_partition
-template <class RandomIter, class T>
-RandomIter unchecked_partition(RandomIter first, RandomIter last, const T& pivot)
+// 有缓冲区的情况下分割
+template <typename BidirectionalIter, typename UnaryPredicate, typename Distance, typename Pointer>
+BidirectionalIter stable_partition_adaptive(BidirectionalIter first, BidirectionalIter last, UnaryPredicate unary_pred,
+                                            Distance len, Pointer buffer, Distance buffer_size)
 {
-    while(true)
+    if(len <= buffer_size)
     {
-        while(*first < pivot)++first;
-        --last;
-        while(pivot < *last)--last;
-        if(!(first < last))return first;
-        mystl::iter_swap(first, last);
-        ++first;
+        // 判定为 true 的元素依次前移，其余的暂存到缓冲区，最后接在后面
+        auto result1 = first;
+        auto result2 = buffer;
+        for(; first != last; ++first)
+        {
+            if(unary_pred(*first))
+            {
+                *result1 = *first;
+                ++result1;
+            }
+            else
+            {
+                *result2 = *first;
+                ++result2;
+            }
+        }
+        mystl::copy(buffer, result2, result1);
+        return result1;
     }
+    auto middle = first;
+    mystl::advance(middle, len / 2);
+    auto left = mystl::stable_partition_adaptive(first, middle, unary_pred, len / 2, buffer, buffer_size);
+    auto right = mystl::stable_partition_adaptive(middle, last, unary_pred, len - len / 2, buffer, buffer_size);
+    return mystl::rotate_adaptive(left, middle, right, static_cast<Distance>(mystl::distance(left, middle)),
+                                  static_cast<Distance>(mystl::distance(middle, right)), buffer, buffer_size);
 }
 
-// 内省式排序，先进行 quick sort，当分割行为有恶化倾向时，改用 heap sort
-template <class RandomIter, class Size>
-void intro_sort(RandomIter first, RandomIter last, Size depth_limit)
+template <typename BidirectionalIter, typename UnaryPredicate, typename T, typename Distance>
+BidirectionalIter stable_partition_aux(BidirectionalIter first, BidirectionalIter last,
+                                       UnaryPredicate unary_pred, T*, Distance*)
 {
-    while(static_cast<size_t>(last - first) > kSmallSectionSize)
+    // 开头已经判定为 true 的元素不需要移动
+    first = mystl::find_if_not(first, last, unary_pred);
+    if(first == last)return first;
+    const Distance len = mystl::distance(first, last);
+    temporary_buffer<BidirectionalIter, T> buf(first, last);
+    if(!buf.begin())
     {
-        if(depth_limit == 0)
-        {
-            // 到达最大分割深度限制
-            mystl::partial_sort(first, last, last);  // 改用 heap_sort
-            return;
-        }
-        --depth_limit;
-        auto mid = mystl::median(*first, *(first + (last - first) / 2), *(last - 1));
-        auto cut = mystl::unchecked_partition(first, last, mid);
-        mystl::intro_sort(cut, last, depth_limit);
-        last = cut;
+        return mystl::inplace_stable_partition(first, last, unary_pred, len);
     }
+    return mystl::stable_partition_adaptive(first, last, unary_pred, len, buf.begin(),
+                                            static_cast<Distance>(buf.size()));
+}
+
+template <typename BidirectionalIter, typename UnaryPredicate>
+BidirectionalIter stable_partition(BidirectionalIter first, BidirectionalIter last, UnaryPredicate unary_pred)
+{
+    return mystl::stable_partition_aux(first, last, unary_pred, value_type(first), distance_type(first));
 }
 
+/*****************************************************************************************/
+// sort
+// 将[first, last)内的元素以递增的方式排序
+// 使用 pattern-defeating quicksort(pdqsort)，排序过程中只移动元素，不复制元素：
+//   * 小区间使用插入排序，区间较大时以九点中值(ninther)作为枢轴，否则取三点中值
+//   * 分割时没有发生交换，说明区间可能已经有序，先尝试有限次数的插入排序，有序或逆序的输入只需线性时间
+//   * 分割极不平衡时交换几个元素打乱输入的模式，次数过多则改用 heap sort，最坏复杂度为 O(N logN)
+//   * 枢轴与左边相邻的元素相等时，把与枢轴相等的元素一次分到左边，重复元素很多时接近线性
+//   * 元素为算术类型且使用 less / greater 比较时，改用没有分支的块分割(block partition)
+/*****************************************************************************************/
+constexpr static ptrdiff_t kSmallSectionSize   = 24;   // 小型区间的大小，在这个大小内采用插入排序
+constexpr static ptrdiff_t kNintherThreshold   = 128;  // 超过这个大小时用九点中值选取枢轴
+constexpr static ptrdiff_t kPartialInsertLimit = 8;    // 尝试插入排序时最多移动的元素个数
+constexpr static size_t    kBlockSize          = 64;   // 块分割中每一块的元素个数
+
+// 用于控制分割恶化的情况
+template <typename Size>
+Size slg2(Size n)
+{
+    Size k = 0;
+    for(; n > 1; n >>= 1)++k;
+    return k;
+}
+
+// 比较没有副作用且代价很低时才值得使用块分割
+template <class T, class Compared>
+struct use_block_partition
+    : std::integral_constant<bool, std::is_arithmetic<T>::value &&
+                                   (std::is_same<Compared, mystl::less<T>>::value ||
+                                    std::is_same<Compared, mystl::greater<T>>::value)>
+{
+};
+
 // 插入排序辅助函数 unchecked_linear_insert
-template <typename RandomIter, typename T>
-void unchecked_linear_insert(RandomIter last, const T& value)
+// value 为原来位于 last 的元素，last 之前一定存在不大于 value 的元素
+template <class RandomIter, class T, class Compared>
+void unchecked_linear_insert(RandomIter last, T value, Compared comp)
 {
     auto next = last;
     --next;
-    while(value < *next)
+    while(comp(value, *next))
     {
-        *last = *next;
+        *last = mystl::move(*next);
         last = next;
         --next;
     }
-    *last = value;
+    *last = mystl::move(value);
 }
 
-// 插入排序函数 unchecked_insertion_sort
-template <class RandomIter>
-void unchecked_insertion_sort(RandomIter first, RandomIter last)
+// 插入排序函数 unchecked_insertion_sort，first 之前一定存在不大于区间内所有元素的元素
+template <class RandomIter, class Compared>
+void unchecked_insertion_sort(RandomIter first, RandomIter last, Compared comp)
 {
     for(auto i = first; i != last; ++i)
     {
-        mystl::unchecked_linear_insert(i, *i);
+        if(comp(*i, *(i - 1)))
+            mystl::unchecked_linear_insert(i, mystl::move(*i), comp);
     }
 }
 
 // 插入排序函数 insertion_sort
-template <class RandomIter>
-void insertion_sort(RandomIter first, RandomIter last)
+template <class RandomIter, class Compared>
+void insertion_sort(RandomIter first, RandomIter last, Compared comp)
 {
     if(first == last)return;
-    for(auto i = first + 1; i < last; ++i)
+    for(auto i = first + 1; i != last; ++i)
     {
-        auto value = *i;
-        if(value < *first)
+        if(comp(*i, *first))
         {
-            mystl::copy_backward(first, i, i + 1);
-            *first = value;
+            auto value = mystl::move(*i);
+            mystl::move_backward(first, i, i + 1);
+            *first = mystl::move(value);
         }
-        else
+        else if(comp(*i, *(i - 1)))
         {
-            mystl::unchecked_linear_insert(i, value);
+            mystl::unchecked_linear_insert(i, mystl::move(*i), comp);
         }
     }
 }
 
-// 最终插入排序函数 final_insertion_sort
-template <class RandomIter>
-void final_insertion_sort(RandomIter first, RandomIter last)
+// 尝试进行插入排序，移动的元素超过 kPartialInsertLimit 个时放弃，返回区间是否已经有序
+template <class RandomIter, class Compared>
+bool partial_insertion_sort(RandomIter first, RandomIter last, Compared comp)
 {
-    if(static_cast<size_t>(last -first) > kSmallSectionSize)
+    if(first == last)return true;
+    ptrdiff_t moved = 0;
+    for(auto i = first + 1; i != last; ++i)
     {
-        mystl::insertion_sort(first, first + kSmallSectionSize);
-        mystl::unchecked_insertion_sort(first + kSmallSectionSize, last);
+        if(comp(*i, *(i - 1)))
+        {
+            auto value = mystl::move(*i);
+            auto hole = i;
+            do
+            {
+                *hole = mystl::move(*(hole - 1));
+                --hole;
+            } while(hole != first && comp(value, *(hole - 1)));
+            *hole = mystl::move(value);
+            moved += i - hole;
+            if(moved > kPartialInsertLimit)return false;
+        }
     }
+    return true;
+}
+
+// 重排三个元素使 *a <= *b <= *c
+template <class RandomIter, class Compared>
+void sort3(RandomIter a, RandomIter b, RandomIter c, Compared comp)
+{
+    if(comp(*b, *a))mystl::iter_swap(a, b);
+    if(comp(*c, *b))mystl::iter_swap(b, c);
+    if(comp(*b, *a))mystl::iter_swap(a, b);
+}
+
+// 分割函数 partition_right
+// 以 *first 为枢轴，小于枢轴的元素放到左边，其余的放到右边，返回枢轴的最终位置以及分割前区间是否已经分好
+// 区间内在 first 之后必须存在不小于枢轴的元素，三点中值保证这一点
+template <class RandomIter, class Compared>
+mystl::pair<RandomIter, bool> partition_right(RandomIter first, RandomIter last, Compared comp, std::false_type)
+{
+    auto pivot = mystl::move(*first);
+    auto begin = first;
+    while(comp(*++first, pivot));
+    // first 左边没有小于枢轴的元素时，从右往左的查找需要检查边界
+    if(first - 1 == begin)
+        while(first < last && !comp(*--last, pivot));
     else
+        while(!comp(*--last, pivot));
+    const bool already_partitioned = first >= last;
+    while(first < last)
     {
-        mystl::unchecked_insertion_sort(first, last);
+        mystl::iter_swap(first, last);
+        while(comp(*++first, pivot));
+        while(!comp(*--last, pivot));
     }
+    auto pivot_pos = first - 1;
+    *begin = mystl::move(*pivot_pos);
+    *pivot_pos = mystl::move(pivot);
+    return mystl::pair<RandomIter, bool>(pivot_pos, already_partitioned);
 }
 
+// 按照两个偏移数组交换左右两边放错位置的元素，左右元素个数相同时直接交换，否则轮转减少一半的移动
 template <class RandomIter>
-void sort(RandomIter first, RandomIter last)
+void swap_offsets(RandomIter left_base, RandomIter right_base, const unsigned char* offsets_l,
+                  const unsigned char* offsets_r, size_t num, bool use_swaps)
 {
-    if(first != last)
+    if(use_swaps)
+    {   // 逆序的输入需要逐对交换，否则会破坏逆序的结构，使分割退化
+        for(size_t i = 0; i < num; ++i)
+            mystl::iter_swap(left_base + offsets_l[i], right_base - offsets_r[i]);
+    }
+    else if(num > 0)
     {
-        // 内省式排序，将区间分为一个个小区间，然后对整体进行插入排序
-        mystl::intro_sort(first, last, slg2(last - first) * 2);
-        mystl::final_insertion_sort(first, last);
+        auto l = left_base + offsets_l[0];
+        auto r = right_base - offsets_r[0];
+        auto tmp = mystl::move(*l);
+        *l = mystl::move(*r);
+        for(size_t i = 1; i < num; ++i)
+        {
+            l = left_base + offsets_l[i];
+            *r = mystl::move(*l);
+            r = right_base - offsets_r[i];
+            *l = mystl::move(*r);
+        }
+        *r = mystl::move(tmp);
     }
 }
 
-// 重载版本使用函数对象 comp 代替比较操作
-// 分割函数 unchecked_partition
-template <class RandomIter, class T, class Compared>
-RandomIter unchecked_partition(RandomIter first, RandomIter last, const T& pivot, Compared comp)
+// partition_right 的块分割版本
+// 每次从左右两端各取 kBlockSize 个元素，不用分支地记录放错位置的元素的偏移，再成批交换
+template <class RandomIter, class Compared>
+mystl::pair<RandomIter, bool> partition_right(RandomIter first, RandomIter last, Compared comp, std::true_type)
 {
-    while(true)
+    auto pivot = mystl::move(*first);
+    auto begin = first;
+    while(comp(*++first, pivot));
+    if(first - 1 == begin)
+        while(first < last && !comp(*--last, pivot));
+    else
+        while(!comp(*--last, pivot));
+    const bool already_partitioned = first >= last;
+    if(!already_partitioned)
     {
-        while(comp(*first, pivot))++first;
-        --last;
-        while(comp(pivot, *last))--last;
-        if(!(first < last))return first;
         mystl::iter_swap(first, last);
         ++first;
     }
-}
 
-// 内省式排序，先进行 quick sort，当分割行为有恶化倾向时，改用 heap sort
-template <class RandomIter, class Size, class Compared>
-void intro_sort(RandomIter first, RandomIter last, Size depth_limit, Compared comp)
-{
-    while(static_cast<size_t>(last - first) > kSmallSectionSize)
+    unsigned char offsets_l[kBlockSize];
+    unsigned char offsets_r[kBlockSize];
+    auto left_base = first;
+    auto right_base = last;
+    size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+    while(first < last)
     {
-        if(depth_limit == 0)
+        // 只有一边的偏移用完时才取新的一块，剩下的元素不足两块时按比例分给两边
+        const size_t num_unknown = static_cast<size_t>(last - first);
+        const size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+        const size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+        const size_t left_count = left_split < kBlockSize ? left_split : kBlockSize;
+        const size_t right_count = right_split < kBlockSize ? right_split : kBlockSize;
+        for(size_t i = 0; i < left_count; ++i)
         {
-            // 到达最大分割深度限制
-            mystl::partial_sort(first, last, last);  // 改用 heap_sort
-            return;
+            offsets_l[num_l] = static_cast<unsigned char>(i);
+            num_l += !comp(*first, pivot);
+            ++first;
+        }
+        for(size_t i = 0; i < right_count;)
+        {
+            offsets_r[num_r] = static_cast<unsigned char>(++i);
+            num_r += comp(*--last, pivot);
+        }
+        const size_t num = num_l < num_r ? num_l : num_r;
+        mystl::swap_offsets(left_base, right_base, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+        if(num_l == 0)
+        {
+            start_l = 0;
+            left_base = first;
+        }
+        if(num_r == 0)
+        {
+            start_r = 0;
+            right_base = last;
         }
-        --depth_limit;
-        auto mid = mystl::median(*first, *(first + (last - first) / 2), *(last - 1));
-        auto cut = mystl::unchecked_partition(first, last, mid, comp);
-        mystl::intro_sort(cut, last, depth_limit, comp);
-        last = cut;
     }
-}
-
-// 插入排序辅助函数 unchecked_linear_insert
-template <typename RandomIter, typename T, class Compared>
-void unchecked_linear_insert(RandomIter last, const T& value, Compared comp)
-{
-    auto next = last;
-    --next;
-    while(comp(value, *next))
+    // 一边剩下的放错位置的元素移到中间
+    if(num_l != 0)
     {
-        *last = *next;
-        last = next;
-        --next;
+        while(num_l--)
+            mystl::iter_swap(left_base + offsets_l[start_l + num_l], --last);
+        first = last;
+    }
+    if(num_r != 0)
+    {
+        while(num_r--)
+        {
+            mystl::iter_swap(right_base - offsets_r[start_r + num_r], first);
+            ++first;
+        }
+        last = first;
     }
-    *last = value;
+    auto pivot_pos = first - 1;
+    *begin = mystl::move(*pivot_pos);
+    *pivot_pos = mystl::move(pivot);
+    return mystl::pair<RandomIter, bool>(pivot_pos, already_partitioned);
 }
 
-// 插入排序函数 unchecked_insertion_sort
+// 分割函数 partition_left
+// 以 *first 为枢轴，不大于枢轴的元素放到左边，大于的放到右边，返回枢轴的最终位置
+// 只在区间左边相邻的元素等于枢轴时使用，此时区间内没有小于枢轴的元素，左边全部等于枢轴
 template <class RandomIter, class Compared>
-void unchecked_insertion_sort(RandomIter first, RandomIter last, Compared comp)
-{
-    for(auto i = first; i != last; ++i)
+RandomIter partition_left(RandomIter first, RandomIter last, Compared comp)
+{
+    auto pivot = mystl::move(*first);
+    auto begin = first;
+    auto end = last;
+    while(comp(pivot, *--last));
+    if(last + 1 == end)
+        while(first < last && !comp(pivot, *++first));
+    else
+        while(!comp(pivot, *++first));
+    while(first < last)
     {
-        mystl::unchecked_linear_insert(i, *i, comp);
+        mystl::iter_swap(first, last);
+        while(comp(pivot, *--last));
+        while(!comp(pivot, *++first));
     }
+    *begin = mystl::move(*last);
+    *last = mystl::move(pivot);
+    return last;
 }
 
-// 插入排序函数 insertion_sort
-template <class RandomIter, class Compared>
-void insertion_sort(RandomIter first, RandomIter last, Compared comp)
+// pdqsort 的主循环，bad_allowed 为还允许出现的不平衡分割次数，leftmost 表示区间是否位于最左边
+template <class RandomIter, class Compared, class BlockPartition>
+void pdq_sort_loop(RandomIter first, RandomIter last, Compared comp, int bad_allowed,
+                   bool leftmost, BlockPartition block_partition)
 {
-    if(first == last)return;
-    for(auto i = first + 1; i < last; ++i)
+    while(true)
     {
-        auto value = *i;
-        if(comp(value, *first))
+        const auto size = last - first;
+        if(size < kSmallSectionSize)
         {
-            mystl::copy_backward(first, i, i + 1);
-            *first = value;
+            if(leftmost)
+                mystl::insertion_sort(first, last, comp);
+            else
+                mystl::unchecked_insertion_sort(first, last, comp);
+            return;
+        }
+
+        // 选取枢轴并放到 first
+        const auto half = size / 2;
+        if(size > kNintherThreshold)
+        {
+            mystl::sort3(first, first + half, last - 1, comp);
+            mystl::sort3(first + 1, first + (half - 1), last - 2, comp);
+            mystl::sort3(first + 2, first + (half + 1), last - 3, comp);
+            mystl::sort3(first + (half - 1), first + half, first + (half + 1), comp);
+            mystl::iter_swap(first, first + half);
         }
         else
         {
-            mystl::unchecked_linear_insert(i, value, comp);
+            mystl::sort3(first + half, first, last - 1, comp);
+        }
+
+        // 左边相邻的元素是上一次分割的枢轴，不大于区间内的所有元素，与枢轴相等时区间内有大量重复元素，
+        // 把等于枢轴的元素都分到左边，左段不需要再排序
+        if(!leftmost && !comp(*(first - 1), *first))
+        {
+            first = mystl::partition_left(first, last, comp) + 1;
+            continue;
+        }
+
+        auto result = mystl::partition_right(first, last, comp, block_partition);
+        auto pivot_pos = result.first;
+        const auto l_size = pivot_pos - first;
+        const auto r_size = last - (pivot_pos + 1);
+        if(l_size < size / 8 || r_size < size / 8)
+        {
+            // 分割极不平衡
+            if(--bad_allowed == 0)
+            {
+                mystl::make_heap(first, last, comp);
+                mystl::sort_heap(first, last, comp);
+                return;
+            }
+            if(l_size >= kSmallSectionSize)
+            {
+                mystl::iter_swap(first, first + l_size / 4);
+                mystl::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+                if(l_size > kNintherThreshold)
+                {
+                    mystl::iter_swap(first + 1, first + (l_size / 4 + 1));
+                    mystl::iter_swap(first + 2, first + (l_size / 4 + 2));
+                    mystl::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    mystl::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if(r_size >= kSmallSectionSize)
+            {
+                mystl::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                mystl::iter_swap(last - 1, last - r_size / 4);
+                if(r_size > kNintherThreshold)
+                {
+                    mystl::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    mystl::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    mystl::iter_swap(last - 2, last - (1 + r_size / 4));
+                    mystl::iter_swap(last - 3, last - (2 + r_size / 4));
+                }
+            }
         }
+        else if(result.second && mystl::partial_insertion_sort(first, pivot_pos, comp) &&
+                mystl::partial_insertion_sort(pivot_pos + 1, last, comp))
+        {
+            // 分割比较平衡且没有发生交换，两段都已经有序
+            return;
+        }
+
+        // 递归排序左段，右段在循环中处理
+        mystl::pdq_sort_loop(first, pivot_pos, comp, bad_allowed, leftmost, block_partition);
+        first = pivot_pos + 1;
+        leftmost = false;
     }
 }
 
-// 最终插入排序函数 final_insertion_sort
 template <class RandomIter, class Compared>
-void final_insertion_sort(RandomIter first, RandomIter last, Compared comp)
+void sort(RandomIter first, RandomIter last, Compared comp)
+{
+    if(last - first < 2)return;
+    typedef typename iterator_traits<RandomIter>::value_type value_type;
+    mystl::pdq_sort_loop(first, last, comp, static_cast<int>(slg2(last - first)), true,
+                         use_block_partition<value_type, Compared>());
+}
+
+// 不带 comp 的版本使用 mystl::less 比较
+template <class RandomIter>
+void unchecked_insertion_sort(RandomIter first, RandomIter last)
+{
+    mystl::unchecked_insertion_sort(first, last, mystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
+template <class RandomIter>
+void insertion_sort(RandomIter first, RandomIter last)
+{
+    mystl::insertion_sort(first, last, mystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
+template <class RandomIter>
+void sort(RandomIter first, RandomIter last)
+{
+    mystl::sort(first, last, mystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
+/*****************************************************************************************/
+// stable_sort
+// 将[first, last)内的元素以递增的方式排序，相等的元素保持原来的相对位置
+// 申请到临时缓冲区时进行归并排序，缓冲区不足以容纳整个区间时分割递归，再用 merge_adaptive 合并，
+// 申请不到缓冲区时改用不需要额外空间的 inplace_stable_sort，复杂度为 O(N * logN * logN)
+/*****************************************************************************************/
+constexpr static ptrdiff_t kStableChunkSize = 7;  // 归并之前先对每 7 个元素做插入排序
+
+// 没有缓冲区的情况下排序
+template <class RandomIter>
+void inplace_stable_sort(RandomIter first, RandomIter last)
+{
+    if(last - first < 15)
+    {
+        mystl::insertion_sort(first, last);
+        return;
+    }
+    auto middle = first + (last - first) / 2;
+    mystl::inplace_stable_sort(first, middle);
+    mystl::inplace_stable_sort(middle, last);
+    mystl::merge_without_buffer(first, middle, last, middle - first, last - middle);
+}
+
+// 把区间内相邻的两个长度为 step_size 的有序序列两两合并，结果移动到 result
+template <class RandomIter1, class RandomIter2, class Distance>
+void merge_sort_loop(RandomIter1 first, RandomIter1 last, RandomIter2 result, Distance step_size)
+{
+    const Distance two_step = 2 * step_size;
+    while(last - first >= two_step)
+    {
+        result = mystl::move_merge(first, first + step_size, first + step_size, first + two_step, result);
+        first += two_step;
+    }
+    step_size = mystl::min(static_cast<Distance>(last - first), step_size);
+    mystl::move_merge(first, first + step_size, first + step_size, last, result);
+}
+
+// 对每 chunk_size 个元素做插入排序
+template <class RandomIter, class Distance>
+void chunk_insertion_sort(RandomIter first, RandomIter last, Distance chunk_size)
 {
-    if(static_cast<size_t>(last -first) > kSmallSectionSize)
+    while(last - first >= chunk_size)
     {
-        mystl::insertion_sort(first, first + kSmallSectionSize, comp);
-        mystl::unchecked_insertion_sort(first + kSmallSectionSize, last, comp);
+        mystl::insertion_sort(first, first + chunk_size);
+        first += chunk_size;
+    }
+    mystl::insertion_sort(first, last);
+}
+
+// 缓冲区可以容纳整个区间，在区间与缓冲区之间来回合并
+template <class RandomIter, class Pointer, class Distance>
+void merge_sort_with_buffer(RandomIter first, RandomIter last, Pointer buffer, Distance*)
+{
+    const Distance len = last - first;
+    const Pointer buffer_last = buffer + len;
+    Distance step_size = kStableChunkSize;
+    mystl::chunk_insertion_sort(first, last, step_size);
+    while(step_size < len)
+    {
+        mystl::merge_sort_loop(first, last, buffer, step_size);
+        step_size *= 2;
+        mystl::merge_sort_loop(buffer, buffer_last, first, step_size);
+        step_size *= 2;
+    }
+}
+
+// 有缓冲区的情况下排序，前后两半分别排序后合并
+template <class RandomIter, class Pointer, class Distance>
+void stable_sort_adaptive(RandomIter first, RandomIter last, Pointer buffer, Distance buffer_size)
+{
+    const Distance len = (last - first + 1) / 2;
+    const auto middle = first + len;
+    if(len > buffer_size)
+    {
+        mystl::stable_sort_adaptive(first, middle, buffer, buffer_size);
+        mystl::stable_sort_adaptive(middle, last, buffer, buffer_size);
     }
     else
     {
-        mystl::unchecked_insertion_sort(first, last, comp);
+        mystl::merge_sort_with_buffer(first, middle, buffer, static_cast<Distance*>(0));
+        mystl::merge_sort_with_buffer(middle, last, buffer, static_cast<Distance*>(0));
     }
+    mystl::merge_adaptive(first, middle, last, static_cast<Distance>(middle - first),
+                          static_cast<Distance>(last - middle), buffer, buffer_size);
 }
 
-template <class RandomIter, class Compared>
-void sort(RandomIter first, RandomIter last, Compared comp)
+template <class RandomIter, class T, class Distance>
+void stable_sort_aux(RandomIter first, RandomIter last, T*, Distance*)
 {
-    if(first != last)
+    temporary_buffer<RandomIter, T> buf(first, last);
+    if(!buf.begin())
     {
-        // 内省式排序，将区间分为一个个小区间，然后对整体进行插入排序
-        mystl::intro_sort(first, last, slg2(last - first) * 2, comp);
-        mystl::final_insertion_sort(first, last, comp);
+        mystl::inplace_stable_sort(first, last);
+    }
+    else
+    {
+        mystl::stable_sort_adaptive(first, last, buf.begin(), static_cast<Distance>(buf.size()));
     }
 }
 
-/*****************************************************************************************/
-// nth_element
-// 对序列重排，使得所有小于第 n 个元素的元素出现在它的前面，大于它的出现在它的后面
-/*****************************************************************************************/
 template <class RandomIter>
-void nth_element(RandomIter first, RandomIter nth, RandomIter last)
+void stable_sort(RandomIter first, RandomIter last)
 {
-    if(nth == last)return;
-    while(last - first > 3)
+    if(last - first < 2)return;
+    mystl::stable_sort_aux(first, last, value_type(first), distance_type(first));
+}
+
+// 重载版本使用函数对象 comp 代替比较操作
+template <class RandomIter, class Compared>
+void inplace_stable_sort(RandomIter first, RandomIter last, Compared comp)
+{
+    if(last - first < 15)
     {
-        auto cut = mystl::unchecked_partition(first, last,
-                    mystl::median(*first, *(first + (last - first) / 2), *(last - 1)));
-        if(cut <= nth)first = cut;  // 对右段进行分割
-        else last = cut;  // 对左段进行分割
+        mystl::insertion_sort(first, last, comp);
+        return;
+    }
+    auto middle = first + (last - first) / 2;
+    mystl::inplace_stable_sort(first, middle, comp);
+    mystl::inplace_stable_sort(middle, last, comp);
+    mystl::merge_without_buffer(first, middle, last, middle - first, last - middle, comp);
+}
+
+template <class RandomIter1, class RandomIter2, class Distance, class Compared>
+void merge_sort_loop(RandomIter1 first, RandomIter1 last, RandomIter2 result, Distance step_size, Compared comp)
+{
+    const Distance two_step = 2 * step_size;
+    while(last - first >= two_step)
+    {
+        result = mystl::move_merge(first, first + step_size, first + step_size, first + two_step, result, comp);
+        first += two_step;
+    }
+    step_size = mystl::min(static_cast<Distance>(last - first), step_size);
+    mystl::move_merge(first, first + step_size, first + step_size, last, result, comp);
+}
+
+template <class RandomIter, class Distance, class Compared>
+void chunk_insertion_sort(RandomIter first, RandomIter last, Distance chunk_size, Compared comp)
+{
+    while(last - first >= chunk_size)
+    {
+        mystl::insertion_sort(first, first + chunk_size, comp);
+        first += chunk_size;
+    }
+    mystl::insertion_sort(first, last, comp);
+}
+
+template <class RandomIter, class Pointer, class Distance, class Compared>
+void merge_sort_with_buffer(RandomIter first, RandomIter last, Pointer buffer, Distance*, Compared comp)
+{
+    const Distance len = last - first;
+    const Pointer buffer_last = buffer + len;
+    Distance step_size = kStableChunkSize;
+    mystl::chunk_insertion_sort(first, last, step_size, comp);
+    while(step_size < len)
+    {
+        mystl::merge_sort_loop(first, last, buffer, step_size, comp);
+        step_size *= 2;
+        mystl::merge_sort_loop(buffer, buffer_last, first, step_size, comp);
+        step_size *= 2;
+    }
+}
+
+template <class RandomIter, class Pointer, class Distance, class Compared>
+void stable_sort_adaptive(RandomIter first, RandomIter last, Pointer buffer, Distance buffer_size, Compared comp)
+{
+    const Distance len = (last - first + 1) / 2;
+    const auto middle = first + len;
+    if(len > buffer_size)
+    {
+        mystl::stable_sort_adaptive(first, middle, buffer, buffer_size, comp);
+        mystl::stable_sort_adaptive(middle, last, buffer, buffer_size, comp);
+    }
+    else
+    {
+        mystl::merge_sort_with_buffer(first, middle, buffer, static_cast<Distance*>(0), comp);
+        mystl::merge_sort_with_buffer(middle, last, buffer, static_cast<Distance*>(0), comp);
+    }
+    mystl::merge_adaptive(first, middle, last, static_cast<Distance>(middle - first),
+                          static_cast<Distance>(last - middle), buffer, buffer_size, comp);
+}
+
+template <class RandomIter, class T, class Distance, class Compared>
+void stable_sort_aux(RandomIter first, RandomIter last, T*, Distance*, Compared comp)
+{
+    temporary_buffer<RandomIter, T> buf(first, last);
+    if(!buf.begin())
+    {
+        mystl::inplace_stable_sort(first, last, comp);
+    }
+    else
+    {
+        mystl::stable_sort_adaptive(first, last, buf.begin(), static_cast<Distance>(buf.size()), comp);
     }
-    mystl::insertion_sort(first, last);
 }
 
-// 重载版本使用函数对象 comp 代替比较操作
+template <class RandomIter, class Compared>
+void stable_sort(RandomIter first, RandomIter last, Compared comp)
+{
+    if(last - first < 2)return;
+    mystl::stable_sort_aux(first, last, value_type(first), distance_type(first), comp);
+}
+
+/*****************************************************************************************/
+// nth_element
+// 对序列重排，使得所有小于第 n 个元素的元素出现在它的前面，大于它的出现在它的后面
+// 与 sort 使用相同的分割函数，分割恶化时改用 partial_sort
+/*****************************************************************************************/
 template <class RandomIter, class Compared>
 void nth_element(RandomIter first, RandomIter nth, RandomIter last, Compared comp)
 {
     if(nth == last)return;
-    while(last - first > 3)
+    auto bad_allowed = slg2(last - first) * 2;
+    while(last - first > kSmallSectionSize)
     {
-        auto cut = mystl::unchecked_partition(first, last,
-                    mystl::median(*first, *(first + (last - first) / 2), *(last - 1), comp), comp);
-        if(cut <= nth)first = cut;  // 对右段进行分割
+        if(bad_allowed-- == 0)
+        {
+            // 到达最大分割深度限制
+            mystl::partial_sort(first, nth + 1, last, comp);
+            return;
+        }
+        mystl::sort3(first + (last - first) / 2, first, last - 1, comp);  // 三点中值作为枢轴放到 first
+        auto cut = mystl::partition_right(first, last, comp, std::false_type()).first;
+        if(cut == nth)return;
+        if(cut < nth)first = cut + 1;  // 对右段进行分割
         else last = cut;  // 对左段进行分割
     }
     mystl::insertion_sort(first, last, comp);
 }
 
+template <class RandomIter>
+void nth_element(RandomIter first, RandomIter nth, RandomIter last)
+{
+    mystl::nth_element(first, nth, last, mystl::less<typename iterator_traits<RandomIter>::value_type>());
+}
+
 /*****************************************************************************************/
 // unique_copy
 // 从[first, last)中将元素复制到 result 上，序列必须有序，如果有重复的元素，只会复制一次
@@ -2327,7 +2903,7 @@ ForwardIter unique_copy_dispatch(InputIter first, InputIter last, ForwardIter re
     *result = *first;
     while(++first != last)
     {
-        if(comp(*result, *first))
+        if(!comp(*result, *first))
         {
             *++result = *first;
         }
@@ -109,11 +109,80 @@ unchecked_copy(Tp* first, Tp* last, Up* result)
 }
 
 template <class InputIter, class OutputIter>
-OutputIter copy(InputIter first, InputIter last, OutputIter result)
+OutputIter copy(InputIter first, InputIter last, OutputIter result);
+
+// 分段迭代器的版本：源区间是分段迭代器时逐段复制，每一段都是一对指针
+template <class InputIter, class OutputIter, class OutputSegmented>
+OutputIter segmented_copy(InputIter first, InputIter last, OutputIter result, m_true_type, OutputSegmented)
+{
+    typedef segmented_iterator_traits<InputIter> traits;
+    auto sfirst = traits::segment(first);
+    const auto slast = traits::segment(last);
+    if(sfirst == slast)
+    {
+        return mystl::copy(traits::local(first), traits::local(last), result);
+    }
+    result = mystl::copy(traits::local(first), traits::end(sfirst), result);
+    for(++sfirst; sfirst != slast; ++sfirst)
+    {
+        result = mystl::copy(traits::begin(sfirst), traits::end(sfirst), result);
+    }
+    return mystl::copy(traits::begin(slast), traits::local(last), result);
+}
+
+// 目标区间是分段迭代器时，把源区间切成与目标的每一段对齐的小段
+template <class RandomIter, class OutputIter>
+OutputIter segmented_copy_out(RandomIter first, RandomIter last, OutputIter result, mystl::random_access_iterator_tag)
+{
+    typedef segmented_iterator_traits<OutputIter> traits;
+    auto n = last - first;
+    if(n <= 0)
+    {
+        return result;
+    }
+    auto seg = traits::segment(result);
+    auto cur = traits::local(result);
+    while(true)
+    {
+        const auto room = traits::end(seg) - cur;
+        const auto len = n < room ? n : room;
+        cur = unchecked_copy(first, first + len, cur);
+        first += len;
+        n -= len;
+        if(n == 0)
+        {
+            return traits::compose(seg, cur);
+        }
+        ++seg;
+        cur = traits::begin(seg);
+    }
+}
+
+template <class InputIter, class OutputIter>
+OutputIter segmented_copy_out(InputIter first, InputIter last, OutputIter result, mystl::input_iterator_tag)
+{
+    return unchecked_copy(first, last, result);
+}
+
+template <class InputIter, class OutputIter>
+OutputIter segmented_copy(InputIter first, InputIter last, OutputIter result, m_false_type, m_true_type)
+{
+    return segmented_copy_out(first, last, result, iterator_category(first));
+}
+
+template <class InputIter, class OutputIter>
+OutputIter segmented_copy(InputIter first, InputIter last, OutputIter result, m_false_type, m_false_type)
 {
     return unchecked_copy(first, last, result);
 }
 
+template <class InputIter, class OutputIter>
+OutputIter copy(InputIter first, InputIter last, OutputIter result)
+{
+    return segmented_copy(first, last, result,
+                          is_segmented_iterator<InputIter>{}, is_segmented_iterator<OutputIter>{});
+}
+
 
 // copy_backward
 // 将 [first, last)区间内的元素拷贝到 [result - (last - first), result)内
@@ -257,7 +326,7 @@ OutputIter move(InputIter first, InputIter last, OutputIter result)
 
 // bidirectional_iterator_tag 版本
 template <class BidirectionalIter1, class BidirectionalIter2>
-BidirectionalIter1 unchecked_move_backward_cat(BidirectionalIter1 first, BidirectionalIter1 last, BidirectionalIter2 result, mystl::bidirectional_iterator_tag)
+BidirectionalIter2 unchecked_move_backward_cat(BidirectionalIter1 first, BidirectionalIter1 last, BidirectionalIter2 result, mystl::bidirectional_iterator_tag)
 {
     while( first != last)*--result = mystl::move(*--last);
     return result;
@@ -369,15 +438,44 @@ void fill_cat(ForwardIter first, ForwardIter last, const T& value, mystl::forwar
 template <typename RandomIter, typename T>
 void fill_cat(RandomIter first, RandomIter last, const T& value, mystl::random_access_iterator_tag)
 {
-    fill_n(first, last - first, value);
+    mystl::fill_n(first, last - first, value);
 }
 
 template <typename ForwardIter, typename T>
-void fill(ForwardIter first, ForwardIter last, const T& value)
+void fill(ForwardIter first, ForwardIter last, const T& value);
+
+// 分段迭代器的版本：逐段填充，每一段都是一对指针
+template <typename ForwardIter, typename T>
+void segmented_fill(ForwardIter first, ForwardIter last, const T& value, m_true_type)
+{
+    typedef segmented_iterator_traits<ForwardIter> traits;
+    auto sfirst = traits::segment(first);
+    const auto slast = traits::segment(last);
+    if(sfirst == slast)
+    {
+        mystl::fill(traits::local(first), traits::local(last), value);
+        return;
+    }
+    mystl::fill(traits::local(first), traits::end(sfirst), value);
+    for(++sfirst; sfirst != slast; ++sfirst)
+    {
+        mystl::fill(traits::begin(sfirst), traits::end(sfirst), value);
+    }
+    mystl::fill(traits::begin(slast), traits::local(last), value);
+}
+
+template <typename ForwardIter, typename T>
+void segmented_fill(ForwardIter first, ForwardIter last, const T& value, m_false_type)
 {
     fill_cat(first, last, value, iterator_category(first));
 }
 
+template <typename ForwardIter, typename T>
+void fill(ForwardIter first, ForwardIter last, const T& value)
+{
+    segmented_fill(first, last, value, is_segmented_iterator<ForwardIter>{});
+}
+
 
 // lexicographical_compare
 // 以字典序排列对两个序列进行比较，当在某个位置发现第一组不相等元素时，有下列几种情况：
@@ -2,6 +2,7 @@
 #define MYTINYSTL_ALLOCATOR_H_
 
 // 这个头文件包含一个模板类 allocator，用于管理内存的分配、释放，对象的构造、析构
+// 以及 allocator_traits，容器通过它访问分配器，从而支持用户自定义的（有状态的）分配器
 
 #include "construct.h"
 #include "util.h"
@@ -23,6 +24,17 @@ public:
     typedef size_t    size_type;
     typedef ptrdiff_t difference_type;
 
+    template <typename U>
+    struct rebind
+    {
+        typedef allocator<U> other;
+    };
+
+public:
+    allocator() noexcept = default;
+    template <typename U>
+    allocator(const allocator<U>&) noexcept {}
+
 public:
     static T* allocate();
     static T* allocate(size_type n);
@@ -107,6 +119,280 @@ void allocator<T>::destroy(T* first, T* last)
     mystl::destroy(first, last);
 }
 
+// allocator 是无状态的，任意两个实例都相等
+template <typename T, typename U>
+bool operator==(const allocator<T>&, const allocator<U>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const allocator<T>&, const allocator<U>&) noexcept
+{
+    return false;
+}
+
+/*****************************************************************************************/
+// allocator_traits
+// 容器只通过 allocator_traits 使用分配器，分配器最少只需提供 value_type、allocate(n)、deallocate(p, n)
+// 以及 operator==，其余的类型与操作在缺省时由 allocator_traits 补全
+
+namespace alloc_detail
+{
+
+template <typename... >
+struct make_void
+{
+    typedef void type;
+};
+
+// 用 U 替换 Alloc<T, Args...> 的第一个模板参数
+template <typename Alloc, typename U>
+struct replace_first_arg {};
+
+template <template <typename, typename...> class Alloc, typename T, typename... Args, typename U>
+struct replace_first_arg<Alloc<T, Args...>, U>
+{
+    typedef Alloc<U, Args...> type;
+};
+
+template <typename Alloc, typename U, typename = void>
+struct rebind_alloc
+{
+    typedef typename replace_first_arg<Alloc, U>::type type;
+};
+
+template <typename Alloc, typename U>
+struct rebind_alloc<Alloc, U, typename make_void<typename Alloc::template rebind<U>::other>::type>
+{
+    typedef typename Alloc::template rebind<U>::other type;
+};
+
+#define MYSTL_ALLOC_TRAIT_MEMBER(NAME, DEFAULT)                         \
+template <typename Alloc, typename = void>                              \
+struct NAME { typedef DEFAULT type; };                                  \
+template <typename Alloc>                                               \
+struct NAME<Alloc, typename make_void<typename Alloc::NAME>::type>      \
+{ typedef typename Alloc::NAME type; };
+
+MYSTL_ALLOC_TRAIT_MEMBER(propagate_on_container_copy_assignment, std::false_type)
+MYSTL_ALLOC_TRAIT_MEMBER(propagate_on_container_move_assignment, std::false_type)
+MYSTL_ALLOC_TRAIT_MEMBER(propagate_on_container_swap, std::false_type)
+MYSTL_ALLOC_TRAIT_MEMBER(is_always_equal, typename std::is_empty<Alloc>::type)
+
+#undef MYSTL_ALLOC_TRAIT_MEMBER
+
+} // namespace alloc_detail
+
+template <typename Alloc>
+struct allocator_traits
+{
+    typedef Alloc                                   allocator_type;
+    typedef typename Alloc::value_type              value_type;
+    typedef value_type*                             pointer;
+    typedef const value_type*                       const_pointer;
+    typedef size_t                                  size_type;
+    typedef ptrdiff_t                               difference_type;
+
+    typedef typename alloc_detail::propagate_on_container_copy_assignment<Alloc>::type
+        propagate_on_container_copy_assignment;
+    typedef typename alloc_detail::propagate_on_container_move_assignment<Alloc>::type
+        propagate_on_container_move_assignment;
+    typedef typename alloc_detail::propagate_on_container_swap<Alloc>::type
+        propagate_on_container_swap;
+    typedef typename alloc_detail::is_always_equal<Alloc>::type
+        is_always_equal;
+
+    template <typename U>
+    using rebind_alloc = typename alloc_detail::rebind_alloc<Alloc, U>::type;
+
+    template <typename U>
+    using rebind_traits = allocator_traits<rebind_alloc<U>>;
+
+    static pointer allocate(Alloc& a, size_type n)
+    {
+        return n == 0 ? nullptr : a.allocate(n);
+    }
+
+    static void deallocate(Alloc& a, pointer ptr, size_type n)
+    {
+        if(ptr != nullptr)a.deallocate(ptr, n);
+    }
+
+    // 若分配器提供了 construct / destroy 则使用之，否则使用 mystl::construct / mystl::destroy
+    template <typename T, typename... Args>
+    static void construct(Alloc& a, T* ptr, Args&&... args)
+    {
+        construct_aux(0, a, ptr, mystl::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    static void destroy(Alloc& a, T* ptr)
+    {
+        destroy_aux(0, a, ptr);
+    }
+
+    template <typename T>
+    static void destroy(Alloc& a, T* first, T* last)
+    {
+        destroy_range_aux(0, a, first, last);
+    }
+
+    static size_type max_size(const Alloc&) noexcept
+    {
+        return static_cast<size_type>(-1) / sizeof(value_type);
+    }
+
+    // 复制构造容器时使用的分配器
+    static Alloc select_on_container_copy_construction(const Alloc& a)
+    {
+        return select_aux(0, a);
+    }
+
+    // 元素无需析构，且分配器的 deallocate 什么都不做（如 pmr::monotonic_buffer_resource）时，
+    // 容器析构时可以跳过逐个节点的析构与释放，空间随内存资源一起归还
+    template <typename T>
+    static bool can_skip_destroy(const Alloc& a) noexcept
+    {
+        return std::is_trivially_destructible<T>::value && noop_aux(0, a);
+    }
+
+private:
+    template <typename A, typename T, typename... Args>
+    static auto construct_aux(int, A& a, T* ptr, Args&&... args)
+    -> decltype(a.construct(ptr, mystl::forward<Args>(args)...), void())
+    {
+        a.construct(ptr, mystl::forward<Args>(args)...);
+    }
+    template <typename T, typename... Args>
+    static void construct_aux(long, Alloc&, T* ptr, Args&&... args)
+    {
+        mystl::construct(ptr, mystl::forward<Args>(args)...);
+    }
+
+    template <typename A, typename T>
+    static auto destroy_aux(int, A& a, T* ptr) -> decltype(a.destroy(ptr), void())
+    {
+        a.destroy(ptr);
+    }
+    template <typename T>
+    static void destroy_aux(long, Alloc&, T* ptr)
+    {
+        mystl::destroy(ptr);
+    }
+
+    template <typename A, typename T>
+    static auto destroy_range_aux(int, A& a, T* first, T* last)
+    -> decltype(a.destroy(first), void())
+    {
+        // 与 mystl::destroy 保持一致，trivially destructible 的类型不做任何事
+        if(std::is_trivially_destructible<T>::value)return;
+        for(; first != last; ++first)
+            a.destroy(first);
+    }
+    template <typename T>
+    static void destroy_range_aux(long, Alloc&, T* first, T* last)
+    {
+        mystl::destroy(first, last);
+    }
+
+    template <typename A>
+    static auto select_aux(int, const A& a)
+    -> decltype(a.select_on_container_copy_construction())
+    {
+        return a.select_on_container_copy_construction();
+    }
+    static Alloc select_aux(long, const Alloc& a)
+    {
+        return a;
+    }
+
+    template <typename A>
+    static auto noop_aux(int, const A& a) noexcept -> decltype(a.deallocate_is_noop())
+    {
+        return a.deallocate_is_noop();
+    }
+    static bool noop_aux(long, const Alloc&) noexcept
+    {
+        return false;
+    }
+};
+
+// 按照 propagate_on_container_* 的要求在两个分配器之间复制、移动、交换
+template <typename Alloc>
+void alloc_on_copy(Alloc& lhs, const Alloc& rhs, std::true_type)
+{
+    lhs = rhs;
+}
+template <typename Alloc>
+void alloc_on_copy(Alloc&, const Alloc&, std::false_type) {}
+
+template <typename Alloc>
+void alloc_on_copy(Alloc& lhs, const Alloc& rhs)
+{
+    alloc_on_copy(lhs, rhs,
+        typename allocator_traits<Alloc>::propagate_on_container_copy_assignment{});
+}
+
+template <typename Alloc>
+void alloc_on_move(Alloc& lhs, Alloc& rhs, std::true_type)
+{
+    lhs = mystl::move(rhs);
+}
+template <typename Alloc>
+void alloc_on_move(Alloc&, Alloc&, std::false_type) {}
+
+template <typename Alloc>
+void alloc_on_move(Alloc& lhs, Alloc& rhs)
+{
+    alloc_on_move(lhs, rhs,
+        typename allocator_traits<Alloc>::propagate_on_container_move_assignment{});
+}
+
+template <typename Alloc>
+void alloc_on_swap(Alloc& lhs, Alloc& rhs, std::true_type)
+{
+    mystl::swap(lhs, rhs);
+}
+template <typename Alloc>
+void alloc_on_swap(Alloc&, Alloc&, std::false_type) {}
+
+template <typename Alloc>
+void alloc_on_swap(Alloc& lhs, Alloc& rhs)
+{
+    alloc_on_swap(lhs, rhs,
+        typename allocator_traits<Alloc>::propagate_on_container_swap{});
+}
+
+// 模板类：alloc_holder
+// 容器通过继承它来保存分配器，对于空的（无状态的）分配器利用空基类优化，不增加容器的大小
+template <typename Alloc, bool = std::is_empty<Alloc>::value>
+class alloc_holder
+{
+public:
+    alloc_holder() : alloc_() {}
+    explicit alloc_holder(const Alloc& a) : alloc_(a) {}
+    explicit alloc_holder(Alloc&& a) : alloc_(mystl::move(a)) {}
+
+    Alloc&       get_alloc() noexcept       { return alloc_; }
+    const Alloc& get_alloc() const noexcept { return alloc_; }
+
+private:
+    Alloc alloc_;
+};
+
+template <typename Alloc>
+class alloc_holder<Alloc, true> : private Alloc
+{
+public:
+    alloc_holder() : Alloc() {}
+    explicit alloc_holder(const Alloc& a) : Alloc(a) {}
+    explicit alloc_holder(Alloc&& a) : Alloc(mystl::move(a)) {}
+
+    Alloc&       get_alloc() noexcept       { return *this; }
+    const Alloc& get_alloc() const noexcept { return *this; }
+};
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_ALLOCATOR_H_
\ No newline at end of file
@@ -12,6 +12,14 @@ namespace mystl
     using u16string = mystl::basic_string<char16_t>;
     using u32string = mystl::basic_string<char32_t>;
 
+namespace pmr
+{
+    using string = mystl::pmr::basic_string<char>;
+    using wstring = mystl::pmr::basic_string<wchar_t>;
+    using u16string = mystl::pmr::basic_string<char16_t>;
+    using u32string = mystl::pmr::basic_string<char32_t>;
+} // namespace pmr
+
 }
 
 #endif // !MYTINYSTL_ASTRING_H_
\ No newline at end of file
@@ -245,35 +245,35 @@ struct char_traits<char32_t>
     }
 };
 
-// 初始化 basic_string 尝试分配的最小 buffer 大小，可能被忽略
-#define STRING_INIT_SIZE 32
-
 // 模板类 basic_string
 // 参数一代表字符类型，参数二代表萃取字符类型的方式，缺省使用 mystl::char_traits
-template <typename CharType, typename CharTraits = mystl::char_traits<CharType>>
-class basic_string
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+template <typename CharType, typename CharTraits = mystl::char_traits<CharType>,
+          typename Alloc = mystl::allocator<CharType>>
+class basic_string : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<CharType>>
 {
 public:
     typedef CharTraits                               traits_type;
     typedef CharTraits                               char_traits;
 
-    typedef mystl::allocator<CharType>               allocator_type;
-    typedef mystl::allocator<CharType>               data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<CharType> data_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef data_allocator                              allocator_type;
 
-    typedef typename allocator_type::value_type      value_type;
-    typedef typename allocator_type::pointer         pointer;
-    typedef typename allocator_type::const_pointer   const_pointer;
-    typedef typename allocator_type::reference       reference;
-    typedef typename allocator_type::const_reference const_reference;
-    typedef typename allocator_type::size_type       size_type;
-    typedef typename allocator_type::difference_type difference_type;
+    typedef typename data_alloc_traits::value_type      value_type;
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
 
     typedef value_type*                              iterator;
     typedef const value_type*                        const_iterator;
     typedef mystl::reverse_iterator<iterator>        reverse_iterator;
     typedef mystl::reverse_iterator<const_iterator>  const_reverse_iterator;
 
-    allocator_type get_allocator() { return allocator_type(); }
+    allocator_type get_allocator() const { return this->get_alloc(); }
 
     static_assert(std::is_pod<CharType>::value, "Character type of basic_string must be a POD");
     static_assert(std::is_same<CharType, typename traits_type::char_type>::value,
@@ -285,57 +285,93 @@ public:
     static constexpr size_type npos = static_cast<size_type>(-1);
 
 private:
-    iterator  buffer_;  // 储存字符串的起始位置
-    size_type size_;    // 大小
-    size_type cap_;     // 容量
+    typedef mystl::alloc_holder<data_allocator>      alloc_base;
+
+    // 短字符串直接存放在对象内部，不申请堆空间（SSO）
+    // 放在堆上时 rep_ 保存指针和长度，tail_ 保存容量；内联时 rep_ 整体用来保存字符，tail_ 保存长度
+    // 堆上的容量总是大于 local_cap，由 tail_ 即可区分两种状态
+    // 对象中不保存指向自身的指针，因此仍然可以直接搬移（见 is_trivially_relocatable）
+    struct heap_rep
+    {
+        pointer   ptr;   // 储存字符串的起始位置
+        size_type size;  // 大小
+    };
+
+    static_assert(sizeof(value_type) <= sizeof(heap_rep), "Character type of basic_string is too large");
+
+    enum : size_type
+    {
+        local_n   = sizeof(heap_rep) / sizeof(value_type),  // 内联空间能容纳的字符数
+        local_cap = local_n - 1                             // 内联时的容量，留一个位置给结尾的空字符
+    };
+
+    union rep_type
+    {
+        heap_rep   heap;
+        value_type local[local_n];
+    };
+
+    rep_type  rep_;
+    size_type tail_;  // 内联时为大小，在堆上时为容量
 
 public:
     // 构造、复制、移动、析构函数
-    basic_string() noexcept { try_init(); }
+    basic_string() noexcept
+    { init_local(); }
+
+    explicit basic_string(const allocator_type& alloc) noexcept
+    : alloc_base(alloc)
+    { init_local(); }
 
-    basic_string(size_type n, value_type ch)
-    : buffer_(nullptr), size_(0), cap_(0)
+    basic_string(size_type n, value_type ch, const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc)
     { fill_init(n, ch); }
 
-    basic_string(const basic_string& rhs, size_type pos)
-    : buffer_(nullptr), size_(0), cap_(0)
+    basic_string(const basic_string& rhs, size_type pos, const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc)
     {
-        init_from(rhs.buffer_, pos, rhs.size_ - pos);
+        init_from(rhs.buffer(), pos, rhs.size() - pos);
     }
-    basic_string(const basic_string& rhs, size_type pos, size_type count)
-    : buffer_(nullptr), size_(0), cap_(0)
+    basic_string(const basic_string& rhs, size_type pos, size_type count,
+                 const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc)
     {
-        init_from(rhs.buffer_, pos, count);
+        init_from(rhs.buffer(), pos, count);
     }
 
-    basic_string(const_pointer str)
-    : buffer_(nullptr), size_(0), cap_(0)
+    basic_string(const_pointer str, const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc)
     {
         init_from(str, 0, char_traits::length(str));
     }
-    basic_string(const_pointer str, size_type count)
-    : buffer_(nullptr), size_(0), cap_(0)
+    basic_string(const_pointer str, size_type count, const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc)
     {
         init_from(str, 0, count);
     }
 
     template <typename Iter, typename std::enable_if<mystl::is_input_iterator<Iter>::value, int>::type = 0>
-    basic_string(Iter first, Iter last)
+    basic_string(Iter first, Iter last, const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc)
     {
         copy_init(first, last, iterator_category(first));
     }
 
     basic_string(const basic_string& rhs)
-    : buffer_(nullptr), size_(0), cap_(0)
+    : alloc_base(data_alloc_traits::select_on_container_copy_construction(rhs.get_alloc()))
     {
-        init_from(rhs.buffer_, 0, rhs.size_);
+        init_from(rhs.buffer(), 0, rhs.size());
     }
+    basic_string(const basic_string& rhs, const allocator_type& alloc)
+    : alloc_base(alloc)
+    {
+        init_from(rhs.buffer(), 0, rhs.size());
+    }
+    // 内联和堆上的字符串都只需复制三个字
     basic_string(basic_string&& rhs) noexcept
-    : buffer_(rhs.buffer_), size_(rhs.size_), cap_(rhs.cap_)
+    : alloc_base(mystl::move(rhs.get_alloc())), rep_(rhs.rep_), tail_(rhs.tail_)
     {
-        rhs.buffer_ = nullptr;
-        rhs.size_ = 0;
-        rhs.cap_ = 0;
+        rhs.init_local();
     }
 
     basic_string& operator=(const basic_string& rhs);
@@ -349,13 +385,13 @@ public:
 public:
     // 迭代器相关操作
     iterator        begin() noexcept
-    { return buffer_; }
+    { return buffer(); }
     const_iterator  begin() const noexcept
-    { return buffer_; }
+    { return buffer(); }
     iterator        end()   noexcept
-    { return buffer_ + size_; }
+    { return buffer() + size(); }
     const_iterator  end()   const noexcept
-    { return buffer_ + size_; }
+    { return buffer() + size(); }
 
     reverse_iterator       rbegin() noexcept
     { return reverse_iterator(end()); }
@@ -377,14 +413,14 @@ public:
 
     // 容量相关操作
     bool empty() const noexcept
-    { return size_ == 0; }
+    { return size() == 0; }
 
     size_type size()     const noexcept
-    { return size_; }
+    { return is_local() ? tail_ : rep_.heap.size; }
     size_type length()   const noexcept
-    { return size_; }
+    { return size(); }
     size_type capacity() const noexcept
-    { return cap_; }
+    { return is_local() ? static_cast<size_type>(local_cap) : tail_; }
     size_type max_size() const noexcept
     { return static_cast<size_type>(-1); }
 
@@ -393,26 +429,24 @@ public:
 
     reference operator[](size_type n)
     {
-        MYSTL_DEBUG(n <= size_);
-        if(n == size_)*(buffer_ + n) = value_type();
-        return *(buffer_ + n);
+        MYSTL_DEBUG(n <= size());
+        return *(buffer() + n);
     }
     const_reference operator[](size_type n) const
     {
-        MYSTL_DEBUG(n <= size_);
-        if(n == size_)*(buffer_ + n) = value_type();
-        return *(buffer_ + n);
+        MYSTL_DEBUG(n <= size());
+        return *(buffer() + n);
     }
 
     reference at(size_type n)
     {
-        THROW_OUT_OF_RANGE_IF(n >= size_, "basic_string<Char, Traits>::at()"
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_string<Char, Traits>::at()"
                                 "subscript out of range");
         return (*this)[n];
     }
     const_reference at(size_type n) const
     {
-        THROW_OUT_OF_RANGE_IF(n >= size_, "basic_string<Char, Traits>::at()"
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_string<Char, Traits>::at()"
                                 "subscript out of range");
         return (*this)[n];
     }
@@ -439,10 +473,11 @@ public:
         return *(end() - 1);
     }
 
+    // 字符串总是以空字符结尾，data() / c_str() 直接返回起始位置
     const_pointer data() const noexcept
-    { return to_raw_pointer(); }
+    { return buffer(); }
     const_pointer c_str() const noexcept
-    { return to_raw_pointer(); }
+    { return buffer(); }
 
     // 添加删除相关操作
     // insert
@@ -459,16 +494,19 @@ public:
     void pop_back()
     {
         MYSTL_DEBUG(!empty());
-        --size_;
+        set_size(size() - 1);
     }
 
+    // assign
+    basic_string& assign(const_pointer s, size_type count);
+
     // append
     basic_string& append(size_type count, value_type ch);
 
     basic_string& append(const basic_string& str)
-    { return append(str, 0, str.size_); }
+    { return append(str, 0, str.size()); }
     basic_string& append(const basic_string& str, size_type pos)
-    { return append(str, pos, str.size_ - pos); }
+    { return append(str, pos, str.size() - pos); }
     basic_string& append(const basic_string& str, size_type pos, size_type count);
 
     basic_string& append(const_pointer s)
@@ -484,7 +522,7 @@ public:
     iterator erase(const_iterator first, const_iterator last);
 
     void clear() noexcept
-    { size_ = 0; }
+    { set_size(0); }
 
     // resize
     void resize(size_type count)
@@ -503,26 +541,26 @@ public:
     // substr
     basic_string substr(size_type index, size_type count = npos)
     {
-        count = mystl::min(count, size_ - index);
-        return basic_string(buffer_ + index, buffer_ + index + count);
+        count = mystl::min(count, size() - index);
+        return basic_string(buffer() + index, buffer() + index + count);
     }
 
     // replace
     basic_string& replace(size_type pos, size_type count, const basic_string& str)
     {
-        THROW_OUT_OF_RANGE_IF(pos > size_, "basic_string<Char, Traits>::replace's pos out of range");
-        return replace_cstr(buffer_ + pos, count, str.buffer_, str.size_);
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>::replace's pos out of range");
+        return replace_cstr(buffer() + pos, count, str.buffer(), str.size());
     }
     basic_string& replace(const_iterator first, const_iterator last, const basic_string& str)
     {
         MYSTL_DEBUG(begin() <= first && last <= end() && first <= last);
-        return replace_cstr(first, static_cast<size_type>(last - first), str.buffer_, str.size_);
+        return replace_cstr(first, static_cast<size_type>(last - first), str.buffer(), str.size());
     }
 
     basic_string& replace(size_type pos, size_type count, const_pointer s)
     {
-        THROW_OUT_OF_RANGE_IF(pos > size_, "basic_string<Char, Traits>::replace's pos out of range");
-        return replace_cstr(buffer_ + pos, count, s, char_traits::length(s));
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>::replace's pos out of range");
+        return replace_cstr(buffer() + pos, count, s, char_traits::length(s));
     }
     basic_string& replace(const_iterator first, const_iterator last, const_pointer s)
     {
@@ -532,8 +570,8 @@ public:
 
     basic_string& replace(size_type pos, size_type count1, const_pointer s, size_type count2)
     {
-        THROW_OUT_OF_RANGE_IF(pos > size_, "basic_string<Char, Traits>::replace's pos out of range");
-        return replace_cstr(buffer_ + pos, count1, s, count2);
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>::replace's pos out of range");
+        return replace_cstr(buffer() + pos, count1, s, count2);
     }
     basic_string& replace(const_iterator first, const_iterator last, const_pointer s, size_type count)
     {
@@ -543,8 +581,8 @@ public:
 
     basic_string& replace(size_type pos, size_type count1, size_type count2, value_type ch)
     {
-        THROW_OUT_OF_RANGE_IF(pos > size_, "basic_string<Char, Traits>::replace's pos out of range");
-        return replace_fill(buffer_ + pos, count1, count2, ch);
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>::replace's pos out of range");
+        return replace_fill(buffer() + pos, count1, count2, ch);
     }
     basic_string& replace(const_iterator first, const_iterator last, size_type count, value_type ch)
     {
@@ -554,8 +592,8 @@ public:
 
     basic_string& replace(size_type pos1, size_type count1, const basic_string& str, size_type pos2, size_type count2 = npos)
     {
-        THROW_OUT_OF_RANGE_IF(pos1 > size_ || pos2 > str.size_, "basic_string<Char, Traits>::replace's pos out of range");
-        return replace_cstr(buffer_ + pos1, count1, str.buffer_ + pos2, count2);
+        THROW_OUT_OF_RANGE_IF(pos1 > size() || pos2 > str.size(), "basic_string<Char, Traits>::replace's pos out of range");
+        return replace_cstr(buffer() + pos1, count1, str.buffer() + pos2, count2);
     }
     template <typename Iter, typename std::enable_if<mystl::is_input_iterator<Iter>::value, int>::type = 0>
     basic_string& replace(const_iterator first, const_iterator last, Iter first2, Iter last2)
@@ -632,14 +670,64 @@ public:
 
     friend std::ostream& operator<<(std::ostream& os, const basic_string& str)
     {
-        for(size_type i = 0; i < str.size_; ++i)os << *(str.buffer_ + i);
+        for(size_type i = 0; i < str.size(); ++i)os << *(str.buffer() + i);
         return os;
     }
 
 private:
     // helper functions
+    // 只交换数据，不交换分配器。对象中没有指向自身的指针，内联和堆上的情况都只需交换三个字
+    void swap_data(basic_string& rhs) noexcept
+    {
+        mystl::swap(rep_, rhs.rep_);
+        mystl::swap(tail_, rhs.tail_);
+    }
+
+    // storage
+    bool is_local() const noexcept
+    { return tail_ <= local_cap; }
+
+    pointer buffer() const noexcept
+    { return is_local() ? const_cast<pointer>(rep_.local) : rep_.heap.ptr; }
+
+    // 修改大小并写入结尾的空字符
+    void set_size(size_type n) noexcept
+    {
+        if(is_local())
+        {
+            tail_ = n;
+            rep_.local[n] = value_type();
+        }
+        else
+        {
+            rep_.heap.size = n;
+            rep_.heap.ptr[n] = value_type();
+        }
+    }
+
+    void init_local() noexcept
+    {
+        tail_ = 0;
+        rep_.local[0] = value_type();
+    }
+
+    // 改为使用堆上容量为 cap 的空间 p，原来的空间由调用者释放
+    void set_heap(pointer p, size_type n, size_type cap) noexcept
+    {
+        rep_.heap.ptr = p;
+        tail_ = cap;
+        set_size(n);
+    }
+
+    // 申请能容纳 cap 个字符及结尾空字符的空间
+    pointer allocate_buffer(size_type cap)
+    { return data_alloc_traits::allocate(this->get_alloc(), cap + 1); }
+
+    // 容纳 n 个字符需要的新容量，至少增长一半
+    size_type next_cap(size_type n) const noexcept
+    { return mystl::max(n, capacity() + (capacity() >> 1)); }
+
     // init / destroy 
-    void try_init() noexcept;
 
     void fill_init(size_type n, value_type ch);
 
@@ -650,13 +738,10 @@ private:
 
     void init_from(const_pointer src, size_type pos, size_type n);
 
-    void destroy_buffer();
-
-    // get raw pointer
-    const_pointer to_raw_pointer() const;
+    void destroy_buffer() noexcept;
 
-    // shrink_to_fit
-    void reinsert(size_type size);
+    // reserve / shrink_to_fit
+    void reinsert(size_type cap);
 
     // append
     template <typename Iter>
@@ -671,226 +756,221 @@ private:
     template <typename Iter>
     basic_string& replace_copy(const_iterator first, const_iterator last, Iter first2, Iter last2);
 
+    pointer replace_gap(size_type pos, size_type count1, size_type count2);
+
     // reallocate
     void reallocate(size_type need);
     iterator reallocate_and_fill(iterator pos, size_type n, value_type ch);
-    iterator reallocate_and_copy(iterator pos, const_iterator first, const_iterator last);
+    template <typename Iter>
+    iterator reallocate_and_copy(iterator pos, Iter first, Iter last);
 };
 
 /*****************************************************************************************/
 
 // 复制赋值操作符
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::operator=(const basic_string& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::operator=(const basic_string& rhs)
 {
     if(this != &rhs)
     {
-        basic_string tmp(rhs);
-        swap(tmp);
+        // 需要传播分配器且两者不相等时，原有空间必须由原分配器释放
+        if(data_alloc_traits::propagate_on_container_copy_assignment::value &&
+           this->get_alloc() != rhs.get_alloc())
+        {
+            destroy_buffer();
+        }
+        mystl::alloc_on_copy(this->get_alloc(), rhs.get_alloc());
+        assign(rhs.buffer(), rhs.size());
     }
     return *this;
 }
 
 // 移动赋值操作符
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::operator=(basic_string&& rhs) noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::operator=(basic_string&& rhs) noexcept
 {
-    destroy_buffer();
-    buffer_ = rhs.buffer_;
-    size_ = rhs.size_;
-    cap_ = rhs.cap_;
-    rhs.buffer_ = nullptr;
-    rhs.size_ = 0;
-    rhs.cap_ = 0;
+    if(this == &rhs)return *this;
+    if(data_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
+    {
+        destroy_buffer();
+        mystl::alloc_on_move(this->get_alloc(), rhs.get_alloc());
+        rep_ = rhs.rep_;
+        tail_ = rhs.tail_;
+        rhs.init_local();
+    }
+    else
+    {
+        // 分配器不相等且不传播时，不能接管 rhs 的空间，只能复制字符
+        basic_string tmp(rhs, this->get_alloc());
+        swap_data(tmp);
+    }
     return *this;
 }
 
 // 用一个字符串赋值
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::operator=(const_pointer s)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::operator=(const_pointer s)
 {
-    const size_type len = char_traits::length(s);
-    if(cap_ < len)
-    {
-        auto new_buffer = data_allocator::allocate(len + 1);
-        data_allocator::deallocate(buffer_);
-        buffer_ = new_buffer;
-        cap_ = len + 1;
-    }
-    char_traits::copy(buffer_, s, len);
-    size_ = len;
-    return *this;
+    return assign(s, char_traits::length(s));
 }
 
 // 用一个字符赋值
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::operator=(value_type ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::operator=(value_type ch)
 {
-    if(cap_ < 1)
+    *buffer() = ch;
+    set_size(1);
+    return *this;
+}
+
+// 用 [s, s + count) 赋值，容量足够时复用原来的空间
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::assign(const_pointer s, size_type count)
+{
+    if(count > capacity())
+    {
+        auto new_buffer = allocate_buffer(count);
+        char_traits::copy(new_buffer, s, count);
+        destroy_buffer();
+        set_heap(new_buffer, count, count);
+    }
+    else
     {
-        auto new_buffer = data_allocator::allocate(2);
-        data_allocator::deallocate(buffer_);
-        buffer_ = new_buffer;
-        cap_ = 2;
+        char_traits::move(buffer(), s, count);
+        set_size(count);
     }
-    *buffer_ = ch;
-    size_ = 1;
     return *this;
 }
 
 // 预留储存空间
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::reserve(size_type n)
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::reserve(size_type n)
 {
-    if(cap_ < n)
+    if(capacity() < n)
     {
         THROW_LENGTH_ERROR_IF(n > max_size(), "n can not larger than max_size()"
                                 "in basic_string<Char,Traits>::reserve(n)");
-        auto new_buffer = data_allocator::allocate(n);
-        char_traits::move(new_buffer, buffer_, size_);
-        buffer_ = new_buffer;
-        cap_ = n;
+        reinsert(n);
     }
 }
 
-// 减少不用的空间
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::shrink_to_fit()
+// 减少不用的空间，足够短时回到内联存储
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::shrink_to_fit()
 {
-    if(size_ != cap_)reinsert(size_);
+    if(size() != capacity())reinsert(size());
 }
 
 // 在 pos 处插入一个元素
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::insert(const_iterator pos, value_type ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::insert(const_iterator pos, value_type ch)
 {
-    iterator r = const_cast<iterator>(pos);
-    if(size_ == cap_)
-    {
-        return reallocate_and_fill(r, 1, ch);
-    }
-    char_traits::move(r + 1, r, end() - r);
-    *r = ch;
-    ++size_;
-    return r;
+    return insert(pos, 1, ch);
 }
 
 // 在 pos 处插入 n 个元素
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::insert(const_iterator pos, size_type count, value_type ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::insert(const_iterator pos, size_type count, value_type ch)
 {
     iterator r = const_cast<iterator>(pos);
     if(count == 0)return r;
-    if(cap_ - size_ < count)
+    if(capacity() - size() < count)
     {
         return reallocate_and_fill(r, count, ch);
     }
-    if(pos == end())
-    {
-        char_traits::fill(end(), count, ch);
-        size_ += count;
-        return r;
-    }
     char_traits::move(r + count, r, end() - r);
     char_traits::fill(r, ch, count);
-    size_ += count;
+    set_size(size() + count);
     return r;
 }
 
 // 在 pos 处插入 [first, last) 内的元素
-template <typename CharType, typename CharTraits>
+template <typename CharType, typename CharTraits, typename Alloc>
 template <typename Iter>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::insert(const_iterator pos, Iter first, Iter last)
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::insert(const_iterator pos, Iter first, Iter last)
 {
     iterator r = const_cast<iterator>(pos);
-    const size_type& len = mystl::distance(first, last);
+    const size_type len = mystl::distance(first, last);
     if(len == 0)return r;
-    if(cap_ - size_ < len)
+    if(capacity() - size() < len)
     {
         return reallocate_and_copy(r, first, last);
     }
-    if(pos == end())
-    {
-        mystl::uninitialized_copy(first, last, end());
-        size_ += len;
-        return r;
-    }
     char_traits::move(r + len, r, end() - r);
-    mystl::uninitialized_copy(first, last, r);
-    size_ += len;
+    mystl::copy(first, last, r);
+    set_size(size() + len);
     return r;
 }
 
 // 在末尾添加 count 个 ch
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::append(size_type count, value_type ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::append(size_type count, value_type ch)
 {
-    THROW_LENGTH_ERROR_IF(size_ > max_size() - count, "basic_string<Char, Tratis>'s size too big");
-    if(cap_ - size_ < count)
+    THROW_LENGTH_ERROR_IF(size() > max_size() - count, "basic_string<Char, Tratis>'s size too big");
+    if(capacity() - size() < count)
     {
         reallocate(count);
     }
-    char_traits::fill(buffer_ + size_, ch, count);
-    size_ += count;
+    char_traits::fill(buffer() + size(), ch, count);
+    set_size(size() + count);
     return *this;
 }
 
 // 在末尾添加 [str[pos] str[pos+count]) 一段
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::append(const basic_string& str, size_type pos, size_type count)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::append(const basic_string& str, size_type pos, size_type count)
 {
-    THROW_LENGTH_ERROR_IF(size_ > max_size() - count, "basic_string<Char, Tratis>'s size too big");
-    if(count == 0)return *this;
-    if(cap_ - size_ < count)
-    {
-        reallocate(count);
-    }
-    char_traits::copy(buffer_ + size_, str.buffer_ + pos, count);
-    size_ += count;
-    return *this;
+    THROW_OUT_OF_RANGE_IF(pos > str.size(), "basic_string<Char, Traits>::append's pos out of range");
+    return append(str.buffer() + pos, mystl::min(count, str.size() - pos));
 }
 
 // 在末尾添加 [s, s+count) 一段
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::append(const_pointer s, size_type count)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::append(const_pointer s, size_type count)
 {
-    THROW_LENGTH_ERROR_IF(size_ > max_size() - count, "basic_string<Char, Tratis>'s size too big");
+    THROW_LENGTH_ERROR_IF(size() > max_size() - count, "basic_string<Char, Tratis>'s size too big");
     if(count == 0)return *this;
-    if(cap_ - size_ < count)
+    if(capacity() - size() < count)
     {
+        // s 可能指向自身，重新分配后按偏移量找回
+        const bool inside = buffer() <= s && s <= buffer() + size();
+        const size_type off = inside ? static_cast<size_type>(s - buffer()) : 0;
         reallocate(count);
+        if(inside)s = buffer() + off;
     }
-    char_traits::copy(buffer_ + size_, s, count);
-    size_ += count;
+    char_traits::copy(buffer() + size(), s, count);
+    set_size(size() + count);
     return *this;
 }
 
 // 删除 pos 处的元素
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::erase(const_iterator pos)
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::erase(const_iterator pos)
 {
     MYSTL_DEBUG(pos != end());
     iterator r = const_cast<iterator>(pos);
     char_traits::move(r, r + 1, end() - r - 1);
-    --size_;
+    set_size(size() - 1);
     return r;
 }
 
 // 删除 [first, last) 的元素
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::erase(const_iterator first, const_iterator last)
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::erase(const_iterator first, const_iterator last)
 {
     if(first == begin() && last == end())
     {
@@ -900,79 +980,86 @@ basic_string<CharType, CharTraits>::erase(const_iterator first, const_iterator l
     const size_type n = end() - last;
     iterator r = const_cast<iterator>(first);
     char_traits::move(r, last, n);
-    size_ -= (last - first);
+    set_size(size() - (last - first));
     return r;
 }
 
 // 重置容器大小
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::resize(size_type count, value_type ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::resize(size_type count, value_type ch)
 {
-    if(count < size_)
+    if(count < size())
     {
-        erase(buffer_ + count, buffer_ + size_);
+        erase(buffer() + count, buffer() + size());
     }
     else
     {
-        append(count - size_, ch);
+        append(count - size(), ch);
     }
 }
 
 // 比较两个 basic_string，小于返回 -1，大于返回 1，等于返回 0
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::compare(const basic_string& str)const
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::compare(const basic_string& str)const
 {
-    return compare_cstr(buffer_, size_, str.buffer_, str.size_);
+    return compare_cstr(buffer(), size(), str.buffer(), str.size());
 }
 
 // 从 pos1 下标开始的 count1 个字符跟另一个 basic_string 比较
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::compare(size_type pos, size_type count, const basic_string& str)const
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::compare(size_type pos, size_type count, const basic_string& str)const
 {
-    auto n1 = mystl::min(count, size_ - pos);
-    return compare_cstr(buffer_ + pos, n1, str.buffer_, str.size_);
+    auto n1 = mystl::min(count, size() - pos);
+    return compare_cstr(buffer() + pos, n1, str.buffer(), str.size());
 }
 
 // 从 pos1 下标开始的 count1 个字符跟另一个 basic_string 下标 pos2 开始的 count2 个字符比较
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::
 compare(size_type pos1, size_type count1, const basic_string& str, size_type pos2, size_type count2) const
 {
-    auto n1 = mystl::min(count1, size_ - pos1);
-    auto n2 = mystl::min(count2, str.size_ - pos2);
-    return compare_cstr(buffer_, n1, str.buffer_, n2);
+    auto n1 = mystl::min(count1, size() - pos1);
+    auto n2 = mystl::min(count2, str.size() - pos2);
+    return compare_cstr(buffer(), n1, str.buffer(), n2);
 }
 
 // 跟一个字符串比较
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::compare(const_pointer s) const
+// 边比较边找 s 的结尾，遇到第一个不同的字符就返回，不必先求出 s 的长度
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::compare(const_pointer s) const
 {
-    auto n2 = char_traits::length(s);
-    return compare_cstr(buffer_, size_, s, n2);
+    const_pointer p = buffer();
+    const size_type n = size();
+    for(size_type i = 0; i < n; ++i)
+    {
+        if(s[i] == value_type())return 1;
+        if(!(p[i] == s[i]))return char_traits::compare(p + i, s + i, 1);
+    }
+    return s[n] == value_type() ? 0 : -1;
 }
 
 // 从下标 pos1 开始的 count1 个字符跟另一个字符串比较
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::
 compare(size_type pos1, size_type count1, const_pointer s) const
 {
-    auto n1 = mystl::min(count1, size_ - pos1);
+    auto n1 = mystl::min(count1, size() - pos1);
     auto n2 = char_traits::length(s);
-    return compare_cstr(buffer_ + pos1, n1, s, n2);
+    return compare_cstr(buffer() + pos1, n1, s, n2);
 }
 
 // 从下标 pos1 开始的 count1 个字符跟另一个字符串的前 count2 个字符比较
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::
 compare(size_type pos1, size_type count1, const_pointer s, size_type count2) const
 {
-    auto n1 = mystl::min(count1, size_ - pos1);
-    return compare_cstr(buffer_ + pos1, n1, s, count2);
+    auto n1 = mystl::min(count1, size() - pos1);
+    return compare_cstr(buffer() + pos1, n1, s, count2);
 }
 
 // 反转 basic_string
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::reverse() noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::reverse() noexcept
 {
     for(auto i = begin(), j = end(); i < j;)
     {
@@ -981,46 +1068,45 @@ void basic_string<CharType, CharTraits>::reverse() noexcept
 }
 
 // 交换两个 basic_string
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::swap(basic_string& rhs) noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::swap(basic_string& rhs) noexcept
 {
     if(this != &rhs)
     {
-        mystl::swap(buffer_, rhs.buffer_);
-        mystl::swap(size_, rhs.size_);
-        mystl::swap(cap_, rhs.cap_);
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
     }
 }
 
 // 从下标 pos 开始查找字符为 ch 的元素，若找到返回其下标，否则返回 npos
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::find(value_type ch, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::find(value_type ch, size_type pos) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        if(*(buffer_ + i) == ch)return i;
+        if(*(buffer() + i) == ch)return i;
     }
     return npos;
 }
 
 // 从下标 pos 开始查找字符串 str，若找到返回起始位置的下标，否则返回 npos
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::find(const_pointer s, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::find(const_pointer s, size_type pos) const noexcept
 {
     const size_type len = char_traits::length(s);
     if(len == 0)return pos;
-    if(size_ - pos < len)return npos;
-    const size_type left = size_ - len;
+    if(size() - pos < len)return npos;
+    const size_type left = size() - len;
     for(auto i = pos; i <= left; ++i)
     {
-        if(*(buffer_ + i) == *s)
+        if(*(buffer() + i) == *s)
         {
             size_type j = 1;
             for(; j < len; ++j)
             {
-                if(*(buffer_ + i + j) != *(s + j))break;
+                if(*(buffer() + i + j) != *(s + j))break;
             }
             if(j == len)return i;
         }
@@ -1029,21 +1115,21 @@ basic_string<CharType, CharTraits>::find(const_pointer s, size_type pos) const n
 }
 
 // 从下标 pos 开始查找字符串 str 的前 count 个字符，若找到返回起始位置的下标，否则返回 npos
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::find(const_pointer s, size_type pos, size_type count) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::find(const_pointer s, size_type pos, size_type count) const noexcept
 {
     if(count == 0)return pos;
-    if(size_ - pos < count)return npos;
-    const size_type left = size_ - count;
+    if(size() - pos < count)return npos;
+    const size_type left = size() - count;
     for(auto i = pos; i <= left; ++i)
     {
-        if(*(buffer_ + i) == *s)
+        if(*(buffer() + i) == *s)
         {
             size_type j = 1;
             for(; j < count; ++j)
             {
-                if(*(buffer_ + i + j) != *(s + j))break;
+                if(*(buffer() + i + j) != *(s + j))break;
             }
             if(j == count)return i;
         }
@@ -1052,22 +1138,22 @@ basic_string<CharType, CharTraits>::find(const_pointer s, size_type pos, size_ty
 }
 
 // 从下标 pos 开始查找字符串 str，若找到返回起始位置的下标，否则返回 npos
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::find(const basic_string& str, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::find(const basic_string& str, size_type pos) const noexcept
 {
-    const size_type count = str.size_;
+    const size_type count = str.size();
     if(count == 0)return pos;
-    if(size_ - pos < count)return npos;
-    const size_type left = size_ - count;
+    if(size() - pos < count)return npos;
+    const size_type left = size() - count;
     for(auto i = pos; i <= left; ++i)
     {
-        if(*(buffer_ + i) == str.front())
+        if(*(buffer() + i) == str.front())
         {
             size_type j = 1;
             for(; j < count; ++j)
             {
-                if(*(buffer_ + i + j) != str[j])break;
+                if(*(buffer() + i + j) != str[j])break;
             }
             if(j == count)return i;
         }
@@ -1076,42 +1162,42 @@ basic_string<CharType, CharTraits>::find(const basic_string& str, size_type pos)
 }
 
 // 从下标 pos 开始反向查找值为 ch 的元素，与 find 类似
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::rfind(value_type ch, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::rfind(value_type ch, size_type pos) const noexcept
 {
-    if(pos >= size_)pos = size_ - 1;
+    if(pos >= size())pos = size() - 1;
     for(auto i = pos; i != 0; --i)
     {
-        if(*(buffer_ + i) == ch)return i;
+        if(*(buffer() + i) == ch)return i;
     }
     return front() == ch ? 0 : npos;
 }
 
 // 从下标 pos 开始反向查找字符串 str，与 find 类似
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::rfind(const_pointer s, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::rfind(const_pointer s, size_type pos) const noexcept
 {
-    if(pos >= size_)pos = size_ - 1;
+    if(pos >= size())pos = size() - 1;
     const size_type len = char_traits::length(s);
     if(len == 0)return pos;
     if(len == 1)
     {
         for(auto i = pos; i != 0; --i)
         {
-            if(*(buffer_ + i) == *s)return i;
+            if(*(buffer() + i) == *s)return i;
         }
         return front() == *s ? 0 : npos;
     }
     for(auto i = pos; i >= len - 1; --i)
     {
-        if(*(buffer_ + i) == *(s + len - 1))
+        if(*(buffer() + i) == *(s + len - 1))
         {
             size_type j = 1;
             for(; j < len; ++j)
             {
-                if(*(buffer_ + i - j) != *(s + len - j - 1))break;
+                if(*(buffer() + i - j) != *(s + len - j - 1))break;
             }
             if(j == len)return i - len + 1;
         }
@@ -1120,21 +1206,21 @@ basic_string<CharType, CharTraits>::rfind(const_pointer s, size_type pos) const
 }
 
 // 从下标 pos 开始反向查找字符串 str 前 count 个字符，与 find 类似
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::rfind(const_pointer s, size_type pos, size_type count) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::rfind(const_pointer s, size_type pos, size_type count) const noexcept
 {
-    if(pos >= size_)pos = size_ - 1;
+    if(pos >= size())pos = size() - 1;
     if(count == 0)return pos;
     if(pos + 1 < count)return npos;
     for(auto i = pos; i >= count - 1; --i)
     {
-        if(*(buffer_ + i) == *(s + count - 1))
+        if(*(buffer() + i) == *(s + count - 1))
         {
             size_type j = 1;
             for(; j < count; ++j)
             {
-                if(*(buffer_ + i - j) != *(s + count - j - 1))break;
+                if(*(buffer() + i - j) != *(s + count - j - 1))break;
             }
             if(j == count)return i - count + 1;
         }
@@ -1143,22 +1229,22 @@ basic_string<CharType, CharTraits>::rfind(const_pointer s, size_type pos, size_t
 }
 
 // 从下标 pos 开始反向查找字符串 str，与 find 类似
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::rfind(const basic_string& str, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::rfind(const basic_string& str, size_type pos) const noexcept
 {
-    const size_type count = str.size_;
-    if(pos >= size_)pos = size_ - 1;
+    const size_type count = str.size();
+    if(pos >= size())pos = size() - 1;
     if(count == 0)return pos;
     if(pos + 1 < count)return npos;
     for(auto i = pos; i >= count - 1; --i)
     {
-        if(*(buffer_ + i) == str[count - 1])
+        if(*(buffer() + i) == str[count - 1])
         {
             size_type j = 1;
             for(; j < count; ++j)
             {
-                if(*(buffer_ + i - j) != str[count -j - 1])break;
+                if(*(buffer() + i - j) != str[count -j - 1])break;
             }
             if(j == count)return i - count + 1;
         }
@@ -1167,26 +1253,26 @@ basic_string<CharType, CharTraits>::rfind(const basic_string& str, size_type pos
 }
 
 // 从下标 pos 开始查找 ch 出现的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::find_first_of(value_type ch, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::find_first_of(value_type ch, size_type pos) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        if(*(buffer_ + i) == ch)return i;
+        if(*(buffer() + i) == ch)return i;
     }
     return npos;
 }
 
 // 从下标 pos 开始查找字符串 s 其中的一个字符出现的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::find_first_of(const_pointer s, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::find_first_of(const_pointer s, size_type pos) const noexcept
 {
     const size_type len = char_traits::length(s);
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < len; ++j)
         {
             if(ch == *(s + j))return i;
@@ -1196,14 +1282,14 @@ basic_string<CharType, CharTraits>::find_first_of(const_pointer s, size_type pos
 }
 
 // 从下标 pos 开始查找字符串 s 
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_first_of(const_pointer s, size_type pos, size_type count) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < count; ++j)
         {
             if(ch == *(s + j))return i;
@@ -1213,15 +1299,15 @@ find_first_of(const_pointer s, size_type pos, size_type count) const noexcept
 }
 
 // 从下标 pos 开始查找字符串 str 其中一个字符出现的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_first_of(const basic_string& str, size_type pos) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        value_type ch = *(buffer_ + i);
-        for(size_type j = 0; j < str.size_; ++j)
+        value_type ch = *(buffer() + i);
+        for(size_type j = 0; j < str.size(); ++j)
         {
             if(ch == str[j])return i;
         }
@@ -1230,28 +1316,28 @@ find_first_of(const basic_string& str, size_type pos) const noexcept
 }
 
 // 从下标 pos 开始查找与 ch 不相等的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_first_not_of(value_type ch, size_type pos) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        if(*(buffer_ + i) != ch)return i;
+        if(*(buffer() + i) != ch)return i;
     }
     return npos;
 }
 
 // 从下标 pos 开始查找与字符串 s 其中一个字符不相等的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_first_not_of(const_pointer s, size_type pos) const noexcept
 {
     const size_type len = char_traits::length(s);
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < len; ++j)
         {
             if(ch != *(s + j))return i;
@@ -1261,14 +1347,14 @@ find_first_not_of(const_pointer s, size_type pos) const noexcept
 }
 
 // 从下标 pos 开始查找与字符串 s 前 count 个字符中不相等的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_first_not_of(const_pointer s, size_type pos, size_type count) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < count; ++j)
         {
             if(ch != *(s + j))return i;
@@ -1278,15 +1364,15 @@ find_first_not_of(const_pointer s, size_type pos, size_type count) const noexcep
 }
 
 // 从下标 pos 开始查找与字符串 str 的字符中不相等的第一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_first_not_of(const basic_string& str, size_type pos) const noexcept
 {
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        value_type ch = *(buffer_ + i);
-        for(size_type j = 0; j < str.size_; ++j)
+        value_type ch = *(buffer() + i);
+        for(size_type j = 0; j < str.size(); ++j)
         {
             if(ch != str[j])return i;
         }
@@ -1295,28 +1381,28 @@ find_first_not_of(const basic_string& str, size_type pos) const noexcept
 }
 
 // 从下标 pos 开始查找与 ch 相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_of(value_type ch, size_type pos) const noexcept
 {
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        if(*(buffer_ + i) == ch)return i;
+        if(*(buffer() + i) == ch)return i;
     }
     return npos;
 }
 
 // 从下标 pos 开始查找与字符串 s 其中一个字符相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_of(const_pointer s, size_type pos) const noexcept
 {
     const size_type len = char_traits::length(s);
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < len; ++j)
         {
             if(ch == *(s + j))return i;
@@ -1326,14 +1412,14 @@ find_last_of(const_pointer s, size_type pos) const noexcept
 }
 
 // 从下标 pos 开始查找与字符串 s 前 count 个字符中相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_of(const_pointer s, size_type pos, size_type count) const noexcept
 {
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < count; ++j)
         {
             if(ch == *(s + j))return i;
@@ -1343,15 +1429,15 @@ find_last_of(const_pointer s, size_type pos, size_type count) const noexcept
 }
 
 // 从下标 pos 开始查找与字符串 str 字符中相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_of(const basic_string& str, size_type pos) const noexcept
 {
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        value_type ch = *(buffer_ + i);
-        for(size_type j = 0; j < str.size_; ++j)
+        value_type ch = *(buffer() + i);
+        for(size_type j = 0; j < str.size(); ++j)
         {
             if(ch == str[j])return i;
         }
@@ -1360,28 +1446,28 @@ find_last_of(const basic_string& str, size_type pos) const noexcept
 }
 
 // 从下标 pos 开始查找与 ch 字符不相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_not_of(value_type ch, size_type pos) const noexcept
 {
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        if(*(buffer_ + i) != ch)return i;
+        if(*(buffer() + i) != ch)return i;
     }
     return npos;
 }
 
 // 从下标 pos 开始查找与字符串 s 的字符中不相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_not_of(const_pointer s, size_type pos) const noexcept
 {
     const size_type len = char_traits::length(s);
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < len; ++j)
         {
             if(ch != *(s + j))return i;
@@ -1391,14 +1477,14 @@ find_last_not_of(const_pointer s, size_type pos) const noexcept
 }
 
 // 从下标 pos 开始查找与字符串 s 前 count 个字符中不相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_not_of(const_pointer s, size_type pos, size_type count) const noexcept
 {
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        value_type ch = *(buffer_ + i);
+        value_type ch = *(buffer() + i);
         for(size_type j = 0; j < count; ++j)
         {
             if(ch != *(s + j))return i;
@@ -1408,15 +1494,15 @@ find_last_not_of(const_pointer s, size_type pos, size_type count) const noexcept
 }
 
 // 从下标 pos 开始查找与字符串 str 字符中不相等的最后一个位置
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::
 find_last_not_of(const basic_string& str, size_type pos) const noexcept
 {
-    for(auto i = size_ - 1; i >= pos; --i)
+    for(auto i = size() - 1; i >= pos; --i)
     {
-        value_type ch = *(buffer_ + i);
-        for(size_type j = 0; j < str.size_; ++j)
+        value_type ch = *(buffer() + i);
+        for(size_type j = 0; j < str.size(); ++j)
         {
             if(ch != str[j])return i;
         }
@@ -1425,14 +1511,14 @@ find_last_not_of(const basic_string& str, size_type pos) const noexcept
 }
 
 // 返回从下标 pos 开始字符为 ch 的元素出现的次数
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::size_type
-basic_string<CharType, CharTraits>::count(value_type ch, size_type pos) const noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::size_type
+basic_string<CharType, CharTraits, Alloc>::count(value_type ch, size_type pos) const noexcept
 {
     size_type n = 0;
-    for(auto i = pos; i < size_; ++i)
+    for(auto i = pos; i < size(); ++i)
     {
-        if(*(buffer_ + i) == ch)++n;
+        if(*(buffer() + i) == ch)++n;
     }
     return n;
 }
@@ -1440,150 +1526,102 @@ basic_string<CharType, CharTraits>::count(value_type ch, size_type pos) const no
 /*****************************************************************************************/
 // helper function
 
-// 尝试初始化一段 buffer，若分配失败则忽略，不会抛出异常
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::try_init() noexcept
-{
-    try
-    {
-        buffer_ = data_allocator::allocate(static_cast<size_type>(STRING_INIT_SIZE));
-        size_ = 0;
-        cap_ = 0;
-    }
-    catch(...)
-    {
-        // data_allocator::deallocate(buffer_);
-        buffer_ = nullptr;
-        size_ = 0;
-        cap_ = 0;
-        // no throw
-    }
-}
-
 // fill_init 函数
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::fill_init(size_type n, value_type ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::fill_init(size_type n, value_type ch)
 {
-    const auto init_size = mystl::max(n + 1, static_cast<size_type>(STRING_INIT_SIZE));
-    buffer_ = data_allocator::allocate(init_size);
-    char_traits::fill(buffer_, ch, n);
-    size_ = n;
-    cap_ = init_size;
+    init_local();
+    if(n > local_cap)
+        set_heap(allocate_buffer(n), 0, n);
+    char_traits::fill(buffer(), ch, n);
+    set_size(n);
 }
 
 // copy_init 函数
-template <typename CharType, typename CharTraits>
+template <typename CharType, typename CharTraits, typename Alloc>
 template <typename Iter>
-void basic_string<CharType, CharTraits>::copy_init(Iter first, Iter last, mystl::input_iterator_tag)
+void basic_string<CharType, CharTraits, Alloc>::copy_init(Iter first, Iter last, mystl::input_iterator_tag)
 {
-    size_type n = mystl::distance(first, last);
-    const auto init_size = mystl::max(n + 1, static_cast<size_type>(STRING_INIT_SIZE));
+    init_local();
     try
     {
-        buffer_ = data_allocator::allocate(init_size);
-        size_ = n;
-        cap_ = init_size;
+        for(; first != last; ++first)append(1, *first);
     }
     catch(...)
     {
-        buffer_ = nullptr;
-        size_ = 0;
-        cap_ = 0;
+        destroy_buffer();
         throw;
     }
-    for(; n > 0; --n, ++first)append(*first);
 }
 
-template <typename CharType, typename CharTraits>
+template <typename CharType, typename CharTraits, typename Alloc>
 template <typename Iter>
-void basic_string<CharType, CharTraits>::copy_init(Iter first, Iter last, mystl::forward_iterator_tag)
+void basic_string<CharType, CharTraits, Alloc>::copy_init(Iter first, Iter last, mystl::forward_iterator_tag)
 {
-    size_type n = mystl::distance(first, last);
-    const auto init_size = mystl::max(n + 1, static_cast<size_type>(STRING_INIT_SIZE));
-    try
-    {// 分input和forward好像也没区别啊
-        buffer_ = data_allocator::allocate(init_size);
-        size_ = n;
-        cap_ = init_size;
-        mystl::uninitialized_copy(first, last, buffer_);
-    }
-    catch(...)
-    {
-        buffer_ = nullptr;
-        size_ = 0;
-        cap_ = 0;
-        throw;
-    }
+    const size_type n = mystl::distance(first, last);
+    init_local();
+    if(n > local_cap)
+        set_heap(allocate_buffer(n), 0, n);
+    mystl::copy(first, last, buffer());
+    set_size(n);
 }
 
 // init_from 函数
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::init_from(const_pointer src, size_type pos, size_type count)
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::init_from(const_pointer src, size_type pos, size_type count)
 {
-    const auto init_size = mystl::max(count + 1, static_cast<size_type>(STRING_INIT_SIZE));
-    buffer_ = data_allocator::allocate(init_size);
-    char_traits::copy(buffer_, src + pos, count);
-    size_ = count;
-    cap_ = init_size;
+    init_local();
+    if(count > local_cap)
+        set_heap(allocate_buffer(count), 0, count);
+    char_traits::copy(buffer(), src + pos, count);
+    set_size(count);
 }
 
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::destroy_buffer()
+// 释放堆上的空间，回到空的内联状态
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::destroy_buffer() noexcept
 {
-    if(buffer_ != nullptr)
+    if(!is_local())
     {
-        data_allocator::deallocate(buffer_, cap_);
-        buffer_ = nullptr;
-        size_ = 0;
-        cap_ = 0;
+        data_alloc_traits::deallocate(this->get_alloc(), rep_.heap.ptr, tail_ + 1);
     }
+    init_local();
 }
 
-// to_raw_pointer 函数
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::const_pointer
-basic_string<CharType, CharTraits>::to_raw_pointer() const
-{
-    *(buffer_ + size_) = value_type();
-    return buffer_;
-}
-
-// reinsert 函数
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::reinsert(size_type size)
+// reinsert 函数，把字符搬到容量为 cap 的新空间，cap 不超过 local_cap 时搬回内联空间
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::reinsert(size_type cap)
 {
-    auto new_buffer = data_allocator::allocate(size);
-    try
+    const size_type n = size();
+    if(cap <= local_cap)
     {
-        char_traits::move(new_buffer, buffer_, size);
+        if(is_local())return;
+        pointer old = rep_.heap.ptr;
+        const size_type old_cap = tail_;
+        char_traits::copy(rep_.local, old, n);
+        tail_ = n;
+        rep_.local[n] = value_type();
+        data_alloc_traits::deallocate(this->get_alloc(), old, old_cap + 1);
+        return;
     }
-    catch(...)
-    {
-        data_allocator::deallocate(new_buffer);
-    }
-    buffer_ = new_buffer;
-    size_ = size;
-    cap_ = size;
+    auto new_buffer = allocate_buffer(cap);
+    char_traits::copy(new_buffer, buffer(), n);
+    destroy_buffer();
+    set_heap(new_buffer, n, cap);
 }
 
 // append_range，末尾追加一段 [first, last) 内的字符
-template <typename CharType, typename CharTraits>
+template <typename CharType, typename CharTraits, typename Alloc>
 template <typename Iter>
-basic_string<CharType, CharTraits>&
-basic_string<CharType, CharTraits>::append_range(Iter first, Iter last)
+basic_string<CharType, CharTraits, Alloc>&
+basic_string<CharType, CharTraits, Alloc>::append_range(Iter first, Iter last)
 {
-    const size_type n = mystl::distance(first, last);
-    THROW_LENGTH_ERROR_IF(size_ > max_size() - n, "basic_string<Char, Tratis>'s size too big");
-    if(cap_ - size_ < n)
-    {
-        reallocate(n);
-    }
-    mystl::uninitialized_copy(first, last, buffer_ + size_);
+    insert(cend(), first, last);
     return *this;
 }
 
-template <typename CharType, typename CharTraits>
-int basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+int basic_string<CharType, CharTraits, Alloc>::
 compare_cstr(const_pointer s1, size_type n1, const_pointer s2, size_type n2) const
 {
     auto rlen = mystl::min(n1, n2);
@@ -1595,321 +1633,369 @@ compare_cstr(const_pointer s1, size_type n1, const_pointer s2, size_type n2) con
 }
 
 // 把 first 开始的 count1 个字符替换成 str 开始的 count2 个字符
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>& basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>& basic_string<CharType, CharTraits, Alloc>::
 replace_cstr(const_iterator first, size_type count1, const_pointer s, size_type count2)
 {
     if(static_cast<size_type>(cend() - first) < count1)
     {
         count1 = cend() - first;
     }
-    if(count1 < count2)
+    if(cbegin() <= s && s < cend())
     {
-        const size_type add = count2 - count1;
-        THROW_LENGTH_ERROR_IF(size_ > max_size() - add, "basic_string<Char, Traits>'s size too big");
-        if(size_ > cap_ - add)
-        {
-            reallocate(add);
-        }
-        pointer r = const_cast<pointer>(first);
-        char_traits::move(r + count2, r + count1, end() - (first + count1));
-        char_traits::copy(r, s, count2);
-        size_ += add;
-    }
-    else
-    {
-        pointer r = const_cast<pointer>(first);
-        char_traits::move(r + count2, r + count1, end() - (first + count1));
-        char_traits::copy(r, s, count2);
-        size_ -= count1 - count2;
+        // s 指向自身时，移动字符会覆盖 s，先复制一份
+        const basic_string tmp(s, count2, this->get_alloc());
+        return replace_cstr(first, count1, tmp.buffer(), count2);
     }
+    char_traits::copy(replace_gap(first - cbegin(), count1, count2), s, count2);
     return *this;
 }
 
 // 把 first 开始的 count1 个字符替换成 count2 个 ch 字符
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>& basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>& basic_string<CharType, CharTraits, Alloc>::
 replace_fill(const_iterator first, size_type count1, size_type count2, value_type ch)
 {
     if(static_cast<size_type>(cend() - first) < count1)
     {
         count1 = cend() - first;
     }
-    if(count1 < count2)
-    {
-        const size_type add = count2 - count1;
-        THROW_LENGTH_ERROR_IF(size_ > max_size() - add, "basic_string<Char, Traits>'s size too big");
-        if(size_ > cap_ - add)
-        {
-            reallocate(add);
-        }
-        pointer r = const_cast<pointer>(first);
-        char_traits::move(r + count2, r + count1, end() - (first + count1));
-        char_traits::fill(r, ch, count2);
-        size_ += add;
-    }
-    else
-    {
-        pointer r = const_cast<pointer>(first);
-        char_traits::move(r + count2, r + count1, end() - (first + count1));
-        char_traits::fill(r, ch, count2);
-        size_ -= count1 - count2;
-    }
+    char_traits::fill(replace_gap(first - cbegin(), count1, count2), ch, count2);
     return *this;
 }
 
 // 把 [first, last) 的字符替换成 [first2, last2)
-template <typename CharType, typename CharTraits>
+template <typename CharType, typename CharTraits, typename Alloc>
 template <typename Iter>
-basic_string<CharType, CharTraits>& basic_string<CharType, CharTraits>::
+basic_string<CharType, CharTraits, Alloc>& basic_string<CharType, CharTraits, Alloc>::
 replace_copy(const_iterator first, const_iterator last, Iter first2, Iter last2)
 {
-    size_type len1 = last - first;
-    size_type len2 = mystl::distance(first2, last2);
-    if(len1 < len2)
+    const basic_string tmp(first2, last2, this->get_alloc());
+    return replace_cstr(first, static_cast<size_type>(last - first), tmp.buffer(), tmp.size());
+}
+
+// replace_gap 函数
+// 把下标 pos 开始的 count1 个字符替换成 count2 个待写入的字符，返回这段空间的起始位置
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::pointer
+basic_string<CharType, CharTraits, Alloc>::
+replace_gap(size_type pos, size_type count1, size_type count2)
+{
+    const size_type n = size();
+    const size_type rest = n - pos - count1;
+    if(count2 > count1)
     {
-        const size_type add = len2 - len1;
-        THROW_LENGTH_ERROR_IF(size_ > max_size() - add, "basic_string<Char, Traits>'s size too big");
-        if(size_ > cap_ - add)
+        const size_type add = count2 - count1;
+        THROW_LENGTH_ERROR_IF(n > max_size() - add, "basic_string<Char, Traits>'s size too big");
+        if(add > capacity() - n)
         {
-            reallocate(add);
+            const size_type new_cap = next_cap(n + add);
+            auto new_buffer = allocate_buffer(new_cap);
+            char_traits::copy(new_buffer, buffer(), pos);
+            char_traits::copy(new_buffer + pos + count2, buffer() + pos + count1, rest);
+            destroy_buffer();
+            set_heap(new_buffer, n + add, new_cap);
+            return new_buffer + pos;
         }
-        pointer r = const_cast<pointer>(first);
-        char_traits::move(r + len2, r + len1, end() - (first + len1));
-        char_traits::copy(r, first2, len2);
-        // mystl::uninitialized_copy(first2, last2, first);
-        size_ += add;
-    }
-    else
-    {
-        pointer r = const_cast<pointer>(first);
-        char_traits::move(r + len2, r + len1, end() - (first + len1));
-        char_traits::copy(r, first2, len2);
-        // mystl::uninitialized_copy(first2, last2, first);
-        size_ -= len1 - len2;
     }
-    return *this;
+    pointer r = buffer() + pos;
+    char_traits::move(r + count2, r + count1, rest);
+    set_size(n - count1 + count2);
+    return r;
 }
 
-// reallocate 函数
-template <typename CharType, typename CharTraits>
-void basic_string<CharType, CharTraits>::reallocate(size_type need)
+// reallocate 函数，保证还能再容纳 need 个字符
+template <typename CharType, typename CharTraits, typename Alloc>
+void basic_string<CharType, CharTraits, Alloc>::reallocate(size_type need)
 {
-    const auto new_cap = mystl::max(cap_ + need, cap_ + (cap_ >> 1));
-    auto new_buffer = data_allocator::allocate(new_cap);
-    char_traits::move(new_buffer, buffer_, size_);
-    data_allocator::deallocate(buffer_);
-    buffer_ = new_buffer;
-    cap_ = new_cap;
+    reinsert(next_cap(size() + need));
 }
 
 // reallocate_and_fill 函数
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::
+template <typename CharType, typename CharTraits, typename Alloc>
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::
 reallocate_and_fill(iterator pos, size_type n, value_type ch)
 {
-    const auto r = pos - buffer_;
-    // const auto old_cap = cap_;
-    const auto new_cap = mystl::max(cap_ + n, cap_ + (cap_ >> 1));
-    auto new_buffer = data_allocator::allocate(new_cap);
-    auto e1 = char_traits::move(new_buffer, buffer_, r) + r;
-    auto e2 = char_traits::fill(e1, ch, n) + n;
-    char_traits::move(e2, buffer_ + r, size_ - r);
-    data_allocator::deallocate(buffer_);
-    buffer_ = new_buffer;
-    size_ += n;
-    cap_ = new_cap;
-    return buffer_ + r;
-}
-
-// reallocate_and_copy 函数
-template <typename CharType, typename CharTraits>
-typename basic_string<CharType, CharTraits>::iterator
-basic_string<CharType, CharTraits>::
-reallocate_and_copy(iterator pos, const_iterator first, const_iterator last)
-{
-    const auto r = pos - buffer_;
-    // const auto old_cap = cap_;
+    auto r = replace_gap(pos - buffer(), 0, n);
+    char_traits::fill(r, ch, n);
+    return r;
+}
+
+// reallocate_and_copy 函数，[first, last) 可能指向自身，复制完成后才释放原来的空间
+template <typename CharType, typename CharTraits, typename Alloc>
+template <typename Iter>
+typename basic_string<CharType, CharTraits, Alloc>::iterator
+basic_string<CharType, CharTraits, Alloc>::
+reallocate_and_copy(iterator pos, Iter first, Iter last)
+{
+    const size_type r = pos - buffer();
+    const size_type old_size = size();
     const size_type n = mystl::distance(first, last);
-    const auto new_cap = mystl::max(cap_ + n, cap_ + (cap_ >> 1));
-    auto new_buffer = data_allocator::allocate(new_cap);
-    auto e1 = char_traits::move(new_buffer, buffer_, r) + r;
-    auto e2 = mystl::uninitialized_copy_n(first, n, e1);
-    char_traits::move(e2, buffer_ + r, size_ - r);
-    data_allocator::deallocate(buffer_);
-    buffer_ = new_buffer;
-    size_ += n;
-    cap_ = new_cap;
-    return buffer_ + r;
+    THROW_LENGTH_ERROR_IF(old_size > max_size() - n, "basic_string<Char, Traits>'s size too big");
+    const auto new_cap = next_cap(old_size + n);
+    auto new_buffer = allocate_buffer(new_cap);
+    char_traits::copy(new_buffer, buffer(), r);
+    mystl::copy(first, last, new_buffer + r);
+    char_traits::copy(new_buffer + r + n, buffer() + r, old_size - r);
+    destroy_buffer();
+    set_heap(new_buffer, old_size + n, new_cap);
+    return new_buffer + r;
 }
 
 /*****************************************************************************************/
 // 重载全局操作符
 
 // 重载 operator+
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(lhs);
+    basic_string<CharType, CharTraits, Alloc> tmp(lhs);
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(const CharType* lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(lhs);
+    basic_string<CharType, CharTraits, Alloc> tmp(lhs);
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(CharType ch, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(CharType ch, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(1, ch);
+    basic_string<CharType, CharTraits, Alloc> tmp(1, ch);
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(const basic_string<CharType, CharTraits>& lhs, const CharType* rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
 {
-    basic_string<CharType, CharTraits> tmp(lhs);
+    basic_string<CharType, CharTraits, Alloc> tmp(lhs);
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(const basic_string<CharType, CharTraits>& lhs, CharType ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(const basic_string<CharType, CharTraits, Alloc>& lhs, CharType ch)
 {
-    basic_string<CharType, CharTraits> tmp(lhs);
+    basic_string<CharType, CharTraits, Alloc> tmp(lhs);
     tmp.append(1, ch);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(basic_string<CharType, CharTraits>&& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(basic_string<CharType, CharTraits, Alloc>&& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(lhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(lhs));
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(const basic_string<CharType, CharTraits>& lhs, basic_string<CharType, CharTraits>&& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(const basic_string<CharType, CharTraits, Alloc>& lhs, basic_string<CharType, CharTraits, Alloc>&& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(rhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(rhs));
     tmp.insert(tmp.begin(), lhs.begin(), lhs.end());
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(basic_string<CharType, CharTraits>&& lhs, basic_string<CharType, CharTraits>&& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(basic_string<CharType, CharTraits, Alloc>&& lhs, basic_string<CharType, CharTraits, Alloc>&& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(lhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(lhs));
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(const CharType* lhs, basic_string<CharType, CharTraits>&& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(const CharType* lhs, basic_string<CharType, CharTraits, Alloc>&& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(rhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(rhs));
     tmp.insert(tmp.begin(), lhs, lhs + char_traits<CharType>::length(lhs));
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(CharType ch, basic_string<CharType, CharTraits>&& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(CharType ch, basic_string<CharType, CharTraits, Alloc>&& rhs)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(rhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(rhs));
     tmp.insert(tmp.begin(), ch);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(basic_string<CharType, CharTraits>&& lhs, const CharType* rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(basic_string<CharType, CharTraits, Alloc>&& lhs, const CharType* rhs)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(lhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(lhs));
     tmp.append(rhs);
     return tmp;
 }
 
-template <typename CharType, typename CharTraits>
-basic_string<CharType, CharTraits>
-operator+(basic_string<CharType, CharTraits>&& lhs, CharType ch)
+template <typename CharType, typename CharTraits, typename Alloc>
+basic_string<CharType, CharTraits, Alloc>
+operator+(basic_string<CharType, CharTraits, Alloc>&& lhs, CharType ch)
 {
-    basic_string<CharType, CharTraits> tmp(mystl::move(lhs));
+    basic_string<CharType, CharTraits, Alloc> tmp(mystl::move(lhs));
     tmp.append(1, ch);
     return tmp;
 }
 
 // 重载比较操作符
-template <typename CharType, typename CharTraits>
-bool operator==(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator==(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
     return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
 }
 
-template <typename CharType, typename CharTraits>
-bool operator!=(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator!=(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
     return lhs.size() != rhs.size() || lhs.compare(rhs) != 0;
 }
 
-template <typename CharType, typename CharTraits>
-bool operator<(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator<(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
     return lhs.compare(rhs) < 0;
 }
 
-template <typename CharType, typename CharTraits>
-bool operator<=(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator<=(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
     return lhs.compare(rhs) <= 0;
 }
 
-template <typename CharType, typename CharTraits>
-bool operator>(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator>(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
     return lhs.compare(rhs) > 0;
 }
 
-template <typename CharType, typename CharTraits>
-bool operator>=(const basic_string<CharType, CharTraits>& lhs, const basic_string<CharType, CharTraits>& rhs)
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator>=(const basic_string<CharType, CharTraits, Alloc>& lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
 {
     return lhs.compare(rhs) >= 0;
 }
 
+// 与字符串指针比较，不必为右侧（或左侧）构造临时的 basic_string
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator==(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
+{
+    return lhs.compare(rhs) == 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator==(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
+{
+    return rhs.compare(lhs) == 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator!=(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
+{
+    return lhs.compare(rhs) != 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator!=(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
+{
+    return rhs.compare(lhs) != 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator<(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator<(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
+{
+    return rhs.compare(lhs) > 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator<=(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
+{
+    return lhs.compare(rhs) <= 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator<=(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
+{
+    return rhs.compare(lhs) >= 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator>(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
+{
+    return lhs.compare(rhs) > 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator>(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
+{
+    return rhs.compare(lhs) < 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator>=(const basic_string<CharType, CharTraits, Alloc>& lhs, const CharType* rhs)
+{
+    return lhs.compare(rhs) >= 0;
+}
+
+template <typename CharType, typename CharTraits, typename Alloc>
+bool operator>=(const CharType* lhs, const basic_string<CharType, CharTraits, Alloc>& rhs)
+{
+    return rhs.compare(lhs) <= 0;
+}
+
 // 重载 mystl 的 swap
-template <typename CharType, typename CharTraits>
-void swap(basic_string<CharType, CharTraits>& lhs, basic_string<CharType, CharTraits>& rhs) noexcept
+template <typename CharType, typename CharTraits, typename Alloc>
+void swap(basic_string<CharType, CharTraits, Alloc>& lhs, basic_string<CharType, CharTraits, Alloc>& rhs) noexcept
 {
     lhs.swap(rhs);
 }
 
 // 特化 mystl::hash
-template <typename CharType, typename CharTraits>
-struct hash<basic_string<CharType, CharTraits>>
+template <typename CharType, typename CharTraits, typename Alloc>
+struct hash<basic_string<CharType, CharTraits, Alloc>>
 {
-    size_t operator()(const basic_string<CharType, CharTraits>& str)
+    size_t operator()(const basic_string<CharType, CharTraits, Alloc>& str) const noexcept
     {
-        return bitwise_hash((const unsigned char*)str.c_str(), str.size() * sizeof(CharType));
+        return bitwise_hash((const unsigned char*)str.data(), str.size() * sizeof(CharType));
     }
 };
 
+// basic_string 的内联空间不依赖对象地址，堆上的空间只通过指针引用
+template <typename CharType, typename CharTraits, typename Alloc>
+struct is_trivially_relocatable<basic_string<CharType, CharTraits, Alloc>>
+    : is_trivially_relocatable<Alloc> {};
+
+// 使用 pmr::polymorphic_allocator 的 basic_string，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <typename CharType, typename CharTraits = mystl::char_traits<CharType>>
+using basic_string = mystl::basic_string<CharType, CharTraits, polymorphic_allocator<CharType>>;
+} // namespace pmr
+
 }
 
 #endif
\ No newline at end of file
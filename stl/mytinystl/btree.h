@@ -0,0 +1,1473 @@
+#ifndef MYTINYSTL_BTREE_H_
+#define MYTINYSTL_BTREE_H_
+
+// 这个头文件包含一个模板类 btree
+// btree : B 树，每个节点连续存放多个元素，节点大小按缓存行的整数倍确定
+//
+// rb_tree 每个元素一个节点，查找时每比较一次就要访问一个新的节点；btree 的节点内可以放下几十个元素，
+// 查找只需访问约 log_N(n) 个节点，节点内二分查找，顺序遍历时相邻的元素大多位于同一块内存
+//
+// 叶节点只存放元素，内部节点在元素之后另存 N + 1 个孩子指针，空树不分配任何节点
+// 节点已满时从中间分裂，中间的元素上移到父节点；在节点的最前或最后插入时偏向一侧分裂，
+// 顺序插入得到的节点几乎都是满的
+// 删除内部节点上的元素时用它的前驱代替，再从叶节点删除；节点的元素不足一半时与兄弟节点合并或从兄弟节点借入
+//
+// 与 rb_tree 不同，插入与删除时元素会在节点之间搬移，之后所有的迭代器、指针和引用都会失效，
+// erase 返回的迭代器除外
+
+#include <initializer_list>
+
+#include "iterator.h"
+#include "type_traits.h"
+#include "memory.h"
+#include "functional.h"
+#include "exceptdef.h"
+#include "rb_tree.h"
+
+namespace mystl
+{
+
+// 节点占用的空间，按 64 字节的缓存行计为 4 行
+static constexpr size_t btree_node_bytes = 256;
+
+// 节点最多容纳的元素个数，除去节点头部后按元素大小计算，元素很大时至少为 3
+template <typename T>
+struct btree_node_capacity
+{
+    static constexpr size_t header = 2 * sizeof(void*);
+    static constexpr size_t fit    = (btree_node_bytes - header) / sizeof(T);
+    static constexpr size_t value  = fit < 3 ? 3 : (fit > 255 ? 255 : fit);
+};
+
+// btree 的节点，叶节点与内部节点共用这个头部
+template <typename T>
+struct btree_node
+{
+    typedef btree_node<T>* node_ptr;
+
+    static constexpr size_t capacity = btree_node_capacity<T>::value;
+
+    node_ptr      parent;    // 父节点，根节点为 nullptr
+    unsigned char position;  // 是父节点的第几个孩子
+    unsigned char count;     // 元素个数
+    bool          leaf;      // 是否为叶节点
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[capacity];
+
+    T*        value_ptr(size_t i) { return reinterpret_cast<T*>(slots + i); }
+    T&        value(size_t i)     { return *value_ptr(i); }
+    node_ptr& child(size_t i);    // 只对内部节点有效
+};
+
+// 内部节点在元素之后存放孩子指针，第 i 个孩子上的元素都位于第 i - 1 与第 i 个元素之间
+template <typename T>
+struct btree_internal_node : public btree_node<T>
+{
+    btree_node<T>* children[btree_node<T>::capacity + 1];
+};
+
+template <typename T>
+inline btree_node<T>*& btree_node<T>::child(size_t i)
+{
+    return static_cast<btree_internal_node<T>*>(this)->children[i];
+}
+
+template <typename T> struct btree_iterator;
+template <typename T> struct btree_const_iterator;
+
+// btree 的迭代器由节点与节点内的位置组成，end() 指向最右边的叶节点的末尾
+template <typename T>
+struct btree_iterator_base : public mystl::iterator<mystl::bidirectional_iterator_tag, T>
+{
+    typedef btree_node<T>* node_ptr;
+
+    node_ptr node;      // 所在的节点
+    size_t   position;  // 在节点中的位置
+
+    btree_iterator_base() : node(nullptr), position(0) {}
+    btree_iterator_base(node_ptr x, size_t i) : node(x), position(i) {}
+
+    // 使迭代器前进
+    void inc()
+    {
+        if(!node->leaf)
+        {   // 内部节点的下一个元素是右侧子树的最小元素
+            node = node->child(position + 1);
+            while(!node->leaf)
+                node = node->child(0);
+            position = 0;
+            return;
+        }
+        if(++position < node->count)
+            return;
+        // 已经走到叶节点的末尾，向上找到第一个还有后续元素的祖先
+        auto save = *this;
+        while(position == node->count && node->parent != nullptr)
+        {
+            position = node->position;
+            node = node->parent;
+        }
+        if(position == node->count)
+            *this = save;  // 没有下一个元素，停在 end()
+    }
+
+    // 使迭代器后退
+    void dec()
+    {
+        if(!node->leaf)
+        {   // 内部节点的上一个元素是左侧子树的最大元素
+            node = node->child(position);
+            while(!node->leaf)
+                node = node->child(node->count);
+            position = node->count - 1;
+            return;
+        }
+        while(position == 0 && node->parent != nullptr)
+        {
+            position = node->position;
+            node = node->parent;
+        }
+        --position;
+    }
+
+    bool operator==(const btree_iterator_base& rhs) const
+    { return node == rhs.node && position == rhs.position; }
+    bool operator!=(const btree_iterator_base& rhs) const
+    { return !(*this == rhs); }
+};
+
+template <typename T>
+struct btree_iterator : public btree_iterator_base<T>
+{
+    typedef T                         value_type;
+    typedef T*                        pointer;
+    typedef T&                        reference;
+    typedef btree_node<T>*            node_ptr;
+
+    typedef btree_iterator<T>         iterator;
+    typedef btree_const_iterator<T>   const_iterator;
+    typedef iterator                  self;
+
+    using btree_iterator_base<T>::node;
+    using btree_iterator_base<T>::position;
+
+    // 构造函数
+    btree_iterator() {}
+    btree_iterator(node_ptr x, size_t i) : btree_iterator_base<T>(x, i) {}
+    btree_iterator(const const_iterator& rhs) : btree_iterator_base<T>(rhs.node, rhs.position) {}
+
+    // 重载操作符
+    reference operator*()  const { return node->value(position); }
+    pointer   operator->() const { return &(operator*()); }
+
+    self& operator++()
+    {
+        this->inc();
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp(*this);
+        this->inc();
+        return tmp;
+    }
+    self& operator--()
+    {
+        this->dec();
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp(*this);
+        this->dec();
+        return tmp;
+    }
+};
+
+template <typename T>
+struct btree_const_iterator : public btree_iterator_base<T>
+{
+    typedef T                         value_type;
+    typedef const T*                  pointer;
+    typedef const T&                  reference;
+    typedef btree_node<T>*            node_ptr;
+
+    typedef btree_iterator<T>         iterator;
+    typedef btree_const_iterator<T>   const_iterator;
+    typedef const_iterator            self;
+
+    using btree_iterator_base<T>::node;
+    using btree_iterator_base<T>::position;
+
+    // 构造函数
+    btree_const_iterator() {}
+    btree_const_iterator(node_ptr x, size_t i) : btree_iterator_base<T>(x, i) {}
+    btree_const_iterator(const iterator& rhs) : btree_iterator_base<T>(rhs.node, rhs.position) {}
+
+    // 重载操作符
+    reference operator*()  const { return node->value(position); }
+    pointer   operator->() const { return &(operator*()); }
+
+    self& operator++()
+    {
+        this->inc();
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp(*this);
+        this->inc();
+        return tmp;
+    }
+    self& operator--()
+    {
+        this->dec();
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp(*this);
+        this->dec();
+        return tmp;
+    }
+};
+
+// 模板类 btree
+// 参数一代表数据类型，参数二代表键值比较类型，参数三代表空间配置器
+// btree 保存的是叶节点的分配器，内部节点与元素分别通过重新绑定得到的分配器构造
+template <typename T, typename Compare, typename Alloc = mystl::allocator<T>>
+class btree : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<btree_node<T>>>
+{
+public:
+    // btree 的嵌套型别定义
+    typedef rb_tree_value_traits<T>                  value_traits;
+
+    typedef btree_node<T>                            node_type;
+    typedef node_type*                               node_ptr;
+    typedef btree_internal_node<T>                   internal_type;
+    typedef typename value_traits::key_type          key_type;
+    typedef typename value_traits::mapped_type       mapped_type;
+    typedef typename value_traits::value_type       value_type;
+    typedef Compare                                  key_compare;
+
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>             data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<node_type>     node_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<internal_type> internal_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef mystl::allocator_traits<node_allocator>     node_alloc_traits;
+    typedef mystl::allocator_traits<internal_allocator> internal_alloc_traits;
+    typedef data_allocator                              allocator_type;
+
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
+
+    typedef btree_iterator<T>                        iterator;
+    typedef btree_const_iterator<T>                  const_iterator;
+    typedef mystl::reverse_iterator<iterator>        reverse_iterator;
+    typedef mystl::reverse_iterator<const_iterator>  const_reverse_iterator;
+
+    // 每个节点最多容纳的元素个数
+    static constexpr size_type node_capacity = node_type::capacity;
+
+    allocator_type get_allocator() const { return allocator_type(this->get_alloc()); }
+    key_compare    key_comp()      const { return key_comp_; }
+
+private:
+    typedef mystl::alloc_holder<node_allocator>      alloc_base;
+
+    // 节点的元素少于这个数目时需要与兄弟节点合并或从兄弟节点借入
+    static constexpr size_type min_count = node_capacity / 2;
+
+    // 插入时先把元素构造在这里，确定位置之后再搬进节点
+    struct value_buffer
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        value_type* get() { return reinterpret_cast<value_type*>(&storage); }
+    };
+
+    // 用以下数据表现 btree
+    node_ptr    root_;       // 根节点，空树为 nullptr
+    node_ptr    leftmost_;   // 最左边的叶节点
+    node_ptr    rightmost_;  // 最右边的叶节点
+    size_type   size_;       // 元素个数
+    key_compare key_comp_;   // 节点键值比较的准则
+
+public:
+    // 构造、复制、析构函数
+    btree() : root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), size_(0) {}
+
+    explicit btree(const allocator_type& alloc)
+        :alloc_base(node_allocator(alloc)),
+        root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), size_(0)
+    {}
+
+    btree(const btree& rhs);
+    btree(const btree& rhs, const allocator_type& alloc);
+    btree(btree&& rhs) noexcept;
+
+    btree& operator=(const btree& rhs);
+    btree& operator=(btree&& rhs);
+
+    ~btree()
+    {
+        if(root_ != nullptr && !node_alloc_traits::template can_skip_destroy<T>(this->get_alloc()))
+            clear();
+    }
+
+public:
+    // 迭代器相关操作
+    iterator begin() noexcept
+    { return iterator(leftmost_, 0); }
+    const_iterator begin() const noexcept
+    { return const_iterator(leftmost_, 0); }
+    iterator end() noexcept
+    { return iterator(rightmost_, rightmost_ == nullptr ? 0 : rightmost_->count); }
+    const_iterator end() const noexcept
+    { return const_iterator(rightmost_, rightmost_ == nullptr ? 0 : rightmost_->count); }
+
+    reverse_iterator rbegin() noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept
+    { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept
+    { return reverse_iterator(begin()); }
+
+    const_iterator cbegin() const noexcept
+    { return begin(); }
+    const_iterator cend() const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend() const noexcept
+    { return rend(); }
+
+    // 容量相关操作
+    bool empty()         const noexcept { return size_ == 0; }
+    size_type size()     const noexcept { return size_; }
+    size_type max_size() const noexcept { return static_cast<size_type>(-1); }
+
+    // 插入删除相关操作
+    // emplace
+    // hint 只在等于 end() 且新元素不小于最大的元素时起作用，此时直接追加到最右边的叶节点，其余情况与不带 hint 相同
+    template <typename... Args>
+    iterator emplace_multi(Args&&... args)
+    {
+        return emplace_multi_use_hint(iterator(), mystl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    mystl::pair<iterator, bool> emplace_unique(Args&&... args)
+    {
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "btree<T, Comp>'s size too big");
+        return emplace_unique_dispatch(can_extract_key<key_type, value_type, Args...>(),
+                                       iterator(), mystl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_multi_use_hint(iterator hint, Args&&... args);
+
+    template <typename... Args>
+    iterator emplace_unique_use_hint(iterator hint, Args&&... args)
+    {
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "btree<T, Comp>'s size too big");
+        return emplace_unique_dispatch(can_extract_key<key_type, value_type, Args...>(),
+                                       hint, mystl::forward<Args>(args)...).first;
+    }
+
+    // try_emplace，键值已经存在时什么都不做，args 不会被移动
+    template <typename K, typename... Args>
+    mystl::pair<iterator, bool> try_emplace_unique(K&& key, Args&&... args)
+    {
+        return try_emplace_unique_use_hint_pair(iterator(), mystl::forward<K>(key), mystl::forward<Args>(args)...);
+    }
+
+    template <typename K, typename... Args>
+    iterator try_emplace_unique_use_hint(iterator hint, K&& key, Args&&... args)
+    {
+        return try_emplace_unique_use_hint_pair(hint, mystl::forward<K>(key), mystl::forward<Args>(args)...).first;
+    }
+
+    // insert
+    iterator insert_multi(const value_type& value)
+    {
+        return emplace_multi(value);
+    }
+    iterator insert_multi(value_type&& value)
+    {
+        return emplace_multi(mystl::move(value));
+    }
+
+    iterator insert_multi(iterator hint, const value_type& value)
+    {
+        return emplace_multi_use_hint(hint, value);
+    }
+    iterator insert_multi(iterator hint, value_type&& value)
+    {
+        return emplace_multi_use_hint(hint, mystl::move(value));
+    }
+
+    // 已序的区间每次都追加到最右边的叶节点，不必从根节点查找
+    template <typename InputIterator>
+    void insert_multi(InputIterator first, InputIterator last)
+    {
+        for(; first != last; ++first)
+            emplace_multi_use_hint(end(), *first);
+    }
+
+    mystl::pair<iterator, bool> insert_unique(const value_type& value)
+    {
+        return emplace_unique(value);
+    }
+    mystl::pair<iterator, bool> insert_unique(value_type&& value)
+    {
+        return emplace_unique(mystl::move(value));
+    }
+
+    iterator insert_unique(iterator hint, const value_type& value)
+    {
+        return emplace_unique_use_hint(hint, value);
+    }
+    iterator insert_unique(iterator hint, value_type&& value)
+    {
+        return emplace_unique_use_hint(hint, mystl::move(value));
+    }
+
+    template <typename InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        for(; first != last; ++first)
+            emplace_unique_use_hint(end(), *first);
+    }
+
+    // erase
+    // 返回被删除元素的下一个元素，其它迭代器都会失效
+    iterator erase(iterator pos);
+
+    size_type erase_multi(const key_type& key);
+    size_type erase_unique(const key_type& key);
+
+    iterator erase(iterator first, iterator last);
+
+    void clear();
+
+    // btree 相关操作
+    // 比较函数声明了 is_transparent 时，另有接受任意型别 K 的模板版本，不必先构造 key_type
+    iterator       find(const key_type& key)       { return M_find(key); }
+    const_iterator find(const key_type& key) const { return M_find(key); }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return M_find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key) const        { return M_find(key); }
+
+    size_type count_multi(const key_type& key) const
+    {
+        auto p = equal_range_multi(key);
+        return static_cast<size_type>(mystl::distance(p.first, p.second));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type count_multi(const K& key) const
+    {
+        auto p = equal_range_multi(key);
+        return static_cast<size_type>(mystl::distance(p.first, p.second));
+    }
+
+    size_type count_unique(const key_type& key) const
+    {
+        return M_find(key) != end() ? 1 : 0;
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type count_unique(const K& key) const
+    {
+        return M_find(key) != end() ? 1 : 0;
+    }
+
+    iterator       lower_bound(const key_type& key)       { return M_lower_bound(key); }
+    const_iterator lower_bound(const key_type& key) const { return M_lower_bound(key); }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)              { return M_lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const        { return M_lower_bound(key); }
+
+    iterator       upper_bound(const key_type& key)       { return M_upper_bound(key); }
+    const_iterator upper_bound(const key_type& key) const { return M_upper_bound(key); }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)              { return M_upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const        { return M_upper_bound(key); }
+
+    mystl::pair<iterator, iterator> equal_range_multi(const key_type& key)
+    {
+        return mystl::pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    mystl::pair<const_iterator, const_iterator>
+    equal_range_multi(const key_type& key) const
+    {
+        return mystl::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<iterator, iterator> equal_range_multi(const K& key)
+    {
+        return mystl::pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<const_iterator, const_iterator>
+    equal_range_multi(const K& key) const
+    {
+        return mystl::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    mystl::pair<iterator, iterator> equal_range_unique(const key_type& key)
+    {
+        iterator it = find(key);
+        auto next = it;
+        return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+    }
+
+    mystl::pair<const_iterator, const_iterator>
+    equal_range_unique(const key_type& key) const
+    {
+        const_iterator it = find(key);
+        auto next = it;
+        return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+    }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<iterator, iterator> equal_range_unique(const K& key)
+    {
+        iterator it = find(key);
+        auto next = it;
+        return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+    }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<const_iterator, const_iterator>
+    equal_range_unique(const K& key) const
+    {
+        const_iterator it = find(key);
+        auto next = it;
+        return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+    }
+
+    void swap(btree& rhs) noexcept;
+
+private:
+    // node related
+    node_ptr create_node(bool leaf);
+    void     deallocate_node(node_ptr x);
+
+    void reset() noexcept
+    {
+        root_ = leftmost_ = rightmost_ = nullptr;
+        size_ = 0;
+    }
+
+    // 只交换数据，不交换分配器
+    void swap_data(btree& rhs) noexcept
+    {
+        mystl::swap(root_, rhs.root_);
+        mystl::swap(leftmost_, rhs.leftmost_);
+        mystl::swap(rightmost_, rhs.rightmost_);
+        mystl::swap(size_, rhs.size_);
+        mystl::swap(key_comp_, rhs.key_comp_);
+    }
+
+    // 节点内二分查找第一个不小于 / 大于 key 的位置
+    template <class K>
+    size_type lower_index(node_ptr x, const K& key) const;
+    template <class K>
+    size_type upper_index(node_ptr x, const K& key) const;
+
+    // find / lower_bound / upper_bound 的实现，K 可以是 key_type 或异构查找的键值型别
+    template <class K>
+    iterator M_find(const K& key) const;
+    template <class K>
+    iterator M_lower_bound(const K& key) const;
+    template <class K>
+    iterator M_upper_bound(const K& key) const;
+
+    // get insert pos，返回叶节点上的插入位置
+    // unique 版本在键值已经存在时返回该元素，second 为 false
+    iterator get_insert_multi_pos(iterator hint, const key_type& key);
+    mystl::pair<iterator, bool> get_insert_unique_pos(iterator hint, const key_type& key);
+
+    // 把已经构造好的 *v 搬进叶节点 x 的位置 i，x 为 nullptr 表示空树
+    // 节点已满时先分裂，分配节点失败时树与 *v 都保持不变
+    iterator insert_at(node_ptr x, size_type i, value_type* v);
+
+    // 在叶节点 x 的位置 i 构造元素
+    template <typename... Args>
+    iterator emplace_at(node_ptr x, size_type i, Args&&... args);
+
+    // emplace_unique 的实现：能从参数中直接取得键值时先查找，键值不存在才构造元素，
+    // 否则先构造元素，键值重复时再销毁它
+    template <typename... Args>
+    mystl::pair<iterator, bool> emplace_unique_dispatch(m_true_type, iterator hint, Args&&... args);
+    template <typename... Args>
+    mystl::pair<iterator, bool> emplace_unique_dispatch(m_false_type, iterator hint, Args&&... args);
+
+    template <typename K, typename... Args>
+    mystl::pair<iterator, bool> try_emplace_unique_use_hint_pair(iterator hint, K&& key, Args&&... args);
+
+    template <typename A>
+    static const key_type& extract_key(const A& arg)
+    { return value_traits::get_key(arg); }
+    template <typename A, typename B>
+    static const key_type& extract_key(const A& key, const B&)
+    { return key; }
+
+    // 分裂已满的节点 x，使位置 i 可以插入一个元素，x 与 i 更新为分裂后的插入位置
+    void split(node_ptr& x, size_type& i);
+
+    // 删除之后调整元素不足的节点，next 是要返回的迭代器，随元素的搬移一起更新
+    void rebalance(node_ptr x, iterator& next);
+    void merge_nodes(node_ptr l, node_ptr r, iterator& next);
+    void borrow_from_left(node_ptr x, iterator& next);
+    void borrow_from_right(node_ptr x, iterator& next);
+
+    // copy tree / erase tree
+    node_ptr copy_from(node_ptr x, node_ptr p);
+    void     copy_root(const btree& rhs);
+    void     erase_since(node_ptr x);
+};
+
+/*****************************************************************************************/
+
+// 复制构造函数
+template <typename T, typename Compare, typename Alloc>
+btree<T, Compare, Alloc>::btree(const btree& rhs)
+    :alloc_base(node_alloc_traits::select_on_container_copy_construction(rhs.get_alloc())),
+    root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), size_(0)
+{
+    copy_root(rhs);
+}
+
+template <typename T, typename Compare, typename Alloc>
+btree<T, Compare, Alloc>::btree(const btree& rhs, const allocator_type& alloc)
+    :alloc_base(node_allocator(alloc)),
+    root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), size_(0)
+{
+    copy_root(rhs);
+}
+
+// 移动构造函数
+template <typename T, typename Compare, typename Alloc>
+btree<T, Compare, Alloc>::btree(btree&& rhs) noexcept
+    : alloc_base(mystl::move(rhs.get_alloc())),
+    root_(rhs.root_),
+    leftmost_(rhs.leftmost_),
+    rightmost_(rhs.rightmost_),
+    size_(rhs.size_),
+    key_comp_(rhs.key_comp_)
+{
+    rhs.reset();
+}
+
+// 复制赋值操作符
+template <typename T, typename Compare, typename Alloc>
+btree<T, Compare, Alloc>& btree<T, Compare, Alloc>::operator=(const btree& rhs)
+{
+    if(this != &rhs)
+    {
+        // 需要传播分配器且两者不相等时，原有节点必须由原分配器释放
+        if(node_alloc_traits::propagate_on_container_copy_assignment::value &&
+           this->get_alloc() != rhs.get_alloc())
+        {
+            btree tmp(rhs, allocator_type(rhs.get_alloc()));
+            swap_data(tmp);
+            mystl::swap(this->get_alloc(), tmp.get_alloc());
+            return *this;
+        }
+        clear();
+        copy_root(rhs);
+    }
+    return *this;
+}
+
+// 移动赋值操作符
+template <typename T, typename Compare, typename Alloc>
+btree<T, Compare, Alloc>& btree<T, Compare, Alloc>::operator=(btree&& rhs)
+{
+    if(this == &rhs)return *this;
+    clear();
+    if(node_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
+    {
+        swap_data(rhs);
+        if(node_alloc_traits::propagate_on_container_move_assignment::value)
+            mystl::swap(this->get_alloc(), rhs.get_alloc());
+    }
+    else
+    {
+        // 分配器不相等且不传播时，只能逐个移动元素
+        key_comp_ = rhs.key_comp_;
+        for(auto it = rhs.begin(); it != rhs.end(); ++it)
+            emplace_multi_use_hint(end(), mystl::move(*it));
+        rhs.clear();
+    }
+    return *this;
+}
+
+// 就地插入元素，键值允许重复，先构造元素再确定插入位置
+template <typename T, typename Compare, typename Alloc>
+template <typename... Args>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::emplace_multi_use_hint(iterator hint, Args&&... args)
+{
+    THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "btree<T, Comp>'s size too big");
+    value_buffer buf;
+    node_alloc_traits::construct(this->get_alloc(), buf.get(), mystl::forward<Args>(args)...);
+    try
+    {
+        auto pos = get_insert_multi_pos(hint, value_traits::get_key(*buf.get()));
+        return insert_at(pos.node, pos.position, buf.get());
+    }
+    catch(...)
+    {
+        node_alloc_traits::destroy(this->get_alloc(), buf.get());
+        throw;
+    }
+}
+
+template <typename T, typename Compare, typename Alloc>
+template <typename... Args>
+mystl::pair<typename btree<T, Compare, Alloc>::iterator, bool>
+btree<T, Compare, Alloc>::emplace_unique_dispatch(m_true_type, iterator hint, Args&&... args)
+{
+    auto res = get_insert_unique_pos(hint, extract_key(args...));
+    if(!res.second)
+        return res;
+    return mystl::make_pair(emplace_at(res.first.node, res.first.position,
+                                       mystl::forward<Args>(args)...), true);
+}
+
+template <typename T, typename Compare, typename Alloc>
+template <typename... Args>
+mystl::pair<typename btree<T, Compare, Alloc>::iterator, bool>
+btree<T, Compare, Alloc>::emplace_unique_dispatch(m_false_type, iterator hint, Args&&... args)
+{
+    value_buffer buf;
+    node_alloc_traits::construct(this->get_alloc(), buf.get(), mystl::forward<Args>(args)...);
+    try
+    {
+        auto res = get_insert_unique_pos(hint, value_traits::get_key(*buf.get()));
+        if(!res.second)
+        {
+            node_alloc_traits::destroy(this->get_alloc(), buf.get());
+            return res;
+        }
+        return mystl::make_pair(insert_at(res.first.node, res.first.position, buf.get()), true);
+    }
+    catch(...)
+    {
+        node_alloc_traits::destroy(this->get_alloc(), buf.get());
+        throw;
+    }
+}
+
+template <typename T, typename Compare, typename Alloc>
+template <typename K, typename... Args>
+mystl::pair<typename btree<T, Compare, Alloc>::iterator, bool>
+btree<T, Compare, Alloc>::try_emplace_unique_use_hint_pair(iterator hint, K&& key, Args&&... args)
+{
+    auto res = get_insert_unique_pos(hint, key);
+    if(!res.second)
+        return res;
+    THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "btree<T, Comp>'s size too big");
+    return mystl::make_pair(emplace_at(res.first.node, res.first.position, mystl::forward<K>(key),
+                                       mapped_type(mystl::forward<Args>(args)...)), true);
+}
+
+// 删除 pos 位置的元素，返回下一个元素
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::erase(iterator pos)
+{
+    MYSTL_DEBUG(pos != end());
+    node_ptr x = pos.node;
+    const size_type i = pos.position;
+    iterator next;
+    node_alloc_traits::destroy(this->get_alloc(), x->value_ptr(i));
+    if(x->leaf)
+    {
+        mystl::uninitialized_relocate(x->value_ptr(i + 1), x->value_ptr(x->count), x->value_ptr(i));
+        --x->count;
+        // 下一个元素在同一个叶节点中，或者在第一个还有后续元素的祖先中
+        node_ptr y = x;
+        size_type j = i;
+        while(j == y->count && y->parent != nullptr)
+        {
+            j = y->position;
+            y = y->parent;
+        }
+        if(j < y->count)
+            next = iterator(y, j);
+    }
+    else
+    {
+        // 用前驱（左侧子树的最大元素）代替被删除的元素，再从前驱所在的叶节点删除
+        node_ptr l = x->child(i);
+        while(!l->leaf)
+            l = l->child(l->count);
+        mystl::uninitialized_relocate(l->value_ptr(l->count - 1), l->value_ptr(l->count), x->value_ptr(i));
+        --l->count;
+        // 下一个元素是右侧子树的最小元素，不受前驱所在叶节点的影响
+        next = iterator(x, i);
+        ++next;
+        x = l;
+    }
+    --size_;
+    rebalance(x, next);
+    return next.node == nullptr ? end() : next;
+}
+
+// 删除键值等于 key 的元素，返回删除的个数
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::size_type
+btree<T, Compare, Alloc>::erase_multi(const key_type& key)
+{
+    const size_type n = count_multi(key);
+    auto it = lower_bound(key);
+    for(size_type k = 0; k < n; ++k)
+        it = erase(it);
+    return n;
+}
+
+// 删除键值等于 key 的元素，返回删除的个数
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::size_type
+btree<T, Compare, Alloc>::erase_unique(const key_type& key)
+{
+    auto it = find(key);
+    if(it != end())
+    {
+        erase(it);
+        return 1;
+    }
+    return 0;
+}
+
+// 删除[first, last)区间内的元素，每次删除之后 last 都会失效，因此按个数删除
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::erase(iterator first, iterator last)
+{
+    if(first == begin() && last == end())
+    {
+        clear();
+        return end();
+    }
+    for(auto n = mystl::distance(first, last); n > 0; --n)
+        first = erase(first);
+    return first;
+}
+
+// 清空 btree
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::clear()
+{
+    if(root_ != nullptr)
+    {
+        erase_since(root_);
+        reset();
+    }
+}
+
+// 交换 btree
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::swap(btree& rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
+    }
+}
+
+/*****************************************************************************************/
+// helper function
+
+// 创建一个空节点
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::node_ptr
+btree<T, Compare, Alloc>::create_node(bool leaf)
+{
+    node_ptr x;
+    if(leaf)
+    {
+        x = node_alloc_traits::allocate(this->get_alloc(), 1);
+    }
+    else
+    {
+        internal_allocator alloc(this->get_alloc());
+        x = internal_alloc_traits::allocate(alloc, 1);
+    }
+    x->parent = nullptr;
+    x->position = 0;
+    x->count = 0;
+    x->leaf = leaf;
+    return x;
+}
+
+// 释放一个节点，其中的元素已经销毁或搬走
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::deallocate_node(node_ptr x)
+{
+    if(x->leaf)
+    {
+        node_alloc_traits::deallocate(this->get_alloc(), x, 1);
+    }
+    else
+    {
+        internal_allocator alloc(this->get_alloc());
+        internal_alloc_traits::deallocate(alloc, static_cast<internal_type*>(x), 1);
+    }
+}
+
+template <typename T, typename Compare, typename Alloc>
+template <class K>
+typename btree<T, Compare, Alloc>::size_type
+btree<T, Compare, Alloc>::lower_index(node_ptr x, const K& key) const
+{
+    size_type first = 0, last = x->count;
+    while(first < last)
+    {
+        const size_type mid = (first + last) >> 1;
+        if(key_comp_(value_traits::get_key(x->value(mid)), key))
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return first;
+}
+
+template <typename T, typename Compare, typename Alloc>
+template <class K>
+typename btree<T, Compare, Alloc>::size_type
+btree<T, Compare, Alloc>::upper_index(node_ptr x, const K& key) const
+{
+    size_type first = 0, last = x->count;
+    while(first < last)
+    {
+        const size_type mid = (first + last) >> 1;
+        if(key_comp_(key, value_traits::get_key(x->value(mid))))
+            last = mid;
+        else
+            first = mid + 1;
+    }
+    return first;
+}
+
+// 查找键值为 key 的元素，键值允许重复时返回第一个
+template <typename T, typename Compare, typename Alloc>
+template <class K>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::M_find(const K& key) const
+{
+    auto it = M_lower_bound(key);
+    if(it.node == nullptr || it.position == it.node->count ||
+       key_comp_(key, value_traits::get_key(*it)))
+        return iterator(rightmost_, rightmost_ == nullptr ? 0 : rightmost_->count);
+    return it;
+}
+
+// 键值不小于 key 的第一个位置，沿途记下最后一个满足条件的元素
+template <typename T, typename Compare, typename Alloc>
+template <class K>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::M_lower_bound(const K& key) const
+{
+    iterator res(rightmost_, rightmost_ == nullptr ? 0 : rightmost_->count);
+    node_ptr x = root_;
+    while(x != nullptr)
+    {
+        const size_type i = lower_index(x, key);
+        if(i < x->count)
+            res = iterator(x, i);
+        if(x->leaf)
+            break;
+        x = x->child(i);
+    }
+    return res;
+}
+
+// 键值大于 key 的第一个位置
+template <typename T, typename Compare, typename Alloc>
+template <class K>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::M_upper_bound(const K& key) const
+{
+    iterator res(rightmost_, rightmost_ == nullptr ? 0 : rightmost_->count);
+    node_ptr x = root_;
+    while(x != nullptr)
+    {
+        const size_type i = upper_index(x, key);
+        if(i < x->count)
+            res = iterator(x, i);
+        if(x->leaf)
+            break;
+        x = x->child(i);
+    }
+    return res;
+}
+
+// 键值允许重复时的插入位置，在相等的元素之后
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::get_insert_multi_pos(iterator hint, const key_type& key)
+{
+    if(root_ == nullptr)
+        return iterator();
+    if(hint == end() && !key_comp_(key, value_traits::get_key(rightmost_->value(rightmost_->count - 1))))
+        return hint;
+    node_ptr x = root_;
+    while(true)
+    {
+        const size_type i = upper_index(x, key);
+        if(x->leaf)
+            return iterator(x, i);
+        x = x->child(i);
+    }
+}
+
+// 键值不允许重复时的插入位置，键值已经存在时返回该元素
+template <typename T, typename Compare, typename Alloc>
+mystl::pair<typename btree<T, Compare, Alloc>::iterator, bool>
+btree<T, Compare, Alloc>::get_insert_unique_pos(iterator hint, const key_type& key)
+{
+    if(root_ == nullptr)
+        return mystl::make_pair(iterator(), true);
+    if(hint == end() && key_comp_(value_traits::get_key(rightmost_->value(rightmost_->count - 1)), key))
+        return mystl::make_pair(hint, true);
+    node_ptr x = root_;
+    while(true)
+    {
+        const size_type i = lower_index(x, key);
+        if(i < x->count && !key_comp_(key, value_traits::get_key(x->value(i))))
+            return mystl::make_pair(iterator(x, i), false);
+        if(x->leaf)
+            return mystl::make_pair(iterator(x, i), true);
+        x = x->child(i);
+    }
+}
+
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::insert_at(node_ptr x, size_type i, value_type* v)
+{
+    if(x == nullptr)
+    {
+        x = root_ = leftmost_ = rightmost_ = create_node(true);
+        i = 0;
+    }
+    else if(x->count == node_capacity)
+    {
+        split(x, i);
+    }
+    mystl::uninitialized_relocate_backward(x->value_ptr(i), x->value_ptr(x->count), x->value_ptr(x->count + 1));
+    mystl::uninitialized_relocate(v, v + 1, x->value_ptr(i));
+    ++x->count;
+    ++size_;
+    return iterator(x, i);
+}
+
+// 先把元素构造在节点之外，参数引用了树中的元素时也不会受分裂与搬移的影响
+template <typename T, typename Compare, typename Alloc>
+template <typename... Args>
+typename btree<T, Compare, Alloc>::iterator
+btree<T, Compare, Alloc>::emplace_at(node_ptr x, size_type i, Args&&... args)
+{
+    value_buffer buf;
+    node_alloc_traits::construct(this->get_alloc(), buf.get(), mystl::forward<Args>(args)...);
+    try
+    {
+        return insert_at(x, i, buf.get());
+    }
+    catch(...)
+    {
+        node_alloc_traits::destroy(this->get_alloc(), buf.get());
+        throw;
+    }
+}
+
+// 分裂已满的节点 x：左边留下 mid 个元素，第 mid 个元素上移到父节点，其余的元素移到新的右兄弟节点
+// 父节点也满时先分裂父节点，根节点分裂时树长高一层
+// 在节点末尾插入时左边留下 N - 1 个元素，在节点开头插入时左边不留元素，顺序插入时节点几乎都是满的
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::split(node_ptr& x, size_type& i)
+{
+    // 先分配所有需要的节点，失败时树保持不变
+    node_ptr s = create_node(x->leaf);
+    try
+    {
+        if(x->parent == nullptr)
+        {
+            node_ptr r = create_node(false);
+            r->child(0) = x;
+            x->parent = r;
+            x->position = 0;
+            root_ = r;
+        }
+        else if(x->parent->count == node_capacity)
+        {
+            node_ptr p = x->parent;
+            size_type pi = x->position;
+            split(p, pi);
+        }
+    }
+    catch(...)
+    {
+        deallocate_node(s);
+        throw;
+    }
+
+    const size_type mid = i == node_capacity ? node_capacity - 1 : (i == 0 ? 0 : node_capacity / 2);
+    const size_type rc = node_capacity - mid - 1;
+    node_ptr p = x->parent;
+    const size_type k = x->position;
+
+    // 父节点在 k 处腾出位置，放入上移的元素，右兄弟节点成为第 k + 1 个孩子
+    mystl::uninitialized_relocate_backward(p->value_ptr(k), p->value_ptr(p->count), p->value_ptr(p->count + 1));
+    for(size_type j = p->count; j > k; --j)
+    {
+        p->child(j + 1) = p->child(j);
+        p->child(j + 1)->position = static_cast<unsigned char>(j + 1);
+    }
+    mystl::uninitialized_relocate(x->value_ptr(mid), x->value_ptr(mid + 1), p->value_ptr(k));
+    p->child(k + 1) = s;
+    s->parent = p;
+    s->position = static_cast<unsigned char>(k + 1);
+    ++p->count;
+
+    // 其余的元素与孩子移到右兄弟节点
+    mystl::uninitialized_relocate(x->value_ptr(mid + 1), x->value_ptr(node_capacity), s->value_ptr(0));
+    if(!x->leaf)
+    {
+        for(size_type j = 0; j <= rc; ++j)
+        {
+            node_ptr c = x->child(mid + 1 + j);
+            s->child(j) = c;
+            c->parent = s;
+            c->position = static_cast<unsigned char>(j);
+        }
+    }
+    x->count = static_cast<unsigned char>(mid);
+    s->count = static_cast<unsigned char>(rc);
+    if(rightmost_ == x)
+        rightmost_ = s;
+
+    if(i > mid)
+    {
+        x = s;
+        i -= mid + 1;
+    }
+}
+
+// 从节点 x 开始向上调整，直到不再有元素不足的节点
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::rebalance(node_ptr x, iterator& next)
+{
+    while(x != root_ && x->count < min_count)
+    {
+        node_ptr p = x->parent;
+        const size_type i = x->position;
+        // 能放进一个节点时与兄弟节点合并，父节点少一个元素，继续向上调整
+        if(i > 0 && static_cast<size_type>(p->child(i - 1)->count) + x->count + 1 <= node_capacity)
+        {
+            merge_nodes(p->child(i - 1), x, next);
+            x = p;
+            continue;
+        }
+        if(i < p->count && static_cast<size_type>(x->count) + p->child(i + 1)->count + 1 <= node_capacity)
+        {
+            merge_nodes(x, p->child(i + 1), next);
+            x = p;
+            continue;
+        }
+        // 否则从元素较多的兄弟节点借入，父节点的元素个数不变
+        if(i > 0 && (i == p->count || p->child(i - 1)->count >= p->child(i + 1)->count))
+            borrow_from_left(x, next);
+        else
+            borrow_from_right(x, next);
+        break;
+    }
+    if(root_->count == 0)
+    {
+        node_ptr old = root_;
+        if(old->leaf)
+        {
+            reset();
+        }
+        else
+        {   // 根节点的元素都合并下去了，唯一的孩子成为新的根节点，树降低一层
+            root_ = old->child(0);
+            root_->parent = nullptr;
+            root_->position = 0;
+        }
+        deallocate_node(old);
+    }
+}
+
+// 合并相邻的兄弟节点 l 与 r：父节点中的分隔元素下移到 l 的末尾，r 的元素与孩子接在后面，再释放 r
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::merge_nodes(node_ptr l, node_ptr r, iterator& next)
+{
+    node_ptr p = l->parent;
+    const size_type k = l->position;
+    const size_type lc = l->count;
+    const size_type rc = r->count;
+
+    mystl::uninitialized_relocate(p->value_ptr(k), p->value_ptr(k + 1), l->value_ptr(lc));
+    mystl::uninitialized_relocate(r->value_ptr(0), r->value_ptr(rc), l->value_ptr(lc + 1));
+    if(!l->leaf)
+    {
+        for(size_type j = 0; j <= rc; ++j)
+        {
+            node_ptr c = r->child(j);
+            l->child(lc + 1 + j) = c;
+            c->parent = l;
+            c->position = static_cast<unsigned char>(lc + 1 + j);
+        }
+    }
+    // 父节点删除分隔元素与 r
+    mystl::uninitialized_relocate(p->value_ptr(k + 1), p->value_ptr(p->count), p->value_ptr(k));
+    for(size_type j = k + 2; j <= p->count; ++j)
+    {
+        p->child(j - 1) = p->child(j);
+        p->child(j - 1)->position = static_cast<unsigned char>(j - 1);
+    }
+    l->count = static_cast<unsigned char>(lc + 1 + rc);
+    --p->count;
+    if(rightmost_ == r)
+        rightmost_ = l;
+
+    if(next.node == p)
+    {
+        if(next.position == k)
+            next = iterator(l, lc);
+        else if(next.position > k)
+            --next.position;
+    }
+    else if(next.node == r)
+    {
+        next = iterator(l, lc + 1 + next.position);
+    }
+    deallocate_node(r);
+}
+
+// 从左兄弟节点借入元素：左兄弟的元素经过父节点转到 x 的开头，使两者的元素个数大致相等
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::borrow_from_left(node_ptr x, iterator& next)
+{
+    node_ptr p = x->parent;
+    const size_type k = x->position - 1;
+    node_ptr l = p->child(k);
+    const size_type xc = x->count;
+    const size_type lc = l->count;
+    const size_type n = (lc - xc) / 2;
+
+    mystl::uninitialized_relocate_backward(x->value_ptr(0), x->value_ptr(xc), x->value_ptr(xc + n));
+    mystl::uninitialized_relocate(p->value_ptr(k), p->value_ptr(k + 1), x->value_ptr(n - 1));
+    mystl::uninitialized_relocate(l->value_ptr(lc - n + 1), l->value_ptr(lc), x->value_ptr(0));
+    mystl::uninitialized_relocate(l->value_ptr(lc - n), l->value_ptr(lc - n + 1), p->value_ptr(k));
+    if(!x->leaf)
+    {
+        for(size_type j = xc + 1; j-- > 0; )
+        {
+            x->child(j + n) = x->child(j);
+            x->child(j + n)->position = static_cast<unsigned char>(j + n);
+        }
+        for(size_type j = 0; j < n; ++j)
+        {
+            node_ptr c = l->child(lc - n + 1 + j);
+            x->child(j) = c;
+            c->parent = x;
+            c->position = static_cast<unsigned char>(j);
+        }
+    }
+    l->count = static_cast<unsigned char>(lc - n);
+    x->count = static_cast<unsigned char>(xc + n);
+
+    if(next.node == x)
+    {
+        next.position += n;
+    }
+    else if(next.node == p && next.position == k)
+    {
+        next = iterator(x, n - 1);
+    }
+    else if(next.node == l && next.position >= lc - n)
+    {
+        next = next.position == lc - n ? iterator(p, k) : iterator(x, next.position - (lc - n + 1));
+    }
+}
+
+// 从右兄弟节点借入元素：右兄弟的元素经过父节点转到 x 的末尾
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::borrow_from_right(node_ptr x, iterator& next)
+{
+    node_ptr p = x->parent;
+    const size_type k = x->position;
+    node_ptr r = p->child(k + 1);
+    const size_type xc = x->count;
+    const size_type rc = r->count;
+    const size_type n = (rc - xc) / 2;
+
+    mystl::uninitialized_relocate(p->value_ptr(k), p->value_ptr(k + 1), x->value_ptr(xc));
+    mystl::uninitialized_relocate(r->value_ptr(0), r->value_ptr(n - 1), x->value_ptr(xc + 1));
+    mystl::uninitialized_relocate(r->value_ptr(n - 1), r->value_ptr(n), p->value_ptr(k));
+    mystl::uninitialized_relocate(r->value_ptr(n), r->value_ptr(rc), r->value_ptr(0));
+    if(!x->leaf)
+    {
+        for(size_type j = 0; j < n; ++j)
+        {
+            node_ptr c = r->child(j);
+            x->child(xc + 1 + j) = c;
+            c->parent = x;
+            c->position = static_cast<unsigned char>(xc + 1 + j);
+        }
+        for(size_type j = n; j <= rc; ++j)
+        {
+            r->child(j - n) = r->child(j);
+            r->child(j - n)->position = static_cast<unsigned char>(j - n);
+        }
+    }
+    x->count = static_cast<unsigned char>(xc + n);
+    r->count = static_cast<unsigned char>(rc - n);
+
+    if(next.node == p && next.position == k)
+    {
+        next = iterator(x, xc);
+    }
+    else if(next.node == r)
+    {
+        if(next.position + 1 < n)
+            next = iterator(x, xc + 1 + next.position);
+        else if(next.position + 1 == n)
+            next = iterator(p, k);
+        else
+            next.position -= n;
+    }
+}
+
+// 递归复制一颗子树，p 为新子树的父节点
+template <typename T, typename Compare, typename Alloc>
+typename btree<T, Compare, Alloc>::node_ptr
+btree<T, Compare, Alloc>::copy_from(node_ptr x, node_ptr p)
+{
+    node_ptr y = create_node(x->leaf);
+    y->parent = p;
+    y->position = x->position;
+    size_type nc = 0;  // 已经复制的孩子个数
+    try
+    {
+        for(; y->count < x->count; ++y->count)
+            node_alloc_traits::construct(this->get_alloc(), y->value_ptr(y->count), x->value(y->count));
+        if(!x->leaf)
+        {
+            for(; nc <= x->count; ++nc)
+                y->child(nc) = copy_from(x->child(nc), y);
+        }
+    }
+    catch(...)
+    {
+        for(size_type j = 0; j < nc; ++j)
+            erase_since(y->child(j));
+        for(size_type j = 0; j < y->count; ++j)
+            node_alloc_traits::destroy(this->get_alloc(), y->value_ptr(j));
+        deallocate_node(y);
+        throw;
+    }
+    return y;
+}
+
+// 复制 rhs 的所有节点，本树需为空
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::copy_root(const btree& rhs)
+{
+    if(rhs.root_ != nullptr)
+    {
+        root_ = copy_from(rhs.root_, nullptr);
+        leftmost_ = rightmost_ = root_;
+        while(!leftmost_->leaf)
+            leftmost_ = leftmost_->child(0);
+        while(!rightmost_->leaf)
+            rightmost_ = rightmost_->child(rightmost_->count);
+    }
+    size_ = rhs.size_;
+    key_comp_ = rhs.key_comp_;
+}
+
+// 销毁以 x 为根的子树上的所有元素并释放节点
+template <typename T, typename Compare, typename Alloc>
+void btree<T, Compare, Alloc>::erase_since(node_ptr x)
+{
+    for(size_type j = 0; j < x->count; ++j)
+        node_alloc_traits::destroy(this->get_alloc(), x->value_ptr(j));
+    if(!x->leaf)
+    {
+        for(size_type j = 0; j <= x->count; ++j)
+            erase_since(x->child(j));
+    }
+    deallocate_node(x);
+}
+
+// 重载比较操作符
+template <class T, class Compare, class Alloc>
+bool operator==(const btree<T, Compare, Alloc>& lhs, const btree<T, Compare, Alloc>& rhs)
+{
+  return lhs.size() == rhs.size() && mystl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class T, class Compare, class Alloc>
+bool operator<(const btree<T, Compare, Alloc>& lhs, const btree<T, Compare, Alloc>& rhs)
+{
+  return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <class T, class Compare, class Alloc>
+bool operator!=(const btree<T, Compare, Alloc>& lhs, const btree<T, Compare, Alloc>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class T, class Compare, class Alloc>
+bool operator>(const btree<T, Compare, Alloc>& lhs, const btree<T, Compare, Alloc>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class T, class Compare, class Alloc>
+bool operator<=(const btree<T, Compare, Alloc>& lhs, const btree<T, Compare, Alloc>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class T, class Compare, class Alloc>
+bool operator>=(const btree<T, Compare, Alloc>& lhs, const btree<T, Compare, Alloc>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class T, class Compare, class Alloc>
+void swap(btree<T, Compare, Alloc>& lhs, btree<T, Compare, Alloc>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+// 节点都分配在堆上，根节点的父节点为 nullptr，没有节点指向 btree 对象本身
+template <class T, class Compare, class Alloc>
+struct is_trivially_relocatable<btree<T, Compare, Alloc>>
+  : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                    is_trivially_relocatable<Alloc>::value> {};
+
+}
+#endif // !MYTINYSTL_BTREE_H_
@@ -0,0 +1,465 @@
+#ifndef MYTINYSTL_BTREE_SET_H_
+#define MYTINYSTL_BTREE_SET_H_
+
+// 这个头文件包含两个模板类 btree_set 和 btree_multiset
+// 功能与用法与 set / multiset 相同，底层使用 btree，每个节点连续存放多个元素，
+// 查找访问的节点数少，顺序遍历接近连续访问
+
+// notes:
+//
+// 与 set / multiset 的区别：
+//   * 插入与删除时元素会在节点之间搬移，之后所有的迭代器、指针和引用都会失效，
+//     erase 返回指向下一个元素的迭代器，可以用它继续遍历
+//   * 元素不在单独的节点中，不提供节点句柄（extract、insert(node_type&&)）与 merge
+//   * emplace_hint / insert(hint, value) 只在 hint 为 end() 且元素不小于最大的元素时使用 hint，顺序插入最快
+//
+// 异常保证：
+// mystl::btree_set<Key> / mystl::btree_multiset<Key> 满足基本异常保证，对以下等函数做强异常安全保证：
+//   * emplace
+//   * emplace_hint
+//   * insert
+// 元素的移动构造函数不应抛出异常
+
+#include "btree.h"
+
+namespace mystl
+{
+
+// 模板类 btree_set，键值不允许重复
+// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+template <typename Key, typename Compare = mystl::less<Key>, typename Alloc = mystl::allocator<Key>>
+class btree_set
+{
+public:
+    typedef Key      key_type;
+    typedef Key      value_type;
+    typedef Compare  key_compare;
+    typedef Compare  value_compare;
+
+private:
+    // 以 mystl::btree 作为底层机制
+    typedef mystl::btree<value_type, key_compare, Alloc> base_type;
+    base_type tree_;
+
+public:
+    // 使用 btree 定义的型别
+    typedef typename base_type::const_pointer           pointer;
+    typedef typename base_type::const_pointer           const_pointer;
+    typedef typename base_type::const_reference         reference;
+    typedef typename base_type::const_reference         const_reference;
+    typedef typename base_type::const_iterator          iterator;
+    typedef typename base_type::const_iterator          const_iterator;
+    typedef typename base_type::const_reverse_iterator  reverse_iterator;
+    typedef typename base_type::const_reverse_iterator  const_reverse_iterator;
+    typedef typename base_type::size_type               size_type;
+    typedef typename base_type::difference_type         difference_type;
+    typedef typename base_type::allocator_type          allocator_type;
+
+public:
+    // 构造、复制、移动函数
+    btree_set() = default;
+
+    explicit btree_set(const allocator_type& alloc) : tree_(alloc) {}
+
+    template <typename InputIterator>
+    btree_set(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
+    {
+        tree_.insert_unique(first, last);
+    }
+    btree_set(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
+    {
+        tree_.insert_unique(ilist.begin(), ilist.end());
+    }
+
+    btree_set(const btree_set& rhs) : tree_(rhs.tree_) {}
+    btree_set(btree_set&& rhs) noexcept : tree_(mystl::move(rhs.tree_)) {};
+
+    btree_set& operator=(const btree_set& rhs)
+    {
+        tree_ = rhs.tree_;
+        return *this;
+    }
+    btree_set& operator=(btree_set&& rhs)
+    {
+        tree_ = mystl::move(rhs.tree_);
+        return *this;
+    }
+    btree_set& operator=(std::initializer_list<value_type> ilist)
+    {
+        tree_.clear();
+        tree_.insert_unique(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    key_compare    key_comp()      const { return tree_.key_comp(); }
+    value_compare  value_comp()    const { return tree_.key_comp(); }
+    allocator_type get_allocator() const { return tree_.get_allocator(); }
+
+    iterator begin() noexcept
+    { return tree_.begin(); }
+    const_iterator begin() const noexcept
+    { return tree_.begin(); }
+    iterator end() noexcept
+    { return tree_.end(); }
+    const_iterator end() const noexcept
+    { return tree_.end(); }
+
+    reverse_iterator rbegin() noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept
+    { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept
+    { return const_reverse_iterator(end()); }
+
+    const_iterator cbegin() const noexcept
+    { return begin(); }
+    const_iterator cend() const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend() const noexcept
+    { return rend(); }
+
+    // 容量相关
+    bool      empty()    const noexcept { return tree_.empty(); }
+    size_type size()     const noexcept { return tree_.size(); }
+    size_type max_size() const noexcept { return tree_.max_size(); }
+
+    // 插入删除操作
+    template <typename... Args>
+    pair<iterator, bool> emplace(Args&&... args)
+    {
+        return tree_.emplace_unique(mystl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(iterator hint, Args&&... args)
+    {
+        return tree_.emplace_unique_use_hint(hint, mystl::forward<Args>(args)...);
+    }
+
+    pair<iterator, bool> insert(const value_type& value)
+    {
+        return tree_.insert_unique(value);
+    }
+    pair<iterator, bool> insert(value_type&& value)
+    {
+        return tree_.insert_unique(mystl::move(value));
+    }
+
+    iterator insert(iterator hint, const value_type& value)
+    {
+        return tree_.insert_unique(hint, value);
+    }
+    iterator insert(iterator hint, value_type&& value)
+    {
+        return tree_.insert_unique(hint, mystl::move(value));
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        tree_.insert_unique(first, last);
+    }
+
+    // erase 会使所有的迭代器失效，返回的迭代器指向被删除元素的下一个元素
+    iterator erase(iterator position) { return tree_.erase(position); }
+    size_type erase(const value_type& value)
+    {
+        return tree_.erase_unique(value);
+    }
+    iterator erase(iterator first, iterator last)
+    { return tree_.erase(first, last); }
+
+    void clear() { tree_.clear(); }
+
+    // btree_set 相关操作
+    iterator       find(const key_type& key)              { return tree_.find(key); }
+    const_iterator find(const key_type& key)        const { return tree_.find(key); }
+
+    size_type      count(const key_type& key)       const { return tree_.count_unique(key); }
+
+    iterator       lower_bound(const key_type& key)       { return tree_.lower_bound(key); }
+    const_iterator lower_bound(const key_type& key) const { return tree_.lower_bound(key); }
+
+    iterator       upper_bound(const key_type& key)       { return tree_.upper_bound(key); }
+    const_iterator upper_bound(const key_type& key) const { return tree_.upper_bound(key); }
+
+    pair<iterator, iterator> equal_range(const key_type& key)
+    { return tree_.equal_range_unique(key); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    { return tree_.equal_range_unique(key); }
+
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return tree_.count_unique(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return tree_.equal_range_unique(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return tree_.equal_range_unique(key); }
+
+    void swap(btree_set& rhs) noexcept
+    { tree_.swap(rhs.tree_); }
+public:
+    friend bool operator==(const btree_set& lhs, const btree_set& rhs) { return lhs.tree_ == rhs.tree_; }
+    friend bool operator< (const btree_set& lhs, const btree_set& rhs) { return lhs.tree_ < rhs.tree_; }
+};
+
+template <typename Key, typename Compare, typename Alloc>
+void swap(btree_set<Key, Compare, Alloc>& lhs, btree_set<Key, Compare, Alloc>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+/*****************************************************************************************/
+
+// 模板类 btree_multiset，键值允许重复
+// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+template <typename Key, typename Compare = mystl::less<Key>, typename Alloc = mystl::allocator<Key>>
+class btree_multiset
+{
+public:
+    typedef Key      key_type;
+    typedef Key      value_type;
+    typedef Compare  key_compare;
+    typedef Compare  value_compare;
+
+private:
+    // 以 mystl::btree 作为底层机制
+    typedef mystl::btree<value_type, key_compare, Alloc> base_type;
+    base_type tree_;
+
+public:
+    // 使用 btree 定义的型别
+    typedef typename base_type::const_pointer           pointer;
+    typedef typename base_type::const_pointer           const_pointer;
+    typedef typename base_type::const_reference         reference;
+    typedef typename base_type::const_reference         const_reference;
+    typedef typename base_type::const_iterator          iterator;
+    typedef typename base_type::const_iterator          const_iterator;
+    typedef typename base_type::const_reverse_iterator  reverse_iterator;
+    typedef typename base_type::const_reverse_iterator  const_reverse_iterator;
+    typedef typename base_type::size_type               size_type;
+    typedef typename base_type::difference_type         difference_type;
+    typedef typename base_type::allocator_type          allocator_type;
+
+public:
+    // 构造、复制、移动函数
+    btree_multiset() = default;
+
+    explicit btree_multiset(const allocator_type& alloc) : tree_(alloc) {}
+
+    template <typename InputIterator>
+    btree_multiset(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
+    {
+        tree_.insert_multi(first, last);
+    }
+    btree_multiset(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
+    {
+        tree_.insert_multi(ilist.begin(), ilist.end());
+    }
+
+    btree_multiset(const btree_multiset& rhs) : tree_(rhs.tree_) {}
+    btree_multiset(btree_multiset&& rhs) noexcept : tree_(mystl::move(rhs.tree_)) {};
+
+    btree_multiset& operator=(const btree_multiset& rhs)
+    {
+        tree_ = rhs.tree_;
+        return *this;
+    }
+    btree_multiset& operator=(btree_multiset&& rhs)
+    {
+        tree_ = mystl::move(rhs.tree_);
+        return *this;
+    }
+    btree_multiset& operator=(std::initializer_list<value_type> ilist)
+    {
+        tree_.clear();
+        tree_.insert_multi(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    key_compare    key_comp()      const { return tree_.key_comp(); }
+    value_compare  value_comp()    const { return tree_.key_comp(); }
+    allocator_type get_allocator() const { return tree_.get_allocator(); }
+
+    iterator begin() noexcept
+    { return tree_.begin(); }
+    const_iterator begin() const noexcept
+    { return tree_.begin(); }
+    iterator end() noexcept
+    { return tree_.end(); }
+    const_iterator end() const noexcept
+    { return tree_.end(); }
+
+    reverse_iterator rbegin() noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept
+    { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept
+    { return const_reverse_iterator(end()); }
+
+    const_iterator cbegin() const noexcept
+    { return begin(); }
+    const_iterator cend() const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend() const noexcept
+    { return rend(); }
+
+    // 容量相关
+    bool      empty()    const noexcept { return tree_.empty(); }
+    size_type size()     const noexcept { return tree_.size(); }
+    size_type max_size() const noexcept { return tree_.max_size(); }
+
+    // 插入删除操作
+    template <typename... Args>
+    iterator emplace(Args&&... args)
+    {
+        return tree_.emplace_multi(mystl::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(iterator hint, Args&&... args)
+    {
+        return tree_.emplace_multi_use_hint(hint, mystl::forward<Args>(args)...);
+    }
+
+    iterator insert(const value_type& value)
+    {
+        return tree_.insert_multi(value);
+    }
+    iterator insert(value_type&& value)
+    {
+        return tree_.insert_multi(mystl::move(value));
+    }
+
+    iterator insert(iterator hint, const value_type& value)
+    {
+        return tree_.insert_multi(hint, value);
+    }
+    iterator insert(iterator hint, value_type&& value)
+    {
+        return tree_.insert_multi(hint, mystl::move(value));
+    }
+
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        tree_.insert_multi(first, last);
+    }
+
+    // erase 会使所有的迭代器失效，返回的迭代器指向被删除元素的下一个元素
+    iterator erase(iterator position) { return tree_.erase(position); }
+    size_type erase(const value_type& value)
+    {
+        return tree_.erase_multi(value);
+    }
+    iterator erase(iterator first, iterator last)
+    { return tree_.erase(first, last); }
+
+    void clear() { tree_.clear(); }
+
+    // btree_multiset 相关操作
+    iterator       find(const key_type& key)              { return tree_.find(key); }
+    const_iterator find(const key_type& key)        const { return tree_.find(key); }
+
+    size_type      count(const key_type& key)       const { return tree_.count_multi(key); }
+
+    iterator       lower_bound(const key_type& key)       { return tree_.lower_bound(key); }
+    const_iterator lower_bound(const key_type& key) const { return tree_.lower_bound(key); }
+
+    iterator       upper_bound(const key_type& key)       { return tree_.upper_bound(key); }
+    const_iterator upper_bound(const key_type& key) const { return tree_.upper_bound(key); }
+
+    pair<iterator, iterator> equal_range(const key_type& key)
+    { return tree_.equal_range_multi(key); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    { return tree_.equal_range_multi(key); }
+
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return tree_.count_multi(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return tree_.equal_range_multi(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return tree_.equal_range_multi(key); }
+
+    void swap(btree_multiset& rhs) noexcept
+    { tree_.swap(rhs.tree_); }
+public:
+    friend bool operator==(const btree_multiset& lhs, const btree_multiset& rhs) { return lhs.tree_ == rhs.tree_; }
+    friend bool operator< (const btree_multiset& lhs, const btree_multiset& rhs) { return lhs.tree_ < rhs.tree_; }
+};
+
+template <typename Key, typename Compare, typename Alloc>
+void swap(btree_multiset<Key, Compare, Alloc>& lhs, btree_multiset<Key, Compare, Alloc>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+// 与底层的 btree 相同，可以直接搬移
+template <typename Key, typename Compare, typename Alloc>
+struct is_trivially_relocatable<btree_set<Key, Compare, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <typename Key, typename Compare, typename Alloc>
+struct is_trivially_relocatable<btree_multiset<Key, Compare, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 btree_set / btree_multiset，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <typename Key, typename Compare = mystl::less<Key>>
+using btree_set = mystl::btree_set<Key, Compare, polymorphic_allocator<Key>>;
+
+template <typename Key, typename Compare = mystl::less<Key>>
+using btree_multiset = mystl::btree_multiset<Key, Compare, polymorphic_allocator<Key>>;
+} // namespace pmr
+
+}
+
+#endif // !MYTINYSTL_BTREE_SET_H_
@@ -50,6 +50,9 @@ void destroy_one(Ty* pointer, std::false_type)
     }
 }
 
+template <class Ty>
+void destroy(Ty* pointer);
+
 template <class ForwardIterator>
 void destroy_cat(ForwardIterator, ForwardIterator, std::true_type) {}
 template <class ForwardIterator>
@@ -42,19 +42,25 @@ namespace mystl
 #define DEQUE_MAP_INIT_SIZE 8
 #endif
 
-template <class T>
+// deque 缓存的空闲缓冲区的最大数目
+#ifndef DEQUE_SPARE_BUFFERS
+#define DEQUE_SPARE_BUFFERS 2
+#endif
+
+// 每个缓冲区容纳的元素个数，BufSize 不为 0 时使用 BufSize，否则每个缓冲区约占 4096 字节
+template <class T, size_t BufSize = 0>
 struct deque_buf_size
 {
-    static constexpr size_t value = sizeof(T) < 256 ? 4096 / sizeof(T) : 16;
+    static constexpr size_t value = BufSize != 0 ? BufSize : (sizeof(T) < 256 ? 4096 / sizeof(T) : 16);
 };
 
 // deque 的迭代器设计
-template <class T, class Ref, class Ptr>
+template <class T, class Ref, class Ptr, size_t BufSize = 0>
 struct deque_iterator : public iterator<random_access_iterator_tag, T>
 {
-    typedef deque_iterator<T, T&, T*>             iterator;
-    typedef deque_iterator<T, const T&, const T*> const_iterator;
-    typedef deque_iterator                        self;
+    typedef deque_iterator<T, T&, T*, BufSize>             iterator;
+    typedef deque_iterator<T, const T&, const T*, BufSize> const_iterator;
+    typedef deque_iterator                                 self;
 
     typedef T            value_type;
     typedef Ptr          pointer;
@@ -64,7 +70,7 @@ struct deque_iterator : public iterator<random_access_iterator_tag, T>
     typedef T*           value_pointer;
     typedef T**          map_pointer;
 
-    static const size_type buffer_size = deque_buf_size<T>::value;
+    static const size_type buffer_size = deque_buf_size<T, BufSize>::value;
 
     // 迭代器所含成员数据
     value_pointer cur;    // 指向所在缓冲区的当前元素
@@ -204,83 +210,141 @@ struct deque_iterator : public iterator<random_access_iterator_tag, T>
     bool operator>=(const self& rhs) const { return !(*this < rhs); }
 };
 
+// deque 的迭代器是分段迭代器，每个缓冲区是一段
+template <class T, class Ref, class Ptr, size_t BufSize>
+struct segmented_iterator_traits<deque_iterator<T, Ref, Ptr, BufSize>>
+{
+    typedef deque_iterator<T, Ref, Ptr, BufSize> iterator;
+    typedef typename iterator::map_pointer       segment_iterator;
+    typedef Ptr                                  local_iterator;
+
+    static constexpr bool is_segmented = true;
+
+    static segment_iterator segment(const iterator& it) { return it.node; }
+    static local_iterator   local(const iterator& it)   { return it.cur; }
+    static local_iterator   begin(segment_iterator seg) { return *seg; }
+    static local_iterator   end(segment_iterator seg)   { return *seg + iterator::buffer_size; }
+
+    // 位于一段的尾部时，转到下一段的头部
+    static iterator compose(segment_iterator seg, local_iterator local)
+    {
+        if(local == end(seg))
+        {
+            ++seg;
+            local = begin(seg);
+        }
+        return iterator(const_cast<T*>(local), seg);
+    }
+};
+
 // 模板类 deque
-// 模板参数代表数据类型
-template <class T>
-class deque
+// 模板参数 T 代表数据类型，Alloc 代表空间配置器，缺省使用 mystl::allocator
+// BufSize 代表每个缓冲区容纳的元素个数，缺省为 0，由 deque_buf_size 决定
+template <class T, class Alloc = mystl::allocator<T>, size_t BufSize = 0>
+class deque : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>>
 {
 public:
     // deque 的型别定义
-    typedef mystl::allocator<T>                      allocator_type;
-    typedef mystl::allocator<T>                      data_allocator;
-    typedef mystl::allocator<T*>                     map_allocator;
-
-    typedef typename allocator_type::value_type      value_type;
-    typedef typename allocator_type::pointer         pointer;
-    typedef typename allocator_type::const_pointer   const_pointer;
-    typedef typename allocator_type::reference       reference;
-    typedef typename allocator_type::const_reference const_reference;
-    typedef typename allocator_type::size_type       size_type;
-    typedef typename allocator_type::difference_type difference_type;
-    typedef pointer*                                 map_pointer;
-    typedef const_pointer*                           const_map_pointer;
-
-    typedef deque_iterator<T, T&, T*>                iterator;
-    typedef deque_iterator<T, const T&, const T*>    const_iterator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>  data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T*> map_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef mystl::allocator_traits<map_allocator>      map_alloc_traits;
+    typedef data_allocator                              allocator_type;
+
+    typedef typename data_alloc_traits::value_type      value_type;
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
+    typedef pointer*                                    map_pointer;
+    typedef const_pointer*                              const_map_pointer;
+
+    typedef deque_iterator<T, T&, T*, BufSize>             iterator;
+    typedef deque_iterator<T, const T&, const T*, BufSize> const_iterator;
     typedef mystl::reverse_iterator<iterator>        reverse_iterator;
     typedef mystl::reverse_iterator<const_iterator>  const_reverse_iterator;
 
-    allocator_type get_allocator() { return allocator_type(); }
+    allocator_type get_allocator() const { return this->get_alloc(); }
 
-    static const size_type buffer_size = deque_buf_size<T>::value;
+    static const size_type buffer_size = deque_buf_size<T, BufSize>::value;
 
 private:
+    typedef mystl::alloc_holder<data_allocator>      alloc_base;
+
+    static_assert(DEQUE_SPARE_BUFFERS > 0, "DEQUE_SPARE_BUFFERS should be positive");
+
     // 用以下四个数据来表现一个 deque
     iterator       begin_;     // 指向第一个节点
     iterator       end_;       // 指向最后一个结点
     map_pointer    map_;       // 指向一块 map，map 中的每个元素都是一个指针，指向一个缓冲区
     size_type      map_size_;  // map 内指针的数目
 
+    // 弹出元素时空出的缓冲区先放在这里，需要新缓冲区时优先取用
+    pointer        spare_[DEQUE_SPARE_BUFFERS];
+    size_type      spare_size_ = 0;
+
 public:
     // 构造、复制、移动、析构函数
     deque()
     { fill_init(0, value_type()); }
 
-    explicit deque(size_type n)
+    explicit deque(const allocator_type& alloc)
+        :alloc_base(alloc)
+    { fill_init(0, value_type()); }
+
+    explicit deque(size_type n, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     { fill_init(n, value_type()); }
 
-    deque(size_type n, const value_type& value)
+    deque(size_type n, const value_type& value, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     { fill_init(n, value); }
 
     template <class InputIterator,
     typename std::enable_if<mystl::is_input_iterator<InputIterator>::value, int>::type = 0>
-    deque(InputIterator first, InputIterator last)
+    deque(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     {
         copy_init(first, last, iterator_category(first));
     }
 
-    deque(std::initializer_list<value_type> ilist)
+    deque(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     {
         copy_init(ilist.begin(), ilist.end(), mystl::forward_iterator_tag());
     }
 
     deque(const deque& rhs)
+        :alloc_base(data_alloc_traits::select_on_container_copy_construction(rhs.get_alloc()))
+    {
+        copy_init(rhs.begin(), rhs.end(), mystl::forward_iterator_tag());
+    }
+
+    deque(const deque& rhs, const allocator_type& alloc)
+        :alloc_base(alloc)
     {
         copy_init(rhs.begin(), rhs.end(), mystl::forward_iterator_tag());
     }
 
     deque(deque&& rhs)
-    : begin_(mystl::move(rhs.begin_)), end_(mystl::move(rhs.end_)), map_(rhs.map_), map_size_(rhs.map_size_)
+    : alloc_base(mystl::move(rhs.get_alloc())),
+      begin_(mystl::move(rhs.begin_)), end_(mystl::move(rhs.end_)), map_(rhs.map_), map_size_(rhs.map_size_),
+      spare_size_(rhs.spare_size_)
     {
+        for(size_type i = 0; i < spare_size_; ++i)
+            spare_[i] = rhs.spare_[i];
         rhs.map_ = nullptr;
         rhs.map_size_ = 0;
+        rhs.spare_size_ = 0;
     }
 
     deque& operator=(const deque& rhs);
     deque& operator=(deque&& rhs);
     deque& operator=(std::initializer_list<value_type> ilist)
     {
-        deque tmp(ilist);
+        deque tmp(ilist, this->get_alloc());
         swap(tmp);
         return *this;
     }
@@ -290,9 +354,9 @@ public:
         if(map_ != nullptr)
         {
             clear();
-            data_allocator::deallocate(*begin_.node, buffer_size);
+            data_alloc_traits::deallocate(this->get_alloc(), *begin_.node, buffer_size);
             *begin_.node = nullptr;
-            map_allocator::deallocate(map_, map_size_);
+            destroy_map(map_, map_size_);
             map_ = nullptr;
         }
     }
@@ -336,12 +400,12 @@ public:
 
     reference at(size_type n)
     {
-        THROW_OUT_OF_RANGE_IF(!(n < size()), "deque<T>::at() subscript out of range");
+        THROW_OUT_OF_RANGE_IF(!(n < size()), "deque<T, Alloc>::at() subscript out of range");
         return (*this)[n];
     }
     const_reference at(size_type n) const
     {
-        THROW_OUT_OF_RANGE_IF(!(n < size()), "deque<T>::at() subscript out of range");
+        THROW_OUT_OF_RANGE_IF(!(n < size()), "deque<T, Alloc>::at() subscript out of range");
         return (*this)[n];
     }
 
@@ -425,8 +489,14 @@ private:
 
     // create node / destroy node
     map_pointer create_map(size_type size);
+    void        destroy_map(map_pointer mp, size_type size);
+    void        swap_data(deque& rhs) noexcept;
     void        create_buffer(map_pointer nstart, map_pointer nfinish);
     void        destroy_buffer(map_pointer nstart, map_pointer nfinish);
+    void        destroy_range(iterator first, iterator last) noexcept;
+    pointer     allocate_buffer();
+    void        deallocate_buffer(pointer p) noexcept;
+    void        release_spare() noexcept;
 
     // initialize
     void map_init(size_type nelem);
@@ -466,15 +536,26 @@ private:
     void require_capacity(size_type n, bool front);
     void reallocate_map_at_front(size_type need_buffer);
     void reallocate_map_at_back(size_type need_buffer);
+    void recenter_map(map_pointer nstart);
 };
 
 
 // 复制赋值运算符
-template <class T>
-deque<T>& deque<T>::operator=(const deque& rhs)
+template <class T, class Alloc, size_t BufSize>
+deque<T, Alloc, BufSize>& deque<T, Alloc, BufSize>::operator=(const deque& rhs)
 {
     if(this != &rhs)
     {
+        // 需要传播分配器且两者不相等时，原有空间必须由原分配器释放
+        if(data_alloc_traits::propagate_on_container_copy_assignment::value &&
+           this->get_alloc() != rhs.get_alloc())
+        {
+            deque tmp(rhs.begin_, rhs.end_, rhs.get_alloc());
+            swap_data(tmp);
+            mystl::swap(this->get_alloc(), tmp.get_alloc());
+            return *this;
+        }
+        mystl::alloc_on_copy(this->get_alloc(), rhs.get_alloc());
         const auto len = size();
         if(len >= rhs.size())
         {
@@ -491,22 +572,32 @@ deque<T>& deque<T>::operator=(const deque& rhs)
 }
 
 // 移动赋值运算符
-template <class T>
-deque<T>& deque<T>::operator=(deque&& rhs)
+template <class T, class Alloc, size_t BufSize>
+deque<T, Alloc, BufSize>& deque<T, Alloc, BufSize>::operator=(deque&& rhs)
 {
-    clear();  // 空间没有deallocate?
-    begin_ = mystl::move(rhs.begin_);
-    end_ = mystl::move(rhs.end_);
-    map_ = rhs.map_;
-    map_size_ = rhs.map_size_;
-    rhs.map_ = nullptr;
-    rhs.map_size_ = 0;
+    if(this == &rhs)return *this;
+    if(data_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
+    {
+        // 先与 rhs 交换数据，原有的空间随 tmp 一起释放
+        deque tmp(mystl::move(*this));
+        swap_data(rhs);
+        mystl::alloc_on_move(this->get_alloc(), rhs.get_alloc());
+    }
+    else
+    {
+        // 分配器不相等且不传播时，只能逐个移动元素
+        clear();
+        for(auto it = rhs.begin_; it != rhs.end_; ++it)
+            emplace_back(mystl::move(*it));
+        rhs.clear();
+    }
     return *this;
 }
 
 // 重置容器大小
-template <class T>
-void deque<T>::resize(size_type new_size, const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::resize(size_type new_size, const value_type& value)
 {
     const auto len = size();
     if(new_size < len)
@@ -520,30 +611,31 @@ void deque<T>::resize(size_type new_size, const value_type& value)
 }
 
 // 减小容器容量
-template <class T>
-void deque<T>::shrink_to_fit() noexcept
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::shrink_to_fit() noexcept
 {
     // 至少会留下头部缓冲区
     for(auto cur = map_; cur < begin_.node; ++cur)
     {
-        data_allocator::deallocate(*cur, buffer_size);
+        data_alloc_traits::deallocate(this->get_alloc(), *cur, buffer_size);
         *cur = nullptr;
     }
     for(auto cur = end_.node + 1; cur < map_ + map_size_; ++cur)
     {
-        data_allocator::deallocate(*cur, buffer_size);
+        data_alloc_traits::deallocate(this->get_alloc(), *cur, buffer_size);
         *cur = nullptr;
     }
+    release_spare();
 }
 
 // 在头部就地构建元素
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class... Args>
-void deque<T>::emplace_front(Args&&... args)
+void deque<T, Alloc, BufSize>::emplace_front(Args&&... args)
 {
     if(begin_.cur != begin_.first)
     {
-        data_allocator::construct(begin_.cur - 1, mystl::forward<Args>(args)...);
+        data_alloc_traits::construct(this->get_alloc(), begin_.cur - 1, mystl::forward<Args>(args)...);
         --begin_.cur;
     }
     else
@@ -552,7 +644,7 @@ void deque<T>::emplace_front(Args&&... args)
         try
         {
             --begin_;
-            data_allocator::construct(begin_.cur, mystl::forward<Args>(args)...);
+            data_alloc_traits::construct(this->get_alloc(), begin_.cur, mystl::forward<Args>(args)...);
         }
         catch(...)
         {
@@ -563,28 +655,28 @@ void deque<T>::emplace_front(Args&&... args)
 }
 
 // 在尾部就地构建元素
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class... Args>
-void deque<T>::emplace_back(Args&&... args)
+void deque<T, Alloc, BufSize>::emplace_back(Args&&... args)
 {
     if(end_.cur != end_.last - 1)
     {
-        data_allocator::construct(end_.cur, mystl::forward<Args>(args)...);
+        data_alloc_traits::construct(this->get_alloc(), end_.cur, mystl::forward<Args>(args)...);
         ++end_.cur;
     }
     else
     {
         require_capacity(1, false);
         // require_capacity操作后end_已经被更新了，后面的new_buffer是在这一步才创建的
-        data_allocator::construct(end_.cur, mystl::forward<Args>(args)...);
+        data_alloc_traits::construct(this->get_alloc(), end_.cur, mystl::forward<Args>(args)...);
         ++end_;
     }
 }
 
 // 在 pos 位置就地构建元素
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class... Args>
-typename deque<T>::iterator deque<T>::emplace(iterator pos, Args&&... args)
+typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::emplace(iterator pos, Args&&... args)
 {
     if(pos.cur == begin_.cur)
     {
@@ -600,12 +692,12 @@ typename deque<T>::iterator deque<T>::emplace(iterator pos, Args&&... args)
 }
 
 // 在头部插入元素
-template <class T>
-void deque<T>::push_front(const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::push_front(const value_type& value)
 {
     if(begin_.cur != begin_.first)
     {
-        data_allocator::construct(begin_.cur - 1, value);
+        data_alloc_traits::construct(this->get_alloc(), begin_.cur - 1, value);
         --begin_.cur;
     }
     else
@@ -614,7 +706,7 @@ void deque<T>::push_front(const value_type& value)
         try
         {
             --begin_;
-            data_allocator::construct(begin_.cur, value);
+            data_alloc_traits::construct(this->get_alloc(), begin_.cur, value);
         }
         catch(...)
         {
@@ -625,60 +717,60 @@ void deque<T>::push_front(const value_type& value)
 }
 
 // 在尾部插入元素
-template <class T>
-void deque<T>::push_back(const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::push_back(const value_type& value)
 {
     if(end_.cur != end_.last - 1)
     {
-        data_allocator::construct(end_.cur, value);
+        data_alloc_traits::construct(this->get_alloc(), end_.cur, value);
         ++end_.cur;
     }
     else
     {
         require_capacity(1, false);
-        data_allocator::construct(end_.cur, value);
+        data_alloc_traits::construct(this->get_alloc(), end_.cur, value);
         ++end_;
     }
 }
 
 // 弹出头部元素
-template <class T>
-void deque<T>::pop_front()
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::pop_front()
 {
     MYSTL_DEBUG(!empty());
     if(begin_.cur != begin_.last - 1)
     {
-        data_allocator::destroy(begin_.cur);
+        data_alloc_traits::destroy(this->get_alloc(), begin_.cur);
         ++begin_.cur;
     }
     else
     {
-        data_allocator::destroy(begin_.cur);
+        data_alloc_traits::destroy(this->get_alloc(), begin_.cur);
         ++begin_;
         destroy_buffer(begin_.node - 1, begin_.node - 1);
     }
 }
 
 // 弹出尾部元素
-template <class T>
-void deque<T>::pop_back(){
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::pop_back(){
     MYSTL_DEBUG(!empty());
     if(end_.cur != end_.first)
     {
         --end_.cur;
-        data_allocator::destroy(end_.cur);
+        data_alloc_traits::destroy(this->get_alloc(), end_.cur);
     }
     else
     {
         --end_;
-        data_allocator::destroy(end_.cur);
+        data_alloc_traits::destroy(this->get_alloc(), end_.cur);
         destroy_buffer(end_.node + 1, end_.node + 1);
     }
 }
 
 // 在 pos 处插入元素
-template <class T>
-typename deque<T>::iterator deque<T>::insert(iterator pos, const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::insert(iterator pos, const value_type& value)
 {
     if(pos.cur == begin_.cur)
     {
@@ -698,8 +790,8 @@ typename deque<T>::iterator deque<T>::insert(iterator pos, const value_type& val
     }
 }
 
-template <class T>
-typename deque<T>::iterator deque<T>::insert(iterator pos, value_type&& value)
+template <class T, class Alloc, size_t BufSize>
+typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::insert(iterator pos, value_type&& value)
 {
     if(pos.cur == begin_.cur)
     {
@@ -720,8 +812,8 @@ typename deque<T>::iterator deque<T>::insert(iterator pos, value_type&& value)
 }
 
 // 在 position 位置插入 n 个元素
-template <class T>
-void deque<T>::insert(iterator pos, size_type n, const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::insert(iterator pos, size_type n, const value_type& value)
 {
     if(pos.cur == begin_.cur)
     {
@@ -744,8 +836,8 @@ void deque<T>::insert(iterator pos, size_type n, const value_type& value)
 }
 
 // 删除 pos 处的元素
-template <class T>
-typename deque<T>::iterator deque<T>::erase(iterator pos)
+template <class T, class Alloc, size_t BufSize>
+typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iterator pos)
 {
     auto next = pos;
     ++next;
@@ -764,8 +856,8 @@ typename deque<T>::iterator deque<T>::erase(iterator pos)
 }
 
 // 删除[first, last)上的元素
-template <class T>
-typename deque<T>::iterator deque<T>::erase(iterator first, iterator last)
+template <class T, class Alloc, size_t BufSize>
+typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::erase(iterator first, iterator last)
 {
     if(first == begin_ && last == end_)
     {
@@ -780,14 +872,18 @@ typename deque<T>::iterator deque<T>::erase(iterator first, iterator last)
         {
             mystl::copy_backward(begin_, first, last);
             auto new_begin = begin_ + len;
-            data_allocator::destroy(begin_.cur, new_begin.cur);
+            destroy_range(begin_, new_begin);
+            if(new_begin.node != begin_.node)
+                destroy_buffer(begin_.node, new_begin.node - 1);
             begin_ = new_begin;
         }
         else
         {
             mystl::copy(last, end_, first);
             auto new_end = end_ - len;
-            data_allocator::destroy(new_end.cur, end_.cur);
+            destroy_range(new_end, end_);
+            if(new_end.node != end_.node)
+                destroy_buffer(new_end.node + 1, end_.node);
             end_ = new_end;
         }
         return begin_ + elems_before;
@@ -795,37 +891,23 @@ typename deque<T>::iterator deque<T>::erase(iterator first, iterator last)
 }
 
 // 清空 deque
-template <class T>
-void deque<T>::clear()
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::clear()
 {
     // clear 会保留头部的缓冲区
-    for(map_pointer cur = begin_.node + 1; cur < end_.node; ++cur)
-    {
-        data_allocator::destroy(*cur, *cur + buffer_size);
-    }
-    if(begin_.node != end_.node)
-    {   // 有两个以上的缓冲区
-        mystl::destroy(begin_.cur, begin_.last);
-        mystl::destroy(end_.first, end_.cur);
-    }
-    else
-    {
-        mystl::destroy(begin_.cur, end_.cur);
-    }
-    shrink_to_fit();
+    destroy_range(begin_, end_);
     end_ = begin_;
+    shrink_to_fit();
 }
 
 // 交换两个 deque
-template <class T>
-void deque<T>::swap(deque& rhs) noexcept
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::swap(deque& rhs) noexcept
 {
     if(this != &rhs)
     {
-        mystl::swap(begin_, rhs.begin_);
-        mystl::swap(end_, rhs.end_);
-        mystl::swap(map_, rhs.map_);
-        mystl::swap(map_size_, rhs.map_size_);
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
     }
 }
 
@@ -833,26 +915,49 @@ void deque<T>::swap(deque& rhs) noexcept
 /*****************************************************************************************/
 // helper function
 
+// swap_data 函数，只交换数据，不交换分配器
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::swap_data(deque& rhs) noexcept
+{
+    mystl::swap(begin_, rhs.begin_);
+    mystl::swap(end_, rhs.end_);
+    mystl::swap(map_, rhs.map_);
+    mystl::swap(map_size_, rhs.map_size_);
+    const auto n = mystl::max(spare_size_, rhs.spare_size_);
+    for(size_type i = 0; i < n; ++i)
+        mystl::swap(spare_[i], rhs.spare_[i]);
+    mystl::swap(spare_size_, rhs.spare_size_);
+}
+
 // create_map 函数
-template <class T>
-typename deque<T>::map_pointer deque<T>::create_map(size_type size)
+template <class T, class Alloc, size_t BufSize>
+typename deque<T, Alloc, BufSize>::map_pointer deque<T, Alloc, BufSize>::create_map(size_type size)
 {
     map_pointer mp = nullptr;
-    mp = map_allocator::allocate(size);
+    map_allocator map_alloc(this->get_alloc());
+    mp = map_alloc_traits::allocate(map_alloc, size);
     for(size_type i = 0; i < size; ++i)*(mp + i) = nullptr;
     return mp;
 }
 
+// destroy_map 函数
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::destroy_map(map_pointer mp, size_type size)
+{
+    map_allocator map_alloc(this->get_alloc());
+    map_alloc_traits::deallocate(map_alloc, mp, size);
+}
+
 // create_buffer 函数
-template <class T>
-void deque<T>::create_buffer(map_pointer nstart, map_pointer nfinish)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::create_buffer(map_pointer nstart, map_pointer nfinish)
 {
     map_pointer cur;
     try
     {
         for(cur = nstart; cur <= nfinish; ++cur)
         {
-            *cur = data_allocator::allocate(buffer_size);
+            *cur = allocate_buffer();
         }
     }
     catch(...)
@@ -860,7 +965,7 @@ void deque<T>::create_buffer(map_pointer nstart, map_pointer nfinish)
         while(cur != nstart)
         {
             --cur;
-            data_allocator::deallocate(*cur, buffer_size);
+            deallocate_buffer(*cur);
             *cur = nullptr;
         }
         throw;
@@ -868,19 +973,65 @@ void deque<T>::create_buffer(map_pointer nstart, map_pointer nfinish)
 }
 
 // destroy_buffer 函数
-template <class T>
-void deque<T>::destroy_buffer(map_pointer nstart, map_pointer nfinish)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::destroy_buffer(map_pointer nstart, map_pointer nfinish)
 {
     for(map_pointer cur = nstart; cur <= nfinish; ++cur)
     {
-        data_allocator::deallocate(*cur, buffer_size);
+        deallocate_buffer(*cur);
         *cur = nullptr;
     }
 }
 
+// destroy_range 函数
+// 析构 [first, last) 上的元素，区间可能跨越多个缓冲区，需要逐个缓冲区析构：
+// 头部缓冲区的 [cur, last)、中间的整个缓冲区、尾部缓冲区的 [first, cur)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::destroy_range(iterator first, iterator last) noexcept
+{
+    if(first.node == last.node)
+    {
+        data_alloc_traits::destroy(this->get_alloc(), first.cur, last.cur);
+        return;
+    }
+    data_alloc_traits::destroy(this->get_alloc(), first.cur, first.last);
+    for(map_pointer cur = first.node + 1; cur < last.node; ++cur)
+    {
+        data_alloc_traits::destroy(this->get_alloc(), *cur, *cur + buffer_size);
+    }
+    data_alloc_traits::destroy(this->get_alloc(), last.first, last.cur);
+}
+
+// allocate_buffer 函数，优先取用缓存的空闲缓冲区
+template <class T, class Alloc, size_t BufSize>
+typename deque<T, Alloc, BufSize>::pointer deque<T, Alloc, BufSize>::allocate_buffer()
+{
+    if(spare_size_ != 0)
+        return spare_[--spare_size_];
+    return data_alloc_traits::allocate(this->get_alloc(), buffer_size);
+}
+
+// deallocate_buffer 函数，缓存未满时留下缓冲区，否则归还给分配器
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::deallocate_buffer(pointer p) noexcept
+{
+    if(spare_size_ != DEQUE_SPARE_BUFFERS)
+        spare_[spare_size_++] = p;
+    else
+        data_alloc_traits::deallocate(this->get_alloc(), p, buffer_size);
+}
+
+// release_spare 函数，把缓存的空闲缓冲区全部归还给分配器
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::release_spare() noexcept
+{
+    while(spare_size_ != 0)
+        data_alloc_traits::deallocate(this->get_alloc(), spare_[--spare_size_], buffer_size);
+}
+
 // map_init 函数
-template <class T>
-void deque<T>::map_init(size_type nElem)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::map_init(size_type nElem)
 {
     const size_type nNode = nElem / buffer_size + 1;  // 需要分配的结点个数
     map_size_ = mystl::max(static_cast<size_type>(DEQUE_MAP_INIT_SIZE), nNode + 2);
@@ -903,7 +1054,7 @@ void deque<T>::map_init(size_type nElem)
     }
     catch(...)
     {
-        map_allocator::deallocate(map_, map_size_);
+        destroy_map(map_, map_size_);
         map_ = nullptr;
         map_size_ = 0;
         throw;
@@ -915,8 +1066,8 @@ void deque<T>::map_init(size_type nElem)
 }
 
 // fill_init 函数
-template <class T>
-void deque<T>::fill_init(size_type n, const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::fill_init(size_type n, const value_type& value)
 {
     map_init(n);
     if(n != 0)
@@ -930,18 +1081,18 @@ void deque<T>::fill_init(size_type n, const value_type& value)
 }
 
 // copy_init 函数
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class InputIterator>
-void deque<T>::copy_init(InputIterator first, InputIterator last, input_iterator_tag)
+void deque<T, Alloc, BufSize>::copy_init(InputIterator first, InputIterator last, input_iterator_tag)
 {
     const size_type n = mystl::distance(first, last);
     map_init(n);
     for(; first != last; ++first)emplace_back(*first);
 }
 
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class ForwardIterator>
-void deque<T>::copy_init(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+void deque<T, Alloc, BufSize>::copy_init(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
 {
     const size_type n = mystl::distance(first, last);
     map_init(n);
@@ -956,8 +1107,8 @@ void deque<T>::copy_init(ForwardIterator first, ForwardIterator last, forward_it
 }
 
 // fill_assign 函数
-template <class T>
-void deque<T>::fill_assign(size_type n, const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::fill_assign(size_type n, const value_type& value)
 {
     if(n > size())
     {
@@ -972,9 +1123,9 @@ void deque<T>::fill_assign(size_type n, const value_type& value)
 }
 
 // copy_assign 函数
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class InputIterator>
-void deque<T>::copy_assign(InputIterator first, InputIterator last, input_iterator_tag)
+void deque<T, Alloc, BufSize>::copy_assign(InputIterator first, InputIterator last, input_iterator_tag)
 {
     auto first1 = begin();
     auto last1 = end();
@@ -992,9 +1143,9 @@ void deque<T>::copy_assign(InputIterator first, InputIterator last, input_iterat
     }
 }
 
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class ForwardIterator>
-void deque<T>::copy_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+void deque<T, Alloc, BufSize>::copy_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
 {
     const size_type len1 = size();
     const size_type len2 = mystl::distance(first, last);
@@ -1012,9 +1163,9 @@ void deque<T>::copy_assign(ForwardIterator first, ForwardIterator last, forward_
 }
 
 // insert_aux 函数
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class... Args>
-typename deque<T>::iterator deque<T>::insert_aux(iterator pos, Args&&... args)
+typename deque<T, Alloc, BufSize>::iterator deque<T, Alloc, BufSize>::insert_aux(iterator pos, Args&&... args)
 {
     const size_type elems_before = pos - begin_;
     value_type value_copy = value_type(mystl::forward<Args>(args)...);
@@ -1045,8 +1196,8 @@ typename deque<T>::iterator deque<T>::insert_aux(iterator pos, Args&&... args)
 }
 
 // fill_insert 函数
-template <class T>
-void deque<T>::fill_insert(iterator pos, size_type n, const value_type& value)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::fill_insert(iterator pos, size_type n, const value_type& value)
 {
     const size_type elems_before = pos - begin_;
     const size_type len = size();
@@ -1123,9 +1274,9 @@ void deque<T>::fill_insert(iterator pos, size_type n, const value_type& value)
 }
 
 // copy_insert
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class ForwardIterator>
-void deque<T>::copy_insert(iterator pos, ForwardIterator first, ForwardIterator last, size_type n)
+void deque<T, Alloc, BufSize>::copy_insert(iterator pos, ForwardIterator first, ForwardIterator last, size_type n)
 {
     const size_type elems_before = pos - begin_;
     auto len = size();
@@ -1203,9 +1354,9 @@ void deque<T>::copy_insert(iterator pos, ForwardIterator first, ForwardIterator
 }
 
 // insert_dispatch 函数
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class InputIterator>
-void deque<T>::insert_dispatch(iterator pos, InputIterator first, InputIterator last, input_iterator_tag)
+void deque<T, Alloc, BufSize>::insert_dispatch(iterator pos, InputIterator first, InputIterator last, input_iterator_tag)
 {
     if(last <= first)return;
     const size_type n = mystl::distance(first, last);
@@ -1226,9 +1377,9 @@ void deque<T>::insert_dispatch(iterator pos, InputIterator first, InputIterator
     }
 }
 
-template <class T>
+template <class T, class Alloc, size_t BufSize>
 template <class ForwardIterator>
-void deque<T>::insert_dispatch(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+void deque<T, Alloc, BufSize>::insert_dispatch(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
 {
     if(last <= first)return;
     const size_type n = mystl::distance(first, last);
@@ -1272,12 +1423,12 @@ void deque<T>::insert_dispatch(iterator pos, ForwardIterator first, ForwardItera
 }
 
 // require_capacity 函数
-template <class T>
-void deque<T>::require_capacity(size_type n, bool front)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::require_capacity(size_type n, bool front)
 {
     if(front && (static_cast<size_type>(begin_.cur - begin_.first) < n))
     {
-        const size_type need_buffer = (n - (begin_.cur - begin_.first)) / buffer_size + 1;
+        const size_type need_buffer = (n - (begin_.cur - begin_.first) - 1) / buffer_size + 1;
         if(need_buffer > static_cast<size_type>(begin_.node - map_))
         {
             reallocate_map_at_front(need_buffer);
@@ -1287,7 +1438,7 @@ void deque<T>::require_capacity(size_type n, bool front)
     }
     else if(!front && (static_cast<size_type>(end_.last - end_.cur - 1) < n))
     {
-        const size_type need_buffer = (n - (end_.last - end_.cur - 1)) / buffer_size + 1;
+        const size_type need_buffer = (n - (end_.last - end_.cur - 1) - 1) / buffer_size + 1;
         if(need_buffer > static_cast<size_type>((map_ + map_size_) - end_.node - 1))
         {
             reallocate_map_at_back(need_buffer);
@@ -1298,26 +1449,30 @@ void deque<T>::require_capacity(size_type n, bool front)
 }
 
 // reallocate_map_at_front 函数
-template <class T>
-void deque<T>::reallocate_map_at_front(size_type need_buffer)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::reallocate_map_at_front(size_type need_buffer)
 {
-    const size_type new_map_size = mystl::max(map_size_ << 1, map_size_ + need_buffer + DEQUE_MAP_INIT_SIZE);
-    map_pointer new_map = create_map(new_map_size);
     const size_type old_buffer = end_.node - begin_.node + 1;
     const size_type new_buffer = old_buffer + need_buffer;
+    if(map_size_ > 2 * new_buffer)
+    {   // map 中大部分是空位，把缓冲区挪到中央即可，不必重新分配 map
+        auto mid = map_ + (map_size_ - new_buffer) / 2 + need_buffer;
+        recenter_map(mid);
+        create_buffer(mid - need_buffer, mid - 1);
+        return;
+    }
+    const size_type new_map_size = mystl::max(map_size_ << 1, map_size_ + need_buffer + DEQUE_MAP_INIT_SIZE);
+    map_pointer new_map = create_map(new_map_size);
 
-    // 另新的 map 中的指针指向原来的 buffer，并开辟新的 buffer
+    // 把原 map 中指向 buffer 的指针整块搬到新的 map，并开辟新的 buffer
     auto begin = new_map + (new_map_size - new_buffer) / 2;
     auto mid = begin + need_buffer;
     auto end = mid + old_buffer;
     create_buffer(begin, mid - 1);
-    for(auto begin1 = mid, begin2 = begin_.node; begin1 != end; ++begin1, ++begin2)
-    {
-        *begin1 = *begin2;
-    }
+    mystl::uninitialized_relocate(begin_.node, end_.node + 1, mid);
     
     // 更新数据
-    map_allocator::deallocate(map_, map_size_);  // 没有destroy吗？
+    destroy_map(map_, map_size_);
     map_ = new_map;
     map_size_ = new_map_size;
     begin_ = iterator(*mid + (begin_.cur - begin_.first), mid);
@@ -1325,77 +1480,113 @@ void deque<T>::reallocate_map_at_front(size_type need_buffer)
 }
 
 // reallocate_map_at_back 函数
-template <class T>
-void deque<T>::reallocate_map_at_back(size_type need_buffer)
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::reallocate_map_at_back(size_type need_buffer)
 {
-    const size_type new_map_size = mystl::max(map_size_ << 1, map_size_ + need_buffer + DEQUE_MAP_INIT_SIZE);
-    map_pointer new_map = create_map(new_map_size);
     const size_type old_buffer = end_.node - begin_.node + 1;
     const size_type new_buffer = old_buffer + need_buffer;
+    if(map_size_ > 2 * new_buffer)
+    {   // map 中大部分是空位，把缓冲区挪到中央即可，不必重新分配 map
+        auto begin = map_ + (map_size_ - new_buffer) / 2;
+        recenter_map(begin);
+        create_buffer(begin + old_buffer, begin + new_buffer - 1);
+        return;
+    }
+    const size_type new_map_size = mystl::max(map_size_ << 1, map_size_ + need_buffer + DEQUE_MAP_INIT_SIZE);
+    map_pointer new_map = create_map(new_map_size);
 
-    // 另新的 map 中的指针指向原来的 buffer，并开辟新的 buffer
+    // 把原 map 中指向 buffer 的指针整块搬到新的 map，并开辟新的 buffer
     auto begin = new_map + ((new_map_size - new_buffer) / 2);
     auto mid = begin + old_buffer;
     auto end = mid + need_buffer;
-    for(auto begin1 = begin, begin2 = begin_.node; begin1 != mid; ++begin1, ++begin2)
-    {
-        *begin1 = *begin2;
-    }
+    mystl::uninitialized_relocate(begin_.node, end_.node + 1, begin);
     create_buffer(mid, end - 1);
 
     // 更新数据
-    map_allocator::deallocate(map_, map_size_);
+    destroy_map(map_, map_size_);
     map_ = new_map;
     map_size_ = new_map_size;
     begin_ = iterator(*begin + (begin_.cur - begin_.first), begin);
     end_ = iterator(*(mid - 1) + (end_.cur - end_.first), mid - 1);
 }
 
+// recenter_map 函数，在原 map 中把 [begin_.node, end_.node] 上的缓冲区指针挪到以 nstart 开始的位置
+template <class T, class Alloc, size_t BufSize>
+void deque<T, Alloc, BufSize>::recenter_map(map_pointer nstart)
+{
+    const size_type old_buffer = end_.node - begin_.node + 1;
+    const auto nfinish = nstart + old_buffer;
+    if(nstart < begin_.node)
+        mystl::copy(begin_.node, end_.node + 1, nstart);
+    else
+        mystl::copy_backward(begin_.node, end_.node + 1, nfinish);
+    // 挪走之后留在原处的指针要清空，否则 shrink_to_fit 会重复释放
+    for(auto cur = map_; cur < nstart; ++cur)
+        *cur = nullptr;
+    for(auto cur = nfinish; cur < map_ + map_size_; ++cur)
+        *cur = nullptr;
+    begin_ = iterator(*nstart + (begin_.cur - begin_.first), nstart);
+    end_ = iterator(*(nfinish - 1) + (end_.cur - end_.first), nfinish - 1);
+}
+
 
 // 重载比较操作符
-template <class T>
-bool operator==(const deque<T>& lhs, const deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+bool operator==(const deque<T, Alloc, BufSize>& lhs, const deque<T, Alloc, BufSize>& rhs)
 {
     return lhs.size() == rhs.size() && mystl::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class T>
-bool operator<(const deque<T>& lhs, const deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+bool operator<(const deque<T, Alloc, BufSize>& lhs, const deque<T, Alloc, BufSize>& rhs)
 {
     return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template <class T>
-bool operator!=(const deque<T>& lhs, const deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+bool operator!=(const deque<T, Alloc, BufSize>& lhs, const deque<T, Alloc, BufSize>& rhs)
 {
     return !(lhs == rhs);
 }
 
-template <class T>
-bool operator>(const deque<T>& lhs, const deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+bool operator>(const deque<T, Alloc, BufSize>& lhs, const deque<T, Alloc, BufSize>& rhs)
 {
     return rhs < lhs;
 }
 
-template <class T>
-bool operator<=(const deque<T>& lhs, const deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+bool operator<=(const deque<T, Alloc, BufSize>& lhs, const deque<T, Alloc, BufSize>& rhs)
 {
     return !(rhs < lhs);
 }
 
-template <class T>
-bool operator>=(const deque<T>& lhs, const deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+bool operator>=(const deque<T, Alloc, BufSize>& lhs, const deque<T, Alloc, BufSize>& rhs)
 {
     return !(lhs < rhs);
 }
 
 // 重载 mystl 的 swap
-template <class T>
-void swap(deque<T>& lhs, deque<T>& rhs)
+template <class T, class Alloc, size_t BufSize>
+void swap(deque<T, Alloc, BufSize>& lhs, deque<T, Alloc, BufSize>& rhs)
 {
     lhs.swap(rhs);
 }
 
+// deque 的迭代器和 map 都指向堆上的空间，搬移 deque 对象本身不影响其中的元素
+template <class T, class Alloc, size_t BufSize>
+struct is_trivially_relocatable<deque<T, Alloc, BufSize>> : is_trivially_relocatable<Alloc> {};
+
+// 使用 pmr::polymorphic_allocator 的 deque，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <typename T>
+using deque = mystl::deque<T, polymorphic_allocator<T>>;
+} // namespace pmr
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_DEQUE_H_
\ No newline at end of file
@@ -0,0 +1,1148 @@
+#ifndef MYTINYSTL_FLAT_HASHTABLE_H_
+#define MYTINYSTL_FLAT_HASHTABLE_H_
+
+// 这个头文件包含了一个模板类 flat_hashtable
+// flat_hashtable : 开放定址的哈希表，元素直接存放在连续的槽位数组中，没有单独分配的节点
+//
+// 每个槽位对应一个控制字节，控制字节与槽位分开存放（SoA）：
+//   * 空槽位为 ctrl_empty
+//   * 占用的槽位保存哈希值的低 7 位（h2），取值 0 ~ 127
+//   * 槽位数组之后是一个哨兵 ctrl_sentinel，迭代器遇到它即停止
+// 查找时一次读取一组控制字节（SSE2 下 16 个，否则用 64 位整数模拟 8 个），同时筛出 h2 相同的槽位，
+// 只有筛出的槽位才去比较键值，不命中的查找一般不会访问槽位数组
+//
+// 探测以槽位为单位线性进行，逐组向后扫描，并维持以下性质：
+//   元素的起始位置（哈希值的高位）到它所在的位置之间没有空槽位
+// 因此查找遇到含有空槽位的组即可停止；删除时把同一簇中后面的元素向前回填，不需要墓碑标记
+// 容量总是 2^k - 1，加上哨兵恰好 2^k 个位置，取模只需一次按位与
+//
+// 与 hashtable 不同，插入引起扩容、删除引起回填时元素会在槽位之间搬移，迭代器、指针和引用都会失效
+
+#include <initializer_list>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MYSTL_FLAT_HASH_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "hashtable.h"
+#include "uninitialized.h"
+
+namespace mystl
+{
+
+namespace flat_detail
+{
+
+const signed char ctrl_empty    = -128;  // 空槽位
+const signed char ctrl_deleted  = -2;    // 只在删除后整理的过程中临时使用
+const signed char ctrl_sentinel = -1;    // 槽位数组的末尾
+
+inline int count_trailing_zeros(uint32_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(x);
+#elif defined(_MSC_VER)
+    unsigned long r;
+    _BitScanForward(&r, x);
+    return static_cast<int>(r);
+#else
+    int n = 0;
+    for(; (x & 1) == 0; x >>= 1)++n;
+    return n;
+#endif
+}
+
+inline int count_trailing_zeros(uint64_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long r;
+    _BitScanForward64(&r, x);
+    return static_cast<int>(r);
+#else
+    int n = 0;
+    for(; (x & 1) == 0; x >>= 1)++n;
+    return n;
+#endif
+}
+
+// 一组控制字节的匹配结果，每个匹配的槽位对应 2^Shift 位，从低位到高位依次对应组内的槽位
+template <class Word, int Shift>
+class bitmask
+{
+public:
+    explicit bitmask(Word m) noexcept : mask_(m) {}
+
+    explicit operator bool() const noexcept { return mask_ != 0; }
+
+    // 第一个匹配的槽位在组内的下标
+    size_t lowest() const noexcept
+    {
+        return static_cast<size_t>(count_trailing_zeros(mask_)) >> Shift;
+    }
+
+    void clear_lowest() noexcept { mask_ &= mask_ - 1; }
+
+private:
+    Word mask_;
+};
+
+#ifdef MYSTL_FLAT_HASH_SSE2
+
+// 一组 16 个控制字节，使用 SSE2 比较
+struct group
+{
+    enum : size_t { width = 16 };
+    typedef bitmask<uint32_t, 0> mask_type;
+
+    __m128i ctrl;
+
+    explicit group(const signed char* p) noexcept
+        :ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))
+    {
+    }
+
+    // h2 等于 tag 的槽位
+    mask_type match(signed char tag) const noexcept
+    {
+        return mask_type(static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl))));
+    }
+
+    mask_type match_empty() const noexcept
+    {
+        return match(ctrl_empty);
+    }
+
+    // 空槽位或删除标记，二者都小于哨兵
+    mask_type match_empty_or_deleted() const noexcept
+    {
+        return mask_type(static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl))));
+    }
+
+    // 占用的槽位或哨兵，迭代器用它跳过空槽位
+    mask_type match_full_or_sentinel() const noexcept
+    {
+        return mask_type(static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpgt_epi8(ctrl, _mm_set1_epi8(ctrl_deleted)))));
+    }
+};
+
+#else
+
+// 一组 8 个控制字节，用 64 位整数逐字节模拟 SIMD 比较，匹配结果是每个字节的最高位
+struct group
+{
+    enum : size_t { width = 8 };
+    typedef bitmask<uint64_t, 3> mask_type;
+
+    static constexpr uint64_t lsbs = 0x0101010101010101ull;
+    static constexpr uint64_t msbs = 0x8080808080808080ull;
+
+    uint64_t ctrl;
+
+    explicit group(const signed char* p) noexcept
+    {
+        std::memcpy(&ctrl, p, sizeof(ctrl));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        ctrl = __builtin_bswap64(ctrl);
+#endif
+    }
+
+    // 可能误报 tag 之后紧邻的占用槽位，调用者总会再比较键值，但不会把空槽位当作匹配
+    mask_type match(signed char tag) const noexcept
+    {
+        const uint64_t x = ctrl ^ (lsbs * static_cast<unsigned char>(tag));
+        return mask_type((x - lsbs) & ~x & msbs);
+    }
+
+    // 空槽位 0x80 是唯一最高位为 1 而第 6 位为 0 的控制字节
+    mask_type match_empty() const noexcept
+    {
+        return mask_type(ctrl & (~ctrl << 1) & msbs);
+    }
+
+    // 空槽位 0x80 与删除标记 0xFE 最高位为 1 且最低位为 0，哨兵 0xFF 的最低位为 1
+    mask_type match_empty_or_deleted() const noexcept
+    {
+        return mask_type(ctrl & (~ctrl << 7) & msbs);
+    }
+
+    mask_type match_full_or_sentinel() const noexcept
+    {
+        return mask_type(~(ctrl & (~ctrl << 7)) & msbs);
+    }
+};
+
+#endif
+
+// 空表共用的一组控制字节，第一个就是哨兵，因此空表的 begin() 等于 end()，查找读到空槽位后立即停止
+template <class = void>
+struct empty_group
+{
+    static const signed char value[16];
+};
+
+template <class V>
+const signed char empty_group<V>::value[16] = {
+    ctrl_sentinel, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty,
+    ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty, ctrl_empty
+};
+
+// 元素多半就在起始位置附近，读取控制字节的同时预取槽位，两次缓存缺失可以重叠
+template <class T>
+void prefetch(const T* p) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#elif defined(MYSTL_FLAT_HASH_SSE2)
+    _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+// 从 ctrl 开始跳过空槽位，停在占用的槽位或哨兵处
+template <class T>
+void skip_empty(signed char*& ctrl, T*& slot) noexcept
+{
+    while(*ctrl == ctrl_empty)
+    {
+        const auto m = group(ctrl).match_full_or_sentinel();
+        const size_t n = m ? m.lowest() : static_cast<size_t>(group::width);
+        ctrl += n;
+        slot += n;
+    }
+}
+
+} // namespace flat_detail
+
+// forward declaration
+
+template <class T, class Hash, class KeyEqual, class Alloc = mystl::allocator<T>>
+class flat_hashtable;
+
+template <class T>
+struct flat_ht_const_iterator;
+
+// flat_ht_iterator
+// 保存当前控制字节与槽位的位置，前进时跳过空槽位，遇到哨兵即为 end()
+template <class T>
+struct flat_ht_iterator : public mystl::iterator<mystl::forward_iterator_tag, T>
+{
+public:
+    typedef T                          value_type;
+    typedef value_type*                pointer;
+    typedef value_type&                reference;
+    typedef size_t                     size_type;
+    typedef ptrdiff_t                  difference_type;
+
+    typedef flat_ht_iterator<T>        self;
+
+    signed char* ctrl;
+    T*           slot;
+
+    flat_ht_iterator() noexcept : ctrl(nullptr), slot(nullptr) {}
+    flat_ht_iterator(signed char* c, T* s) noexcept : ctrl(c), slot(s) {}
+
+    reference operator*()  const { return *slot; }
+    pointer   operator->() const { return slot; }
+
+    self& operator++()
+    {
+        MYSTL_DEBUG(*ctrl != flat_detail::ctrl_sentinel);
+        ++ctrl;
+        ++slot;
+        flat_detail::skip_empty(ctrl, slot);
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator==(const self& rhs) const noexcept { return ctrl == rhs.ctrl; }
+    bool operator!=(const self& rhs) const noexcept { return ctrl != rhs.ctrl; }
+};
+
+template <class T>
+struct flat_ht_const_iterator : public mystl::iterator<mystl::forward_iterator_tag, T>
+{
+public:
+    typedef T                          value_type;
+    typedef const value_type*          pointer;
+    typedef const value_type&          reference;
+    typedef size_t                     size_type;
+    typedef ptrdiff_t                  difference_type;
+
+    typedef flat_ht_const_iterator<T>  self;
+
+    signed char* ctrl;
+    T*           slot;
+
+    flat_ht_const_iterator() noexcept : ctrl(nullptr), slot(nullptr) {}
+    flat_ht_const_iterator(signed char* c, T* s) noexcept : ctrl(c), slot(s) {}
+    flat_ht_const_iterator(const flat_ht_iterator<T>& rhs) noexcept : ctrl(rhs.ctrl), slot(rhs.slot) {}
+
+    reference operator*()  const { return *slot; }
+    pointer   operator->() const { return slot; }
+
+    self& operator++()
+    {
+        MYSTL_DEBUG(*ctrl != flat_detail::ctrl_sentinel);
+        ++ctrl;
+        ++slot;
+        flat_detail::skip_empty(ctrl, slot);
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator==(const self& rhs) const noexcept { return ctrl == rhs.ctrl; }
+    bool operator!=(const self& rhs) const noexcept { return ctrl != rhs.ctrl; }
+};
+
+template <class T>
+bool operator==(const flat_ht_iterator<T>& lhs, const flat_ht_const_iterator<T>& rhs) noexcept
+{ return lhs.ctrl == rhs.ctrl; }
+template <class T>
+bool operator!=(const flat_ht_iterator<T>& lhs, const flat_ht_const_iterator<T>& rhs) noexcept
+{ return lhs.ctrl != rhs.ctrl; }
+
+
+// 模板类 flat_hashtable
+// 参数一代表数据类型，参数二代表哈希函数，参数三代表键值相等的比较函数，参数四代表空间配置器
+// 键值不允许重复；控制字节数组与槽位数组分别通过重新绑定得到的分配器申请
+template <class T, class Hash, class KeyEqual, class Alloc>
+class flat_hashtable : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>>
+{
+public:
+    // flat_hashtable 的型别定义
+    typedef ht_value_traits<T>                          value_traits;
+    typedef typename value_traits::key_type             key_type;
+    typedef typename value_traits::mapped_type          mapped_type;
+    typedef typename value_traits::value_type           value_type;
+    typedef Hash                                        hasher;
+    typedef KeyEqual                                    key_equal;
+
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>           data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<signed char> ctrl_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef mystl::allocator_traits<ctrl_allocator>     ctrl_alloc_traits;
+    typedef data_allocator                              allocator_type;
+
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
+
+    typedef mystl::flat_ht_iterator<T>                  iterator;
+    typedef mystl::flat_ht_const_iterator<T>            const_iterator;
+
+    typedef flat_detail::group                          group;
+
+    allocator_type get_allocator() const { return this->get_alloc(); }
+
+private:
+    typedef mystl::alloc_holder<data_allocator>         alloc_base;
+
+    enum : size_type { min_capacity = 7 };
+
+    // 用以下参数来表现 flat_hashtable
+    signed char* ctrl_;         // capacity_ + group::width 个控制字节，哨兵之后复制开头的控制字节
+    pointer      slots_;        // capacity_ 个槽位
+    size_type    capacity_;     // 2^k - 1，空表为 0
+    size_type    size_;
+    size_type    growth_left_;  // 不扩容还能插入的元素个数
+    float        mlf_;
+    hasher       hash_;
+    key_equal    equal_;
+
+public:
+    // 构造、复制、移动、析构函数
+    // 空表不分配空间，第一次插入时才申请
+    explicit flat_hashtable(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                            const allocator_type& alloc = allocator_type())
+    : alloc_base(alloc), mlf_(0.875f), hash_(hash), equal_(equal)
+    {
+        init_empty();
+        if(bucket_count != 0)
+            resize(normalize_capacity(bucket_count));
+    }
+
+    flat_hashtable(const flat_hashtable& rhs)
+    : alloc_base(data_alloc_traits::select_on_container_copy_construction(rhs.get_alloc())),
+      mlf_(rhs.mlf_), hash_(rhs.hash_), equal_(rhs.equal_)
+    {
+        copy_init(rhs);
+    }
+    flat_hashtable(const flat_hashtable& rhs, const allocator_type& alloc)
+    : alloc_base(alloc), mlf_(rhs.mlf_), hash_(rhs.hash_), equal_(rhs.equal_)
+    {
+        copy_init(rhs);
+    }
+    flat_hashtable(flat_hashtable&& rhs) noexcept
+    : alloc_base(mystl::move(rhs.get_alloc())), ctrl_(rhs.ctrl_), slots_(rhs.slots_),
+      capacity_(rhs.capacity_), size_(rhs.size_), growth_left_(rhs.growth_left_),
+      mlf_(rhs.mlf_), hash_(rhs.hash_), equal_(rhs.equal_)
+    {
+        rhs.init_empty();
+    }
+
+    flat_hashtable& operator=(const flat_hashtable& rhs);
+    // 分配器不传播且不总是相等时，可能需要逐个移动元素，此时不保证 noexcept
+    flat_hashtable& operator=(flat_hashtable&& rhs)
+        noexcept(data_alloc_traits::propagate_on_container_move_assignment::value ||
+                 data_alloc_traits::is_always_equal::value);
+
+    ~flat_hashtable()
+    {
+        if(!data_alloc_traits::template can_skip_destroy<T>(this->get_alloc()))
+        {
+            destroy_slots();
+            free_storage(ctrl_, slots_, capacity_);
+        }
+    }
+
+    // 迭代器相关操作
+    iterator       begin()  noexcept       { return M_begin(); }
+    const_iterator begin()  const noexcept { return M_begin(); }
+    iterator       end()    noexcept       { return M_it(capacity_); }
+    const_iterator end()    const noexcept { return M_it(capacity_); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend()   const noexcept { return end(); }
+
+    // 容量相关操作
+    bool      empty() const noexcept { return size_ == 0; }
+    size_type size()  const noexcept { return size_; }
+    size_type max_size() const noexcept { return data_alloc_traits::max_size(this->get_alloc()); }
+
+    // 修改容器相关操作
+
+    // emplace：先构造出临时元素以取得键值，键值不存在时再把它移动到槽位中
+    template <class... Args>
+    pair<iterator, bool> emplace_unique(Args&&... args)
+    {
+        value_type tmp(mystl::forward<Args>(args)...);
+        return emplace_key(value_traits::get_key(tmp), mystl::move(tmp));
+    }
+
+    pair<iterator, bool> insert_unique(const value_type& value)
+    { return emplace_key(value_traits::get_key(value), value); }
+    pair<iterator, bool> insert_unique(value_type&& value)
+    { return emplace_key(value_traits::get_key(value), mystl::move(value)); }
+
+    template <class InputIter>
+    void insert_unique(InputIter first, InputIter last)
+    { copy_insert_unique(first, last, iterator_category(first)); }
+
+    // 以 key 查找，不存在时用 args 在槽位上直接构造元素，由 args 构造出的元素的键值必须等于 key
+    template <class... Args>
+    pair<iterator, bool> emplace_key(const key_type& key, Args&&... args);
+
+    // 以 key 查找，只有键值不存在时才用 args 构造 mapped_type，键值已经存在时 key 与 args 都不会被使用
+    template <class K, class... Args>
+    pair<iterator, bool> try_emplace_key(K&& key, Args&&... args);
+
+    // erase / clear
+    void erase(const_iterator pos);
+    void erase(const_iterator first, const_iterator last);
+
+    size_type erase_unique(const key_type& key);
+
+    void clear();
+
+    void swap(flat_hashtable& rhs) noexcept;
+
+    // 查找相关操作
+    size_type count(const key_type& key) const
+    { return find_index(key, hash_of(key)) == capacity_ ? 0 : 1; }
+
+    iterator       find(const key_type& key)
+    { return M_it(find_index(key, hash_of(key))); }
+    const_iterator find(const key_type& key) const
+    { return M_it(find_index(key, hash_of(key))); }
+
+    pair<iterator, iterator> equal_range_unique(const key_type& key)
+    {
+        auto it = find(key);
+        if(it == end())
+            return mystl::make_pair(it, it);
+        auto next = it;
+        return mystl::make_pair(it, ++next);
+    }
+    pair<const_iterator, const_iterator> equal_range_unique(const key_type& key) const
+    {
+        auto it = find(key);
+        if(it == end())
+            return mystl::make_pair(it, it);
+        auto next = it;
+        return mystl::make_pair(it, ++next);
+    }
+
+    // bucket interface，每个槽位相当于一个 bucket
+    size_type bucket_count() const noexcept
+    { return capacity_; }
+    size_type max_bucket_count() const noexcept
+    { return max_size(); }
+
+    // hash policy
+    float load_factor() const noexcept
+    { return capacity_ != 0 ? (float)size_ / capacity_ : 0.0f; }
+
+    float max_load_factor() const noexcept
+    { return mlf_; }
+    void max_load_factor(float ml)
+    {
+        THROW_OUT_OF_RANGE_IF(ml != ml || ml <= 0, "invalid hash load factor");
+        mlf_ = ml;
+        if(size_ > growth_limit(capacity_))
+            resize(capacity_for(size_));
+        else
+            growth_left_ = growth_limit(capacity_) - size_;
+    }
+
+    void rehash(size_type count);
+
+    void reserve(size_type count)
+    { rehash(capacity_for(count)); }
+
+    hasher    hash_fcn() const { return hash_; }
+    key_equal key_eq()   const { return equal_; }
+
+    bool equal_to_unique(const flat_hashtable& rhs) const;
+
+private:
+    // flat_hashtable 成员函数
+
+    iterator M_it(size_type i) noexcept
+    { return iterator(ctrl_ + i, slots_ + i); }
+    const_iterator M_it(size_type i) const noexcept
+    { return const_iterator(ctrl_ + i, slots_ + i); }
+
+    iterator M_begin() noexcept
+    {
+        iterator it = M_it(0);
+        flat_detail::skip_empty(it.ctrl, it.slot);
+        return it;
+    }
+    const_iterator M_begin() const noexcept
+    {
+        const_iterator it = M_it(0);
+        flat_detail::skip_empty(it.ctrl, it.slot);
+        return it;
+    }
+
+    // hash
+    // 先把哈希函数的结果再混合一次：mystl::hash 对整数直接返回其值，不混合的话连续的键值会挤在一起，
+    // 也会得到相同的 h2
+    size_t hash_of(const key_type& key) const
+    {
+        return static_cast<size_t>(hash_detail::mix(static_cast<uint64_t>(hash_(key)), 0x9e3779b97f4a7c15ull));
+    }
+    static size_type   h1(size_t h) noexcept { return static_cast<size_type>(h >> 7); }
+    static signed char h2(size_t h) noexcept { return static_cast<signed char>(h & 0x7f); }
+
+    size_type find_index(const key_type& key, size_t h) const;
+    pair<size_type, bool> find_or_prepare_insert(const key_type& key, size_t h) const;
+    size_type find_first_non_full(size_t h) const noexcept;
+    pair<size_type, bool> prepare_insert(const key_type& key, size_t h);
+    void commit_insert(size_type i, size_t h) noexcept;
+
+    // ctrl
+    void set_ctrl(size_type i, signed char c) noexcept;
+    void reset_ctrl() noexcept;
+
+    // storage
+    void      init_empty() noexcept;
+    void      copy_init(const flat_hashtable& rhs);
+    void      resize(size_type new_cap);
+    void      destroy_slots() noexcept;
+    void      free_storage(signed char* ctrl, pointer slots, size_type cap) noexcept;
+
+    size_type growth_limit(size_type cap) const noexcept;
+    size_type capacity_for(size_type n) const noexcept;
+    static size_type normalize_capacity(size_type n) noexcept;
+
+    // erase
+    void erase_at(size_type i);
+    void compact(size_type start, bool stop_at_empty);
+    void reposition(size_type i);
+
+    // insert
+    template <class InputIter>
+    void copy_insert_unique(InputIter first, InputIter last, mystl::input_iterator_tag);
+    template <class ForwardIter>
+    void copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag);
+
+    void swap_data(flat_hashtable& rhs) noexcept;
+};
+
+/*****************************************************************************************/
+
+// 复制赋值运算符
+template <class T, class Hash, class KeyEqual, class Alloc>
+flat_hashtable<T, Hash, KeyEqual, Alloc>&
+flat_hashtable<T, Hash, KeyEqual, Alloc>::operator=(const flat_hashtable& rhs)
+{
+    if(this != &rhs)
+    {
+        // 需要传播分配器时用 rhs 的分配器复制，tmp 换回原分配器以释放原有空间
+        flat_hashtable tmp(rhs, data_alloc_traits::propagate_on_container_copy_assignment::value
+                                ? rhs.get_alloc() : this->get_alloc());
+        swap_data(tmp);
+        mystl::swap(this->get_alloc(), tmp.get_alloc());
+    }
+    return *this;
+}
+
+// 移动赋值运算符
+template <class T, class Hash, class KeyEqual, class Alloc>
+flat_hashtable<T, Hash, KeyEqual, Alloc>&
+flat_hashtable<T, Hash, KeyEqual, Alloc>::operator=(flat_hashtable&& rhs)
+    noexcept(data_alloc_traits::propagate_on_container_move_assignment::value ||
+             data_alloc_traits::is_always_equal::value)
+{
+    if(this == &rhs)return *this;
+    if(data_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
+    {
+        flat_hashtable tmp(mystl::move(rhs));
+        swap_data(tmp);
+        if(data_alloc_traits::propagate_on_container_move_assignment::value)
+            mystl::swap(this->get_alloc(), tmp.get_alloc());
+    }
+    else
+    {
+        // 分配器不相等且不传播时，只能逐个移动元素
+        clear();
+        hash_ = rhs.hash_;
+        equal_ = rhs.equal_;
+        mlf_ = rhs.mlf_;
+        reserve(rhs.size_);
+        for(auto it = rhs.begin(); it != rhs.end(); ++it)
+            emplace_key(value_traits::get_key(*it), mystl::move(*it));
+        rhs.clear();
+    }
+    return *this;
+}
+
+// 以 key 查找，不存在时在探测停下的空槽位上构造元素
+// 强异常安全保证：构造失败时控制字节尚未修改
+template <class T, class Hash, class KeyEqual, class Alloc>
+template <class... Args>
+pair<typename flat_hashtable<T, Hash, KeyEqual, Alloc>::iterator, bool>
+flat_hashtable<T, Hash, KeyEqual, Alloc>::emplace_key(const key_type& key, Args&&... args)
+{
+    const size_t h = hash_of(key);
+    auto res = prepare_insert(key, h);
+    if(res.second)
+        return mystl::make_pair(M_it(res.first), false);
+    data_alloc_traits::construct(this->get_alloc(), slots_ + res.first, mystl::forward<Args>(args)...);
+    commit_insert(res.first, h);
+    return mystl::make_pair(M_it(res.first), true);
+}
+
+// 与 emplace_key 相同，但 mapped_type 只在确定要插入时才构造
+template <class T, class Hash, class KeyEqual, class Alloc>
+template <class K, class... Args>
+pair<typename flat_hashtable<T, Hash, KeyEqual, Alloc>::iterator, bool>
+flat_hashtable<T, Hash, KeyEqual, Alloc>::try_emplace_key(K&& key, Args&&... args)
+{
+    const size_t h = hash_of(key);
+    auto res = prepare_insert(key, h);
+    if(res.second)
+        return mystl::make_pair(M_it(res.first), false);
+    data_alloc_traits::construct(this->get_alloc(), slots_ + res.first, mystl::forward<K>(key),
+                                 mapped_type(mystl::forward<Args>(args)...));
+    commit_insert(res.first, h);
+    return mystl::make_pair(M_it(res.first), true);
+}
+
+// 查找 key，找到时返回 (位置, true)；否则在必要时扩容，返回 (可插入的空槽位, false)
+template <class T, class Hash, class KeyEqual, class Alloc>
+pair<typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type, bool>
+flat_hashtable<T, Hash, KeyEqual, Alloc>::prepare_insert(const key_type& key, size_t h)
+{
+    auto res = find_or_prepare_insert(key, h);
+    if(!res.second && growth_left_ == 0)
+    {
+        resize(capacity_for(size_ + 1));
+        res.first = find_first_non_full(h);
+    }
+    return res;
+}
+
+// 槽位 i 上的元素已构造完成，写入控制字节并更新计数
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::commit_insert(size_type i, size_t h) noexcept
+{
+    set_ctrl(i, h2(h));
+    ++size_;
+    --growth_left_;
+}
+
+// 删除迭代器所指的元素
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::erase(const_iterator pos)
+{
+    MYSTL_DEBUG(pos != end());
+    erase_at(static_cast<size_type>(pos.ctrl - ctrl_));
+}
+
+// 删除[first, last)内的元素
+// 先析构全部元素并标记为删除，再从一个原本就为空的槽位开始整理一遍
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::erase(const_iterator first, const_iterator last)
+{
+    if(first == last)return;
+    if(first == begin() && last == end())
+    {
+        clear();
+        return;
+    }
+    // 元素个数不超过 capacity_ - 1，总有一个空槽位，从它之后开始整理就不会遗漏跨越数组末尾的簇
+    size_type start = 0;
+    while(ctrl_[start] != flat_detail::ctrl_empty)
+        ++start;
+    while(first != last)
+    {
+        const auto i = static_cast<size_type>(first.ctrl - ctrl_);
+        ++first;
+        data_alloc_traits::destroy(this->get_alloc(), slots_ + i);
+        set_ctrl(i, flat_detail::ctrl_deleted);
+        --size_;
+        ++growth_left_;
+    }
+    compact(start, false);
+}
+
+// 删除键值为 key 的元素
+template <class T, class Hash, class KeyEqual, class Alloc>
+typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type
+flat_hashtable<T, Hash, KeyEqual, Alloc>::erase_unique(const key_type& key)
+{
+    const auto i = find_index(key, hash_of(key));
+    if(i == capacity_)
+        return 0;
+    erase_at(i);
+    return 1;
+}
+
+// 清空 flat_hashtable，保留已申请的空间
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::clear()
+{
+    if(size_ != 0)
+    {
+        destroy_slots();
+        reset_ctrl();
+        size_ = 0;
+    }
+    growth_left_ = growth_limit(capacity_);
+}
+
+// 交换两个 flat_hashtable
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::swap(flat_hashtable& rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
+    }
+}
+
+// 重新选择容量，至少为 count 且能容纳现有元素
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::rehash(size_type count)
+{
+    if(count == 0 && size_ == 0)
+    {
+        free_storage(ctrl_, slots_, capacity_);
+        init_empty();
+        return;
+    }
+    const auto n = mystl::max(normalize_capacity(count), capacity_for(size_));
+    if(n != capacity_)
+        resize(n);
+}
+
+// 两个表的元素相同（与顺序无关）
+template <class T, class Hash, class KeyEqual, class Alloc>
+bool flat_hashtable<T, Hash, KeyEqual, Alloc>::equal_to_unique(const flat_hashtable& rhs) const
+{
+    if(size_ != rhs.size_)return false;
+    for(auto first = begin(), last = end(); first != last; ++first)
+    {
+        auto res = rhs.find(value_traits::get_key(*first));
+        if(res == rhs.end() || !(*res == *first))return false;
+    }
+    return true;
+}
+
+/*****************************************************************************************/
+// helper function
+
+// 查找 key 所在的槽位，不存在时返回 capacity_
+template <class T, class Hash, class KeyEqual, class Alloc>
+typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type
+flat_hashtable<T, Hash, KeyEqual, Alloc>::find_index(const key_type& key, size_t h) const
+{
+    const signed char tag = h2(h);
+    size_type pos = h1(h) & capacity_;
+    flat_detail::prefetch(slots_ + pos);
+    for(;;)
+    {
+        group g(ctrl_ + pos);
+        for(auto m = g.match(tag); m; m.clear_lowest())
+        {
+            const size_type i = (pos + m.lowest()) & capacity_;
+            if(equal_(value_traits::get_key(slots_[i]), key))
+                return i;
+        }
+        if(g.match_empty())
+            return capacity_;
+        pos = (pos + group::width) & capacity_;
+    }
+}
+
+// 查找 key，找到时返回其槽位和 true；否则返回探测停下的组内第一个空槽位和 false
+// 由于起始位置到该组之间没有空槽位，这个空槽位就是插入 key 的位置
+template <class T, class Hash, class KeyEqual, class Alloc>
+pair<typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type, bool>
+flat_hashtable<T, Hash, KeyEqual, Alloc>::find_or_prepare_insert(const key_type& key, size_t h) const
+{
+    const signed char tag = h2(h);
+    size_type pos = h1(h) & capacity_;
+    flat_detail::prefetch(slots_ + pos);
+    for(;;)
+    {
+        group g(ctrl_ + pos);
+        for(auto m = g.match(tag); m; m.clear_lowest())
+        {
+            const size_type i = (pos + m.lowest()) & capacity_;
+            if(equal_(value_traits::get_key(slots_[i]), key))
+                return mystl::make_pair(i, true);
+        }
+        const auto e = g.match_empty();
+        if(e)
+            return mystl::make_pair((pos + e.lowest()) & capacity_, false);
+        pos = (pos + group::width) & capacity_;
+    }
+}
+
+// 从哈希值的起始位置开始，找到第一个空槽位（整理过程中也包括删除标记）
+template <class T, class Hash, class KeyEqual, class Alloc>
+typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type
+flat_hashtable<T, Hash, KeyEqual, Alloc>::find_first_non_full(size_t h) const noexcept
+{
+    size_type pos = h1(h) & capacity_;
+    for(;;)
+    {
+        const auto m = group(ctrl_ + pos).match_empty_or_deleted();
+        if(m)
+            return (pos + m.lowest()) & capacity_;
+        pos = (pos + group::width) & capacity_;
+    }
+}
+
+// 设置第 i 个控制字节，同时更新哨兵之后复制的部分，使得从任何位置读取一组都不必回绕
+// 容量小于一组时复制的部分会重复多遍
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::set_ctrl(size_type i, signed char c) noexcept
+{
+    ctrl_[i] = c;
+    for(size_type j = i + capacity_ + 1; j < capacity_ + group::width; j += capacity_ + 1)
+        ctrl_[j] = c;
+}
+
+// 把所有控制字节置为空，再放置哨兵及其副本
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::reset_ctrl() noexcept
+{
+    std::memset(ctrl_, static_cast<unsigned char>(flat_detail::ctrl_empty), capacity_ + group::width);
+    for(size_type j = capacity_; j < capacity_ + group::width; j += capacity_ + 1)
+        ctrl_[j] = flat_detail::ctrl_sentinel;
+}
+
+// 空表指向共用的控制字节，不分配空间
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::init_empty() noexcept
+{
+    ctrl_ = const_cast<signed char*>(flat_detail::empty_group<>::value);
+    slots_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+}
+
+// copy_init 函数
+// 哈希函数相同，元素放在与 rhs 相同的槽位上，控制字节直接复制
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::copy_init(const flat_hashtable& rhs)
+{
+    init_empty();
+    if(rhs.size_ == 0)
+        return;
+    THROW_LENGTH_ERROR_IF(rhs.capacity_ > max_size(), "flat_hashtable<T>'s size too big");
+    ctrl_allocator ctrl_alloc(this->get_alloc());
+    signed char* ctrl = ctrl_alloc_traits::allocate(ctrl_alloc, rhs.capacity_ + group::width);
+    pointer slots = nullptr;
+    size_type i = 0;
+    try
+    {
+        slots = data_alloc_traits::allocate(this->get_alloc(), rhs.capacity_);
+        for(; i < rhs.capacity_; ++i)
+        {
+            if(rhs.ctrl_[i] >= 0)
+                data_alloc_traits::construct(this->get_alloc(), slots + i, rhs.slots_[i]);
+        }
+    }
+    catch(...)
+    {
+        for(size_type j = 0; j < i; ++j)
+        {
+            if(rhs.ctrl_[j] >= 0)
+                data_alloc_traits::destroy(this->get_alloc(), slots + j);
+        }
+        data_alloc_traits::deallocate(this->get_alloc(), slots, rhs.capacity_);
+        ctrl_alloc_traits::deallocate(ctrl_alloc, ctrl, rhs.capacity_ + group::width);
+        throw;
+    }
+    std::memcpy(ctrl, rhs.ctrl_, rhs.capacity_ + group::width);
+    ctrl_ = ctrl;
+    slots_ = slots;
+    capacity_ = rhs.capacity_;
+    size_ = rhs.size_;
+    growth_left_ = growth_limit(capacity_) - size_;
+}
+
+// resize 函数
+// 申请 new_cap 个槽位，把原有元素逐个搬到新表中的位置，可平凡重定位的元素直接复制内存
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::resize(size_type new_cap)
+{
+    THROW_LENGTH_ERROR_IF(new_cap > max_size(), "flat_hashtable<T>'s size too big");
+    ctrl_allocator ctrl_alloc(this->get_alloc());
+    signed char* ctrl = ctrl_alloc_traits::allocate(ctrl_alloc, new_cap + group::width);
+    pointer slots = nullptr;
+    try
+    {
+        slots = data_alloc_traits::allocate(this->get_alloc(), new_cap);
+    }
+    catch(...)
+    {
+        ctrl_alloc_traits::deallocate(ctrl_alloc, ctrl, new_cap + group::width);
+        throw;
+    }
+    signed char* old_ctrl = ctrl_;
+    pointer      old_slots = slots_;
+    size_type    old_cap = capacity_;
+    ctrl_ = ctrl;
+    slots_ = slots;
+    capacity_ = new_cap;
+    reset_ctrl();
+    for(size_type i = 0; i < old_cap; ++i)
+    {
+        if(old_ctrl[i] >= 0)
+        {
+            const size_t h = hash_of(value_traits::get_key(old_slots[i]));
+            const size_type pos = find_first_non_full(h);
+            mystl::uninitialized_relocate(old_slots + i, old_slots + i + 1, slots_ + pos);
+            set_ctrl(pos, h2(h));
+        }
+    }
+    growth_left_ = growth_limit(capacity_) - size_;
+    free_storage(old_ctrl, old_slots, old_cap);
+}
+
+// 析构所有元素，不修改控制字节
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::destroy_slots() noexcept
+{
+    if(std::is_trivially_destructible<T>::value)
+        return;
+    for(size_type i = 0; i < capacity_; ++i)
+    {
+        if(ctrl_[i] >= 0)
+            data_alloc_traits::destroy(this->get_alloc(), slots_ + i);
+    }
+}
+
+// 释放控制字节与槽位的空间，空表共用的控制字节不释放
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::
+free_storage(signed char* ctrl, pointer slots, size_type cap) noexcept
+{
+    if(cap == 0)
+        return;
+    ctrl_allocator ctrl_alloc(this->get_alloc());
+    ctrl_alloc_traits::deallocate(ctrl_alloc, ctrl, cap + group::width);
+    data_alloc_traits::deallocate(this->get_alloc(), slots, cap);
+}
+
+// 容量为 cap 时最多容纳的元素个数，至少留一个空槽位使查找总能停下
+template <class T, class Hash, class KeyEqual, class Alloc>
+typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type
+flat_hashtable<T, Hash, KeyEqual, Alloc>::growth_limit(size_type cap) const noexcept
+{
+    if(cap == 0)
+        return 0;
+    return mystl::min(cap - 1, static_cast<size_type>((float)cap * mlf_));
+}
+
+// 能容纳 n 个元素的最小容量
+template <class T, class Hash, class KeyEqual, class Alloc>
+typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type
+flat_hashtable<T, Hash, KeyEqual, Alloc>::capacity_for(size_type n) const noexcept
+{
+    if(n == 0)
+        return 0;
+    size_type cap = min_capacity;
+    while(growth_limit(cap) < n)
+        cap = cap * 2 + 1;
+    return cap;
+}
+
+// 不小于 n 的 2^k - 1
+template <class T, class Hash, class KeyEqual, class Alloc>
+typename flat_hashtable<T, Hash, KeyEqual, Alloc>::size_type
+flat_hashtable<T, Hash, KeyEqual, Alloc>::normalize_capacity(size_type n) noexcept
+{
+    if(n == 0)
+        return 0;
+    size_type cap = min_capacity;
+    while(cap < n)
+        cap = cap * 2 + 1;
+    return cap;
+}
+
+// 删除第 i 个槽位上的元素，然后整理它所在的簇
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::erase_at(size_type i)
+{
+    data_alloc_traits::destroy(this->get_alloc(), slots_ + i);
+    set_ctrl(i, flat_detail::ctrl_deleted);
+    --size_;
+    ++growth_left_;
+    compact(i, true);
+}
+
+// compact 函数
+// 从 start 开始沿探测方向依次检查元素，位于删除标记之后的元素若能移到更靠近起始位置的空槽位就向前回填，
+// 回填留下的槽位同样标记为删除，最后把经过的删除标记都换成空槽位
+// stop_at_empty 为 true 时遇到删除标记之后的第一个空槽位即停止，否则检查整张表
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::compact(size_type start, bool stop_at_empty)
+{
+    bool dirty = false;
+    size_type i = start;
+    size_type n = 0;
+    for(; n <= capacity_; ++n, i = (i + 1) & capacity_)
+    {
+        const signed char c = ctrl_[i];
+        if(c == flat_detail::ctrl_empty)
+        {
+            if(stop_at_empty && dirty)
+                break;
+            dirty = false;
+        }
+        else if(c == flat_detail::ctrl_deleted)
+        {
+            dirty = true;
+        }
+        else if(c >= 0 && dirty)
+        {
+            reposition(i);
+        }
+    }
+    for(i = start; n > 0; --n, i = (i + 1) & capacity_)
+    {
+        if(ctrl_[i] == flat_detail::ctrl_deleted)
+            set_ctrl(i, flat_detail::ctrl_empty);
+    }
+}
+
+// 第 i 个槽位上的元素的探测路径上若有空槽位，把它搬到第一个空槽位
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::reposition(size_type i)
+{
+    const size_t h = hash_of(value_traits::get_key(slots_[i]));
+    const size_type home = h1(h) & capacity_;
+    const size_type pos = find_first_non_full(h);
+    if(((pos - home) & capacity_) < ((i - home) & capacity_))
+    {
+        mystl::uninitialized_relocate(slots_ + i, slots_ + i + 1, slots_ + pos);
+        set_ctrl(pos, ctrl_[i]);
+        set_ctrl(i, flat_detail::ctrl_deleted);
+    }
+}
+
+// copy_insert_unique
+template <class T, class Hash, class KeyEqual, class Alloc>
+template <class InputIter>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::
+copy_insert_unique(InputIter first, InputIter last, mystl::input_iterator_tag)
+{
+    for(; first != last; ++first)
+        insert_unique(*first);
+}
+
+template <class T, class Hash, class KeyEqual, class Alloc>
+template <class ForwardIter>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::
+copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag)
+{
+    reserve(size_ + static_cast<size_type>(mystl::distance(first, last)));
+    for(; first != last; ++first)
+        insert_unique(*first);
+}
+
+// swap_data 函数，不交换分配器
+template <class T, class Hash, class KeyEqual, class Alloc>
+void flat_hashtable<T, Hash, KeyEqual, Alloc>::swap_data(flat_hashtable& rhs) noexcept
+{
+    mystl::swap(ctrl_, rhs.ctrl_);
+    mystl::swap(slots_, rhs.slots_);
+    mystl::swap(capacity_, rhs.capacity_);
+    mystl::swap(size_, rhs.size_);
+    mystl::swap(growth_left_, rhs.growth_left_);
+    mystl::swap(mlf_, rhs.mlf_);
+    mystl::swap(hash_, rhs.hash_);
+    mystl::swap(equal_, rhs.equal_);
+}
+
+// 重载 mystl 的 swap
+template <class T, class Hash, class KeyEqual, class Alloc>
+void swap(flat_hashtable<T, Hash, KeyEqual, Alloc>& lhs, flat_hashtable<T, Hash, KeyEqual, Alloc>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+// 控制字节与槽位都在堆上，空表指向的共用控制字节也与对象地址无关
+template <class T, class Hash, class KeyEqual, class Alloc>
+struct is_trivially_relocatable<flat_hashtable<T, Hash, KeyEqual, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Hash>::value &&
+                      is_trivially_relocatable<KeyEqual>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+} // namespace mystl
+#endif // !MYTINYSTL_FLAT_HASHTABLE_H_
@@ -0,0 +1,1149 @@
+#ifndef MYTINYSTL_FLAT_MAP_H_
+#define MYTINYSTL_FLAT_MAP_H_
+
+// 这个头文件包含两个模板类 flat_map 和 flat_multimap
+// 功能与用法与 map / multimap 相同，底层使用两个按键值有序的 mystl::vector，分别存放键值与实值，
+// 查找时只在连续的键值数组上二分，适合构造一次之后大量查找的场合
+
+// notes:
+//
+// 与 map / multimap 的区别：
+//   * 单个元素的插入与删除需要搬移其后的所有元素，复杂度为 O(n)，大量插入时应使用区间版本，
+//     区间插入先把新元素追加到尾部，排序去重后与原有元素归并，复杂度为 O(n + m log m)
+//   * 插入与删除会使所有的迭代器、指针和引用失效，erase 返回指向下一个元素的迭代器
+//   * 键值与实值分开存放，value_type 为 pair<Key, T>，迭代器解引用得到 pair<const Key&, T&>，
+//     operator-> 返回一个代理对象，it->first、it->second 的用法不变
+//   * keys() 与 values() 返回底层的两个数组，reserve 与 shrink_to_fit 作用于两个数组
+//   * 不提供节点句柄与 merge
+//
+// 异常保证：
+// mystl::flat_map<Key, T> / mystl::flat_multimap<Key, T> 满足基本异常保证，对以下等函数做强异常安全保证：
+//   * emplace
+//   * emplace_hint
+//   * insert
+// 元素的移动构造函数与移动赋值不应抛出异常
+
+#include <initializer_list>
+
+#include "vector.h"
+#include "algo.h"
+#include "functional.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// flat_map 迭代器的 operator-> 返回的代理对象，保存解引用得到的 pair
+template <class Reference>
+struct flat_map_arrow_proxy
+{
+    Reference ref;
+
+    explicit flat_map_arrow_proxy(const Reference& r) : ref(r) {}
+
+    Reference* operator->() { return &ref; }
+};
+
+// flat_map 的迭代器，同时指向键值数组与实值数组中的同一位置
+// MappedPtr 为 T* 时是 iterator，为 const T* 时是 const_iterator
+template <class Key, class T, class MappedPtr>
+struct flat_map_iterator
+{
+    typedef typename std::remove_pointer<MappedPtr>::type&        mapped_ref;
+
+    typedef random_access_iterator_tag                            iterator_category;
+    typedef mystl::pair<Key, T>                                   value_type;
+    typedef mystl::pair<const Key&, mapped_ref>                   reference;
+    typedef flat_map_arrow_proxy<reference>                       pointer;
+    typedef ptrdiff_t                                             difference_type;
+    typedef flat_map_iterator<Key, T, MappedPtr>                  self;
+
+    const Key* kp;  // 指向键值
+    MappedPtr  mp;  // 指向实值
+
+    flat_map_iterator() : kp(nullptr), mp(nullptr) {}
+    flat_map_iterator(const Key* k, MappedPtr m) : kp(k), mp(m) {}
+
+    // iterator 可以转换为 const_iterator
+    template <class P, typename std::enable_if<
+        !std::is_same<P, MappedPtr>::value && std::is_convertible<P, MappedPtr>::value, int>::type = 0>
+    flat_map_iterator(const flat_map_iterator<Key, T, P>& rhs) : kp(rhs.kp), mp(rhs.mp) {}
+
+    reference operator*()  const { return reference(*kp, *mp); }
+    pointer   operator->() const { return pointer(operator*()); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    self& operator++()
+    {
+        ++kp;
+        ++mp;
+        return *this;
+    }
+    self operator++(int)
+    {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self& operator--()
+    {
+        --kp;
+        --mp;
+        return *this;
+    }
+    self operator--(int)
+    {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    self& operator+=(difference_type n)
+    {
+        kp += n;
+        mp += n;
+        return *this;
+    }
+    self operator+(difference_type n) const
+    {
+        self tmp = *this;
+        return tmp += n;
+    }
+    self& operator-=(difference_type n)
+    {
+        return *this += -n;
+    }
+    self operator-(difference_type n) const
+    {
+        self tmp = *this;
+        return tmp -= n;
+    }
+
+    difference_type operator-(const self& rhs) const { return kp - rhs.kp; }
+
+    bool operator==(const self& rhs) const { return kp == rhs.kp; }
+    bool operator!=(const self& rhs) const { return kp != rhs.kp; }
+    bool operator< (const self& rhs) const { return kp < rhs.kp; }
+    bool operator> (const self& rhs) const { return rhs.kp < kp; }
+    bool operator<=(const self& rhs) const { return !(rhs.kp < kp); }
+    bool operator>=(const self& rhs) const { return !(kp < rhs.kp); }
+};
+
+template <class Key, class T, class MappedPtr>
+flat_map_iterator<Key, T, MappedPtr>
+operator+(ptrdiff_t n, const flat_map_iterator<Key, T, MappedPtr>& it)
+{
+    return it + n;
+}
+
+// flat_map 与 flat_multimap 共用的区间插入操作
+// 新元素已经追加在 [old, size) 上，先按键值排序（键值相等时保持追加的次序），unique 为 true 时
+// 只保留每组相等键值中最先出现的一个，再与 [0, old) 上的原有元素归并，原有元素排在相等的新元素之前，
+// unique 为 true 时与原有元素键值相同的新元素被丢弃
+template <class KeyContainer, class MappedContainer, class Compare>
+void flat_map_sort_merge(KeyContainer& keys, MappedContainer& values, const Compare& comp,
+                         size_t old, bool unique)
+{
+    typedef size_t                                       size_type;
+    typedef typename KeyContainer::value_type            key_type;
+    typedef mystl::pair<key_type, size_type>             keyed_type;
+    const size_type n = keys.size();
+    if(n == old)
+        return;
+
+    // 新元素本身有序且都排在原有元素之后时不需要调整，已经有序的数据构造时只需要一次检查
+    bool sorted = old == 0 || (unique ? comp(keys[old - 1], keys[old]) : !comp(keys[old], keys[old - 1]));
+    for(size_type i = old + 1; sorted && i < n; ++i)
+        sorted = unique ? comp(keys[i - 1], keys[i]) : !comp(keys[i], keys[i - 1]);
+    if(sorted)
+        return;
+
+    // 把新的键值连同它原来的下标移到一个数组中排序，比较时不必再经由下标访问键值数组，
+    // 实值只在归并时按下标取一次
+    struct keyed_less
+    {
+        const Compare* c;
+        bool operator()(const keyed_type& a, const keyed_type& b) const
+        {
+            return (*c)(a.first, b.first) || (!(*c)(b.first, a.first) && a.second < b.second);
+        }
+    };
+    struct keyed_equal
+    {
+        const Compare* c;
+        bool operator()(const keyed_type& a, const keyed_type& b) const
+        {   // 已经有序，a 在 b 之前
+            return !(*c)(a.first, b.first);
+        }
+    };
+
+    try
+    {
+        mystl::vector<keyed_type> batch;
+        batch.reserve(n - old);
+        for(size_type i = old; i < n; ++i)
+            batch.emplace_back(mystl::move(keys[i]), i);
+        mystl::sort(batch.begin(), batch.end(), keyed_less{&comp});
+        if(unique)
+            batch.erase(mystl::unique(batch.begin(), batch.end(), keyed_equal{&comp}), batch.end());
+
+        KeyContainer    new_keys(keys.get_allocator());
+        MappedContainer new_values(values.get_allocator());
+        new_keys.reserve(old + batch.size());
+        new_values.reserve(old + batch.size());
+        size_type i = 0, j = 0;
+        while(i < old || j < batch.size())
+        {
+            if(j == batch.size() || (i != old && !comp(batch[j].first, keys[i])))
+            {
+                if(unique && j != batch.size() && !comp(keys[i], batch[j].first))
+                    ++j;  // 键值已经存在，丢弃新元素
+                new_keys.emplace_back(mystl::move(keys[i]));
+                new_values.emplace_back(mystl::move(values[i]));
+                ++i;
+            }
+            else
+            {
+                new_keys.emplace_back(mystl::move(batch[j].first));
+                new_values.emplace_back(mystl::move(values[batch[j].second]));
+                ++j;
+            }
+        }
+        keys.swap(new_keys);
+        values.swap(new_values);
+    }
+    catch(...)
+    {   // 撤销追加的元素，原有元素保持不变
+        keys.erase(keys.begin() + old, keys.end());
+        values.erase(values.begin() + old, values.end());
+        throw;
+    }
+}
+
+// 模板类 flat_map，键值不允许重复
+// 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less
+// 参数四代表空间配置器，缺省使用 mystl::allocator，键值数组与实值数组分别使用重新绑定得到的分配器
+template <class Key, class T, class Compare = mystl::less<Key>,
+          class Alloc = mystl::allocator<mystl::pair<const Key, T>>>
+class flat_map
+{
+public:
+    // flat_map 的嵌套型别定义
+    typedef Key                       key_type;
+    typedef T                         mapped_type;
+    typedef mystl::pair<Key, T>       value_type;
+    typedef Compare                   key_compare;
+    typedef Alloc                     allocator_type;
+
+    typedef mystl::vector<Key, typename allocator_traits<Alloc>::template rebind_alloc<Key>> key_container_type;
+    typedef mystl::vector<T, typename allocator_traits<Alloc>::template rebind_alloc<T>>     mapped_container_type;
+
+    // 定义一个 functor，用来进行元素比较
+class value_compare : public binary_function <value_type, value_type, bool>
+{
+    friend class flat_map<Key, T, Compare, Alloc>;
+private:
+    Compare comp;
+    value_compare(Compare c) : comp(c) {}
+public:
+    template <class P1, class P2>
+    bool operator()(const P1& lhs, const P2& rhs) const
+    {
+        return comp(lhs.first, rhs.first);  // 比较键值的大小
+    }
+};
+
+    typedef flat_map_iterator<Key, T, T*>                     iterator;
+    typedef flat_map_iterator<Key, T, const T*>               const_iterator;
+    typedef mystl::reverse_iterator<iterator>                 reverse_iterator;
+    typedef mystl::reverse_iterator<const_iterator>           const_reverse_iterator;
+    typedef typename iterator::reference                      reference;
+    typedef typename const_iterator::reference                const_reference;
+    typedef typename iterator::pointer                        pointer;
+    typedef typename const_iterator::pointer                  const_pointer;
+    typedef size_t                                            size_type;
+    typedef ptrdiff_t                                         difference_type;
+
+private:
+    // 用以下三个数据表现 flat_map
+    key_container_type    keys_;    // 有序的键值
+    mapped_container_type values_;  // 与键值一一对应的实值
+    key_compare           comp_;    // 键值比较的准则
+
+public:
+    // 构造、复制、移动、赋值函数
+    flat_map() = default;
+
+    explicit flat_map(const allocator_type& alloc)
+        : keys_(alloc), values_(alloc)
+    {}
+
+    template <class InputIterator>
+    flat_map(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : keys_(alloc), values_(alloc)
+    { insert(first, last); }
+
+    flat_map(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : keys_(alloc), values_(alloc)
+    { insert(ilist.begin(), ilist.end()); }
+
+    flat_map(const flat_map& rhs) = default;
+
+    flat_map(flat_map&& rhs) noexcept
+        : keys_(mystl::move(rhs.keys_)), values_(mystl::move(rhs.values_)), comp_(rhs.comp_)
+    {}
+
+    flat_map& operator=(const flat_map& rhs) = default;
+    flat_map& operator=(flat_map&& rhs)
+    {
+        keys_ = mystl::move(rhs.keys_);
+        values_ = mystl::move(rhs.values_);
+        comp_ = rhs.comp_;
+        return *this;
+    }
+    flat_map& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // 相关接口
+    key_compare    key_comp()      const { return comp_; }
+    value_compare  value_comp()    const { return value_compare(comp_); }
+    allocator_type get_allocator() const { return allocator_type(keys_.get_allocator()); }
+
+    const key_container_type&    keys()   const noexcept { return keys_; }
+    const mapped_container_type& values() const noexcept { return values_; }
+
+    // 迭代器相关
+    iterator               begin()         noexcept
+    { return iterator(keys_.data(), values_.data()); }
+    const_iterator         begin()   const noexcept
+    { return const_iterator(keys_.data(), values_.data()); }
+    iterator               end()           noexcept
+    { return begin() + size(); }
+    const_iterator         end()     const noexcept
+    { return begin() + size(); }
+
+    reverse_iterator       rbegin()        noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const noexcept
+    { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const noexcept
+    { return const_reverse_iterator(begin()); }
+
+    const_iterator         cbegin()  const noexcept
+    { return begin(); }
+    const_iterator         cend()    const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend()   const noexcept
+    { return rend(); }
+
+    // 容量相关
+    bool      empty()    const noexcept { return keys_.empty(); }
+    size_type size()     const noexcept { return keys_.size(); }
+    size_type max_size() const noexcept { return mystl::min(keys_.max_size(), values_.max_size()); }
+    size_type capacity() const noexcept { return keys_.capacity(); }
+
+    void reserve(size_type n)
+    {
+        keys_.reserve(n);
+        values_.reserve(n);
+    }
+    void shrink_to_fit()
+    {
+        keys_.shrink_to_fit();
+        values_.shrink_to_fit();
+    }
+
+    // 访问元素相关
+    // 若键值不存在，at 会抛出一个异常
+    mapped_type& at(const key_type& key)
+    {
+        const size_type i = find_index(key);
+        THROW_OUT_OF_RANGE_IF(i == size(), "flat_map<Key, T> no such element exists");
+        return values_[i];
+    }
+    const mapped_type& at(const key_type& key) const
+    {
+        const size_type i = find_index(key);
+        THROW_OUT_OF_RANGE_IF(i == size(), "flat_map<Key, T> no such element exists");
+        return values_[i];
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+        return values_[try_emplace_index(lower_index(key), key).first];
+    }
+    mapped_type& operator[](key_type&& key)
+    {
+        const size_type i = lower_index(key);
+        return values_[try_emplace_index(i, mystl::move(key)).first];
+    }
+
+    // 插入删除相关
+    template <class... Args>
+    pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type value(mystl::forward<Args>(args)...);
+        return try_emplace(mystl::move(value.first), mystl::move(value.second));
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        value_type value(mystl::forward<Args>(args)...);
+        return try_emplace(hint, mystl::move(value.first), mystl::move(value.second));
+    }
+
+    // try_emplace
+    // 键值不存在时才用 args 构造实值，键值已经存在时 key 与 args 不会被移动
+    template <class... Args>
+    pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        auto res = try_emplace_index(lower_index(key), key, mystl::forward<Args>(args)...);
+        return pair<iterator, bool>(iterator_at(res.first), res.second);
+    }
+    template <class... Args>
+    pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        const size_type i = lower_index(key);
+        auto res = try_emplace_index(i, mystl::move(key), mystl::forward<Args>(args)...);
+        return pair<iterator, bool>(iterator_at(res.first), res.second);
+    }
+    template <class... Args>
+    iterator try_emplace(const_iterator hint, const key_type& key, Args&&... args)
+    {
+        const size_type i = hint_index(hint, key);
+        return iterator_at(try_emplace_index(i, key, mystl::forward<Args>(args)...).first);
+    }
+    template <class... Args>
+    iterator try_emplace(const_iterator hint, key_type&& key, Args&&... args)
+    {
+        const size_type i = hint_index(hint, key);
+        return iterator_at(try_emplace_index(i, mystl::move(key), mystl::forward<Args>(args)...).first);
+    }
+
+    // insert_or_assign
+    // 键值不存在时插入，否则把 obj 赋值给已有的实值
+    template <class M>
+    pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+    {
+        auto res = try_emplace(key, mystl::forward<M>(obj));
+        if(!res.second)
+            res.first->second = mystl::forward<M>(obj);
+        return res;
+    }
+    template <class M>
+    pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+    {
+        auto res = try_emplace(mystl::move(key), mystl::forward<M>(obj));
+        if(!res.second)
+            res.first->second = mystl::forward<M>(obj);
+        return res;
+    }
+    template <class M>
+    iterator insert_or_assign(const_iterator hint, const key_type& key, M&& obj)
+    {
+        const size_type n = size();
+        iterator it = try_emplace(hint, key, mystl::forward<M>(obj));
+        if(size() == n)
+            it->second = mystl::forward<M>(obj);
+        return it;
+    }
+    template <class M>
+    iterator insert_or_assign(const_iterator hint, key_type&& key, M&& obj)
+    {
+        const size_type n = size();
+        iterator it = try_emplace(hint, mystl::move(key), mystl::forward<M>(obj));
+        if(size() == n)
+            it->second = mystl::forward<M>(obj);
+        return it;
+    }
+
+    pair<iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+    pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(mystl::move(value.first), mystl::move(value.second));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return try_emplace(hint, value.first, value.second);
+    }
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        return try_emplace(hint, mystl::move(value.first), mystl::move(value.second));
+    }
+
+    // 区间插入，元素可以是任何有 first 与 second 成员的 pair
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        append(first, last);
+        flat_map_sort_merge(keys_, values_, comp_, old, true);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // erase 返回指向被删除元素的下一个元素的迭代器
+    iterator erase(const_iterator pos)
+    {
+        MYSTL_DEBUG(pos != end());
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const size_type i = index_of(first);
+        const size_type j = index_of(last);
+        keys_.erase(keys_.begin() + i, keys_.begin() + j);
+        values_.erase(values_.begin() + i, values_.begin() + j);
+        return iterator_at(i);
+    }
+    size_type erase(const key_type& key)
+    {
+        const size_type i = find_index(key);
+        if(i == size())
+            return 0;
+        erase(iterator_at(i));
+        return 1;
+    }
+
+    void clear()
+    {
+        keys_.clear();
+        values_.clear();
+    }
+
+    // flat_map 相关操作
+    iterator       find(const key_type& key)              { return iterator_at(find_index(key)); }
+    const_iterator find(const key_type& key)        const { return iterator_at(find_index(key)); }
+
+    size_type      count(const key_type& key)       const { return find_index(key) != size() ? 1 : 0; }
+
+    iterator       lower_bound(const key_type& key)       { return iterator_at(lower_index(key)); }
+    const_iterator lower_bound(const key_type& key) const { return iterator_at(lower_index(key)); }
+
+    iterator       upper_bound(const key_type& key)       { return iterator_at(upper_index(key)); }
+    const_iterator upper_bound(const key_type& key) const { return iterator_at(upper_index(key)); }
+
+    pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        const size_type i = find_index(key);
+        return i == size() ? pair<iterator, iterator>(end(), end())
+                           : pair<iterator, iterator>(iterator_at(i), iterator_at(i + 1));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    {
+        const size_type i = find_index(key);
+        return i == size() ? pair<const_iterator, const_iterator>(end(), end())
+                           : pair<const_iterator, const_iterator>(iterator_at(i), iterator_at(i + 1));
+    }
+
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return iterator_at(find_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return iterator_at(find_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return find_index(key) != size() ? 1 : 0; }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return iterator_at(lower_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return iterator_at(lower_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return iterator_at(upper_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return iterator_at(upper_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    void swap(flat_map& rhs) noexcept
+    {
+        keys_.swap(rhs.keys_);
+        values_.swap(rhs.values_);
+        mystl::swap(comp_, rhs.comp_);
+    }
+
+public:
+    friend bool operator==(const flat_map& lhs, const flat_map& rhs)
+    {
+        return lhs.keys_ == rhs.keys_ && lhs.values_ == rhs.values_;
+    }
+    friend bool operator< (const flat_map& lhs, const flat_map& rhs)
+    {
+        return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+private:
+    iterator       iterator_at(size_type i)       { return begin() + i; }
+    const_iterator iterator_at(size_type i) const { return begin() + i; }
+
+    size_type index_of(const_iterator it) const
+    {
+        return static_cast<size_type>(it.kp - keys_.data());
+    }
+
+    template <class K>
+    size_type lower_index(const K& key) const
+    {
+        return static_cast<size_type>(mystl::lower_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+    }
+    template <class K>
+    size_type upper_index(const K& key) const
+    {
+        return static_cast<size_type>(mystl::upper_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+    }
+    // 找不到时返回 size()
+    template <class K>
+    size_type find_index(const K& key) const
+    {
+        const size_type i = lower_index(key);
+        return (i == size() || comp_(key, keys_[i])) ? size() : i;
+    }
+
+    // hint 恰好是插入位置时直接使用，否则重新查找
+    size_type hint_index(const_iterator hint, const key_type& key) const
+    {
+        const size_type h = index_of(hint);
+        if((h == 0 || comp_(keys_[h - 1], key)) && (h == size() || comp_(key, keys_[h])))
+            return h;
+        return lower_index(key);
+    }
+
+    // i 为 key 的 lower_bound 位置，键值已经存在时返回 (i, false)，否则在 i 处插入
+    template <class K, class... Args>
+    pair<size_type, bool> try_emplace_index(size_type i, K&& key, Args&&... args)
+    {
+        if(i != size() && !comp_(key, keys_[i]))
+            return pair<size_type, bool>(i, false);
+        keys_.emplace(keys_.begin() + i, mystl::forward<K>(key));
+        try
+        {
+            values_.emplace(values_.begin() + i, mystl::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            keys_.erase(keys_.begin() + i);
+            throw;
+        }
+        return pair<size_type, bool>(i, true);
+    }
+
+    // 把 [first, last) 追加到尾部，出现异常时撤销追加的元素
+    template <class InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        try
+        {
+            for(; first != last; ++first)
+            {
+                keys_.emplace_back((*first).first);
+                values_.emplace_back((*first).second);
+            }
+        }
+        catch(...)
+        {
+            keys_.erase(keys_.begin() + old, keys_.end());
+            values_.erase(values_.begin() + old, values_.end());
+            throw;
+        }
+    }
+};
+
+// 重载比较操作符
+template <class Key, class T, class Compare, class Alloc>
+bool operator==(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs)
+{
+  return lhs == rhs;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator<(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs)
+{
+  return lhs < rhs;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator!=(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator>(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator<=(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator>=(const flat_map<Key, T, Compare, Alloc>& lhs, const flat_map<Key, T, Compare, Alloc>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Key, class T, class Compare, class Alloc>
+void swap(flat_map<Key, T, Compare, Alloc>& lhs, flat_map<Key, T, Compare, Alloc>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+/*****************************************************************************************/
+
+// 模板类 flat_multimap，键值允许重复
+// 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less
+// 参数四代表空间配置器，缺省使用 mystl::allocator，键值数组与实值数组分别使用重新绑定得到的分配器
+template <class Key, class T, class Compare = mystl::less<Key>,
+          class Alloc = mystl::allocator<mystl::pair<const Key, T>>>
+class flat_multimap
+{
+public:
+    // flat_multimap 的嵌套型别定义
+    typedef Key                       key_type;
+    typedef T                         mapped_type;
+    typedef mystl::pair<Key, T>       value_type;
+    typedef Compare                   key_compare;
+    typedef Alloc                     allocator_type;
+
+    typedef mystl::vector<Key, typename allocator_traits<Alloc>::template rebind_alloc<Key>> key_container_type;
+    typedef mystl::vector<T, typename allocator_traits<Alloc>::template rebind_alloc<T>>     mapped_container_type;
+
+    // 定义一个 functor，用来进行元素比较
+class value_compare : public binary_function <value_type, value_type, bool>
+{
+    friend class flat_multimap<Key, T, Compare, Alloc>;
+private:
+    Compare comp;
+    value_compare(Compare c) : comp(c) {}
+public:
+    template <class P1, class P2>
+    bool operator()(const P1& lhs, const P2& rhs) const
+    {
+        return comp(lhs.first, rhs.first);  // 比较键值的大小
+    }
+};
+
+    typedef flat_map_iterator<Key, T, T*>                     iterator;
+    typedef flat_map_iterator<Key, T, const T*>               const_iterator;
+    typedef mystl::reverse_iterator<iterator>                 reverse_iterator;
+    typedef mystl::reverse_iterator<const_iterator>           const_reverse_iterator;
+    typedef typename iterator::reference                      reference;
+    typedef typename const_iterator::reference                const_reference;
+    typedef typename iterator::pointer                        pointer;
+    typedef typename const_iterator::pointer                  const_pointer;
+    typedef size_t                                            size_type;
+    typedef ptrdiff_t                                         difference_type;
+
+private:
+    // 用以下三个数据表现 flat_multimap
+    key_container_type    keys_;    // 有序的键值
+    mapped_container_type values_;  // 与键值一一对应的实值
+    key_compare           comp_;    // 键值比较的准则
+
+public:
+    // 构造、复制、移动、赋值函数
+    flat_multimap() = default;
+
+    explicit flat_multimap(const allocator_type& alloc)
+        : keys_(alloc), values_(alloc)
+    {}
+
+    template <class InputIterator>
+    flat_multimap(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : keys_(alloc), values_(alloc)
+    { insert(first, last); }
+
+    flat_multimap(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : keys_(alloc), values_(alloc)
+    { insert(ilist.begin(), ilist.end()); }
+
+    flat_multimap(const flat_multimap& rhs) = default;
+
+    flat_multimap(flat_multimap&& rhs) noexcept
+        : keys_(mystl::move(rhs.keys_)), values_(mystl::move(rhs.values_)), comp_(rhs.comp_)
+    {}
+
+    flat_multimap& operator=(const flat_multimap& rhs) = default;
+    flat_multimap& operator=(flat_multimap&& rhs)
+    {
+        keys_ = mystl::move(rhs.keys_);
+        values_ = mystl::move(rhs.values_);
+        comp_ = rhs.comp_;
+        return *this;
+    }
+    flat_multimap& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // 相关接口
+    key_compare    key_comp()      const { return comp_; }
+    value_compare  value_comp()    const { return value_compare(comp_); }
+    allocator_type get_allocator() const { return allocator_type(keys_.get_allocator()); }
+
+    const key_container_type&    keys()   const noexcept { return keys_; }
+    const mapped_container_type& values() const noexcept { return values_; }
+
+    // 迭代器相关
+    iterator               begin()         noexcept
+    { return iterator(keys_.data(), values_.data()); }
+    const_iterator         begin()   const noexcept
+    { return const_iterator(keys_.data(), values_.data()); }
+    iterator               end()           noexcept
+    { return begin() + size(); }
+    const_iterator         end()     const noexcept
+    { return begin() + size(); }
+
+    reverse_iterator       rbegin()        noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const noexcept
+    { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const noexcept
+    { return const_reverse_iterator(begin()); }
+
+    const_iterator         cbegin()  const noexcept
+    { return begin(); }
+    const_iterator         cend()    const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend()   const noexcept
+    { return rend(); }
+
+    // 容量相关
+    bool      empty()    const noexcept { return keys_.empty(); }
+    size_type size()     const noexcept { return keys_.size(); }
+    size_type max_size() const noexcept { return mystl::min(keys_.max_size(), values_.max_size()); }
+    size_type capacity() const noexcept { return keys_.capacity(); }
+
+    void reserve(size_type n)
+    {
+        keys_.reserve(n);
+        values_.reserve(n);
+    }
+    void shrink_to_fit()
+    {
+        keys_.shrink_to_fit();
+        values_.shrink_to_fit();
+    }
+
+    // 插入删除相关
+    template <class... Args>
+    iterator emplace(Args&&... args)
+    {
+        value_type value(mystl::forward<Args>(args)...);
+        const size_type i = upper_index(value.first);
+        return iterator_at(emplace_index(i, mystl::move(value.first), mystl::move(value.second)));
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        value_type value(mystl::forward<Args>(args)...);
+        const size_type i = hint_index(hint, value.first);
+        return iterator_at(emplace_index(i, mystl::move(value.first), mystl::move(value.second)));
+    }
+
+    iterator insert(const value_type& value)
+    {
+        return iterator_at(emplace_index(upper_index(value.first), value.first, value.second));
+    }
+    iterator insert(value_type&& value)
+    {
+        const size_type i = upper_index(value.first);
+        return iterator_at(emplace_index(i, mystl::move(value.first), mystl::move(value.second)));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return iterator_at(emplace_index(hint_index(hint, value.first), value.first, value.second));
+    }
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        const size_type i = hint_index(hint, value.first);
+        return iterator_at(emplace_index(i, mystl::move(value.first), mystl::move(value.second)));
+    }
+
+    // 区间插入，元素可以是任何有 first 与 second 成员的 pair，键值相等的元素保持插入的次序
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        append(first, last);
+        flat_map_sort_merge(keys_, values_, comp_, old, false);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // erase 返回指向被删除元素的下一个元素的迭代器
+    iterator erase(const_iterator pos)
+    {
+        MYSTL_DEBUG(pos != end());
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const size_type i = index_of(first);
+        const size_type j = index_of(last);
+        keys_.erase(keys_.begin() + i, keys_.begin() + j);
+        values_.erase(values_.begin() + i, values_.begin() + j);
+        return iterator_at(i);
+    }
+    size_type erase(const key_type& key)
+    {
+        const size_type i = lower_index(key);
+        const size_type j = upper_index(key);
+        erase(iterator_at(i), iterator_at(j));
+        return j - i;
+    }
+
+    void clear()
+    {
+        keys_.clear();
+        values_.clear();
+    }
+
+    // flat_multimap 相关操作
+    iterator       find(const key_type& key)              { return iterator_at(find_index(key)); }
+    const_iterator find(const key_type& key)        const { return iterator_at(find_index(key)); }
+
+    size_type      count(const key_type& key)       const { return upper_index(key) - lower_index(key); }
+
+    iterator       lower_bound(const key_type& key)       { return iterator_at(lower_index(key)); }
+    const_iterator lower_bound(const key_type& key) const { return iterator_at(lower_index(key)); }
+
+    iterator       upper_bound(const key_type& key)       { return iterator_at(upper_index(key)); }
+    const_iterator upper_bound(const key_type& key) const { return iterator_at(upper_index(key)); }
+
+    pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return iterator_at(find_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return iterator_at(find_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return upper_index(key) - lower_index(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return iterator_at(lower_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return iterator_at(lower_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return iterator_at(upper_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return iterator_at(upper_index(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    void swap(flat_multimap& rhs) noexcept
+    {
+        keys_.swap(rhs.keys_);
+        values_.swap(rhs.values_);
+        mystl::swap(comp_, rhs.comp_);
+    }
+
+public:
+    friend bool operator==(const flat_multimap& lhs, const flat_multimap& rhs)
+    {
+        return lhs.keys_ == rhs.keys_ && lhs.values_ == rhs.values_;
+    }
+    friend bool operator< (const flat_multimap& lhs, const flat_multimap& rhs)
+    {
+        return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+private:
+    iterator       iterator_at(size_type i)       { return begin() + i; }
+    const_iterator iterator_at(size_type i) const { return begin() + i; }
+
+    size_type index_of(const_iterator it) const
+    {
+        return static_cast<size_type>(it.kp - keys_.data());
+    }
+
+    template <class K>
+    size_type lower_index(const K& key) const
+    {
+        return static_cast<size_type>(mystl::lower_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+    }
+    template <class K>
+    size_type upper_index(const K& key) const
+    {
+        return static_cast<size_type>(mystl::upper_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin());
+    }
+    // 找不到时返回 size()
+    template <class K>
+    size_type find_index(const K& key) const
+    {
+        const size_type i = lower_index(key);
+        return (i == size() || comp_(key, keys_[i])) ? size() : i;
+    }
+
+    // hint 处可以插入 key 时直接使用，否则插入到相等键值的最后
+    size_type hint_index(const_iterator hint, const key_type& key) const
+    {
+        const size_type h = index_of(hint);
+        if((h == 0 || !comp_(key, keys_[h - 1])) && (h == size() || !comp_(keys_[h], key)))
+            return h;
+        return upper_index(key);
+    }
+
+    // 在 i 处插入，返回 i
+    template <class K, class... Args>
+    size_type emplace_index(size_type i, K&& key, Args&&... args)
+    {
+        keys_.emplace(keys_.begin() + i, mystl::forward<K>(key));
+        try
+        {
+            values_.emplace(values_.begin() + i, mystl::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            keys_.erase(keys_.begin() + i);
+            throw;
+        }
+        return i;
+    }
+
+    // 把 [first, last) 追加到尾部，出现异常时撤销追加的元素
+    template <class InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        try
+        {
+            for(; first != last; ++first)
+            {
+                keys_.emplace_back((*first).first);
+                values_.emplace_back((*first).second);
+            }
+        }
+        catch(...)
+        {
+            keys_.erase(keys_.begin() + old, keys_.end());
+            values_.erase(values_.begin() + old, values_.end());
+            throw;
+        }
+    }
+};
+
+// 重载比较操作符
+template <class Key, class T, class Compare, class Alloc>
+bool operator==(const flat_multimap<Key, T, Compare, Alloc>& lhs, const flat_multimap<Key, T, Compare, Alloc>& rhs)
+{
+  return lhs == rhs;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator<(const flat_multimap<Key, T, Compare, Alloc>& lhs, const flat_multimap<Key, T, Compare, Alloc>& rhs)
+{
+  return lhs < rhs;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator!=(const flat_multimap<Key, T, Compare, Alloc>& lhs, const flat_multimap<Key, T, Compare, Alloc>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator>(const flat_multimap<Key, T, Compare, Alloc>& lhs, const flat_multimap<Key, T, Compare, Alloc>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator<=(const flat_multimap<Key, T, Compare, Alloc>& lhs, const flat_multimap<Key, T, Compare, Alloc>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Key, class T, class Compare, class Alloc>
+bool operator>=(const flat_multimap<Key, T, Compare, Alloc>& lhs, const flat_multimap<Key, T, Compare, Alloc>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Key, class T, class Compare, class Alloc>
+void swap(flat_multimap<Key, T, Compare, Alloc>& lhs, flat_multimap<Key, T, Compare, Alloc>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+// 与底层的两个 vector 相同，可以直接搬移
+template <class Key, class T, class Compare, class Alloc>
+struct is_trivially_relocatable<flat_map<Key, T, Compare, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <class Key, class T, class Compare, class Alloc>
+struct is_trivially_relocatable<flat_multimap<Key, T, Compare, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 flat_map / flat_multimap，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <class Key, class T, class Compare = mystl::less<Key>>
+using flat_map = mystl::flat_map<Key, T, Compare, polymorphic_allocator<mystl::pair<const Key, T>>>;
+
+template <class Key, class T, class Compare = mystl::less<Key>>
+using flat_multimap = mystl::flat_multimap<Key, T, Compare, polymorphic_allocator<mystl::pair<const Key, T>>>;
+} // namespace pmr
+
+} // namespace mystl
+
+#endif // !MYTINYSTL_FLAT_MAP_H_
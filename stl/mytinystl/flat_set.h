@@ -0,0 +1,722 @@
+#ifndef MYTINYSTL_FLAT_SET_H_
+#define MYTINYSTL_FLAT_SET_H_
+
+// 这个头文件包含两个模板类 flat_set 和 flat_multiset
+// 功能与用法与 set / multiset 相同，底层使用一个有序的 mystl::vector，
+// 查找时在连续的数组上二分，适合构造一次之后大量查找的场合
+
+// notes:
+//
+// 与 set / multiset 的区别：
+//   * 单个元素的插入与删除需要搬移其后的所有元素，复杂度为 O(n)，大量插入时应使用区间版本，
+//     区间插入先把新元素追加到尾部，排序后与原有元素归并再去重，复杂度为 O(n + m log m)
+//   * 插入与删除会使所有的迭代器、指针和引用失效，erase 返回指向下一个元素的迭代器
+//   * keys() 返回底层的数组，reserve 与 shrink_to_fit 作用于该数组
+//   * 不提供节点句柄与 merge
+//
+// 异常保证：
+// mystl::flat_set<Key> / mystl::flat_multiset<Key> 满足基本异常保证，对以下等函数做强异常安全保证：
+//   * emplace
+//   * emplace_hint
+//   * insert
+// 元素的移动构造函数与移动赋值不应抛出异常
+
+#include <initializer_list>
+
+#include "vector.h"
+#include "algo.h"
+#include "functional.h"
+
+namespace mystl
+{
+
+// flat_set 与 flat_multiset 共用的区间插入操作
+// 新元素已经追加在 [old, size) 上，先排序再与 [0, old) 上的原有元素归并，原有元素排在相等的新元素之前，
+// unique 为 true 时再去掉重复的元素，与原有元素相等的新元素被丢弃
+template <class Container, class Compare>
+void flat_set_sort_merge(Container& keys, const Compare& comp, size_t old, bool unique)
+{
+    typedef typename Container::value_type value_type;
+    const size_t n = keys.size();
+    if(n == old)
+        return;
+
+    // 新元素本身有序且都排在原有元素之后时不需要调整，已经有序的数据构造时只需要一次检查
+    bool sorted = old == 0 || (unique ? comp(keys[old - 1], keys[old]) : !comp(keys[old], keys[old - 1]));
+    for(size_t i = old + 1; sorted && i < n; ++i)
+        sorted = unique ? comp(keys[i - 1], keys[i]) : !comp(keys[i], keys[i - 1]);
+    if(sorted)
+        return;
+
+    struct equal
+    {
+        const Compare* c;
+        bool operator()(const value_type& a, const value_type& b) const
+        {   // 已经有序，a 在 b 之前
+            return !(*c)(a, b);
+        }
+    };
+
+    auto first = keys.begin();
+    mystl::sort(first + old, keys.end(), comp);
+    if(old != 0)
+        mystl::inplace_merge(first, first + old, keys.end(), comp);
+    if(unique)
+        keys.erase(mystl::unique(keys.begin(), keys.end(), equal{&comp}), keys.end());
+}
+
+// 模板类 flat_set，键值不允许重复
+// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+template <class Key, class Compare = mystl::less<Key>, class Alloc = mystl::allocator<Key>>
+class flat_set
+{
+public:
+    typedef Key      key_type;
+    typedef Key      value_type;
+    typedef Compare  key_compare;
+    typedef Compare  value_compare;
+    typedef Alloc    allocator_type;
+
+    typedef mystl::vector<Key, Alloc> container_type;
+
+    // 元素不能被修改，iterator 与 const_iterator 都是只读的
+    typedef typename container_type::const_pointer           pointer;
+    typedef typename container_type::const_pointer           const_pointer;
+    typedef typename container_type::const_reference         reference;
+    typedef typename container_type::const_reference         const_reference;
+    typedef typename container_type::const_iterator          iterator;
+    typedef typename container_type::const_iterator          const_iterator;
+    typedef typename container_type::const_reverse_iterator  reverse_iterator;
+    typedef typename container_type::const_reverse_iterator  const_reverse_iterator;
+    typedef typename container_type::size_type               size_type;
+    typedef typename container_type::difference_type         difference_type;
+
+private:
+    container_type keys_;  // 有序的元素
+    key_compare    comp_;  // 键值比较的准则
+
+public:
+    // 构造、复制、移动函数
+    flat_set() = default;
+
+    explicit flat_set(const allocator_type& alloc) : keys_(alloc) {}
+
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : keys_(alloc)
+    {
+        insert(first, last);
+    }
+    flat_set(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : keys_(alloc)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    flat_set(const flat_set& rhs) = default;
+    flat_set(flat_set&& rhs) noexcept : keys_(mystl::move(rhs.keys_)), comp_(rhs.comp_) {}
+
+    flat_set& operator=(const flat_set& rhs) = default;
+    flat_set& operator=(flat_set&& rhs)
+    {
+        keys_ = mystl::move(rhs.keys_);
+        comp_ = rhs.comp_;
+        return *this;
+    }
+    flat_set& operator=(std::initializer_list<value_type> ilist)
+    {
+        keys_.clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // 相关接口
+    key_compare            key_comp()      const { return comp_; }
+    value_compare          value_comp()    const { return comp_; }
+    allocator_type         get_allocator() const { return keys_.get_allocator(); }
+
+    const container_type&  keys()          const noexcept { return keys_; }
+
+    // 迭代器相关
+    iterator               begin()         noexcept
+    { return keys_.begin(); }
+    const_iterator         begin()   const noexcept
+    { return keys_.begin(); }
+    iterator               end()           noexcept
+    { return keys_.end(); }
+    const_iterator         end()     const noexcept
+    { return keys_.end(); }
+
+    reverse_iterator       rbegin()        noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const noexcept
+    { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const noexcept
+    { return const_reverse_iterator(begin()); }
+
+    const_iterator         cbegin()  const noexcept
+    { return begin(); }
+    const_iterator         cend()    const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend()   const noexcept
+    { return rend(); }
+
+    // 容量相关
+    bool                   empty()    const noexcept { return keys_.empty(); }
+    size_type              size()     const noexcept { return keys_.size(); }
+    size_type              max_size() const noexcept { return keys_.max_size(); }
+    size_type              capacity() const noexcept { return keys_.capacity(); }
+
+    void reserve(size_type n) { keys_.reserve(n); }
+    void shrink_to_fit()      { keys_.shrink_to_fit(); }
+
+    // 插入删除操作
+    template <class ...Args>
+    pair<iterator, bool> emplace(Args&& ...args)
+    {
+        return insert(value_type(mystl::forward<Args>(args)...));
+    }
+
+    template <class ...Args>
+    iterator emplace_hint(const_iterator hint, Args&& ...args)
+    {
+        return insert(hint, value_type(mystl::forward<Args>(args)...));
+    }
+
+    pair<iterator, bool> insert(const value_type& value)
+    {
+        return insert_unique(lower_bound(value), value);
+    }
+    pair<iterator, bool> insert(value_type&& value)
+    {
+        const_iterator pos = lower_bound(value);
+        return insert_unique(pos, mystl::move(value));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return insert_unique(hint_position(hint, value), value).first;
+    }
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        const_iterator pos = hint_position(hint, value);
+        return insert_unique(pos, mystl::move(value)).first;
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        append(first, last);
+        flat_set_sort_merge(keys_, comp_, old, true);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // erase 返回指向被删除元素的下一个元素的迭代器
+    iterator  erase(const_iterator position) { return keys_.erase(position); }
+    size_type erase(const key_type& key)
+    {
+        const_iterator it = find(key);
+        if(it == end())
+            return 0;
+        keys_.erase(it);
+        return 1;
+    }
+    iterator  erase(const_iterator first, const_iterator last) { return keys_.erase(first, last); }
+
+    void clear() { keys_.clear(); }
+
+    // flat_set 相关操作
+    iterator       find(const key_type& key)              { return find_impl(key); }
+    const_iterator find(const key_type& key)        const { return find_impl(key); }
+
+    size_type      count(const key_type& key)       const { return find_impl(key) != end() ? 1 : 0; }
+
+    iterator       lower_bound(const key_type& key)       { return mystl::lower_bound(begin(), end(), key, comp_); }
+    const_iterator lower_bound(const key_type& key) const { return mystl::lower_bound(begin(), end(), key, comp_); }
+
+    iterator       upper_bound(const key_type& key)       { return mystl::upper_bound(begin(), end(), key, comp_); }
+    const_iterator upper_bound(const key_type& key) const { return mystl::upper_bound(begin(), end(), key, comp_); }
+
+    pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        iterator it = find_impl(key);
+        return pair<iterator, iterator>(it, it == end() ? it : it + 1);
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    {
+        const_iterator it = find_impl(key);
+        return pair<const_iterator, const_iterator>(it, it == end() ? it : it + 1);
+    }
+
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return find_impl(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return find_impl(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return find_impl(key) != end() ? 1 : 0; }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return mystl::lower_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return mystl::lower_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return mystl::upper_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return mystl::upper_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    void swap(flat_set& rhs) noexcept
+    {
+        keys_.swap(rhs.keys_);
+        mystl::swap(comp_, rhs.comp_);
+    }
+
+public:
+    friend bool operator==(const flat_set& lhs, const flat_set& rhs) { return lhs.keys_ == rhs.keys_; }
+    friend bool operator< (const flat_set& lhs, const flat_set& rhs) { return lhs.keys_ <  rhs.keys_; }
+
+private:
+    template <class K>
+    const_iterator find_impl(const K& key) const
+    {
+        const_iterator it = mystl::lower_bound(begin(), end(), key, comp_);
+        return (it == end() || comp_(key, *it)) ? end() : it;
+    }
+
+    // hint 恰好是插入位置时直接使用，否则重新查找
+    const_iterator hint_position(const_iterator hint, const value_type& value) const
+    {
+        if((hint == begin() || comp_(*(hint - 1), value)) && (hint == end() || comp_(value, *hint)))
+            return hint;
+        return lower_bound(value);
+    }
+
+    // pos 为 value 的 lower_bound 位置，已经存在相等的元素时返回 (pos, false)
+    template <class V>
+    pair<iterator, bool> insert_unique(const_iterator pos, V&& value)
+    {
+        if(pos != end() && !comp_(value, *pos))
+            return pair<iterator, bool>(pos, false);
+        return pair<iterator, bool>(keys_.emplace(pos, mystl::forward<V>(value)), true);
+    }
+
+    // 把 [first, last) 追加到尾部，出现异常时撤销追加的元素
+    template <class InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        try
+        {
+            for(; first != last; ++first)
+                keys_.emplace_back(*first);
+        }
+        catch(...)
+        {
+            keys_.erase(keys_.begin() + old, keys_.end());
+            throw;
+        }
+    }
+};
+
+// 重载比较操作符
+template <class Key, class Compare, class Alloc>
+bool operator==(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs)
+{
+  return lhs == rhs;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator<(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs)
+{
+  return lhs < rhs;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator!=(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator>(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator<=(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator>=(const flat_set<Key, Compare, Alloc>& lhs, const flat_set<Key, Compare, Alloc>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Key, class Compare, class Alloc>
+void swap(flat_set<Key, Compare, Alloc>& lhs, flat_set<Key, Compare, Alloc>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+/*****************************************************************************************/
+
+// 模板类 flat_multiset，键值允许重复
+// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+template <class Key, class Compare = mystl::less<Key>, class Alloc = mystl::allocator<Key>>
+class flat_multiset
+{
+public:
+    typedef Key      key_type;
+    typedef Key      value_type;
+    typedef Compare  key_compare;
+    typedef Compare  value_compare;
+    typedef Alloc    allocator_type;
+
+    typedef mystl::vector<Key, Alloc> container_type;
+
+    // 元素不能被修改，iterator 与 const_iterator 都是只读的
+    typedef typename container_type::const_pointer           pointer;
+    typedef typename container_type::const_pointer           const_pointer;
+    typedef typename container_type::const_reference         reference;
+    typedef typename container_type::const_reference         const_reference;
+    typedef typename container_type::const_iterator          iterator;
+    typedef typename container_type::const_iterator          const_iterator;
+    typedef typename container_type::const_reverse_iterator  reverse_iterator;
+    typedef typename container_type::const_reverse_iterator  const_reverse_iterator;
+    typedef typename container_type::size_type               size_type;
+    typedef typename container_type::difference_type         difference_type;
+
+private:
+    container_type keys_;  // 有序的元素
+    key_compare    comp_;  // 键值比较的准则
+
+public:
+    // 构造、复制、移动函数
+    flat_multiset() = default;
+
+    explicit flat_multiset(const allocator_type& alloc) : keys_(alloc) {}
+
+    template <class InputIterator>
+    flat_multiset(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : keys_(alloc)
+    {
+        insert(first, last);
+    }
+    flat_multiset(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : keys_(alloc)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    flat_multiset(const flat_multiset& rhs) = default;
+    flat_multiset(flat_multiset&& rhs) noexcept : keys_(mystl::move(rhs.keys_)), comp_(rhs.comp_) {}
+
+    flat_multiset& operator=(const flat_multiset& rhs) = default;
+    flat_multiset& operator=(flat_multiset&& rhs)
+    {
+        keys_ = mystl::move(rhs.keys_);
+        comp_ = rhs.comp_;
+        return *this;
+    }
+    flat_multiset& operator=(std::initializer_list<value_type> ilist)
+    {
+        keys_.clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // 相关接口
+    key_compare            key_comp()      const { return comp_; }
+    value_compare          value_comp()    const { return comp_; }
+    allocator_type         get_allocator() const { return keys_.get_allocator(); }
+
+    const container_type&  keys()          const noexcept { return keys_; }
+
+    // 迭代器相关
+    iterator               begin()         noexcept
+    { return keys_.begin(); }
+    const_iterator         begin()   const noexcept
+    { return keys_.begin(); }
+    iterator               end()           noexcept
+    { return keys_.end(); }
+    const_iterator         end()     const noexcept
+    { return keys_.end(); }
+
+    reverse_iterator       rbegin()        noexcept
+    { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const noexcept
+    { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          noexcept
+    { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const noexcept
+    { return const_reverse_iterator(begin()); }
+
+    const_iterator         cbegin()  const noexcept
+    { return begin(); }
+    const_iterator         cend()    const noexcept
+    { return end(); }
+    const_reverse_iterator crbegin() const noexcept
+    { return rbegin(); }
+    const_reverse_iterator crend()   const noexcept
+    { return rend(); }
+
+    // 容量相关
+    bool                   empty()    const noexcept { return keys_.empty(); }
+    size_type              size()     const noexcept { return keys_.size(); }
+    size_type              max_size() const noexcept { return keys_.max_size(); }
+    size_type              capacity() const noexcept { return keys_.capacity(); }
+
+    void reserve(size_type n) { keys_.reserve(n); }
+    void shrink_to_fit()      { keys_.shrink_to_fit(); }
+
+    // 插入删除操作
+    template <class ...Args>
+    iterator emplace(Args&& ...args)
+    {
+        return insert(value_type(mystl::forward<Args>(args)...));
+    }
+
+    template <class ...Args>
+    iterator emplace_hint(const_iterator hint, Args&& ...args)
+    {
+        return insert(hint, value_type(mystl::forward<Args>(args)...));
+    }
+
+    iterator insert(const value_type& value)
+    {
+        return keys_.emplace(upper_bound(value), value);
+    }
+    iterator insert(value_type&& value)
+    {
+        const_iterator pos = upper_bound(value);
+        return keys_.emplace(pos, mystl::move(value));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return keys_.emplace(hint_position(hint, value), value);
+    }
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        const_iterator pos = hint_position(hint, value);
+        return keys_.emplace(pos, mystl::move(value));
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        append(first, last);
+        flat_set_sort_merge(keys_, comp_, old, false);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // erase 返回指向被删除元素的下一个元素的迭代器
+    iterator  erase(const_iterator position) { return keys_.erase(position); }
+    size_type erase(const key_type& key)
+    {
+        auto p = equal_range(key);
+        const size_type n = static_cast<size_type>(p.second - p.first);
+        keys_.erase(p.first, p.second);
+        return n;
+    }
+    iterator  erase(const_iterator first, const_iterator last) { return keys_.erase(first, last); }
+
+    void clear() { keys_.clear(); }
+
+    // flat_multiset 相关操作
+    iterator       find(const key_type& key)              { return find_impl(key); }
+    const_iterator find(const key_type& key)        const { return find_impl(key); }
+
+    size_type      count(const key_type& key)       const
+    {
+        auto p = equal_range(key);
+        return static_cast<size_type>(p.second - p.first);
+    }
+
+    iterator       lower_bound(const key_type& key)       { return mystl::lower_bound(begin(), end(), key, comp_); }
+    const_iterator lower_bound(const key_type& key) const { return mystl::lower_bound(begin(), end(), key, comp_); }
+
+    iterator       upper_bound(const key_type& key)       { return mystl::upper_bound(begin(), end(), key, comp_); }
+    const_iterator upper_bound(const key_type& key) const { return mystl::upper_bound(begin(), end(), key, comp_); }
+
+    pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return find_impl(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return find_impl(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const
+    {
+        return static_cast<size_type>(upper_bound(key) - lower_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return mystl::lower_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return mystl::lower_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return mystl::upper_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return mystl::upper_bound(begin(), end(), key, comp_); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    {
+        return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
+
+    void swap(flat_multiset& rhs) noexcept
+    {
+        keys_.swap(rhs.keys_);
+        mystl::swap(comp_, rhs.comp_);
+    }
+
+public:
+    friend bool operator==(const flat_multiset& lhs, const flat_multiset& rhs) { return lhs.keys_ == rhs.keys_; }
+    friend bool operator< (const flat_multiset& lhs, const flat_multiset& rhs) { return lhs.keys_ <  rhs.keys_; }
+
+private:
+    template <class K>
+    const_iterator find_impl(const K& key) const
+    {
+        const_iterator it = mystl::lower_bound(begin(), end(), key, comp_);
+        return (it == end() || comp_(key, *it)) ? end() : it;
+    }
+
+    // hint 处可以插入 value 时直接使用，否则插入到相等元素的最后
+    const_iterator hint_position(const_iterator hint, const value_type& value) const
+    {
+        if((hint == begin() || !comp_(value, *(hint - 1))) && (hint == end() || !comp_(*hint, value)))
+            return hint;
+        return upper_bound(value);
+    }
+
+    // 把 [first, last) 追加到尾部，出现异常时撤销追加的元素
+    template <class InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        const size_type old = size();
+        try
+        {
+            for(; first != last; ++first)
+                keys_.emplace_back(*first);
+        }
+        catch(...)
+        {
+            keys_.erase(keys_.begin() + old, keys_.end());
+            throw;
+        }
+    }
+};
+
+// 重载比较操作符
+template <class Key, class Compare, class Alloc>
+bool operator==(const flat_multiset<Key, Compare, Alloc>& lhs, const flat_multiset<Key, Compare, Alloc>& rhs)
+{
+  return lhs == rhs;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator<(const flat_multiset<Key, Compare, Alloc>& lhs, const flat_multiset<Key, Compare, Alloc>& rhs)
+{
+  return lhs < rhs;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator!=(const flat_multiset<Key, Compare, Alloc>& lhs, const flat_multiset<Key, Compare, Alloc>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator>(const flat_multiset<Key, Compare, Alloc>& lhs, const flat_multiset<Key, Compare, Alloc>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator<=(const flat_multiset<Key, Compare, Alloc>& lhs, const flat_multiset<Key, Compare, Alloc>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Key, class Compare, class Alloc>
+bool operator>=(const flat_multiset<Key, Compare, Alloc>& lhs, const flat_multiset<Key, Compare, Alloc>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Key, class Compare, class Alloc>
+void swap(flat_multiset<Key, Compare, Alloc>& lhs, flat_multiset<Key, Compare, Alloc>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+// 与底层的 vector 相同，可以直接搬移
+template <class Key, class Compare, class Alloc>
+struct is_trivially_relocatable<flat_set<Key, Compare, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <class Key, class Compare, class Alloc>
+struct is_trivially_relocatable<flat_multiset<Key, Compare, Alloc>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 flat_set / flat_multiset，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <class Key, class Compare = mystl::less<Key>>
+using flat_set = mystl::flat_set<Key, Compare, polymorphic_allocator<Key>>;
+
+template <class Key, class Compare = mystl::less<Key>>
+using flat_multiset = mystl::flat_multiset<Key, Compare, polymorphic_allocator<Key>>;
+} // namespace pmr
+
+} // namespace mystl
+
+#endif // !MYTINYSTL_FLAT_SET_H_
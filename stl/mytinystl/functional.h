@@ -4,6 +4,9 @@
 // 这个头文件包含了 mystl 的函数对象与哈希函数
 
 #include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<cfloat>
 
 namespace mystl{
 
@@ -67,11 +70,19 @@ template<class T>
 T identity_element(multiplies<T>){ return T(1); }
 
 // 函数对象：等于
-template<class T>
+template<class T = void>
 struct equal_to : public binary_function<T, T, bool>{
     bool operator()(const T& x, const T& y) const { return x == y; }
 };
 
+// 透明的 equal_to<>，比较任意两个可以用 == 比较的对象，不必先转换成同一型别
+template<>
+struct equal_to<void>{
+    typedef int is_transparent;
+    template<class T, class U>
+    bool operator()(const T& x, const U& y) const { return x == y; }
+};
+
 // 函数对象：不等于
 template<class T>
 struct not_equal_to : public binary_function<T, T, bool>{
@@ -85,11 +96,19 @@ struct greater : public binary_function<T, T, bool>{
 };
 
 // 函数对象：小于
-template<class T>
+template<class T = void>
 struct less : public binary_function<T, T, bool>{
     bool operator()(const T& x, const T& y) const { return x < y; }
 };
 
+// 透明的 less<>，比较任意两个可以用 < 比较的对象，用作 map / set 的比较函数时启用异构查找
+template<>
+struct less<void>{
+    typedef int is_transparent;
+    template<class T, class U>
+    bool operator()(const T& x, const U& y) const { return x < y; }
+};
+
 // 函数对象：大于等于
 template<class T>
 struct greater_equal : public binary_function<T, T, bool>{
@@ -209,41 +228,172 @@ MYSTL_TRIVIAL_HASH_FCN(unsigned long long)
 #undef MYSTL_TRIVIAL_HASH_FCN
 
 
-// 对于浮点数，逐位哈希
-inline size_t bitwise_hash(const unsigned char* first, size_t count){
-#if (_MSC_VER_ && _WIN64) || ((__GNUC__ || __clang__) && __SIZEOF_POINTER__ == 8)
-    const size_t fnv_offset = 14695981039346656037ull;
-    const size_t fnv_prime = 1099511628211ull;
+// 字节序列的哈希引擎
+// 采用 wyhash 的结构：每次读取 8 字节，用 64 位乘法得到的 128 位结果折叠混合，
+// 长度不超过 16 字节的输入用几次可能重叠的读取一次完成，长输入的尾部同样从末尾倒读，
+// 因此任何长度都没有逐字节的循环
+namespace hash_detail
+{
+
+const uint64_t secret0 = 0x2d358dccaa6c78a5ull;
+const uint64_t secret1 = 0x8bb84b93962eacc9ull;
+const uint64_t secret2 = 0x4b33a62ed433d4a3ull;
+const uint64_t secret3 = 0x4d5a2da51de1aa47ull;
+
+// 用 memcpy 读取，不要求地址对齐，编译器会生成一条普通的读指令
+inline uint64_t read64(const unsigned char* p) noexcept
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t read32(const unsigned char* p) noexcept
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+// 1 到 3 个字节：取首、中、尾三个字节
+inline uint64_t read_small(const unsigned char* p, size_t n) noexcept
+{
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[n >> 1]) << 8) | p[n - 1];
+}
+
+// 计算 a * b 的 128 位结果，低 64 位写回 a，高 64 位写回 b
+inline void mum(uint64_t& a, uint64_t& b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
 #else
-    const size_t fnv_offset = 2166136261u;
-    const size_t fnv_prime = 16777619u;
+    const uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    const uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
 #endif
-    size_t result = fnv_offset;
-    for(size_t i = 0; i < count; ++i){
-        result ^= (size_t)first[i];
-        result *= fnv_prime;
+}
+
+inline uint64_t mix(uint64_t a, uint64_t b) noexcept
+{
+    mum(a, b);
+    return a ^ b;
+}
+
+inline uint64_t hash_bytes(const void* key, size_t len, uint64_t seed) noexcept
+{
+    const unsigned char* p = static_cast<const unsigned char*>(key);
+    seed ^= mix(seed ^ secret0, secret1);
+    uint64_t a, b;
+    if(len <= 16)
+    {
+        if(len >= 4)
+        {
+            // 4 到 16 字节：首尾各读两次 4 字节，中间的读取位置随长度移动
+            const size_t off = (len >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + off);
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - off);
+        }
+        else if(len > 0)
+        {
+            a = read_small(p, len);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if(i > 48)
+        {
+            // 三条互不依赖的乘法链并行推进，隐藏乘法的延迟
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+                see1 = mix(read64(p + 16) ^ secret2, read64(p + 24) ^ see1);
+                see2 = mix(read64(p + 32) ^ secret3, read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while(i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while(i > 16)
+        {
+            seed = mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        // 最后 16 字节从末尾读取，可能与已经处理的部分重叠
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
     }
-    return result;
+    a ^= secret1;
+    b ^= seed;
+    mum(a, b);
+    return mix(a ^ secret0 ^ len, b ^ secret1);
 }
 
+} // namespace hash_detail
+
+// 对任意字节序列求哈希值，浮点数与字符串都使用它
+inline size_t bitwise_hash(const unsigned char* first, size_t count) noexcept
+{
+    return static_cast<size_t>(hash_detail::hash_bytes(first, count, 0));
+}
+
+// 透明的字符串哈希函数，接受 const CharType* 或任何提供 data() 与 size() 的字符串，
+// 结果与 hash<basic_string<CharType>> 相同，用作无序容器的哈希函数时启用异构查找
+template<class CharType = char>
+struct string_hash{
+    typedef int is_transparent;
+
+    size_t operator()(const CharType* s) const noexcept{
+        size_t n = 0;
+        for(; s[n] != CharType(); ++n);
+        return bitwise_hash((const unsigned char*)s, n * sizeof(CharType));
+    }
+
+    template<class Str>
+    size_t operator()(const Str& str) const noexcept{
+        return bitwise_hash((const unsigned char*)str.data(), str.size() * sizeof(CharType));
+    }
+};
+
+// 对于浮点数，逐位哈希，+0.0 与 -0.0 相等，因此都映射为 0
 template<>
 struct hash<float>{
-    size_t operator()(const float& val){
+    size_t operator()(const float& val) const noexcept{
         return val == 0.0f ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(float));
     }
 };
 
 template<>
 struct hash<double>{
-    size_t operator()(const double& val){
-        return val == 0.0f ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(double));
+    size_t operator()(const double& val) const noexcept{
+        return val == 0.0 ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(double));
     }
 };
 
+// x87 的 long double 只有前 10 个字节有效，其余是未定义的填充字节，不能参与哈希
 template<>
 struct hash<long double>{
-    size_t operator()(const long double& val){
-        return val == 0.0f ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(long double));
+    size_t operator()(const long double& val) const noexcept{
+#if LDBL_MANT_DIG == 64
+        const size_t bytes = 10;
+#else
+        const size_t bytes = sizeof(long double);
+#endif
+        return val == 0.0L ? 0 : bitwise_hash((const unsigned char*)&val, bytes);
     }
 };
 
@@ -12,6 +12,7 @@
 #include "vector.h"
 #include "util.h"
 #include "exceptdef.h"
+#include "node_handle.h"
 
 namespace mystl
 {
@@ -105,13 +106,16 @@ public:
 
 // forward declaration
 
-template <class T, class HashFun, class KeyEqual>
+struct ht_prime_policy;
+
+template <class T, class HashFun, class KeyEqual, class Alloc = mystl::allocator<T>,
+          class Policy = mystl::ht_prime_policy>
 class hashtable;
 
-template <class T, class HashFun, class KeyEqual>
+template <class T, class HashFun, class KeyEqual, class Alloc, class Policy>
 struct ht_iterator;
 
-template <class T, class HashFun, class KeyEqual>
+template <class T, class HashFun, class KeyEqual, class Alloc, class Policy>
 struct ht_const_iterator;
 
 template <class T>
@@ -121,14 +125,14 @@ template <class T>
 struct ht_const_local_iterator;
 
 // ht_iterator
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 struct ht_iterator_base : public mystl::iterator<mystl::forward_iterator_tag, T>
 {
 public:
-    typedef mystl::hashtable<T, Hash, KeyEqual>         hashtable;
-    typedef ht_iterator_base<T, Hash, KeyEqual>         base;
-    typedef mystl::ht_iterator<T, Hash, KeyEqual>       iterator;
-    typedef mystl::ht_const_iterator<T, Hash, KeyEqual> const_iterator;
+    typedef mystl::hashtable<T, Hash, KeyEqual, Alloc, Policy>         hashtable;
+    typedef ht_iterator_base<T, Hash, KeyEqual, Alloc, Policy>         base;
+    typedef mystl::ht_iterator<T, Hash, KeyEqual, Alloc, Policy>       iterator;
+    typedef mystl::ht_const_iterator<T, Hash, KeyEqual, Alloc, Policy> const_iterator;
     typedef hashtable_node<T>*                          node_ptr;
     typedef hashtable*                                  contain_ptr;
     typedef const node_ptr                              const_node_ptr;
@@ -146,11 +150,11 @@ public:
     bool operator!=(const base& rhs) const { return node != rhs.node; }
 };
 
-template <class T, class Hash, class KeyEqual>
-struct ht_iterator : public ht_iterator_base<T, Hash, KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+struct ht_iterator : public ht_iterator_base<T, Hash, KeyEqual, Alloc, Policy>
 {
 public:
-    typedef ht_iterator_base<T, Hash, KeyEqual> base;
+    typedef ht_iterator_base<T, Hash, KeyEqual, Alloc, Policy> base;
     typedef typename base::hashtable            hashtable;
     typedef typename base::iterator             iterator;
     typedef typename base::const_iterator       const_iterator;
@@ -212,8 +216,8 @@ public:
         if(node == nullptr)
         {   // 如果下一个位置为空，跳到下一个 bucket 的起始处
             auto index = ht->hash(value_traits::get_key(old->value));
-            while(!node && ++index < ht->bucket_size_)
-                node = ht->buckets_[index];
+            while(!node && ++index < ht->M_bucket_total())
+                node = ht->M_bucket(index);
         }
         return *this;
     }
@@ -225,11 +229,11 @@ public:
     }
 };
 
-template <class T, class Hash, class KeyEqual>
-struct ht_const_iterator : public ht_iterator_base<T, Hash, KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+struct ht_const_iterator : public ht_iterator_base<T, Hash, KeyEqual, Alloc, Policy>
 {
 public:
-    typedef ht_iterator_base<T, Hash, KeyEqual> base;
+    typedef ht_iterator_base<T, Hash, KeyEqual, Alloc, Policy> base;
     typedef typename base::hashtable            hashtable;
     typedef typename base::iterator             iterator;
     typedef typename base::const_iterator       const_iterator;
@@ -291,8 +295,8 @@ public:
         if(node == nullptr)
         {   // 如果下一个位置为空，跳到下一个 bucket 的起始处
             auto index = ht->hash(value_traits::get_key(old->value));
-            while(!node && ++index < ht->bucket_size_)
-                node = ht->buckets_[index];
+            while(!node && ++index < ht->M_bucket_total())
+                node = ht->M_bucket(index);
         }
         return *this;
     }
@@ -454,15 +458,171 @@ inline size_t ht_next_prime(size_t n)
     return pos == last ? *(last - 1) : *pos;
 }
 
+// bucket 策略
+// hashtable 通过策略类把哈希值映射到 bucket，策略类需要提供：
+//   static size_t next_size(size_t n) : 不小于 n 的合法 bucket 数量
+//   static size_t max_size()          : 最大的 bucket 数量
+//   Policy(size_t n)                  : 以 next_size 的返回值构造
+//   size_t bucket(size_t h) const     : 哈希值 h 所在的 bucket
+
+// 质数策略（缺省），bucket 数量取自 ht_prime_list
+// 对每个质数分别写出以常量取模的分支，编译器会把常量取模化为乘法与移位，
+// 运行时按质数的下标跳转，省去一次整数除法
+#define HT_PRIME_MOD(I) case I: return h % ht_prime_list[I];
+
+#ifdef SYSTEM_64
+#define HT_PRIME_MOD_CASES \
+    HT_PRIME_MOD(0) HT_PRIME_MOD(1) HT_PRIME_MOD(2) HT_PRIME_MOD(3) HT_PRIME_MOD(4) HT_PRIME_MOD(5) \
+    HT_PRIME_MOD(6) HT_PRIME_MOD(7) HT_PRIME_MOD(8) HT_PRIME_MOD(9) HT_PRIME_MOD(10) HT_PRIME_MOD(11) \
+    HT_PRIME_MOD(12) HT_PRIME_MOD(13) HT_PRIME_MOD(14) HT_PRIME_MOD(15) HT_PRIME_MOD(16) HT_PRIME_MOD(17) \
+    HT_PRIME_MOD(18) HT_PRIME_MOD(19) HT_PRIME_MOD(20) HT_PRIME_MOD(21) HT_PRIME_MOD(22) HT_PRIME_MOD(23) \
+    HT_PRIME_MOD(24) HT_PRIME_MOD(25) HT_PRIME_MOD(26) HT_PRIME_MOD(27) HT_PRIME_MOD(28) HT_PRIME_MOD(29) \
+    HT_PRIME_MOD(30) HT_PRIME_MOD(31) HT_PRIME_MOD(32) HT_PRIME_MOD(33) HT_PRIME_MOD(34) HT_PRIME_MOD(35) \
+    HT_PRIME_MOD(36) HT_PRIME_MOD(37) HT_PRIME_MOD(38) HT_PRIME_MOD(39) HT_PRIME_MOD(40) HT_PRIME_MOD(41) \
+    HT_PRIME_MOD(42) HT_PRIME_MOD(43) HT_PRIME_MOD(44) HT_PRIME_MOD(45) HT_PRIME_MOD(46) HT_PRIME_MOD(47) \
+    HT_PRIME_MOD(48) HT_PRIME_MOD(49) HT_PRIME_MOD(50) HT_PRIME_MOD(51) HT_PRIME_MOD(52) HT_PRIME_MOD(53) \
+    HT_PRIME_MOD(54) HT_PRIME_MOD(55) HT_PRIME_MOD(56) HT_PRIME_MOD(57) HT_PRIME_MOD(58) HT_PRIME_MOD(59) \
+    HT_PRIME_MOD(60) HT_PRIME_MOD(61) HT_PRIME_MOD(62) HT_PRIME_MOD(63) HT_PRIME_MOD(64) HT_PRIME_MOD(65) \
+    HT_PRIME_MOD(66) HT_PRIME_MOD(67) HT_PRIME_MOD(68) HT_PRIME_MOD(69) HT_PRIME_MOD(70) HT_PRIME_MOD(71) \
+    HT_PRIME_MOD(72) HT_PRIME_MOD(73) HT_PRIME_MOD(74) HT_PRIME_MOD(75) HT_PRIME_MOD(76) HT_PRIME_MOD(77) \
+    HT_PRIME_MOD(78) HT_PRIME_MOD(79) HT_PRIME_MOD(80) HT_PRIME_MOD(81) HT_PRIME_MOD(82) HT_PRIME_MOD(83) \
+    HT_PRIME_MOD(84) HT_PRIME_MOD(85) HT_PRIME_MOD(86) HT_PRIME_MOD(87) HT_PRIME_MOD(88) HT_PRIME_MOD(89) \
+    HT_PRIME_MOD(90) HT_PRIME_MOD(91) HT_PRIME_MOD(92) HT_PRIME_MOD(93) HT_PRIME_MOD(94) HT_PRIME_MOD(95) \
+    HT_PRIME_MOD(96) HT_PRIME_MOD(97) HT_PRIME_MOD(98)
+#else
+#define HT_PRIME_MOD_CASES \
+    HT_PRIME_MOD(0) HT_PRIME_MOD(1) HT_PRIME_MOD(2) HT_PRIME_MOD(3) HT_PRIME_MOD(4) HT_PRIME_MOD(5) \
+    HT_PRIME_MOD(6) HT_PRIME_MOD(7) HT_PRIME_MOD(8) HT_PRIME_MOD(9) HT_PRIME_MOD(10) HT_PRIME_MOD(11) \
+    HT_PRIME_MOD(12) HT_PRIME_MOD(13) HT_PRIME_MOD(14) HT_PRIME_MOD(15) HT_PRIME_MOD(16) HT_PRIME_MOD(17) \
+    HT_PRIME_MOD(18) HT_PRIME_MOD(19) HT_PRIME_MOD(20) HT_PRIME_MOD(21) HT_PRIME_MOD(22) HT_PRIME_MOD(23) \
+    HT_PRIME_MOD(24) HT_PRIME_MOD(25) HT_PRIME_MOD(26) HT_PRIME_MOD(27) HT_PRIME_MOD(28) HT_PRIME_MOD(29) \
+    HT_PRIME_MOD(30) HT_PRIME_MOD(31) HT_PRIME_MOD(32) HT_PRIME_MOD(33) HT_PRIME_MOD(34) HT_PRIME_MOD(35) \
+    HT_PRIME_MOD(36) HT_PRIME_MOD(37) HT_PRIME_MOD(38) HT_PRIME_MOD(39) HT_PRIME_MOD(40) HT_PRIME_MOD(41) \
+    HT_PRIME_MOD(42) HT_PRIME_MOD(43)
+#endif
+
+struct ht_prime_policy
+{
+    size_t index;  // 当前质数在 ht_prime_list 中的下标
+
+    ht_prime_policy() noexcept : index(0) {}
+    explicit ht_prime_policy(size_t n) noexcept
+    : index(static_cast<size_t>(mystl::lower_bound(ht_prime_list, ht_prime_list + PRIME_NUM, n) - ht_prime_list))
+    {
+        MYSTL_DEBUG(index < PRIME_NUM);
+    }
+
+    static size_t next_size(size_t n) noexcept { return ht_next_prime(n); }
+    static size_t max_size() noexcept { return ht_prime_list[PRIME_NUM - 1]; }
+
+    size_t bucket(size_t h) const noexcept
+    {
+        switch (index)
+        {
+            HT_PRIME_MOD_CASES
+        default:  // index 总是小于 PRIME_NUM
+            return h % ht_prime_list[PRIME_NUM - 1];
+        }
+    }
+};
+
+#undef HT_PRIME_MOD_CASES
+#undef HT_PRIME_MOD
+
+// 2 的幂次策略，bucket 数量为 2 的幂次，用掩码取低位
+// mystl::hash 对整数是恒等映射，低位往往分布不均，所以先用乘法把高位混入低位
+struct ht_pow2_policy
+{
+    size_t mask;  // bucket 数量减一
+
+    ht_pow2_policy() noexcept : mask(0) {}
+    explicit ht_pow2_policy(size_t n) noexcept : mask(n - 1)
+    {
+        MYSTL_DEBUG(n != 0 && (n & (n - 1)) == 0);
+    }
+
+    static size_t next_size(size_t n) noexcept
+    {
+        size_t result = 16;
+        while (result < n && result < max_size())
+            result <<= 1;
+        return result;
+    }
+    static size_t max_size() noexcept { return (static_cast<size_t>(-1) >> 1) + 1; }
+
+    size_t bucket(size_t h) const noexcept
+    {
+        return static_cast<size_t>(hash_detail::mix(h, 0x9e3779b97f4a7c15ull)) & mask;
+    }
+};
+
+// 渐进式 rehash 策略，参数一为实际把哈希值映射到 bucket 的策略，参数二为每次插入迁移的旧 bucket 数量
+// 自动扩容时保留旧的 bucket 数组，之后每次插入只把 Step 个旧 bucket 的节点迁移到新数组，
+// 把一次性搬动全部节点的停顿分摊到之后的插入上；显式调用 rehash / reserve 时仍然一次完成
+template <class Policy, size_t Step = 8>
+struct ht_incremental_policy : public Policy
+{
+    static constexpr size_t migrate_step = Step;
+
+    ht_incremental_policy() noexcept : Policy() {}
+    explicit ht_incremental_policy(size_t n) noexcept : Policy(n) {}
+};
+
+template <class Policy>
+struct ht_is_incremental : public m_false_type {};
+
+template <class Policy, size_t Step>
+struct ht_is_incremental<ht_incremental_policy<Policy, Step>> : public m_true_type {};
+
+// 渐进式 rehash 的迁移状态，旧 bucket 数组不为空时表示正在迁移
+// 非渐进式的策略不需要任何状态
+template <class Bucket, class Policy, bool = ht_is_incremental<Policy>::value>
+struct ht_rehash_state
+{
+    Bucket old_buckets;  // 尚未迁移完的旧 bucket 数组
+    Policy old_policy;   // 旧 bucket 数组使用的策略
+    size_t migrate_pos;  // 旧 bucket 中 [0, migrate_pos) 已经迁移完毕
+
+    template <class BucketAlloc>
+    explicit ht_rehash_state(const BucketAlloc& alloc) : old_buckets(alloc), old_policy(), migrate_pos(0) {}
+
+    ht_rehash_state(ht_rehash_state&& rhs) noexcept
+    : old_buckets(mystl::move(rhs.old_buckets)), old_policy(rhs.old_policy), migrate_pos(rhs.migrate_pos)
+    {
+        rhs.migrate_pos = 0;
+    }
+
+    bool migrating() const noexcept { return old_buckets.size() != 0; }
+
+    void swap(ht_rehash_state& rhs) noexcept
+    {
+        old_buckets.swap(rhs.old_buckets);
+        mystl::swap(old_policy, rhs.old_policy);
+        mystl::swap(migrate_pos, rhs.migrate_pos);
+    }
+};
+
+template <class Bucket, class Policy>
+struct ht_rehash_state<Bucket, Policy, false>
+{
+    template <class BucketAlloc>
+    explicit ht_rehash_state(const BucketAlloc&) noexcept {}
+
+    bool migrating() const noexcept { return false; }
+    void swap(ht_rehash_state&) noexcept {}
+};
+
 
 // 模板类 hashtable
-// 参数一代表数据类型，参数二代表哈希函数，参数三代表键值相等的比较函数
-template <class T, class Hash, class KeyEqual>
-class hashtable
+// 参数一代表数据类型，参数二代表哈希函数，参数三代表键值相等的比较函数，参数四代表空间配置器，
+// 参数五代表 bucket 策略，缺省使用 mystl::ht_prime_policy
+// hashtable 保存的是结点的分配器，bucket 数组与元素分别通过重新绑定得到的分配器构造
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+class hashtable : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<hashtable_node<T>>>
 {
 
-    friend struct mystl::ht_iterator<T, Hash, KeyEqual>;
-    friend struct mystl::ht_const_iterator<T, Hash, KeyEqual>;
+    friend struct mystl::ht_iterator<T, Hash, KeyEqual, Alloc, Policy>;
+    friend struct mystl::ht_const_iterator<T, Hash, KeyEqual, Alloc, Policy>;
 
 public:
     // hashtable 的型别定义
@@ -472,45 +632,63 @@ public:
     typedef typename value_traits::value_type           value_type;
     typedef Hash                                        hasher;
     typedef KeyEqual                                    key_equal;
+    typedef Policy                                      policy_type;
 
     typedef hashtable_node<T>                           node_type;
     typedef node_type*                                  node_ptr;
-    typedef mystl::vector<node_ptr>                     bucket_type;
 
-    typedef mystl::allocator<T>                         allocator_type;
-    typedef mystl::allocator<T>                         data_allocator;
-    typedef mystl::allocator<node_type>                 node_allocator;
-    
-    typedef typename allocator_type::pointer            pointer;
-    typedef typename allocator_type::const_pointer      const_pointer;
-    typedef typename allocator_type::reference          reference;
-    typedef typename allocator_type::const_reference    const_reference;
-    typedef typename allocator_type::size_type          size_type;
-    typedef typename allocator_type::difference_type    difference_type;
-
-    typedef mystl::ht_iterator<T, Hash, KeyEqual>       iterator;
-    typedef mystl::ht_const_iterator<T, Hash, KeyEqual> const_iterator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>         data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<node_type> node_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<node_ptr>  bucket_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef mystl::allocator_traits<node_allocator>     node_alloc_traits;
+    typedef data_allocator                              allocator_type;
+    typedef mystl::vector<node_ptr, bucket_allocator>   bucket_type;
+
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
+
+    typedef mystl::ht_iterator<T, Hash, KeyEqual, Alloc, Policy>       iterator;
+    typedef mystl::ht_const_iterator<T, Hash, KeyEqual, Alloc, Policy> const_iterator;
     typedef mystl::ht_local_iterator<T>                 local_iterator;
     typedef mystl::ht_const_local_iterator<T>           const_local_iterator;
 
-    allocator_type get_allocator() const { return allocator_type(); }
+    typedef mystl::node_handle<node_type, node_allocator>    node_handle;
+    typedef mystl::node_insert_return<iterator, node_handle> insert_return_type;
+
+    allocator_type get_allocator() const { return allocator_type(this->get_alloc()); }
+
+    // merge 需要访问哈希函数、比较函数或策略不同的 hashtable 的节点
+    template <class, class, class, class, class> friend class hashtable;
 
 private:
-    // 用以下六个参数来表现 hashtable
-    bucket_type buckets_;
-    size_type   bucket_size_;
-    size_type   size_;
-    float       mlf_;
-    hasher      hash_;
-    key_equal   equal_;
+    typedef mystl::alloc_holder<node_allocator>         alloc_base;
+    typedef ht_rehash_state<bucket_type, Policy>        rehash_state;
+    typedef ht_is_incremental<Policy>                   incremental;
+
+    // 用以下八个参数来表现 hashtable
+    bucket_type  buckets_;
+    size_type    bucket_size_;
+    policy_type  policy_;
+    rehash_state rehash_state_;  // 渐进式 rehash 时保存旧的 bucket 数组
+    size_type    size_;
+    float        mlf_;
+    hasher       hash_;
+    key_equal    equal_;
 
 private:
-    bool is_equal(const key_type& key1, const key_type& key2)
+    template <class K>
+    bool is_equal(const key_type& key1, const K& key2)
     {
         return equal_(key1, key2);
     }
 
-    bool is_equal(const key_type& key1, const key_type& key2) const
+    template <class K>
+    bool is_equal(const key_type& key1, const K& key2) const
     {
         return equal_(key1, key2);
     }
@@ -520,46 +698,74 @@ private:
         return const_iterator(node, const_cast<hashtable*>(this));
     }
 
+    // 按编号访问 bucket，渐进式 rehash 的迁移过程中，新的 bucket 在前，尚未迁移完的旧 bucket 在后
+    size_type M_bucket_total() const noexcept { return M_bucket_total(incremental()); }
+    size_type M_bucket_total(m_false_type) const noexcept { return bucket_size_; }
+    size_type M_bucket_total(m_true_type) const noexcept
+    { return bucket_size_ + rehash_state_.old_buckets.size(); }
+
+    node_ptr& M_bucket(size_type n) noexcept { return M_bucket(n, incremental()); }
+    node_ptr  M_bucket(size_type n) const noexcept
+    { return const_cast<hashtable*>(this)->M_bucket(n, incremental()); }
+    node_ptr& M_bucket(size_type n, m_false_type) noexcept { return buckets_[n]; }
+    node_ptr& M_bucket(size_type n, m_true_type) noexcept
+    { return n < bucket_size_ ? buckets_[n] : rehash_state_.old_buckets[n - bucket_size_]; }
+
     iterator M_begin() noexcept
     {
-        for(size_type i = 0; i < bucket_size_; ++i)
+        for(size_type i = 0, total = M_bucket_total(); i < total; ++i)
         {
-            if(buckets_[i])return iterator(buckets_[i], this);
+            if(M_bucket(i))return iterator(M_bucket(i), this);
         }
         return iterator(nullptr, this);
     }
     const_iterator M_begin() const noexcept
     {
-        for(size_type i = 0; i < bucket_size_; ++i)
+        for(size_type i = 0, total = M_bucket_total(); i < total; ++i)
         {
-            if(buckets_[i])return M_cit(buckets_[i]);
+            if(M_bucket(i))return M_cit(M_bucket(i));
         }
         return M_cit(nullptr);
     }
 
 public:
     // 构造、复制、移动、析构函数
-    explicit hashtable(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : size_(0), mlf_(1.0f), hash_(hash), equal_(equal)
+    explicit hashtable(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                       const allocator_type& alloc = allocator_type())
+    : alloc_base(node_allocator(alloc)), buckets_(bucket_allocator(alloc)), rehash_state_(bucket_allocator(alloc)),
+      size_(0), mlf_(1.0f), hash_(hash), equal_(equal)
     {
         init(bucket_count);
     }
 
     template <class Iter, typename std::enable_if<mystl::is_input_iterator<Iter>::value, int>::type = 0>
-    hashtable(Iter first, Iter last, size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : size_(mystl::distance(first, last)), mlf_(1.0f), hash_(hash), equal_(equal)
+    hashtable(Iter first, Iter last, size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+              const allocator_type& alloc = allocator_type())
+    : alloc_base(node_allocator(alloc)), buckets_(bucket_allocator(alloc)), rehash_state_(bucket_allocator(alloc)),
+      size_(mystl::distance(first, last)), mlf_(1.0f), hash_(hash), equal_(equal)
     {
         init(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))));
     }
 
-    hashtable(const hashtable& rhs) : hash_(rhs.hash_), equal_(rhs.equal_)
+    hashtable(const hashtable& rhs)
+    : alloc_base(node_alloc_traits::select_on_container_copy_construction(rhs.get_alloc())),
+      buckets_(bucket_allocator(this->get_alloc())), rehash_state_(bucket_allocator(this->get_alloc())),
+      hash_(rhs.hash_), equal_(rhs.equal_)
+    {
+        copy_init(rhs);
+    }
+    hashtable(const hashtable& rhs, const allocator_type& alloc)
+    : alloc_base(node_allocator(alloc)), buckets_(bucket_allocator(alloc)), rehash_state_(bucket_allocator(alloc)),
+      hash_(rhs.hash_), equal_(rhs.equal_)
     {
         copy_init(rhs);
     }
     hashtable(hashtable&& rhs) noexcept
-    : bucket_size_(rhs.bucket_size_), size_(rhs.size_), mlf_(rhs.mlf_), hash_(rhs.hash_), equal_(rhs.equal_)
+    : alloc_base(mystl::move(rhs.get_alloc())), buckets_(mystl::move(rhs.buckets_)),
+      bucket_size_(rhs.bucket_size_), policy_(rhs.policy_), rehash_state_(mystl::move(rhs.rehash_state_)),
+      size_(rhs.size_), mlf_(rhs.mlf_),
+      hash_(rhs.hash_), equal_(rhs.equal_)
     {
-        buckets_ = mystl::move(rhs.buckets_);
         rhs.bucket_size_ = 0;
         rhs.size_ = 0;
         rhs.mlf_ = 0.0f;
@@ -568,7 +774,11 @@ public:
     hashtable& operator=(const hashtable& rhs);
     hashtable& operator=(hashtable&& rhs) noexcept;
 
-    ~hashtable() { clear(); }
+    ~hashtable()
+    {
+        if(!node_alloc_traits::template can_skip_destroy<T>(this->get_alloc()))
+            clear();
+    }
 
     // 迭代器相关操作
     iterator       begin()  noexcept       { return M_begin(); }
@@ -599,6 +809,10 @@ public:
     iterator emplace_unique_use_hint(const_iterator /*hint*/, Args&&... args)
     { return emplace_unique(mystl::forward<Args>(args)...).first; }
 
+    // try_emplace，键值已经存在时什么都不做，args 不会被移动
+    template <class K, class... Args>
+    pair<iterator, bool> try_emplace_unique(K&& key, Args&&... args);
+
     // insert
     iterator             insert_multi_noresize(const value_type& value);
     pair<iterator, bool> insert_unique_noresize(const value_type& value);
@@ -613,8 +827,11 @@ public:
 
     pair<iterator, bool> insert_unique(const value_type& value)
     {
-        rehash_if_need(1);
-        return insert_unique_noresize(value);
+        size_type n = 0;
+        node_ptr cur = find_for_insert(value_traits::get_key(value), n);
+        if(cur)
+            return mystl::make_pair(iterator(cur, this), false);
+        return mystl::make_pair(link_new_node(n, create_node(value)), true);
     }
     pair<iterator, bool> insert_unique(value_type&& value)
     { return emplace_unique(mystl::move(value)); }
@@ -628,7 +845,7 @@ public:
     iterator insert_unique_use_hint(const_iterator /*hint*/, const value_type& value)
     { return insert_unique(value).first; }
     iterator insert_unique_use_hint(const_iterator /*hint*/, value_type&& value)
-    { return emplace_unique(mystl::move(value)); }
+    { return emplace_unique(mystl::move(value)).first; }
 
     template <class InputIter>
     void insert_multi(InputIter first, InputIter last)
@@ -647,35 +864,98 @@ public:
 
     void clear();
 
-    void swap(hashtable& rhs) noexcept;
+    // 节点句柄：extract 把节点从 bucket 中摘下交给句柄，insert 再把句柄中的节点链接进表中，
+    // merge 把 source 中的节点逐个移到本表，都不重新分配节点，也不复制或移动元素
+    node_handle extract(const_iterator pos)
+    {
+        MYSTL_DEBUG(pos.node != nullptr);
+        return node_handle(unlink_node(pos.node), this->get_alloc());
+    }
+    node_handle extract(const key_type& key)
+    {
+        auto p = M_find(key);
+        return p == nullptr ? node_handle() : node_handle(unlink_node(p), this->get_alloc());
+    }
 
-    // 查找相关操作
-    size_type      count(const key_type& key) const;
+    insert_return_type insert_unique(node_handle&& nh);
+    iterator           insert_multi(node_handle&& nh);
 
-    iterator       find(const key_type& key);
-    const_iterator find(const key_type& key) const;
+    // [note]: 同 emplace_hint
+    iterator insert_unique_use_hint(const_iterator /*hint*/, node_handle&& nh)
+    { return insert_unique(mystl::move(nh)).position; }
+    iterator insert_multi_use_hint(const_iterator /*hint*/, node_handle&& nh)
+    { return insert_multi(mystl::move(nh)); }
 
-    pair<iterator, iterator>             equal_range_multi(const key_type& key);
-    pair<const_iterator, const_iterator> equal_range_multi(const key_type& key) const;
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge_unique(hashtable<T, Hash2, KeyEqual2, Alloc, Policy2>& source);
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge_multi(hashtable<T, Hash2, KeyEqual2, Alloc, Policy2>& source);
 
-    pair<iterator, iterator>             equal_range_unique(const key_type& key);
-    pair<const_iterator, const_iterator> equal_range_unique(const key_type& key) const;
+    void swap(hashtable& rhs) noexcept;
+
+    // 查找相关操作
+    // 哈希函数与比较函数都声明了 is_transparent 时，另有接受任意型别 K 的模板版本，不必先构造 key_type
+    size_type count(const key_type& key) const
+    { return M_count(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    size_type count(const K& key) const
+    { return M_count(key); }
+
+    iterator       find(const key_type& key)
+    { return iterator(M_find(key), this); }
+    const_iterator find(const key_type& key) const
+    { return M_cit(M_find(key)); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    iterator       find(const K& key)
+    { return iterator(M_find(key), this); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    const_iterator find(const K& key) const
+    { return M_cit(M_find(key)); }
+
+    pair<iterator, iterator> equal_range_multi(const key_type& key)
+    { return M_range(M_equal_range_multi(key)); }
+    pair<const_iterator, const_iterator> equal_range_multi(const key_type& key) const
+    { return M_crange(M_equal_range_multi(key)); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<iterator, iterator> equal_range_multi(const K& key)
+    { return M_range(M_equal_range_multi(key)); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<const_iterator, const_iterator> equal_range_multi(const K& key) const
+    { return M_crange(M_equal_range_multi(key)); }
+
+    pair<iterator, iterator> equal_range_unique(const key_type& key)
+    { return M_range(M_equal_range_unique(key)); }
+    pair<const_iterator, const_iterator> equal_range_unique(const key_type& key) const
+    { return M_crange(M_equal_range_unique(key)); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<iterator, iterator> equal_range_unique(const K& key)
+    { return M_range(M_equal_range_unique(key)); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<const_iterator, const_iterator> equal_range_unique(const K& key) const
+    { return M_crange(M_equal_range_unique(key)); }
 
     // bucket interface
     local_iterator begin(size_type n) noexcept
     {
         MYSTL_DEBUG(n < size_);
-        return buckets_[n];
+        return M_bucket(n);
     }
     const_local_iterator begin(size_type n) const noexcept
     {
         MYSTL_DEBUG(n < size_);
-        return buckets_[n];
+        return M_bucket(n);
     }
     const_local_iterator cbegin(size_type n) const noexcept
     {
         MYSTL_DEBUG(n < size_);
-        return buckets_[n];
+        return M_bucket(n);
     }
 
     local_iterator end(size_type n) noexcept
@@ -694,11 +974,12 @@ public:
         return nullptr;
     }
 
+    // 渐进式 rehash 的迁移过程中，bucket 的数量包含尚未迁移完的旧 bucket
     size_type bucket_count() const noexcept
-    { return bucket_size_; }
+    { return M_bucket_total(); }
 
     size_type max_bucket_count() const noexcept
-    { return ht_prime_list[PRIME_NUM - 1]; }
+    { return policy_type::max_size(); }
 
     size_type bucket_size(size_type n) const noexcept;
 
@@ -739,12 +1020,42 @@ private:
     node_ptr  create_node(Args&&... args);
     void      destroy_node(node_ptr node);
 
+    // find / count / equal_range 的实现，K 可以是 key_type 或异构查找的键值型别
+    // 区间的尾端为空指针时表示 end()
+    template <class K>
+    node_ptr  M_find(const K& key) const;
+    template <class K>
+    size_type M_count(const K& key) const;
+    template <class K>
+    pair<node_ptr, node_ptr> M_equal_range_multi(const K& key) const;
+    template <class K>
+    pair<node_ptr, node_ptr> M_equal_range_unique(const K& key) const;
+    node_ptr  M_next_bucket_node(size_type n) const;
+
+    pair<iterator, iterator> M_range(const pair<node_ptr, node_ptr>& p)
+    { return mystl::make_pair(iterator(p.first, this), iterator(p.second, this)); }
+    pair<const_iterator, const_iterator> M_crange(const pair<node_ptr, node_ptr>& p) const
+    { return mystl::make_pair(M_cit(p.first), M_cit(p.second)); }
+
     // hash
     size_type next_size(size_type n) const;
-    size_type hash(const key_type& key) const;
-    size_type hash(const key_type& key, size_type n)const;
+    template <class K>
+    size_type hash(const K& key) const { return hash(key, incremental()); }
+    template <class K>
+    size_type hash(const K& key, m_false_type) const;
+    template <class K>
+    size_type hash(const K& key, m_true_type) const;
     void      rehash_if_need(size_type n);
 
+    // incremental rehash
+    void grow(size_type n, m_false_type);
+    void grow(size_type n, m_true_type);
+    void migrate(m_false_type) noexcept {}
+    void migrate(m_true_type);
+    void finish_migrate();
+    void copy_rehash_state(const hashtable&, m_false_type) {}
+    void copy_rehash_state(const hashtable& rhs, m_true_type);
+
     // insert
     template <class InputIter>
     void copy_insert_multi(InputIter first, InputIter last, mystl::input_iterator_tag);
@@ -757,10 +1068,30 @@ private:
     void copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag);
 
     // insert node
-    pair<iterator, bool> insert_node_unique(node_ptr np);
     iterator insert_node_multi(node_ptr np);
 
+    // emplace_unique 的实现：能从参数中直接取得键值时先查找，键值不存在才构造节点，
+    // 否则先构造节点，键值重复时再销毁它
+    template <class... Args>
+    pair<iterator, bool> emplace_unique_dispatch(m_true_type, Args&&... args);
+    template <class... Args>
+    pair<iterator, bool> emplace_unique_dispatch(m_false_type, Args&&... args);
+
+    node_ptr find_for_insert(const key_type& key, size_type& n);
+    iterator link_new_node(size_type n, node_ptr np);
+
+    template <class A>
+    static const key_type& extract_key(const A& arg)
+    { return value_traits::get_key(arg); }
+    template <class A, class B>
+    static const key_type& extract_key(const A& key, const B&)
+    { return key; }
+
+    // 把节点从所在的 bucket 中摘下，但不销毁它
+    node_ptr unlink_node(node_ptr p);
+
     // bucket operator
+    void link_node(bucket_type& bucket, size_type n, node_ptr np);
     void replace_bucket(size_type bucket_count);
     void erase_bucket(size_type n, node_ptr first, node_ptr last);
     void erase_bucket(size_type n, node_ptr last);
@@ -768,46 +1099,66 @@ private:
     // comparision
     bool equal_to_multi(const hashtable& rhs);
     bool equal_to_unique(const hashtable& rhs);
+
+    void swap_data(hashtable& rhs) noexcept;
 };
 
 /*****************************************************************************************/
 
 // 复制赋值运算符
-template <class T, class Hash, class KeyEqual>
-hashtable<T, Hash, KeyEqual>& hashtable<T, Hash, KeyEqual>::operator=(const hashtable& rhs)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>& hashtable<T, Hash, KeyEqual, Alloc, Policy>::operator=(const hashtable& rhs)
 {
     if(this != &rhs)
     {
-        hashtable tmp(rhs);
-        swap(tmp);
+        // 需要传播分配器时用 rhs 的分配器复制，tmp 换回原分配器以释放原有结点
+        hashtable tmp(rhs, allocator_type(node_alloc_traits::propagate_on_container_copy_assignment::value
+                                          ? rhs.get_alloc() : this->get_alloc()));
+        swap_data(tmp);
+        mystl::swap(this->get_alloc(), tmp.get_alloc());
     }
     return *this;
 }
 
 // 移动赋值运算符
-template <class T, class Hash, class KeyEqual>
-hashtable<T, Hash, KeyEqual>& hashtable<T, Hash, KeyEqual>::operator=(hashtable&& rhs) noexcept
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>& hashtable<T, Hash, KeyEqual, Alloc, Policy>::operator=(hashtable&& rhs) noexcept
 {
-    if(this != &rhs)
+    if(this == &rhs)return *this;
+    if(node_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
     {
         hashtable tmp(mystl::move(rhs));
-        swap(tmp);
+        swap_data(tmp);
+        if(node_alloc_traits::propagate_on_container_move_assignment::value)
+            mystl::swap(this->get_alloc(), tmp.get_alloc());
+    }
+    else
+    {
+        // 分配器不相等且不传播时，只能逐个移动元素
+        clear();
+        hash_ = rhs.hash_;
+        equal_ = rhs.equal_;
+        mlf_ = rhs.mlf_;
+        rehash_if_need(rhs.size_);
+        for(auto it = rhs.begin(); it != rhs.end(); ++it)
+            insert_node_multi(create_node(mystl::move(*it)));
+        rhs.clear();
     }
     return *this;
 }
 
 // 就地构造元素，键值允许重复
 // 强异常安全保证
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class... Args>
-typename hashtable<T, Hash, KeyEqual>::iterator
-hashtable<T, Hash, KeyEqual>::emplace_multi(Args&&... args)
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::emplace_multi(Args&&... args)
 {
     auto np = create_node(mystl::forward<Args>(args)...);
     try
     {
-        if((float)(size_ + 1) > (float)bucket_size_ * max_load_factor())
-            rehash(size_ + 1);
+        rehash_if_need(1);
     }
     catch(...)
     {
@@ -817,54 +1168,95 @@ hashtable<T, Hash, KeyEqual>::emplace_multi(Args&&... args)
     return insert_node_multi(np);
 }
 
-// 就地构造元素，键值允许重复
+// 就地构造元素，键值不允许重复
 // 强异常安全保证
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class... Args>
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator, bool>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::emplace_unique(Args&&... args)
+{
+    return emplace_unique_dispatch(can_extract_key<key_type, value_type, Args...>(),
+                                   mystl::forward<Args>(args)...);
+}
+
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class... Args>
-pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool>
-hashtable<T, Hash, KeyEqual>::emplace_unique(Args&&... args)
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator, bool>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::emplace_unique_dispatch(m_true_type, Args&&... args)
+{
+    size_type n = 0;
+    node_ptr cur = find_for_insert(extract_key(args...), n);
+    if(cur)
+        return mystl::make_pair(iterator(cur, this), false);
+    return mystl::make_pair(link_new_node(n, create_node(mystl::forward<Args>(args)...)), true);
+}
+
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class... Args>
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator, bool>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::emplace_unique_dispatch(m_false_type, Args&&... args)
 {
     auto np = create_node(mystl::forward<Args>(args)...);
+    size_type n = 0;
+    node_ptr cur = nullptr;
     try
     {
-        if((float)(size_ + 1) > (float)bucket_size_ * max_load_factor())
-            rehash(size_ + 1);
+        cur = find_for_insert(value_traits::get_key(np->value), n);
     }
     catch(...)
     {
         destroy_node(np);
         throw;
     }
-    return insert_node_unique(np);
+    if(cur)
+    {
+        destroy_node(np);
+        return mystl::make_pair(iterator(cur, this), false);
+    }
+    return mystl::make_pair(link_new_node(n, np), true);
 }
 
+// 键值 key 不存在时，用 key 与 args 构造 mapped_type 后插入，否则什么都不做
+// 先查找再构造节点，键值已经存在时不会分配空间，也不会移动 key 与 args
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K, class... Args>
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator, bool>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::try_emplace_unique(K&& key, Args&&... args)
+{
+    size_type n = 0;
+    node_ptr cur = find_for_insert(key, n);
+    if(cur)
+        return mystl::make_pair(iterator(cur, this), false);
+    node_ptr np = create_node(mystl::forward<K>(key), mapped_type(mystl::forward<Args>(args)...));
+    return mystl::make_pair(link_new_node(n, np), true);
+}
 
 // 在不需要重建表格的情况下插入新节点，键值不允许重复
-template <class T, class Hash, class KeyEqual>
-pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool>
-hashtable<T, Hash, KeyEqual>::insert_unique_noresize(const value_type& value)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator, bool>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::insert_unique_noresize(const value_type& value)
 {
     const auto n = hash(value_traits::get_key(value));
-    auto first = buckets_[n];
+    auto first = M_bucket(n);
     for(auto cur = first; cur; cur = cur->next)
     {
         if(is_equal(value_traits::get_key(cur->value), value_traits::get_key(value)))
             return mystl::make_pair(iterator(cur, this), false);
     }
     auto tmp = create_node(value);
-    tmp->next = buckets_[n];
-    buckets_[n] = tmp;
+    tmp->next = M_bucket(n);
+    M_bucket(n) = tmp;
     ++size_;
     return mystl::make_pair(iterator(tmp, this), true);
 }
 
 // 在不需要重建表格的情况下插入新节点，键值允许重复
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::iterator
-hashtable <T, Hash, KeyEqual>::insert_multi_noresize(const value_type& value)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::insert_multi_noresize(const value_type& value)
 {
     const auto n = hash(value_traits::get_key(value));
-    auto first = buckets_[n];
+    auto first = M_bucket(n);
     auto tmp = create_node(value);
     for(auto cur = first; cur; cur = cur->next)
     {   // 如果链表中存在相同键值的节点就马上插入，然后返回
@@ -877,53 +1269,94 @@ hashtable <T, Hash, KeyEqual>::insert_multi_noresize(const value_type& value)
         }
     }
     // 否则插入在链表头部
-    tmp->next = buckets_[n];
-    buckets_[n] = tmp;
+    tmp->next = M_bucket(n);
+    M_bucket(n) = tmp;
     ++size_;
     return iterator(tmp, this);
 }
 
 // 删除迭代器所指的节点
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::erase(const_iterator pos)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::erase(const_iterator pos)
 {
     auto p = pos.node;
     if(p != nullptr)
+        destroy_node(unlink_node(p));
+}
+
+// 把句柄中的节点插入表中，键值不允许重复
+// 键值已经存在时节点仍然留在返回值的 node 中，position 指向已经存在的元素
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::insert_return_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::insert_unique(node_handle&& nh)
+{
+    if(nh.empty())
+        return insert_return_type{end(), false, node_handle()};
+    MYSTL_DEBUG(nh.node_alloc() == this->get_alloc());
+    size_type n = 0;
+    node_ptr cur = find_for_insert(value_traits::get_key(nh.ptr_->value), n);
+    if(cur)
+        return insert_return_type{iterator(cur, this), false, mystl::move(nh)};
+    return insert_return_type{link_new_node(n, nh.release()), true, node_handle()};
+}
+
+// 把句柄中的节点插入表中，键值允许重复
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::insert_multi(node_handle&& nh)
+{
+    if(nh.empty())
+        return end();
+    MYSTL_DEBUG(nh.node_alloc() == this->get_alloc());
+    rehash_if_need(1);
+    return insert_node_multi(nh.release());
+}
+
+// 把 source 中键值在本表中不存在的节点移到本表，键值重复的节点留在 source 中
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class Hash2, class KeyEqual2, class Policy2>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::
+merge_unique(hashtable<T, Hash2, KeyEqual2, Alloc, Policy2>& source)
+{
+    MYSTL_DEBUG(this->get_alloc() == source.get_alloc());
+    if(static_cast<void*>(&source) == static_cast<void*>(this))
+        return;
+    for(auto it = source.begin(); it.node != nullptr; )
     {
-        const auto n = hash(value_traits::get_key(p->value));
-        auto cur = buckets_[n];
-        if(cur == p)
-        {   // p 位于链表头部
-            buckets_[n] = cur->next;
-            destroy_node(cur);
-            --size_;
-        }
-        else
-        {
-            auto next = cur->next;
-            while(next)
-            {
-                if(next == p)
-                {
-                    cur->next = next->next;
-                    destroy_node(next);
-                    --size_;
-                    break;
-                }
-                cur = next;
-                next = cur->next;
-            }
-        }
+        auto p = it.node;
+        ++it;
+        size_type n = 0;
+        if(find_for_insert(value_traits::get_key(p->value), n) == nullptr)
+            link_new_node(n, source.unlink_node(p));
+    }
+}
+
+// 把 source 中的全部节点移到本表
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class Hash2, class KeyEqual2, class Policy2>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::
+merge_multi(hashtable<T, Hash2, KeyEqual2, Alloc, Policy2>& source)
+{
+    MYSTL_DEBUG(this->get_alloc() == source.get_alloc());
+    if(static_cast<void*>(&source) == static_cast<void*>(this))
+        return;
+    rehash_if_need(source.size());
+    for(auto it = source.begin(); it.node != nullptr; )
+    {
+        auto p = it.node;
+        ++it;
+        insert_node_multi(source.unlink_node(p));
     }
 }
 
 // 删除[first, last)内的节点
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::erase(const_iterator first, const_iterator last)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::erase(const_iterator first, const_iterator last)
 {
     if(first.node == last.node)return;
-    auto first_bucket = first.node ? hash(value_traits::get_key(first.node->value)) : bucket_size_;
-    auto last_bucket = last.node ? hash(value_traits::get_key(last.node->value)) : bucket_size_;
+    const auto total = M_bucket_total();
+    auto first_bucket = first.node ? hash(value_traits::get_key(first.node->value)) : total;
+    auto last_bucket = last.node ? hash(value_traits::get_key(last.node->value)) : total;
     if(first_bucket == last_bucket)
     {   // 如果在 bucket 同一个位置
         erase_bucket(first_bucket, first.node, last.node);
@@ -933,37 +1366,38 @@ void hashtable<T, Hash, KeyEqual>::erase(const_iterator first, const_iterator la
         erase_bucket(first_bucket, first.node, nullptr);
         for(auto n = first_bucket + 1; n < last_bucket; ++n)
         {
-            if(buckets_[n])erase_bucket(n, nullptr);
+            if(M_bucket(n))erase_bucket(n, nullptr);
         }
-        if(last_bucket != bucket_size_)erase_bucket(last_bucket, last.node);
+        if(last_bucket != total)erase_bucket(last_bucket, last.node);
     }
 }
 
 // 删除键值为 key 的节点
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable <T, Hash, KeyEqual>::erase_multi(const key_type& key)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::erase_multi(const key_type& key)
 {
     auto p = equal_range_multi(key);
     if(p.first.node != nullptr)
     {
+        const size_type n = mystl::distance(p.first, p.second);
         erase(p.first, p.second);
-        return mystl::distance(p.first, p.second);
+        return n;
     }
     return 0;
 }
 
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable <T, Hash, KeyEqual>::erase_unique(const key_type& key)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::erase_unique(const key_type& key)
 {
     const auto n = hash(key);
-    auto first = buckets_[n];
+    auto first = M_bucket(n);
     if(first)
     {
         if(is_equal(value_traits::get_key(first->value), key))
         {
-            buckets_[n] = first->next;
+            M_bucket(n) = first->next;
             destroy_node(first);
             --size_;
             return 1;
@@ -989,33 +1423,34 @@ hashtable <T, Hash, KeyEqual>::erase_unique(const key_type& key)
 }
 
 // 清空 hashtable
-template <class T, class Hash, class KeyEqual>
-void hashtable <T, Hash, KeyEqual>::clear()
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::clear()
 {
     if(size_ != 0)
     {
-        for(size_type i = 0; i < bucket_size_; ++i)
+        for(size_type i = 0, total = M_bucket_total(); i < total; ++i)
         {
-            node_ptr cur = buckets_[i];
+            node_ptr cur = M_bucket(i);
             while(cur)
             {
                 node_ptr next = cur->next;
                 destroy_node(cur);
                 cur = next; 
             }
-            buckets_[i] = nullptr;
+            M_bucket(i) = nullptr;
         }
         size_ = 0;
     }
+    finish_migrate();
 }
 
 // 在某个 bucket 节点的个数
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable<T, Hash, KeyEqual>::bucket_size(size_type n) const noexcept
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::bucket_size(size_type n) const noexcept
 {
     size_type result = 0;
-    for(auto cur = buckets_[n]; cur; cur = cur->next)
+    for(auto cur = M_bucket(n); cur; cur = cur->next)
     {
         ++result;
     }
@@ -1023,10 +1458,11 @@ hashtable<T, Hash, KeyEqual>::bucket_size(size_type n) const noexcept
 }
 
 // 重新对元素进行一遍哈希，插入到新的位置
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::rehash(size_type count)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::rehash(size_type count)
 {
-    auto n = ht_next_prime(count);
+    finish_migrate();
+    auto n = next_size(count);
     if(n > bucket_size_)
     {
         replace_bucket(n);
@@ -1041,171 +1477,116 @@ void hashtable<T, Hash, KeyEqual>::rehash(size_type count)
     }
 }
 
-// 查找键值为 key 的节点，返回其迭代器
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::iterator
-hashtable<T, Hash, KeyEqual>::find(const key_type& key)
+// 查找键值为 key 的节点，找不到时返回空指针
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::M_find(const K& key) const
 {
     const auto n = hash(key);
-    node_ptr first = buckets_[n];
+    node_ptr first = M_bucket(n);
     for(; first && !is_equal(value_traits::get_key(first->value), key); first = first->next);
-    return iterator(first, this);
-}
-
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::const_iterator
-hashtable<T, Hash, KeyEqual>::find(const key_type& key) const
-{
-    const auto n = hash(key);
-    node_ptr first = buckets_[n];
-    for(; first && !is_equal(value_traits::get_key(first->value), key); first = first->next);
-    return M_cit(first);
+    return first;
 }
 
 // 查找键值为 key 出现的次数
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable<T, Hash, KeyEqual>::count(const key_type& key) const
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::M_count(const K& key) const
 {
     const auto n = hash(key);
     size_type result = 0;
-    for(node_ptr cur = buckets_[n]; cur; cur = cur->next)
+    for(node_ptr cur = M_bucket(n); cur; cur = cur->next)
     {
         if(is_equal(value_traits::get_key(cur->value), key))++result;
     }
     return result;
 }
 
-// 查找与键值 key 相等的区间，返回一个 pair，指向相等区间的首尾
-template <class T, class Hash, class KeyEqual>
-pair<typename hashtable<T, Hash, KeyEqual>::iterator, typename hashtable<T, Hash, KeyEqual>::iterator>
-hashtable<T, Hash, KeyEqual>::equal_range_multi(const key_type& key)
+// 第 n 个 bucket 之后的第一个节点，没有时返回空指针
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::M_next_bucket_node(size_type n) const
 {
-    const auto n = hash(key);
-    for(node_ptr first = buckets_[n]; first; first = first->next)
+    for(auto m = n + 1, total = M_bucket_total(); m < total; ++m)
     {
-        if(is_equal(value_traits::get_key(first->value), key))
-        {
-            for(node_ptr second = first->next; second; second = second->next){
-                if(!is_equal(value_traits::get_key(second->value), key))
-                {
-                    return mystl::make_pair(iterator(first, this), iterator(second, this));
-                }
-            }
-            for(auto m = n + 1; m < bucket_size_; ++m)
-            {
-                if(buckets_[m])
-                {
-                    return mystl::make_pair(iterator(first, this), iterator(buckets_[m], this));
-                }
-            }
-            return mystl::make_pair(iterator(first, this), end());
-        }
+        if(M_bucket(m))
+            return M_bucket(m);
     }
-    return mystl::make_pair(end(), end());
+    return nullptr;
 }
 
-template <class T, class Hash, class KeyEqual>
-pair<typename hashtable<T, Hash, KeyEqual>::const_iterator, typename hashtable<T, Hash, KeyEqual>::const_iterator>
-hashtable<T, Hash, KeyEqual>::equal_range_multi(const key_type& key) const
+// 查找与键值 key 相等的区间，返回一个 pair，指向相等区间的首尾
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K>
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr, typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::M_equal_range_multi(const K& key) const
 {
     const auto n = hash(key);
-    for(node_ptr first = buckets_[n]; first; first = first->next)
+    for(node_ptr first = M_bucket(n); first; first = first->next)
     {
         if(is_equal(value_traits::get_key(first->value), key))
         {
             for(node_ptr second = first->next; second; second = second->next){
                 if(!is_equal(value_traits::get_key(second->value), key))
                 {
-                    return mystl::make_pair(M_cit(first), M_cit(second));
-                }
-            }
-            for(auto m = n + 1; m < bucket_size_; ++m)
-            {
-                if(buckets_[m])
-                {
-                    return mystl::make_pair(M_cit(first), M_cit(buckets_[m]));
+                    return mystl::make_pair(first, second);
                 }
             }
-            return mystl::make_pair(M_cit(first), cend());
+            return mystl::make_pair(first, M_next_bucket_node(n));
         }
     }
-    return mystl::make_pair(cend(), cend());
+    return mystl::make_pair(node_ptr(nullptr), node_ptr(nullptr));
 }
 
-template <class T, class Hash, class KeyEqual>
-pair<typename hashtable<T, Hash, KeyEqual>::iterator, typename hashtable<T, Hash, KeyEqual>::iterator>
-hashtable<T, Hash, KeyEqual>::equal_range_unique(const key_type& key)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K>
+pair<typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr, typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr>
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::M_equal_range_unique(const K& key) const
 {
     const auto n = hash(key);
-    for(node_ptr first = buckets_[n]; first; first = first->next)
+    for(node_ptr first = M_bucket(n); first; first = first->next)
     {
         if(is_equal(value_traits::get_key(first->value), key))
         {
-            if(first->next)
-            {
-                return mystl::make_pair(iterator(first, this), iterator(first->next, this));
-            }
-            for(auto m = n + 1; m < bucket_size_; ++m)
-            {
-                if(buckets_[m])
-                {
-                    return mystl::make_pair(iterator(first, this), iterator(buckets_[m], this));
-                }
-            }
-            return mystl::make_pair(iterator(first, this), end());
+            return mystl::make_pair(first, first->next ? first->next : M_next_bucket_node(n));
         }
     }
-    return mystl::make_pair(end(), end());
+    return mystl::make_pair(node_ptr(nullptr), node_ptr(nullptr));
 }
 
-template <class T, class Hash, class KeyEqual>
-pair<typename hashtable<T, Hash, KeyEqual>::const_iterator, typename hashtable<T, Hash, KeyEqual>::const_iterator>
-hashtable<T, Hash, KeyEqual>::equal_range_unique(const key_type& key) const
+// 交换 hashtable
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::swap(hashtable& rhs) noexcept
 {
-    const auto n = hash(key);
-    for(node_ptr first = buckets_[n]; first; first = first->next)
+    if(this != &rhs)
     {
-        if(is_equal(value_traits::get_key(first->value), key))
-        {
-            if(first->next)
-            {
-                return mystl::make_pair(M_cit(first), M_cit(first->next));
-            }
-            for(auto m = n + 1; m < bucket_size_; ++m)
-            {
-                if(buckets_[m])
-                {
-                    return mystl::make_pair(M_cit(first), M_cit(buckets_[m]));
-                }
-            }
-            return mystl::make_pair(M_cit(first), cend());
-        }
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
     }
-    return mystl::make_pair(cend(), cend());
 }
 
-// 交换 hashtable
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::swap(hashtable& rhs) noexcept
+// swap_data 函数，只交换数据，不交换结点的分配器
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::swap_data(hashtable& rhs) noexcept
 {
-    if(this != &rhs)
-    {
-        buckets_.swap(rhs.buckets_);
-        mystl::swap(bucket_size_, rhs.bucket_size_);
-        mystl::swap(size_, rhs.size_);
-        mystl::swap(mlf_, rhs.mlf_);
-        mystl::swap(hash_, rhs.hash_);
-        mystl::swap(equal_, rhs.equal_);
-    }
+    buckets_.swap(rhs.buckets_);
+    mystl::swap(bucket_size_, rhs.bucket_size_);
+    mystl::swap(policy_, rhs.policy_);
+    rehash_state_.swap(rhs.rehash_state_);
+    mystl::swap(size_, rhs.size_);
+    mystl::swap(mlf_, rhs.mlf_);
+    mystl::swap(hash_, rhs.hash_);
+    mystl::swap(equal_, rhs.equal_);
 }
 
 /****************************************************************************************/
 // helper function
 
 // init 函数
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::init(size_type n)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::init(size_type n)
 {
     const auto bucket_nums = next_size(n);
     try
@@ -1220,115 +1601,205 @@ void hashtable<T, Hash, KeyEqual>::init(size_type n)
         throw;
     }
     bucket_size_ = buckets_.size();
+    policy_ = policy_type(bucket_size_);
 }
 
 // copy_init 函数
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::copy_init(const hashtable& rhs)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::copy_init(const hashtable& rhs)
 {
     bucket_size_ = 0;
+    size_ = 0;
+    mlf_ = rhs.mlf_;
     buckets_.reserve(rhs.bucket_size_);
     buckets_.assign(rhs.bucket_size_, nullptr);
+    copy_rehash_state(rhs, incremental());
+    bucket_size_ = rhs.bucket_size_;
+    policy_ = rhs.policy_;
     try
     {
-        for(size_type i = 0; i < rhs.bucket_size_; ++i)
+        for(size_type i = 0, total = rhs.M_bucket_total(); i < total; ++i)
         {
-            node_ptr cur = rhs.buckets_[i];
+            node_ptr cur = rhs.M_bucket(i);
             if(cur)
             {
                 auto copy_node = create_node(cur->value);
-                buckets_[i] = copy_node;
+                M_bucket(i) = copy_node;
+                ++size_;
                 for(auto next = cur->next; next; cur = next, next = cur->next)
                 {
                     copy_node->next = create_node(next->value);
                     copy_node = copy_node->next;
+                    ++size_;
                 }
                 copy_node->next = nullptr;
             }
         }
-        bucket_size_ = rhs.bucket_size_;
-        size_ = rhs.size_;
-        mlf_ = rhs.mlf_;
     }
     catch(...)
     {
         clear();
+        throw;
     }
 }
 
 // create_node 函数
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class... Args>
-typename hashtable<T, Hash, KeyEqual>::node_ptr
-hashtable<T, Hash, KeyEqual>::create_node(Args&&... args)
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::create_node(Args&&... args)
 {
-    node_ptr tmp = node_allocator::allocate(1);
+    node_ptr tmp = node_alloc_traits::allocate(this->get_alloc(), 1);
     try
     {
-        data_allocator::construct(mystl::address_of(tmp->value), mystl::forward<Args>(args)...);
+        node_alloc_traits::construct(this->get_alloc(), mystl::address_of(tmp->value), mystl::forward<Args>(args)...);
         tmp->next = nullptr;
     }
     catch(...)
     {
-        node_allocator::deallocate(tmp);
+        node_alloc_traits::deallocate(this->get_alloc(), tmp, 1);
         throw;
     }
     return tmp;
 }
 
 // destroy_node 函数
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::destroy_node(node_ptr node)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::destroy_node(node_ptr node)
 {
-    data_allocator::destroy(mystl::address_of(node->value));
-    node_allocator::deallocate(node);
+    node_alloc_traits::destroy(this->get_alloc(), mystl::address_of(node->value));
+    node_alloc_traits::deallocate(this->get_alloc(), node, 1);
     node = nullptr;
 }
 
 // next_size 函数
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable<T, Hash, KeyEqual>::next_size(size_type n) const
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::next_size(size_type n) const
 {
-    return ht_next_prime(n);
+    return policy_type::next_size(n);
 }
 
-// hash 函数
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable<T, Hash, KeyEqual>::hash(const key_type& key, size_type n) const
+// hash 函数，由 bucket 策略把哈希值映射到 bucket
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::hash(const K& key, m_false_type) const
 {
-    return hash_(key) % n;
+    return policy_.bucket(hash_(key));
 }
 
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::size_type
-hashtable<T, Hash, KeyEqual>::hash(const key_type& key) const
+// 迁移过程中，旧 bucket 尚未迁移的键值仍在旧 bucket 中，编号排在新 bucket 之后
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+template <class K>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::size_type
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::hash(const K& key, m_true_type) const
 {
-    return hash_(key) % bucket_size_;
+    const size_t h = hash_(key);
+    if(rehash_state_.migrating())
+    {
+        const auto n = rehash_state_.old_policy.bucket(h);
+        if(n >= rehash_state_.migrate_pos)
+            return bucket_size_ + n;
+    }
+    return policy_.bucket(h);
 }
 
 // rehash_if_need 函数
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::rehash_if_need(size_type n)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::rehash_if_need(size_type n)
 {
     if(static_cast<float>(size_ + n) > (float)bucket_size_ * max_load_factor())
-        rehash(size_ + n);
+        grow(size_ + n, incremental());
+    migrate(incremental());
+}
+
+// grow 函数
+// 非渐进式时直接 rehash，渐进式时只换上新的 bucket 数组，旧数组留待之后逐步迁移
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::grow(size_type n, m_false_type)
+{
+    rehash(n);
+}
+
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::grow(size_type n, m_true_type)
+{
+    finish_migrate();  // 上一轮迁移还没有完成时，先把它完成
+    const auto bucket_count = next_size(n);
+    if(bucket_count <= bucket_size_ || size_ == 0)
+    {
+        rehash(n);
+        return;
+    }
+    bucket_type bucket(bucket_count, nullptr, bucket_allocator(this->get_alloc()));
+    rehash_state_.old_buckets.swap(buckets_);
+    rehash_state_.old_policy = policy_;
+    rehash_state_.migrate_pos = 0;
+    buckets_.swap(bucket);
+    bucket_size_ = bucket_count;
+    policy_ = policy_type(bucket_count);
+}
+
+// migrate 函数
+// 把接下来 migrate_step 个旧 bucket 中的节点链接到新的 bucket 中，全部迁移完后释放旧数组
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::migrate(m_true_type)
+{
+    if(!rehash_state_.migrating())
+        return;
+    auto& old = rehash_state_.old_buckets;
+    auto pos = rehash_state_.migrate_pos;
+    const auto last = mystl::min(old.size(), pos + policy_type::migrate_step);
+    for(; pos < last; ++pos)
+    {
+        for(auto first = old[pos]; first; )
+        {
+            auto next = first->next;
+            link_node(buckets_, policy_.bucket(hash_(value_traits::get_key(first->value))), first);
+            first = next;
+        }
+        old[pos] = nullptr;
+    }
+    rehash_state_.migrate_pos = pos;
+    if(pos == old.size())
+    {
+        bucket_type empty(bucket_allocator(this->get_alloc()));
+        old.swap(empty);
+        rehash_state_.migrate_pos = 0;
+    }
+}
+
+// finish_migrate 函数，一次完成剩余的迁移
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::finish_migrate()
+{
+    while(rehash_state_.migrating())
+        migrate(incremental());
+}
+
+// copy_rehash_state 函数，复制 rhs 的迁移进度，旧 bucket 的节点由 copy_init 复制
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::copy_rehash_state(const hashtable& rhs, m_true_type)
+{
+    rehash_state_.old_buckets.assign(rhs.rehash_state_.old_buckets.size(), nullptr);
+    rehash_state_.old_policy = rhs.rehash_state_.old_policy;
+    rehash_state_.migrate_pos = rhs.rehash_state_.migrate_pos;
 }
 
 // copy_insert_multi
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class InputIter>
-void hashtable<T, Hash, KeyEqual>::
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::
 copy_insert_multi(InputIter first, InputIter last, mystl::input_iterator_tag)
 {
     rehash_if_need(mystl::distance(first, last));
     for(; first != last; ++first)insert_multi_noresize(*first);
 }
 
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class ForwardIter>
-void hashtable<T, Hash, KeyEqual>::
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::
 copy_insert_multi(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag)
 {
     size_type n = mystl::distance(first, last);// 这里forward_iterator_tag是不是有点问题
@@ -1338,9 +1809,9 @@ copy_insert_multi(ForwardIter first, ForwardIter last, mystl::forward_iterator_t
 }
 
 // copy_insert_unique
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class InputIter>
-void hashtable<T, Hash, KeyEqual>::
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::
 copy_insert_unique(InputIter first, InputIter last, mystl::input_iterator_tag)
 {
     rehash_if_need(mystl::distance(first, last));
@@ -1348,9 +1819,9 @@ copy_insert_unique(InputIter first, InputIter last, mystl::input_iterator_tag)
         insert_unique_noresize(*first);
 }
 
-template <class T, class Hash, class KeyEqual>
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
 template <class ForwardIter>
-void hashtable<T, Hash, KeyEqual>::
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::
 copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag)
 {
     size_type n = mystl::distance(first, last);
@@ -1360,15 +1831,15 @@ copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_
 }
 
 // insert_node_multi 函数
-template <class T, class Hash, class KeyEqual>
-typename hashtable<T, Hash, KeyEqual>::iterator
-hashtable<T, Hash, KeyEqual>::insert_node_multi(node_ptr np)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::insert_node_multi(node_ptr np)
 {
     const auto n = hash(value_traits::get_key(np->value));
-    auto cur = buckets_[n];
+    auto cur = M_bucket(n);
     if(!cur)
     {
-        buckets_[n] = np;
+        M_bucket(n) = np;
         ++size_;
         return iterator(np, this);
     }
@@ -1382,80 +1853,121 @@ hashtable<T, Hash, KeyEqual>::insert_node_multi(node_ptr np)
             return iterator(np, this);
         }
     }
-    np->next = buckets_[n];
-    buckets_[n] = np;
+    np->next = M_bucket(n);
+    M_bucket(n) = np;
     ++size_;
     return iterator(np, this);
 }
 
-// insert_node_unique 函数
-template <class T, class Hash, class KeyEqual>
-pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool>
-hashtable<T, Hash, KeyEqual>::insert_node_unique(node_ptr np)
+// find_for_insert 函数
+// 先在 key 所在的 bucket 中查找，找到时返回该节点，不会扩容；
+// 否则确定要插入，这时才按需要扩容，返回空指针，并由 n 带回插入的 bucket
+// 被移动后的表没有 bucket，无法查找，先为它申请 bucket
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::find_for_insert(const key_type& key, size_type& n)
 {
-    const auto n = hash(value_traits::get_key(np->value));
-    auto cur = buckets_[n];
-    if(!cur)
+    if(bucket_size_ == 0)
+        rehash_if_need(1);
+    n = hash(key);
+    for(node_ptr cur = M_bucket(n); cur; cur = cur->next)
     {
-        buckets_[n] = np;
-        ++size_;
-        return mystl::make_pair(iterator(np, this), true);
+        if(is_equal(value_traits::get_key(cur->value), key))
+            return cur;
     }
-    for(; cur; cur = cur->next){
+    if(static_cast<float>(size_ + 1) > (float)bucket_size_ * max_load_factor() || rehash_state_.migrating())
+    {
+        // 扩容或迁移会改变 bucket 布局，需要重新定位
+        rehash_if_need(1);
+        n = hash(key);
+    }
+    return nullptr;
+}
+
+// link_new_node 函数
+// 把键值不重复的新节点链接到 bucket[n] 的头部
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::iterator
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::link_new_node(size_type n, node_ptr np)
+{
+    np->next = M_bucket(n);
+    M_bucket(n) = np;
+    ++size_;
+    return iterator(np, this);
+}
+
+// unlink_node 函数
+// 把节点 p 从所在 bucket 的链表中摘下，节点本身与其中的元素保持不变
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+typename hashtable<T, Hash, KeyEqual, Alloc, Policy>::node_ptr
+hashtable<T, Hash, KeyEqual, Alloc, Policy>::unlink_node(node_ptr p)
+{
+    const auto n = hash(value_traits::get_key(p->value));
+    auto cur = M_bucket(n);
+    if(cur == p)
+    {   // p 位于链表头部
+        M_bucket(n) = cur->next;
+    }
+    else
+    {
+        while(cur->next != p)
+            cur = cur->next;
+        cur->next = p->next;
+    }
+    p->next = nullptr;
+    --size_;
+    return p;
+}
+
+// link_node 函数
+// 把节点链接到 bucket[n]，链表中已有相同键值的节点时紧跟在它之后，保持相同键值的节点相邻
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::link_node(bucket_type& bucket, size_type n, node_ptr np)
+{
+    for(auto cur = bucket[n]; cur; cur = cur->next)
+    {
         if(is_equal(value_traits::get_key(cur->value), value_traits::get_key(np->value)))
         {
-            return mystl::make_pair(iterator(cur, this), false);
+            np->next = cur->next;
+            cur->next = np;
+            return;
         }
     }
-    np->next = buckets_[n];
-    buckets_[n] = np;
-    ++size_;
-    return mystl::make_pair(iterator(np, this), true);
+    np->next = bucket[n];
+    bucket[n] = np;
 }
 
 // replace_bucket 函数
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::replace_bucket(size_type bucket_count)
+// 把原有的结点重新链接到新的 bucket 中，不复制元素
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::replace_bucket(size_type bucket_count)
 {
-    bucket_type bucket(bucket_count);
+    bucket_type bucket(bucket_count, nullptr, bucket_allocator(this->get_alloc()));
+    const policy_type policy(bucket_count);
     if(size_ != 0)
     {
         for(size_type i = 0; i < bucket_size_; ++i)
         {
-            for(auto first = buckets_[i]; first; first = first->next)
+            for(auto first = buckets_[i]; first; )
             {
-                auto tmp = create_node(first->value);
-                const auto n = hash(value_traits::get_key(first->value), bucket_count);
-                auto f = bucket[n];
-                bool is_inserted = false;
-                for(auto cur = f; cur; cur = cur->next)
-                {
-                    if(is_equal(value_traits::get_key(cur->value), value_traits::get_key(first->value)))
-                    {
-                        tmp->next = cur->next;
-                        cur->next = tmp;
-                        is_inserted = true;
-                        break;
-                    }
-                }
-                if(!is_inserted)
-                {
-                    tmp->next = f;
-                    bucket[n] = tmp;
-                }
+                auto next = first->next;
+                link_node(bucket, policy.bucket(hash_(value_traits::get_key(first->value))), first);
+                first = next;
             }
+            buckets_[i] = nullptr;
         }
     }
     buckets_.swap(bucket);
     bucket_size_ = buckets_.size();
+    policy_ = policy;
 }
 
 // erase_bucket 函数
 // 在第 n 个 bucket 内，删除 [first, last) 的节点
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::erase_bucket(size_type n, node_ptr first, node_ptr last)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::erase_bucket(size_type n, node_ptr first, node_ptr last)
 {
-    auto cur = buckets_[n];
+    auto cur = M_bucket(n);
     if(cur == first)
     {
         erase_bucket(n, last);
@@ -1476,10 +1988,10 @@ void hashtable<T, Hash, KeyEqual>::erase_bucket(size_type n, node_ptr first, nod
 
 // erase_bucket 函数
 // 在第 n 个 bucket 内，删除 [buckets_[n], last) 的节点
-template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::erase_bucket(size_type n, node_ptr last)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void hashtable<T, Hash, KeyEqual, Alloc, Policy>::erase_bucket(size_type n, node_ptr last)
 {
-    auto cur = buckets_[n];
+    auto cur = M_bucket(n);
     while(cur != last)
     {
         auto next = cur->next;
@@ -1487,12 +1999,12 @@ void hashtable<T, Hash, KeyEqual>::erase_bucket(size_type n, node_ptr last)
         cur = next;
         --size_;
     }
-    buckets_[n] = last;
+    M_bucket(n) = last;
 }
 
 // equal_to_multi 函数
-template <class T, class Hash, class KeyEqual>
-bool hashtable<T, Hash, KeyEqual>::equal_to_multi(const hashtable& rhs)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+bool hashtable<T, Hash, KeyEqual, Alloc, Policy>::equal_to_multi(const hashtable& rhs)
 {
     if(size != rhs.size_)return false;
     for(auto f = begin(), l = end(); f != l;)
@@ -1508,8 +2020,8 @@ bool hashtable<T, Hash, KeyEqual>::equal_to_multi(const hashtable& rhs)
 }
 
 // equal_to_unique 函数
-template <class T, class Hash, class KeyEqual>
-bool hashtable<T, Hash, KeyEqual>::equal_to_unique(const hashtable& rhs)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+bool hashtable<T, Hash, KeyEqual, Alloc, Policy>::equal_to_unique(const hashtable& rhs)
 {
     if(size_ != rhs.size_)return false;
     for(auto first = begin(), last = end(); first != last; ++first)
@@ -1521,12 +2033,19 @@ bool hashtable<T, Hash, KeyEqual>::equal_to_unique(const hashtable& rhs)
 }
 
 // 重载 mystl 的 swap
-template <class T, class Hash, class KeyEqual>
-void swap(hashtable<T, Hash, KeyEqual>& lhs, hashtable<T, Hash, KeyEqual>& rhs)
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void swap(hashtable<T, Hash, KeyEqual, Alloc, Policy>& lhs, hashtable<T, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     lhs.swap(rhs);
 }
 
+// hashtable 的节点和 buckets_ 的空间都在堆上，没有节点指向 hashtable 对象本身
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy>
+struct is_trivially_relocatable<hashtable<T, Hash, KeyEqual, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Hash>::value &&
+                      is_trivially_relocatable<KeyEqual>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_HASHTABLE_H_
\ No newline at end of file
@@ -2,8 +2,11 @@
 #define MYTINYSTL_HEAP_ALGO_H_
 
 // 这个头文件包含 heap 的四个算法 : push_heap, pop_heap, sort_heap, make_heap
+// 以及 d 叉堆的三个算法 : push_dary_heap, pop_dary_heap, make_dary_heap
+// 调整 heap 时只移动元素，不复制元素
 
 #include "iterator.h"
+#include "util.h"
 
 namespace mystl
 {
@@ -18,17 +21,17 @@ void push_heap_aux(RandomIter first, Distance holeIndex, Distance topIndex, T va
     auto parent = (holeIndex - 1) / 2;
     while (holeIndex > topIndex && *(first + parent) < value)
     {   // 使用 operator<，所以 heap 为 max-heap
-        *(first + holeIndex) = *(first + parent);
+        *(first + holeIndex) = mystl::move(*(first + parent));
         holeIndex = parent;
         parent = (holeIndex - 1) / 2;
     }
-    *(first + holeIndex) = value;
+    *(first + holeIndex) = mystl::move(value);
 }
 
 template <class RandomIter, class Distance>
 void push_heap_d(RandomIter first, RandomIter last, Distance*)
 {
-    mystl::push_heap_aux(first, (last - first) - 1, static_cast<Distance>(0), *(last - 1));
+    mystl::push_heap_aux(first, (last - first) - 1, static_cast<Distance>(0), mystl::move(*(last - 1)));
 }
 
 template <class RandomIter>
@@ -44,17 +47,17 @@ void push_heap_aux(RandomIter first, Distance holeIndex, Distance topIndex, T va
     auto parent = (holeIndex - 1) / 2;
     while (holeIndex > topIndex && comp(*(first + parent), value))
     {
-        *(first + holeIndex) = *(first + parent);
+        *(first + holeIndex) = mystl::move(*(first + parent));
         holeIndex = parent;
         parent = (holeIndex - 1) / 2;
     }
-    *(first + holeIndex) = value;
+    *(first + holeIndex) = mystl::move(value);
 }
 
 template <class RandomIter, class Compared, class Distance>
 void push_heap_d(RandomIter first, RandomIter last, Distance*, Compared comp)
 {
-    mystl::push_heap_aux(first, (last - first) - 1, static_cast<Distance>(0), *(last - 1), comp);
+    mystl::push_heap_aux(first, (last - first) - 1, static_cast<Distance>(0), mystl::move(*(last - 1)), comp);
 } 
 
 template <class RandomIter, class Compared>
@@ -77,31 +80,31 @@ void adjust_heap(RandomIter first, Distance holeIndex, Distance len, T value)
     {
         if (*(first + rchild) < *(first + rchild - 1))
             --rchild;
-        *(first + holeIndex) = *(first + rchild);
+        *(first + holeIndex) = mystl::move(*(first + rchild));
         holeIndex = rchild;
         rchild = 2 * (rchild + 1);
     }
     if (rchild == len)
     {   // 如果没有右子节点
-        *(first + holeIndex) = *(first + (rchild - 1));
+        *(first + holeIndex) = mystl::move(*(first + (rchild - 1)));
         holeIndex = rchild - 1;
     }
     // 再执行一次上溯(percolate up)过程
-    mystl::push_heap_aux(first, holeIndex, topIndex, value);
+    mystl::push_heap_aux(first, holeIndex, topIndex, mystl::move(value));
 }
 
 template <class RandomIter, class T, class Distance>
 void pop_heap_aux(RandomIter first, RandomIter last, RandomIter result, T value, Distance*)
 {
     // 先将首值调至尾节点，然后调整[first, last - 1)使之重新成为一个 max-heap
-    *result = *first;
-    mystl::adjust_heap(first, static_cast<Distance>(0), last - first, value);
+    *result = mystl::move(*first);
+    mystl::adjust_heap(first, static_cast<Distance>(0), last - first, mystl::move(value));
 }
 
 template <class RandomIter>
 void pop_heap(RandomIter first, RandomIter last)
 {
-    mystl::pop_heap_aux(first, last - 1, last - 1, *(last - 1), distance_type(first));
+    mystl::pop_heap_aux(first, last - 1, last - 1, mystl::move(*(last - 1)), distance_type(first));
 }
 
 // 重载版本使用函数对象 comp 代替比较操作
@@ -115,30 +118,30 @@ void adjust_heap(RandomIter first, Distance holeIndex, Distance len, T value, Co
     {
         if (comp(*(first + rchild), *(first + rchild - 1)))
             --rchild;
-        *(first + holeIndex) = *(first + rchild);
+        *(first + holeIndex) = mystl::move(*(first + rchild));
         holeIndex = rchild;
         rchild = 2 * (rchild + 1);
     }
     if (rchild == len)
     {
-        *(first + holeIndex) = *(first + (rchild - 1));
+        *(first + holeIndex) = mystl::move(*(first + (rchild - 1)));
         holeIndex = rchild - 1;
     }
     // 再执行一次上溯(percolate up)过程
-    mystl::push_heap_aux(first, holeIndex, topIndex, value, comp);
+    mystl::push_heap_aux(first, holeIndex, topIndex, mystl::move(value), comp);
 }
 
 template <class RandomIter, class T, class Distance, class Compared>
 void pop_heap_aux(RandomIter first, RandomIter last, RandomIter result, T value, Distance*, Compared comp)
 {
-    *result = *first;  // 先将尾指设置成首值，即尾指为欲求结果
-    mystl::adjust_heap(first, static_cast<Distance>(0), last - first, value, comp);
+    *result = mystl::move(*first);  // 先将尾指设置成首值，即尾指为欲求结果
+    mystl::adjust_heap(first, static_cast<Distance>(0), last - first, mystl::move(value), comp);
 }
 
 template <class RandomIter, class Compared>
 void pop_heap(RandomIter first, RandomIter last, Compared comp)
 {
-    mystl::pop_heap_aux(first, last - 1, last - 1, *(last - 1), distance_type(first), comp);
+    mystl::pop_heap_aux(first, last - 1, last - 1, mystl::move(*(last - 1)), distance_type(first), comp);
 }
 
 /*****************************************************************************************/
@@ -177,7 +180,7 @@ void make_heap_aux(RandomIter first, RandomIter last, Distance*)
     auto holeIndex = (len - 2) / 2;
     while (true)
     {   // 重排以 holeIndex 为首的子树
-        mystl::adjust_heap(first, holeIndex, len, *(first + holeIndex));
+        mystl::adjust_heap(first, holeIndex, len, mystl::move(*(first + holeIndex)));
         if (holeIndex == 0)
             return;
         holeIndex--;
@@ -200,7 +203,7 @@ void make_heap_aux(RandomIter first, RandomIter last, Distance*, Compared comp)
     auto holeIndex = (len - 2) / 2;
     while (true)
     {   // 重排以 holeIndex 为首的子树
-        mystl::adjust_heap(first, holeIndex, len, *(first + holeIndex), comp);
+        mystl::adjust_heap(first, holeIndex, len, mystl::move(*(first + holeIndex)), comp);
         if (holeIndex == 0)
             return;
         holeIndex--;
@@ -213,6 +216,96 @@ void make_heap(RandomIter first, RandomIter last, Compared comp)
     mystl::make_heap_aux(first, last, distance_type(first), comp);
 }
 
+/*****************************************************************************************/
+// d-ary heap : push_dary_heap, pop_dary_heap, make_dary_heap
+// 结点 i 的子结点为 D * i + 1 ... D * i + D，父结点为 (i - 1) / D
+// 同一结点的 D 个子结点在底部容器中连续存放，下溯时一次比较的子结点落在相邻的一两条缓存行内，
+// 树高降为 log_D(n)，元素很多时 pop 访问的缓存行比二叉堆少
+// 比较方式由函数对象 comp 给出，与二叉堆相同，heap 为 max-heap
+/*****************************************************************************************/
+template <size_t D, class RandomIter, class Distance, class T, class Compared>
+void dary_push_heap_aux(RandomIter first, Distance holeIndex, Distance topIndex, T value, Compared comp)
+{
+    const auto d = static_cast<Distance>(D);
+    while (holeIndex > topIndex)
+    {
+        auto parent = (holeIndex - 1) / d;
+        if (!comp(*(first + parent), value))
+            break;
+        *(first + holeIndex) = mystl::move(*(first + parent));
+        holeIndex = parent;
+    }
+    *(first + holeIndex) = mystl::move(value);
+}
+
+template <size_t D, class RandomIter, class Distance, class T, class Compared>
+void dary_adjust_heap(RandomIter first, Distance holeIndex, Distance len, T value, Compared comp)
+{
+    // 先沿着最大的子结点下溯到叶子，再对 value 执行一次上溯
+    const auto d = static_cast<Distance>(D);
+    auto topIndex = holeIndex;
+    auto child = d * holeIndex + 1;
+    while (len - child >= d)
+    {   // D 个子结点都存在，循环次数为常量，选择最大子结点时不产生分支
+        auto best = child;
+        for (Distance i = 1; i < d; ++i)
+            best = comp(*(first + best), *(first + (child + i))) ? child + i : best;
+        *(first + holeIndex) = mystl::move(*(first + best));
+        holeIndex = best;
+        child = d * holeIndex + 1;
+    }
+    if (child < len)
+    {   // 最后一个结点的子结点不足 D 个
+        auto best = child;
+        for (auto i = child + 1; i < len; ++i)
+            best = comp(*(first + best), *(first + i)) ? i : best;
+        *(first + holeIndex) = mystl::move(*(first + best));
+        holeIndex = best;
+    }
+    mystl::dary_push_heap_aux<D>(first, holeIndex, topIndex, mystl::move(value), comp);
+}
+
+template <size_t D, class RandomIter, class Compared>
+void push_dary_heap(RandomIter first, RandomIter last, Compared comp)
+{   // 新元素应该已置于底部容器的最尾端
+    static_assert(D >= 2, "the arity of d-ary heap should be at least 2");
+    typedef typename iterator_traits<RandomIter>::difference_type Distance;
+    mystl::dary_push_heap_aux<D>(first, static_cast<Distance>((last - first) - 1),
+                                 static_cast<Distance>(0), mystl::move(*(last - 1)), comp);
+}
+
+template <size_t D, class RandomIter, class Compared>
+void pop_dary_heap(RandomIter first, RandomIter last, Compared comp)
+{   // 将堆顶放到尾部，再调整 [first, last - 1)
+    static_assert(D >= 2, "the arity of d-ary heap should be at least 2");
+    typedef typename iterator_traits<RandomIter>::difference_type Distance;
+    if (last - first < 2)
+        return;
+    --last;
+    auto value = mystl::move(*last);
+    *last = mystl::move(*first);
+    mystl::dary_adjust_heap<D>(first, static_cast<Distance>(0), static_cast<Distance>(last - first),
+                               mystl::move(value), comp);
+}
+
+template <size_t D, class RandomIter, class Compared>
+void make_dary_heap(RandomIter first, RandomIter last, Compared comp)
+{
+    static_assert(D >= 2, "the arity of d-ary heap should be at least 2");
+    typedef typename iterator_traits<RandomIter>::difference_type Distance;
+    const Distance len = last - first;
+    if (len < 2)
+        return;
+    auto holeIndex = (len - 2) / static_cast<Distance>(D);
+    while (true)
+    {   // 重排以 holeIndex 为首的子树
+        mystl::dary_adjust_heap<D>(first, holeIndex, len, mystl::move(*(first + holeIndex)), comp);
+        if (holeIndex == 0)
+            return;
+        holeIndex--;
+    }
+}
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_HEAP_ALGO_H_
\ No newline at end of file
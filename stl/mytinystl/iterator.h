@@ -118,6 +118,22 @@ template <typename Iterator>
 struct is_iterator 
 : public m_bool_constant<is_input_iterator<Iterator>::value || is_output_iterator<Iterator>::value> {};
 
+// 分段迭代器的萃取
+// 由若干段连续空间组成的迭代器（如 deque 的迭代器）特化此模板，令 is_segmented 为 true，并提供：
+//   segment_iterator / local_iterator : 段的迭代器与段内的迭代器（指针）
+//   segment(it) / local(it)           : it 所在的段与它在段内的位置
+//   begin(seg) / end(seg)             : 一段的头尾
+//   compose(seg, local)               : 由段与段内位置合成迭代器
+// 算法可以据此逐段处理，每一段都能使用针对指针的版本
+template <class Iterator>
+struct segmented_iterator_traits
+{
+    static constexpr bool is_segmented = false;
+};
+
+template <class Iterator>
+using is_segmented_iterator = m_bool_constant<segmented_iterator_traits<Iterator>::is_segmented>;
+
 
 // 萃取某个迭代器的 category
 template <typename Iterator>
@@ -247,9 +263,13 @@ public:
     
     pointer operator->() const
     {
-        return &(operator*());
+        return arrow(operator*(), std::is_pointer<pointer>{});
     }
 
+    // 解引用得到代理对象的迭代器（如 flat_map 的迭代器），pointer 由 reference 构造
+    static pointer arrow(reference r, std::true_type)  { return &r; }
+    static pointer arrow(reference r, std::false_type) { return pointer(r); }
+
     // 前进(++)变为后退(--)
     self& operator++()
     {
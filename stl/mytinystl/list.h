@@ -22,6 +22,7 @@
 #include "functional.h"
 #include "util.h"
 #include "exceptdef.h"
+#include "vector.h"
 
 namespace mystl
 {
@@ -193,24 +194,28 @@ struct list_const_iterator : public iterator<bidirectional_iterator_tag, T>
 };
 
 // 模板类: list
-// 模板参数 T 代表数据类型
-template <typename T>
-class list
+// 模板参数 T 代表数据类型，Alloc 代表空间配置器，缺省使用 mystl::allocator
+// list 保存的是结点的分配器，哨兵结点与元素分别通过重新绑定得到的分配器构造
+template <typename T, typename Alloc = mystl::allocator<T>>
+class list : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<list_node<T>>>
 {
 public:
     // list 的嵌套型别定义
-    typedef mystl::allocator<T>                      allocator_type;
-    typedef mystl::allocator<T>                      data_allocator;
-    typedef mystl::allocator<list_node_base<T>>      base_allocator;
-    typedef mystl::allocator<list_node<T>>           node_allocator;
-
-    typedef typename allocator_type::value_type      value_type;
-    typedef typename allocator_type::pointer         pointer;
-    typedef typename allocator_type::const_pointer   const_pointer;
-    typedef typename allocator_type::reference       reference;
-    typedef typename allocator_type::const_reference const_reference;
-    typedef typename allocator_type::size_type       size_type;
-    typedef typename allocator_type::difference_type difference_type;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>                 data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<list_node_base<T>> base_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<list_node<T>>      node_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef mystl::allocator_traits<base_allocator>     base_alloc_traits;
+    typedef mystl::allocator_traits<node_allocator>     node_alloc_traits;
+    typedef data_allocator                              allocator_type;
+
+    typedef typename data_alloc_traits::value_type      value_type;
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
 
     typedef list_iterator<T>                         iterator;
     typedef list_const_iterator<T>                   const_iterator;
@@ -220,9 +225,11 @@ public:
     typedef typename node_traits<T>::base_ptr        base_ptr;
     typedef typename node_traits<T>::node_ptr        node_ptr;
 
-    allocator_type get_allocator() { return node_allocator(); }
+    allocator_type get_allocator() const { return allocator_type(this->get_alloc()); }
 
 private:
+    typedef mystl::alloc_holder<node_allocator>      alloc_base;
+
     base_ptr  node_;  // 指向末尾节点
     size_type size_;  // 大小
 
@@ -231,23 +238,37 @@ public:
     list()
     { fill_init(0, value_type()); }
 
-    explicit list(size_type n)
+    explicit list(const allocator_type& alloc)
+        :alloc_base(node_allocator(alloc))
+    { fill_init(0, value_type()); }
+
+    explicit list(size_type n, const allocator_type& alloc = allocator_type())
+        :alloc_base(node_allocator(alloc))
     { fill_init(n, value_type()); }
 
-    list(size_type n, const value_type& value)
+    list(size_type n, const value_type& value, const allocator_type& alloc = allocator_type())
+        :alloc_base(node_allocator(alloc))
     { fill_init(n, value); }
 
     template <typename Iter, typename std::enable_if<mystl::is_input_iterator<Iter>::value, int>::type = 0>
-    list(Iter first, Iter last)
+    list(Iter first, Iter last, const allocator_type& alloc = allocator_type())
+        :alloc_base(node_allocator(alloc))
     { copy_init(first, last); }
 
-    list(std::initializer_list<T> ilist)
+    list(std::initializer_list<T> ilist, const allocator_type& alloc = allocator_type())
+        :alloc_base(node_allocator(alloc))
     { copy_init(ilist.begin(), ilist.end()); }
 
     list(const list& rhs)
+        :alloc_base(node_alloc_traits::select_on_container_copy_construction(rhs.get_alloc()))
     { copy_init(rhs.cbegin(), rhs.cend()); }
 
-    list(list&& rhs) noexcept : node_(rhs.node_), size_(rhs.size_)
+    list(const list& rhs, const allocator_type& alloc)
+        :alloc_base(node_allocator(alloc))
+    { copy_init(rhs.cbegin(), rhs.cend()); }
+
+    list(list&& rhs) noexcept
+        :alloc_base(mystl::move(rhs.get_alloc())), node_(rhs.node_), size_(rhs.size_)
     {
         rhs.node_ = nullptr;
         rhs.size_ = 0;
@@ -257,6 +278,15 @@ public:
     {
         if(this != &rhs)
         {
+            // 需要传播分配器且两者不相等时，原有结点必须由原分配器释放
+            if(node_alloc_traits::propagate_on_container_copy_assignment::value &&
+               this->get_alloc() != rhs.get_alloc())
+            {
+                list tmp(rhs, allocator_type(rhs.get_alloc()));
+                swap_data(tmp);
+                mystl::swap(this->get_alloc(), tmp.get_alloc());
+                return *this;
+            }
             assign(rhs.begin(), rhs.end());
         }
         return *this;
@@ -264,14 +294,29 @@ public:
 
     list& operator=(list&& rhs) noexcept
     {
+        if(this == &rhs)return *this;
         clear();
-        splice(end(), rhs);
+        if(node_alloc_traits::propagate_on_container_move_assignment::value ||
+           this->get_alloc() == rhs.get_alloc())
+        {
+            // rhs 得到本容器的空哨兵结点，分配器跟随各自的结点
+            swap_data(rhs);
+            if(node_alloc_traits::propagate_on_container_move_assignment::value)
+                mystl::swap(this->get_alloc(), rhs.get_alloc());
+        }
+        else
+        {
+            // 分配器不相等且不传播时，只能逐个移动元素
+            for(auto it = rhs.begin(); it != rhs.end(); ++it)
+                emplace_back(mystl::move(*it));
+            rhs.clear();
+        }
         return *this;
     }
 
     list& operator=(std::initializer_list<T> ilist)
     {
-        list tmp(ilist.begin(), ilist.end());
+        list tmp(ilist.begin(), ilist.end(), allocator_type(this->get_alloc()));
         swap(tmp);
         return *this;
     }
@@ -280,8 +325,9 @@ public:
     {
         if(node_ != nullptr)
         {
-            clear();
-            base_allocator::deallocate(node_);
+            if(!node_alloc_traits::template can_skip_destroy<T>(this->get_alloc()))
+                clear();
+            destroy_base_node(node_);
             node_ = nullptr;
             size_ = 0;
         }
@@ -469,8 +515,8 @@ public:
 
     void swap(list& rhs) noexcept
     {
-        mystl::swap(node_, rhs.node_);
-        mystl::swap(size_, rhs.size_);
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
     }
 
     // list 相关操作
@@ -493,11 +539,19 @@ public:
     template <typename Compare>
     void merge(list& x, Compare comp);
 
+    // 自底向上的 64 桶归并排序，稳定，不申请额外内存
     void sort()
-    { list_sort(begin(), end(), size(), mystl::less<T>()); }
+    { list_sort(mystl::less<T>()); }
     template <typename Compare>
     void sort(Compare comp)
-    { list_sort(begin(), end(), size(), comp); }
+    { list_sort(comp); }
+
+    // 把节点指针放入临时 vector 中稳定排序后重新链接，
+    // 需要 O(n) 的额外内存，比较时不再沿链表跳转
+    void pointer_sort()
+    { pointer_sort(mystl::less<T>()); }
+    template <typename Compare>
+    void pointer_sort(Compare comp);
 
     void reverse();
 
@@ -508,6 +562,15 @@ private:
     template <typename... Args>
     node_ptr create_node(Args&&... args);
     void destroy_node(node_ptr p);
+    base_ptr create_base_node();
+    void destroy_base_node(base_ptr p);
+
+    // 只交换数据，不交换分配器
+    void swap_data(list& rhs) noexcept
+    {
+        mystl::swap(node_, rhs.node_);
+        mystl::swap(size_, rhs.size_);
+    }
 
     // initialize
     void fill_init(size_type n, const value_type& value);
@@ -533,13 +596,16 @@ private:
 
     // sort
     template <typename Compared>
-    iterator list_sort(iterator first, iterator last, size_type n, Compared comp);
+    void list_sort(Compared comp);
+    template <typename Compared>
+    static void merge_chain(base_ptr& x, base_ptr y, Compared& comp);
+    void relink_chain(base_ptr first);
 };
 
 
 // 删除 pos 处的元素
-template <typename T>
-typename list<T>::iterator list<T>::erase(const_iterator pos)
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator list<T, Alloc>::erase(const_iterator pos)
 {
     MYSTL_DEBUG(pos != cend());
     auto n = pos.node_;
@@ -551,8 +617,8 @@ typename list<T>::iterator list<T>::erase(const_iterator pos)
 }
 
 // 删除 [first, last) 内的元素
-template <typename T>
-typename list<T>::iterator list<T>::erase(const_iterator first, const_iterator last)
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator list<T, Alloc>::erase(const_iterator first, const_iterator last)
 {
     if(first != last)
     {
@@ -569,8 +635,8 @@ typename list<T>::iterator list<T>::erase(const_iterator first, const_iterator l
 }
 
 // 清空 list
-template <typename T>
-void list<T>::clear()
+template <typename T, typename Alloc>
+void list<T, Alloc>::clear()
 {
     if(size_ != 0)
     {
@@ -585,8 +651,8 @@ void list<T>::clear()
 }
 
 // 重置容器大小
-template <typename T>
-void list<T>::resize(size_type new_size, const value_type& value)
+template <typename T, typename Alloc>
+void list<T, Alloc>::resize(size_type new_size, const value_type& value)
 {
     auto it = begin();
     size_type len = 0;
@@ -606,10 +672,12 @@ void list<T>::resize(size_type new_size, const value_type& value)
 }
 
 // 将 list x 接合于 pos 之前
-template <typename T>
-void list<T>::splice(const_iterator pos, list& x)
+template <typename T, typename Alloc>
+void list<T, Alloc>::splice(const_iterator pos, list& x)
 {
     MYSTL_DEBUG(this != &x);
+    // 节点由 x 的分配器分配，只能在分配器相等的 list 之间转移
+    MYSTL_DEBUG(this->get_alloc() == x.get_alloc());
     if(!x.empty())
     {
         THROW_LENGTH_ERROR_IF(size_ > max_size() - x.size(), "list<T>'s size too big");
@@ -623,9 +691,10 @@ void list<T>::splice(const_iterator pos, list& x)
 }
 
 // 将 it 所指的节点接合于 pos 之前
-template <typename T>
-void list<T>::splice(const_iterator pos, list& x, const_iterator it)
+template <typename T, typename Alloc>
+void list<T, Alloc>::splice(const_iterator pos, list& x, const_iterator it)
 {
+    MYSTL_DEBUG(this->get_alloc() == x.get_alloc());
     if(pos.node_ != it.node_ && pos.node_ != it.node_->next)// ???
     {
         THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "list<T>'s size too big");
@@ -638,9 +707,10 @@ void list<T>::splice(const_iterator pos, list& x, const_iterator it)
 }
 
 // 将 list x 的 [first, last) 内的节点接合于 pos 之前
-template <typename T>
-void list<T>::splice(const_iterator pos, list& x, const_iterator first, const_iterator last)
+template <typename T, typename Alloc>
+void list<T, Alloc>::splice(const_iterator pos, list& x, const_iterator first, const_iterator last)
 {
+    MYSTL_DEBUG(this->get_alloc() == x.get_alloc());
     if(first != last && this != &x)
     {
         size_type n = mystl::distance(first, last);
@@ -655,9 +725,9 @@ void list<T>::splice(const_iterator pos, list& x, const_iterator first, const_it
 }
 
 // 将一元操作 pred 为 true 的所有元素移除
-template <typename T>
+template <typename T, typename Alloc>
 template <typename UnaryPredicate>
-void list<T>::remove_if(UnaryPredicate pred)
+void list<T, Alloc>::remove_if(UnaryPredicate pred)
 {
     auto cur = begin();
     for(auto next = cur; cur != end(); cur = next)
@@ -668,9 +738,9 @@ void list<T>::remove_if(UnaryPredicate pred)
 }
 
 // 移除 list 中满足 pred 为 true 重复元素
-template <typename T>
+template <typename T, typename Alloc>
 template <typename BinaryPredicate>
-void list<T>::unique(BinaryPredicate pred)
+void list<T, Alloc>::unique(BinaryPredicate pred)
 {
     auto i = begin();
     auto e = end();
@@ -686,10 +756,11 @@ void list<T>::unique(BinaryPredicate pred)
 }
 
 // 与另一个 list 合并，按照 comp 为 true 的顺序
-template <typename T>
+template <typename T, typename Alloc>
 template <typename Compared>
-void list<T>::merge(list& x, Compared comp)
+void list<T, Alloc>::merge(list& x, Compared comp)
 {
+    MYSTL_DEBUG(this->get_alloc() == x.get_alloc());
     if(this != &x)
     {
         THROW_LENGTH_ERROR_IF(size_ > max_size() - x.size_, "list<T>'s size too big");
@@ -730,8 +801,8 @@ void list<T>::merge(list& x, Compared comp)
 }
 
 // 将 list 反转
-template <typename T>
-void list<T>::reverse()
+template <typename T, typename Alloc>
+void list<T, Alloc>::reverse()
 {
     if(size_ <= 1)return;
     auto i = begin(), e = end();
@@ -747,38 +818,53 @@ void list<T>::reverse()
 // helper function
 
 // 创建结点
-template <typename T>
+template <typename T, typename Alloc>
 template <typename... Args>
-typename list<T>::node_ptr list<T>::create_node(Args&&... args)
+typename list<T, Alloc>::node_ptr list<T, Alloc>::create_node(Args&&... args)
 {
-    node_ptr p = node_allocator::allocate(1);
+    node_ptr p = node_alloc_traits::allocate(this->get_alloc(), 1);
     try
     {
-        data_allocator::construct(mystl::address_of(p->value), mystl::forward<Args>(args)...);
+        node_alloc_traits::construct(this->get_alloc(), mystl::address_of(p->value), mystl::forward<Args>(args)...);
         p->prev = nullptr;
         p->next = nullptr;
     }
     catch(...)
     {
-        node_allocator::deallocate(p);
+        node_alloc_traits::deallocate(this->get_alloc(), p, 1);
         throw;
     }
     return p;
 }
 
 // 销毁结点
-template <typename T>
-void list<T>::destroy_node(node_ptr p)
+template <typename T, typename Alloc>
+void list<T, Alloc>::destroy_node(node_ptr p)
+{
+    node_alloc_traits::destroy(this->get_alloc(), mystl::address_of(p->value));
+    node_alloc_traits::deallocate(this->get_alloc(), p, 1);
+}
+
+// 创建 / 销毁哨兵结点
+template <typename T, typename Alloc>
+typename list<T, Alloc>::base_ptr list<T, Alloc>::create_base_node()
+{
+    base_allocator base_alloc(this->get_alloc());
+    return base_alloc_traits::allocate(base_alloc, 1);
+}
+
+template <typename T, typename Alloc>
+void list<T, Alloc>::destroy_base_node(base_ptr p)
 {
-    data_allocator::destroy(mystl::address_of(p->value));
-    node_allocator::deallocate(p);
+    base_allocator base_alloc(this->get_alloc());
+    base_alloc_traits::deallocate(base_alloc, p, 1);
 }
 
 // 用 n 个元素初始化容器
-template <typename T>
-void list<T>::fill_init(size_type n, const value_type& value)
+template <typename T, typename Alloc>
+void list<T, Alloc>::fill_init(size_type n, const value_type& value)
 {
-    node_ = base_allocator::allocate(1);
+    node_ = create_base_node();
     node_->unlink();
     size_ = n;
     try
@@ -792,18 +878,18 @@ void list<T>::fill_init(size_type n, const value_type& value)
     catch(...)
     {
         clear();
-        base_allocator::deallocate(node_);
+        destroy_base_node(node_);
         node_ = nullptr;
         throw;
     }
 }
 
 // 以 [first, last) 初始化容器
-template <typename T>
+template <typename T, typename Alloc>
 template <typename Iter>
-void list<T>::copy_init(Iter first, Iter last)
+void list<T, Alloc>::copy_init(Iter first, Iter last)
 {
-    node_ = base_allocator::allocate(1);
+    node_ = create_base_node();
     node_->unlink();
     size_type n = mystl::distance(first, last);
     size_ = n;
@@ -818,15 +904,15 @@ void list<T>::copy_init(Iter first, Iter last)
     catch(...)
     {
         clear();
-        base_allocator::deallocate(node_);
+        destroy_base_node(node_);
         node_ = nullptr;
         throw;
     }
 }
 
 // 在 pos 处连接一个节点
-template <typename T>
-typename list<T>::iterator list<T>::link_iter_node(const_iterator pos, base_ptr link_node)
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator list<T, Alloc>::link_iter_node(const_iterator pos, base_ptr link_node)
 {
     if(pos == node_->next)
     {
@@ -844,8 +930,8 @@ typename list<T>::iterator list<T>::link_iter_node(const_iterator pos, base_ptr
 }
     
 // 在 pos 处连接 [first, last] 的结点
-template <typename T>
-void list<T>::link_nodes(base_ptr pos, base_ptr first, base_ptr last)
+template <typename T, typename Alloc>
+void list<T, Alloc>::link_nodes(base_ptr pos, base_ptr first, base_ptr last)
 {
     pos->prev->next = first;
     first->prev = pos->prev;
@@ -854,8 +940,8 @@ void list<T>::link_nodes(base_ptr pos, base_ptr first, base_ptr last)
 }
 
 // 在头部连接 [first, last] 结点
-template <typename T>
-void list<T>::link_nodes_at_front(base_ptr first, base_ptr last)
+template <typename T, typename Alloc>
+void list<T, Alloc>::link_nodes_at_front(base_ptr first, base_ptr last)
 {
     first->prev = node_;
     last->next = node_->next;
@@ -864,8 +950,8 @@ void list<T>::link_nodes_at_front(base_ptr first, base_ptr last)
 }
 
 // 在尾部连接 [first, last] 结点
-template <typename T>
-void list<T>::link_nodes_at_back(base_ptr first, base_ptr last)
+template <typename T, typename Alloc>
+void list<T, Alloc>::link_nodes_at_back(base_ptr first, base_ptr last)
 {
     first->prev = node_->prev;
     first->prev->next = first;
@@ -874,16 +960,16 @@ void list<T>::link_nodes_at_back(base_ptr first, base_ptr last)
 }
 
 // 容器与 [first, last] 结点断开连接
-template <typename T>
-void list<T>::unlink_nodes(base_ptr first, base_ptr last)
+template <typename T, typename Alloc>
+void list<T, Alloc>::unlink_nodes(base_ptr first, base_ptr last)
 {
     first->prev->next = last->next;
     last->next->prev = first->prev;
 }
 
 // 用 n 个元素为容器赋值
-template <typename T>
-void list<T>::fill_assign(size_type n, const value_type& value)
+template <typename T, typename Alloc>
+void list<T, Alloc>::fill_assign(size_type n, const value_type& value)
 {
     auto i = begin();
     auto e = end();
@@ -896,9 +982,9 @@ void list<T>::fill_assign(size_type n, const value_type& value)
 }
 
 // 复制[f2, l2)为容器赋值
-template <typename T>
+template <typename T, typename Alloc>
 template <typename Iter>
-void list<T>::copy_assign(Iter f2, Iter l2)
+void list<T, Alloc>::copy_assign(Iter f2, Iter l2)
 {
     auto f1 = begin();
     auto l1 = end();
@@ -911,8 +997,8 @@ void list<T>::copy_assign(Iter f2, Iter l2)
 }
 
 // 在 pos 处插入 n 个元素
-template <typename T>
-typename list<T>::iterator list<T>::fill_insert(const_iterator pos, size_type n, const value_type& value)
+template <typename T, typename Alloc>
+typename list<T, Alloc>::iterator list<T, Alloc>::fill_insert(const_iterator pos, size_type n, const value_type& value)
 {
     iterator r(pos.node_);
     if(n != 0)
@@ -950,9 +1036,9 @@ typename list<T>::iterator list<T>::fill_insert(const_iterator pos, size_type n,
 }
 
 // 在 pos 处插入 [first, last) 的元素
-template <typename T>
+template <typename T, typename Alloc>
 template <typename Iter>
-typename list<T>::iterator list<T>::copy_insert(const_iterator pos, size_type n, Iter first)
+typename list<T, Alloc>::iterator list<T, Alloc>::copy_insert(const_iterator pos, size_type n, Iter first)
 {
     iterator r(pos.node_);
     if(n != 0)
@@ -989,74 +1075,180 @@ typename list<T>::iterator list<T>::copy_insert(const_iterator pos, size_type n,
     return r;
 }
 
-// 对 list 进行归并排序，返回一个迭代器指向区间最小元素的位置
-template <typename T>
+// 合并两条有序链，x 中的元素在前（保证稳定），结果存入 x
+// 链以 nullptr 结尾，首节点的 prev 指向尾节点；每次取出一整段连续的节点，
+// 段内的链接无需改写，只在两条链交替处修改指针
+// 若 comp 抛出异常，剩余节点会被接回 x，不会丢失（此时只保证 next 完整）
+template <typename T, typename Alloc>
 template <typename Compared>
-typename list<T>::iterator list<T>::list_sort(iterator f1, iterator l2, size_type n, Compared comp)
+void list<T, Alloc>::merge_chain(base_ptr& x, base_ptr y, Compared& comp)
 {
-    if(n < 2)return f1;
-    if(n == 2)
+    base_ptr a = x;
+    base_ptr b = y;
+    const base_ptr alast = a->prev;
+    const base_ptr blast = b->prev;
+    base_ptr head = nullptr;
+    base_ptr tail = nullptr;
+    try
     {
-        if(comp(*(--l2), *f1))
+        while(true)
         {
-            auto node = l2.node_;
-            unlink_nodes(node, node);
-            link_nodes(f1.node_, node, node);
-            return l2;
+            if(comp(b->as_node()->value, a->as_node()->value))
+            {
+                if(tail == nullptr)head = b;
+                else { tail->next = b; b->prev = tail; }
+                do
+                {
+                    tail = b;
+                    b = b->next;
+                } while(b != nullptr && comp(b->as_node()->value, a->as_node()->value));
+                if(b == nullptr)
+                {
+                    tail->next = a;
+                    a->prev = tail;
+                    head->prev = alast;
+                    break;
+                }
+            }
+            else
+            {
+                if(tail == nullptr)head = a;
+                else { tail->next = a; a->prev = tail; }
+                do
+                {
+                    tail = a;
+                    a = a->next;
+                } while(a != nullptr && !comp(b->as_node()->value, a->as_node()->value));
+                if(a == nullptr)
+                {
+                    tail->next = b;
+                    b->prev = tail;
+                    head->prev = blast;
+                    break;
+                }
+            }
         }
-        return f1;
     }
+    catch(...)
+    {
+        if(tail == nullptr)head = a;
+        else tail->next = a;
+        alast->next = b;
+        x = head;
+        throw;
+    }
+    x = head;
+}
 
-    auto n2 = n / 2;
-    auto l1 = f1;
-    mystl::advance(l1, n2);
-    auto result = f1 = list_sort(f1, l1, n2, comp); // 前半段的最小位置
-    auto f2 = l1 = list_sort(l1, l2, n - n2, comp); // 后半段的最小位置
-    
-    // 把较小的一段区间移到前面
-    if(comp(*f2, *f1))
-    {
-        auto m = f2;
-        ++m;
-        for(; m != l2 && comp(*m, *f1); ++m);
-        auto f = f2.node_;
-        auto l = m.node_->prev;
-        result = f2;
-        l1 = f2 = m;
-        unlink_nodes(f, l);
-        m = f1;
-        ++m;
-        link_nodes(f1.node_, f, l);
-        f1 = m;
-    }
-    else ++f1;
-
-    // 合并两段有序区间
-    while(f1 != l1 && f2 != l2)
-    {
-        if(comp(*f2, *f1))
+// 把以 nullptr 结尾的单链重新接回 node_，并修复 prev 指针
+template <typename T, typename Alloc>
+void list<T, Alloc>::relink_chain(base_ptr first)
+{
+    base_ptr prev = node_;
+    for(; first != nullptr; prev = first, first = first->next)
+    {
+        prev->next = first;
+        first->prev = prev;
+    }
+    prev->next = node_;
+    node_->prev = prev;
+}
+
+// 对 list 进行自底向上的归并排序
+// bins[i] 为空或是长度为 2^i 的有序链，下标越大的桶中元素越靠前
+template <typename T, typename Alloc>
+template <typename Compared>
+void list<T, Alloc>::list_sort(Compared comp)
+{
+    if(size_ < 2)return;
+    base_ptr bins[64] = {};
+    size_type fill = 0;
+    base_ptr carry = nullptr;
+    base_ptr rest = node_->next;
+    node_->prev->next = nullptr;
+    try
+    {
+        while(rest != nullptr)
         {
-            auto m = f2;
-            ++m;
-            for(; m != l2 && comp(*m, *f1); ++m);
-            auto f = f2.node_;
-            auto l = m.node_->prev;
-            if(l1 == f2)l1 = m; // ???
-            f2 = m;
-            unlink_nodes(f, l);
-            m = f1;
-            ++m;
-            link_nodes(f1.node_, f, l);
-            f1 = m;
+            carry = rest;
+            rest = rest->next;
+            carry->next = nullptr;
+            carry->prev = carry;
+            size_type i = 0;
+            for(; i < fill && bins[i] != nullptr; ++i)
+            {
+                base_ptr y = carry;
+                carry = bins[i];
+                bins[i] = nullptr;
+                merge_chain(carry, y, comp);
+            }
+            bins[i] = carry;
+            carry = nullptr;
+            if(i == fill)++fill;
+        }
+        for(size_type i = 1; i < fill; ++i)
+        {
+            if(bins[i - 1] == nullptr)continue;
+            base_ptr y = bins[i - 1];
+            bins[i - 1] = nullptr;
+            if(bins[i] == nullptr)bins[i] = y;
+            else merge_chain(bins[i], y, comp);
         }
-        else ++f1;
     }
-    return result;
+    catch(...)
+    {
+        // 把所有链接回 list，元素顺序未定，但不丢失节点
+        base_ptr head = rest;
+        auto append = [&](base_ptr chain)
+        {
+            if(chain == nullptr)return;
+            base_ptr l = chain;
+            while(l->next != nullptr)l = l->next;
+            l->next = head;
+            head = chain;
+        };
+        append(carry);
+        for(size_type i = 0; i < fill; ++i)append(bins[i]);
+        relink_chain(head);
+        throw;
+    }
+    base_ptr first = bins[fill - 1];
+    base_ptr last = first->prev;
+    first->prev = node_;
+    last->next = node_;
+    node_->next = first;
+    node_->prev = last;
+}
+
+// 把节点指针放入临时 vector 中稳定排序，再按顺序重新链接
+// 若排序抛出异常，list 保持不变
+template <typename T, typename Alloc>
+template <typename Compare>
+void list<T, Alloc>::pointer_sort(Compare comp)
+{
+    if(size_ < 2)return;
+    mystl::vector<base_ptr> buf;
+    buf.reserve(size_);
+    for(auto p = node_->next; p != node_; p = p->next)
+        buf.push_back(p);
+    mystl::stable_sort(buf.begin(), buf.end(), [&](base_ptr a, base_ptr b)
+    {
+        return comp(a->as_node()->value, b->as_node()->value);
+    });
+    base_ptr prev = node_;
+    for(auto p : buf)
+    {
+        prev->next = p;
+        p->prev = prev;
+        prev = p;
+    }
+    prev->next = node_;
+    node_->prev = prev;
 }
 
 // 重载比较操作符
-template <typename T>
-bool operator==(const list<T>& lhs, const list<T>& rhs)
+template <typename T, typename Alloc>
+bool operator==(const list<T, Alloc>& lhs, const list<T, Alloc>& rhs)
 {
     auto f1 = lhs.cbegin();
     auto l1 = lhs.cend();
@@ -1066,43 +1258,56 @@ bool operator==(const list<T>& lhs, const list<T>& rhs)
     return f1 == l1 && f2 == l2;
 }
 
-template <typename T>
-bool operator<(const list<T>& lhs, const list<T>& rhs)
+template <typename T, typename Alloc>
+bool operator<(const list<T, Alloc>& lhs, const list<T, Alloc>& rhs)
 {
     return mystl::lexicographical_compare(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend());
 }
 
-template <typename T>
-bool operator!=(const list<T>& lhs, const list<T>& rhs)
+template <typename T, typename Alloc>
+bool operator!=(const list<T, Alloc>& lhs, const list<T, Alloc>& rhs)
 {
     return !(lhs == rhs);
 }
 
-template <typename T>
-bool operator>(const list<T>& lhs, const list<T>& rhs)
+template <typename T, typename Alloc>
+bool operator>(const list<T, Alloc>& lhs, const list<T, Alloc>& rhs)
 {
     return rhs < lhs;
 }
 
-template <typename T>
-bool operator<=(const list<T>& lhs, const list<T>& rhs)
+template <typename T, typename Alloc>
+bool operator<=(const list<T, Alloc>& lhs, const list<T, Alloc>& rhs)
 {
     return !(rhs < lhs);
 }
 
-template <typename T>
-bool operator>=(const list<T>& lhs, const list<T>& rhs)
+template <typename T, typename Alloc>
+bool operator>=(const list<T, Alloc>& lhs, const list<T, Alloc>& rhs)
 {
     return !(lhs < rhs);
 }
 
 // 重载 mystl 的 swap
-template <typename T>
-void swap(list<T>& lhs, list<T>& rhs) noexcept
+template <typename T, typename Alloc>
+void swap(list<T, Alloc>& lhs, list<T, Alloc>& rhs) noexcept
 {
     lhs.swap(rhs);
 }
 
+// list 的尾节点分配在堆上，没有节点指向 list 对象本身
+template <typename T, typename Alloc>
+struct is_trivially_relocatable<list<T, Alloc>> : is_trivially_relocatable<Alloc> {};
+
+// 使用 pmr::polymorphic_allocator 的 list，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <typename T>
+using list = mystl::list<T, polymorphic_allocator<T>>;
+} // namespace pmr
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_LIST_H_
\ No newline at end of file
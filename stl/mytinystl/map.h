@@ -18,11 +18,21 @@
 namespace mystl
 {
 
+template <typename Key, typename T, typename Compare, typename Alloc, typename Policy> class multimap;
+
 // 模板类 map，键值不允许重复
 // 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less
-template <typename Key, typename T, typename Compare = mystl::less<Key>>
+// 参数四代表空间配置器，缺省使用 mystl::allocator
+// 参数五代表节点策略，缺省使用 mystl::rb_tree_plain_policy，使用 mystl::rb_tree_rank_policy 时可以调用 nth 与 rank
+template <typename Key, typename T, typename Compare = mystl::less<Key>,
+          typename Alloc = mystl::allocator<mystl::pair<const Key, T>>,
+          typename Policy = mystl::rb_tree_plain_policy>
 class map
 {
+    // merge 需要访问其它 map / multimap 的底层 rb_tree
+    template <typename, typename, typename, typename, typename> friend class map;
+    template <typename, typename, typename, typename, typename> friend class multimap;
+
 public:
     // map 的嵌套型别定义
     typedef Key                       key_type;
@@ -33,7 +43,7 @@ public:
     // 定义一个 functor，用来进行元素比较
 class value_compare : public binary_function <value_type, value_type, bool>
 {
-    friend class map<Key, T, Compare>;
+    friend class map<Key, T, Compare, Alloc, Policy>;
 private:
     Compare comp;
     value_compare(Compare c) : comp(c) {}
@@ -46,12 +56,13 @@ public:
 
 private:
     // 以 mystl::rb_tree 作为底层机制
-    typedef mystl::rb_tree<value_type, key_compare> base_type;
+    typedef mystl::rb_tree<value_type, key_compare, Alloc, Policy> base_type;
     base_type tree_;
 
 public:
     // 使用 rb_tree 的型别
-    typedef typename base_type::node_type              node_type;
+    typedef typename base_type::node_handle            node_type;
+    typedef typename base_type::insert_return_type     insert_return_type;
     typedef typename base_type::pointer                pointer;
     typedef typename base_type::const_pointer          const_pointer;
     typedef typename base_type::reference              reference;
@@ -68,11 +79,15 @@ public:
     // 构造、复制、移动、赋值函数
     map() = default;
 
+    explicit map(const allocator_type& alloc) : tree_(alloc) {}
+
     template <typename InputIterator>
-    map(InputIterator first, InputIterator last)
+    map(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     { tree_.insert_unique(first, last); }
 
-    map(std::initializer_list<value_type> ilist)
+    map(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     { tree_.insert_unique(ilist.begin(), ilist.end()); }
 
     map(const map& rhs) : tree_(rhs.tree_) {}
@@ -151,17 +166,11 @@ public:
 
     mapped_type& operator[](const key_type& key)
     {
-        iterator it = lower_bound(key);
-        if(it == end() || key_comp()(key, it->first))
-            it = emplace_hint(it, key, T{});
-        return it->second;
+        return tree_.try_emplace_unique(key).first->second;
     }
     mapped_type& operator[](key_type&& key)
     {
-        iterator it = lower_bound(key);
-        if(it == end() || key_comp()(key, it->first))
-            it = emplace_hint(it, mystl::move(key), T{});
-        return it->second;
+        return tree_.try_emplace_unique(mystl::move(key)).first->second;
     }
 
     // 插入删除相关
@@ -177,6 +186,66 @@ public:
         return tree_.emplace_unique_use_hint(hint, mystl::forward<Args>(args)...);
     }
 
+    // try_emplace
+    // 键值不存在时才用 args 构造实值，键值已经存在时不分配空间，key 与 args 也不会被移动
+    template <typename... Args>
+    pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        return tree_.try_emplace_unique(key, mystl::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        return tree_.try_emplace_unique(mystl::move(key), mystl::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    iterator try_emplace(iterator hint, const key_type& key, Args&&... args)
+    {
+        return tree_.try_emplace_unique_use_hint(hint, key, mystl::forward<Args>(args)...);
+    }
+    template <typename... Args>
+    iterator try_emplace(iterator hint, key_type&& key, Args&&... args)
+    {
+        return tree_.try_emplace_unique_use_hint(hint, mystl::move(key), mystl::forward<Args>(args)...);
+    }
+
+    // insert_or_assign
+    // 键值不存在时插入，否则把 obj 赋值给已有的实值
+    template <typename M>
+    pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+    {
+        auto res = tree_.try_emplace_unique(key, mystl::forward<M>(obj));
+        if(!res.second)
+            res.first->second = mystl::forward<M>(obj);
+        return res;
+    }
+    template <typename M>
+    pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+    {
+        auto res = tree_.try_emplace_unique(mystl::move(key), mystl::forward<M>(obj));
+        if(!res.second)
+            res.first->second = mystl::forward<M>(obj);
+        return res;
+    }
+    template <typename M>
+    iterator insert_or_assign(iterator hint, const key_type& key, M&& obj)
+    {
+        const size_type n = size();
+        iterator it = tree_.try_emplace_unique_use_hint(hint, key, mystl::forward<M>(obj));
+        if(size() == n)
+            it->second = mystl::forward<M>(obj);
+        return it;
+    }
+    template <typename M>
+    iterator insert_or_assign(iterator hint, key_type&& key, M&& obj)
+    {
+        const size_type n = size();
+        iterator it = tree_.try_emplace_unique_use_hint(hint, mystl::move(key), mystl::forward<M>(obj));
+        if(size() == n)
+            it->second = mystl::forward<M>(obj);
+        return it;
+    }
+
     pair<iterator, bool> insert(const value_type& value)
     {
         return tree_.insert_unique(value);
@@ -201,6 +270,29 @@ public:
         tree_.insert_unique(first, last);
     }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    insert_return_type insert(node_type&& nh)
+    {
+        return tree_.insert_unique(mystl::move(nh));
+    }
+    iterator insert(iterator hint, node_type&& nh)
+    {
+        return tree_.insert_unique(hint, mystl::move(nh));
+    }
+
+    node_type extract(iterator pos)         { return tree_.extract(pos); }
+    node_type extract(const key_type& key)  { return tree_.extract(key); }
+
+    // merge 把 source 中键值不重复的元素移过来，键值重复的元素留在 source 中
+    template <typename Compare2>
+    void merge(map<Key, T, Compare2, Alloc, Policy>& source)  { tree_.merge_unique(source.tree_); }
+    template <typename Compare2>
+    void merge(map<Key, T, Compare2, Alloc, Policy>&& source) { tree_.merge_unique(source.tree_); }
+    template <typename Compare2>
+    void merge(multimap<Key, T, Compare2, Alloc, Policy>& source)  { tree_.merge_unique(source.tree_); }
+    template <typename Compare2>
+    void merge(multimap<Key, T, Compare2, Alloc, Policy>&& source) { tree_.merge_unique(source.tree_); }
+
     void      erase(iterator pos)                  { tree_.erase(pos); }
     size_type erase(const key_type& key)           { return tree_.erase_unique(key); }
     void      erase(iterator first, iterator last) { tree_.erase(first, last); }
@@ -228,56 +320,90 @@ public:
         return tree_.equal_range_unique(key);
     }
 
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return tree_.count_unique(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    {
+        return tree_.equal_range_unique(key);
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return tree_.equal_range_unique(key);
+    }
+
+    // 顺序统计，只有节点策略为 mystl::rb_tree_rank_policy 时才能调用，都是 O(log n)
+    // nth(k) 返回第 k 小（从 0 开始）的元素，k 不小于 size() 时返回 end()；rank(key) 返回小于 key 的元素个数
+    iterator       nth(size_type k)                       { return tree_.nth(k); }
+    const_iterator nth(size_type k)                 const { return tree_.nth(k); }
+    size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      rank(const K& key)               const { return tree_.rank(key); }
+
     void swap(map& rhs) noexcept
     {
         tree_.swap(rhs.tree_);
     }
 
 public:
-    friend bool operator==(const map& lhs, const map& rhs) { return lhs.tree_ == rhs.tree; }
+    friend bool operator==(const map& lhs, const map& rhs) { return lhs.tree_ == rhs.tree_; }
     friend bool operator< (const map& lhs, const map& rhs) { return lhs.tree_ < rhs.tree_; }
 };
 
 // 重载比较操作符
-template <class Key, class T, class Compare>
-bool operator==(const map<Key, T, Compare>& lhs, const map<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator==(const map<Key, T, Compare, Alloc, Policy>& lhs, const map<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return lhs == rhs;
 }
 
-template <class Key, class T, class Compare>
-bool operator<(const map<Key, T, Compare>& lhs, const map<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator<(const map<Key, T, Compare, Alloc, Policy>& lhs, const map<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return lhs < rhs;
 }
 
-template <class Key, class T, class Compare>
-bool operator!=(const map<Key, T, Compare>& lhs, const map<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator!=(const map<Key, T, Compare, Alloc, Policy>& lhs, const map<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return !(lhs == rhs);
 }
 
-template <class Key, class T, class Compare>
-bool operator>(const map<Key, T, Compare>& lhs, const map<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator>(const map<Key, T, Compare, Alloc, Policy>& lhs, const map<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return rhs < lhs;
 }
 
-template <class Key, class T, class Compare>
-bool operator<=(const map<Key, T, Compare>& lhs, const map<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator<=(const map<Key, T, Compare, Alloc, Policy>& lhs, const map<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return !(rhs < lhs);
 }
 
-template <class Key, class T, class Compare>
-bool operator>=(const map<Key, T, Compare>& lhs, const map<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator>=(const map<Key, T, Compare, Alloc, Policy>& lhs, const map<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return !(lhs < rhs);
 }
 
 // 重载 mystl 的 swap
-template <class Key, class T, class Compare>
-void swap(map<Key, T, Compare>& lhs, map<Key, T, Compare>& rhs) noexcept
+template <class Key, class T, class Compare, class Alloc, class Policy>
+void swap(map<Key, T, Compare, Alloc, Policy>& lhs, map<Key, T, Compare, Alloc, Policy>& rhs) noexcept
 {
   lhs.swap(rhs);
 }
@@ -286,9 +412,17 @@ void swap(map<Key, T, Compare>& lhs, map<Key, T, Compare>& rhs) noexcept
 
 // 模板类 multimap，键值允许重复
 // 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less
-template <typename Key, typename T, typename Compare = mystl::less<Key>>
+// 参数四代表空间配置器，缺省使用 mystl::allocator
+// 参数五代表节点策略，缺省使用 mystl::rb_tree_plain_policy，使用 mystl::rb_tree_rank_policy 时可以调用 nth 与 rank
+template <typename Key, typename T, typename Compare = mystl::less<Key>,
+          typename Alloc = mystl::allocator<mystl::pair<const Key, T>>,
+          typename Policy = mystl::rb_tree_plain_policy>
 class multimap
 {
+    // merge 需要访问其它 map / multimap 的底层 rb_tree
+    template <typename, typename, typename, typename, typename> friend class map;
+    template <typename, typename, typename, typename, typename> friend class multimap;
+
 public:
     // multimap 的嵌套型别定义
     typedef Key                       key_type;
@@ -299,7 +433,7 @@ public:
     // 定义一个 functor，用来进行元素比较
 class value_compare : public binary_function <value_type, value_type, bool>
 {
-    friend class map<Key, T, Compare>;
+    friend class multimap<Key, T, Compare, Alloc, Policy>;
 private:
     Compare comp;
     value_compare(Compare c) : comp(c) {}
@@ -312,12 +446,12 @@ public:
 
 private:
     // 以 mystl::rb_tree 作为底层机制
-    typedef mystl::rb_tree<value_type, key_compare> base_type;
+    typedef mystl::rb_tree<value_type, key_compare, Alloc, Policy> base_type;
     base_type tree_;
 
 public:
     // 使用 rb_tree 的型别
-    typedef typename base_type::node_type              node_type;
+    typedef typename base_type::node_handle            node_type;
     typedef typename base_type::pointer                pointer;
     typedef typename base_type::const_pointer          const_pointer;
     typedef typename base_type::reference              reference;
@@ -334,11 +468,15 @@ public:
     // 构造、复制、移动、赋值函数
     multimap() = default;
 
+    explicit multimap(const allocator_type& alloc) : tree_(alloc) {}
+
     template <typename InputIterator>
-    multimap(InputIterator first, InputIterator last)
+    multimap(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     { tree_.insert_multi(first, last); }
 
-    multimap(std::initializer_list<value_type> ilist)
+    multimap(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     { tree_.insert_multi(ilist.begin(), ilist.end()); }
 
     multimap(const multimap& rhs) : tree_(rhs.tree_) {}
@@ -437,6 +575,29 @@ public:
         tree_.insert_multi(first, last);
     }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    iterator insert(node_type&& nh)
+    {
+        return tree_.insert_multi(mystl::move(nh));
+    }
+    iterator insert(iterator hint, node_type&& nh)
+    {
+        return tree_.insert_multi(hint, mystl::move(nh));
+    }
+
+    node_type extract(iterator pos)         { return tree_.extract(pos); }
+    node_type extract(const key_type& key)  { return tree_.extract(key); }
+
+    // merge 把 source 中的全部元素移过来
+    template <typename Compare2>
+    void merge(map<Key, T, Compare2, Alloc, Policy>& source)  { tree_.merge_multi(source.tree_); }
+    template <typename Compare2>
+    void merge(map<Key, T, Compare2, Alloc, Policy>&& source) { tree_.merge_multi(source.tree_); }
+    template <typename Compare2>
+    void merge(multimap<Key, T, Compare2, Alloc, Policy>& source)  { tree_.merge_multi(source.tree_); }
+    template <typename Compare2>
+    void merge(multimap<Key, T, Compare2, Alloc, Policy>&& source) { tree_.merge_multi(source.tree_); }
+
     void      erase(iterator pos)                  { tree_.erase(pos); }
     size_type erase(const key_type& key)           { return tree_.erase_multi(key); }
     void      erase(iterator first, iterator last) { tree_.erase(first, last); }
@@ -464,60 +625,117 @@ public:
         return tree_.equal_range_multi(key);
     }
 
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return tree_.count_multi(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    {
+        return tree_.equal_range_multi(key);
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        return tree_.equal_range_multi(key);
+    }
+
+    // 顺序统计，只有节点策略为 mystl::rb_tree_rank_policy 时才能调用，都是 O(log n)
+    // nth(k) 返回第 k 小（从 0 开始）的元素，k 不小于 size() 时返回 end()；rank(key) 返回小于 key 的元素个数
+    iterator       nth(size_type k)                       { return tree_.nth(k); }
+    const_iterator nth(size_type k)                 const { return tree_.nth(k); }
+    size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      rank(const K& key)               const { return tree_.rank(key); }
+
     void swap(multimap& rhs) noexcept
     {
         tree_.swap(rhs.tree_);
     }
 
 public:
-    friend bool operator==(const multimap& lhs, const multimap& rhs) { return lhs.tree_ == rhs.tree; }
+    friend bool operator==(const multimap& lhs, const multimap& rhs) { return lhs.tree_ == rhs.tree_; }
     friend bool operator< (const multimap& lhs, const multimap& rhs) { return lhs.tree_ < rhs.tree_; }
 };
 
 // 重载比较操作符
-template <class Key, class T, class Compare>
-bool operator==(const multimap<Key, T, Compare>& lhs, const multimap<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator==(const multimap<Key, T, Compare, Alloc, Policy>& lhs, const multimap<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return lhs == rhs;
 }
 
-template <class Key, class T, class Compare>
-bool operator<(const multimap<Key, T, Compare>& lhs, const multimap<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator<(const multimap<Key, T, Compare, Alloc, Policy>& lhs, const multimap<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return lhs < rhs;
 }
 
-template <class Key, class T, class Compare>
-bool operator!=(const multimap<Key, T, Compare>& lhs, const multimap<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator!=(const multimap<Key, T, Compare, Alloc, Policy>& lhs, const multimap<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return !(lhs == rhs);
 }
 
-template <class Key, class T, class Compare>
-bool operator>(const multimap<Key, T, Compare>& lhs, const multimap<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator>(const multimap<Key, T, Compare, Alloc, Policy>& lhs, const multimap<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return rhs < lhs;
 }
 
-template <class Key, class T, class Compare>
-bool operator<=(const multimap<Key, T, Compare>& lhs, const multimap<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator<=(const multimap<Key, T, Compare, Alloc, Policy>& lhs, const multimap<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return !(rhs < lhs);
 }
 
-template <class Key, class T, class Compare>
-bool operator>=(const multimap<Key, T, Compare>& lhs, const multimap<Key, T, Compare>& rhs)
+template <class Key, class T, class Compare, class Alloc, class Policy>
+bool operator>=(const multimap<Key, T, Compare, Alloc, Policy>& lhs, const multimap<Key, T, Compare, Alloc, Policy>& rhs)
 {
   return !(lhs < rhs);
 }
 
 // 重载 mystl 的 swap
-template <class Key, class T, class Compare>
-void swap(multimap<Key, T, Compare>& lhs, multimap<Key, T, Compare>& rhs) noexcept
+template <class Key, class T, class Compare, class Alloc, class Policy>
+void swap(multimap<Key, T, Compare, Alloc, Policy>& lhs, multimap<Key, T, Compare, Alloc, Policy>& rhs) noexcept
 {
   lhs.swap(rhs);
 }
 
+// 与底层的 rb_tree 相同，可以直接搬移
+template <class Key, class T, class Compare, class Alloc, class Policy>
+struct is_trivially_relocatable<map<Key, T, Compare, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <class Key, class T, class Compare, class Alloc, class Policy>
+struct is_trivially_relocatable<multimap<Key, T, Compare, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 map / multimap，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <class Key, class T, class Compare = mystl::less<Key>>
+using map = mystl::map<Key, T, Compare, polymorphic_allocator<mystl::pair<const Key, T>>>;
+
+template <class Key, class T, class Compare = mystl::less<Key>>
+using multimap = mystl::multimap<Key, T, Compare, polymorphic_allocator<mystl::pair<const Key, T>>>;
+} // namespace pmr
+
 }
 
 #endif
\ No newline at end of file
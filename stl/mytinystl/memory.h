@@ -72,6 +72,7 @@ public:
     ~temporary_buffer()
     {
         mystl::destroy(buffer, buffer + len);
+        free(buffer);
     }
 
 public:
@@ -82,9 +83,8 @@ public:
 
 private:
     void allocate_buffer();
-    void initialize_buffer(const T&, std::true_type) {}
-    void initialize_buffer(const T& value, std::false_type)
-    { mystl::uninitialized_fill_n(buffer, len, value); }
+    void initialize_buffer(T&, std::true_type) {}
+    void initialize_buffer(T& value, std::false_type);
 
 private:
     temporary_buffer(const temporary_buffer&);
@@ -95,6 +95,7 @@ private:
 // 构造函数
 template <class ForwardIterator, class T>
 temporary_buffer<ForwardIterator, T>::temporary_buffer(ForwardIterator first, ForwardIterator last)
+    : original_len(0), len(0), buffer(nullptr)
 {
     try
     {
@@ -113,6 +114,28 @@ temporary_buffer<ForwardIterator, T>::temporary_buffer(ForwardIterator first, Fo
     }
 }
 
+// initialize_buffer 函数
+// 缓冲区的元素只是之后移动的落脚点，不需要 value 的副本：把 value 移入 buffer[0]，依次移动构造到末尾，
+// 再把最后一个元素移回 value，这样 value 不变，也不要求元素可复制
+template <class ForwardIterator, class T>
+void temporary_buffer<ForwardIterator, T>::initialize_buffer(T& value, std::false_type)
+{
+    T* cur = buffer;
+    mystl::construct(cur, mystl::move(value));
+    try
+    {
+        for(++cur; cur != buffer + len; ++cur)
+            mystl::construct(cur, mystl::move(*(cur - 1)));
+    }
+    catch(...)
+    {
+        value = mystl::move(*(cur - 1));
+        mystl::destroy(buffer, cur);
+        throw;
+    }
+    value = mystl::move(*(cur - 1));
+}
+
 // allocate_buffer 函数
 template <class ForwardIterator, class T>
 void temporary_buffer<ForwardIterator, T>::allocate_buffer()
@@ -0,0 +1,652 @@
+#ifndef MYTINYSTL_MEMORY_RESOURCE_H_
+#define MYTINYSTL_MEMORY_RESOURCE_H_
+
+// 这个头文件包含 mystl::pmr 下的内存资源体系以及模板类 polymorphic_allocator
+// memory_resource           : 所有内存资源的抽象基类
+// monotonic_buffer_resource : 单调增长的内存池（arena），释放操作什么都不做，析构时整体归还
+// unsynchronized_pool_resource / synchronized_pool_resource : 按大小分级的内存池，后者加锁
+// polymorphic_allocator     : 在运行期选择内存资源的分配器，各容器的 pmr 版本都使用它
+
+#include <cstddef>
+#include <new>
+#include <atomic>
+#include <mutex>
+
+#include "util.h"
+#include "construct.h"
+
+namespace mystl
+{
+
+namespace pmr
+{
+
+// 类：memory_resource
+// 派生类实现 do_allocate / do_deallocate / do_is_equal
+class memory_resource
+{
+public:
+    enum : size_t { max_align = alignof(std::max_align_t) };
+
+public:
+    virtual ~memory_resource() = default;
+
+    void* allocate(size_t bytes, size_t alignment = max_align)
+    {
+        return do_allocate(bytes, alignment);
+    }
+    void deallocate(void* ptr, size_t bytes, size_t alignment = max_align)
+    {
+        do_deallocate(ptr, bytes, alignment);
+    }
+    bool is_equal(const memory_resource& other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+    // 若为 true，deallocate 什么都不做，空间只在资源本身释放时统一归还
+    // 容器析构时据此跳过逐个节点的析构与释放
+    bool is_monotonic() const noexcept
+    {
+        return do_is_monotonic();
+    }
+
+private:
+    virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+    virtual void  do_deallocate(void* ptr, size_t bytes, size_t alignment) = 0;
+    virtual bool  do_is_equal(const memory_resource& other) const noexcept = 0;
+    virtual bool  do_is_monotonic() const noexcept { return false; }
+};
+
+inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept
+{
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+/*****************************************************************************************/
+// 全局的内存资源
+
+namespace resource_detail
+{
+
+// 使用 ::operator new / ::operator delete，对齐要求超过 max_align 时手动对齐，
+// 并在返回地址之前保存原始地址
+class new_delete_resource_impl : public memory_resource
+{
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if(alignment <= max_align)
+            return ::operator new(bytes);
+        void* raw = ::operator new(bytes + alignment + sizeof(void*));
+        auto addr = reinterpret_cast<size_t>(static_cast<char*>(raw) + sizeof(void*));
+        void* result = reinterpret_cast<void*>((addr + alignment - 1) & ~(alignment - 1));
+        static_cast<void**>(result)[-1] = raw;
+        return result;
+    }
+
+    void do_deallocate(void* ptr, size_t, size_t alignment) override
+    {
+        if(alignment <= max_align)
+            ::operator delete(ptr);
+        else
+            ::operator delete(static_cast<void**>(ptr)[-1]);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// 任何分配请求都抛出 std::bad_alloc
+class null_memory_resource_impl : public memory_resource
+{
+private:
+    void* do_allocate(size_t, size_t) override
+    {
+        throw std::bad_alloc();
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+inline std::atomic<memory_resource*>& default_resource() noexcept;
+
+} // namespace resource_detail
+
+inline memory_resource* new_delete_resource() noexcept
+{
+    static resource_detail::new_delete_resource_impl instance;
+    return &instance;
+}
+
+inline memory_resource* null_memory_resource() noexcept
+{
+    static resource_detail::null_memory_resource_impl instance;
+    return &instance;
+}
+
+inline std::atomic<memory_resource*>& resource_detail::default_resource() noexcept
+{
+    static std::atomic<memory_resource*> instance(new_delete_resource());
+    return instance;
+}
+
+// 设置缺省的内存资源，传入 nullptr 时恢复为 new_delete_resource()，返回之前的缺省资源
+inline memory_resource* set_default_resource(memory_resource* r) noexcept
+{
+    if(r == nullptr)
+        r = new_delete_resource();
+    return resource_detail::default_resource().exchange(r);
+}
+
+inline memory_resource* get_default_resource() noexcept
+{
+    return resource_detail::default_resource().load();
+}
+
+/*****************************************************************************************/
+
+// 类：monotonic_buffer_resource
+// 先使用构造时给定的缓冲区，用完后向上游资源申请成倍增长的内存块，每次分配只移动指针
+// deallocate 什么都不做，release() 或析构时把所有内存块一次性归还给上游资源
+class monotonic_buffer_resource : public memory_resource
+{
+private:
+    // 每个向上游申请的内存块头部，串成链表以便整体归还
+    struct chunk
+    {
+        chunk* next;
+        size_t size;
+        size_t alignment;
+    };
+
+    enum : size_t { default_size = 1024 };
+
+    memory_resource* upstream_;
+    void*            initial_buffer_;
+    size_t           initial_size_;
+    char*            cur_;        // 当前内存块中尚未使用的起始位置
+    size_t           space_;      // 当前内存块中剩余的字节数
+    size_t           next_size_;  // 下一个内存块的大小
+    chunk*           chunks_;
+
+public:
+    explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept
+        :upstream_(upstream), initial_buffer_(nullptr), initial_size_(0),
+         cur_(nullptr), space_(0), next_size_(default_size), chunks_(nullptr)
+    {
+    }
+
+    explicit monotonic_buffer_resource(size_t initial_size,
+                                       memory_resource* upstream = get_default_resource()) noexcept
+        :upstream_(upstream), initial_buffer_(nullptr), initial_size_(0),
+         cur_(nullptr), space_(0), next_size_(initial_size == 0 ? 1 : initial_size), chunks_(nullptr)
+    {
+    }
+
+    monotonic_buffer_resource(void* buffer, size_t buffer_size,
+                              memory_resource* upstream = get_default_resource()) noexcept
+        :upstream_(upstream), initial_buffer_(buffer), initial_size_(buffer_size),
+         cur_(static_cast<char*>(buffer)), space_(buffer_size),
+         next_size_(buffer_size == 0 ? default_size : buffer_size * 2), chunks_(nullptr)
+    {
+    }
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    ~monotonic_buffer_resource() override { release(); }
+
+    // 归还所有内存块，之后重新从初始缓冲区开始分配
+    void release() noexcept
+    {
+        while(chunks_ != nullptr)
+        {
+            chunk* next = chunks_->next;
+            upstream_->deallocate(chunks_, chunks_->size, chunks_->alignment);
+            chunks_ = next;
+        }
+        cur_ = static_cast<char*>(initial_buffer_);
+        space_ = initial_size_;
+    }
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* result = align_in_current(bytes, alignment);
+        if(result == nullptr)
+        {
+            new_chunk(bytes, alignment);
+            result = align_in_current(bytes, alignment);
+        }
+        return result;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    bool do_is_monotonic() const noexcept override { return true; }
+
+    // 在当前内存块中按 alignment 对齐切出 bytes 字节，空间不足时返回 nullptr
+    void* align_in_current(size_t bytes, size_t alignment) noexcept
+    {
+        if(cur_ == nullptr)return nullptr;
+        const auto addr = reinterpret_cast<size_t>(cur_);
+        const size_t pad = ((addr + alignment - 1) & ~(alignment - 1)) - addr;
+        if(pad > space_ || space_ - pad < bytes)return nullptr;
+        char* result = cur_ + pad;
+        cur_ = result + bytes;
+        space_ -= pad + bytes;
+        return result;
+    }
+
+    void new_chunk(size_t bytes, size_t alignment)
+    {
+        const size_t chunk_align = alignment > max_align ? alignment : static_cast<size_t>(max_align);
+        const size_t header = (sizeof(chunk) + chunk_align - 1) & ~(chunk_align - 1);
+        size_t size = next_size_;
+        if(size < bytes + alignment)
+            size = bytes + alignment;
+        size += header;
+        chunk* c = static_cast<chunk*>(upstream_->allocate(size, chunk_align));
+        c->next = chunks_;
+        c->size = size;
+        c->alignment = chunk_align;
+        chunks_ = c;
+        cur_ = reinterpret_cast<char*>(c) + header;
+        space_ = size - header;
+        next_size_ = size * 2;
+    }
+};
+
+/*****************************************************************************************/
+
+// 内存池的选项，0 表示使用缺省值
+struct pool_options
+{
+    size_t max_blocks_per_chunk = 0;         // 每个内存块最多容纳的块数
+    size_t largest_required_pool_block = 0;  // 超过这个大小的请求直接交给上游资源
+};
+
+// 类：unsynchronized_pool_resource
+// 按 2 的幂划分大小级别，每个级别从上游申请内存块并切分成固定大小的块，归还的块挂在空闲链表上
+// 超过 largest_required_pool_block 或对齐要求超过 max_align 的请求直接交给上游资源
+// release() 或析构时把所有空间整体归还，不加锁
+class unsynchronized_pool_resource : public memory_resource
+{
+private:
+    enum : size_t
+    {
+        min_block       = 8,
+        default_largest = 4096,
+        max_largest     = 64 * 1024,
+        default_blocks  = 1024,
+        init_blocks     = 16
+    };
+
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    // 每个内存块的头部，串成链表以便整体归还
+    struct chunk
+    {
+        chunk* next;
+        size_t size;
+    };
+
+    // 直接交给上游资源的大块空间的头部，双向链表使得单独释放为 O(1)
+    struct large_block
+    {
+        large_block* prev;
+        large_block* next;
+        size_t       size;
+        size_t       alignment;
+    };
+
+    // 一个大小级别
+    struct pool
+    {
+        free_block* free_list;
+        chunk*      chunks;
+        size_t      next_blocks;  // 下一个内存块容纳的块数
+    };
+
+    enum : size_t { chunk_header = (sizeof(chunk) + max_align - 1) & ~(max_align - 1) };
+
+    memory_resource* upstream_;
+    pool_options     options_;
+    pool*            pools_;
+    size_t           npools_;
+    large_block*     large_;
+
+public:
+    unsynchronized_pool_resource() : unsynchronized_pool_resource(pool_options(), get_default_resource()) {}
+
+    explicit unsynchronized_pool_resource(memory_resource* upstream)
+        : unsynchronized_pool_resource(pool_options(), upstream) {}
+
+    explicit unsynchronized_pool_resource(const pool_options& opts)
+        : unsynchronized_pool_resource(opts, get_default_resource()) {}
+
+    unsynchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        :upstream_(upstream), options_(opts), pools_(nullptr), npools_(0), large_(nullptr)
+    {
+        if(options_.max_blocks_per_chunk == 0)
+            options_.max_blocks_per_chunk = default_blocks;
+        if(options_.largest_required_pool_block == 0)
+            options_.largest_required_pool_block = default_largest;
+        if(options_.largest_required_pool_block > max_largest)
+            options_.largest_required_pool_block = max_largest;
+        size_t block = min_block;
+        for(npools_ = 1; block < options_.largest_required_pool_block; ++npools_)
+            block <<= 1;
+        options_.largest_required_pool_block = block;
+        pools_ = static_cast<pool*>(upstream_->allocate(npools_ * sizeof(pool), alignof(pool)));
+        for(size_t i = 0; i < npools_; ++i)
+        {
+            pools_[i].free_list = nullptr;
+            pools_[i].chunks = nullptr;
+            pools_[i].next_blocks = init_blocks;
+        }
+    }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+    ~unsynchronized_pool_resource() override
+    {
+        release();
+        upstream_->deallocate(pools_, npools_ * sizeof(pool), alignof(pool));
+    }
+
+    // 归还所有空间，包括尚未释放的块
+    void release() noexcept
+    {
+        for(size_t i = 0; i < npools_; ++i)
+        {
+            chunk* c = pools_[i].chunks;
+            while(c != nullptr)
+            {
+                chunk* next = c->next;
+                upstream_->deallocate(c, c->size, max_align);
+                c = next;
+            }
+            pools_[i].free_list = nullptr;
+            pools_[i].chunks = nullptr;
+            pools_[i].next_blocks = init_blocks;
+        }
+        while(large_ != nullptr)
+        {
+            large_block* next = large_->next;
+            upstream_->deallocate(large_, large_->size, large_->alignment);
+            large_ = next;
+        }
+    }
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+    pool_options     options() const noexcept { return options_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if(alignment > max_align || bytes > options_.largest_required_pool_block)
+            return allocate_large(bytes, alignment);
+        pool& p = pools_[pool_index(bytes < alignment ? alignment : bytes)];
+        if(p.free_list == nullptr)
+            refill(p, pool_block(&p));
+        free_block* result = p.free_list;
+        p.free_list = result->next;
+        return result;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        if(alignment > max_align || bytes > options_.largest_required_pool_block)
+        {
+            deallocate_large(ptr, alignment);
+            return;
+        }
+        pool& p = pools_[pool_index(bytes < alignment ? alignment : bytes)];
+        free_block* b = static_cast<free_block*>(ptr);
+        b->next = p.free_list;
+        p.free_list = b;
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static size_t pool_index(size_t bytes) noexcept
+    {
+        size_t i = 0;
+        for(size_t block = min_block; block < bytes; block <<= 1)
+            ++i;
+        return i;
+    }
+
+    size_t pool_block(const pool* p) const noexcept
+    {
+        return static_cast<size_t>(min_block) << (p - pools_);
+    }
+
+    // 为一个级别申请新的内存块，切分后全部挂到空闲链表上
+    void refill(pool& p, size_t block)
+    {
+        const size_t n = p.next_blocks;
+        const size_t size = chunk_header + n * block;
+        chunk* c = static_cast<chunk*>(upstream_->allocate(size, max_align));
+        c->next = p.chunks;
+        c->size = size;
+        p.chunks = c;
+        char* first = reinterpret_cast<char*>(c) + chunk_header;
+        for(size_t i = n; i > 0; --i)
+        {
+            free_block* b = reinterpret_cast<free_block*>(first + (i - 1) * block);
+            b->next = p.free_list;
+            p.free_list = b;
+        }
+        if(n * 2 <= options_.max_blocks_per_chunk)
+            p.next_blocks = n * 2;
+    }
+
+    // 块头按照 alignment 补齐，使得块头之后的空间满足对齐要求
+    static size_t large_header(size_t alignment) noexcept
+    {
+        if(alignment < max_align)
+            alignment = max_align;
+        return (sizeof(large_block) + alignment - 1) & ~(alignment - 1);
+    }
+
+    void* allocate_large(size_t bytes, size_t alignment)
+    {
+        const size_t header = large_header(alignment);
+        const size_t align = alignment > max_align ? alignment : static_cast<size_t>(max_align);
+        large_block* b = static_cast<large_block*>(upstream_->allocate(header + bytes, align));
+        b->size = header + bytes;
+        b->alignment = align;
+        b->prev = nullptr;
+        b->next = large_;
+        if(large_ != nullptr)
+            large_->prev = b;
+        large_ = b;
+        return reinterpret_cast<char*>(b) + header;
+    }
+
+    void deallocate_large(void* ptr, size_t alignment) noexcept
+    {
+        large_block* b = reinterpret_cast<large_block*>(static_cast<char*>(ptr) - large_header(alignment));
+        if(b->prev != nullptr)
+            b->prev->next = b->next;
+        else
+            large_ = b->next;
+        if(b->next != nullptr)
+            b->next->prev = b->prev;
+        upstream_->deallocate(b, b->size, b->alignment);
+    }
+};
+
+// 类：synchronized_pool_resource
+// 与 unsynchronized_pool_resource 相同，每次操作都加锁，可以被多个线程共享
+class synchronized_pool_resource : public memory_resource
+{
+private:
+    unsynchronized_pool_resource pool_;
+    mutable std::mutex           mutex_;
+
+public:
+    synchronized_pool_resource() : pool_() {}
+
+    explicit synchronized_pool_resource(memory_resource* upstream) : pool_(upstream) {}
+
+    explicit synchronized_pool_resource(const pool_options& opts) : pool_(opts) {}
+
+    synchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        : pool_(opts, upstream) {}
+
+    synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+    synchronized_pool_resource& operator=(const synchronized_pool_resource&) = delete;
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.release();
+    }
+
+    memory_resource* upstream_resource() const noexcept { return pool_.upstream_resource(); }
+    pool_options     options() const noexcept { return pool_.options(); }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/*****************************************************************************************/
+
+// 模板类：polymorphic_allocator
+// 模板参数代表数据类型，所有空间都从构造时给定的 memory_resource 中分配
+// 与标准库一致，容器复制、移动、交换时分配器都不传播，复制构造的容器使用缺省的内存资源
+template <typename T>
+class polymorphic_allocator
+{
+public:
+    typedef T         value_type;
+    typedef T*        pointer;
+    typedef const T*  const_pointer;
+    typedef T&        reference;
+    typedef const T&  const_reference;
+    typedef size_t    size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef polymorphic_allocator<U> other;
+    };
+
+public:
+    polymorphic_allocator() noexcept : resource_(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource* r) noexcept : resource_(r) {}
+
+    polymorphic_allocator(const polymorphic_allocator& rhs) = default;
+
+    template <typename U>
+    polymorphic_allocator(const polymorphic_allocator<U>& rhs) noexcept
+        :resource_(rhs.resource())
+    {
+    }
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = default;
+
+public:
+    T* allocate(size_type n)
+    {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_type n)
+    {
+        resource_->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args)
+    {
+        mystl::construct(ptr, mystl::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U* ptr)
+    {
+        mystl::destroy(ptr);
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const
+    {
+        return polymorphic_allocator();
+    }
+
+    // 内存资源是单调增长的，deallocate 什么都不做
+    bool deallocate_is_noop() const noexcept
+    {
+        return resource_->is_monotonic();
+    }
+
+    memory_resource* resource() const noexcept { return resource_; }
+
+private:
+    memory_resource* resource_;
+};
+
+template <typename T1, typename T2>
+bool operator==(const polymorphic_allocator<T1>& lhs, const polymorphic_allocator<T2>& rhs) noexcept
+{
+    return *lhs.resource() == *rhs.resource();
+}
+
+template <typename T1, typename T2>
+bool operator!=(const polymorphic_allocator<T1>& lhs, const polymorphic_allocator<T2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+} // namespace pmr
+
+} // namespace mystl
+
+#endif // !MYTINYSTL_MEMORY_RESOURCE_H_
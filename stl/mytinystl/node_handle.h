@@ -0,0 +1,182 @@
+#ifndef MYTINYSTL_NODE_HANDLE_H_
+#define MYTINYSTL_NODE_HANDLE_H_
+
+// 这个头文件包含关联式容器共用的节点句柄 node_handle，以及 insert(node_handle) 的返回型别 node_insert_return
+// node_handle : 独占一个已经从容器中摘下的节点，extract 把节点交给它，insert 再把节点链接进容器，
+//               整个过程不重新分配节点，也不复制或移动元素
+
+#include <new>
+
+#include "util.h"
+#include "type_traits.h"
+#include "memory.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+template <class Node, class NodeAlloc> class node_handle;
+
+template <class T, class Compare, class Alloc, class Policy> class rb_tree;
+template <class T, class Hash, class KeyEqual, class Alloc, class Policy> class hashtable;
+
+// 元素访问接口：map 类容器的句柄提供 key() 与 mapped()，set 类容器的句柄提供 value()
+template <class Value, class Handle, bool = mystl::is_pair<Value>::value>
+class node_handle_access
+{
+public:
+    typedef Value value_type;
+
+    value_type& value() const
+    {
+        MYSTL_DEBUG(!static_cast<const Handle*>(this)->empty());
+        return static_cast<const Handle*>(this)->ptr_->value;
+    }
+};
+
+template <class Value, class Handle>
+class node_handle_access<Value, Handle, true>
+{
+public:
+    typedef typename std::remove_cv<typename Value::first_type>::type key_type;
+    typedef typename Value::second_type                               mapped_type;
+
+    // 元素中的键值是 const 的，句柄独占节点，允许在重新插入之前修改它
+    key_type& key() const
+    {
+        MYSTL_DEBUG(!static_cast<const Handle*>(this)->empty());
+        return const_cast<key_type&>(static_cast<const Handle*>(this)->ptr_->value.first);
+    }
+
+    mapped_type& mapped() const
+    {
+        MYSTL_DEBUG(!static_cast<const Handle*>(this)->empty());
+        return static_cast<const Handle*>(this)->ptr_->value.second;
+    }
+};
+
+// 模板类 node_handle
+// 参数一代表节点类型，参数二代表节点的分配器
+// 非空的句柄持有节点以及分配节点时使用的分配器，析构时用它销毁节点，空的句柄不持有分配器
+template <class Node, class NodeAlloc>
+class node_handle : public node_handle_access<decltype(std::declval<Node&>().value),
+                                              node_handle<Node, NodeAlloc>>
+{
+    typedef decltype(std::declval<Node&>().value) node_value_type;
+
+    friend class node_handle_access<node_value_type, node_handle>;
+    template <class, class, class, class> friend class rb_tree;
+    template <class, class, class, class, class> friend class hashtable;
+
+public:
+    typedef mystl::allocator_traits<NodeAlloc>          node_alloc_traits;
+    typedef typename node_alloc_traits::template rebind_alloc<node_value_type> allocator_type;
+
+private:
+    typedef Node* node_ptr;
+
+    node_ptr ptr_;
+    union
+    {
+        NodeAlloc alloc_;  // 只有 ptr_ 不为空时才构造
+    };
+
+public:
+    node_handle() noexcept : ptr_(nullptr) {}
+
+    node_handle(node_handle&& rhs) noexcept : ptr_(rhs.ptr_)
+    {
+        if(ptr_ != nullptr)
+        {
+            ::new (mystl::address_of(alloc_)) NodeAlloc(mystl::move(rhs.alloc_));
+            rhs.reset();
+        }
+    }
+
+    node_handle& operator=(node_handle&& rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            destroy();
+            ptr_ = rhs.ptr_;
+            if(ptr_ != nullptr)
+            {
+                ::new (mystl::address_of(alloc_)) NodeAlloc(mystl::move(rhs.alloc_));
+                rhs.reset();
+            }
+        }
+        return *this;
+    }
+
+    node_handle(const node_handle&) = delete;
+    node_handle& operator=(const node_handle&) = delete;
+
+    ~node_handle() { destroy(); }
+
+    bool empty() const noexcept { return ptr_ == nullptr; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    allocator_type get_allocator() const
+    {
+        MYSTL_DEBUG(!empty());
+        return allocator_type(alloc_);
+    }
+
+    void swap(node_handle& rhs) noexcept
+    {
+        node_handle tmp(mystl::move(rhs));
+        rhs = mystl::move(*this);
+        *this = mystl::move(tmp);
+    }
+
+    friend void swap(node_handle& lhs, node_handle& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+private:
+    // 以下函数只供容器使用：extract 时接管摘下的节点，insert 时把节点交还给容器
+    node_handle(node_ptr p, const NodeAlloc& alloc) : ptr_(p)
+    {
+        ::new (mystl::address_of(alloc_)) NodeAlloc(alloc);
+    }
+
+    node_ptr release() noexcept
+    {
+        node_ptr p = ptr_;
+        reset();
+        return p;
+    }
+
+    const NodeAlloc& node_alloc() const noexcept { return alloc_; }
+
+    void reset() noexcept
+    {
+        alloc_.~NodeAlloc();
+        ptr_ = nullptr;
+    }
+
+    void destroy() noexcept
+    {
+        if(ptr_ != nullptr)
+        {
+            node_alloc_traits::destroy(alloc_, mystl::address_of(ptr_->value));
+            node_alloc_traits::deallocate(alloc_, ptr_, 1);
+            reset();
+        }
+    }
+};
+
+// 模板结构 node_insert_return
+// 键值不允许重复的容器 insert(node_handle) 的返回值：插入成功时 node 为空，
+// 否则 position 指向已经存在的元素，node 仍然持有原来的节点
+template <class Iterator, class NodeHandle>
+struct node_insert_return
+{
+    Iterator   position;
+    bool       inserted;
+    NodeHandle node;
+};
+
+} // namespace mystl
+#endif // !MYTINYSTL_NODE_HANDLE_H_
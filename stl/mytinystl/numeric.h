@@ -7,13 +7,35 @@ namespace mystl{
 
 // accumulate
 template<class InputIterator,class T>
-T accumulate(InputIterator first,InputIterator last,T init){
+T accumulate(InputIterator first,InputIterator last,T init);
+
+// 分段迭代器的版本：逐段累加，每一段都是一对指针
+template<class InputIterator,class T>
+T segmented_accumulate(InputIterator first,InputIterator last,T init,m_true_type){
+    typedef segmented_iterator_traits<InputIterator> traits;
+    auto sfirst=traits::segment(first);
+    const auto slast=traits::segment(last);
+    if(sfirst==slast)return mystl::accumulate(traits::local(first),traits::local(last),init);
+    init=mystl::accumulate(traits::local(first),traits::end(sfirst),init);
+    for(++sfirst;sfirst!=slast;++sfirst){
+        init=mystl::accumulate(traits::begin(sfirst),traits::end(sfirst),init);
+    }
+    return mystl::accumulate(traits::begin(slast),traits::local(last),init);
+}
+
+template<class InputIterator,class T>
+T segmented_accumulate(InputIterator first,InputIterator last,T init,m_false_type){
     for(;first!=last;++first){
         init=init+*first;
     }
     return init;
 }
 
+template<class InputIterator,class T>
+T accumulate(InputIterator first,InputIterator last,T init){
+    return segmented_accumulate(first,last,init,is_segmented_iterator<InputIterator>{});
+}
+
 template<class InputIterator,class T,class BinaryOperation>
 T accumulate(InputIterator first,InputIterator last,T init,BinaryOperation binary_op){
     for(;first!=last;++first){
@@ -72,7 +94,7 @@ T inner_product(InputIterator1 first1,InputIterator1 last1,InputIterator2 first2
 
 
 // partial_sum
-template<class IunputIterator,class OutputIterator>
+template<class InputIterator,class OutputIterator>
 OutputIterator partial_sum(InputIterator first,InputIterator last,OutputIterator result){
     if(first==last)return result;
     *result=*first;
@@ -84,7 +106,7 @@ OutputIterator partial_sum(InputIterator first,InputIterator last,OutputIterator
     return ++result;
 }
 
-template<class IunputIterator,class OutputIterator,class BinaryOperation>
+template<class InputIterator,class OutputIterator,class BinaryOperation>
 OutputIterator partial_sum(InputIterator first,InputIterator last,OutputIterator result,BinaryOperation binary_op){
     if(first==last)return result;
     *result=*first;
@@ -99,16 +121,13 @@ OutputIterator partial_sum(InputIterator first,InputIterator last,OutputIterator
 
 // iota
 template<class ForwardIterator,class T>
-void iota(Forward_iterator first,ForwardIterator last,T value){
+void iota(ForwardIterator first,ForwardIterator last,T value){
     while(first!=last){
         *first++=value++;
     }
 }
 
 
-// power
-power
-
 }
 
 #endif
\ No newline at end of file
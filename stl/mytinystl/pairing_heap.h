@@ -0,0 +1,513 @@
+#ifndef MYTINYSTL_PAIRING_HEAP_H_
+#define MYTINYSTL_PAIRING_HEAP_H_
+
+// 这个头文件包含了一个模板类 pairing_heap
+// pairing_heap : 配对堆，push 为 O(1)，pop 为均摊 O(log n)，
+//                push 返回指向元素的句柄，可以通过句柄修改优先级或删除元素
+
+// notes:
+//
+// 与 priority_queue 相同，使用 mystl::less 时堆顶为最大的元素
+// decrease_key 提高元素的优先级（对使用 mystl::greater 的最小堆而言即减小键值），均摊 O(1)
+// 句柄在元素被 pop / erase 之前一直有效，其他操作不会使句柄失效
+//
+// 异常保证：
+// mystl::pairing_heap<T> 满足基本异常保证，对 push / emplace 做强异常安全保证
+
+#include <initializer_list>
+
+#include "memory.h"
+#include "functional.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// pairing heap 的结点，以左孩子右兄弟的方式存放
+template <class T>
+struct pairing_heap_node
+{
+    pairing_heap_node* child;  // 第一个子结点
+    pairing_heap_node* next;   // 下一个兄弟结点
+    pairing_heap_node* prev;   // 上一个兄弟结点，第一个子结点指向父结点
+    T                  value;
+};
+
+// pairing heap 的句柄，指向一个结点
+template <class T>
+class pairing_heap_handle
+{
+    template <class, class, class> friend class pairing_heap;
+
+public:
+    pairing_heap_handle() noexcept : node_(nullptr) {}
+
+    const T& operator*()  const { MYSTL_DEBUG(node_ != nullptr); return node_->value; }
+    const T* operator->() const { return mystl::address_of(operator*()); }
+
+    bool operator==(const pairing_heap_handle& rhs) const noexcept { return node_ == rhs.node_; }
+    bool operator!=(const pairing_heap_handle& rhs) const noexcept { return node_ != rhs.node_; }
+
+private:
+    explicit pairing_heap_handle(pairing_heap_node<T>* p) noexcept : node_(p) {}
+
+    pairing_heap_node<T>* node_;
+};
+
+// 模板类 pairing_heap
+// 参数一代表数据类型，参数二代表比较权值的方式，缺省使用 mystl::less，参数三代表空间配置器
+template <class T, class Compare = mystl::less<T>, class Alloc = mystl::allocator<T>>
+class pairing_heap
+    : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<pairing_heap_node<T>>>
+{
+public:
+    // pairing_heap 的嵌套型别定义
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>                    data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<pairing_heap_node<T>> node_allocator;
+    typedef mystl::allocator_traits<node_allocator>  node_alloc_traits;
+    typedef data_allocator                           allocator_type;
+
+    typedef T                                        value_type;
+    typedef Compare                                  value_compare;
+    typedef value_type&                              reference;
+    typedef const value_type&                        const_reference;
+    typedef size_t                                   size_type;
+    typedef pairing_heap_handle<T>                   handle;
+
+    allocator_type get_allocator() const { return allocator_type(this->get_alloc()); }
+    value_compare  value_comp()    const { return comp_; }
+
+private:
+    typedef pairing_heap_node<T>*                    node_ptr;
+    typedef mystl::alloc_holder<node_allocator>      alloc_base;
+
+    node_ptr      root_;  // 堆顶结点
+    size_type     size_;  // 元素个数
+    value_compare comp_;
+
+public:
+    // 构造、复制、移动、析构函数
+    pairing_heap() : root_(nullptr), size_(0), comp_() {}
+
+    explicit pairing_heap(const Compare& c, const allocator_type& alloc = allocator_type())
+        : alloc_base(node_allocator(alloc)), root_(nullptr), size_(0), comp_(c) {}
+
+    template <class InputIterator>
+    pairing_heap(InputIterator first, InputIterator last, const Compare& c = Compare())
+        : root_(nullptr), size_(0), comp_(c)
+    {
+        try
+        {
+            for (; first != last; ++first)
+                push(*first);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    pairing_heap(std::initializer_list<value_type> ilist, const Compare& c = Compare())
+        : pairing_heap(ilist.begin(), ilist.end(), c) {}
+
+    pairing_heap(const pairing_heap& rhs)
+        : alloc_base(node_alloc_traits::select_on_container_copy_construction(rhs.get_alloc())),
+          root_(nullptr), size_(0), comp_(rhs.comp_)
+    { copy_from(rhs); }
+
+    pairing_heap(pairing_heap&& rhs) noexcept
+        : alloc_base(mystl::move(rhs.get_alloc())), root_(rhs.root_), size_(rhs.size_), comp_(rhs.comp_)
+    {
+        rhs.root_ = nullptr;
+        rhs.size_ = 0;
+    }
+
+    pairing_heap& operator=(const pairing_heap& rhs);
+    pairing_heap& operator=(pairing_heap&& rhs);
+
+    pairing_heap& operator=(std::initializer_list<value_type> ilist)
+    {
+        pairing_heap tmp(ilist, comp_);
+        swap(tmp);
+        return *this;
+    }
+
+    ~pairing_heap() { clear(); }
+
+public:
+    // 访问元素相关操作
+    const_reference top() const
+    {
+        MYSTL_DEBUG(!empty());
+        return root_->value;
+    }
+
+    // 容量相关操作
+    bool      empty() const noexcept { return root_ == nullptr; }
+    size_type size()  const noexcept { return size_; }
+
+    // 修改容器相关操作
+    template <class... Args>
+    handle emplace(Args&&... args)
+    {
+        THROW_LENGTH_ERROR_IF(size_ == static_cast<size_type>(-1), "pairing_heap<T>'s size too big");
+        node_ptr p = create_node(mystl::forward<Args>(args)...);
+        root_ = link(root_, p);
+        ++size_;
+        return handle(p);
+    }
+
+    handle push(const value_type& value) { return emplace(value); }
+    handle push(value_type&& value)      { return emplace(mystl::move(value)); }
+
+    void pop();
+    void erase(handle h);
+
+    // 用 value 替换句柄所指的元素，value 的优先级不能低于原来的元素
+    void decrease_key(handle h, const value_type& value)
+    { raise_node(h.node_, value); }
+    void decrease_key(handle h, value_type&& value)
+    { raise_node(h.node_, mystl::move(value)); }
+
+    // 用 value 替换句柄所指的元素，优先级可以任意改变
+    void update(handle h, const value_type& value)
+    { update_node(h.node_, value); }
+    void update(handle h, value_type&& value)
+    { update_node(h.node_, mystl::move(value)); }
+
+    // 把 other 的所有元素并入本容器，other 的句柄随元素一起转移，两者的分配器应当相等
+    void merge(pairing_heap& other);
+    void merge(pairing_heap&& other) { merge(other); }
+
+    void clear() noexcept;
+
+    void swap(pairing_heap& rhs) noexcept
+    {
+        mystl::swap(root_, rhs.root_);
+        mystl::swap(size_, rhs.size_);
+        mystl::swap(comp_, rhs.comp_);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
+    }
+
+private:
+    // helper functions
+
+    // create / destroy node
+    template <class... Args>
+    node_ptr create_node(Args&&... args);
+    void     destroy_node(node_ptr p);
+
+    // link / merge
+    node_ptr link(node_ptr a, node_ptr b);
+    node_ptr merge_pairs(node_ptr first);
+    void     detach(node_ptr p) noexcept;
+
+    // change key
+    template <class V>
+    void     raise_node(node_ptr p, V&& value);
+    template <class V>
+    void     update_node(node_ptr p, V&& value);
+
+    // copy
+    void     copy_from(const pairing_heap& rhs);
+};
+
+/*****************************************************************************************/
+
+// 复制赋值运算符
+template <class T, class Compare, class Alloc>
+pairing_heap<T, Compare, Alloc>&
+pairing_heap<T, Compare, Alloc>::operator=(const pairing_heap& rhs)
+{
+    if (this != &rhs)
+    {
+        clear();
+        mystl::alloc_on_copy(this->get_alloc(), rhs.get_alloc());
+        comp_ = rhs.comp_;
+        copy_from(rhs);
+    }
+    return *this;
+}
+
+// 移动赋值运算符
+template <class T, class Compare, class Alloc>
+pairing_heap<T, Compare, Alloc>&
+pairing_heap<T, Compare, Alloc>::operator=(pairing_heap&& rhs)
+{
+    if (this == &rhs)
+        return *this;
+    clear();
+    comp_ = rhs.comp_;
+    if (node_alloc_traits::propagate_on_container_move_assignment::value ||
+        this->get_alloc() == rhs.get_alloc())
+    {
+        mystl::alloc_on_move(this->get_alloc(), rhs.get_alloc());
+        root_ = rhs.root_;
+        size_ = rhs.size_;
+        rhs.root_ = nullptr;
+        rhs.size_ = 0;
+    }
+    else
+    {
+        // 分配器不相等且不传播时，只能逐个移动元素
+        while (!rhs.empty())
+        {
+            push(mystl::move(rhs.root_->value));
+            rhs.pop();
+        }
+    }
+    return *this;
+}
+
+// 删除堆顶元素，两趟合并其子结点
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::pop()
+{
+    MYSTL_DEBUG(!empty());
+    node_ptr old = root_;
+    root_ = merge_pairs(old->child);
+    destroy_node(old);
+    --size_;
+}
+
+// 删除句柄所指的元素
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::erase(handle h)
+{
+    node_ptr p = h.node_;
+    MYSTL_DEBUG(p != nullptr);
+    if (p == root_)
+    {
+        pop();
+        return;
+    }
+    detach(p);
+    root_ = link(root_, merge_pairs(p->child));
+    destroy_node(p);
+    --size_;
+}
+
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::merge(pairing_heap& other)
+{
+    if (this == &other)
+        return;
+    MYSTL_DEBUG(this->get_alloc() == other.get_alloc());
+    root_ = link(root_, other.root_);
+    size_ += other.size_;
+    other.root_ = nullptr;
+    other.size_ = 0;
+}
+
+// 清空容器，把左孩子右兄弟的二叉树不断右旋，不需要递归或额外的栈
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::clear() noexcept
+{
+    node_ptr p = root_;
+    while (p != nullptr)
+    {
+        if (p->child != nullptr)
+        {
+            node_ptr c = p->child;
+            p->child = c->next;
+            c->next = p;
+            p = c;
+        }
+        else
+        {
+            node_ptr next = p->next;
+            destroy_node(p);
+            p = next;
+        }
+    }
+    root_ = nullptr;
+    size_ = 0;
+}
+
+/*****************************************************************************************/
+// helper function
+
+// 创建结点
+template <class T, class Compare, class Alloc>
+template <class... Args>
+typename pairing_heap<T, Compare, Alloc>::node_ptr
+pairing_heap<T, Compare, Alloc>::create_node(Args&&... args)
+{
+    node_ptr p = node_alloc_traits::allocate(this->get_alloc(), 1);
+    try
+    {
+        node_alloc_traits::construct(this->get_alloc(), mystl::address_of(p->value), mystl::forward<Args>(args)...);
+        p->child = nullptr;
+        p->next = nullptr;
+        p->prev = nullptr;
+    }
+    catch (...)
+    {
+        node_alloc_traits::deallocate(this->get_alloc(), p, 1);
+        throw;
+    }
+    return p;
+}
+
+// 销毁结点
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::destroy_node(node_ptr p)
+{
+    node_alloc_traits::destroy(this->get_alloc(), mystl::address_of(p->value));
+    node_alloc_traits::deallocate(this->get_alloc(), p, 1);
+}
+
+// 合并两棵独立的树，优先级低的根成为另一个根的第一个子结点，返回新的根
+template <class T, class Compare, class Alloc>
+typename pairing_heap<T, Compare, Alloc>::node_ptr
+pairing_heap<T, Compare, Alloc>::link(node_ptr a, node_ptr b)
+{
+    if (a == nullptr)
+        return b;
+    if (b == nullptr)
+        return a;
+    if (comp_(a->value, b->value))
+        mystl::swap(a, b);
+    b->prev = a;
+    b->next = a->child;
+    if (a->child != nullptr)
+        a->child->prev = b;
+    a->child = b;
+    return a;
+}
+
+// 两趟合并一串兄弟结点：先从左到右两两合并，再从右到左依次并入
+template <class T, class Compare, class Alloc>
+typename pairing_heap<T, Compare, Alloc>::node_ptr
+pairing_heap<T, Compare, Alloc>::merge_pairs(node_ptr first)
+{
+    if (first == nullptr)
+        return nullptr;
+    // 第一趟，合并得到的树以 next 逆序串起来
+    node_ptr stack = nullptr;
+    while (first != nullptr)
+    {
+        node_ptr a = first;
+        node_ptr b = a->next;
+        first = b == nullptr ? nullptr : b->next;
+        a->next = a->prev = nullptr;
+        if (b != nullptr)
+            b->next = b->prev = nullptr;
+        node_ptr r = link(a, b);
+        r->next = stack;
+        stack = r;
+    }
+    // 第二趟
+    node_ptr root = stack;
+    stack = stack->next;
+    root->next = nullptr;
+    while (stack != nullptr)
+    {
+        node_ptr next = stack->next;
+        stack->next = nullptr;
+        root = link(root, stack);
+        stack = next;
+    }
+    return root;
+}
+
+// 把以 p 为根的子树从其父结点上摘下，p 不能是堆顶
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::detach(node_ptr p) noexcept
+{
+    if (p->prev->child == p)
+        p->prev->child = p->next;
+    else
+        p->prev->next = p->next;
+    if (p->next != nullptr)
+        p->next->prev = p->prev;
+    p->next = p->prev = nullptr;
+}
+
+// 提高结点的优先级：摘下以它为根的子树，再与堆顶合并
+template <class T, class Compare, class Alloc>
+template <class V>
+void pairing_heap<T, Compare, Alloc>::raise_node(node_ptr p, V&& value)
+{
+    MYSTL_DEBUG(p != nullptr);
+    MYSTL_DEBUG(!comp_(value, p->value));
+    p->value = mystl::forward<V>(value);
+    if (p != root_)
+    {
+        detach(p);
+        root_ = link(root_, p);
+    }
+}
+
+// 任意修改结点的值：优先级提高时同 raise_node，
+// 否则先把它的子结点合并回堆中，再把它作为单个结点重新插入
+template <class T, class Compare, class Alloc>
+template <class V>
+void pairing_heap<T, Compare, Alloc>::update_node(node_ptr p, V&& value)
+{
+    MYSTL_DEBUG(p != nullptr);
+    if (!comp_(value, p->value))
+    {
+        raise_node(p, mystl::forward<V>(value));
+        return;
+    }
+    p->value = mystl::forward<V>(value);
+    node_ptr sub = merge_pairs(p->child);
+    p->child = nullptr;
+    if (p == root_)
+    {
+        root_ = link(sub, p);
+    }
+    else
+    {
+        detach(p);
+        root_ = link(link(root_, sub), p);
+    }
+}
+
+// 复制 rhs 的所有元素，沿 prev 指针回溯遍历，不需要递归或额外的栈
+template <class T, class Compare, class Alloc>
+void pairing_heap<T, Compare, Alloc>::copy_from(const pairing_heap& rhs)
+{
+    try
+    {
+        node_ptr p = rhs.root_;
+        while (p != nullptr)
+        {
+            push(p->value);
+            if (p->child != nullptr)
+            {
+                p = p->child;
+                continue;
+            }
+            // 回溯到第一个还有未访问兄弟结点的祖先
+            while (p->next == nullptr)
+            {
+                while (p->prev != nullptr && p->prev->child != p)
+                    p = p->prev;  // 跳过左侧的兄弟结点，回到第一个子结点
+                p = p->prev;      // 回到父结点
+                if (p == nullptr)
+                    return;
+            }
+            p = p->next;
+        }
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+}
+
+// 重载 mystl 的 swap
+template <class T, class Compare, class Alloc>
+void swap(pairing_heap<T, Compare, Alloc>& lhs, pairing_heap<T, Compare, Alloc>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_PAIRING_HEAP_H_
+
@@ -0,0 +1,298 @@
+#ifndef MYTINYSTL_POOL_ALLOCATOR_H_
+#define MYTINYSTL_POOL_ALLOCATOR_H_
+
+// 这个头文件包含一个模板类 pool_allocator
+// 链表、红黑树、哈希表这类容器每次只分配一个节点，若直接调用 ::operator new，
+// malloc 会成为插入操作的主要开销。pool_allocator 从大块内存（slab）中切分固定大小的节点，
+// 归还的节点挂在对应大小的空闲链表上复用，容器析构时整块归还 slab
+
+#include <cstddef>
+#include <new>
+
+#include "util.h"
+
+namespace mystl
+{
+
+// 类：node_pool
+// 按 8 字节对齐把小块内存划分为若干大小级别，每个级别维护一条空闲链表以及当前正在切分的 slab
+// 一个 node_pool 由一个容器以及它 rebind 出来的分配器共享，和容器本身一样不加锁，
+// 同一时刻只应被一个线程使用
+class node_pool
+{
+public:
+    enum : size_t
+    {
+        align      = 8,                   // 节点大小的对齐粒度
+        max_bytes  = 256,                 // 超过该大小的请求不经过内存池
+        nclass     = max_bytes / align,   // 大小级别的个数
+        init_nodes = 32,                  // 每个级别第一块 slab 容纳的节点数
+        slab_bytes = 64 * 1024            // slab 成倍增长，直到这个大小为止
+    };
+
+private:
+    // 空闲节点复用自身的空间保存下一个空闲节点
+    struct free_node
+    {
+        free_node* next;
+    };
+
+    // 每块 slab 的头部，把所有 slab 串成链表，释放时整体归还
+    struct slab
+    {
+        slab* next;
+    };
+
+    enum : size_t { header = (sizeof(slab) + align - 1) & ~(align - 1) };
+
+    free_node* free_list_[nclass];  // 每个级别归还的节点
+    char*      cur_[nclass];        // 当前 slab 中尚未切分的起始位置
+    char*      end_[nclass];        // 当前 slab 的尾部
+    size_t     nodes_[nclass];      // 下一块 slab 容纳的节点数
+    slab*      slabs_;              // 已分配的 slab 链表
+    size_t     refs_;               // 共享该内存池的分配器个数
+
+public:
+    node_pool() noexcept
+        :slabs_(nullptr), refs_(1)
+    {
+        reset();
+    }
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    ~node_pool() { release(); }
+
+    // 分配 bytes 字节的空间，bytes 不超过 max_bytes
+    void* allocate(size_t bytes)
+    {
+        const size_t i = class_index(bytes);
+        free_node* p = free_list_[i];
+        if(p != nullptr)
+        {
+            free_list_[i] = p->next;
+            return p;
+        }
+        const size_t size = (i + 1) * align;
+        if(static_cast<size_t>(end_[i] - cur_[i]) < size)
+            refill(i);
+        void* result = cur_[i];
+        cur_[i] += size;
+        return result;
+    }
+
+    // 归还的节点挂到对应级别的空闲链表上，不会归还给系统
+    void deallocate(void* ptr, size_t bytes) noexcept
+    {
+        const size_t i = class_index(bytes);
+        free_node* p = static_cast<free_node*>(ptr);
+        p->next = free_list_[i];
+        free_list_[i] = p;
+    }
+
+    // 整块归还所有 slab，之前分配出去的节点全部失效
+    void release() noexcept
+    {
+        while(slabs_ != nullptr)
+        {
+            slab* next = slabs_->next;
+            ::operator delete(slabs_);
+            slabs_ = next;
+        }
+        reset();
+    }
+
+    void add_ref() noexcept { ++refs_; }
+    // 返回 true 表示已经没有分配器引用该内存池
+    bool remove_ref() noexcept { return --refs_ == 0; }
+
+private:
+    static size_t class_index(size_t bytes) noexcept
+    {
+        return bytes == 0 ? 0 : (bytes + align - 1) / align - 1;
+    }
+
+    void reset() noexcept
+    {
+        for(size_t i = 0; i < nclass; ++i)
+        {
+            free_list_[i] = nullptr;
+            cur_[i] = nullptr;
+            end_[i] = nullptr;
+            nodes_[i] = init_nodes;
+        }
+    }
+
+    // 为第 i 个级别申请一块新的 slab，旧 slab 已经恰好切分完毕
+    void refill(size_t i)
+    {
+        const size_t size = (i + 1) * align;
+        const size_t n = nodes_[i];
+        slab* s = static_cast<slab*>(::operator new(header + n * size));
+        s->next = slabs_;
+        slabs_ = s;
+        cur_[i] = reinterpret_cast<char*>(s) + header;
+        end_[i] = cur_[i] + n * size;
+        if(n * size * 2 <= slab_bytes)
+            nodes_[i] = n * 2;
+    }
+};
+
+// 模板类：pool_allocator
+// 模板参数代表数据类型
+// 每个默认构造的 pool_allocator 拥有一个新的内存池，复制和 rebind 得到的分配器共享同一个内存池，
+// 最后一个引用它的分配器析构时（即容器析构时）整体归还所有 slab
+// 复制构造容器时会为新容器创建新的内存池，移动和交换时内存池随节点一起转移
+// 默认构造不抛出异常：若内存池本身申请失败，该分配器不使用内存池，所有请求直接交给 ::operator new，
+// 真正的分配失败推迟到 allocate 时以 std::bad_alloc 报告。被移动后的分配器同样处于这种状态
+template <typename T>
+class pool_allocator
+{
+public:
+    typedef T         value_type;
+    typedef T*        pointer;
+    typedef const T*  const_pointer;
+    typedef T&        reference;
+    typedef const T&  const_reference;
+    typedef size_t    size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef pool_allocator<U> other;
+    };
+
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type  propagate_on_container_move_assignment;
+    typedef std::true_type  propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+public:
+    pool_allocator() noexcept
+        :pool_(new (std::nothrow) node_pool)
+    {
+    }
+
+    pool_allocator(const pool_allocator& rhs) noexcept
+        :pool_(rhs.pool_)
+    {
+        add_ref();
+    }
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>& rhs) noexcept
+        :pool_(rhs.pool_)
+    {
+        add_ref();
+    }
+
+    // 移动时直接转移内存池，引用计数不变
+    pool_allocator(pool_allocator&& rhs) noexcept
+        :pool_(rhs.pool_)
+    {
+        rhs.pool_ = nullptr;
+    }
+
+    pool_allocator& operator=(const pool_allocator& rhs) noexcept
+    {
+        if(pool_ != rhs.pool_)
+        {
+            drop();
+            pool_ = rhs.pool_;
+            add_ref();
+        }
+        return *this;
+    }
+
+    pool_allocator& operator=(pool_allocator&& rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            drop();
+            pool_ = rhs.pool_;
+            rhs.pool_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~pool_allocator() { drop(); }
+
+public:
+    T* allocate(size_type n)
+    {
+        if(n == 0)return nullptr;
+        if(use_pool(n))
+            return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_type n) noexcept
+    {
+        if(ptr == nullptr)return;
+        if(use_pool(n))
+            pool_->deallocate(ptr, n * sizeof(T));
+        else
+            ::operator delete(ptr);
+    }
+
+    // 复制出来的容器使用独立的内存池
+    pool_allocator select_on_container_copy_construction() const
+    {
+        return pool_allocator();
+    }
+
+private:
+    // 对齐要求超过内存池粒度或者过大的请求直接交给 ::operator new
+    bool use_pool(size_type n) const noexcept
+    {
+        return pool_ != nullptr && alignof(T) <= node_pool::align &&
+            n <= node_pool::max_bytes / sizeof(T);
+    }
+
+    void add_ref() noexcept
+    {
+        if(pool_ != nullptr)
+            pool_->add_ref();
+    }
+
+    // 放弃对内存池的引用，之后 pool_ 为空
+    void drop() noexcept
+    {
+        if(pool_ != nullptr && pool_->remove_ref())
+            delete pool_;
+        pool_ = nullptr;
+    }
+
+    template <typename U>
+    friend class pool_allocator;
+
+    template <typename T1, typename T2>
+    friend bool operator==(const pool_allocator<T1>&, const pool_allocator<T2>&) noexcept;
+
+private:
+    node_pool* pool_;
+};
+
+// 共享同一个内存池的分配器才相等，可以互相释放对方分配的空间；
+// 没有内存池的分配器都直接使用 ::operator new，彼此相等
+template <typename T1, typename T2>
+bool operator==(const pool_allocator<T1>& lhs, const pool_allocator<T2>& rhs) noexcept
+{
+    return lhs.pool_ == rhs.pool_;
+}
+
+template <typename T1, typename T2>
+bool operator!=(const pool_allocator<T1>& lhs, const pool_allocator<T2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+// pool_allocator 只保存指向内存池的指针，搬移时引用计数不变
+template <typename T>
+struct is_trivially_relocatable<pool_allocator<T>> : m_true_type {};
+
+} // namespace mystl
+
+#endif // !MYTINYSTL_POOL_ALLOCATOR_H_
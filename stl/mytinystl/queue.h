@@ -4,6 +4,8 @@
 // 这个头文件包含了两个模板类 queue 和 priority_queue
 // queue          : 队列
 // priority_queue : 优先队列
+// 以及 priority_queue 使用的 heap 策略 binary_heap_policy 和 dary_heap_policy
+// 需要 O(1) 插入、decrease_key 或按句柄删除时使用 pairing_heap.h 中的 pairing_heap
 
 #include "deque.h"
 #include "vector.h"
@@ -150,10 +152,54 @@ void swap(queue<T, Container> &lhs, queue<T, Container> &rhs) noexcept(noexcept(
     lhs.swap(rhs);
 }
 
+// heap 策略
+// priority_queue 通过策略类在底层容器上维护 heap，策略类需要提供：
+//   static void make_heap(RandomIter first, RandomIter last, Compare comp) : 把 [first, last) 调整为 heap
+//   static void push_heap(RandomIter first, RandomIter last, Compare comp) : 把尾部的新元素加入 heap
+//   static void pop_heap(RandomIter first, RandomIter last, Compare comp)  : 把堆顶移到尾部，调整其余元素
+
+// 二叉堆策略（缺省），使用 heap_algo.h 中的 make_heap / push_heap / pop_heap
+struct binary_heap_policy
+{
+    template <class RandomIter, class Compare>
+    static void make_heap(RandomIter first, RandomIter last, Compare comp)
+    { mystl::make_heap(first, last, comp); }
+
+    template <class RandomIter, class Compare>
+    static void push_heap(RandomIter first, RandomIter last, Compare comp)
+    { mystl::push_heap(first, last, comp); }
+
+    template <class RandomIter, class Compare>
+    static void pop_heap(RandomIter first, RandomIter last, Compare comp)
+    { mystl::pop_heap(first, last, comp); }
+};
+
+// D 叉堆策略，树高为 log_D(n)，每个结点的 D 个子结点连续存放
+// 元素很多时 pop 的缓存缺失比二叉堆少，push 的比较次数也更少；D 通常取 4 或 8
+template <size_t D>
+struct dary_heap_policy
+{
+    static_assert(D >= 2, "the arity of d-ary heap should be at least 2");
+
+    template <class RandomIter, class Compare>
+    static void make_heap(RandomIter first, RandomIter last, Compare comp)
+    { mystl::make_dary_heap<D>(first, last, comp); }
+
+    template <class RandomIter, class Compare>
+    static void push_heap(RandomIter first, RandomIter last, Compare comp)
+    { mystl::push_dary_heap<D>(first, last, comp); }
+
+    template <class RandomIter, class Compare>
+    static void pop_heap(RandomIter first, RandomIter last, Compare comp)
+    { mystl::pop_dary_heap<D>(first, last, comp); }
+};
+
 // 模板类 priority_queue
 // 参数一代表数据类型，参数二代表容器类型，缺省使用 mystl::vector 作为底层容器
 // 参数三代表比较权值的方式，缺省使用 mystl::less 作为比较方式
-template <class T, class Container = vector<T>, class Compare = mystl::less<typename Container::value_type>>
+// 参数四代表 heap 策略，缺省使用 binary_heap_policy
+template <class T, class Container = vector<T>, class Compare = mystl::less<typename Container::value_type>,
+          class HeapPolicy = binary_heap_policy>
 class priority_queue
 {
 public:
@@ -179,55 +225,55 @@ public:
 
     explicit priority_queue(size_type n) : c_(n)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
 
     priority_queue(size_type n, const value_type &value) : c_(n, value)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
 
     template <class InputIterator>
     priority_queue(InputIterator first, InputIterator last) : c_(first, last)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
 
     priority_queue(std::initializer_list<value_type> ilist) : c_(ilist)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
 
     priority_queue(const Container &c) : c_(c)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
     priority_queue(Container &&c) : c_(mystl::move(c))
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
 
     priority_queue(const priority_queue &rhs) : c_(rhs.c_), comp_(rhs.comp_)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     } // 这里不移动吗
     priority_queue(priority_queue &&rhs) : c_(mystl::move(rhs.c_)), comp_(rhs.comp_)
     {
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
     }
 
     priority_queue &operator=(const priority_queue &rhs)
     {
         c_ = rhs.c_;
         comp_ = rhs.comp_;
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
         return *this;
     }
     priority_queue &operator=(priority_queue &&rhs) noexcept(std::is_nothrow_move_constructible<Container>::value)
     {
         c_ = mystl::move(rhs.c_);
         comp_ = rhs.comp_;
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
         return *this;
     }
 
@@ -235,7 +281,7 @@ public:
     {
         c_ = ilist;
         comp_ = value_compare();
-        mystl::make_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::make_heap(c_.begin(), c_.end(), comp_);
         return *this;
     }
 
@@ -253,23 +299,23 @@ public:
     void emplace(Args &&...args)
     {
         c_.emplace_back(mystl::forward<Args>(args)...);
-        mystl::push_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::push_heap(c_.begin(), c_.end(), comp_);
     }
 
     void push(const value_type &value)
     {
         c_.push_back(value);
-        mystl::push_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::push_heap(c_.begin(), c_.end(), comp_);
     }
     void push(value_type &&value)
     {
         c_.push_back(mystl::move(value));
-        mystl::push_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::push_heap(c_.begin(), c_.end(), comp_);
     }
 
     void pop()
     {
-        mystl::pop_heap(c_.begin(), c_.end(), comp_);
+        HeapPolicy::pop_heap(c_.begin(), c_.end(), comp_);
         c_.pop_back();
     }
 
@@ -298,21 +344,21 @@ public:
 };
 
 // 重载比较操作符
-template <class T, class Container, class Compare>
-bool operator==(const priority_queue<T, Container, Compare> &lhs, const priority_queue<T, Container, Compare> &rhs)
+template <class T, class Container, class Compare, class HeapPolicy>
+bool operator==(const priority_queue<T, Container, Compare, HeapPolicy> &lhs, const priority_queue<T, Container, Compare, HeapPolicy> &rhs)
 {
     return lhs == rhs;
 }
 
-template <class T, class Container, class Compare>
-bool operator!=(const priority_queue<T, Container, Compare> &lhs, const priority_queue<T, Container, Compare> &rhs)
+template <class T, class Container, class Compare, class HeapPolicy>
+bool operator!=(const priority_queue<T, Container, Compare, HeapPolicy> &lhs, const priority_queue<T, Container, Compare, HeapPolicy> &rhs)
 {
     return lhs != rhs;
 }
 
 // 重载 mystl 的 swap
-template <class T, class Container, class Compare>
-void swap(priority_queue<T, Container, Compare> &lhs, priority_queue<T, Container, Compare> &rhs) noexcept(noexcept(lhs.swap(rhs)))
+template <class T, class Container, class Compare, class HeapPolicy>
+void swap(priority_queue<T, Container, Compare, HeapPolicy> &lhs, priority_queue<T, Container, Compare, HeapPolicy> &rhs) noexcept(noexcept(lhs.swap(rhs)))
 {
     lhs.swap(rhs);
 }
@@ -6,12 +6,14 @@
 
 #include <initializer_list>
 #include <cassert>
+#include <cstdint>
 
 #include "iterator.h"
 #include "type_traits.h"
 #include "memory.h"
 #include "functional.h"
 #include "exceptdef.h"
+#include "node_handle.h"
 
 namespace mystl
 {
@@ -23,13 +25,80 @@ typedef bool rb_tree_color_type;
 static constexpr rb_tree_color_type rb_tree_red   = false;
 static constexpr rb_tree_color_type rb_tree_black = true;
 
+// 节点策略
+// rb_tree 通过策略类在节点中附加信息，并在树的结构改变时维护它，策略类需要提供：
+//   struct node_data                        : 附加在每个节点（包括 header）上的数据
+//   static void update(x)                   : 左右子树已经确定，重新计算 x 的附加数据，用于旋转与批量构造
+//   static void on_insert(x, root)          : x 为刚链接到树上的叶节点，在重新平衡之前调用
+//   static void on_erase(z, y, root)        : 将要删除 z，y 为实际从原位置摘下的节点，在重新平衡之前调用
+
+// 普通策略（缺省），节点不附加任何信息
+struct rb_tree_plain_policy
+{
+    struct node_data {};
+
+    template <typename NodePtr>
+    static void update(NodePtr) noexcept {}
+    template <typename NodePtr>
+    static void on_insert(NodePtr, NodePtr) noexcept {}
+    template <typename NodePtr>
+    static void on_erase(NodePtr, NodePtr, NodePtr) noexcept {}
+};
+
+// 顺序统计策略，每个节点记录以它为根的子树的节点数，使 rb_tree 可以在 O(log n) 内
+// 取得第 k 小的元素以及某个键值的排名
+struct rb_tree_rank_policy
+{
+    struct node_data
+    {
+        size_t size;  // 子树的节点数
+    };
+
+    template <typename NodePtr>
+    static size_t size(NodePtr x) noexcept
+    {
+        return x == nullptr ? 0 : x->size;
+    }
+
+    template <typename NodePtr>
+    static void update(NodePtr x) noexcept
+    {
+        x->size = size(x->left) + size(x->right) + 1;
+    }
+
+    // x 的祖先都多了一个节点，header 为根节点的父节点
+    template <typename NodePtr>
+    static void on_insert(NodePtr x, NodePtr root) noexcept
+    {
+        x->size = 1;
+        for(auto p = x->parent(); p != root->parent(); p = p->parent())
+            ++p->size;
+    }
+
+    // y 的祖先都少了一个节点；y 不是 z 时它会顶替 z 的位置，也就接替 z 的子树大小
+    template <typename NodePtr>
+    static void on_erase(NodePtr z, NodePtr y, NodePtr root) noexcept
+    {
+        for(auto p = y->parent(); p != root->parent(); p = p->parent())
+            --p->size;
+        if(y != z)
+            y->size = z->size;
+    }
+};
+
+template <typename Policy>
+struct rb_tree_is_ranked : public m_false_type {};
+
+template <>
+struct rb_tree_is_ranked<rb_tree_rank_policy> : public m_true_type {};
+
 // forward declaration
 
-template <typename T> struct rb_tree_node_base;
-template <typename T> struct rb_tree_node;
+template <typename T, typename Policy> struct rb_tree_node_base;
+template <typename T, typename Policy> struct rb_tree_node;
 
-template <typename T> struct rb_tree_iterator;
-template <typename T> struct rb_tree_const_iterator;
+template <typename T, typename Policy> struct rb_tree_iterator;
+template <typename T, typename Policy> struct rb_tree_const_iterator;
 
 // rb tree value traits
 
@@ -99,7 +168,7 @@ struct rb_tree_value_traits
 
 // rb tree node traits
 
-template <typename T>
+template <typename T, typename Policy>
 struct rb_tree_node_traits
 {
     typedef rb_tree_color_type                 color_type;
@@ -109,23 +178,51 @@ struct rb_tree_node_traits
     typedef typename value_traits::mapped_type mapped_type;
     typedef typename value_traits::value_type  value_type;
 
-    typedef rb_tree_node_base<T>*              base_ptr;
-    typedef rb_tree_node<T>*                   node_ptr;
+    typedef rb_tree_node_base<T, Policy>*      base_ptr;
+    typedef rb_tree_node<T, Policy>*           node_ptr;
 };
 
 // rb tree 的节点设计
 
-template <typename T>
-struct rb_tree_node_base
+template <typename T, typename Policy>
+struct rb_tree_node_base : public Policy::node_data
 {
-    typedef rb_tree_color_type    color_type;
-    typedef rb_tree_node_base<T>* base_ptr;
-    typedef rb_tree_node<T>*      node_ptr;
+    typedef rb_tree_color_type            color_type;
+    typedef rb_tree_node_base<T, Policy>* base_ptr;
+    typedef rb_tree_node<T, Policy>*      node_ptr;
+    typedef Policy                        policy_type;
+
+    // 节点总是按指针对齐分配，父节点地址的最低位恒为 0，用它存放节点颜色，
+    // 省下单独的颜色成员以及随之而来的填充
+    uintptr_t  parent_color;  // 父节点地址 | 节点颜色
+    base_ptr   left;          // 左子节点
+    base_ptr   right;         // 右子节点
+
+    base_ptr parent() const noexcept
+    {
+        return reinterpret_cast<base_ptr>(parent_color & ~static_cast<uintptr_t>(1));
+    }
+
+    color_type color() const noexcept
+    {
+        return static_cast<color_type>(parent_color & 1);
+    }
+
+    void set_parent(base_ptr p) noexcept
+    {
+        parent_color = reinterpret_cast<uintptr_t>(p) | (parent_color & 1);
+    }
+
+    void set_color(color_type c) noexcept
+    {
+        parent_color = (parent_color & ~static_cast<uintptr_t>(1)) | static_cast<uintptr_t>(c);
+    }
 
-    base_ptr   parent;  // 父节点
-    base_ptr   left;    // 左子节点
-    base_ptr   right;   // 右子节点
-    color_type color;   // 节点颜色
+    // 同时写入父节点与颜色，用于初始化刚分配的节点
+    void set_parent_color(base_ptr p, color_type c) noexcept
+    {
+        parent_color = reinterpret_cast<uintptr_t>(p) | static_cast<uintptr_t>(c);
+    }
 
     base_ptr get_base_ptr()
     {
@@ -143,11 +240,11 @@ struct rb_tree_node_base
     }
 };
 
-template <typename T>
-struct rb_tree_node : public rb_tree_node_base<T>
+template <typename T, typename Policy>
+struct rb_tree_node : public rb_tree_node_base<T, Policy>
 {
-    typedef rb_tree_node_base<T>* base_ptr;
-    typedef rb_tree_node<T>*      node_ptr;
+    typedef rb_tree_node_base<T, Policy>* base_ptr;
+    typedef rb_tree_node<T, Policy>*      node_ptr;
 
     T value;  // 节点值
 
@@ -164,7 +261,7 @@ struct rb_tree_node : public rb_tree_node_base<T>
 
 // rb tree traits
 
-template <typename T>
+template <typename T, typename Policy>
 struct rb_tree_traits
 {
     typedef rb_tree_value_traits<T>            value_traits;
@@ -178,8 +275,8 @@ struct rb_tree_traits
     typedef const value_type*                  const_pointer;
     typedef const value_type&                  const_reference;
 
-    typedef rb_tree_node_base<T>               base_type;
-    typedef rb_tree_node<T>                    node_type;
+    typedef rb_tree_node_base<T, Policy>       base_type;
+    typedef rb_tree_node<T, Policy>            node_type;
 
     typedef base_type*                         base_ptr;
     typedef node_type*                         node_ptr;
@@ -187,10 +284,10 @@ struct rb_tree_traits
 
 // rb tree 的迭代器设计
 
-template <typename T>
+template <typename T, typename Policy>
 struct rb_tree_iterator_base : public mystl::iterator<mystl::bidirectional_iterator_tag, T>
 {
-    typedef typename rb_tree_traits<T>::base_ptr base_ptr;
+    typedef typename rb_tree_traits<T, Policy>::base_ptr base_ptr;
 
     base_ptr node;  // 指向节点本身
 
@@ -205,11 +302,11 @@ struct rb_tree_iterator_base : public mystl::iterator<mystl::bidirectional_itera
         }
         else
         {   // 如果没有右子节点
-            auto y = node->parent;
+            auto y = node->parent();
             while(y->right == node)
             {
                 node = y;
-                y = y->parent;
+                y = y->parent();
             }
             if(node->right != y)node = y;  // 应对“寻找根节点的下一节点，而根节点没有右子节点”的特殊情况
         }
@@ -218,7 +315,7 @@ struct rb_tree_iterator_base : public mystl::iterator<mystl::bidirectional_itera
     // 使迭代器后退
     void dec()
     {
-        if(node == node->parent->parent && rb_tree_is_red(node))
+        if(node == node->parent()->parent() && rb_tree_is_red(node))
         {
             node = node->right;  // 如果 node 为 header,指向整棵树的 max 节点
         }
@@ -228,11 +325,11 @@ struct rb_tree_iterator_base : public mystl::iterator<mystl::bidirectional_itera
         }
         else
         {
-            auto y = node->parent;
+            auto y = node->parent();
             while(node == y->left)
             {
                 node = y;
-                y = y->parent;
+                y = y->parent();
             }
             node = y;
         }
@@ -242,10 +339,10 @@ struct rb_tree_iterator_base : public mystl::iterator<mystl::bidirectional_itera
     bool operator!=(const rb_tree_iterator_base& rhs) { return node != rhs.node; }
 };
 
-template <typename T>
-struct rb_tree_iterator : public rb_tree_iterator_base<T>
+template <typename T, typename Policy>
+struct rb_tree_iterator : public rb_tree_iterator_base<T, Policy>
 {
-    typedef rb_tree_traits<T>                tree_traits;
+    typedef rb_tree_traits<T, Policy>        tree_traits;
 
     typedef typename tree_traits::value_type value_type;
     typedef typename tree_traits::pointer    pointer;
@@ -253,11 +350,11 @@ struct rb_tree_iterator : public rb_tree_iterator_base<T>
     typedef typename tree_traits::base_ptr   base_ptr;
     typedef typename tree_traits::node_ptr   node_ptr;
 
-    typedef rb_tree_iterator<T>              iterator;
-    typedef rb_tree_const_iterator<T>        const_iterator;
-    typedef iterator                         self;
+    typedef rb_tree_iterator<T, Policy>       iterator;
+    typedef rb_tree_const_iterator<T, Policy> const_iterator;
+    typedef iterator                          self;
 
-    using rb_tree_iterator_base<T>::node;
+    using rb_tree_iterator_base<T, Policy>::node;
 
     // 构造函数
     rb_tree_iterator() {}
@@ -294,10 +391,10 @@ struct rb_tree_iterator : public rb_tree_iterator_base<T>
     }
 };
 
-template <typename T>
-struct rb_tree_const_iterator : public rb_tree_iterator_base<T>
+template <typename T, typename Policy>
+struct rb_tree_const_iterator : public rb_tree_iterator_base<T, Policy>
 {
-    typedef rb_tree_traits<T>                      tree_traits;
+    typedef rb_tree_traits<T, Policy>              tree_traits;
 
     typedef typename tree_traits::value_type       value_type;
     typedef typename tree_traits::const_pointer    pointer;
@@ -305,11 +402,11 @@ struct rb_tree_const_iterator : public rb_tree_iterator_base<T>
     typedef typename tree_traits::base_ptr         base_ptr;
     typedef typename tree_traits::node_ptr         node_ptr;
     
-    typedef rb_tree_iterator<T>                    iterator;
-    typedef rb_tree_const_iterator<T>              const_iterator;
+    typedef rb_tree_iterator<T, Policy>            iterator;
+    typedef rb_tree_const_iterator<T, Policy>      const_iterator;
     typedef const_iterator                         self;
 
-    using rb_tree_iterator_base<T>::node;
+    using rb_tree_iterator_base<T, Policy>::node;
 
     // 构造函数
     rb_tree_const_iterator() {}
@@ -364,25 +461,25 @@ NodePtr rb_tree_max(NodePtr x) noexcept
 template <typename NodePtr>
 bool rb_tree_is_lchild(NodePtr node) noexcept
 {
-    return node == node->parent->left;
+    return node == node->parent()->left;
 }
 
 template <typename NodePtr>
 bool rb_tree_is_red(NodePtr node) noexcept
 {
-    return node->color == rb_tree_red;
+    return node->color() == rb_tree_red;
 }
 
 template <typename NodePtr>
-void rb_tree_set_black(NodePtr& node) noexcept
+void rb_tree_set_black(NodePtr node) noexcept
 {
-    node->color = rb_tree_black;
+    node->set_color(rb_tree_black);
 }
 
 template <typename NodePtr>
-void rb_tree_set_red(NodePtr& node) noexcept
+void rb_tree_set_red(NodePtr node) noexcept
 {
-    node->color = rb_tree_red;
+    node->set_color(rb_tree_red);
 }
 
 template <typename NodePtr>
@@ -394,9 +491,9 @@ NodePtr rb_tree_next(NodePtr node) noexcept
     }
     while(!rb_tree_is_lchild(node))
     {
-        node = node->parent;
+        node = node->parent();
     }
-    return node->parent;  // header空节点的问题
+    return node->parent();  // header空节点的问题
 }
 
 /*---------------------------------------*\
@@ -408,28 +505,38 @@ NodePtr rb_tree_next(NodePtr node) noexcept
 |      / \                   / \          |
 |     b   c                 a   b         |
 \*---------------------------------------*/
+// 取得节点所用的节点策略
+template <typename NodePtr>
+struct rb_tree_policy_of
+{
+    typedef typename std::remove_pointer<NodePtr>::type::policy_type type;
+};
+
 // 左旋，参数一为左旋点，参数二为根节点
 template <typename NodePtr>
 void rb_tree_rotate_left(NodePtr x, NodePtr& root) noexcept
 {
+    typedef typename rb_tree_policy_of<NodePtr>::type policy;
     auto y = x->right;  // y 为 x 的右子节点
     x->right = y->left;
-    if(y->left != nullptr)y->left->parent = x;
-    y->parent = x->parent;
+    if(y->left != nullptr)y->left->set_parent(x);
+    y->set_parent(x->parent());
     if(x == root)
     {
         root = y;
     }
     else if(rb_tree_is_lchild(x))
     {
-        x->parent->left = y;
+        x->parent()->left = y;
     }
     else
     {
-        x->parent->right = y;
+        x->parent()->right = y;
     }
-    x->parent = y;
+    x->set_parent(y);
     y->left = x;
+    policy::update(x);
+    policy::update(y);
 }
 
 /*----------------------------------------*\
@@ -445,76 +552,80 @@ void rb_tree_rotate_left(NodePtr x, NodePtr& root) noexcept
 template <typename NodePtr>
 void rb_tree_rotate_right(NodePtr x, NodePtr& root) noexcept
 {
+    typedef typename rb_tree_policy_of<NodePtr>::type policy;
     auto y = x->left;
     x->left = y->right;
-    if(y->right != nullptr)y->right->parent = x;
-    y->parent = x->parent;
+    if(y->right != nullptr)y->right->set_parent(x);
+    y->set_parent(x->parent());
     if(x == root)
     {
         root = y;
     }
     else if(rb_tree_is_lchild(x))
     {
-        x->parent->left = y;
+        x->parent()->left = y;
     }
     else
     {
-        x->parent->right = y;
+        x->parent()->right = y;
     }
-    x->parent = y;
+    x->set_parent(y);
     y->right = x;
+    policy::update(x);
+    policy::update(y);
 }
 
 // 插入节点后使 rb tree 重新平衡，参数一为新增节点，参数二为根节点
 template <typename NodePtr>
 void rb_tree_insert_rebalance(NodePtr x, NodePtr& root) noexcept
 {
+    rb_tree_policy_of<NodePtr>::type::on_insert(x, root);
     rb_tree_set_red(x);
-    while(x != root && rb_tree_is_red(x->parent))
+    while(x != root && rb_tree_is_red(x->parent()))
     {
-        if(rb_tree_is_lchild(x->parent))
+        if(rb_tree_is_lchild(x->parent()))
         {
-            auto uncle = x->parent->parent->right;
+            auto uncle = x->parent()->parent()->right;
             if(uncle != nullptr && rb_tree_is_red(uncle))
             {
-                rb_tree_set_black(x->parent);
+                rb_tree_set_black(x->parent());
                 rb_tree_set_black(uncle);
-                x = x->parent->parent;
+                x = x->parent()->parent();
                 rb_tree_set_red(x);
             }
             else
             {
                 if(!rb_tree_is_lchild(x))
                 {
-                    x = x->parent;
+                    x = x->parent();
                     rb_tree_rotate_left(x, root);
                 }
-                rb_tree_set_black(x->parent);
-                rb_tree_set_red(x->parent->parent);
-                rb_tree_rotate_right(x->parent->parent, root);
+                rb_tree_set_black(x->parent());
+                rb_tree_set_red(x->parent()->parent());
+                rb_tree_rotate_right(x->parent()->parent(), root);
                 break;
             }
         }
         else
         {
-            auto uncle = x->parent->parent->left;
+            auto uncle = x->parent()->parent()->left;
             if(uncle != nullptr && rb_tree_is_red(uncle))
             {
-                rb_tree_set_black(x->parent);
+                rb_tree_set_black(x->parent());
                 rb_tree_set_black(uncle);
-                x = x->parent->parent;
+                x = x->parent()->parent();
                 rb_tree_set_red(x);
             }
             else
             {
                 if(rb_tree_is_lchild(x))
                 {
-                    x = x->parent;
+                    x = x->parent();
                     rb_tree_rotate_right(x, root);
                 }
-                rb_tree_set_black(x->parent);
-                rb_tree_set_red(x->parent->parent);
-                rb_tree_rotate_left(x->parent->parent, root);
+                rb_tree_set_black(x->parent());
+                rb_tree_set_red(x->parent()->parent());
+                rb_tree_rotate_left(x->parent()->parent(), root);
                 break;
             }
         }
@@ -532,6 +643,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
     auto y = (z->left == nullptr || z->right == nullptr) ? z : rb_tree_next(z);
     // x 是 y 的一个独子节点或 NIL 节点
     auto x = y->left != nullptr ? y->left : y->right;
+    rb_tree_policy_of<NodePtr>::type::on_erase(z, y, root);
     // xp 为 x 的父节点
     NodePtr xp = nullptr;
 
@@ -539,15 +651,15 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
     // 用 y 顶替 z 的位置，用 x 顶替 y 的位置，最后用 y 指向 z
     if(y != z)
     {
-        z->left->parent = y;
+        z->left->set_parent(y);
         y->left = z->left;
         // 如果 y 不是 z 的右子节点，那么 z 的右子节点一定有左孩子
         if(y != z->right)
         {
-            xp = y->parent;
-            if(x != nullptr)x->parent = xp;
+            xp = y->parent();
+            if(x != nullptr)x->set_parent(xp);
             xp->left = x;
-            z->right->parent = y;
+            z->right->set_parent(y);
             y->right = z->right;
         }
         else
@@ -556,21 +668,23 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
         }
 
         if(root == z)root = y;
-        else if(rb_tree_is_lchild(z))z->parent->left = y;
-        else z->parent->right = y;
-        y->parent = z->parent;
-        mystl::swap(y->color, z->color);
+        else if(rb_tree_is_lchild(z))z->parent()->left = y;
+        else z->parent()->right = y;
+        y->set_parent(z->parent());
+        auto yc = y->color();
+        y->set_color(z->color());
+        z->set_color(yc);
         y = z;
     }
     // y == z 说明 z 至多只有一个孩子
     else
     {
         // 连接 x 与 z 的父节点
-        xp = y->parent;
-        if(x)x->parent = xp;
+        xp = y->parent();
+        if(x)x->set_parent(xp);
         if(root == z)root = x;
-        else if(rb_tree_is_lchild(z))z->parent->left = x;
-        else z->parent->right = x;
+        else if(rb_tree_is_lchild(z))z->parent()->left = x;
+        else z->parent()->right = x;
 
         // 此时 z 有可能是最左节点或最右节点，更新数据
         if(leftmost == z)leftmost = x == nullptr ? xp : rb_tree_min(x);
@@ -601,7 +715,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
                 {
                     rb_tree_set_red(brother);
                     x = xp;
-                    xp = xp->parent;
+                    xp = xp->parent();
                 }
                 else
                 {
@@ -615,7 +729,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
                         rb_tree_rotate_right(brother, root);
                         brother = xp->right;
                     }
-                    brother->color = xp->color;
+                    brother->set_color(xp->color());
                     rb_tree_set_black(xp);
                     if(brother->right != nullptr)rb_tree_set_black(brother->right);
                     rb_tree_rotate_left(xp, root);
@@ -637,7 +751,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
                 {
                     rb_tree_set_red(brother);
                     x = xp;
-                    xp = xp->parent;
+                    xp = xp->parent();
                 }
                 else
                 {
@@ -648,7 +762,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
                         rb_tree_rotate_left(brother, root);
                         brother = xp->left;
                     }
-                    brother->color = xp->color;
+                    brother->set_color(xp->color());
                     rb_tree_set_black(xp);
                     if(brother->left != nullptr)rb_tree_set_black(brother->left);
                     rb_tree_rotate_right(xp, root);
@@ -662,13 +776,16 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
 }
 
 // 模板类 rb_tree
-// 参数一代表数据类型，参数二代表键值比较类型
-template <typename T, typename Compare>
-class rb_tree
+// 参数一代表数据类型，参数二代表键值比较类型，参数三代表空间配置器
+// 参数四代表节点策略，缺省使用 mystl::rb_tree_plain_policy，也可以使用 mystl::rb_tree_rank_policy
+// rb_tree 保存的是结点的分配器，header_ 与元素分别通过重新绑定得到的分配器构造
+template <typename T, typename Compare, typename Alloc = mystl::allocator<T>,
+          typename Policy = mystl::rb_tree_plain_policy>
+class rb_tree : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<rb_tree_node<T, Policy>>>
 {
 public:
     // rb_tree 的嵌套型别定义 
-    typedef rb_tree_traits<T>                        tree_traits;
+    typedef rb_tree_traits<T, Policy>                tree_traits;
     typedef rb_tree_value_traits<T>                  value_traits;
 
     typedef typename tree_traits::base_type          base_type;
@@ -680,27 +797,38 @@ public:
     typedef typename tree_traits::value_type         value_type;
     typedef Compare                                  key_compare;
 
-    typedef mystl::allocator<T>                      allocator_type;
-    typedef mystl::allocator<T>                      data_allocator;
-    typedef mystl::allocator<base_type>              base_allocator;
-    typedef mystl::allocator<node_type>              node_allocator;
-
-    typedef typename allocator_type::pointer         pointer;
-    typedef typename allocator_type::const_pointer   const_pointer;
-    typedef typename allocator_type::reference       reference;
-    typedef typename allocator_type::const_reference const_reference;
-    typedef typename allocator_type::size_type       size_type;
-    typedef typename allocator_type::difference_type difference_type;
-
-    typedef rb_tree_iterator<T>                      iterator;
-    typedef rb_tree_const_iterator<T>                const_iterator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>         data_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<base_type> base_allocator;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<node_type> node_allocator;
+    typedef mystl::allocator_traits<data_allocator>     data_alloc_traits;
+    typedef mystl::allocator_traits<base_allocator>     base_alloc_traits;
+    typedef mystl::allocator_traits<node_allocator>     node_alloc_traits;
+    typedef data_allocator                              allocator_type;
+
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
+
+    typedef rb_tree_iterator<T, Policy>              iterator;
+    typedef rb_tree_const_iterator<T, Policy>        const_iterator;
     typedef mystl::reverse_iterator<iterator>        reverse_iterator;
     typedef mystl::reverse_iterator<const_iterator>  const_reverse_iterator;
 
-    allocator_type get_allocator() const { return node_allocator(); }
+    typedef mystl::node_handle<node_type, node_allocator>         node_handle;
+    typedef mystl::node_insert_return<iterator, node_handle>      insert_return_type;
+
+    allocator_type get_allocator() const { return allocator_type(this->get_alloc()); }
     key_compare    key_comp()      const { return key_comp_; }
 
+    // merge 需要访问比较函数不同的 rb_tree 的节点
+    template <typename, typename, typename, typename> friend class rb_tree;
+
 private:
+    typedef mystl::alloc_holder<node_allocator>      alloc_base;
+
     // 用以下三个数据表现 rb tree
     base_ptr    header_;      // 特殊节点，与根节点互为对方的父节点
     size_type   node_count_;  // 节点数
@@ -708,21 +836,37 @@ private:
 
 private:
     // 以下三个函数用于取得根节点，最小节点和最大节点
-    base_ptr& root()      const { return header_->parent; }
+    base_ptr  root()      const { return header_->parent(); }
     base_ptr& leftmost()  const { return header_->left; }
     base_ptr& rightmost() const { return header_->right; }
 
+    // 根节点地址与 header_ 的颜色共用一个字，不能取引用，经由 set_root 修改
+    void set_root(base_ptr x) const { header_->set_parent(x); }
+
 public:
     // 构造、复制、析构函数
     rb_tree() { rb_tree_init(); }
 
+    explicit rb_tree(const allocator_type& alloc)
+        :alloc_base(node_allocator(alloc))
+    { rb_tree_init(); }
+
     rb_tree(const rb_tree& rhs);
+    rb_tree(const rb_tree& rhs, const allocator_type& alloc);
     rb_tree(rb_tree&& rhs) noexcept;
 
     rb_tree& operator=(const rb_tree& rhs);
     rb_tree& operator=(rb_tree&& rhs);
 
-    ~rb_tree() { clear(); }
+    ~rb_tree()
+    {
+        if(header_ != nullptr)
+        {
+            if(!node_alloc_traits::template can_skip_destroy<T>(this->get_alloc()))
+                clear();
+            destroy_header();
+        }
+    }
 
 public:
     // 迭代器相关操作
@@ -772,6 +916,13 @@ public:
     template <typename... Args>
     iterator emplace_unique_use_hint(iterator hint, Args&&... args);
 
+    // try_emplace，键值已经存在时什么都不做，args 不会被移动
+    template <typename K, typename... Args>
+    mystl::pair<iterator, bool> try_emplace_unique(K&& key, Args&&... args);
+
+    template <typename K, typename... Args>
+    iterator try_emplace_unique_use_hint(iterator hint, K&& key, Args&&... args);
+
     // insert
     iterator insert_multi(const value_type& value);
     iterator insert_multi(value_type&& value)
@@ -788,11 +939,14 @@ public:
         return emplace_multi_use_hint(hint, mystl::move(value));
     }
 
+    // 向空树插入已序的区间时，直接自底向上构造一颗平衡的树，见 build_if_sorted
     template <typename InputIterator>
     void insert_multi(InputIterator first, InputIterator last)
     {
         size_type n = mystl::distance(first, last);
         THROW_LENGTH_ERROR_IF(node_count_ > max_size() - n, "rb_tree<T, Comp>'s size too big");
+        if(node_count_ == 0 && build_if_sorted(first, last, n, false, iterator_category(first)))
+            return;
         for(; n > 0; --n, ++first)
         {
             insert_multi(end(), *first);
@@ -819,6 +973,8 @@ public:
     {
         size_type n = mystl::distance(first, last);
         THROW_LENGTH_ERROR_IF(node_count_ > max_size() - n, "rb_tree<T, Comp>'s size too big");
+        if(node_count_ == 0 && build_if_sorted(first, last, n, true, iterator_category(first)))
+            return;
         for(; n > 0; --n, ++first)
         {
             insert_unique(end(), *first);
@@ -835,26 +991,76 @@ public:
 
     void clear();
 
+    // 节点句柄：extract 把节点从树中摘下交给句柄，insert 再把句柄中的节点链接进树，
+    // merge 把 source 中的节点逐个移到本树，都不重新分配节点，也不复制或移动元素
+    node_handle extract(iterator pos)
+    {
+        MYSTL_DEBUG(pos != end());
+        return node_handle(extract_node(pos.node), this->get_alloc());
+    }
+    node_handle extract(const key_type& key)
+    {
+        auto it = find(key);
+        return it == end() ? node_handle() : extract(it);
+    }
+
+    insert_return_type insert_unique(node_handle&& nh);
+    iterator           insert_unique(iterator hint, node_handle&& nh);
+    iterator           insert_multi(node_handle&& nh);
+    iterator           insert_multi(iterator hint, node_handle&& nh);
+
+    template <typename Compare2>
+    void merge_unique(rb_tree<T, Compare2, Alloc, Policy>& source);
+    template <typename Compare2>
+    void merge_multi(rb_tree<T, Compare2, Alloc, Policy>& source);
+
     // rb_tree 相关操作
-    iterator       find(const key_type& key);
-    const_iterator find(const key_type& key) const;
+    // 比较函数声明了 is_transparent 时，另有接受任意型别 K 的模板版本，不必先构造 key_type
+    iterator       find(const key_type& key)       { return iterator(M_find(key)); }
+    const_iterator find(const key_type& key) const { return const_iterator(M_find(key)); }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return iterator(M_find(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key) const        { return const_iterator(M_find(key)); }
 
     size_type count_multi(const key_type& key) const
     {
         auto p = equal_range_multi(key);
         return static_cast<size_type>(mystl::distance(p.first, p.second));
     }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type count_multi(const K& key) const
+    {
+        auto p = equal_range_multi(key);
+        return static_cast<size_type>(mystl::distance(p.first, p.second));
+    }
 
     size_type count_unique(const key_type& key) const
     {
-        return find(key) != end() ? 1 : 0;
+        return M_find(key) != header_ ? 1 : 0;
     }
-    
-    iterator       lower_bound(const key_type& key);
-    const_iterator lower_bound(const key_type& key) const;
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type count_unique(const K& key) const
+    {
+        return M_find(key) != header_ ? 1 : 0;
+    }
+
+    iterator       lower_bound(const key_type& key)       { return iterator(M_lower_bound(key)); }
+    const_iterator lower_bound(const key_type& key) const { return const_iterator(M_lower_bound(key)); }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)              { return iterator(M_lower_bound(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const        { return const_iterator(M_lower_bound(key)); }
 
-    iterator       upper_bound(const key_type& key);
-    const_iterator upper_bound(const key_type& key) const;
+    iterator       upper_bound(const key_type& key)       { return iterator(M_upper_bound(key)); }
+    const_iterator upper_bound(const key_type& key) const { return const_iterator(M_upper_bound(key)); }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)              { return iterator(M_upper_bound(key)); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const        { return const_iterator(M_upper_bound(key)); }
 
     mystl::pair<iterator, iterator> equal_range_multi(const key_type& key)
     {
@@ -865,6 +1071,17 @@ public:
     {
         return mystl::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
     }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<iterator, iterator> equal_range_multi(const K& key)
+    {
+        return mystl::pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+    }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<const_iterator, const_iterator>
+    equal_range_multi(const K& key) const
+    {
+        return mystl::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+    }
 
     mystl::pair<iterator, iterator> equal_range_unique(const key_type& key)
     {
@@ -881,6 +1098,33 @@ public:
         return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
     }
 
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<iterator, iterator> equal_range_unique(const K& key)
+    {
+        iterator it = find(key);
+        auto next = it;
+        return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+    }
+
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    mystl::pair<const_iterator, const_iterator>
+    equal_range_unique(const K& key) const
+    {
+        const_iterator it = find(key);
+        auto next = it;
+        return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+    }
+
+    // 顺序统计，只有使用 rb_tree_rank_policy 时才能调用，都是 O(log n)
+    // nth(k) 返回第 k 小（从 0 开始）的元素，k 不小于 size() 时返回 end()
+    // rank(key) 返回小于 key 的元素个数，也就是 lower_bound(key) 之前的元素个数
+    iterator       nth(size_type k)       { return iterator(M_nth(k)); }
+    const_iterator nth(size_type k) const { return const_iterator(M_nth(k)); }
+
+    size_type rank(const key_type& key) const { return M_rank(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type rank(const K& key) const        { return M_rank(key); }
+
     void swap(rb_tree& rhs) noexcept;
 
 private:
@@ -892,8 +1136,30 @@ private:
 
     // init / reset
     void rb_tree_init();
+    void destroy_header();
     void reset();
 
+    // 只交换数据，不交换分配器
+    void swap_data(rb_tree& rhs) noexcept
+    {
+        mystl::swap(header_, rhs.header_);
+        mystl::swap(node_count_, rhs.node_count_);
+        mystl::swap(key_comp_, rhs.key_comp_);
+    }
+
+    // find / lower_bound / upper_bound 的实现，K 可以是 key_type 或异构查找的键值型别
+    template <class K>
+    base_ptr M_find(const K& key) const;
+    template <class K>
+    base_ptr M_lower_bound(const K& key) const;
+    template <class K>
+    base_ptr M_upper_bound(const K& key) const;
+
+    // nth / rank 的实现
+    base_ptr M_nth(size_type k) const;
+    template <class K>
+    size_type M_rank(const K& key) const;
+
     // get insert pos
     mystl::pair<base_ptr, bool> get_insert_multi_pos(const key_type& key);
     mystl::pair<mystl::pair<base_ptr, bool>, bool> get_insert_unique_pos(const key_type& key);
@@ -902,9 +1168,42 @@ private:
     iterator insert_value_at(base_ptr x, const value_type& value, bool add_to_left);
     iterator insert_node_at(base_ptr x, node_ptr node, bool add_to_left);
 
+    mystl::pair<mystl::pair<base_ptr, bool>, bool>
+    get_insert_unique_pos_use_hint(iterator hint, const key_type& key);
+
     // insert use hint
-    iterator insert_multi_use_hint(iterator hint, key_type key, node_ptr node);
-    iterator insert_unique_use_hint(iterator hint, key_type key, node_ptr node);
+    iterator insert_multi_use_hint(iterator hint, const key_type& key, node_ptr node);
+
+    // emplace_unique 的实现：能从参数中直接取得键值时先查找，键值不存在才构造节点，
+    // 否则先构造节点，键值重复时再销毁它
+    template <typename... Args>
+    mystl::pair<iterator, bool> emplace_unique_dispatch(m_true_type, Args&&... args);
+    template <typename... Args>
+    mystl::pair<iterator, bool> emplace_unique_dispatch(m_false_type, Args&&... args);
+    template <typename... Args>
+    iterator emplace_unique_use_hint_dispatch(m_true_type, iterator hint, Args&&... args);
+    template <typename... Args>
+    iterator emplace_unique_use_hint_dispatch(m_false_type, iterator hint, Args&&... args);
+
+    template <typename A>
+    static const key_type& extract_key(const A& arg)
+    { return value_traits::get_key(arg); }
+    template <typename A, typename B>
+    static const key_type& extract_key(const A& key, const B&)
+    { return key; }
+
+    // 把节点从树中摘下，但不销毁它
+    node_ptr extract_node(base_ptr x);
+
+    // 从已序区间构造平衡的树
+    template <typename InputIterator>
+    bool build_if_sorted(InputIterator, InputIterator, size_type, bool, mystl::input_iterator_tag)
+    { return false; }
+    template <typename ForwardIter>
+    bool build_if_sorted(ForwardIter first, ForwardIter last, size_type n, bool unique,
+                         mystl::forward_iterator_tag);
+    template <typename ForwardIter>
+    base_ptr build_sorted(ForwardIter& first, size_type n, size_type depth, size_type red_depth, bool reversed);
 
     // copy tree / erase tree
     base_ptr copy_from(base_ptr x, base_ptr p);
@@ -914,13 +1213,29 @@ private:
 /*****************************************************************************************/
 
 // 复制构造函数
-template <typename T, typename Compare>
-rb_tree<T, Compare>::rb_tree(const rb_tree& rhs)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+rb_tree<T, Compare, Alloc, Policy>::rb_tree(const rb_tree& rhs)
+    :alloc_base(node_alloc_traits::select_on_container_copy_construction(rhs.get_alloc()))
+{
+    rb_tree_init();
+    if(rhs.node_count_ != 0)
+    {
+        set_root(copy_from(rhs.root(), header_));
+        leftmost() = rb_tree_min(root());
+        rightmost() = rb_tree_max(root());
+    }
+    node_count_ = rhs.node_count_;
+    key_comp_ = rhs.key_comp_;
+}
+
+template <typename T, typename Compare, typename Alloc, typename Policy>
+rb_tree<T, Compare, Alloc, Policy>::rb_tree(const rb_tree& rhs, const allocator_type& alloc)
+    :alloc_base(node_allocator(alloc))
 {
     rb_tree_init();
     if(rhs.node_count_ != 0)
     {
-        root() = copy_from(rhs.root(), header_);
+        set_root(copy_from(rhs.root(), header_));
         leftmost() = rb_tree_min(root());
         rightmost() = rb_tree_max(root());
     }
@@ -929,9 +1244,10 @@ rb_tree<T, Compare>::rb_tree(const rb_tree& rhs)
 }
 
 // 移动构造函数
-template <typename T, typename Compare>
-rb_tree<T, Compare>::rb_tree(rb_tree&& rhs) noexcept
-    : header_(mystl::move(rhs.header_)),
+template <typename T, typename Compare, typename Alloc, typename Policy>
+rb_tree<T, Compare, Alloc, Policy>::rb_tree(rb_tree&& rhs) noexcept
+    : alloc_base(mystl::move(rhs.get_alloc())),
+    header_(mystl::move(rhs.header_)),
     node_count_(rhs.node_count_),
     key_comp_(rhs.key_comp_) 
 {
@@ -939,15 +1255,24 @@ rb_tree<T, Compare>::rb_tree(rb_tree&& rhs) noexcept
 }
 
 // 复制赋值操作符
-template <typename T, typename Compare>
-rb_tree<T, Compare>& rb_tree<T, Compare>::operator=(const rb_tree& rhs)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+rb_tree<T, Compare, Alloc, Policy>& rb_tree<T, Compare, Alloc, Policy>::operator=(const rb_tree& rhs)
 {
     if(this != &rhs)
     {
+        // 需要传播分配器且两者不相等时，原有结点必须由原分配器释放
+        if(node_alloc_traits::propagate_on_container_copy_assignment::value &&
+           this->get_alloc() != rhs.get_alloc())
+        {
+            rb_tree tmp(rhs, allocator_type(rhs.get_alloc()));
+            swap_data(tmp);
+            mystl::swap(this->get_alloc(), tmp.get_alloc());
+            return *this;
+        }
         clear();
         if(rhs.node_count_ != 0)
         {
-            root() = copy_from(rhs.root(), header_);
+            set_root(copy_from(rhs.root(), header_));
             leftmost() = rb_tree_min(root());
             rightmost() = rb_tree_max(root());
         }
@@ -958,22 +1283,35 @@ rb_tree<T, Compare>& rb_tree<T, Compare>::operator=(const rb_tree& rhs)
 }
 
 // 移动赋值操作符
-template <typename T, typename Compare>
-rb_tree<T, Compare>& rb_tree<T, Compare>::operator=(rb_tree&& rhs)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+rb_tree<T, Compare, Alloc, Policy>& rb_tree<T, Compare, Alloc, Policy>::operator=(rb_tree&& rhs)
 {
+    if(this == &rhs)return *this;
     clear();
-    header_ = mystl::move(rhs.header_);
-    node_count_ = rhs.node_count_;
-    key_comp_ = rhs.key_comp_;
-    rhs.reset();
+    if(node_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
+    {
+        // rhs 得到本容器的空 header_，分配器跟随各自的结点
+        swap_data(rhs);
+        if(node_alloc_traits::propagate_on_container_move_assignment::value)
+            mystl::swap(this->get_alloc(), rhs.get_alloc());
+    }
+    else
+    {
+        // 分配器不相等且不传播时，只能逐个移动元素
+        key_comp_ = rhs.key_comp_;
+        for(auto it = rhs.begin(); it != rhs.end(); ++it)
+            emplace_multi_use_hint(end(), mystl::move(*it));
+        rhs.clear();
+    }
     return *this;
 }
 
 // 就地插入元素，键值允许重复
-template <typename T, typename Compare>
+template <typename T, typename Compare, typename Alloc, typename Policy>
 template <typename... Args>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::emplace_multi(Args&&... args)
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::emplace_multi(Args&&... args)
 {
     THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
     node_ptr np = create_node(mystl::forward<Args>(args)...);
@@ -982,115 +1320,132 @@ rb_tree<T, Compare>::emplace_multi(Args&&... args)
 }
 
 // 就地插入元素，键值不允许重复
-template <typename T, typename Compare>
+template <typename T, typename Compare, typename Alloc, typename Policy>
 template <typename... Args>
-mystl::pair<typename rb_tree<T, Compare>::iterator, bool>
-rb_tree<T, Compare>::emplace_unique(Args&&... args)
+mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::iterator, bool>
+rb_tree<T, Compare, Alloc, Policy>::emplace_unique(Args&&... args)
 {
     THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+    return emplace_unique_dispatch(can_extract_key<key_type, value_type, Args...>(),
+                                   mystl::forward<Args>(args)...);
+}
+
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename... Args>
+mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::iterator, bool>
+rb_tree<T, Compare, Alloc, Policy>::emplace_unique_dispatch(m_true_type, Args&&... args)
+{
+    auto res = get_insert_unique_pos(extract_key(args...));
+    if(!res.second)
+    {
+        return mystl::make_pair(iterator(res.first.first), false);
+    }
+    node_ptr np = create_node(mystl::forward<Args>(args)...);
+    return mystl::make_pair(insert_node_at(res.first.first, np, res.first.second), true);
+}
+
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename... Args>
+mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::iterator, bool>
+rb_tree<T, Compare, Alloc, Policy>::emplace_unique_dispatch(m_false_type, Args&&... args)
+{
     node_ptr np = create_node(mystl::forward<Args>(args)...);
     auto res = get_insert_unique_pos(value_traits::get_key(np->value));
     if(res.second)
     {
         return mystl::make_pair(insert_node_at(res.first.first, np, res.first.second), true);
     }
+    destroy_node(np);
     return mystl::make_pair(iterator(res.first.first), false);
 }
 
 // 就地插入元素，键值允许重复，当 hint 位置与插入位置接近时，插入操作的时间复杂度可以降低
-template <typename T, typename Compare>
+template <typename T, typename Compare, typename Alloc, typename Policy>
 template <typename... Args>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::emplace_multi_use_hint(iterator hint, Args&&... args)
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::emplace_multi_use_hint(iterator hint, Args&&... args)
 {
     THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
     node_ptr np = create_node(mystl::forward<Args>(args)...);
-    if(node_count_ == 0)
-    {
-        return insert_node_at(header_, np, true);
-    }
-    key_type key = value_traits::get_key(np->value);
-    if(hint == begin())
-    {   // 位于 begin 处
-        if(key_comp_(key, value_traits::get_key(*hint)))
-        {
-            return insert_node_at(hint.node, np, true);
-        }
-        else
-        {
-            auto pos = get_insert_multi_pos(key);
-            return insert_node_at(pos.first, np, pos.second);
-        }
-    }
-    else if(hint == end())
-    {   // 位于 end 处
-        if(!key_comp_(key, value_traits::get_key(rightmost()->get_node_ptr()->value)))
-        {
-            return insert_node_at(rightmost(), np, false);
-        }
-        else
-        {
-            auto pos = get_insert_multi_pos(key);
-            return insert_node_at(pos.first, np, pos.second);
-        }
-    }
-    return insert_multi_use_hint(hint, key, np);
+    return insert_multi_use_hint(hint, value_traits::get_key(np->value), np);
 }
 
 // 就地插入元素，键值不允许重复，当 hint 位置与插入位置接近时，插入操作的时间复杂度可以降低
-template <typename T, typename Compare>
+template <typename T, typename Compare, typename Alloc, typename Policy>
 template <typename... Args>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::emplace_unique_use_hint(iterator hint, Args&&... args)
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::emplace_unique_use_hint(iterator hint, Args&&... args)
 {
     THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+    return emplace_unique_use_hint_dispatch(can_extract_key<key_type, value_type, Args...>(),
+                                            hint, mystl::forward<Args>(args)...);
+}
+
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename... Args>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::emplace_unique_use_hint_dispatch(m_true_type, iterator hint, Args&&... args)
+{
+    auto pos = get_insert_unique_pos_use_hint(hint, extract_key(args...));
+    if(!pos.second)
+    {
+        return iterator(pos.first.first);
+    }
     node_ptr np = create_node(mystl::forward<Args>(args)...);
-    if(node_count_ == 0)
+    return insert_node_at(pos.first.first, np, pos.first.second);
+}
+
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename... Args>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::emplace_unique_use_hint_dispatch(m_false_type, iterator hint, Args&&... args)
+{
+    node_ptr np = create_node(mystl::forward<Args>(args)...);
+    auto pos = get_insert_unique_pos_use_hint(hint, value_traits::get_key(np->value));
+    if(!pos.second)
     {
-        return insert_node_at(header_, np, true);
+        destroy_node(np);
+        return iterator(pos.first.first);
     }
-    key_type key = value_traits::get_key(np->value);
-    if(hint == begin())
-    {   // 位于 begin 处
-        if(key_comp_(key, value_traits::get_key(*hint)))
-        {
-            return insert_node_at(hint.node, np, true);
-        }
-        else
-        {
-            auto pos = get_insert_unique_pos(key);
-            if(!pos.second)
-            {
-                destroy_node(np);
-                return pos.first.first;
-            }
-            return insert_node_at(pos.first.first, np, pos.first.second);
-        }
+    return insert_node_at(pos.first.first, np, pos.first.second);
+}
+
+// 键值 key 不存在时，用 key 与 args 构造 mapped_type 后插入，否则什么都不做
+// 先查找再构造节点，键值已经存在时不会分配空间，也不会移动 key 与 args
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename K, typename... Args>
+mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::iterator, bool>
+rb_tree<T, Compare, Alloc, Policy>::try_emplace_unique(K&& key, Args&&... args)
+{
+    auto res = get_insert_unique_pos(key);
+    if(!res.second)
+    {
+        return mystl::make_pair(iterator(res.first.first), false);
     }
-    else if(hint == end())
+    THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+    node_ptr np = create_node(mystl::forward<K>(key), mapped_type(mystl::forward<Args>(args)...));
+    return mystl::make_pair(insert_node_at(res.first.first, np, res.first.second), true);
+}
+
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename K, typename... Args>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::try_emplace_unique_use_hint(iterator hint, K&& key, Args&&... args)
+{
+    auto pos = get_insert_unique_pos_use_hint(hint, key);
+    if(!pos.second)
     {
-        if(key_comp_(value_traits::get_key(rightmost()->get_node_ptr()->value), key))
-        {
-            return insert_node_at(rightmost(), np, false);
-        }
-        else
-        {
-            auto pos = get_insert_unique_pos(key);
-            if(!pos.second)
-            {
-                destroy_node(np);
-                return pos.first.first;
-            }
-            return insert_node_at(pos.first.first, np, pos.first.second);
-        }
+        return iterator(pos.first.first);
     }
-    return insert_unique_use_hint(hint, key, np);
+    THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+    node_ptr np = create_node(mystl::forward<K>(key), mapped_type(mystl::forward<Args>(args)...));
+    return insert_node_at(pos.first.first, np, pos.first.second);
 }
 
 // 插入元素，节点键值允许重复
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::insert_multi(const value_type& value)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_multi(const value_type& value)
 {
     THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
     auto res = get_insert_multi_pos(value_traits::get_key(value));
@@ -1098,9 +1453,9 @@ rb_tree<T, Compare>::insert_multi(const value_type& value)
 }
 
 // 插入新值，节点键值不允许重复，返回一个 pair，若插入成功，pair 的第二参数为 true，否则为 false
-template <typename T, typename Compare>
-mystl::pair<typename rb_tree<T, Compare>::iterator, bool>
-rb_tree<T, Compare>::insert_unique(const value_type& value)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::iterator, bool>
+rb_tree<T, Compare, Alloc, Policy>::insert_unique(const value_type& value)
 {
     THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
     auto res = get_insert_unique_pos(value_traits::get_key(value));
@@ -1112,23 +1467,20 @@ rb_tree<T, Compare>::insert_unique(const value_type& value)
 }
 
 // 删除 hint 位置的节点
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::erase(iterator pos)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::erase(iterator pos)
 {
-    node_ptr node = pos.node->get_node_ptr();
-    iterator next(node);
+    iterator next(pos.node);
     ++next;
-    rb_tree_erase_rebalance(pos.node, root(), leftmost(), rightmost());
-    destroy_node(node);
-    --node_count_;
+    destroy_node(extract_node(pos.node));
     return next;
 }
 
 // 删除键值等于 key 的元素，返回删除的个数
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::size_type
-rb_tree<T, Compare>::erase_multi(const key_type& key)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::size_type
+rb_tree<T, Compare, Alloc, Policy>::erase_multi(const key_type& key)
 {
     auto p = equal_range_multi(key);
     size_type n = mystl::distance(p.first, p.second);
@@ -1137,9 +1489,9 @@ rb_tree<T, Compare>::erase_multi(const key_type& key)
 }
 
 // 删除键值等于 key 的元素，返回删除的个数
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::size_type
-rb_tree<T, Compare>::erase_unique(const key_type& key)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::size_type
+rb_tree<T, Compare, Alloc, Policy>::erase_unique(const key_type& key)
 {
     auto it = find(key);
     if(it != end())
@@ -1150,9 +1502,98 @@ rb_tree<T, Compare>::erase_unique(const key_type& key)
     return 0;
 }
 
+// 把句柄中的节点插入树中，节点键值不允许重复
+// 键值已经存在时节点仍然留在返回值的 node 中，position 指向已经存在的元素
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::insert_return_type
+rb_tree<T, Compare, Alloc, Policy>::insert_unique(node_handle&& nh)
+{
+    if(nh.empty())
+        return insert_return_type{end(), false, node_handle()};
+    MYSTL_DEBUG(nh.node_alloc() == this->get_alloc());
+    auto res = get_insert_unique_pos(value_traits::get_key(nh.ptr_->value));
+    if(!res.second)
+        return insert_return_type{iterator(res.first.first), false, mystl::move(nh)};
+    auto it = insert_node_at(res.first.first, nh.release(), res.first.second);
+    return insert_return_type{it, true, node_handle()};
+}
+
+// 使用 hint 把句柄中的节点插入树中，节点键值不允许重复，键值已经存在时节点仍然留在 nh 中
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_unique(iterator hint, node_handle&& nh)
+{
+    if(nh.empty())
+        return end();
+    MYSTL_DEBUG(nh.node_alloc() == this->get_alloc());
+    auto res = get_insert_unique_pos_use_hint(hint, value_traits::get_key(nh.ptr_->value));
+    if(!res.second)
+        return iterator(res.first.first);
+    return insert_node_at(res.first.first, nh.release(), res.first.second);
+}
+
+// 把句柄中的节点插入树中，节点键值允许重复
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_multi(node_handle&& nh)
+{
+    if(nh.empty())
+        return end();
+    MYSTL_DEBUG(nh.node_alloc() == this->get_alloc());
+    auto res = get_insert_multi_pos(value_traits::get_key(nh.ptr_->value));
+    return insert_node_at(res.first, nh.release(), res.second);
+}
+
+// 使用 hint 把句柄中的节点插入树中，节点键值允许重复
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_multi(iterator hint, node_handle&& nh)
+{
+    if(nh.empty())
+        return end();
+    MYSTL_DEBUG(nh.node_alloc() == this->get_alloc());
+    const key_type& key = value_traits::get_key(nh.ptr_->value);
+    return insert_multi_use_hint(hint, key, nh.release());
+}
+
+// 把 source 中键值在本树中不存在的节点移到本树，键值重复的节点留在 source 中
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename Compare2>
+void rb_tree<T, Compare, Alloc, Policy>::merge_unique(rb_tree<T, Compare2, Alloc, Policy>& source)
+{
+    MYSTL_DEBUG(this->get_alloc() == source.get_alloc());
+    if(static_cast<void*>(&source) == static_cast<void*>(this))
+        return;
+    for(auto it = source.begin(); it != source.end(); )
+    {
+        auto x = it.node;
+        ++it;
+        auto res = get_insert_unique_pos(value_traits::get_key(x->get_node_ptr()->value));
+        if(res.second)
+            insert_node_at(res.first.first, source.extract_node(x), res.first.second);
+    }
+}
+
+// 把 source 中的全部节点移到本树
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename Compare2>
+void rb_tree<T, Compare, Alloc, Policy>::merge_multi(rb_tree<T, Compare2, Alloc, Policy>& source)
+{
+    MYSTL_DEBUG(this->get_alloc() == source.get_alloc());
+    if(static_cast<void*>(&source) == static_cast<void*>(this))
+        return;
+    for(auto it = source.begin(); it != source.end(); )
+    {
+        auto x = it.node;
+        ++it;
+        auto res = get_insert_multi_pos(value_traits::get_key(x->get_node_ptr()->value));
+        insert_node_at(res.first, source.extract_node(x), res.second);
+    }
+}
+
 // 删除[first, last)区间内的元素
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::erase(iterator first, iterator last)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::erase(iterator first, iterator last)
 {
     if(first == begin() && last == end())
     {
@@ -1168,68 +1609,34 @@ void rb_tree<T, Compare>::erase(iterator first, iterator last)
 }
 
 // 清空 rb tree
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::clear()
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::clear()
 {
     if(node_count_ != 0)
     {
         erase_since(root());
-        root() = nullptr;
+        set_root(nullptr);
         leftmost() = header_;
         rightmost() = header_;
         node_count_ = 0;
     }
 }
 
-// 查找键值为 k 的节点，返回指向它的迭代器
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::find(const key_type& key)
+// 查找键值为 k 的节点，返回指向它的节点，找不到时返回 header_
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <class K>
+typename rb_tree<T, Compare, Alloc, Policy>::base_ptr
+rb_tree<T, Compare, Alloc, Policy>::M_find(const K& key) const
 {
-    base_ptr x = root();
-    base_ptr y = header_;  // 最后一个不小于 key 的节点
-    while(x != nullptr)
-    {
-        if(!key_comp_(value_traits::get_key(x->get_node_ptr()->value), key))
-        {   // key 小于等于 x 键值，向左走
-            y = x;
-            x = x->left;
-        }
-        else
-        {   // key 大于 x 键值，向右走
-            x = x->right;
-        }
-    }
-    iterator j = iterator(y);
-    return (j == end() || key_comp_(key, value_traits::get_key(*j))) ? end() : j;
-}
-
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::const_iterator
-rb_tree<T, Compare>::find(const key_type& key) const
-{
-    base_ptr x = root();
-    base_ptr y = header_;  // 最后一个不小于 key 的节点
-    while(x != nullptr)
-    {
-        if(!key_comp_(value_traits::get_key(x->get_node_ptr()->value), key))
-        {   // key 小于等于 x 键值，向左走
-            y = x;
-            x = x->left;
-        }
-        else
-        {   // key 大于 x 键值，向右走
-            x = x->right;
-        }
-    }
-    const_iterator j = const_iterator(y);
-    return (j == end() || key_comp_(key, value_traits::get_key(*j))) ? end() : j;
+    base_ptr y = M_lower_bound(key);
+    return (y == header_ || key_comp_(key, value_traits::get_key(y->get_node_ptr()->value))) ? header_ : y;
 }
 
 // 键值不小于 key 的第一个位置
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::lower_bound(const key_type& key)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <class K>
+typename rb_tree<T, Compare, Alloc, Policy>::base_ptr
+rb_tree<T, Compare, Alloc, Policy>::M_lower_bound(const K& key) const
 {
     base_ptr x = root();
     base_ptr y = header_;  // 最后一个不小于 key 的节点
@@ -1245,81 +1652,90 @@ rb_tree<T, Compare>::lower_bound(const key_type& key)
             x = x->right;
         }
     }
-    return iterator(y);
+    return y;
 }
 
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::const_iterator
-rb_tree<T, Compare>::lower_bound(const key_type& key) const
+// 键值大于 key 的第一个位置
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <class K>
+typename rb_tree<T, Compare, Alloc, Policy>::base_ptr
+rb_tree<T, Compare, Alloc, Policy>::M_upper_bound(const K& key) const
 {
     base_ptr x = root();
-    base_ptr y = header_;  // 最后一个不小于 key 的节点
+    base_ptr y = header_;  // 最后一个大于 key 的节点
     while(x != nullptr)
     {
-        if(!key_comp_(value_traits::get_key(x->get_node_ptr()->value), key))
-        {   // key 小于等于 x 键值，向左走
+        if(key_comp_(key, value_traits::get_key(x->get_node_ptr()->value)))
+        {   // key 小于 x 键值，向左走
             y = x;
             x = x->left;
         }
         else
-        {   // key 大于 x 键值，向右走
+        {   // key 大于等于 x 键值，向右走
             x = x->right;
         }
     }
-    return const_iterator(y);
+    return y;
 }
 
-// 键值大于 key 的第一个位置
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::upper_bound(const key_type& key)
+// 从根节点向下走，左子树的大小就是当前节点在其子树中的名次
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::base_ptr
+rb_tree<T, Compare, Alloc, Policy>::M_nth(size_type k) const
 {
+    static_assert(rb_tree_is_ranked<Policy>::value, "nth requires mystl::rb_tree_rank_policy");
+    if(k >= node_count_)
+        return header_;
     base_ptr x = root();
-    base_ptr y = header_;  // 最后一个不小于 key 的节点
-    while(x != nullptr)
+    while(true)
     {
-        if(key_comp_(key, value_traits::get_key(x->get_node_ptr()->value)))
-        {   // key 小于 x 键值，向左走
-            y = x;
+        const size_type left_size = Policy::size(x->left);
+        if(k < left_size)
+        {
             x = x->left;
         }
+        else if(k == left_size)
+        {
+            return x;
+        }
         else
-        {   // key 大于等于 x 键值，向右走
+        {
+            k -= left_size + 1;
             x = x->right;
         }
     }
-    return iterator(y);
 }
 
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::const_iterator
-rb_tree<T, Compare>::upper_bound(const key_type& key) const
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <class K>
+typename rb_tree<T, Compare, Alloc, Policy>::size_type
+rb_tree<T, Compare, Alloc, Policy>::M_rank(const K& key) const
 {
+    static_assert(rb_tree_is_ranked<Policy>::value, "rank requires mystl::rb_tree_rank_policy");
     base_ptr x = root();
-    base_ptr y = header_;  // 最后一个不小于 key 的节点
+    size_type n = 0;  // 已经确定小于 key 的节点数
     while(x != nullptr)
     {
-        if(key_comp_(key, value_traits::get_key(x->get_node_ptr()->value)))
-        {   // key 小于 x 键值，向左走
-            y = x;
-            x = x->left;
+        if(key_comp_(value_traits::get_key(x->get_node_ptr()->value), key))
+        {   // x 键值小于 key，x 与它的左子树都小于 key，向右走
+            n += Policy::size(x->left) + 1;
+            x = x->right;
         }
         else
-        {   // key 大于等于 x 键值，向右走
-            x = x->right;
+        {
+            x = x->left;
         }
     }
-    return const_iterator(y);
+    return n;
 }
 
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::swap(rb_tree& rhs) noexcept
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::swap(rb_tree& rhs) noexcept
 {
     if(this != &rhs)
     {
-        mystl::swap(header_, rhs.header_);
-        mystl::swap(node_count_, rhs.node_count_);
-        mystl::swap(key_comp_, rhs.key_comp_);
+        swap_data(rhs);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
     }
 }
 
@@ -1327,72 +1743,81 @@ void rb_tree<T, Compare>::swap(rb_tree& rhs) noexcept
 // helper function
 
 // 创建一个结点
-template <typename T, typename Compare>
+template <typename T, typename Compare, typename Alloc, typename Policy>
 template <typename... Args>
-typename rb_tree<T, Compare>::node_ptr 
-rb_tree<T, Compare>::create_node(Args&&... args)
+typename rb_tree<T, Compare, Alloc, Policy>::node_ptr 
+rb_tree<T, Compare, Alloc, Policy>::create_node(Args&&... args)
 {
-    auto tmp = node_allocator::allocate(1);
+    auto tmp = node_alloc_traits::allocate(this->get_alloc(), 1);
     try
     {
-        data_allocator::construct(mystl::address_of(tmp->value), mystl::forward<Args>(args)...);
+        node_alloc_traits::construct(this->get_alloc(), mystl::address_of(tmp->value), mystl::forward<Args>(args)...);
         tmp->left = nullptr;
         tmp->right = nullptr;
-        tmp->parent = nullptr;
+        tmp->set_parent_color(nullptr, rb_tree_red);
     }
     catch(...)
     {
-        node_allocator::deallocate(tmp);
+        node_alloc_traits::deallocate(this->get_alloc(), tmp, 1);
         throw;
     }
     return tmp;
 }
 
 // 复制一个结点
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::node_ptr
-rb_tree<T, Compare>::clone_node(base_ptr x)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::node_ptr
+rb_tree<T, Compare, Alloc, Policy>::clone_node(base_ptr x)
 {
     auto tmp = create_node(x->get_node_ptr()->value);
     tmp->left = nullptr;
     tmp->right = nullptr;
-    tmp->parent = nullptr;
-    tmp->color = x->color;
+    tmp->set_parent_color(nullptr, x->color());
+    static_cast<typename Policy::node_data&>(*tmp) = *x;  // 子树的结构不变，附加数据原样复制
     return tmp;
 }
 
 // 销毁一个结点
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::destroy_node(node_ptr p)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::destroy_node(node_ptr p)
 {
-    data_allocator::destroy(&p->value);
-    node_allocator::deallocate(p);
+    node_alloc_traits::destroy(this->get_alloc(), &p->value);
+    node_alloc_traits::deallocate(this->get_alloc(), p, 1);
 }
 
 // 初始化容器
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::rb_tree_init()
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::rb_tree_init()
 {
-    header_ = base_allocator::allocate(1);
-    header_->color = rb_tree_red;  // header_ 节点颜色为红，与 root 区分
-    root() = nullptr;
+    base_allocator base_alloc(this->get_alloc());
+    header_ = base_alloc_traits::allocate(base_alloc, 1);
+    header_->set_parent_color(nullptr, rb_tree_red);  // header_ 节点颜色为红，与 root 区分
     leftmost() = header_;
     rightmost() = header_;
     node_count_ = 0;
 }
 
+// 释放 header_
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::destroy_header()
+{
+    base_allocator base_alloc(this->get_alloc());
+    base_alloc_traits::deallocate(base_alloc, header_, 1);
+    header_ = nullptr;
+}
+
 // reset 函数
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::reset()
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::reset()
 {
     header_ = nullptr;
     node_count_ = 0;
 }
 
 // get_insert_multi_pos 函数
-template <typename T, typename Compare>
-mystl::pair<typename rb_tree<T, Compare>::base_ptr, bool>
-rb_tree<T, Compare>::get_insert_multi_pos(const key_type& key)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::base_ptr, bool>
+rb_tree<T, Compare, Alloc, Policy>::get_insert_multi_pos(const key_type& key)
 {
     auto x = root();
     auto y = header_;
@@ -1407,9 +1832,9 @@ rb_tree<T, Compare>::get_insert_multi_pos(const key_type& key)
 }
 
 // get_insert_unique_pos 函数
-template <typename T, typename Compare>
-mystl::pair<mystl::pair<typename rb_tree<T, Compare>::base_ptr, bool>, bool>
-rb_tree<T, Compare>::get_insert_unique_pos(const key_type& key)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+mystl::pair<mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::base_ptr, bool>, bool>
+rb_tree<T, Compare, Alloc, Policy>::get_insert_unique_pos(const key_type& key)
 {   // 返回一个 pair，第一个值为一个 pair，包含插入点的父节点和一个 bool 表示是否在左边插入，
     // 第二个值为一个 bool，表示是否插入成功
     auto x = root();
@@ -1437,22 +1862,22 @@ rb_tree<T, Compare>::get_insert_unique_pos(const key_type& key)
     {   // 表明新节点没有重复
         return mystl::make_pair(mystl::make_pair(y, add_to_left), true);
     }
-    // 进行至此，表示新节点与现有节点键值重复
-    return mystl::make_pair(mystl::make_pair(y, add_to_left), false);
+    // 进行至此，表示新节点与现有节点键值重复，返回重复的节点
+    return mystl::make_pair(mystl::make_pair(j.node, add_to_left), false);
 }
 
 // insert_value_at 函数
 // x 为插入点的父节点， value 为要插入的值，add_to_left 表示是否在左边插入
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::insert_value_at(base_ptr x, const value_type& value, bool add_to_left)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_value_at(base_ptr x, const value_type& value, bool add_to_left)
 {
     node_ptr node = create_node(value);
-    node->parent = x;
+    node->set_parent(x);
     auto base_node = node->get_base_ptr();
     if(x == header_)
     {
-        root() = base_node;
+        set_root(base_node);
         leftmost() = base_node;
         rightmost() = base_node;
     }
@@ -1466,22 +1891,24 @@ rb_tree<T, Compare>::insert_value_at(base_ptr x, const value_type& value, bool a
         x->right = base_node;
         if(rightmost() == x)rightmost() = base_node;
     }
-    rb_tree_insert_rebalance(base_node, root());
+    auto r = root();
+    rb_tree_insert_rebalance(base_node, r);
+    set_root(r);
     ++node_count_;
     return iterator(node);
 }
 
 // 在 x 节点处插入新的节点
 // x 为插入点的父节点， node 为要插入的节点，add_to_left 表示是否在左边插入
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::insert_node_at(base_ptr x, node_ptr node, bool add_to_left)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_node_at(base_ptr x, node_ptr node, bool add_to_left)
 {
-    node->parent = x;
+    node->set_parent(x);
     auto base_node = node->get_base_ptr();
     if(x == header_)
     {
-        root() = base_node;
+        set_root(base_node);
         leftmost() = base_node;
         rightmost() = base_node;
     }
@@ -1495,75 +1922,209 @@ rb_tree<T, Compare>::insert_node_at(base_ptr x, node_ptr node, bool add_to_left)
         x->right = base_node;
         if(rightmost() == x)rightmost() = base_node;
     }
-    rb_tree_insert_rebalance(base_node, root());
+    auto r = root();
+    rb_tree_insert_rebalance(base_node, r);
+    set_root(r);
     ++node_count_;
     return iterator(node);
 }
 
 // 插入元素，键值允许重复，使用 hint
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::insert_multi_use_hint(iterator hint, key_type key, node_ptr node)
-{
-    // 在 hint 附近寻找可插入的位置
-    auto np = hint.node;
-    auto before = hint;
-    --before;
-    auto bnp = before.node;
-    if(!key_comp_(key, value_traits::get_key(*before))
-        && !key_comp_(value_traits::get_key(*hint), key))
-    {   // before <= node <= hint
-        if(bnp->right == nullptr)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::iterator
+rb_tree<T, Compare, Alloc, Policy>::insert_multi_use_hint(iterator hint, const key_type& key, node_ptr node)
+{
+    // 在 hint 附近寻找可插入的位置，begin 与 end 的前后没有元素，不能解引用
+    if(node_count_ == 0)
+    {
+        return insert_node_at(header_, node, true);
+    }
+    if(hint == begin())
+    {   // node <= begin
+        if(!key_comp_(value_traits::get_key(*hint), key))
         {
-            return insert_node_at(bnp, node, false);
+            return insert_node_at(hint.node, node, true);
         }
-        else if(np->left == nullptr)
+    }
+    else if(hint == end())
+    {   // rightmost <= node
+        if(!key_comp_(key, value_traits::get_key(rightmost()->get_node_ptr()->value)))
         {
-            return insert_node_at(np, node, true);
+            return insert_node_at(rightmost(), node, false);
+        }
+    }
+    else
+    {
+        auto np = hint.node;
+        auto before = hint;
+        --before;
+        auto bnp = before.node;
+        if(!key_comp_(key, value_traits::get_key(*before))
+            && !key_comp_(value_traits::get_key(*hint), key))
+        {   // before <= node <= hint
+            if(bnp->right == nullptr)
+            {
+                return insert_node_at(bnp, node, false);
+            }
+            else if(np->left == nullptr)
+            {
+                return insert_node_at(np, node, true);
+            }
         }
     }
     auto pos = get_insert_multi_pos(key);
     return insert_node_at(pos.first, node, pos.second);
 }
 
-// 插入元素，键值不允许重复，使用 hint
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::iterator
-rb_tree<T, Compare>::insert_unique_use_hint(iterator hint, key_type key, node_ptr node)
+// get_insert_unique_pos_use_hint 函数
+// 先在 hint 附近寻找插入点，不合适时再从根节点开始查找，返回值的意义与 get_insert_unique_pos 相同
+template <typename T, typename Compare, typename Alloc, typename Policy>
+mystl::pair<mystl::pair<typename rb_tree<T, Compare, Alloc, Policy>::base_ptr, bool>, bool>
+rb_tree<T, Compare, Alloc, Policy>::get_insert_unique_pos_use_hint(iterator hint, const key_type& key)
 {
-    auto np = hint.node;
-    auto before = hint;
-    --before;
-    auto bnp = before.node;
-    if(key_comp_(value_traits::get_key(bnp->get_node_ptr()->value), key)
-        && key_comp_(key, value_traits::get_key(bnp->get_node_ptr()->value)))
-    {   // before < node < hint
-        if(bnp->right == nullptr)
+    if(node_count_ == 0)
+    {
+        return mystl::make_pair(mystl::make_pair(header_, true), true);
+    }
+    if(hint == begin())
+    {   // 位于 begin 处
+        if(key_comp_(key, value_traits::get_key(*hint)))
         {
-            return insert_node_at(bnp, node, false);
+            return mystl::make_pair(mystl::make_pair(hint.node, true), true);
         }
-        else if(np->left == nullptr)
+    }
+    else if(hint == end())
+    {   // 位于 end 处
+        if(key_comp_(value_traits::get_key(rightmost()->get_node_ptr()->value), key))
         {
-            return insert_node_at(np, node, true);
+            return mystl::make_pair(mystl::make_pair(rightmost(), false), true);
         }
     }
-    auto pos = get_insert_unique_pos(key);
-    if(pos.second == false)
+    else
     {
-        destroy_node(node);
-        return pos.first.first;
+        auto before = hint;
+        --before;
+        if(key_comp_(value_traits::get_key(*before), key)
+            && key_comp_(key, value_traits::get_key(*hint)))
+        {   // before < node < hint，两者中总有一个在相邻的一侧没有子节点
+            if(before.node->right == nullptr)
+            {
+                return mystl::make_pair(mystl::make_pair(before.node, false), true);
+            }
+            return mystl::make_pair(mystl::make_pair(hint.node, true), true);
+        }
     }
-    return insert_node_at(pos.first.first, node, pos.first.second);
+    return get_insert_unique_pos(key);
+}
+
+// extract_node 函数
+// 把节点 x 从树中摘下并重新平衡，节点本身与其中的元素保持不变
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::node_ptr
+rb_tree<T, Compare, Alloc, Policy>::extract_node(base_ptr x)
+{
+    auto r = root();
+    rb_tree_erase_rebalance(x, r, leftmost(), rightmost());
+    set_root(r);
+    --node_count_;
+    node_ptr node = x->get_node_ptr();
+    node->left = nullptr;
+    node->right = nullptr;
+    node->set_parent(nullptr);
+    return node;
+}
+
+// build_if_sorted 函数
+// 空树插入 [first, last) 时，先检查区间的键值次序：严格递增或严格递减（允许重复时可以是非递减）的区间
+// 直接按中序位置自底向上构造一颗完全平衡的树，O(n) 完成，不需要逐个查找插入位置与重新平衡
+// 其它次序返回 false，由调用者逐个插入。检查在遇到第一对不满足次序的元素时就停止
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename ForwardIter>
+bool rb_tree<T, Compare, Alloc, Policy>::
+build_if_sorted(ForwardIter first, ForwardIter last, size_type n, bool unique, mystl::forward_iterator_tag)
+{
+    if(n < 2)
+        return false;
+    bool ascending = true, descending = true;
+    ForwardIter prev = first, cur = first;
+    for(++cur; cur != last; prev = cur, ++cur)
+    {
+        const key_type& a = value_traits::get_key(*prev);
+        const key_type& b = value_traits::get_key(*cur);
+        // 递减的区间要反向放入树中，键值相等的元素会颠倒次序，因此总是要求严格递减
+        if(descending && !key_comp_(b, a))
+            descending = false;
+        if(ascending && (unique ? !key_comp_(a, b) : key_comp_(b, a)))
+            ascending = false;
+        if(!ascending && !descending)
+            return false;
+    }
+    // 最底层为红色，其余节点为黑色：各子树大小至多相差 1，所有空节点的深度相差不超过 1，
+    // 这样着色后每条路径的黑色节点数相同
+    size_type red_depth = 0;
+    for(size_type m = n; m > 1; m >>= 1)
+        ++red_depth;
+    base_ptr top = build_sorted(first, n, 0, red_depth, !ascending);
+    top->set_parent(header_);
+    rb_tree_set_black(top);
+    set_root(top);
+    leftmost() = rb_tree_min(top);
+    rightmost() = rb_tree_max(top);
+    node_count_ = n;
+    return true;
+}
+
+// build_sorted 函数
+// 从 first 开始依次取 n 个元素，构造一颗中序与区间次序一致（reversed 为 true 时相反）的完全平衡子树
+template <typename T, typename Compare, typename Alloc, typename Policy>
+template <typename ForwardIter>
+typename rb_tree<T, Compare, Alloc, Policy>::base_ptr
+rb_tree<T, Compare, Alloc, Policy>::
+build_sorted(ForwardIter& first, size_type n, size_type depth, size_type red_depth, bool reversed)
+{
+    if(n == 0)
+        return nullptr;
+    const size_type first_half = (n - 1) / 2;
+    base_ptr before = build_sorted(first, first_half, depth + 1, red_depth, reversed);
+    base_ptr x = nullptr;
+    try
+    {
+        x = create_node(*first)->get_base_ptr();
+    }
+    catch(...)
+    {
+        erase_since(before);
+        throw;
+    }
+    ++first;
+    base_ptr after = nullptr;
+    try
+    {
+        after = build_sorted(first, n - 1 - first_half, depth + 1, red_depth, reversed);
+    }
+    catch(...)
+    {
+        erase_since(before);
+        destroy_node(x->get_node_ptr());
+        throw;
+    }
+    x->left = reversed ? after : before;
+    x->right = reversed ? before : after;
+    if(x->left)  x->left->set_parent(x);
+    if(x->right) x->right->set_parent(x);
+    x->set_color(depth == red_depth ? rb_tree_red : rb_tree_black);
+    Policy::update(x);
+    return x;
 }
 
 // copy_from 函数
 // 递归复制一颗树，节点从 x 开始，p 为 x 的父节点
-template <typename T, typename Compare>
-typename rb_tree<T, Compare>::base_ptr
-rb_tree<T, Compare>::copy_from(base_ptr x, base_ptr p)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+typename rb_tree<T, Compare, Alloc, Policy>::base_ptr
+rb_tree<T, Compare, Alloc, Policy>::copy_from(base_ptr x, base_ptr p)
 {
     auto top = clone_node(x);
-    top->parent = p;
+    top->set_parent(p);
     try
     {
         if(x->right)
@@ -1575,7 +2136,7 @@ rb_tree<T, Compare>::copy_from(base_ptr x, base_ptr p)
         while(x != nullptr)
         {
             auto y = clone_node(x);
-            y->parent = p;
+            y->set_parent(p);
             p->left = y;
             if(x->right)
             {
@@ -1595,8 +2156,8 @@ rb_tree<T, Compare>::copy_from(base_ptr x, base_ptr p)
 
 // erase_since 函数
 // 从 x 节点开始删除该节点及其子树
-template <typename T, typename Compare>
-void rb_tree<T, Compare>::erase_since(base_ptr x)
+template <typename T, typename Compare, typename Alloc, typename Policy>
+void rb_tree<T, Compare, Alloc, Policy>::erase_since(base_ptr x)
 {
     while(x != nullptr)
     {
@@ -1608,49 +2169,55 @@ void rb_tree<T, Compare>::erase_since(base_ptr x)
 }
 
 // 重载比较操作符
-template <class T, class Compare>
-bool operator==(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
+template <class T, class Compare, class Alloc, class Policy>
+bool operator==(const rb_tree<T, Compare, Alloc, Policy>& lhs, const rb_tree<T, Compare, Alloc, Policy>& rhs)
 {
   return lhs.size() == rhs.size() && mystl::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class T, class Compare>
-bool operator<(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
+template <class T, class Compare, class Alloc, class Policy>
+bool operator<(const rb_tree<T, Compare, Alloc, Policy>& lhs, const rb_tree<T, Compare, Alloc, Policy>& rhs)
 {
   return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template <class T, class Compare>
-bool operator!=(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
+template <class T, class Compare, class Alloc, class Policy>
+bool operator!=(const rb_tree<T, Compare, Alloc, Policy>& lhs, const rb_tree<T, Compare, Alloc, Policy>& rhs)
 {
   return !(lhs == rhs);
 }
 
-template <class T, class Compare>
-bool operator>(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
+template <class T, class Compare, class Alloc, class Policy>
+bool operator>(const rb_tree<T, Compare, Alloc, Policy>& lhs, const rb_tree<T, Compare, Alloc, Policy>& rhs)
 {
   return rhs < lhs;
 }
 
-template <class T, class Compare>
-bool operator<=(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
+template <class T, class Compare, class Alloc, class Policy>
+bool operator<=(const rb_tree<T, Compare, Alloc, Policy>& lhs, const rb_tree<T, Compare, Alloc, Policy>& rhs)
 {
   return !(rhs < lhs);
 }
 
-template <class T, class Compare>
-bool operator>=(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
+template <class T, class Compare, class Alloc, class Policy>
+bool operator>=(const rb_tree<T, Compare, Alloc, Policy>& lhs, const rb_tree<T, Compare, Alloc, Policy>& rhs)
 {
   return !(lhs < rhs);
 }
 
 // 重载 mystl 的 swap
-template <class T, class Compare>
-void swap(rb_tree<T, Compare>& lhs, rb_tree<T, Compare>& rhs) noexcept
+template <class T, class Compare, class Alloc, class Policy>
+void swap(rb_tree<T, Compare, Alloc, Policy>& lhs, rb_tree<T, Compare, Alloc, Policy>& rhs) noexcept
 {
   lhs.swap(rhs);
 }
 
+// rb_tree 的 header_ 节点分配在堆上，没有节点指向 rb_tree 对象本身
+template <class T, class Compare, class Alloc, class Policy>
+struct is_trivially_relocatable<rb_tree<T, Compare, Alloc, Policy>>
+  : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                    is_trivially_relocatable<Alloc>::value> {};
+
 }
 
 #endif
\ No newline at end of file
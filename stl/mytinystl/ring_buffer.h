@@ -0,0 +1,568 @@
+#ifndef MYTINYSTL_RING_BUFFER_H_
+#define MYTINYSTL_RING_BUFFER_H_
+
+// 这个头文件包含了三个模板类 ring_buffer, spsc_queue 和 mpmc_queue
+// ring_buffer : 固定容量的环形缓冲区，只在构造时分配一次内存，和其他容器一样不能跨线程共享
+// spsc_queue  : 基于环形缓冲区的有界无锁队列，只允许一个生产者线程和一个消费者线程
+// mpmc_queue  : 基于环形缓冲区的有界无锁队列，允许多个生产者线程和多个消费者线程
+
+// notes:
+//
+// 容量向上取整为 2 的幂次，下标是不断增长的计数器，与掩码相与后得到槽位
+// push 在队列满时返回 false，pop 在队列空时返回 false，都不会阻塞，也不会分配内存
+// push_n 把区间中的元素移动到队列中，pop_n 把元素移动到 result 开始的区间，返回实际搬运的个数，
+// spsc_queue 和 mpmc_queue 的一批元素只需要发布一次下标
+// 生产者与消费者各自修改的下标分别独占一条缓存行，避免伪共享
+//
+// 异常保证：
+// ring_buffer 与 spsc_queue 的 push / emplace / pop 做强异常安全保证，
+// push_n / pop_n 抛出异常时，之前已经搬运的元素保持有效
+// mpmc_queue 在占用槽位之后不能失败，因此要求 T 的移动构造与移动赋值不抛出异常
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "algobase.h"
+#include "memory.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+namespace ring_detail
+{
+
+// 缓存行的大小
+constexpr size_t cache_line_size = 64;
+
+// 不小于 n 的 2 的幂次
+inline size_t ring_capacity(size_t n)
+{
+    THROW_LENGTH_ERROR_IF(n > (static_cast<size_t>(-1) >> 1) + 1, "ring buffer's capacity too big");
+    size_t cap = 1;
+    while (cap < n)
+        cap <<= 1;
+    return cap;
+}
+
+// 独占一条缓存行的下标，cache 保存同一线程对另一端下标的缓存
+struct padded_index
+{
+    std::atomic<size_t> index;
+    size_t              cache;
+    char                pad[cache_line_size - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    padded_index() noexcept : index(0), cache(0) {}
+};
+
+// mpmc_queue 的槽位，seq 记录槽位当前可以被哪个下标的生产者或消费者使用
+template <class T>
+struct mpmc_slot
+{
+    std::atomic<size_t> seq;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* value() noexcept { return reinterpret_cast<T*>(&storage); }
+};
+
+// 环形缓冲区的存储，分配 2 的幂次个未初始化的槽位，元素的构造与析构由派生类负责
+template <class Slot, class Alloc>
+class ring_storage
+    : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<Slot>>
+{
+public:
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<Slot> slot_allocator;
+    typedef mystl::allocator_traits<slot_allocator>                               slot_alloc_traits;
+    typedef mystl::alloc_holder<slot_allocator>                                   alloc_base;
+
+protected:
+    Slot*  slots_;  // 槽位数组
+    size_t mask_;   // 容量减一
+
+    ring_storage(size_t n, const Alloc& alloc)
+        : alloc_base(slot_allocator(alloc)), slots_(nullptr), mask_(ring_capacity(n) - 1)
+    {
+        slots_ = slot_alloc_traits::allocate(this->get_alloc(), mask_ + 1);
+    }
+
+    ~ring_storage()
+    {
+        slot_alloc_traits::deallocate(this->get_alloc(), slots_, mask_ + 1);
+    }
+
+    ring_storage(const ring_storage&) = delete;
+    ring_storage& operator=(const ring_storage&) = delete;
+
+    Slot& slot(size_t pos) noexcept { return slots_[pos & mask_]; }
+
+    template <class U, class... Args>
+    void construct_at(U* p, Args&&... args)
+    { slot_alloc_traits::construct(this->get_alloc(), p, mystl::forward<Args>(args)...); }
+
+    template <class U>
+    void destroy_at(U* p)
+    { slot_alloc_traits::destroy(this->get_alloc(), p); }
+
+public:
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+    Alloc get_allocator() const { return Alloc(this->get_alloc()); }
+};
+
+} // namespace ring_detail
+
+// 模板类 ring_buffer
+// 参数一代表数据类型，参数二代表空间配置器类型，缺省使用 mystl::allocator
+template <class T, class Alloc = mystl::allocator<T>>
+class ring_buffer : public ring_detail::ring_storage<T, Alloc>
+{
+    typedef ring_detail::ring_storage<T, Alloc> base;
+
+public:
+    typedef T                 value_type;
+    typedef Alloc             allocator_type;
+    typedef size_t            size_type;
+    typedef value_type&       reference;
+    typedef const value_type& const_reference;
+
+private:
+    size_type head_;  // 队首元素的下标
+    size_type tail_;  // 队尾元素的下一个下标
+
+public:
+    // 构造、复制、析构函数
+    explicit ring_buffer(size_type n, const allocator_type& alloc = allocator_type())
+        : base(n, alloc), head_(0), tail_(0) {}
+
+    ring_buffer(const ring_buffer& rhs)
+        : base(rhs.capacity(), rhs.get_allocator()), head_(0), tail_(0)
+    {
+        try
+        {
+            for (auto i = rhs.head_; i != rhs.tail_; ++i)
+                push(rhs.slots_[i & rhs.mask_]);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    ring_buffer& operator=(const ring_buffer&) = delete;
+
+    ~ring_buffer() { clear(); }
+
+public:
+    // 访问元素相关操作
+    reference operator[](size_type n)
+    {
+        MYSTL_DEBUG(n < size());
+        return this->slot(head_ + n);
+    }
+    const_reference operator[](size_type n) const
+    {
+        MYSTL_DEBUG(n < size());
+        return this->slots_[(head_ + n) & this->mask_];
+    }
+
+    reference       front()       { MYSTL_DEBUG(!empty()); return this->slot(head_); }
+    const_reference front() const { MYSTL_DEBUG(!empty()); return this->slots_[head_ & this->mask_]; }
+    reference       back()        { MYSTL_DEBUG(!empty()); return this->slot(tail_ - 1); }
+    const_reference back()  const { MYSTL_DEBUG(!empty()); return this->slots_[(tail_ - 1) & this->mask_]; }
+
+    // 容量相关操作
+    bool      empty() const noexcept { return head_ == tail_; }
+    bool      full()  const noexcept { return tail_ - head_ == this->capacity(); }
+    size_type size()  const noexcept { return tail_ - head_; }
+
+    // 修改容器相关操作
+    template <class... Args>
+    bool emplace(Args&&... args)
+    {
+        if (full())
+            return false;
+        this->construct_at(mystl::address_of(this->slot(tail_)), mystl::forward<Args>(args)...);
+        ++tail_;
+        return true;
+    }
+
+    bool push(const value_type& value) { return emplace(value); }
+    bool push(value_type&& value)      { return emplace(mystl::move(value)); }
+
+    void pop()
+    {
+        MYSTL_DEBUG(!empty());
+        this->destroy_at(mystl::address_of(this->slot(head_)));
+        ++head_;
+    }
+
+    bool pop(value_type& value)
+    {
+        if (empty())
+            return false;
+        value = mystl::move(this->slot(head_));
+        pop();
+        return true;
+    }
+
+    template <class InputIter>
+    size_type push_n(InputIter first, size_type n);
+
+    template <class OutputIter>
+    size_type pop_n(OutputIter result, size_type n);
+
+    void clear() noexcept
+    {
+        while (!empty())
+            pop();
+    }
+};
+
+/*****************************************************************************************/
+
+// 把 [first, first + n) 中的元素移动到队尾，直到缓冲区满为止
+template <class T, class Alloc>
+template <class InputIter>
+typename ring_buffer<T, Alloc>::size_type
+ring_buffer<T, Alloc>::push_n(InputIter first, size_type n)
+{
+    const auto count = mystl::min(n, this->capacity() - size());
+    for (size_type i = 0; i < count; ++i, ++first)
+    {
+        this->construct_at(mystl::address_of(this->slot(tail_)), mystl::move(*first));
+        ++tail_;
+    }
+    return count;
+}
+
+// 把至多 n 个队首元素移动到以 result 开始的区间
+template <class T, class Alloc>
+template <class OutputIter>
+typename ring_buffer<T, Alloc>::size_type
+ring_buffer<T, Alloc>::pop_n(OutputIter result, size_type n)
+{
+    const auto count = mystl::min(n, size());
+    for (size_type i = 0; i < count; ++i, ++result)
+    {
+        *result = mystl::move(this->slot(head_));
+        pop();
+    }
+    return count;
+}
+
+// 模板类 spsc_queue
+// 参数一代表数据类型，参数二代表空间配置器类型，缺省使用 mystl::allocator
+// 生产者只修改 tail_，消费者只修改 head_，各自缓存对方的下标，只有缓存显示队列满或空时才重新读取
+template <class T, class Alloc = mystl::allocator<T>>
+class spsc_queue : public ring_detail::ring_storage<T, Alloc>
+{
+    typedef ring_detail::ring_storage<T, Alloc> base;
+
+public:
+    typedef T      value_type;
+    typedef Alloc  allocator_type;
+    typedef size_t size_type;
+
+private:
+    char                      pad_[ring_detail::cache_line_size];  // 与只读的 slots_ / mask_ 隔开
+    ring_detail::padded_index tail_;  // 生产者：下一个写入的下标，缓存消费者的 head
+    ring_detail::padded_index head_;  // 消费者：下一个读取的下标，缓存生产者的 tail
+
+public:
+    explicit spsc_queue(size_type n, const allocator_type& alloc = allocator_type())
+        : base(n, alloc) {}
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    ~spsc_queue()
+    {
+        auto tail = tail_.index.load(std::memory_order_relaxed);
+        for (auto i = head_.index.load(std::memory_order_relaxed); i != tail; ++i)
+            this->destroy_at(mystl::address_of(this->slot(i)));
+    }
+
+    // 以下两个函数可以被任何线程调用，得到的是某一时刻的近似值
+    size_type size() const noexcept
+    {
+        auto head = head_.index.load(std::memory_order_acquire);
+        auto tail = tail_.index.load(std::memory_order_acquire);
+        return mystl::min(tail - head, this->capacity());
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    // 以下函数只能由生产者调用
+    template <class... Args>
+    bool emplace(Args&&... args)
+    {
+        const auto tail = tail_.index.load(std::memory_order_relaxed);
+        if (tail - tail_.cache == this->capacity())
+        {
+            tail_.cache = head_.index.load(std::memory_order_acquire);
+            if (tail - tail_.cache == this->capacity())
+                return false;
+        }
+        this->construct_at(mystl::address_of(this->slot(tail)), mystl::forward<Args>(args)...);
+        tail_.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const value_type& value) { return emplace(value); }
+    bool push(value_type&& value)      { return emplace(mystl::move(value)); }
+
+    template <class InputIter>
+    size_type push_n(InputIter first, size_type n);
+
+    // 以下函数只能由消费者调用
+    bool pop(value_type& value)
+    {
+        const auto head = head_.index.load(std::memory_order_relaxed);
+        if (head == head_.cache)
+        {
+            head_.cache = tail_.index.load(std::memory_order_acquire);
+            if (head == head_.cache)
+                return false;
+        }
+        auto p = mystl::address_of(this->slot(head));
+        value = mystl::move(*p);
+        this->destroy_at(p);
+        head_.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <class OutputIter>
+    size_type pop_n(OutputIter result, size_type n);
+};
+
+/*****************************************************************************************/
+
+// 把 [first, first + n) 中至多 n 个元素移动到队列中，整批只发布一次 tail
+template <class T, class Alloc>
+template <class InputIter>
+typename spsc_queue<T, Alloc>::size_type
+spsc_queue<T, Alloc>::push_n(InputIter first, size_type n)
+{
+    const auto tail = tail_.index.load(std::memory_order_relaxed);
+    auto avail = this->capacity() - (tail - tail_.cache);
+    if (avail < n)
+    {
+        tail_.cache = head_.index.load(std::memory_order_acquire);
+        avail = this->capacity() - (tail - tail_.cache);
+    }
+    const auto count = mystl::min(n, avail);
+    size_type i = 0;
+    try
+    {
+        for (; i < count; ++i, ++first)
+            this->construct_at(mystl::address_of(this->slot(tail + i)), mystl::move(*first));
+    }
+    catch (...)
+    {
+        tail_.index.store(tail + i, std::memory_order_release);
+        throw;
+    }
+    tail_.index.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+// 把至多 n 个元素移动到以 result 开始的区间，整批只发布一次 head
+template <class T, class Alloc>
+template <class OutputIter>
+typename spsc_queue<T, Alloc>::size_type
+spsc_queue<T, Alloc>::pop_n(OutputIter result, size_type n)
+{
+    const auto head = head_.index.load(std::memory_order_relaxed);
+    auto ready = head_.cache - head;
+    if (ready < n)
+    {
+        head_.cache = tail_.index.load(std::memory_order_acquire);
+        ready = head_.cache - head;
+    }
+    const auto count = mystl::min(n, ready);
+    size_type i = 0;
+    try
+    {
+        for (; i < count; ++i, ++result)
+        {
+            auto p = mystl::address_of(this->slot(head + i));
+            *result = mystl::move(*p);
+            this->destroy_at(p);
+        }
+    }
+    catch (...)
+    {
+        head_.index.store(head + i, std::memory_order_release);
+        throw;
+    }
+    head_.index.store(head + count, std::memory_order_release);
+    return count;
+}
+
+// 模板类 mpmc_queue
+// 参数一代表数据类型，参数二代表空间配置器类型，缺省使用 mystl::allocator
+// 每个槽位带有序号 seq：seq == pos 表示下标为 pos 的生产者可以写入，
+// seq == pos + 1 表示下标为 pos 的消费者可以读取，读取后 seq 增加容量，留给下一轮的生产者
+// 生产者和消费者分别用 CAS 抢占 enqueue_ / dequeue_，一次可以抢占连续的多个槽位
+template <class T, class Alloc = mystl::allocator<T>>
+class mpmc_queue : public ring_detail::ring_storage<ring_detail::mpmc_slot<T>, Alloc>
+{
+    typedef ring_detail::ring_storage<ring_detail::mpmc_slot<T>, Alloc> base;
+
+    static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value,
+                  "the value_type of mpmc_queue should be nothrow move constructible and assignable");
+
+public:
+    typedef T      value_type;
+    typedef Alloc  allocator_type;
+    typedef size_t size_type;
+
+private:
+    char                      pad_[ring_detail::cache_line_size];  // 与只读的 slots_ / mask_ 隔开
+    ring_detail::padded_index enqueue_;  // 下一个生产者的下标
+    ring_detail::padded_index dequeue_;  // 下一个消费者的下标
+
+public:
+    explicit mpmc_queue(size_type n, const allocator_type& alloc = allocator_type())
+        : base(n, alloc)
+    {
+        for (size_type i = 0; i < this->capacity(); ++i)
+            ::new (mystl::address_of(this->slots_[i].seq)) std::atomic<size_type>(i);
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    ~mpmc_queue()
+    {
+        auto tail = enqueue_.index.load(std::memory_order_relaxed);
+        for (auto i = dequeue_.index.load(std::memory_order_relaxed); i != tail; ++i)
+            this->destroy_at(this->slot(i).value());
+    }
+
+    // 以下两个函数得到的是某一时刻的近似值
+    size_type size() const noexcept
+    {
+        auto head = dequeue_.index.load(std::memory_order_acquire);
+        auto tail = enqueue_.index.load(std::memory_order_acquire);
+        return tail > head ? mystl::min(tail - head, this->capacity()) : 0;
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    // 先在槽位外构造元素，抢占槽位之后只做不会失败的移动构造
+    template <class... Args>
+    bool emplace(Args&&... args)
+    {
+        value_type value(mystl::forward<Args>(args)...);
+        return push(mystl::move(value));
+    }
+
+    bool push(const value_type& value)
+    {
+        value_type tmp(value);
+        return push(mystl::move(tmp));
+    }
+
+    bool push(value_type&& value)
+    {
+        return push_n(mystl::address_of(value), 1) == 1;
+    }
+
+    bool pop(value_type& value)
+    {
+        return pop_n(mystl::address_of(value), 1) == 1;
+    }
+
+    template <class InputIter>
+    size_type push_n(InputIter first, size_type n);
+
+    template <class OutputIter>
+    size_type pop_n(OutputIter result, size_type n);
+};
+
+/*****************************************************************************************/
+
+// 把 [first, first + n) 中至多 n 个元素移动到队列中，返回实际移动的个数
+template <class T, class Alloc>
+template <class InputIter>
+typename mpmc_queue<T, Alloc>::size_type
+mpmc_queue<T, Alloc>::push_n(InputIter first, size_type n)
+{
+    static_assert(std::is_nothrow_constructible<value_type, decltype(mystl::move(*first))>::value,
+                  "mpmc_queue::push_n should not throw after the slots are claimed");
+    if (n == 0)
+        return 0;
+    auto pos = enqueue_.index.load(std::memory_order_relaxed);
+    size_type count = 0;
+    while (true)
+    {
+        auto seq = this->slot(pos).seq.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff < 0)
+            return 0;  // 队列已满
+        if (diff > 0)
+        {   // 其他生产者已经抢占了 pos
+            pos = enqueue_.index.load(std::memory_order_relaxed);
+            continue;
+        }
+        count = 1;
+        while (count < n && count < this->capacity() &&
+               this->slot(pos + count).seq.load(std::memory_order_acquire) == pos + count)
+            ++count;
+        if (enqueue_.index.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+            break;
+    }
+    for (size_type i = 0; i < count; ++i, ++first)
+    {
+        auto& s = this->slot(pos + i);
+        this->construct_at(s.value(), mystl::move(*first));
+        s.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    return count;
+}
+
+// 把至多 n 个元素移动到以 result 开始的区间，返回实际移动的个数
+template <class T, class Alloc>
+template <class OutputIter>
+typename mpmc_queue<T, Alloc>::size_type
+mpmc_queue<T, Alloc>::pop_n(OutputIter result, size_type n)
+{
+    static_assert(noexcept(*result = mystl::move(*std::declval<value_type*>())),
+                  "mpmc_queue::pop_n should not throw after the slots are claimed");
+    if (n == 0)
+        return 0;
+    auto pos = dequeue_.index.load(std::memory_order_relaxed);
+    size_type count = 0;
+    while (true)
+    {
+        auto seq = this->slot(pos).seq.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff < 0)
+            return 0;  // 队列为空
+        if (diff > 0)
+        {   // 其他消费者已经抢占了 pos
+            pos = dequeue_.index.load(std::memory_order_relaxed);
+            continue;
+        }
+        count = 1;
+        while (count < n && count < this->capacity() &&
+               this->slot(pos + count).seq.load(std::memory_order_acquire) == pos + count + 1)
+            ++count;
+        if (dequeue_.index.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+            break;
+    }
+    for (size_type i = 0; i < count; ++i, ++result)
+    {
+        auto& s = this->slot(pos + i);
+        *result = mystl::move(*s.value());
+        this->destroy_at(s.value());
+        s.seq.store(pos + i + this->capacity(), std::memory_order_release);
+    }
+    return count;
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_RING_BUFFER_H_
+
@@ -18,11 +18,20 @@
 namespace mystl
 {
 
+template <typename Key, typename Compare, typename Alloc, typename Policy> class multiset;
+
 // 模板类 set，键值不允许重复
-// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less 
-template <typename Key, typename Compare = mystl::less<Key>>
+// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+// 参数四代表节点策略，缺省使用 mystl::rb_tree_plain_policy，使用 mystl::rb_tree_rank_policy 时可以调用 nth 与 rank
+template <typename Key, typename Compare = mystl::less<Key>, typename Alloc = mystl::allocator<Key>,
+          typename Policy = mystl::rb_tree_plain_policy>
 class set
 {
+    // merge 需要访问其它 set / multiset 的底层 rb_tree
+    template <typename, typename, typename, typename> friend class set;
+    template <typename, typename, typename, typename> friend class multiset;
+
 public:
     typedef Key      key_type;
     typedef Key      value_type;
@@ -31,12 +40,13 @@ public:
 
 private:
     // 以 mystl::rb_tree 作为底层机制
-    typedef mystl::rb_tree<value_type, key_compare> base_type;
+    typedef mystl::rb_tree<value_type, key_compare, Alloc, Policy> base_type;
     base_type tree_;
 
 public:
     // 使用 rb_tree 定义的型别
-    typedef typename base_type::node_type               node_type;
+    typedef typename base_type::node_handle             node_type;
+    typedef mystl::node_insert_return<typename base_type::const_iterator, node_type> insert_return_type;
     typedef typename base_type::const_pointer           pointer;
     typedef typename base_type::const_pointer           const_pointer;
     typedef typename base_type::const_reference         reference;
@@ -53,12 +63,16 @@ public:
     // 构造、复制、移动函数
     set() = default;
 
+    explicit set(const allocator_type& alloc) : tree_(alloc) {}
+
     template <typename InputIterator>
-    set(InputIterator first, InputIterator last) : tree_()
+    set(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     {
         tree_.insert_unique(first, last);
     }
-    set(std::initializer_list<value_type> ilist) : tree_()
+    set(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     {
         tree_.insert_unique(ilist.begin(), ilist.end());
     }
@@ -156,6 +170,30 @@ public:
         tree_.insert_unique(first, last);
     }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    insert_return_type insert(node_type&& nh)
+    {
+        auto res = tree_.insert_unique(mystl::move(nh));
+        return insert_return_type{res.position, res.inserted, mystl::move(res.node)};
+    }
+    iterator insert(iterator hint, node_type&& nh)
+    {
+        return tree_.insert_unique(hint, mystl::move(nh));
+    }
+
+    node_type extract(iterator pos)         { return tree_.extract(pos); }
+    node_type extract(const key_type& key)  { return tree_.extract(key); }
+
+    // merge 把 source 中键值不重复的元素移过来，键值重复的元素留在 source 中
+    template <typename Compare2>
+    void merge(set<Key, Compare2, Alloc, Policy>& source)  { tree_.merge_unique(source.tree_); }
+    template <typename Compare2>
+    void merge(set<Key, Compare2, Alloc, Policy>&& source) { tree_.merge_unique(source.tree_); }
+    template <typename Compare2>
+    void merge(multiset<Key, Compare2, Alloc, Policy>& source)  { tree_.merge_unique(source.tree_); }
+    template <typename Compare2>
+    void merge(multiset<Key, Compare2, Alloc, Policy>&& source) { tree_.merge_unique(source.tree_); }
+
     void erase(iterator position) { tree_.erase(position); }
     size_type erase(const value_type& value)
     {
@@ -183,6 +221,36 @@ public:
     pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     { return tree_.equal_range_unique(key); }
 
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return tree_.count_unique(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return tree_.equal_range_unique(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return tree_.equal_range_unique(key); }
+
+    // 顺序统计，只有节点策略为 mystl::rb_tree_rank_policy 时才能调用，都是 O(log n)
+    // nth(k) 返回第 k 小（从 0 开始）的元素，k 不小于 size() 时返回 end()；rank(key) 返回小于 key 的元素个数
+    iterator       nth(size_type k)                       { return tree_.nth(k); }
+    const_iterator nth(size_type k)                 const { return tree_.nth(k); }
+    size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      rank(const K& key)               const { return tree_.rank(key); }
+
     void swap(set& rhs) noexcept
     { tree_.swap(rhs.tree_); }
 public:
@@ -190,8 +258,8 @@ public:
     friend bool operator< (const set& lhs, const set& rhs) { return lhs.tree_ < rhs.tree_; }
 };
 
-template <typename Key, typename Compare>
-void swap(set<Key, Compare>& lhs, set<Key, Compare>& rhs) noexcept
+template <typename Key, typename Compare, typename Alloc, typename Policy>
+void swap(set<Key, Compare, Alloc, Policy>& lhs, set<Key, Compare, Alloc, Policy>& rhs) noexcept
 {
     lhs.swap(rhs);
 }
@@ -199,10 +267,17 @@ void swap(set<Key, Compare>& lhs, set<Key, Compare>& rhs) noexcept
 /*****************************************************************************************/
 
 // 模板类 multiset，键值允许重复
-// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less 
-template <typename Key, typename Compare = mystl::less<Key>>
+// 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less
+// 参数三代表空间配置器，缺省使用 mystl::allocator
+// 参数四代表节点策略，缺省使用 mystl::rb_tree_plain_policy，使用 mystl::rb_tree_rank_policy 时可以调用 nth 与 rank
+template <typename Key, typename Compare = mystl::less<Key>, typename Alloc = mystl::allocator<Key>,
+          typename Policy = mystl::rb_tree_plain_policy>
 class multiset
 {
+    // merge 需要访问其它 set / multiset 的底层 rb_tree
+    template <typename, typename, typename, typename> friend class set;
+    template <typename, typename, typename, typename> friend class multiset;
+
 public:
     typedef Key      key_type;
     typedef Key      value_type;
@@ -211,12 +286,12 @@ public:
 
 private:
     // 以 mystl::rb_tree 作为底层机制
-    typedef mystl::rb_tree<value_type, key_compare> base_type;
+    typedef mystl::rb_tree<value_type, key_compare, Alloc, Policy> base_type;
     base_type tree_;
 
 public:
     // 使用 rb_tree 定义的型别
-    typedef typename base_type::node_type               node_type;
+    typedef typename base_type::node_handle             node_type;
     typedef typename base_type::const_pointer           pointer;
     typedef typename base_type::const_pointer           const_pointer;
     typedef typename base_type::const_reference         reference;
@@ -233,12 +308,16 @@ public:
     // 构造、复制、移动函数
     multiset() = default;
 
+    explicit multiset(const allocator_type& alloc) : tree_(alloc) {}
+
     template <typename InputIterator>
-    multiset(InputIterator first, InputIterator last) : tree_()
+    multiset(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     {
         tree_.insert_multi(first, last);
     }
-    multiset(std::initializer_list<value_type> ilist) : tree_()
+    multiset(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        : tree_(alloc)
     {
         tree_.insert_multi(ilist.begin(), ilist.end());
     }
@@ -336,6 +415,29 @@ public:
         tree_.insert_multi(first, last);
     }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    iterator insert(node_type&& nh)
+    {
+        return tree_.insert_multi(mystl::move(nh));
+    }
+    iterator insert(iterator hint, node_type&& nh)
+    {
+        return tree_.insert_multi(hint, mystl::move(nh));
+    }
+
+    node_type extract(iterator pos)         { return tree_.extract(pos); }
+    node_type extract(const key_type& key)  { return tree_.extract(key); }
+
+    // merge 把 source 中的全部元素移过来
+    template <typename Compare2>
+    void merge(set<Key, Compare2, Alloc, Policy>& source)  { tree_.merge_multi(source.tree_); }
+    template <typename Compare2>
+    void merge(set<Key, Compare2, Alloc, Policy>&& source) { tree_.merge_multi(source.tree_); }
+    template <typename Compare2>
+    void merge(multiset<Key, Compare2, Alloc, Policy>& source)  { tree_.merge_multi(source.tree_); }
+    template <typename Compare2>
+    void merge(multiset<Key, Compare2, Alloc, Policy>&& source) { tree_.merge_multi(source.tree_); }
+
     void erase(iterator position) { tree_.erase(position); }
     size_type erase(const value_type& value)
     {
@@ -363,6 +465,36 @@ public:
     pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     { return tree_.equal_range_multi(key); }
 
+    // 比较函数声明了 is_transparent 时（如 mystl::less<>），可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       find(const K& key)              { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator find(const K& key)        const { return tree_.find(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      count(const K& key)       const { return tree_.count_multi(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       lower_bound(const K& key)       { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator lower_bound(const K& key) const { return tree_.lower_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    iterator       upper_bound(const K& key)       { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    const_iterator upper_bound(const K& key) const { return tree_.upper_bound(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return tree_.equal_range_multi(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return tree_.equal_range_multi(key); }
+
+    // 顺序统计，只有节点策略为 mystl::rb_tree_rank_policy 时才能调用，都是 O(log n)
+    // nth(k) 返回第 k 小（从 0 开始）的元素，k 不小于 size() 时返回 end()；rank(key) 返回小于 key 的元素个数
+    iterator       nth(size_type k)                       { return tree_.nth(k); }
+    const_iterator nth(size_type k)                 const { return tree_.nth(k); }
+    size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+    template <class K, class = typename has_transparent<key_compare, K>::type>
+    size_type      rank(const K& key)               const { return tree_.rank(key); }
+
     void swap(multiset& rhs) noexcept
     { tree_.swap(rhs.tree_); }
 public:
@@ -370,12 +502,35 @@ public:
     friend bool operator< (const multiset& lhs, const multiset& rhs) { return lhs.tree_ < rhs.tree_; }
 };
 
-template <typename Key, typename Compare>
-void swap(multiset<Key, Compare>& lhs, multiset<Key, Compare>& rhs) noexcept
+template <typename Key, typename Compare, typename Alloc, typename Policy>
+void swap(multiset<Key, Compare, Alloc, Policy>& lhs, multiset<Key, Compare, Alloc, Policy>& rhs) noexcept
 {
     lhs.swap(rhs);
 }
 
+// 与底层的 rb_tree 相同，可以直接搬移
+template <typename Key, typename Compare, typename Alloc, typename Policy>
+struct is_trivially_relocatable<set<Key, Compare, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <typename Key, typename Compare, typename Alloc, typename Policy>
+struct is_trivially_relocatable<multiset<Key, Compare, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Compare>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 set / multiset，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <typename Key, typename Compare = mystl::less<Key>>
+using set = mystl::set<Key, Compare, polymorphic_allocator<Key>>;
+
+template <typename Key, typename Compare = mystl::less<Key>>
+using multiset = mystl::multiset<Key, Compare, polymorphic_allocator<Key>>;
+} // namespace pmr
+
 }
 
 #endif
\ No newline at end of file
@@ -39,6 +39,64 @@ struct is_pair : m_false_type {};
 template <typename T1, typename T2>
 struct is_pair<mystl::pair<T1, T2>> : m_true_type {};
 
+// is_trivially_relocatable
+// 可以直接复制内存把对象搬到新地址，并且搬移后不必在原地址调用析构函数的类型
+// 默认只包括平凡可复制的类型，不保存指向自身的指针的类（如各个容器）可以特化该模板
+
+template <typename T>
+struct is_trivially_relocatable
+    : m_bool_constant<std::is_trivially_copyable<T>::value> {};
+
+template <typename T>
+struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {};
+
+template <typename T1, typename T2>
+struct is_trivially_relocatable<mystl::pair<T1, T2>>
+    : m_bool_constant<is_trivially_relocatable<T1>::value &&
+                      is_trivially_relocatable<T2>::value> {};
+
+// can_extract_key
+// 判断能否不构造元素，直接从 emplace 的参数中取得键值，以便先查找、键值不存在时才分配节点：
+// 元素不是 pair 时，唯一参数的型别就是键值型别；元素是 pair 时，两个参数中第一个的型别是键值型别，
+// 或者唯一的参数是 first 型别为键值型别的 pair
+
+template <typename P, typename Key>
+struct pair_first_is : m_false_type {};
+
+template <typename T1, typename T2, typename Key>
+struct pair_first_is<mystl::pair<T1, T2>, Key>
+    : m_bool_constant<std::is_same<typename std::remove_cv<T1>::type, Key>::value> {};
+
+template <typename Key, typename Value, typename... Args>
+struct can_extract_key : m_false_type {};
+
+template <typename Key, typename Value, typename A>
+struct can_extract_key<Key, Value, A>
+    : m_bool_constant<is_pair<Value>::value
+                      ? pair_first_is<typename std::decay<A>::type, Key>::value
+                      : std::is_same<typename std::decay<A>::type, Key>::value> {};
+
+template <typename Key, typename Value, typename A, typename B>
+struct can_extract_key<Key, Value, A, B>
+    : m_bool_constant<is_pair<Value>::value &&
+                      std::is_same<typename std::decay<A>::type, Key>::value> {};
+
+// has_transparent
+// 函数对象声明了 is_transparent 时，has_transparent<Fn, K>::type 为 void，否则没有 type 成员
+// 参数 K 让结果依赖于查找函数自身的模板参数，使替换失败只去掉该重载，用于启用异构查找
+
+template <typename... Ts>
+struct m_void { typedef void type; };
+
+template <typename Fn, typename K, typename = void>
+struct has_transparent {};
+
+template <typename Fn, typename K>
+struct has_transparent<Fn, K, typename m_void<typename Fn::is_transparent>::type>
+{
+    typedef void type;
+};
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_TYPE_TRAITS_H_
\ No newline at end of file
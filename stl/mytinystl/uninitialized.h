@@ -20,7 +20,86 @@ ForwardIterator unchecked_uninit_copy(InputIterator first, InputIterator last, F
     return mystl::copy(first, last, result);
 }
 template <class InputIterator, class ForwardIterator>
-ForwardIterator unchecked_uninit_copy(InputIterator first, InputIterator last, ForwardIterator result, std::false_type)
+ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result);
+
+// 分段迭代器的版本：源区间是分段迭代器时逐段构造，出现异常时析构已经构造的元素
+template <class InputIterator, class ForwardIterator, class OutputSegmented>
+ForwardIterator segmented_uninit_copy(InputIterator first, InputIterator last, ForwardIterator result, m_true_type, OutputSegmented)
+{
+    typedef segmented_iterator_traits<InputIterator> traits;
+    auto sfirst = traits::segment(first);
+    const auto slast = traits::segment(last);
+    if(sfirst == slast)
+    {
+        return mystl::uninitialized_copy(traits::local(first), traits::local(last), result);
+    }
+    auto cur = result;
+    try
+    {
+        cur = mystl::uninitialized_copy(traits::local(first), traits::end(sfirst), cur);
+        for(++sfirst; sfirst != slast; ++sfirst)
+        {
+            cur = mystl::uninitialized_copy(traits::begin(sfirst), traits::end(sfirst), cur);
+        }
+        return mystl::uninitialized_copy(traits::begin(slast), traits::local(last), cur);
+    }
+    catch(...)
+    {
+        mystl::destroy(result, cur);
+        throw;
+    }
+}
+
+// 目标区间是分段迭代器时，把源区间切成与目标的每一段对齐的小段
+template <class RandomIter, class ForwardIterator>
+ForwardIterator segmented_uninit_copy_out(RandomIter first, RandomIter last, ForwardIterator result, mystl::random_access_iterator_tag)
+{
+    typedef segmented_iterator_traits<ForwardIterator> traits;
+    auto n = last - first;
+    if(n <= 0)
+    {
+        return result;
+    }
+    auto seg = traits::segment(result);
+    auto cur = traits::local(result);
+    try
+    {
+        while(true)
+        {
+            const auto room = traits::end(seg) - cur;
+            const auto len = n < room ? n : room;
+            auto next = mystl::uninitialized_copy(first, first + len, cur);
+            first += len;
+            n -= len;
+            if(n == 0)
+            {
+                return traits::compose(seg, next);
+            }
+            ++seg;
+            cur = traits::begin(seg);
+        }
+    }
+    catch(...)
+    {
+        mystl::destroy(result, traits::compose(seg, cur));
+        throw;
+    }
+}
+
+template <class InputIterator, class ForwardIterator>
+ForwardIterator segmented_uninit_copy_out(InputIterator first, InputIterator last, ForwardIterator result, mystl::input_iterator_tag)
+{
+    return segmented_uninit_copy(first, last, result, m_false_type{}, m_false_type{});
+}
+
+template <class InputIterator, class ForwardIterator>
+ForwardIterator segmented_uninit_copy(InputIterator first, InputIterator last, ForwardIterator result, m_false_type, m_true_type)
+{
+    return segmented_uninit_copy_out(first, last, result, iterator_category(first));
+}
+
+template <class InputIterator, class ForwardIterator>
+ForwardIterator segmented_uninit_copy(InputIterator first, InputIterator last, ForwardIterator result, m_false_type, m_false_type)
 {
     auto cur = result;
     try
@@ -32,14 +111,22 @@ ForwardIterator unchecked_uninit_copy(InputIterator first, InputIterator last, F
     }
     catch(...)
     {
-        for(; result != cur; --cur)
+        for(; result != cur; ++result)
         {
-            mystl::destroy(&*cur);
+            mystl::destroy(&*result);
         }
+        throw;
     }
     return cur;
 }
 
+template <class InputIterator, class ForwardIterator>
+ForwardIterator unchecked_uninit_copy(InputIterator first, InputIterator last, ForwardIterator result, std::false_type)
+{
+    return segmented_uninit_copy(first, last, result,
+                                 is_segmented_iterator<InputIterator>{}, is_segmented_iterator<ForwardIterator>{});
+}
+
 template <class InputIterator, class ForwardIterator>
 ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result)
 {
@@ -218,6 +305,69 @@ ForwardIterator uninitialized_move_n(InputIterator first, Size n, ForwardIterato
     return unchecked_uninit_move_n(first, n, result, std::is_trivially_move_assignable<typename iterator_traits<InputIterator>::value_type>{});
 }
 
+
+// uninitialized_relocate
+// 把[first, last)上的对象搬到以 result 为起始处的未初始化空间，返回搬移结束的位置，
+// 之后[first, last)视为未初始化的空间
+// 可平凡重定位的类型直接复制内存，两段空间可以重叠；
+// 其余类型逐个移动构造再析构原对象，要求 result 不落在 (first, last) 内
+template <class T>
+T* unchecked_uninit_relocate(T* first, T* last, T* result, std::true_type) noexcept
+{
+    const auto n = static_cast<size_t>(last - first);
+    if(n != 0)
+        std::memmove(static_cast<void*>(result), static_cast<const void*>(first), n * sizeof(T));
+    return result + n;
+}
+template <class T>
+T* unchecked_uninit_relocate(T* first, T* last, T* result, std::false_type)
+{
+    for(; first != last; ++first, ++result)
+    {
+        mystl::construct(result, mystl::move(*first));
+        mystl::destroy(first);
+    }
+    return result;
+}
+
+template <class T>
+T* uninitialized_relocate(T* first, T* last, T* result)
+{
+    return unchecked_uninit_relocate(first, last, result,
+        std::integral_constant<bool, mystl::is_trivially_relocatable<T>::value>{});
+}
+
+// uninitialized_relocate_backward
+// 把[first, last)上的对象搬到以 result 为结束处的未初始化空间，返回搬移开始的位置
+// 从后往前逐个搬移，用于在连续空间中把元素向后挪动，要求 result 不落在 (first, last) 内
+template <class T>
+T* unchecked_uninit_relocate_backward(T* first, T* last, T* result, std::true_type) noexcept
+{
+    const auto n = static_cast<size_t>(last - first);
+    if(n != 0)
+        std::memmove(static_cast<void*>(result - n), static_cast<const void*>(first), n * sizeof(T));
+    return result - n;
+}
+template <class T>
+T* unchecked_uninit_relocate_backward(T* first, T* last, T* result, std::false_type)
+{
+    while(last != first)
+    {
+        --last;
+        --result;
+        mystl::construct(result, mystl::move(*last));
+        mystl::destroy(last);
+    }
+    return result;
+}
+
+template <class T>
+T* uninitialized_relocate_backward(T* first, T* last, T* result)
+{
+    return unchecked_uninit_relocate_backward(first, last, result,
+        std::integral_constant<bool, mystl::is_trivially_relocatable<T>::value>{});
+}
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_UNINITIALIZED_H_
\ No newline at end of file
@@ -17,15 +17,25 @@
 namespace mystl
 {
 
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy> class unordered_multimap;
+
 // 模板类 unordered_map，键值不允许重复
 // 参数一代表键值类型，参数二代表实值类型，参数三代表哈希函数，缺省使用 mystl::hash
 // 参数四代表键值比较方式，缺省使用 mystl::equal_to
-template <class Key, class T, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+// 参数五代表空间配置器，缺省使用 mystl::allocator
+// 参数六代表 bucket 策略，缺省使用 mystl::ht_prime_policy，也可以使用 mystl::ht_pow2_policy
+template <class Key, class T, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>,
+          class Alloc = mystl::allocator<mystl::pair<const Key, T>>,
+          class Policy = mystl::ht_prime_policy>
 class unordered_map
 {
+    // merge 需要访问其它 unordered_map / unordered_multimap 的底层 hashtable
+    template <class, class, class, class, class, class> friend class unordered_map;
+    template <class, class, class, class, class, class> friend class unordered_multimap;
+
 private:
     // 使用 hashtable 作为底层机制
-    typedef hashtable<mystl::pair<const Key, T>, Hash, KeyEqual> base_type;
+    typedef hashtable<mystl::pair<const Key, T>, Hash, KeyEqual, Alloc, Policy> base_type;
     base_type ht_;
 
 public:
@@ -49,27 +59,35 @@ public:
     typedef typename base_type::local_iterator       local_iterator;
     typedef typename base_type::const_local_iterator const_local_iterator;
 
+    typedef typename base_type::node_handle          node_type;
+    typedef typename base_type::insert_return_type   insert_return_type;
+
     allocator_type get_allocator() const { return ht_.get_allocator(); }
 
 public:
     // 构造、复制、移动函数
     unordered_map() : ht_(100, Hash(), KeyEqual()) {}
 
-    explicit unordered_map(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : ht_(bucket_count, hash, equal) {}
+    explicit unordered_map(const allocator_type& alloc) : ht_(100, Hash(), KeyEqual(), alloc) {}
+
+    explicit unordered_map(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+        const allocator_type& alloc = allocator_type())
+    : ht_(bucket_count, hash, equal, alloc) {}
 
     template<class InputIterator>
     unordered_map(InputIterator first, InputIterator last,
-                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal)
+                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                const allocator_type& alloc = allocator_type())
+    : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal, alloc)
     {
         for(; first != last; ++first)
             ht_.insert_unique_noresize(*first);
     }
 
     unordered_map(std::initializer_list<value_type> ilist,
-                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal)
+                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                const allocator_type& alloc = allocator_type())
+    : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal, alloc)
     {
         for(auto first = ilist.begin(), last = ilist.end(); first != last; ++first)
             ht_.insert_unique_noresize(*first);
@@ -129,6 +147,47 @@ public:
         return ht_.emplace_unique_use_hint(hint, mystl::forward<Args>(args)...);
     }
 
+    // try_emplace
+    // 键值不存在时才用 args 构造实值，键值已经存在时不分配空间，key 与 args 也不会被移动
+    // [note]: 与 emplace_hint 相同，忽略 hint
+    template <class... Args>
+    pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    { return ht_.try_emplace_unique(key, mystl::forward<Args>(args)...); }
+    template <class... Args>
+    pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    { return ht_.try_emplace_unique(mystl::move(key), mystl::forward<Args>(args)...); }
+    template <class... Args>
+    iterator try_emplace(const_iterator /*hint*/, const key_type& key, Args&&... args)
+    { return ht_.try_emplace_unique(key, mystl::forward<Args>(args)...).first; }
+    template <class... Args>
+    iterator try_emplace(const_iterator /*hint*/, key_type&& key, Args&&... args)
+    { return ht_.try_emplace_unique(mystl::move(key), mystl::forward<Args>(args)...).first; }
+
+    // insert_or_assign
+    // 键值不存在时插入，否则把 obj 赋值给已有的实值
+    template <class M>
+    pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+    {
+        auto res = ht_.try_emplace_unique(key, mystl::forward<M>(obj));
+        if(!res.second)
+            res.first->second = mystl::forward<M>(obj);
+        return res;
+    }
+    template <class M>
+    pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+    {
+        auto res = ht_.try_emplace_unique(mystl::move(key), mystl::forward<M>(obj));
+        if(!res.second)
+            res.first->second = mystl::forward<M>(obj);
+        return res;
+    }
+    template <class M>
+    iterator insert_or_assign(const_iterator /*hint*/, const key_type& key, M&& obj)
+    { return insert_or_assign(key, mystl::forward<M>(obj)).first; }
+    template <class M>
+    iterator insert_or_assign(const_iterator /*hint*/, key_type&& key, M&& obj)
+    { return insert_or_assign(mystl::move(key), mystl::forward<M>(obj)).first; }
+
     // insert
     pair<iterator, bool> insert(const value_type& value)
     { return ht_.insert_unique(value); }
@@ -144,6 +203,29 @@ public:
     void insert(InputIterator first, InputIterator last)
     { ht_.insert_unique(first, last); }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    insert_return_type insert(node_type&& nh)
+    { return ht_.insert_unique(mystl::move(nh)); }
+    iterator insert(const_iterator hint, node_type&& nh)
+    { return ht_.insert_unique_use_hint(hint, mystl::move(nh)); }
+
+    node_type extract(const_iterator pos)  { return ht_.extract(pos); }
+    node_type extract(const key_type& key) { return ht_.extract(key); }
+
+    // merge 把 source 中键值不重复的元素移过来，键值重复的元素留在 source 中
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_map<Key, T, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_unique(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_map<Key, T, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_unique(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multimap<Key, T, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_unique(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multimap<Key, T, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_unique(source.ht_); }
+
     // erase / clear
     void erase(iterator it) { ht_.erase(it); }
     void erase(iterator first, iterator last) { ht_.erase(first, last); }
@@ -172,15 +254,11 @@ public:
 
     mapped_type& operator[](const key_type& key)
     {
-        iterator it = ht_.find(key);
-        if(it.node == nullptr)it = ht_.emplace_unique(key, T{}).first;
-        return it->second;
+        return ht_.try_emplace_unique(key).first->second;
     }
     mapped_type& operator[](key_type&& key)
     {
-        iterator it = ht_.find(key);
-        if(it.node == nullptr)it = ht_.emplace_unique(mystl::move(key), T{}).first;
-        return it->second;
+        return ht_.try_emplace_unique(mystl::move(key)).first->second;
     }
 
     size_type count(const key_type& key) const
@@ -196,6 +274,31 @@ public:
     pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     { return ht_.equal_range_unique(key); }
 
+    // 哈希函数与比较函数都声明了 is_transparent 时（如 mystl::string_hash<> 与 mystl::equal_to<>），
+    // 可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    size_type count(const K& key) const
+    { return ht_.count(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    iterator find(const K& key)
+    { return ht_.find(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    const_iterator find(const K& key) const
+    { return ht_.find(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return ht_.equal_range_unique(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return ht_.equal_range_unique(key); }
+
     // bucket interface
     local_iterator       begin(size_type n)  noexcept       { return ht_.begin(n); }
     const_local_iterator begin(size_type n)  const noexcept { return ht_.begin(n); }
@@ -238,21 +341,21 @@ public:
 };
 
 // 重载比较操作符
-template <class Key, class T, class Hash, class KeyEqual>
-bool operator==(const unordered_map<Key, T, Hash, KeyEqual>& lhs, const unordered_map<Key, T, Hash, KeyEqual>& rhs)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator==(const unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs == rhs;
 }
 
-template<class Key, class T, class Hash, class KeyEqual>
-bool operator!=(const unordered_map<Key, T, Hash, KeyEqual>& lhs, const unordered_map<Key, T, Hash, KeyEqual>& rhs)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator!=(const unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs != rhs;
 }
 
 // 重载 mystl 的 swap
-template<class Key, class T, class Hash, class KeyEqual>
-void swap(unordered_map<Key, Hash, KeyEqual>& lhs, unordered_map<Key, T, Hash, KeyEqual>& rhs)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void swap(unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs, unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     lhs.swap(rhs);
 }
@@ -263,12 +366,20 @@ void swap(unordered_map<Key, Hash, KeyEqual>& lhs, unordered_map<Key, T, Hash, K
 // 模板类 unordered_multimap，键值允许重复
 // 参数一代表键值类型，参数二代表实值类型，参数三代表哈希函数，缺省使用 mystl::hash
 // 参数四代表键值比较方式，缺省使用 mystl::equal_to
-template <class Key, class T, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+// 参数五代表空间配置器，缺省使用 mystl::allocator
+// 参数六代表 bucket 策略，缺省使用 mystl::ht_prime_policy，也可以使用 mystl::ht_pow2_policy
+template <class Key, class T, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>,
+          class Alloc = mystl::allocator<mystl::pair<const Key, T>>,
+          class Policy = mystl::ht_prime_policy>
 class unordered_multimap
 {
+    // merge 需要访问其它 unordered_map / unordered_multimap 的底层 hashtable
+    template <class, class, class, class, class, class> friend class unordered_map;
+    template <class, class, class, class, class, class> friend class unordered_multimap;
+
 private:
     // 使用 hashtable 作为底层机制
-    typedef hashtable<pair<const Key, T>, Hash, KeyEqual> base_type;
+    typedef hashtable<pair<const Key, T>, Hash, KeyEqual, Alloc, Policy> base_type;
     base_type ht_;
 
 public:
@@ -292,27 +403,34 @@ public:
     typedef typename base_type::local_iterator       local_iterator;
     typedef typename base_type::const_local_iterator const_local_iterator;
 
+    typedef typename base_type::node_handle          node_type;
+
     allocator_type get_allocator() const { return ht_.get_allocator(); }
 
 public:
     // 构造、复制、移动函数
     unordered_multimap() : ht_(100, Hash(), KeyEqual()) {}
 
-    explicit unordered_multimap(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : ht_(bucket_count, hash, equal) {}
+    explicit unordered_multimap(const allocator_type& alloc) : ht_(100, Hash(), KeyEqual(), alloc) {}
+
+    explicit unordered_multimap(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+        const allocator_type& alloc = allocator_type())
+    : ht_(bucket_count, hash, equal, alloc) {}
 
     template <class InputIterator>
     unordered_multimap(InputIterator first, InputIterator last,
-                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal)
+                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                const allocator_type& alloc = allocator_type())
+    : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal, alloc)
     {
         for(; first != last; ++first)
             ht_.insert_multi_noresize(*first);
     }
 
     unordered_multimap(std::initializer_list<value_type> ilist,
-                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-    : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal)
+                const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                const allocator_type& alloc = allocator_type())
+    : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal, alloc)
     {
         for(auto first = ilist.begin(), last = ilist.end(); first != last; ++first)
             ht_.insert_multi_noresize(*first);
@@ -387,6 +505,29 @@ public:
     void insert(InputIterator first, InputIterator last)
     { ht_.insert_multi(first, last); }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    iterator insert(node_type&& nh)
+    { return ht_.insert_multi(mystl::move(nh)); }
+    iterator insert(const_iterator hint, node_type&& nh)
+    { return ht_.insert_multi_use_hint(hint, mystl::move(nh)); }
+
+    node_type extract(const_iterator pos)  { return ht_.extract(pos); }
+    node_type extract(const key_type& key) { return ht_.extract(key); }
+
+    // merge 把 source 中的全部元素移过来
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_map<Key, T, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_multi(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_map<Key, T, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_multi(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multimap<Key, T, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_multi(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multimap<Key, T, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_multi(source.ht_); }
+
     // erase / clear
     void erase(iterator it) { ht_.erase(it); }
     void erase(iterator first, iterator last) { ht_.erase(first, last); }
@@ -413,6 +554,31 @@ public:
     pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     { return ht_.equal_range_multi(key); }
 
+    // 哈希函数与比较函数都声明了 is_transparent 时（如 mystl::string_hash<> 与 mystl::equal_to<>），
+    // 可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    size_type count(const K& key) const
+    { return ht_.count(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    iterator find(const K& key)
+    { return ht_.find(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    const_iterator find(const K& key) const
+    { return ht_.find(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return ht_.equal_range_multi(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return ht_.equal_range_multi(key); }
+
     // bucket interface
     local_iterator       begin(size_type n)  noexcept       { return ht_.begin(n); }
     const_local_iterator begin(size_type n)  const noexcept { return ht_.begin(n); }
@@ -456,24 +622,51 @@ public:
 };
 
 // 重载比较操作符
-template <class Key, class T, class Hash, class KeyEqual>
-bool operator==(const unordered_multimap<Key, T, Hash, KeyEqual>& lhs, const unordered_multimap<Key, T, Hash, KeyEqual>& rhs)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator==(const unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs == rhs;
 }
 
-template <class Key, class T, class Hash, class KeyEqual>
-bool operator!=(const unordered_multimap<Key, T, Hash, KeyEqual>& lhs, const unordered_multimap<Key, T, Hash, KeyEqual>& rhs)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator!=(const unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs != rhs;
 }
 
 // 重载 mystl 的 swap
-template <class Key, class T, class Hash, class KeyEqual>
-void swap(unordered_multimap<Key, T, Hash, KeyEqual>& lhs, unordered_multimap<Key, T, Hash, KeyEqual>& rhs){
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+void swap(unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>& lhs, unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>& rhs){
     lhs.swap(rhs);
 }
 
+// 与底层的 hashtable 相同，可以直接搬移
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+struct is_trivially_relocatable<unordered_map<Key, T, Hash, KeyEqual, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Hash>::value &&
+                      is_trivially_relocatable<KeyEqual>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Policy>
+struct is_trivially_relocatable<unordered_multimap<Key, T, Hash, KeyEqual, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Hash>::value &&
+                      is_trivially_relocatable<KeyEqual>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 unordered_map / unordered_multimap，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <class Key, class T, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+using unordered_map = mystl::unordered_map<Key, T, Hash, KeyEqual,
+                                           polymorphic_allocator<mystl::pair<const Key, T>>>;
+
+template <class Key, class T, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+using unordered_multimap = mystl::unordered_multimap<Key, T, Hash, KeyEqual,
+                                                     polymorphic_allocator<mystl::pair<const Key, T>>>;
+} // namespace pmr
+
 }
 
 #endif
\ No newline at end of file
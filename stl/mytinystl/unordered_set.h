@@ -17,15 +17,25 @@
 namespace mystl
 {
 
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy> class unordered_multiset;
+
 // 模板类 unordered_set，键值不允许重复
 // 参数一代表键值类型，参数二代表哈希函数，缺省使用 mystl::hash，
 // 参数三代表键值比较方式，缺省使用 mystl::equal_to
-template <class Key, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+// 参数四代表空间配置器，缺省使用 mystl::allocator
+// 参数五代表 bucket 策略，缺省使用 mystl::ht_prime_policy，也可以使用 mystl::ht_pow2_policy
+template <class Key, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>,
+          class Alloc = mystl::allocator<Key>,
+          class Policy = mystl::ht_prime_policy>
 class unordered_set
 {
+    // merge 需要访问其它 unordered_set / unordered_multiset 的底层 hashtable
+    template <class, class, class, class, class> friend class unordered_set;
+    template <class, class, class, class, class> friend class unordered_multiset;
+
 private:
     // 使用 hashtable 作为底层机制
-    typedef hashtable<Key, Hash, KeyEqual> base_type;
+    typedef hashtable<Key, Hash, KeyEqual, Alloc, Policy> base_type;
     base_type ht_;
 
 public:
@@ -48,27 +58,35 @@ public:
     typedef typename base_type::const_local_iterator local_iterator;
     typedef typename base_type::const_local_iterator const_local_iterator;
 
+    typedef typename base_type::node_handle          node_type;
+    typedef mystl::node_insert_return<iterator, node_type> insert_return_type;
+
     allocator_type get_allocator() const { return ht_.get_allocator(); }
 
 public:
     // 构造、复制、移动函数
     unordered_set() : ht_(100, Hash(), KeyEqual()) {}
 
-    explicit unordered_set(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-        : ht_(bucket_count, hash, equal) {}
+    explicit unordered_set(const allocator_type& alloc) : ht_(100, Hash(), KeyEqual(), alloc) {}
+
+    explicit unordered_set(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+            const allocator_type& alloc = allocator_type())
+        : ht_(bucket_count, hash, equal, alloc) {}
 
     template <class InputIterator>
     unordered_set(InputIterator first, InputIterator last,
-                    const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-        : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal)
+                    const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                    const allocator_type& alloc = allocator_type())
+        : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal, alloc)
     {
         for (; first != last; ++first)
             ht_.insert_unique_noresize(*first);
     }
 
     unordered_set(std::initializer_list<value_type> ilist,
-                    const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-        : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal)
+                    const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                    const allocator_type& alloc = allocator_type())
+        : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal, alloc)
     {
         for (auto first = ilist.begin(), last = ilist.end(); first != last; ++first)
             ht_.insert_unique_noresize(*first);
@@ -138,6 +156,32 @@ public:
     void insert(InputIterator first, InputIterator last)
     { ht_.insert_unique(first, last); }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    insert_return_type insert(node_type&& nh)
+    {
+        auto res = ht_.insert_unique(mystl::move(nh));
+        return insert_return_type{res.position, res.inserted, mystl::move(res.node)};
+    }
+    iterator insert(const_iterator hint, node_type&& nh)
+    { return ht_.insert_unique_use_hint(hint, mystl::move(nh)); }
+
+    node_type extract(const_iterator pos)  { return ht_.extract(pos); }
+    node_type extract(const key_type& key) { return ht_.extract(key); }
+
+    // merge 把 source 中键值不重复的元素移过来，键值重复的元素留在 source 中
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_set<Key, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_unique(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_set<Key, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_unique(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multiset<Key, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_unique(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multiset<Key, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_unique(source.ht_); }
+
     // erase / clear
     void erase(iterator it) { ht_.erase(it); }
     void erase(iterator first, iterator last) { ht_.erase(first, last); }
@@ -164,6 +208,31 @@ public:
     pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     { return ht_.equal_range_unique(key); }
 
+    // 哈希函数与比较函数都声明了 is_transparent 时（如 mystl::string_hash<> 与 mystl::equal_to<>），
+    // 可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    size_type count(const K& key) const
+    { return ht_.count(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    iterator find(const K& key)
+    { return ht_.find(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    const_iterator find(const K& key) const
+    { return ht_.find(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return ht_.equal_range_unique(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return ht_.equal_range_unique(key); }
+
     // bucket interface
     local_iterator       begin(size_type n)  noexcept       { return ht_.begin(n); }
     const_local_iterator begin(size_type n)  const noexcept { return ht_.begin(n); }
@@ -206,21 +275,21 @@ public:
 };
 
 // 重载比较操作符
-template <class Key, class Hash, class KeyEqual, class Alloc>
-bool operator==(const unordered_set<Key, Hash, KeyEqual>& lhs, const unordered_set<Key, Hash, KeyEqual>& rhs)
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator==(const unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs == rhs;
 }
 
-template <class Key, class Hash, class KeyEqual, class Alloc>
-bool operator!=(const unordered_set<Key, Hash, KeyEqual>& lhs, const unordered_set<Key, Hash, KeyEqual>& rhs)
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator!=(const unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs != rhs;
 }
 
 // 重载 mystl 的 swap
-template <class Key, class Hash, class KeyEqual, class Alloc>
-void swap(unordered_set<Key, Hash, KeyEqual>& lhs, unordered_set<Key, Hash, KeyEqual>& rhs)
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+void swap(unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& lhs, unordered_set<Key, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     lhs.swap(rhs);
 }
@@ -230,12 +299,20 @@ void swap(unordered_set<Key, Hash, KeyEqual>& lhs, unordered_set<Key, Hash, KeyE
 // 模板类 unordered_multiset，键值允许重复
 // 参数一代表键值类型，参数二代表哈希函数，缺省使用 mystl::hash，
 // 参数三代表键值比较方式，缺省使用 mystl::equal_to
-template <class Key, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+// 参数四代表空间配置器，缺省使用 mystl::allocator
+// 参数五代表 bucket 策略，缺省使用 mystl::ht_prime_policy，也可以使用 mystl::ht_pow2_policy
+template <class Key, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>,
+          class Alloc = mystl::allocator<Key>,
+          class Policy = mystl::ht_prime_policy>
 class unordered_multiset
 {
+    // merge 需要访问其它 unordered_set / unordered_multiset 的底层 hashtable
+    template <class, class, class, class, class> friend class unordered_set;
+    template <class, class, class, class, class> friend class unordered_multiset;
+
 private:
     // 使用 hashtable 作为底层机制
-    typedef hashtable<Key, Hash, KeyEqual> base_type;
+    typedef hashtable<Key, Hash, KeyEqual, Alloc, Policy> base_type;
     base_type ht_;
 
 public:
@@ -258,27 +335,34 @@ public:
     typedef typename base_type::const_local_iterator local_iterator;
     typedef typename base_type::const_local_iterator const_local_iterator;
 
+    typedef typename base_type::node_handle          node_type;
+
     allocator_type get_allocator() const { return ht_.get_allocator(); }
 
 public:
     // 构造、复制、移动函数
     unordered_multiset() : ht_(100, Hash(), KeyEqual()) {}
 
-    explicit unordered_multiset(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-        : ht_(bucket_count, hash, equal) {}
+    explicit unordered_multiset(const allocator_type& alloc) : ht_(100, Hash(), KeyEqual(), alloc) {}
+
+    explicit unordered_multiset(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+            const allocator_type& alloc = allocator_type())
+        : ht_(bucket_count, hash, equal, alloc) {}
 
     template <class InputIterator>
     unordered_multiset(InputIterator first, InputIterator last,
-                        const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-        : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal)
+                        const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                        const allocator_type& alloc = allocator_type())
+        : ht_(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))), hash, equal, alloc)
     {
         for (; first != last; ++first)
             ht_.insert_multi_noresize(*first);
     }
 
     unordered_multiset(std::initializer_list<value_type> ilist,
-                        const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
-        : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal)
+                        const size_type bucket_count = 100, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                        const allocator_type& alloc = allocator_type())
+        : ht_(mystl::max(bucket_count, static_cast<size_type>(ilist.size())), hash, equal, alloc)
     {
         for (auto first = ilist.begin(), last = ilist.end(); first != last; ++first)
             ht_.insert_multi_noresize(*first);
@@ -349,6 +433,29 @@ public:
     void insert(InputIterator first, InputIterator last)
     { ht_.insert_multi(first, last); }
 
+    // 节点句柄：extract 与 insert(node_type&&) 在容器之间移动元素，不重新分配节点
+    iterator insert(node_type&& nh)
+    { return ht_.insert_multi(mystl::move(nh)); }
+    iterator insert(const_iterator hint, node_type&& nh)
+    { return ht_.insert_multi_use_hint(hint, mystl::move(nh)); }
+
+    node_type extract(const_iterator pos)  { return ht_.extract(pos); }
+    node_type extract(const key_type& key) { return ht_.extract(key); }
+
+    // merge 把 source 中的全部元素移过来
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_set<Key, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_multi(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_set<Key, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_multi(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multiset<Key, Hash2, KeyEqual2, Alloc, Policy2>& source)
+    { ht_.merge_multi(source.ht_); }
+    template <class Hash2, class KeyEqual2, class Policy2>
+    void merge(unordered_multiset<Key, Hash2, KeyEqual2, Alloc, Policy2>&& source)
+    { ht_.merge_multi(source.ht_); }
+
     // erase / clear
     void erase(iterator it) { ht_.erase(it); }
     void erase(iterator first, iterator last) { ht_.erase(first, last); }
@@ -375,6 +482,31 @@ public:
     pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     { return ht_.equal_range_multi(key); }
 
+    // 哈希函数与比较函数都声明了 is_transparent 时（如 mystl::string_hash<> 与 mystl::equal_to<>），
+    // 可以直接用与键值可比较的其它型别查找
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    size_type count(const K& key) const
+    { return ht_.count(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    iterator find(const K& key)
+    { return ht_.find(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    const_iterator find(const K& key) const
+    { return ht_.find(key); }
+
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<iterator, iterator> equal_range(const K& key)
+    { return ht_.equal_range_multi(key); }
+    template <class K, class = typename has_transparent<hasher, K>::type,
+              class = typename has_transparent<key_equal, K>::type>
+    pair<const_iterator, const_iterator> equal_range(const K& key) const
+    { return ht_.equal_range_multi(key); }
+
     // bucket interface
     local_iterator       begin(size_type n) noexcept        { return ht_.begin(n); }
     const_local_iterator begin(size_type n) const noexcept  { return ht_.begin(n); }
@@ -417,25 +549,50 @@ public:
 };
 
 // 重载比较操作符
-template <class Key, class Hash, class KeyEqual, class Alloc>
-bool operator==(const unordered_multiset<Key, Hash, KeyEqual>& lhs, const unordered_multiset<Key, Hash, KeyEqual>& rhs)
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator==(const unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs == rhs;
 }
 
-template <class Key, class Hash, class KeyEqual, class Alloc>
-bool operator!=(const unordered_multiset<Key, Hash, KeyEqual>& lhs, const unordered_multiset<Key, Hash, KeyEqual>& rhs)
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+bool operator!=(const unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>& lhs, const unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>& rhs)
 {
     return lhs != rhs;
 }
 
     // 重载 mystl 的 swap
-    template <class Key, class Hash, class KeyEqual, class Alloc>
-    void swap(unordered_multiset<Key, Hash, KeyEqual>& lhs, unordered_multiset<Key, Hash, KeyEqual>& rhs)
+    template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+    void swap(unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>& lhs, unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>& rhs)
     {
         lhs.swap(rhs);
     }
 
+// 与底层的 hashtable 相同，可以直接搬移
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+struct is_trivially_relocatable<unordered_set<Key, Hash, KeyEqual, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Hash>::value &&
+                      is_trivially_relocatable<KeyEqual>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+template <class Key, class Hash, class KeyEqual, class Alloc, class Policy>
+struct is_trivially_relocatable<unordered_multiset<Key, Hash, KeyEqual, Alloc, Policy>>
+    : m_bool_constant<is_trivially_relocatable<Hash>::value &&
+                      is_trivially_relocatable<KeyEqual>::value &&
+                      is_trivially_relocatable<Alloc>::value> {};
+
+// 使用 pmr::polymorphic_allocator 的 unordered_set / unordered_multiset，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <class Key, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+using unordered_set = mystl::unordered_set<Key, Hash, KeyEqual, polymorphic_allocator<Key>>;
+
+template <class Key, class Hash = mystl::hash<Key>, class KeyEqual = mystl::equal_to<Key>>
+using unordered_multiset = mystl::unordered_multiset<Key, Hash, KeyEqual, polymorphic_allocator<Key>>;
+} // namespace pmr
+
 }
 
 #endif
\ No newline at end of file
@@ -17,6 +17,7 @@
 //   * insert
 
 #include <initializer_list>
+#include <utility>
 
 #include "iterator.h"
 #include "memory.h"
@@ -37,70 +38,99 @@ namespace mystl{
 #endif
 
 // 模板类: vector 
-// 模板参数 T 代表类型
-template <typename T>
-class vector
+// 模板参数 T 代表类型，Alloc 代表空间配置器，缺省使用 mystl::allocator
+template <typename T, typename Alloc = mystl::allocator<T>>
+class vector : private mystl::alloc_holder<typename mystl::allocator_traits<Alloc>::template rebind_alloc<T>>
 {
     static_assert(!std::is_same<bool, T>::value, "vector<boo> is abandoned");
 public:
     // vector 的嵌套型别定义
-    typedef mystl::allocator<T>                       data_allocator;
-    typedef mystl::allocator<T>                       allocator_type;
-
-    typedef typename allocator_type::value_type       value_type;
-    typedef typename allocator_type::pointer          pointer;
-    typedef typename allocator_type::const_pointer    const_pointer;
-    typedef typename allocator_type::reference        reference;
-    typedef typename allocator_type::const_reference  const_reference;
-    typedef typename allocator_type::size_type        size_type;
-    typedef typename allocator_type::difference_type  difference_type;
+    typedef typename mystl::allocator_traits<Alloc>::template rebind_alloc<T> data_allocator;
+    typedef mystl::allocator_traits<data_allocator>   data_alloc_traits;
+    typedef data_allocator                            allocator_type;
+
+    typedef typename data_alloc_traits::value_type      value_type;
+    typedef typename data_alloc_traits::pointer         pointer;
+    typedef typename data_alloc_traits::const_pointer   const_pointer;
+    typedef value_type&                                 reference;
+    typedef const value_type&                           const_reference;
+    typedef typename data_alloc_traits::size_type       size_type;
+    typedef typename data_alloc_traits::difference_type difference_type;
 
     typedef value_type*                               iterator;
     typedef const value_type*                         const_iterator;
     typedef mystl::reverse_iterator<iterator>         reverse_iterator;
     typedef mystl::reverse_iterator<const_iterator>   const_reverse_iterator;
 
-    allocator_type get_allocator() { return data_allocator(); };
+    allocator_type get_allocator() const { return this->get_alloc(); }
 
 private:
+    typedef mystl::alloc_holder<data_allocator>       alloc_base;
+
+    // 可平凡重定位的元素在扩容、插入和删除时直接搬移内存，不再逐个移动和析构
+    typedef std::integral_constant<bool,
+        mystl::is_trivially_relocatable<T>::value>    relocatable;
+
     iterator begin_;  // 表示目前使用空间的头部
     iterator end_;    // 表示目前使用空间的尾部
     iterator cap_;    // 表示目前储存空间的尾部
 
 public:
     // 构造、复制、移动、析构函数
-    vector() noexcept { try_init(); }
+    // 空 vector 不分配空间，第一次插入元素时才分配
+    vector() noexcept
+        :begin_(nullptr), end_(nullptr), cap_(nullptr)
+    {
+    }
+
+    explicit vector(const allocator_type& alloc) noexcept
+        :alloc_base(alloc), begin_(nullptr), end_(nullptr), cap_(nullptr)
+    {
+    }
 
-    explicit vector(size_type n)
+    explicit vector(size_type n, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     {
         fill_init(n, value_type());
     }
 
-    vector(size_type n, const value_type& value)
+    vector(size_type n, const value_type& value, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     {
         fill_init(n, value);
     }
 
     template<class Iter, typename std::enable_if<mystl::is_input_iterator<Iter>::value, int>::type = 0>
-    vector(Iter first, Iter last)
+    vector(Iter first, Iter last, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     {
         MYSTL_DEBUG(!(last < first));
         range_init(first, last);
     }
 
     vector(const vector& rhs)
+        :alloc_base(data_alloc_traits::select_on_container_copy_construction(rhs.get_alloc()))
     {
         range_init(rhs.begin_, rhs.end_);
     }
 
-    vector(vector&& rhs) noexcept: begin_(rhs.begin_), end_(rhs.end_), cap_(rhs.cap_)
+    vector(const vector& rhs, const allocator_type& alloc)
+        :alloc_base(alloc)
+    {
+        range_init(rhs.begin_, rhs.end_);
+    }
+
+    vector(vector&& rhs) noexcept
+        :alloc_base(mystl::move(rhs.get_alloc())),
+         begin_(rhs.begin_), end_(rhs.end_), cap_(rhs.cap_)
     {
         rhs.begin_ = nullptr;
         rhs.end_ = nullptr;
         rhs.cap_ = nullptr;
     }
 
-    vector(std::initializer_list<value_type> ilist)
+    vector(std::initializer_list<value_type> ilist, const allocator_type& alloc = allocator_type())
+        :alloc_base(alloc)
     {
         range_init(ilist.begin(), ilist.end());
     }
@@ -110,7 +140,7 @@ public:
 
     vector& operator=(std::initializer_list<value_type> ilist)
     {
-        vector tmp(ilist.begin(), ilist.end());
+        vector tmp(ilist.begin(), ilist.end(), this->get_alloc());
         swap(tmp);
         return *this;
     }
@@ -159,12 +189,12 @@ public:
     }
     reference at(size_type n)
     {
-        THROW_OUT_OF_RANGE_IF(!(n < size()), "vector<T>::at() subscript out of range");
+        THROW_OUT_OF_RANGE_IF(!(n < size()), "vector<T, Alloc>::at() subscript out of range");
         return (*this)[n];
     }
     const_reference at(size_type n) const
     {
-        THROW_OUT_OF_RANGE_IF(!(n < size()), "vector<T>::at() subscript out of range");
+        THROW_OUT_OF_RANGE_IF(!(n < size()), "vector<T, Alloc>::at() subscript out of range");
         return (*this)[n];
     }
 
@@ -266,8 +296,6 @@ private:
     // helper functions
 
     // initialize / destroy
-    void try_init() noexcept;
-
     void init_space(size_type size, size_type cap);
 
     void fill_init(size_type n, const value_type& value);
@@ -279,6 +307,7 @@ private:
 
     // calculate the growth size
     size_type get_new_cap(size_type add_size);
+    static size_type init_cap() noexcept;
 
     // assign
     void fill_assign(size_type n, const value_type& value);
@@ -293,8 +322,14 @@ private:
     template<class... Args>
     void reallocate_emplace(iterator pos, Args&&... args);
     void reallocate_insert(iterator pos, const value_type& value);
+    void relocate_storage(iterator new_begin, iterator pos, iterator new_pos,
+                          size_type n, size_type new_cap) noexcept;
+    void move_storage(iterator new_begin, iterator pos, iterator new_pos,
+                      size_type n, size_type new_cap);
 
     // insert
+    void relocate_insert_aux(iterator pos, value_type&& value);
+
     iterator fill_insert(iterator pos, size_type n, const value_type& value);
     
     template<class InputIterator>
@@ -307,57 +342,87 @@ private:
 
 
 // 复制赋值操作符
-template <class T>
-vector<T>& vector<T>::operator=(const vector& rhs)
+template <class T, class Alloc>
+vector<T, Alloc>& vector<T, Alloc>::operator=(const vector& rhs)
 {
     if(this != &rhs){
+        // 需要传播分配器且两者不相等时，原有空间必须由原分配器释放
+        if(data_alloc_traits::propagate_on_container_copy_assignment::value &&
+           this->get_alloc() != rhs.get_alloc())
+        {
+            destroy_and_recover(begin_, end_, cap_ - begin_);
+            begin_ = end_ = cap_ = nullptr;
+        }
+        mystl::alloc_on_copy(this->get_alloc(), rhs.get_alloc());
         const auto len = rhs.size();
         if(len > capacity())
         {
-            vector tmp(rhs.begin(), rhs.end());
+            vector tmp(rhs.begin(), rhs.end(), this->get_alloc());
             swap(tmp);
         }
         else if(size() >= len)
         {
             auto it = mystl::copy(rhs.begin(), rhs.end(), begin_);
-            data_allocator::destroy(it, end_);
+            data_alloc_traits::destroy(this->get_alloc(), it, end_);
             end_ = begin_ + len;
         }
         else
         {
             mystl::copy(rhs.begin(), rhs.begin() + size(), begin_);
             mystl::uninitialized_copy(rhs.begin() + size(), rhs.end(), end_);
-            cap_ = end_ = begin_ + len;
+            end_ = begin_ + len;
         }
     }
     return *this;
 }
 
 // 移动赋值操作符
-template <class T>
-vector<T>& vector<T>::operator=(vector<T>&& rhs) noexcept
+template <class T, class Alloc>
+vector<T, Alloc>& vector<T, Alloc>::operator=(vector&& rhs) noexcept
 {
-    destroy_and_recover(begin_, end_, cap_ - begin_);
-    begin_ = rhs.begin_;
-    end_ = rhs.end_;
-    cap_ = rhs.cap_;
-    rhs.begin_ = nullptr;
-    rhs.end_ = nullptr;
-    rhs.cap_ = nullptr;
+    if(this == &rhs)return *this;
+    if(data_alloc_traits::propagate_on_container_move_assignment::value ||
+       this->get_alloc() == rhs.get_alloc())
+    {
+        destroy_and_recover(begin_, end_, cap_ - begin_);
+        mystl::alloc_on_move(this->get_alloc(), rhs.get_alloc());
+        begin_ = rhs.begin_;
+        end_ = rhs.end_;
+        cap_ = rhs.cap_;
+        rhs.begin_ = nullptr;
+        rhs.end_ = nullptr;
+        rhs.cap_ = nullptr;
+    }
+    else
+    {
+        // 分配器不相等且不传播时，不能接管 rhs 的空间，只能逐个移动元素
+        clear();
+        reserve(rhs.size());
+        end_ = mystl::uninitialized_move(rhs.begin_, rhs.end_, begin_);
+        rhs.clear();
+    }
     return *this;
 }
 
 // 预留空间大小，当原容量小于要求大小时，才会重新分配
-template <class T>
-void vector<T>::reserve(size_type n)
+template <class T, class Alloc>
+void vector<T, Alloc>::reserve(size_type n)
 {
     if(capacity() < n)
     {
-        THROW_OUT_OF_RANGE_IF(n > max_size(), "n can not larger than max_size() in vector<T>::reserve(n)");
+        THROW_OUT_OF_RANGE_IF(n > max_size(), "n can not larger than max_size() in vector<T, Alloc>::reserve(n)");
         const auto old_size = size();
-        auto tmp = data_allocator::allocate(n);
-        mystl::uninitialized_move(begin_, end_, tmp);
-        data_allocator::deallocate(begin_, cap_ - begin_);
+        auto tmp = data_alloc_traits::allocate(this->get_alloc(), n);
+        if(relocatable::value)
+        {
+            mystl::uninitialized_relocate(begin_, end_, tmp);
+            data_alloc_traits::deallocate(this->get_alloc(), begin_, cap_ - begin_);
+        }
+        else
+        {
+            mystl::uninitialized_move(begin_, end_, tmp);
+            destroy_and_recover(begin_, end_, cap_ - begin_);
+        }
         begin_ = tmp;
         end_ = begin_ + old_size;
         cap_ = begin_ + n;
@@ -365,8 +430,8 @@ void vector<T>::reserve(size_type n)
 }
 
 // 放弃多余的容量
-template <class T>
-void vector<T>::shrink_to_fit()
+template <class T, class Alloc>
+void vector<T, Alloc>::shrink_to_fit()
 {
     if(end_ < cap_)
     {
@@ -375,25 +440,32 @@ void vector<T>::shrink_to_fit()
 }
 
 // 在 pos 位置就地构造元素，避免额外的复制或移动开销
-template <class T>
+template <class T, class Alloc>
 template <class... Args>
-typename vector<T>::iterator vector<T>::emplace(const_iterator pos, Args&&... args)
+typename vector<T, Alloc>::iterator vector<T, Alloc>::emplace(const_iterator pos, Args&&... args)
 {
     MYSTL_DEBUG(pos >= begin_ && pos <= end_);
     iterator xpos = const_cast<iterator>(pos);
     const size_type n = xpos - begin_;
     if(end_ != cap_ && xpos == end_)
     {
-        data_allocator::construct(mystl::address_of(*end_), mystl::forward<Args>(args)...);
+        data_alloc_traits::construct(this->get_alloc(), mystl::address_of(*end_), mystl::forward<Args>(args)...);
         ++end_;
     }
+    else if(end_ != cap_ && relocatable::value)
+    {
+        // 先构造出新元素，args 可能引用容器内的元素
+        value_type tmp(mystl::forward<Args>(args)...);
+        relocate_insert_aux(xpos, mystl::move(tmp));
+    }
     else if(end_ != cap_)
     {
+        value_type tmp(mystl::forward<Args>(args)...);  // 同上
         auto new_end = end_;
-        data_allocator::construct(mystl::address_of(*end_), *(end_ - 1));
+        data_alloc_traits::construct(this->get_alloc(), mystl::address_of(*end_), mystl::move(*(end_ - 1)));
         ++new_end;
-        mystl::copy_backward(xpos, end_ - 1, end_);
-        *xpos = value_type(mystl::forward<Args>(args)...);
+        mystl::move_backward(xpos, end_ - 1, end_);
+        *xpos = mystl::move(tmp);
         end_ = new_end;
     }
     else
@@ -404,13 +476,13 @@ typename vector<T>::iterator vector<T>::emplace(const_iterator pos, Args&&... ar
 }
 
 // 在尾部就地构造元素，避免额外的复制或移动开销
-template <class T>
+template <class T, class Alloc>
 template <class... Args>
-void vector<T>::emplace_back(Args&&... args)
+void vector<T, Alloc>::emplace_back(Args&&... args)
 {
     if(end_ != cap_)
     {
-        data_allocator::construct(mystl::address_of(*end_), mystl::forward<Args>(args)...);
+        data_alloc_traits::construct(this->get_alloc(), mystl::address_of(*end_), mystl::forward<Args>(args)...);
         ++end_;
     }
     else
@@ -420,12 +492,12 @@ void vector<T>::emplace_back(Args&&... args)
 }
 
 // 在尾部插入元素
-template <class T>
-void vector<T>::push_back(const value_type& value)
+template <class T, class Alloc>
+void vector<T, Alloc>::push_back(const value_type& value)
 {
     if(end_ != cap_)
     {
-        data_allocator::construct(mystl::address_of(*end_), value);
+        data_alloc_traits::construct(this->get_alloc(), mystl::address_of(*end_), value);
         ++end_;
     }
     else
@@ -435,30 +507,35 @@ void vector<T>::push_back(const value_type& value)
 }
 
 // 弹出尾部元素
-template <class T>
-void vector<T>::pop_back()
+template <class T, class Alloc>
+void vector<T, Alloc>::pop_back()
 {
     MYSTL_DEBUG(!empty());
-    data_allocator::destroy(end_ - 1);
+    data_alloc_traits::destroy(this->get_alloc(), end_ - 1);
     --end_;
 }
 
 // 在 pos 处插入元素
-template <class T>
-typename vector<T>::iterator vector<T>::insert(const_iterator pos, const value_type& value)
+template <class T, class Alloc>
+typename vector<T, Alloc>::iterator vector<T, Alloc>::insert(const_iterator pos, const value_type& value)
 {
     MYSTL_DEBUG(pos >= begin_ && pos <= end_);
     iterator xpos = const_cast<iterator>(pos);
     const size_type n = pos - begin_;
     if(end_ != cap_ && xpos == end_)
     {
-        data_allocator::construct(mystl::address_of(*end_), value);
+        data_alloc_traits::construct(this->get_alloc(), mystl::address_of(*end_), value);
         ++end_;
     }
+    else if(end_ != cap_ && relocatable::value)
+    {
+        auto value_copy = value;
+        relocate_insert_aux(xpos, mystl::move(value_copy));
+    }
     else if(end_ != cap_)
     {
         auto new_end = end_;
-        data_allocator::construct(mystl::address_of(*end_), *(end_ - 1));
+        data_alloc_traits::construct(this->get_alloc(), mystl::address_of(*end_), *(end_ - 1));
         ++new_end;
         auto value_copy = value; // 避免元素因以下复制操作而被改变
         mystl::copy_backward(xpos, end_ - 1, end_);
@@ -473,33 +550,49 @@ typename vector<T>::iterator vector<T>::insert(const_iterator pos, const value_t
 }
 
 // 删除 pos 位置上的元素
-template <class T>
-typename vector<T>::iterator vector<T>::erase(const_iterator pos)
+template <class T, class Alloc>
+typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(const_iterator pos)
 {
     MYSTL_DEBUG(pos >= begin_ && pos <= end_);
     iterator xpos = const_cast<iterator>(pos);
-    mystl::move(xpos + 1, end_, xpos);
-    data_allocator::destroy(end_ - 1);
+    if(relocatable::value)
+    {
+        data_alloc_traits::destroy(this->get_alloc(), xpos);
+        mystl::uninitialized_relocate(xpos + 1, end_, xpos);
+    }
+    else
+    {
+        mystl::move(xpos + 1, end_, xpos);
+        data_alloc_traits::destroy(this->get_alloc(), end_ - 1);
+    }
     --end_;
     return xpos;
 }
 
 // 删除[first, last)上的元素
-template <class T>
-typename vector<T>::iterator vector<T>::erase(const_iterator first, const_iterator last)
+template <class T, class Alloc>
+typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(const_iterator first, const_iterator last)
 {
     MYSTL_DEBUG(first >= begin_ && last <= end_ && !(first > last));
     const auto n = first - begin_;
     iterator r = begin_ + (first - begin_);
     // iterator r = const_cast<iterator>(first);
-    data_allocator::destroy(mystl::move(r + (last - first), end_, r), end_);
+    if(relocatable::value)
+    {
+        data_alloc_traits::destroy(this->get_alloc(), r, r + (last - first));
+        mystl::uninitialized_relocate(r + (last - first), end_, r);
+    }
+    else
+    {
+        data_alloc_traits::destroy(this->get_alloc(), mystl::move(r + (last - first), end_, r), end_);
+    }
     end_ = end_ - (last - first);
     return begin_ + n;
 }
 
 // 重置容器大小
-template <class T>
-void vector<T>::resize(size_type new_size, const value_type& value)
+template <class T, class Alloc>
+void vector<T, Alloc>::resize(size_type new_size, const value_type& value)
 {
     if(new_size < size())
     {
@@ -512,14 +605,15 @@ void vector<T>::resize(size_type new_size, const value_type& value)
 }
 
 // 与另一个 vector 交换
-template <class T>
-void vector<T>::swap(vector<T>& rhs) noexcept
+template <class T, class Alloc>
+void vector<T, Alloc>::swap(vector<T, Alloc>& rhs) noexcept
 {
     if(this != &rhs)
     {
         mystl::swap(begin_, rhs.begin_);
         mystl::swap(end_, rhs.end_);
         mystl::swap(cap_, rhs.cap_);
+        mystl::alloc_on_swap(this->get_alloc(), rhs.get_alloc());
     }
 }
 
@@ -527,32 +621,18 @@ void vector<T>::swap(vector<T>& rhs) noexcept
 /*****************************************************************************************/
 // helper function
 
-// try_init 函数，若分配失败则忽略，不抛出异常
-template <class T>
-void vector<T>::try_init() noexcept
+// init_space 函数，cap 为 0 时不分配空间
+template <class T, class Alloc>
+void vector<T, Alloc>::init_space(size_type size, size_type cap)
 {
-    try
-    {
-        begin_ = data_allocator::allocate(16);
-        end_ = begin_;
-        cap_ = begin_ + 16;
-    }
-    catch(...)
+    if(cap == 0)
     {
-        // data_allocator::deallocate(begin_);
-        begin_ = nullptr;
-        end_ = nullptr;
-        cap_ = nullptr;
+        begin_ = end_ = cap_ = nullptr;
+        return;
     }
-}
-
-// init_space 函数
-template <class T>
-void vector<T>::init_space(size_type size, size_type cap)
-{
     try
     {
-        begin_ = data_allocator::allocate(cap);
+        begin_ = data_alloc_traits::allocate(this->get_alloc(), cap);
         end_ = begin_ + size;
         cap_ = begin_ + cap;
     }
@@ -565,56 +645,62 @@ void vector<T>::init_space(size_type size, size_type cap)
     }
 }
 
-// fill_init 函数
-template <class T>
-void vector<T>::fill_init(size_type n, const value_type& value)
+// fill_init 函数，按元素个数精确分配
+template <class T, class Alloc>
+void vector<T, Alloc>::fill_init(size_type n, const value_type& value)
 {
-    const size_type init_size = mystl::max(static_cast<size_type>(16), n);
-    init_space(n, init_size);
+    init_space(n, n);
     mystl::uninitialized_fill_n(begin_, n, value);
 }
 
 // range_init 函数
-template <class T>
+template <class T, class Alloc>
 template <class Iterator>
-void vector<T>::range_init(Iterator first, Iterator last)
+void vector<T, Alloc>::range_init(Iterator first, Iterator last)
 {
     const size_type len = mystl::distance(first, last);
-    const size_type init_size = mystl::max(static_cast<size_type>(16), len);
-    init_space(len, init_size);
+    init_space(len, len);
     mystl::uninitialized_copy(first, last, begin_);
 }
 
 // destroy_and_recover 函数
-template <class T>
-void vector<T>::destroy_and_recover(iterator first, iterator last, size_type n)
+template <class T, class Alloc>
+void vector<T, Alloc>::destroy_and_recover(iterator first, iterator last, size_type n)
 {
-    data_allocator::destroy(first, last);
-    data_allocator::deallocate(first, n);
+    data_alloc_traits::destroy(this->get_alloc(), first, last);
+    data_alloc_traits::deallocate(this->get_alloc(), first, n);
 }
 
 // get_new_cap 函数
-template <class T>
-typename vector<T>::size_type vector<T>::get_new_cap(size_type add_size)
+template <class T, class Alloc>
+typename vector<T, Alloc>::size_type vector<T, Alloc>::get_new_cap(size_type add_size)
 {
     const auto old_size = capacity();
-    THROW_LENGTH_ERROR_IF(old_size > max_size() - add_size, "vector<T>'s size too big");
+    THROW_LENGTH_ERROR_IF(old_size > max_size() - add_size, "vector<T, Alloc>'s size too big");
     if(old_size > max_size() - old_size / 2)
     {
         return old_size + add_size > max_size() - 16 ? old_size + add_size : old_size + add_size + 16;
     }
-    const size_type new_size = old_size == 0 ? mystl::max(add_size, static_cast<size_type>(16))
+    const size_type new_size = old_size == 0 ? mystl::max(add_size, init_cap())
     : mystl::max(old_size + old_size / 2, old_size + add_size);
     return new_size;
 }
 
+// init_cap 函数，空 vector 第一次扩容时的最小容量
+// 约为 64 字节能容纳的元素个数，至少 1 个，至多 16 个
+template <class T, class Alloc>
+typename vector<T, Alloc>::size_type vector<T, Alloc>::init_cap() noexcept
+{
+    return sizeof(T) >= 64 ? 1 : mystl::min(static_cast<size_type>(16), 64 / sizeof(T));
+}
+
 // fill_assign 函数
-template <class T>
-void vector<T>::fill_assign(size_type n, const value_type& value)
+template <class T, class Alloc>
+void vector<T, Alloc>::fill_assign(size_type n, const value_type& value)
 {
     if(n > capacity())
     {
-        vector tmp(n, value);
+        vector tmp(n, value, this->get_alloc());
         swap(tmp);
     }
     else if(n > size())
@@ -629,9 +715,9 @@ void vector<T>::fill_assign(size_type n, const value_type& value)
 }
 
 // copy_assign 函数
-template <class T>
+template <class T, class Alloc>
 template <class InputIterator>
-void vector<T>::copy_assign(InputIterator first, InputIterator last, input_iterator_tag)
+void vector<T, Alloc>::copy_assign(InputIterator first, InputIterator last, input_iterator_tag)
 {
     auto cur = begin_;
     for(; first != last && cur != end_; ++first, ++cur)
@@ -649,20 +735,20 @@ void vector<T>::copy_assign(InputIterator first, InputIterator last, input_itera
 }
 
 // 用 [first, last) 为容器赋值
-template <class T>
+template <class T, class Alloc>
 template <class ForwardIterator>
-void vector<T>::copy_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+void vector<T, Alloc>::copy_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
 {
     const size_type len = mystl::distance(first, last);
     if(len > capacity())
     {
-        vector tmp(first, last);
+        vector tmp(first, last, this->get_alloc());
         swap(tmp);
     }
     else if(size() >= len)
     {
         auto new_end = mystl::copy(first, last, begin_);
-        data_allocator::destroy(new_end, end_);
+        data_alloc_traits::destroy(this->get_alloc(), new_end, end_);
         end_ = new_end;
     }
     else
@@ -676,65 +762,161 @@ void vector<T>::copy_assign(ForwardIterator first, ForwardIterator last, forward
 }
 
 // 重新分配空间并在 pos 处就地构造元素
-template <class T>
+template <class T, class Alloc>
 template <class... Args>
-void vector<T>::reallocate_emplace(iterator pos, Args&&... args)
+void vector<T, Alloc>::reallocate_emplace(iterator pos, Args&&... args)
 {
     const auto new_size = get_new_cap(1);
-    auto new_begin = data_allocator::allocate(new_size);
-    auto new_end = new_begin;
+    auto new_begin = data_alloc_traits::allocate(this->get_alloc(), new_size);
+    // 先构造新元素，再搬动原有元素，args 引用容器中的元素时也不会读到被移动后的值
+    auto new_pos = new_begin + (pos - begin_);
     try
     {
-        new_end = mystl::uninitialized_move(begin_, pos, new_begin);
-        data_allocator::construct(mystl::address_of(*new_end), mystl::forward<Args>(args)...);
-        ++new_end;
-        new_end = mystl::uninitialized_move(pos, end_, new_end);
+        data_alloc_traits::construct(this->get_alloc(), new_pos, mystl::forward<Args>(args)...);
     }
     catch(...)
     {
-        data_allocator::deallocate(new_begin, new_size);
+        data_alloc_traits::deallocate(this->get_alloc(), new_begin, new_size);
         throw;
     }
-    destroy_and_recover(begin_, end_, cap_ - begin_);
-    begin_ = new_begin;
-    end_ = new_end;
-    cap_ = new_begin + new_size;
+    if(relocatable::value)
+        relocate_storage(new_begin, pos, new_pos, 1, new_size);
+    else
+        move_storage(new_begin, pos, new_pos, 1, new_size);
 }
 
 // 重新分配空间并在 pos 处插入元素
-template <class T>
-void vector<T>::reallocate_insert(iterator pos, const value_type& value)
+template <class T, class Alloc>
+void vector<T, Alloc>::reallocate_insert(iterator pos, const value_type& value)
 {
     const auto new_size = get_new_cap(1);
-    auto new_begin = data_allocator::allocate(new_size);
-    auto new_end = new_begin;
-    const value_type& value_copy = value;
+    auto new_begin = data_alloc_traits::allocate(this->get_alloc(), new_size);
+    // 与 reallocate_emplace 相同，先构造新元素，value 可以引用容器中的元素
+    auto new_pos = new_begin + (pos - begin_);
     try
     {
-        new_end = mystl::uninitialized_move(begin_, pos, new_begin);
-        data_allocator::construct(mystl::address_of(*new_end), value_copy);
-        ++new_end;
-        new_end = mystl::uninitialized_move(pos, end_, new_end);
+        data_alloc_traits::construct(this->get_alloc(), new_pos, value);
     }
     catch(...)
     {
-        data_allocator::deallocate(new_begin, new_size);
+        data_alloc_traits::deallocate(this->get_alloc(), new_begin, new_size);
         throw;
     }
-    destroy_and_recover(begin_, end_, cap_ - begin_);
+    if(relocatable::value)
+        relocate_storage(new_begin, pos, new_pos, 1, new_size);
+    else
+        move_storage(new_begin, pos, new_pos, 1, new_size);
+}
+
+// relocate_storage 函数
+// 新空间的 [new_pos, new_pos + n) 上已经构造好插入的元素，把原有元素以 pos 为界搬到它的两侧，
+// 然后释放原空间。只用于可平凡重定位的元素，原空间上的元素不再析构
+template <class T, class Alloc>
+void vector<T, Alloc>::relocate_storage(iterator new_begin, iterator pos, iterator new_pos,
+                                        size_type n, size_type new_cap) noexcept
+{
+    mystl::uninitialized_relocate(begin_, pos, new_begin);
+    auto new_end = mystl::uninitialized_relocate(pos, end_, new_pos + n);
+    data_alloc_traits::deallocate(this->get_alloc(), begin_, cap_ - begin_);
     begin_ = new_begin;
     end_ = new_end;
-    cap_ = new_begin + new_size;
+    cap_ = new_begin + new_cap;
+}
+
+// move_storage 函数
+// 与 relocate_storage 相同，但用于不可平凡重定位的元素：逐个移动构造原有元素，移动可能抛出异常且元素可以复制时改为复制。
+// 失败时析构新空间上已构造的元素（包括插入的元素）并释放新空间，原有元素保持不变
+template <class T, class Alloc>
+void vector<T, Alloc>::move_storage(iterator new_begin, iterator pos, iterator new_pos,
+                                    size_type n, size_type new_cap)
+{
+    auto cur = new_begin;
+    try
+    {
+        for(auto p = begin_; p != pos; ++p, ++cur)
+            data_alloc_traits::construct(this->get_alloc(), cur, std::move_if_noexcept(*p));
+        cur = new_pos + n;
+        for(auto p = pos; p != end_; ++p, ++cur)
+            data_alloc_traits::construct(this->get_alloc(), cur, std::move_if_noexcept(*p));
+    }
+    catch(...)
+    {
+        if(cur <= new_pos)
+        {   // 失败在 pos 之前的部分，插入的元素与已构造的部分不相连
+            data_alloc_traits::destroy(this->get_alloc(), new_begin, cur);
+            data_alloc_traits::destroy(this->get_alloc(), new_pos, new_pos + n);
+        }
+        else
+        {
+            data_alloc_traits::destroy(this->get_alloc(), new_begin, cur);
+        }
+        data_alloc_traits::deallocate(this->get_alloc(), new_begin, new_cap);
+        throw;
+    }
+    destroy_and_recover(begin_, end_, cap_ - begin_);
+    begin_ = new_begin;
+    end_ = cur;
+    cap_ = new_begin + new_cap;
+}
+
+// relocate_insert_aux 函数
+// 容量足够时，把 [pos, end_) 整体后移一位，再在 pos 处构造 value，构造失败时把元素搬回原位
+template <class T, class Alloc>
+void vector<T, Alloc>::relocate_insert_aux(iterator pos, value_type&& value)
+{
+    mystl::uninitialized_relocate(pos, end_, pos + 1);
+    try
+    {
+        data_alloc_traits::construct(this->get_alloc(), pos, mystl::move(value));
+    }
+    catch(...)
+    {
+        mystl::uninitialized_relocate(pos + 1, end_ + 1, pos);
+        throw;
+    }
+    ++end_;
 }
 
 // fill_insert 函数
-template <class T>
-typename vector<T>::iterator vector<T>::fill_insert(iterator pos, size_type n, const value_type& value)
+template <class T, class Alloc>
+typename vector<T, Alloc>::iterator vector<T, Alloc>::fill_insert(iterator pos, size_type n, const value_type& value)
 {
     if(n == 0)return pos;
     const size_type xpos = pos - begin_;
     const value_type value_copy = value;
-    if(static_cast<size_type>(cap_ - end_) >= n)
+    if(relocatable::value)
+    {
+        if(static_cast<size_type>(cap_ - end_) >= n)
+        {
+            mystl::uninitialized_relocate(pos, end_, pos + n);
+            try
+            {
+                mystl::uninitialized_fill_n(pos, n, value_copy);
+            }
+            catch(...)
+            {
+                mystl::uninitialized_relocate(pos + n, end_ + n, pos);
+                throw;
+            }
+            end_ += n;
+        }
+        else
+        {
+            const auto new_size = get_new_cap(n);
+            auto new_begin = data_alloc_traits::allocate(this->get_alloc(), new_size);
+            try
+            {
+                mystl::uninitialized_fill_n(new_begin + xpos, n, value_copy);
+            }
+            catch(...)
+            {
+                data_alloc_traits::deallocate(this->get_alloc(), new_begin, new_size);
+                throw;
+            }
+            relocate_storage(new_begin, pos, new_begin + xpos, n, new_size);
+        }
+    }
+    else if(static_cast<size_type>(cap_ - end_) >= n)
     {
         const size_type after_elems = end_ - pos;
         auto old_end = end_;
@@ -743,19 +925,19 @@ typename vector<T>::iterator vector<T>::fill_insert(iterator pos, size_type n, c
             mystl::uninitialized_copy(end_ - n, end_, end_);
             end_ += n;
             mystl::move_backward(pos, old_end - n, old_end);
-            mystl::uninitialized_fill_n(pos, n, value_copy);
+            mystl::fill_n(pos, n, value_copy);
         }
         else
         {
             end_ = mystl::uninitialized_fill_n(end_, n - after_elems, value_copy);
             end_ = mystl::uninitialized_move(pos, old_end, end_);
-            mystl::uninitialized_fill_n(pos, after_elems, value_copy);
+            mystl::fill_n(pos, after_elems, value_copy);
         }
     }
     else
     {
         const auto new_size = get_new_cap(n);
-        auto new_begin = data_allocator::allocate(new_size);
+        auto new_begin = data_alloc_traits::allocate(this->get_alloc(), new_size);
         auto new_end = new_begin;
         try
         {
@@ -768,7 +950,7 @@ typename vector<T>::iterator vector<T>::fill_insert(iterator pos, size_type n, c
             destroy_and_recover(new_begin, new_end, new_size);
             throw;
         }
-        data_allocator::deallocate(begin_, cap_ - begin_);
+        destroy_and_recover(begin_, end_, cap_ - begin_);
         begin_ = new_begin;
         end_ = new_end;
         cap_ = begin_ + new_size;
@@ -777,13 +959,46 @@ typename vector<T>::iterator vector<T>::fill_insert(iterator pos, size_type n, c
 }
 
 // copy_insert 函数
-template <class T>
+template <class T, class Alloc>
 template <class InputIterator>
-void vector<T>::copy_insert(iterator pos, InputIterator first, InputIterator last)
+void vector<T, Alloc>::copy_insert(iterator pos, InputIterator first, InputIterator last)
 {
     if(first == last)return;
-    const auto n = mystl::distance(first, last);
-    if(static_cast<size_type>(cap_ - end_) >= n)
+    const size_type n = static_cast<size_type>(mystl::distance(first, last));
+    if(relocatable::value)
+    {
+        if(static_cast<size_type>(cap_ - end_) >= n)
+        {
+            mystl::uninitialized_relocate(pos, end_, pos + n);
+            try
+            {
+                mystl::uninitialized_copy(first, last, pos);
+            }
+            catch(...)
+            {
+                mystl::uninitialized_relocate(pos + n, end_ + n, pos);
+                throw;
+            }
+            end_ += n;
+        }
+        else
+        {
+            const auto new_size = get_new_cap(n);
+            auto new_begin = data_alloc_traits::allocate(this->get_alloc(), new_size);
+            auto new_pos = new_begin + (pos - begin_);
+            try
+            {
+                mystl::uninitialized_copy(first, last, new_pos);
+            }
+            catch(...)
+            {
+                data_alloc_traits::deallocate(this->get_alloc(), new_begin, new_size);
+                throw;
+            }
+            relocate_storage(new_begin, pos, new_pos, n, new_size);
+        }
+    }
+    else if(static_cast<size_type>(cap_ - end_) >= n)
     {
         const size_type after_elems = end_ - pos;
         auto old_end = end_;
@@ -792,7 +1007,7 @@ void vector<T>::copy_insert(iterator pos, InputIterator first, InputIterator las
             mystl::uninitialized_copy(end_ - n, end_, end_);
             end_ += n;
             mystl::move_backward(pos, old_end - n, old_end);
-            mystl::uninitialized_copy(first, last, pos);
+            mystl::copy(first, last, pos);
         }
         else
         {
@@ -800,13 +1015,13 @@ void vector<T>::copy_insert(iterator pos, InputIterator first, InputIterator las
             mystl::advance(mid, after_elems);
             end_ = mystl::uninitialized_copy(mid, last, end_);
             end_ = mystl::uninitialized_move(pos, old_end, end_);
-            mystl::uninitialized_copy(first, mid, pos);
+            mystl::copy(first, mid, pos);
         }
     }
     else
     {
         const auto new_size = get_new_cap(n);
-        auto new_begin = data_allocator::allocate(new_size);
+        auto new_begin = data_alloc_traits::allocate(this->get_alloc(), new_size);
         auto new_end = new_begin;
         try
         {
@@ -819,7 +1034,7 @@ void vector<T>::copy_insert(iterator pos, InputIterator first, InputIterator las
             destroy_and_recover(new_begin, new_end, new_size);
             throw;
         }
-        data_allocator::deallocate(begin_, cap_ - begin_);
+        destroy_and_recover(begin_, end_, cap_ - begin_);
         begin_ = new_begin;
         end_ = new_end;
         cap_ = begin_ + new_size;
@@ -827,20 +1042,34 @@ void vector<T>::copy_insert(iterator pos, InputIterator first, InputIterator las
 }
 
 // reinsert 函数
-template <class T>
-void vector<T>::reinsert(size_type size)
+template <class T, class Alloc>
+void vector<T, Alloc>::reinsert(size_type size)
 {
-    auto new_begin = data_allocator::allocate(size);
-    try
+    if(size == 0)
     {
-        mystl::uninitialized_move(begin_, end_, new_begin);
+        data_alloc_traits::deallocate(this->get_alloc(), begin_, cap_ - begin_);
+        begin_ = end_ = cap_ = nullptr;
+        return;
     }
-    catch(...)
+    auto new_begin = data_alloc_traits::allocate(this->get_alloc(), size);
+    if(relocatable::value)
     {
-        data_allocator::deallocate(new_begin, size);
-        throw;
+        mystl::uninitialized_relocate(begin_, end_, new_begin);
+        data_alloc_traits::deallocate(this->get_alloc(), begin_, cap_ - begin_);
+    }
+    else
+    {
+        try
+        {
+            mystl::uninitialized_move(begin_, end_, new_begin);
+        }
+        catch(...)
+        {
+            data_alloc_traits::deallocate(this->get_alloc(), new_begin, size);
+            throw;
+        }
+        destroy_and_recover(begin_, end_, cap_ - begin_);
     }
-    data_allocator::deallocate(begin_, cap_ - begin_);
     begin_ = new_begin;
     end_ = begin_ + size;
     cap_ = begin_ + size;
@@ -848,49 +1077,62 @@ void vector<T>::reinsert(size_type size)
 
 
 // 重载比较操作符
-template <class T>
-bool operator==(const vector<T>& lhs, const vector<T>& rhs)
+template <class T, class Alloc>
+bool operator==(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
 {
     return lhs.size() == rhs.size() && mystl::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class T>
-bool operator<(const vector<T>& lhs, const vector<T>& rhs)
+template <class T, class Alloc>
+bool operator<(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
 {
     return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class T>
-bool operator!=(const vector<T>& lhs, const vector<T>& rhs)
+template <class T, class Alloc>
+bool operator!=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
 {
     return !(lhs == rhs);
 }
 
-template <class T>
-bool operator>(const vector<T>& lhs, const vector<T>& rhs)
+template <class T, class Alloc>
+bool operator>(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
 {
     return rhs < lhs;
 }
 
-template <class T>
-bool operator<=(const vector<T>& lhs, const vector<T>& rhs)
+template <class T, class Alloc>
+bool operator<=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
 {
     return !(rhs < lhs);
 }
 
-template <class T>
-bool operator>=(const vector<T>& lhs, const vector<T>& rhs)
+template <class T, class Alloc>
+bool operator>=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
 {
     return !(lhs < rhs);
 }
 
 // 重载 mystl 的 swap
-template <class T>
-void swap(vector<T>& lhs, vector<T>& rhs)
+template <class T, class Alloc>
+void swap(vector<T, Alloc>& lhs, vector<T, Alloc>& rhs)
 {
     lhs.swap(rhs);
 }
 
+// vector 只保存指向元素空间的指针，搬移 vector 对象本身不影响其中的元素
+template <class T, class Alloc>
+struct is_trivially_relocatable<vector<T, Alloc>> : is_trivially_relocatable<Alloc> {};
+
+// 使用 pmr::polymorphic_allocator 的 vector，需要包含 memory_resource.h
+namespace pmr
+{
+template <typename T> class polymorphic_allocator;
+
+template <typename T>
+using vector = mystl::vector<T, polymorphic_allocator<T>>;
+} // namespace pmr
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+#ifndef MYTINYSTL_ALGORITHM_TEST_H_
+#define MYTINYSTL_ALGORITHM_TEST_H_
+
+// algorithm test : 测试 stable_sort, stable_partition 的结果与性能，并与 sort 对比，
+//                  以及 sort 在随机、有序、逆序、大量重复的输入下的性能
+
+#include <algorithm>
+#include <memory>
+
+#include "../mytinystl/algo.h"
+#include "../mytinystl/vector.h"
+#include "../mytinystl/astring.h"
+#include "test.h"
+
+namespace mystl
+{
+
+namespace test
+{
+
+namespace algorithm_test
+{
+
+bool is_even(int x) { return x % 2 == 0; }
+
+// 只比较十位，十位相同的元素视为相等，用于观察排序是否稳定
+bool tens_less(int a, int b) { return a / 10 < b / 10; }
+
+bool ptr_tens_less(const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a / 10 < *b / 10; }
+
+// 只能移动的元素：stable_sort 与 inplace_merge 在区间与缓冲区之间只移动元素，结果与 std::stable_sort 一致
+void move_only_sort_test()
+{
+    const int n = 100;
+    std::unique_ptr<int> up[n];
+    int ref[n];
+    for (int i = 0; i < n; ++i)
+    {
+        ref[i] = i * 37 % n;
+        up[i].reset(new int(ref[i]));
+    }
+    mystl::stable_sort(up, up + n, ptr_tens_less);
+    std::stable_sort(ref, ref + n, tens_less);
+    bool same = true;
+    for (int i = 0; i < n; ++i)
+        same = same && up[i] && *up[i] == ref[i];
+    EXPECT_TRUE(same);
+    for (int i = 0; i < n; ++i)
+        *up[i] = ref[i] = (i < n / 2 ? 2 * i : 2 * (i - n / 2) + 1);
+    mystl::inplace_merge(up, up + n / 2, up + n, ptr_tens_less);
+    std::inplace_merge(ref, ref + n / 2, ref + n, tens_less);
+    same = true;
+    for (int i = 0; i < n; ++i)
+        same = same && up[i] && *up[i] == ref[i];
+    EXPECT_TRUE(same);
+    mystl::stable_sort(up, up + n);
+    EXPECT_TRUE(std::is_sorted(up, up + n));
+}
+
+// 对 sort_input 生成的各种输入（随机、有序、逆序、大量重复、基本有序）检查排序结果
+void sort_result_test()
+{
+    bool sorted = true;
+    bool stable_sorted = true;
+    bool inplace_sorted = true;
+    for (int pattern = 0; pattern <= 4; ++pattern)
+    {
+        std::vector<int> v(10000);
+        sort_input(v, pattern);
+        std::vector<int> w(v);
+        std::vector<int> u(v);
+        mystl::sort(v.data(), v.data() + v.size());
+        mystl::stable_sort(w.data(), w.data() + w.size());
+        mystl::inplace_stable_sort(u.data(), u.data() + u.size());
+        sorted = sorted && std::is_sorted(v.begin(), v.end());
+        stable_sorted = stable_sorted && std::is_sorted(w.begin(), w.end());
+        inplace_sorted = inplace_sorted && std::is_sorted(u.begin(), u.end());
+    }
+    EXPECT_TRUE(sorted);
+    EXPECT_TRUE(stable_sorted);
+    EXPECT_TRUE(inplace_sorted);
+}
+
+void sort_test()
+{
+    std::cout << "[===============================================================]" << std::endl;
+    std::cout << "[------------------ Run algorithm test : sort ------------------]" << std::endl;
+    std::cout << "[-------------------------- API test ---------------------------]" << std::endl;
+    int a[] = {31, 12, 35, 17, 33, 14, 26, 12};
+    mystl::vector<int> v1(a, a + 8);
+    mystl::vector<int> v2(a, a + 8);
+    mystl::vector<int> v3(a, a + 8);
+    mystl::vector<int> v4(a, a + 8);
+    mystl::vector<int> v5;
+    mystl::vector<int> v6(a, a + 8);
+    mystl::vector<mystl::string> v7{"pear", "apple", "fig", "banana", "cherry"};
+    FUN_AFTER(v1, mystl::stable_sort(v1.begin(), v1.end()));
+    FUN_AFTER(v1, mystl::stable_sort(v1.begin(), v1.end(), mystl::greater<int>()));
+    FUN_AFTER(v2, mystl::stable_sort(v2.begin(), v2.end(), tens_less));
+    FUN_AFTER(v3, mystl::inplace_stable_sort(v3.begin(), v3.end(), tens_less));
+    FUN_AFTER(v4, mystl::stable_partition(v4.begin(), v4.end(), is_even));
+    FUN_VALUE(*mystl::stable_partition(v4.begin(), v4.end(), is_even));
+    FUN_AFTER(v5, mystl::stable_sort(v5.begin(), v5.end()));
+    FUN_AFTER(v6, mystl::nth_element(v6.begin(), v6.begin() + 3, v6.end()));
+    FUN_VALUE(v6[3]);
+    FUN_AFTER(v6, mystl::partial_sort(v6.begin(), v6.begin() + 3, v6.end(), mystl::greater<int>()));
+    FUN_AFTER(v6, mystl::sort(v6.begin(), v6.end()));
+    FUN_AFTER(v7, mystl::sort(v7.begin(), v7.end()));
+    FUN_AFTER(v7, mystl::sort(v7.begin(), v7.end(), mystl::greater<mystl::string>()));
+    move_only_sort_test();
+    sort_result_test();
+    PASSED;
+#if PERFORMANCE_TEST_ON
+    std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|    sort (random)    |";
+#if LARGER_TEST_DATA_ON
+    SORT_TEST(SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    SORT_TEST(SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|   sort (sorted)     |";
+#if LARGER_TEST_DATA_ON
+    SORT_PATTERN_TEST(1, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    SORT_PATTERN_TEST(1, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|   sort (reversed)   |";
+#if LARGER_TEST_DATA_ON
+    SORT_PATTERN_TEST(2, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    SORT_PATTERN_TEST(2, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  sort (few unique)  |";
+#if LARGER_TEST_DATA_ON
+    SORT_PATTERN_TEST(3, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    SORT_PATTERN_TEST(3, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  stable_partition   |";
+#if LARGER_TEST_DATA_ON
+    PARTITION_TEST(SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    PARTITION_TEST(SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    PASSED;
+#endif
+    std::cout << "[------------------ End algorithm test : sort ------------------]" << std::endl;
+}
+
+} // namespace algorithm_test
+
+} // namespace test
+
+} // namespace mystl
+
+#endif // !MYTINYSTL_ALGORITHM_TEST_H_
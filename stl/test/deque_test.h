@@ -1,11 +1,16 @@
 #ifndef MYTINYSTL_DEQUE_TEST_H_
 #define MYTINYSTL_DEQUE_TEST_H_
 
-// deque test : 测试 deque 的接口和 push_front/push_back 的性能
+// deque test : 测试 deque 的接口和 push_front/push_back 的性能，作为队列使用时的性能与分配次数，
+//              以及 copy / fill / accumulate 在 deque 上的性能
 
 #include <deque>
+#include <numeric>
+#include <string>
 
+#include "../mytinystl/algo.h"
 #include "../mytinystl/deque.h"
+#include "../mytinystl/numeric.h"
 #include "test.h"
 
 namespace mystl
@@ -36,6 +41,8 @@ void deque_test()
     mystl::deque<int> d9{1, 2, 3, 4, 5, 6, 7, 8, 9};
     mystl::deque<int> d10;
     d10 = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    mystl::deque<int, mystl::allocator<int>, 4> d11(a, a + 5);
+    mystl::deque<int, mystl::allocator<int>, 4> d12{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
 
     FUN_AFTER(d1, d1.assign(5, 1));
     FUN_AFTER(d1, d1.assign(8, 8));
@@ -72,6 +79,50 @@ void deque_test()
     std::cout << std::noboolalpha;
     FUN_VALUE(d1.size());
     FUN_VALUE(d1.max_size());
+    FUN_VALUE(d11.buffer_size);
+    FUN_AFTER(d11, d11.push_back(6));
+    FUN_AFTER(d11, d11.push_front(0));
+    FUN_AFTER(d11, d11.pop_front());
+    FUN_AFTER(d11, d11.pop_front());
+    FUN_AFTER(d11, d11.insert(d11.begin() + 2, 4, 9));
+    FUN_AFTER(d11, d11.erase(d11.begin() + 1, d11.end() - 1));
+    FUN_AFTER(d11, d11.shrink_to_fit());
+    // 元素需要析构时，跨越多个缓冲区的区间删除与缩小 resize 要逐个缓冲区析构
+    mystl::deque<std::string, mystl::allocator<std::string>, 4> d13;
+    std::deque<std::string> sd;
+    for (int i = 0; i < 400; ++i)
+    {
+        d13.push_back(std::string(24, 'x') + std::to_string(i));
+        sd.push_back(std::string(24, 'x') + std::to_string(i));
+    }
+    auto same_as_std = [&]() {
+        if (d13.size() != sd.size())
+            return false;
+        for (size_t i = 0; i < sd.size(); ++i)
+            if (d13[i] != sd[i])
+                return false;
+        return true;
+    };
+    d13.erase(d13.begin() + 300, d13.begin() + 390);
+    sd.erase(sd.begin() + 300, sd.begin() + 390);
+    EXPECT_TRUE(same_as_std());
+    d13.erase(d13.begin() + 3, d13.begin() + 101);
+    sd.erase(sd.begin() + 3, sd.begin() + 101);
+    EXPECT_TRUE(same_as_std());
+    d13.resize(37);
+    sd.resize(37);
+    EXPECT_TRUE(same_as_std());
+    d13.resize(50, "tail");
+    sd.resize(50, "tail");
+    d13.resize(1);
+    sd.resize(1);
+    EXPECT_TRUE(same_as_std());
+    FUN_VALUE(*mystl::find(d12.begin(), d12.end(), 7));
+    FUN_VALUE(mystl::find(d12.begin(), d12.end(), 11) - d12.begin());
+    FUN_VALUE(mystl::accumulate(d12.begin() + 1, d12.end() - 1, 0));
+    FUN_AFTER(d12, mystl::copy(d12.begin() + 3, d12.end(), d12.begin()));
+    FUN_AFTER(d12, mystl::copy(a, a + 5, d12.begin() + 2));
+    FUN_AFTER(d12, mystl::fill(d12.begin() + 1, d12.end() - 1, 0));
     PASSED;
 #if PERFORMANCE_TEST_ON
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
@@ -90,6 +141,26 @@ void deque_test()
 #else
     CON_TEST_P1(deque<int>, push_back, rand(), SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  push_back+pop_front|";
+#if LARGER_TEST_DATA_ON
+    DEQUE_FIFO_TEST(SCALE_LL(LEN1), SCALE_LL(LEN2), SCALE_LL(LEN3));
+#else
+    DEQUE_FIFO_TEST(SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|     copy (x100)     |";
+    DEQUE_ALGO_TEST(DEQUE_COPY, LEN1, LEN2, LEN3);
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|     fill (x100)     |";
+    DEQUE_ALGO_TEST(DEQUE_FILL, LEN1, LEN2, LEN3);
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  accumulate (x100)  |";
+    DEQUE_ALGO_TEST(DEQUE_ACCUMULATE, LEN1, LEN2, LEN3);
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     PASSED;
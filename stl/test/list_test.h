@@ -1,11 +1,13 @@
 #ifndef MYTINYSTL_LIST_TEST_H_
 #define MYTINYSTL_LIST_TEST_H_
 
-// list test : 测试 list 的接口与 insert, sort 的性能
+// list test : 测试 list 的接口与 insert, sort 的性能，以及使用 pool_allocator 时 insert 的性能
 
+#include <algorithm>
 #include <list>
 
 #include "../mytinystl/list.h"
+#include "../mytinystl/pool_allocator.h"
 #include "test.h"
 
 namespace mystl
@@ -19,6 +21,28 @@ namespace list_test
 
 bool is_odd(int x) { return x & 1; }
 
+// 对 sort_input 生成的各种输入检查 sort 与 pointer_sort 的结果，并与 std::stable_sort 比较以检查稳定性
+void list_sort_result_test()
+{
+    bool sort_ok = true;
+    bool pointer_sort_ok = true;
+    auto tens_less = [](int a, int b) { return a / 10 < b / 10; };
+    for (int pattern = 0; pattern <= 4; ++pattern)
+    {
+        std::vector<int> v(10000);
+        sort_input(v, pattern);
+        mystl::list<int> l1(v.data(), v.data() + v.size());
+        mystl::list<int> l2(v.data(), v.data() + v.size());
+        l1.sort(tens_less);
+        l2.pointer_sort(tens_less);
+        std::stable_sort(v.begin(), v.end(), tens_less);
+        sort_ok = sort_ok && std::equal(v.begin(), v.end(), l1.begin());
+        pointer_sort_ok = pointer_sort_ok && std::equal(v.begin(), v.end(), l2.begin());
+    }
+    EXPECT_TRUE(sort_ok);
+    EXPECT_TRUE(pointer_sort_ok);
+}
+
 void list_test()
 {
     std::cout << "[===============================================================]" << std::endl;
@@ -38,6 +62,10 @@ void list_test()
     l9 = std::move(l3);
     mystl::list<int> l10;
     l10 = { 1, 2, 2, 3, 5, 6, 7, 8, 9 };
+    mystl::list<int, mystl::pool_allocator<int>> l11(a, a + 5);
+    mystl::list<int, mystl::pool_allocator<int>> l12(l11);
+    mystl::list<int, mystl::pool_allocator<int>> l13(l11.get_allocator());
+    l13 = l12;
 
     FUN_AFTER(l1, l1.assign(8, 8));
     FUN_AFTER(l1, l1.assign(a, a + 5));
@@ -74,6 +102,8 @@ void list_test()
     FUN_AFTER(l1, l1.unique([&](int a, int b) { return b == a + 1; }));
     FUN_AFTER(l1, l1.merge(l7));
     FUN_AFTER(l1, l1.sort(mystl::greater<int>()));
+    FUN_AFTER(l1, l1.pointer_sort());
+    FUN_AFTER(l1, l1.pointer_sort(mystl::greater<int>()));
     FUN_AFTER(l1, l1.merge(l8, mystl::greater<int>()));
     FUN_AFTER(l1, l1.reverse());
     FUN_AFTER(l1, l1.clear());
@@ -87,23 +117,46 @@ void list_test()
     std::cout << std::noboolalpha;
     FUN_VALUE(l1.size());
     FUN_VALUE(l1.max_size());
+    FUN_AFTER(l11, l11.insert(l11.end(), 2, 7));
+    FUN_AFTER(l11, l11.erase(l11.begin()));
+    FUN_AFTER(l11, l11.merge(l13));
+    FUN_AFTER(l11, l11.sort());
+    FUN_AFTER(l11, l11.swap(l12));
+    mystl::pool_allocator<int> pa;
+    mystl::pool_allocator<int> pb(std::move(pa));
+    mystl::list<int, mystl::pool_allocator<int>> l14(pa);  // 被移动后的分配器不再持有内存池，直接使用 ::operator new
+    mystl::list<int, mystl::pool_allocator<int>> l15(pb);
+    FUN_AFTER(l14, l14.assign(a, a + 3));
+    FUN_AFTER(l15, l15.assign(a, a + 3));
+    list_sort_result_test();
     PASSED;
 #if PERFORMANCE_TEST_ON
+    typedef mystl::list<int, mystl::pool_allocator<int>> pool_list;
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     std::cout << "|       insert        |";
 #if LARGER_TEST_DATA_ON
     CON_TEST_P2(list<int>, insert, end, rand(), SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+    CON_POOL_TEST_P2(pool_list, insert, end, rand(), SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #else
     CON_TEST_P2(list<int>, insert, end, rand(), SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    CON_POOL_TEST_P2(pool_list, insert, end, rand(), SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|    sort (random)    |";
+#if LARGER_TEST_DATA_ON
+    LIST_SORT_TEST(0, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    LIST_SORT_TEST(0, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
-    std::cout << "|         sort        |";
+    std::cout << "| sort (nearly sorted)|";
 #if LARGER_TEST_DATA_ON
-    LIST_SORT_TEST(SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    LIST_SORT_TEST(4, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #else
-    LIST_SORT_TEST(SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+    LIST_SORT_TEST(4, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
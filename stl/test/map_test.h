@@ -1,12 +1,21 @@
 #ifndef MYTINYSTL_MAP_TEST_H_
 #define MYTINYSTL_MAP_TEST_H_
 
-// map test : 测试 map, multimap 的接口与它们 insert 的性能
+// map test : 测试 map, multimap 的接口与它们 insert 的性能，以及使用 pool_allocator 时的性能，
+// 用 const char* 异构查找 mystl::string 键值的性能，重复键值插入的性能，以及用 extract 在两个 map 之间迁移元素的性能，
+// 用已序、逆序区间构造 map 的性能，以及维护子树大小（rb_tree_rank_policy）对插入性能的影响，
+// 以及 btree_map, btree_multimap 的接口与它们和 map 的随机插入、查找、遍历性能对比
+// 以及 flat_map, flat_multimap 的接口与它们和 map 的区间构造、查找性能对比
 
 #include <map>
 
 #include "../mytinystl/vector.h"
 #include "../mytinystl/map.h"
+#include "../mytinystl/btree_map.h"
+#include "../mytinystl/flat_map.h"
+#include "../mytinystl/pool_allocator.h"
+#include "../mytinystl/memory_resource.h"
+#include "../mytinystl/astring.h"
 #include "test.h"
 
 namespace mystl
@@ -65,6 +74,14 @@ void map_test()
     mystl::map<int, int> m9{ PAIR(1,1),PAIR(3,2),PAIR(2,3) };
     mystl::map<int, int> m10;
     m10 = { PAIR(1,1),PAIR(3,2),PAIR(2,3) };
+    mystl::map<int, int, mystl::less<int>, mystl::pool_allocator<mystl::pair<const int, int>>> m11(v.begin(), v.end());
+    mystl::pmr::unsynchronized_pool_resource pool;
+    mystl::pmr::map<int, int> m12(v.begin(), v.end(), &pool);
+    mystl::map<mystl::string, int, mystl::less<>> m13;
+    mystl::map<int, int> m14{ PAIR(1,1),PAIR(2,2) };
+    mystl::map<int, int> m15{ PAIR(2,20),PAIR(3,30),PAIR(4,40),PAIR(5,50) };
+    mystl::map<int, int> m16(v.rbegin(), v.rend());
+    mystl::map<int, int, mystl::less<int>, mystl::allocator<PAIR>, mystl::rb_tree_rank_policy> m17(v.begin(), v.end());
 
     for (int i = 5; i > 0; --i)
     {
@@ -104,15 +121,96 @@ void map_test()
     std::cout << std::noboolalpha;
     FUN_VALUE(m1.size());
     FUN_VALUE(m1.max_size());
+    MAP_FUN_AFTER(m11, m11.emplace(5, 5));
+    MAP_FUN_AFTER(m11, m11.erase(m11.begin()));
+    MAP_FUN_AFTER(m11, m11.insert(PAIR(0, 1)));
+    MAP_FUN_AFTER(m12, m12.emplace(5, 5));
+    MAP_FUN_AFTER(m12, m12.erase(m12.begin()));
+    MAP_FUN_AFTER(m13, m13.emplace(mystl::string("apple"), 1));
+    MAP_FUN_AFTER(m13, m13.emplace(mystl::string("banana"), 2));
+    FUN_VALUE(m13.count("banana"));
+    FUN_VALUE(m13.count("cherry"));
+    FUN_VALUE(m13.find("apple")->second);
+    FUN_VALUE(m13.lower_bound("b")->second);
+    FUN_VALUE(m13.try_emplace(mystl::string("apple"), 5).second);
+    FUN_VALUE(m13.try_emplace(mystl::string("cherry"), 3).second);
+    FUN_VALUE(m13.insert_or_assign(mystl::string("apple"), 4).second);
+    MAP_FUN_AFTER(m13, m13.try_emplace(m13.end(), mystl::string("durian"), 6));
+    MAP_FUN_AFTER(m13, m13.insert_or_assign(mystl::string("banana"), 7));
+    MAP_FUN_AFTER(m14, m14.insert(m15.extract(3)));
+    FUN_VALUE(m14.insert(m15.extract(2)).inserted);
+    MAP_FUN_AFTER(m15, m15.insert(m15.begin(), m14.extract(m14.begin())));
+    MAP_FUN_AFTER(m15, m15.emplace(3, 33));
+    MAP_FUN_AFTER(m14, m14.merge(m15));
+    FUN_VALUE(m15.size());
+    MAP_COUT(m16);
+    MAP_FUN_AFTER(m16, m16.emplace(-1, -1));
+    MAP_FUN_AFTER(m17, m17.emplace(10, 10));
+    MAP_FUN_AFTER(m17, m17.erase(2));
+    MAP_VALUE(*m17.nth(0));
+    MAP_VALUE(*m17.nth(2));
+    FUN_VALUE(m17.rank(3));
+    FUN_VALUE(m17.rank(5));
     PASSED;
 #if PERFORMANCE_TEST_ON
+    typedef mystl::map<int, int, mystl::less<int>, mystl::pool_allocator<mystl::pair<const int, int>>> pool_map;
+    typedef mystl::map<int, int> plain_map;
+    typedef mystl::map<int, int, mystl::less<int>, mystl::allocator<mystl::pair<const int, int>>,
+                       mystl::rb_tree_rank_policy> rank_map;
+    typedef std::map<int, int> std_map;
+    typedef mystl::map<mystl::string, int> str_map;
+    typedef mystl::map<mystl::string, int, mystl::less<>> tr_str_map;
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     std::cout << "|       emplace       |";
     #if LARGER_TEST_DATA_ON
     MAP_EMPLACE_TEST(map, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_map, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+    MAP_EMPLACE_RANK_TEST(rank_map, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #else
     MAP_EMPLACE_TEST(map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_EMPLACE_RANK_TEST(rank_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|    emplace (dup)    |";
+#if LARGER_TEST_DATA_ON
+    MAP_DEDUP_TEST(map, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    MAP_DEDUP_TEST(map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "| find (const char*)  |";
+#if LARGER_TEST_DATA_ON
+    MAP_CSTR_FIND_TEST(str_map, tr_str_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_CSTR_FIND_TEST(str_map, tr_str_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|       migrate       |";
+#if LARGER_TEST_DATA_ON
+    MAP_MIGRATE_TEST(plain_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_MIGRATE_TEST(plain_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|    bulk (sorted)    |";
+#if LARGER_TEST_DATA_ON
+    BULK_LOAD_TEST(std_map, plain_map, false, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    BULK_LOAD_TEST(std_map, plain_map, false, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|   bulk (reverse)    |";
+#if LARGER_TEST_DATA_ON
+    BULK_LOAD_TEST(std_map, plain_map, true, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    BULK_LOAD_TEST(std_map, plain_map, true, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
@@ -173,6 +271,9 @@ void multimap_test()
     MAP_FUN_AFTER(m1, m1.clear());
     MAP_FUN_AFTER(m1, m1.swap(m9));
     MAP_FUN_AFTER(m1, m1.insert(PAIR(3, 3)));
+    MAP_FUN_AFTER(m1, m1.insert(m10.extract(3)));
+    MAP_FUN_AFTER(m1, m1.insert(m1.begin(), m10.extract(m10.begin())));
+    MAP_FUN_AFTER(m1, m1.merge(m10));
     MAP_VALUE(*m1.begin());
     MAP_VALUE(*m1.rbegin());
     std::cout << std::boolalpha;
@@ -182,13 +283,16 @@ void multimap_test()
     FUN_VALUE(m1.max_size());
     PASSED;
 #if PERFORMANCE_TEST_ON
+    typedef mystl::multimap<int, int, mystl::less<int>, mystl::pool_allocator<mystl::pair<const int, int>>> pool_multimap;
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     std::cout << "|       emplace       |";
 #if LARGER_TEST_DATA_ON
     MAP_EMPLACE_TEST(multimap, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_multimap, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #else
     MAP_EMPLACE_TEST(multimap, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_multimap, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
@@ -197,6 +301,223 @@ void multimap_test()
     std::cout << "[---------------- End container test : multimap ----------------]" << std::endl;
 }
 
+void btree_map_test()
+{
+    std::cout << "[===============================================================]" << std::endl;
+    std::cout << "[--------------- Run container test : btree_map ----------------]" << std::endl;
+    std::cout << "[-------------------------- API test ---------------------------]" << std::endl;
+    mystl::vector<PAIR> v;
+    for (int i = 0; i < 5; ++i)
+        v.push_back(PAIR(i, i));
+    mystl::btree_map<int, int> bm1;
+    mystl::btree_map<int, int, mystl::greater<int>> bm2(v.begin(), v.end());
+    mystl::btree_map<int, int> bm3(v.begin(), v.end());
+    mystl::btree_map<int, int> bm4(bm3);
+    mystl::btree_map<int, int> bm5(std::move(bm3));
+    mystl::btree_map<int, int> bm6;
+    bm6 = bm4;
+    mystl::btree_map<int, int> bm7;
+    bm7 = std::move(bm4);
+    mystl::btree_map<int, int> bm8{ PAIR(1,1),PAIR(3,2),PAIR(2,3) };
+    mystl::btree_map<mystl::string, int, mystl::less<>> bm9;
+    mystl::btree_multimap<int, int> bm10;
+    mystl::btree_map<int, int> bm11;
+
+    for (int i = 5; i > 0; --i)
+    {
+        MAP_FUN_AFTER(bm1, bm1.emplace(i, i));
+    }
+    MAP_FUN_AFTER(bm1, bm1.emplace_hint(bm1.end(), 6, 6));
+    MAP_FUN_AFTER(bm1, bm1.insert(PAIR(0, 0)));
+    MAP_FUN_AFTER(bm1, bm1.insert(v.begin(), v.end()));
+    MAP_FUN_AFTER(bm1, bm1.erase(bm1.begin()));
+    MAP_FUN_AFTER(bm1, bm1.erase(2));
+    MAP_VALUE(*bm1.erase(bm1.find(3)));
+    MAP_FUN_AFTER(bm1, bm1.erase(bm1.begin(), bm1.find(5)));
+    FUN_VALUE(bm1.count(5));
+    MAP_VALUE(*bm1.find(5));
+    MAP_VALUE(*bm1.lower_bound(5));
+    MAP_VALUE(*bm1.upper_bound(5));
+    auto first = *bm1.equal_range(5).first;
+    auto second = *bm1.equal_range(5).second;
+    std::cout << " bm1.equal_range(5) : from <" << first.first << ", " << first.second
+        << "> to <" << second.first << ", " << second.second << ">" << std::endl;
+    MAP_FUN_AFTER(bm1, bm1.clear());
+    MAP_FUN_AFTER(bm1, bm1.swap(bm8));
+    MAP_VALUE(*bm1.begin());
+    MAP_VALUE(*bm1.rbegin());
+    FUN_VALUE(bm1[1]);
+    MAP_FUN_AFTER(bm1, bm1[4] = 4);
+    FUN_VALUE(bm1.at(2));
+    MAP_FUN_AFTER(bm1, bm1.try_emplace(5, 5));
+    MAP_FUN_AFTER(bm1, bm1.insert_or_assign(1, 10));
+    std::cout << std::boolalpha;
+    FUN_VALUE(bm1.empty());
+    FUN_VALUE((bm5 == bm6));
+    std::cout << std::noboolalpha;
+    FUN_VALUE(bm1.size());
+    MAP_COUT(bm2);
+    MAP_COUT(bm7);
+    MAP_FUN_AFTER(bm9, bm9.emplace(mystl::string("apple"), 1));
+    MAP_FUN_AFTER(bm9, bm9.emplace(mystl::string("banana"), 2));
+    FUN_VALUE(bm9.count("banana"));
+    FUN_VALUE(bm9.lower_bound("b")->second);
+    for (int i = 0; i < 6; ++i)
+    {
+        bm10.emplace(i % 3, i);
+    }
+    MAP_COUT(bm10);
+    FUN_VALUE(bm10.count(1));
+    MAP_VALUE(*bm10.upper_bound(1));
+    MAP_FUN_AFTER(bm10, bm10.erase(1));
+    // 插入足够多的元素使节点分裂，再逐个删除使节点合并
+    for (int i = 0; i < 1000; ++i)
+    {
+        bm11.emplace(i * 7 % 1000, i);
+    }
+    FUN_VALUE(bm11.size());
+    for (auto it = bm11.begin(); it != bm11.end(); )
+    {
+        if (it->first % 10 == 0)
+            ++it;
+        else
+            it = bm11.erase(it);
+    }
+    FUN_VALUE(bm11.size());
+    MAP_VALUE(*bm11.rbegin());
+    PASSED;
+#if PERFORMANCE_TEST_ON
+    typedef std::map<int, int> std_map;
+    typedef mystl::map<int, int> plain_map;
+    typedef mystl::btree_map<int, int> bt_map;
+    std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|       emplace       |";
+#if LARGER_TEST_DATA_ON
+    MAP_TREE_TEST(MAP_EMPLACE_KV_DO_TEST, std_map, plain_map, bt_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#else
+    MAP_TREE_TEST(MAP_EMPLACE_KV_DO_TEST, std_map, plain_map, bt_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|        find         |";
+#if LARGER_TEST_DATA_ON
+    MAP_TREE_TEST(MAP_FIND_DO_TEST, std_map, plain_map, bt_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#else
+    MAP_TREE_TEST(MAP_FIND_DO_TEST, std_map, plain_map, bt_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|       iterate       |";
+#if LARGER_TEST_DATA_ON
+    MAP_TREE_TEST(MAP_ITERATE_DO_TEST, std_map, plain_map, bt_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#else
+    MAP_TREE_TEST(MAP_ITERATE_DO_TEST, std_map, plain_map, bt_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    PASSED;
+#endif
+    std::cout << "[--------------- End container test : btree_map ----------------]" << std::endl;
+}
+
+void flat_map_test()
+{
+    std::cout << "[===============================================================]" << std::endl;
+    std::cout << "[--------------- Run container test : flat_map -----------------]" << std::endl;
+    std::cout << "[-------------------------- API test ---------------------------]" << std::endl;
+    mystl::vector<PAIR> v;
+    for (int i = 0; i < 5; ++i)
+        v.push_back(PAIR(i, i));
+    mystl::flat_map<int, int> fm1;
+    mystl::flat_map<int, int, mystl::greater<int>> fm2(v.begin(), v.end());
+    mystl::flat_map<int, int> fm3(v.rbegin(), v.rend());
+    mystl::flat_map<int, int> fm4(fm3);
+    mystl::flat_map<int, int> fm5(std::move(fm3));
+    mystl::flat_map<int, int> fm6;
+    fm6 = fm4;
+    mystl::flat_map<int, int> fm7;
+    fm7 = std::move(fm4);
+    mystl::flat_map<int, int> fm8{ PAIR(1,1),PAIR(3,2),PAIR(2,3),PAIR(3,4) };
+    mystl::flat_map<mystl::string, int, mystl::less<>> fm9;
+    mystl::flat_multimap<int, int> fm10{ PAIR(2,0),PAIR(1,1),PAIR(2,2),PAIR(1,3) };
+
+    for (int i = 5; i > 0; --i)
+    {
+        MAP_FUN_AFTER(fm1, fm1.emplace(i, i));
+    }
+    MAP_FUN_AFTER(fm1, fm1.emplace_hint(fm1.end(), 6, 6));
+    MAP_FUN_AFTER(fm1, fm1.insert(PAIR(0, 0)));
+    MAP_FUN_AFTER(fm1, fm1.insert(v.begin(), v.end()));
+    MAP_FUN_AFTER(fm1, fm1.insert({ PAIR(9,9),PAIR(7,7),PAIR(8,8) }));
+    MAP_FUN_AFTER(fm1, fm1.erase(fm1.begin()));
+    MAP_FUN_AFTER(fm1, fm1.erase(2));
+    MAP_VALUE(*fm1.erase(fm1.find(3)));
+    MAP_FUN_AFTER(fm1, fm1.erase(fm1.begin(), fm1.find(5)));
+    FUN_VALUE(fm1.count(5));
+    MAP_VALUE(*fm1.find(5));
+    MAP_VALUE(*fm1.lower_bound(5));
+    MAP_VALUE(*fm1.upper_bound(5));
+    auto first = *fm1.equal_range(5).first;
+    auto second = *fm1.equal_range(5).second;
+    std::cout << " fm1.equal_range(5) : from <" << first.first << ", " << first.second
+        << "> to <" << second.first << ", " << second.second << ">" << std::endl;
+    FUN_VALUE(fm1.keys().size());
+    FUN_VALUE(fm1.values().back());
+    MAP_FUN_AFTER(fm1, fm1.clear());
+    MAP_FUN_AFTER(fm1, fm1.swap(fm8));
+    MAP_VALUE(*fm1.begin());
+    FUN_VALUE(fm1.rbegin()->second);
+    FUN_VALUE(fm1[1]);
+    MAP_FUN_AFTER(fm1, fm1[4] = 4);
+    FUN_VALUE(fm1.at(2));
+    MAP_FUN_AFTER(fm1, fm1.try_emplace(5, 5));
+    MAP_FUN_AFTER(fm1, fm1.insert_or_assign(1, 10));
+    MAP_FUN_AFTER(fm1, fm1.begin()->second = 0);
+    std::cout << std::boolalpha;
+    FUN_VALUE(fm1.empty());
+    FUN_VALUE((fm5 == fm6));
+    std::cout << std::noboolalpha;
+    FUN_VALUE(fm1.size());
+    MAP_COUT(fm2);
+    MAP_COUT(fm7);
+    MAP_FUN_AFTER(fm9, fm9.emplace(mystl::string("apple"), 1));
+    MAP_FUN_AFTER(fm9, fm9.emplace(mystl::string("banana"), 2));
+    FUN_VALUE(fm9.count("banana"));
+    FUN_VALUE(fm9.lower_bound("b")->second);
+    MAP_COUT(fm10);
+    MAP_FUN_AFTER(fm10, fm10.emplace(1, 4));
+    FUN_VALUE(fm10.count(1));
+    MAP_VALUE(*fm10.upper_bound(1));
+    MAP_FUN_AFTER(fm10, fm10.erase(1));
+    PASSED;
+#if PERFORMANCE_TEST_ON
+    typedef std::map<int, int> std_map;
+    typedef mystl::map<int, int> plain_map;
+    typedef mystl::flat_map<int, int> fl_map;
+    std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|        build        |";
+#if LARGER_TEST_DATA_ON
+    MAP_SORTED_TEST(MAP_BUILD_DO_TEST, std_map, plain_map, fl_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#else
+    MAP_SORTED_TEST(MAP_BUILD_DO_TEST, std_map, plain_map, fl_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|        find         |";
+#if LARGER_TEST_DATA_ON
+    MAP_SORTED_TEST(MAP_BULK_FIND_DO_TEST, std_map, plain_map, fl_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#else
+    MAP_SORTED_TEST(MAP_BULK_FIND_DO_TEST, std_map, plain_map, fl_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    PASSED;
+#endif
+    std::cout << "[--------------- End container test : flat_map -----------------]" << std::endl;
+}
+
 
 }
 
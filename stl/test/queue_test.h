@@ -1,11 +1,19 @@
 #ifndef MYTINYSTL_QUEUE_TEST_H_
 #define MYTINYSTL_QUEUE_TEST_H_
 
-// queue test : 测试 queue, priority_queue 的接口和它们 push 的性能
+// queue test : 测试 queue, priority_queue 的接口和它们 push 的性能，
+//              以及 priority_queue 各 heap 策略与 pairing_heap 的接口和 push / pop 的性能，
+//              ring_buffer, spsc_queue, mpmc_queue 的接口和多线程下的吞吐量
 
 #include <queue>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 #include "../mytinystl/queue.h"
+#include "../mytinystl/pairing_heap.h"
+#include "../mytinystl/ring_buffer.h"
 #include "test.h"
 
 namespace mystl
@@ -27,7 +35,8 @@ void queue_print(mystl::queue<int> q)
     std::cout << std::endl;
 }
 
-void p_queue_print(mystl::priority_queue<int> p)
+template <class PQueue>
+void p_queue_print(PQueue p)
 {
     while(!p.empty())
     {
@@ -37,6 +46,13 @@ void p_queue_print(mystl::priority_queue<int> p)
     std::cout << std::endl;
 }
 
+void ring_print(const mystl::ring_buffer<int>& r)
+{
+    for (size_t i = 0; i < r.size(); ++i)
+        std::cout << " " << r[i];
+    std::cout << std::endl;
+}
+
 //  queue 的遍历输出
 #define QUEUE_COUT(q) do{                           \
     std::string q_name = #q;                        \
@@ -65,6 +81,108 @@ void p_queue_print(mystl::priority_queue<int> p)
     P_QUEUE_COUT(con);                              \
 }while(0)
 
+// ring_buffer 的遍历输出
+#define RING_COUT(r) do{                            \
+    std::string r_name = #r;                        \
+    std::cout << " " << r_name << " :";             \
+    ring_print(r);                                  \
+}while(0)
+
+#define RING_FUN_AFTER(con, fun) do{                \
+    std::string fun_name = #fun;                    \
+    std::cout << " After " << fun_name << " :\n";   \
+    fun;                                            \
+    RING_COUT(con);                                 \
+}while(0)
+
+// 用互斥锁保护的 mystl::queue，作为多线程吞吐量测试的对照
+class locked_queue
+{
+public:
+    explicit locked_queue(size_t) {}
+
+    size_t push_n(int* first, size_t n)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < n; ++i)
+            q_.push(first[i]);
+        return n;
+    }
+
+    size_t pop_n(int* result, size_t n)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t i = 0;
+        for (; i < n && !q_.empty(); ++i)
+        {
+            result[i] = q_.front();
+            q_.pop();
+        }
+        return i;
+    }
+
+private:
+    std::mutex        mutex_;
+    mystl::queue<int> q_;
+};
+
+// 多线程吞吐量测试：producers 个线程共写入 1 ~ len，consumers 个线程读出，每次搬运 batch 个元素
+// 返回经过的时间（毫秒），读出的元素之和不正确时返回 -1
+template <class Queue>
+int mt_queue_run(size_t producers, size_t consumers, size_t batch, size_t len)
+{
+    Queue q(1024);
+    std::atomic<size_t> consumed(0);
+    std::atomic<unsigned long long> total(0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < producers; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            std::vector<int> buf(batch);
+            for (size_t v = t + 1; v <= len;)
+            {
+                size_t n = 0;
+                for (; n < batch && v <= len; ++n, v += producers)
+                    buf[n] = static_cast<int>(v);
+                for (size_t done = 0; done < n;)
+                {
+                    auto k = q.push_n(buf.data() + done, n - done);
+                    if (k == 0)
+                        std::this_thread::yield();
+                    done += k;
+                }
+            }
+        });
+    }
+    for (size_t t = 0; t < consumers; ++t)
+    {
+        threads.emplace_back([&]() {
+            std::vector<int> buf(batch);
+            unsigned long long sum = 0;
+            while (consumed.load(std::memory_order_relaxed) < len)
+            {
+                auto k = q.pop_n(buf.data(), batch);
+                if (k == 0)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t i = 0; i < k; ++i)
+                    sum += buf[i];
+                consumed.fetch_add(k, std::memory_order_relaxed);
+            }
+            total.fetch_add(sum);
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    auto end = std::chrono::steady_clock::now();
+    if (total.load() != static_cast<unsigned long long>(len) * (len + 1) / 2)
+        return -1;
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+}
+
 void queue_test()
 {
     std::cout << "[===============================================================]" << std::endl;
@@ -164,6 +282,35 @@ void priority_test()
     }
     P_QUEUE_FUN_AFTER(p1, p1.swap(p4));
     P_QUEUE_FUN_AFTER(p1, p1.clear());
+
+    int b[] = {12, 3, 45, 7, 31, 9, 28, 16, 5, 40, 22};
+    mystl::priority_queue<int, mystl::vector<int>, mystl::less<int>, mystl::dary_heap_policy<4>> d1(b, b + 11);
+    mystl::priority_queue<int, mystl::vector<int>, mystl::greater<int>, mystl::dary_heap_policy<8>> d2;
+    P_QUEUE_COUT(d1);
+    P_QUEUE_FUN_AFTER(d1, d1.push(30));
+    P_QUEUE_FUN_AFTER(d1, d1.pop());
+    P_QUEUE_FUN_AFTER(d2, for (auto x : b) d2.push(x));
+    P_QUEUE_FUN_AFTER(d2, d2.pop());
+    FUN_VALUE(d2.top());
+
+    mystl::pairing_heap<int> h1{5, 1, 4};
+    mystl::pairing_heap<int, mystl::greater<int>> h2;
+    auto k1 = h2.push(20);
+    auto k2 = h2.push(10);
+    auto k3 = h2.push(30);
+    h2.push(15);
+    P_QUEUE_COUT(h1);
+    P_QUEUE_FUN_AFTER(h1, h1.push(3));
+    P_QUEUE_FUN_AFTER(h1, h1.pop());
+    P_QUEUE_COUT(h2);
+    P_QUEUE_FUN_AFTER(h2, h2.decrease_key(k3, 5));
+    FUN_VALUE(h2.top());
+    FUN_VALUE(*k3);
+    P_QUEUE_FUN_AFTER(h2, h2.update(k3, 25));
+    P_QUEUE_FUN_AFTER(h2, h2.erase(k1));
+    P_QUEUE_FUN_AFTER(h2, h2.erase(k2));
+    P_QUEUE_FUN_AFTER(h2, h2.merge(mystl::pairing_heap<int, mystl::greater<int>>{8, 40}));
+    FUN_VALUE(h2.size());
     PASSED;
 #if PERFORMANCE_TEST_ON
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
@@ -173,6 +320,14 @@ void priority_test()
     CON_TEST_P1(priority_queue<int>, push, rand(), SCALE_LL(LEN1), SCALE_LL(LEN2), SCALE_LL(LEN3));
 #else
     CON_TEST_P1(priority_queue<int>, push, rand(), SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|     push and pop    |";
+#if LARGER_TEST_DATA_ON
+    P_QUEUE_TEST(SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    P_QUEUE_TEST(SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
@@ -181,6 +336,82 @@ void priority_test()
     std::cout << "[------------- End container test : priority_queue -------------]" << std::endl;
 }
 
+void ring_buffer_test()
+{
+    std::cout << "[===============================================================]" << std::endl;
+    std::cout << "[----------- Run container test : ring_buffer / queues ----------]" << std::endl;
+    std::cout << "[-------------------------- API test ---------------------------]" << std::endl;
+    int a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    int b[10] = {0};
+    int x = 0;
+    mystl::ring_buffer<int> r1(5);
+    std::cout << std::boolalpha;
+    FUN_VALUE(r1.capacity());
+    RING_FUN_AFTER(r1, r1.push(1));
+    RING_FUN_AFTER(r1, r1.emplace(2));
+    RING_FUN_AFTER(r1, r1.push_n(a + 2, 5));
+    FUN_VALUE(r1.full());
+    FUN_VALUE(r1.push(9));
+    RING_FUN_AFTER(r1, r1.pop());
+    RING_FUN_AFTER(r1, r1.pop(x));
+    FUN_VALUE(x);
+    RING_FUN_AFTER(r1, r1.push_n(a, 10));
+    FUN_VALUE(r1.front());
+    FUN_VALUE(r1.back());
+    FUN_VALUE(r1[2]);
+    FUN_VALUE(r1.pop_n(b, 3));
+    FUN_VALUE(b[2]);
+    mystl::ring_buffer<int> r2(r1);
+    RING_COUT(r2);
+    RING_FUN_AFTER(r1, r1.clear());
+    FUN_VALUE(r1.empty());
+
+    mystl::spsc_queue<int> s1(4);
+    FUN_VALUE(s1.push_n(a, 10));
+    FUN_VALUE(s1.push(11));
+    FUN_VALUE(s1.pop(x));
+    FUN_VALUE(x);
+    FUN_VALUE(s1.size());
+    FUN_VALUE(s1.pop_n(b, 10));
+    FUN_VALUE(b[2]);
+    FUN_VALUE(s1.empty());
+
+    mystl::mpmc_queue<int> m1(4);
+    FUN_VALUE(m1.push(1));
+    FUN_VALUE(m1.emplace(2));
+    FUN_VALUE(m1.push_n(a + 2, 8));
+    FUN_VALUE(m1.size());
+    FUN_VALUE(m1.pop(x));
+    FUN_VALUE(x);
+    FUN_VALUE(m1.pop_n(b, 10));
+    FUN_VALUE(b[2]);
+    FUN_VALUE(m1.pop(x));
+    std::cout << std::noboolalpha;
+    PASSED;
+#if PERFORMANCE_TEST_ON
+    std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  1 producer, 1 cons |";
+#if LARGER_TEST_DATA_ON
+    MT_QUEUE_TEST(1, 1, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    MT_QUEUE_TEST(1, 1, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  2 producer, 2 cons |";
+#if LARGER_TEST_DATA_ON
+    MT_QUEUE_TEST(2, 2, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    MT_QUEUE_TEST(2, 2, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    PASSED;
+#endif
+    std::cout << "[----------- End container test : ring_buffer / queues ----------]" << std::endl;
+}
+
 } // namespace queue_test
 
 } // namespace test
@@ -1,11 +1,14 @@
 #ifndef MYTINYSTL_SET_TEST_H_
 #define MYTINYSTL_SET_TEST_H_
 
-// set test : 测试 set, multiset 的接口与它们 insert 的性能
+// set test : 测试 set, multiset 的接口与它们 insert 的性能，以及用已序、逆序区间构造 set 的性能，
+// 以及使用 rb_tree_rank_policy 时 multiset 的 nth 与 rank，以及 btree_set, btree_multiset, flat_set, flat_multiset 的接口
 
 #include <set>
 
 #include "../mytinystl/set.h"
+#include "../mytinystl/btree_set.h"
+#include "../mytinystl/flat_set.h"
 #include "test.h"
 
 namespace mystl
@@ -34,6 +37,9 @@ void set_test()
     mystl::set<int> s9{ 1,2,3,4,5 };
     mystl::set<int> s10;
     s10 = { 1,2,3,4,5 };
+    mystl::set<int> s11(s9.rbegin(), s9.rend());
+    mystl::btree_set<int> s12(a, a + 5);
+    mystl::flat_set<int> s13{ 4,2,5,1,3,2 };
 
     for (int i = 5; i > 0; --i)
     {
@@ -70,8 +76,23 @@ void set_test()
     std::cout << std::noboolalpha;
     FUN_VALUE(s1.size());
     FUN_VALUE(s1.max_size());
+    COUT(s11);
+    FUN_AFTER(s11, s11.insert(0));
+    FUN_AFTER(s12, s12.insert(0));
+    FUN_AFTER(s12, s12.emplace_hint(s12.end(), 6));
+    FUN_VALUE(*s12.erase(s12.find(3)));
+    FUN_VALUE(*s12.lower_bound(3));
+    FUN_AFTER(s12, s12.erase(s12.begin(), s12.find(5)));
+    FUN_AFTER(s13, s13.insert(0));
+    FUN_AFTER(s13, s13.insert(a, a + 5));
+    FUN_AFTER(s13, s13.emplace_hint(s13.end(), 6));
+    FUN_VALUE(*s13.erase(s13.find(3)));
+    FUN_VALUE(*s13.lower_bound(3));
+    FUN_AFTER(s13, s13.erase(s13.begin(), s13.find(5)));
     PASSED;
 #if PERFORMANCE_TEST_ON
+    typedef std::set<int> std_set;
+    typedef mystl::set<int> mystl_set;
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     std::cout << "|       emplace       |";
@@ -79,6 +100,22 @@ void set_test()
     CON_TEST_P1(set<int>, emplace, rand(), SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #else
     CON_TEST_P1(set<int>, emplace, rand(), SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|    bulk (sorted)    |";
+#if LARGER_TEST_DATA_ON
+    BULK_LOAD_TEST(std_set, mystl_set, false, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    BULK_LOAD_TEST(std_set, mystl_set, false, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|   bulk (reverse)    |";
+#if LARGER_TEST_DATA_ON
+    BULK_LOAD_TEST(std_set, mystl_set, true, SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+#else
+    BULK_LOAD_TEST(std_set, mystl_set, true, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
@@ -106,6 +143,9 @@ void multiset_test()
     mystl::multiset<int> s9{ 1,2,3,4,5 };
     mystl::multiset<int> s10;
     s10 = { 1,2,3,4,5 };
+    mystl::multiset<int, mystl::less<int>, mystl::allocator<int>, mystl::rb_tree_rank_policy> s11{ 5,1,3,3,2 };
+    mystl::btree_multiset<int> s12{ 5,1,3,3,2 };
+    mystl::flat_multiset<int> s13{ 5,1,3,3,2 };
 
     for (int i = 5; i > 0; --i)
     {
@@ -142,6 +182,22 @@ void multiset_test()
     std::cout << std::noboolalpha;
     FUN_VALUE(s1.size());
     FUN_VALUE(s1.max_size());
+    FUN_VALUE(*s11.nth(2));
+    FUN_VALUE(*s11.nth(3));
+    FUN_VALUE(s11.rank(3));
+    FUN_VALUE(s11.rank(4));
+    FUN_AFTER(s11, s11.erase(3));
+    FUN_VALUE(s11.rank(4));
+    FUN_VALUE(*s11.nth(2));
+    FUN_AFTER(s12, s12.insert(3));
+    FUN_VALUE(s12.count(3));
+    FUN_VALUE(*s12.upper_bound(3));
+    FUN_AFTER(s12, s12.erase(3));
+    FUN_AFTER(s13, s13.insert(3));
+    FUN_AFTER(s13, s13.insert({ 4,3,0 }));
+    FUN_VALUE(s13.count(3));
+    FUN_VALUE(*s13.upper_bound(3));
+    FUN_AFTER(s13, s13.erase(3));
     PASSED;
 #if PERFORMANCE_TEST_ON
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
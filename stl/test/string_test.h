@@ -6,6 +6,7 @@
 #include <string>
 
 #include "../mytinystl/astring.h"
+#include "../mytinystl/memory_resource.h"
 #include "test.h"
 
 namespace mystl
@@ -15,6 +16,95 @@ namespace test
 namespace string_test
 {
 
+// 与 std::basic_string 的结果比较，同时检查结尾的空字符
+template <class Str, class StdStr>
+bool same_str(const Str& s, const StdStr& t)
+{
+  return s.size() == t.size() && std::equal(t.begin(), t.end(), s.c_str()) &&
+         s.c_str()[s.size()] == typename Str::value_type();
+}
+
+// 检查短字符串在内联容量边界处、内联与堆上两种状态互相交换，以及源区间指向自身时的行为
+template <class CharT>
+void sso_test()
+{
+  typedef mystl::basic_string<CharT> str_t;
+  typedef std::basic_string<CharT>   std_t;
+  const size_t cap = str_t().capacity();  // 内联容量，char 为 15，wchar_t 为 3
+  std_t pat;
+  for (size_t i = 0; i < 4 * cap + 8; ++i)
+    pat.push_back(static_cast<CharT>('a' + i % 26));
+
+  // 内联容量边界
+  for (size_t n = cap - 1; n <= cap + 1; ++n)
+  {
+    str_t s(pat.c_str(), n);
+    EXPECT_TRUE(same_str(s, pat.substr(0, n)));
+    EXPECT_TRUE((s.capacity() == cap) == (n <= cap));
+    s.push_back(CharT('x'));
+    EXPECT_TRUE(same_str(s, pat.substr(0, n) + CharT('x')));
+    EXPECT_TRUE((s.capacity() == cap) == (n + 1 <= cap));
+    s.pop_back();
+    s.shrink_to_fit();
+    EXPECT_TRUE(same_str(s, pat.substr(0, n)));
+    EXPECT_TRUE((s.capacity() == cap) == (n <= cap));
+    str_t t(s);
+    EXPECT_TRUE(same_str(t, pat.substr(0, n)));
+  }
+
+  // 内联与堆上的字符串互相交换
+  {
+    str_t a(pat.c_str(), 2), b(pat.c_str(), 3 * cap);
+    a.swap(b);
+    EXPECT_TRUE(same_str(a, pat.substr(0, 3 * cap)) && same_str(b, pat.substr(0, 2)));
+    mystl::swap(a, b);
+    EXPECT_TRUE(same_str(a, pat.substr(0, 2)) && same_str(b, pat.substr(0, 3 * cap)));
+    str_t c(pat.c_str() + 1, cap);
+    a.swap(c);
+    EXPECT_TRUE(same_str(a, pat.substr(1, cap)) && same_str(c, pat.substr(0, 2)));
+    str_t d(pat.c_str() + 2, 2 * cap);
+    b.swap(d);
+    EXPECT_TRUE(same_str(b, pat.substr(2, 2 * cap)) && same_str(d, pat.substr(0, 3 * cap)));
+    b.swap(b);
+    EXPECT_TRUE(same_str(b, pat.substr(2, 2 * cap)));
+  }
+
+  // 源区间指向自身，并且结果越过内联容量
+  const size_t lens[] = { 2, cap - 1, cap, cap + 1 };
+  for (size_t n : lens)
+  {
+    str_t s(pat.c_str(), n);
+    std_t t = pat.substr(0, n);
+    s.append(s);
+    t += std_t(t);
+    EXPECT_TRUE(same_str(s, t));
+    s.append(s.c_str() + 1, n);
+    t += t.substr(1, n);
+    EXPECT_TRUE(same_str(s, t));
+
+    s.assign(pat.c_str(), n);
+    t = pat.substr(0, n);
+    s.replace(0, 1, s);
+    t.replace(0, 1, std_t(t));
+    EXPECT_TRUE(same_str(s, t));
+    s.replace(1, s.size() - 2, s.c_str(), 2);
+    t.replace(1, t.size() - 2, t.substr(0, 2));
+    EXPECT_TRUE(same_str(s, t));
+    s.replace(s.begin(), s.begin() + 1, s.c_str(), s.size());
+    t.replace(0, 1, std_t(t));
+    EXPECT_TRUE(same_str(s, t));
+
+    s.assign(pat.c_str(), n);
+    t = pat.substr(0, n);
+    s.insert(s.begin() + 1, s.begin(), s.end());
+    t.insert(1, std_t(t));
+    EXPECT_TRUE(same_str(s, t));
+    s.insert(s.end(), s.begin() + 1, s.begin() + 1 + n);
+    t += t.substr(1, n);
+    EXPECT_TRUE(same_str(s, t));
+  }
+}
+
 void string_test()
 {
   std::cout << "[===============================================================]" << std::endl;
@@ -38,6 +128,9 @@ void string_test()
   str11 = "123";
   mystl::string str12;
   str12 = 'A';
+  char buf[256];
+  mystl::pmr::monotonic_buffer_resource arena(buf, sizeof(buf));
+  mystl::pmr::string pstr("pmr", &arena);
 
   STR_FUN_AFTER(str, str = 'a');
   STR_FUN_AFTER(str, str = "string");
@@ -184,6 +277,10 @@ void string_test()
   std::cout << " str3 + \" success\" : " << str3 + " success" << std::endl;
   std::cout << " \"My \" + str3 : " << "My " + str3 << std::endl;
   std::cout << " str3 + str4 : " << str3 + str4 << std::endl;
+  STR_FUN_AFTER(pstr, pstr.append(" string"));
+  STR_FUN_AFTER(pstr, pstr.insert(pstr.begin(), 'a'));
+  sso_test<char>();
+  sso_test<wchar_t>();
   PASSED;
 #if PERFORMANCE_TEST_ON
   std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
@@ -194,6 +291,14 @@ void string_test()
 #else
   CON_TEST_P1(string, append, "s", SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #endif
+  std::cout << std::endl;
+  std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+  std::cout << "|    short string     |";
+  STR_SHORT_TEST(SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
+  std::cout << std::endl;
+  std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+  std::cout << "|    hash(string)     |";
+  STR_HASH_TEST(8, 256, 4096, SCALE_LL(LEN3) * 10);
   std::cout << std::endl;
   std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
   PASSED;
@@ -18,6 +18,7 @@
 #include "unordered_set_test.h"
 #include "unordered_map_test.h"
 #include "string_test.h"
+#include "algorithm_test.h"
 
 int main()
 {
@@ -30,14 +31,22 @@ int main()
     stack_test::stack_test();
     queue_test::queue_test();
     queue_test::priority_test();
+    queue_test::ring_buffer_test();
     list_test::list_test();
     set_test::set_test();
     set_test::multiset_test();
     map_test::map_test();
     map_test::multimap_test();
+    map_test::btree_map_test();
+    map_test::flat_map_test();
     unordered_set_test::unordered_set_test();
     unordered_set_test::unordered_multiset_test();
     unordered_map_test::unordered_map_test();
     unordered_map_test::unordered_multimap_test();
+    unordered_map_test::flat_hash_map_test();
     string_test::string_test();
+    algorithm_test::sort_test();
+
+    // 任何一个 EXPECT_* 失败都以非零值退出
+    return UnitTest::GetInstance()->CurrentTestCase->nFailed == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 // 一个简单的单元测试框架，定义了两个类 TestCase 和 UnitTest，以及一系列用于测试的宏
 
 #include <ctime>
+#include <chrono>
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 #include <vector>
@@ -73,9 +75,26 @@ protected:
     std::vector<TestCase*> testcases_;  // 保存案例集合
 };
 
+// 容器测试直接在 main 中调用，不经过 UnitTest::Run，
+// 此时 EXPECT_* 的结果记录在这个默认的测试案例中
+class DefaultTestCase : public TestCase
+{
+public:
+    DefaultTestCase() : TestCase("default")
+    {
+        nTestResult = 1;
+        nFailed = 0;
+        nPassed = 0;
+    }
+    virtual void Run() {}
+};
+
 UnitTest* UnitTest::GetInstance()
 {
     static UnitTest instance;
+    static DefaultTestCase default_case;
+    if(instance.CurrentTestCase == nullptr)
+        instance.CurrentTestCase = &default_case;
     return &instance;
 }
 
@@ -564,6 +583,75 @@ void test_len(size_t len1, size_t len2, size_t len3, size_t wide)
 
 #define TEST_LEN(len1, len2, len3, wide) test_len(len1, len2, len3, wide)
 
+// 把被计时代码的结果写到 volatile 变量中，避免编译器把整段代码当作无用代码删掉；结果本身不参与输出
+template <class T>
+inline void keep_result(const T& value)
+{
+    static volatile T sink;
+    sink = value;
+    (void)sink;
+}
+
+// 统计经由分配器申请的字节数，用于比较容器的内存占用
+inline size_t& alloc_bytes()
+{
+    static size_t bytes = 0;
+    return bytes;
+}
+
+// 统计分配器的 allocate 调用次数
+inline size_t& alloc_calls()
+{
+    static size_t calls = 0;
+    return calls;
+}
+
+template <class T>
+struct count_allocator
+{
+    typedef T value_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef count_allocator<U> other;
+    };
+
+    count_allocator() = default;
+    template <class U>
+    count_allocator(const count_allocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        alloc_bytes() += n * sizeof(T);
+        ++alloc_calls();
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* ptr, size_t n)
+    {
+        alloc_bytes() -= n * sizeof(T);
+        ::operator delete(ptr);
+    }
+};
+
+template <class T1, class T2>
+bool operator==(const count_allocator<T1>&, const count_allocator<T2>&) { return true; }
+template <class T1, class T2>
+bool operator!=(const count_allocator<T1>&, const count_allocator<T2>&) { return false; }
+
+// 按序号生成容器的元素，set 类容器为 i，map 类容器为 (i, i)
+template <class T>
+struct bulk_value
+{
+    static T make(int i) { return T(i); }
+};
+
+template <template <class, class> class Pair, class K, class V>
+struct bulk_value<Pair<K, V>>
+{
+    static Pair<K, V> make(int i) { return Pair<K, V>(i, i); }
+};
+
 // 常用测试性能的宏
 #define FUN_TEST_FORMAT1(mode, fun, arg, count) do{             \
     srand((int)time(0));                                        \
@@ -597,14 +685,108 @@ void test_len(size_t len1, size_t len2, size_t len3, size_t wide)
     std::cout << std::setw(WIDE) << t;                          \
 }while(0)
 
-#define LIST_SORT_DO_TEST(mode, count) do{                      \
+// 生成排序测试的输入，pattern 为 0 时随机，1 时有序，2 时逆序，3 时只有 16 种不同的值，
+// 4 时基本有序（约 1% 的位置为随机值）
+inline void sort_input(std::vector<int>& v, int pattern)
+{
+    const int n = static_cast<int>(v.size());
+    for(int i = 0; i < n; ++i)
+    {
+        switch(pattern)
+        {
+        case 1:  v[i] = i;           break;
+        case 2:  v[i] = n - i;       break;
+        case 3:  v[i] = rand() % 16; break;
+        case 4:  v[i] = rand() % 100 ? i : rand(); break;
+        default: v[i] = rand();      break;
+        }
+    }
+}
+
+// fun 为 std::sort、mystl::stable_sort 等排序函数，对 len 个按 pattern 生成的整数排序
+#define SORT_DO_TEST(fun, pattern, len) do{                     \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    char buf[10];                                               \
+    std::vector<int> v(len);                                    \
+    sort_input(v, pattern);                                     \
+    start = clock();                                            \
+    fun(v.data(), v.data() + v.size());                         \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// fun 为 list 的排序成员函数（sort 或 pointer_sort），对 count 个按 pattern 生成的整数排序，只统计排序时间
+#define LIST_SORT_DO_TEST(mode, fun, pattern, count) do{        \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    char buf[16];                                               \
+    std::vector<int> v(count);                                  \
+    sort_input(v, pattern);                                     \
+    mode::list<int> l(v.data(), v.data() + v.size());           \
+    start = clock();                                            \
+    l.fun();                                                    \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// fun 为 std::stable_partition 或 mystl::stable_partition，把 len 个随机整数中的偶数放到前段
+#define PARTITION_DO_TEST(fun, len) do{                         \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    char buf[10];                                               \
+    std::vector<int> v(len);                                    \
+    for(auto& x : v)x = rand();                                 \
+    start = clock();                                            \
+    fun(v.data(), v.data() + v.size(),                          \
+        [](int x) { return x % 2 == 0; });                      \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// con 为队列，producers 个生产者与 consumers 个消费者线程每次搬运 batch 个元素，计时为墙上时间
+#define MT_QUEUE_DO_TEST(con, producers, consumers, batch, len) do{ \
+    char buf[16];                                               \
+    int n = mt_queue_run<con>(producers, consumers, batch, len);\
+    if(n < 0)                                                   \
+        std::snprintf(buf, sizeof(buf), "%s", "failed");        \
+    else                                                        \
+        std::snprintf(buf, sizeof(buf), "%d", n);               \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 使用 D 叉堆策略的 priority_queue<int>
+#define P_QUEUE_DARY(D) mystl::priority_queue<int, mystl::vector<int>, \
+    mystl::less<int>, mystl::dary_heap_policy<D>>
+
+// con 为优先队列，先 push len 个随机整数，再逐个 pop，计时包括两者
+#define P_QUEUE_DO_TEST(con, len) do{                           \
     srand((int)time(0));                                        \
     clock_t start, end;                                         \
-    mode::list<int> l;                                          \    
     char buf[10];                                               \
+    con c;                                                      \
     start = clock();                                            \
-    for(size_t i = 0; i < count; ++i)l.insert(l.end(), rand()); \
-    l.sort();                                                   \
+    for(size_t i = 0; i < len; ++i)                             \
+        c.push(rand());                                         \
+    while(!c.empty())                                           \
+        c.pop();                                                \
     end = clock();                                              \
     int n = static_cast<int>(static_cast<double>(end - start)   \
             / CLOCKS_PER_SEC * 1000);                           \
@@ -631,6 +813,398 @@ void test_len(size_t len1, size_t len2, size_t len3, size_t wide)
     std::cout << std::setw(WIDE) << t;                          \
 }while(0)
 
+// 只在 1024 个键值中随机插入，绝大多数插入的键值已经存在，衡量重复插入的开销
+#define MAP_DEDUP_DO_TEST(mode, con, len) do{                   \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    mode::con<int, int> c;                                      \
+    char buf[10];                                               \
+    start = clock();                                            \
+    for(size_t i = 0; i < len; ++i)                             \
+        c.emplace(rand() % 1024, static_cast<int>(i));          \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(c.size());                                      \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 先向 src 插入 len 个随机键值，再把全部元素逐个迁移到 dst
+// use_extract 为 false 时先 insert 元素的副本再 erase 原来的节点，为 true 时用 extract + insert(node_type)
+#define MAP_MIGRATE_DO_TEST(con, len, use_extract) do{          \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    con src, dst;                                               \
+    char buf[10];                                               \
+    for(size_t i = 0; i < len; ++i)                             \
+        src.emplace(rand(), static_cast<int>(i));               \
+    start = clock();                                            \
+    for(auto it = src.begin(); it != src.end(); )               \
+    {                                                           \
+        auto cur = it++;                                        \
+        if(use_extract)                                         \
+            dst.insert(src.extract(cur));                       \
+        else                                                    \
+        {                                                       \
+            dst.insert(mystl::move(*cur));                      \
+            src.erase(cur);                                     \
+        }                                                       \
+    }                                                           \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(dst.size());                                    \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 用 len 个已序（reversed 为 true 时为逆序）的元素构造容器 con
+#define BULK_LOAD_DO_TEST(con, len, reversed) do{               \
+    clock_t start, end;                                         \
+    std::vector<con::value_type> v;                             \
+    char buf[10];                                               \
+    v.reserve(len);                                             \
+    for(size_t i = 0; i < len; ++i)                             \
+        v.push_back(bulk_value<con::value_type>::make(          \
+            static_cast<int>(reversed ? len - i : i)));         \
+    start = clock();                                            \
+    con c(v.data(), v.data() + v.size());                       \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(c.size());                                      \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// con 为完整的容器类型，用键值与实值两个参数 emplace 随机键值，std 与 mystl 的容器都可以使用
+#define MAP_EMPLACE_KV_DO_TEST(con, len) do{                    \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    con c;                                                      \
+    char buf[10];                                               \
+    start = clock();                                            \
+    for(size_t i = 0; i < len; ++i)                             \
+        c.emplace(rand(), static_cast<int>(i));                 \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(c.size());                                      \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 先插入 len 个随机键值，再从头到尾遍历 10 次，衡量顺序访问全部元素的开销
+#define MAP_ITERATE_DO_TEST(con, len) do{                       \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    con c;                                                      \
+    char buf[10];                                               \
+    for(size_t i = 0; i < len; ++i)                             \
+        c.emplace(rand(), static_cast<int>(i));                 \
+    long long sum = 0;                                          \
+    start = clock();                                            \
+    for(int pass = 0; pass < 10; ++pass)                        \
+        for(auto it = c.begin(); it != c.end(); ++it)           \
+            sum += it->second;                                  \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(sum);                                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 用 len 个随机键值的 value_type 区间一次构造容器
+#define MAP_BUILD_DO_TEST(con, len) do{                         \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    char buf[10];                                               \
+    std::vector<con::value_type> v;                             \
+    v.reserve(len);                                             \
+    for(size_t i = 0; i < len; ++i)                             \
+        v.emplace_back(rand(), static_cast<int>(i));            \
+    start = clock();                                            \
+    con c(v.data(), v.data() + v.size());                       \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(c.size());                                      \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 与 MAP_FIND_DO_TEST 相同，但用区间一次构造容器，适用于逐个插入代价为 O(n) 的 flat_map
+#define MAP_BULK_FIND_DO_TEST(con, len) do{                     \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    char buf[10];                                               \
+    std::vector<con::value_type> v;                             \
+    v.reserve(len);                                             \
+    for(size_t i = 0; i < len; ++i)                             \
+        v.emplace_back(rand(), static_cast<int>(i));            \
+    con c(v.data(), v.data() + v.size());                       \
+    size_t hit = 0;                                             \
+    start = clock();                                            \
+    for(size_t i = 0; i < len; ++i)                             \
+    {                                                           \
+        hit += c.find(v[i * 7919 % len].first) != c.end();      \
+        hit += c.find(rand()) != c.end();                       \
+    }                                                           \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(hit);                                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// con 为完整的容器类型，如使用 mystl::pool_allocator 的容器或 flat_hash_map，与默认配置对比
+#define MAP_EMPLACE_POOL_DO_TEST(con, count) do{                \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    con c;                                                      \
+    char buf[10];                                               \
+    start = clock();                                            \
+    for(size_t i = 0; i < count; ++i)                           \
+        c.emplace(mystl::make_pair(rand(), rand()));            \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 先插入 count 个随机键值，再以打乱的次序查找全部键值，并查找同样多的随机键值（多数不命中）
+#define MAP_FIND_DO_TEST(con, count) do{                        \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    con c;                                                      \
+    char buf[10];                                               \
+    std::vector<int> keys(count);                               \
+    for(size_t i = 0; i < count; ++i)                           \
+    {                                                           \
+        keys[i] = rand();                                       \
+        c[keys[i]] = static_cast<int>(i);                       \
+    }                                                           \
+    size_t hit = 0;                                             \
+    start = clock();                                            \
+    for(size_t i = 0; i < count; ++i)                           \
+    {                                                           \
+        hit += c.find(keys[i * 7919 % count]) != c.end();       \
+        hit += c.find(rand()) != c.end();                       \
+    }                                                           \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(hit);                                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 以 len 个较长的 mystl::string 为键值，再以打乱的次序用 const char* 查找全部键值
+// 比较函数不透明时，每次查找都要先构造一个临时的 mystl::string
+#define MAP_CSTR_FIND_DO_TEST(con, len) do{                     \
+    srand((int)time(0));                                        \
+    clock_t start, end;                                         \
+    con c;                                                      \
+    char buf[10];                                               \
+    std::vector<mystl::string> keys(len);                       \
+    for(size_t i = 0; i < len; ++i)                             \
+    {                                                           \
+        char key[64];                                           \
+        std::snprintf(key, sizeof(key), "lookup-key-%08d-%d",   \
+                      static_cast<int>(i), rand());             \
+        keys[i] = key;                                          \
+        c[keys[i]] = static_cast<int>(i);                       \
+    }                                                           \
+    size_t hit = 0;                                             \
+    start = clock();                                            \
+    for(size_t i = 0; i < len; ++i)                             \
+        hit += c.find(keys[i * 7919 % len].c_str()) != c.end(); \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(hit);                                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 逐个插入 len 个随机键值并记录每次插入的耗时，输出第 permille 千分位的单次延迟，单位 us
+// permille 为 1000 时即最大延迟，整表扩容会在这里表现为一次很长的停顿
+#define MAP_INSERT_LATENCY_DO_TEST(con, len, permille) do{      \
+    typedef std::chrono::steady_clock lat_clock;                \
+    srand((int)time(0));                                        \
+    con c;                                                      \
+    char buf[16];                                               \
+    std::vector<double> lat(len);                               \
+    for(size_t i = 0; i < len; ++i)                             \
+    {                                                           \
+        lat_clock::time_point s = lat_clock::now();             \
+        c.emplace(rand(), static_cast<int>(i));                 \
+        lat[i] = std::chrono::duration<double, std::micro>(     \
+            lat_clock::now() - s).count();                      \
+    }                                                           \
+    size_t k = (len - 1) * (permille) / 1000;                   \
+    std::nth_element(lat.begin(), lat.begin() + k, lat.end());  \
+    std::snprintf(buf, sizeof(buf), "%.0f", lat[k]);            \
+    std::string t = buf;                                        \
+    t += "us    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 反复构造、修改短字符串，短字符串不申请堆空间时会快很多
+#define STR_SHORT_DO_TEST(mode, count) do{                      \
+    clock_t start, end;                                         \
+    char buf[10];                                               \
+    size_t total = 0;                                           \
+    start = clock();                                            \
+    for(size_t i = 0; i < count; ++i)                           \
+    {                                                           \
+        mode::string s("key");                                  \
+        s += static_cast<char>('a' + i % 26);                   \
+        mode::string t(s);                                      \
+        total += t.size();                                      \
+    }                                                           \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(total);                                         \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 对长度为 len 的字符串反复求哈希值，共处理 bytes 字节，输出吞吐量，单位 MB/s
+// 轮流对 16 个首字符不同的字符串求值，避免编译器把哈希计算提到循环外
+#define STR_HASH_DO_TEST(mode, len, bytes) do{                  \
+    clock_t start, end;                                         \
+    char buf[16];                                               \
+    mode::string keys[16];                                      \
+    for(size_t k = 0; k < 16; ++k)                              \
+    {                                                           \
+        keys[k] = mode::string(len, 'a');                       \
+        keys[k][0] = static_cast<char>('a' + k);                \
+    }                                                           \
+    mode::hash<mode::string> h;                                 \
+    const size_t rounds = (bytes) / (len);                      \
+    size_t total = 0;                                           \
+    start = clock();                                            \
+    for(size_t i = 0; i < rounds; ++i)                          \
+        total += h(keys[i & 15]);                               \
+    end = clock();                                              \
+    double sec = static_cast<double>(end - start)               \
+            / CLOCKS_PER_SEC + 1e-9;                            \
+    int n = static_cast<int>(rounds * (len) / sec / 1e6);       \
+    keep_result(total);                                         \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "MB/s  |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 统计 count 个空 vector 占用的内存（对象本身加上堆空间），单位 KB
+#define VECTOR_FOOTPRINT_DO_TEST(mode, count) do{               \
+    typedef mode::vector<int, count_allocator<int>> vec;        \
+    char buf[16];                                               \
+    alloc_bytes() = 0;                                          \
+    std::vector<vec> c(count);                                  \
+    size_t n = (alloc_bytes() + count * sizeof(vec)) / 1024;    \
+    std::snprintf(buf, sizeof(buf), "%d", static_cast<int>(n)); \
+    std::string t = buf;                                        \
+    t += "KB    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// 把 deque 当作保持 1024 个元素的队列，交替 push_back 与 pop_front 共 len 次，返回期间 allocate 的调用次数
+template <class Deque>
+size_t deque_fifo_run(size_t len)
+{
+    Deque d;
+    for(int i = 0; i < 1024; ++i)
+        d.push_back(i);
+    alloc_calls() = 0;
+    for(size_t i = 0; i < len; ++i)
+    {
+        d.push_back(static_cast<int>(i));
+        d.pop_front();
+    }
+    return alloc_calls();
+}
+
+// mode 为 std 或 mystl，输出上面的队列操作所用的时间
+#define DEQUE_FIFO_DO_TEST(mode, len) do{                       \
+    clock_t start, end;                                         \
+    char buf[16];                                               \
+    start = clock();                                            \
+    deque_fifo_run<mode::deque<int, count_allocator<int>>>(len);\
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// mode 为 std 或 mystl，输出上面的队列操作中 allocate 的调用次数
+#define DEQUE_FIFO_ALLOC_DO_TEST(mode, len) do{                 \
+    char buf[16];                                               \
+    size_t n = deque_fifo_run<mode::deque<int, count_allocator<int>>>(len); \
+    std::snprintf(buf, sizeof(buf), "%d", static_cast<int>(n)); \
+    std::string t = buf;                                        \
+    t += "      |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
+// deque 上的算法，d1 为源序列，d2 为目标序列，sum 累计 accumulate 的结果
+#define DEQUE_COPY(mode)        mode::copy(d1.begin(), d1.end(), d2.begin())
+#define DEQUE_FILL(mode)        mode::fill(d2.begin(), d2.end(), r)
+#define DEQUE_ACCUMULATE(mode)  sum += mode::accumulate(d1.begin(), d1.end(), 0LL)
+
+// mode 为 std 或 mystl，op 为以上三者之一，在 len 个元素的 deque<int> 上重复 100 次
+#define DEQUE_ALGO_DO_TEST(mode, op, len) do{                   \
+    clock_t start, end;                                         \
+    char buf[16];                                               \
+    mode::deque<int> d1(len, 1);                                \
+    mode::deque<int> d2(len);                                   \
+    long long sum = 0;                                          \
+    start = clock();                                            \
+    for(int r = 0; r < 100; ++r)                                \
+        op(mode);                                               \
+    end = clock();                                              \
+    int n = static_cast<int>(static_cast<double>(end - start)   \
+            / CLOCKS_PER_SEC * 1000);                           \
+    keep_result(sum);                                           \
+    keep_result(d2[0]);                                         \
+    std::snprintf(buf, sizeof(buf), "%d", n);                   \
+    std::string t = buf;                                        \
+    t += "ms    |";                                             \
+    std::cout << std::setw(WIDE) << t;                          \
+}while(0)
+
 // 重构重复代码
 #define CON_TEST_P1(con, fun, arg, len1, len2, len3)            \
     TEST_LEN(len1, len2, len3, WIDE);                           \
@@ -665,16 +1239,317 @@ void test_len(size_t len1, size_t len2, size_t len3, size_t wide)
     MAP_EMPLACE_DO_TEST(mystl, con, len2);                      \
     MAP_EMPLACE_DO_TEST(mystl, con, len3);
 
-#define LIST_SORT_TEST(len1, len2, len3)                        \
+#define MAP_DEDUP_TEST(con, len1, len2, len3)                   \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    MAP_DEDUP_DO_TEST(std, con, len1);                          \
+    MAP_DEDUP_DO_TEST(std, con, len2);                          \
+    MAP_DEDUP_DO_TEST(std, con, len3);                          \
+    std::cout << "\n|        mystl        |";                   \
+    MAP_DEDUP_DO_TEST(mystl, con, len1);                        \
+    MAP_DEDUP_DO_TEST(mystl, con, len2);                        \
+    MAP_DEDUP_DO_TEST(mystl, con, len3);
+
+#define CON_POOL_TEST_P2(con, fun, arg1, arg2, len1, len2, len3) \
+    std::cout << "\n|        pool         |";                   \
+    FUN_TEST_FORMAT2(con, fun, arg1, arg2, len1);               \
+    FUN_TEST_FORMAT2(con, fun, arg1, arg2, len2);               \
+    FUN_TEST_FORMAT2(con, fun, arg1, arg2, len3);
+
+#define MAP_EMPLACE_POOL_TEST(con, len1, len2, len3)            \
+    std::cout << "\n|        pool         |";                   \
+    MAP_EMPLACE_POOL_DO_TEST(con, len1);                        \
+    MAP_EMPLACE_POOL_DO_TEST(con, len2);                        \
+    MAP_EMPLACE_POOL_DO_TEST(con, len3);
+
+#define MAP_EMPLACE_FLAT_TEST(con, len1, len2, len3)            \
+    std::cout << "\n|        flat         |";                   \
+    MAP_EMPLACE_POOL_DO_TEST(con, len1);                        \
+    MAP_EMPLACE_POOL_DO_TEST(con, len2);                        \
+    MAP_EMPLACE_POOL_DO_TEST(con, len3);
+
+#define MAP_EMPLACE_RANK_TEST(con, len1, len2, len3)            \
+    std::cout << "\n|       ranked        |";                   \
+    MAP_EMPLACE_POOL_DO_TEST(con, len1);                        \
+    MAP_EMPLACE_POOL_DO_TEST(con, len2);                        \
+    MAP_EMPLACE_POOL_DO_TEST(con, len3);
+
+#define MAP_FIND_TEST(con, flat_con, len1, len2, len3)          \
+{                                                               \
+    typedef std::con<int, int>   std_find_con;                  \
+    typedef mystl::con<int, int> mystl_find_con;                \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    MAP_FIND_DO_TEST(std_find_con, len1);                       \
+    MAP_FIND_DO_TEST(std_find_con, len2);                       \
+    MAP_FIND_DO_TEST(std_find_con, len3);                       \
+    std::cout << "\n|        mystl        |";                   \
+    MAP_FIND_DO_TEST(mystl_find_con, len1);                     \
+    MAP_FIND_DO_TEST(mystl_find_con, len2);                     \
+    MAP_FIND_DO_TEST(mystl_find_con, len3);                     \
+    std::cout << "\n|        flat         |";                   \
+    MAP_FIND_DO_TEST(flat_con, len1);                           \
+    MAP_FIND_DO_TEST(flat_con, len2);                           \
+    MAP_FIND_DO_TEST(flat_con, len3);                           \
+}
+
+#define MAP_FIND_POW2_TEST(con, len1, len2, len3)               \
+    std::cout << "\n|        pow2         |";                   \
+    MAP_FIND_DO_TEST(con, len1);                                \
+    MAP_FIND_DO_TEST(con, len2);                                \
+    MAP_FIND_DO_TEST(con, len3);
+
+#define MAP_CSTR_FIND_TEST(con, tr_con, len1, len2, len3)      \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|        mystl        |";                     \
+    MAP_CSTR_FIND_DO_TEST(con, len1);                           \
+    MAP_CSTR_FIND_DO_TEST(con, len2);                           \
+    MAP_CSTR_FIND_DO_TEST(con, len3);                           \
+    std::cout << "\n|     transparent     |";                   \
+    MAP_CSTR_FIND_DO_TEST(tr_con, len1);                        \
+    MAP_CSTR_FIND_DO_TEST(tr_con, len2);                        \
+    MAP_CSTR_FIND_DO_TEST(tr_con, len3);
+
+#define MAP_INSERT_LATENCY_TEST(con, inc_con, permille, len1, len2, len3) \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|        mystl        |";                     \
+    MAP_INSERT_LATENCY_DO_TEST(con, len1, permille);            \
+    MAP_INSERT_LATENCY_DO_TEST(con, len2, permille);            \
+    MAP_INSERT_LATENCY_DO_TEST(con, len3, permille);            \
+    std::cout << "\n|     incremental     |";                   \
+    MAP_INSERT_LATENCY_DO_TEST(inc_con, len1, permille);        \
+    MAP_INSERT_LATENCY_DO_TEST(inc_con, len2, permille);        \
+    MAP_INSERT_LATENCY_DO_TEST(inc_con, len3, permille);
+
+#define MAP_MIGRATE_TEST(con, len1, len2, len3)                 \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|    erase+insert     |";                     \
+    MAP_MIGRATE_DO_TEST(con, len1, false);                      \
+    MAP_MIGRATE_DO_TEST(con, len2, false);                      \
+    MAP_MIGRATE_DO_TEST(con, len3, false);                      \
+    std::cout << "\n|       extract       |";                   \
+    MAP_MIGRATE_DO_TEST(con, len1, true);                       \
+    MAP_MIGRATE_DO_TEST(con, len2, true);                       \
+    MAP_MIGRATE_DO_TEST(con, len3, true);
+
+#define BULK_LOAD_TEST(std_con, mystl_con, reversed, len1, len2, len3) \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    BULK_LOAD_DO_TEST(std_con, len1, reversed);                 \
+    BULK_LOAD_DO_TEST(std_con, len2, reversed);                 \
+    BULK_LOAD_DO_TEST(std_con, len3, reversed);                 \
+    std::cout << "\n|        mystl        |";                   \
+    BULK_LOAD_DO_TEST(mystl_con, len1, reversed);               \
+    BULK_LOAD_DO_TEST(mystl_con, len2, reversed);               \
+    BULK_LOAD_DO_TEST(mystl_con, len3, reversed);
+
+// 对比 std::map、以 rb_tree 为底层的 mystl::map 与 btree_map，do_test 为上面的 *_DO_TEST(con, len)
+#define MAP_TREE_TEST(do_test, std_con, mystl_con, btree_con, len1, len2, len3) \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    do_test(std_con, len1);                                     \
+    do_test(std_con, len2);                                     \
+    do_test(std_con, len3);                                     \
+    std::cout << "\n|        mystl        |";                   \
+    do_test(mystl_con, len1);                                   \
+    do_test(mystl_con, len2);                                   \
+    do_test(mystl_con, len3);                                   \
+    std::cout << "\n|        btree        |";                   \
+    do_test(btree_con, len1);                                   \
+    do_test(btree_con, len2);                                   \
+    do_test(btree_con, len3);
+
+// 对比 std::map、mystl::map 与 flat_map，do_test 为上面的 *_DO_TEST(con, len)
+#define MAP_SORTED_TEST(do_test, std_con, mystl_con, flat_con, len1, len2, len3) \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    do_test(std_con, len1);                                     \
+    do_test(std_con, len2);                                     \
+    do_test(std_con, len3);                                     \
+    std::cout << "\n|        mystl        |";                   \
+    do_test(mystl_con, len1);                                   \
+    do_test(mystl_con, len2);                                   \
+    do_test(mystl_con, len3);                                   \
+    std::cout << "\n|      flat_map       |";                   \
+    do_test(flat_con, len1);                                    \
+    do_test(flat_con, len2);                                    \
+    do_test(flat_con, len3);
+
+// 对比 std::list::sort 与 mystl::list 的 sort、pointer_sort，pattern 的含义同 sort_input
+#define LIST_SORT_TEST(pattern, len1, len2, len3)               \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    LIST_SORT_DO_TEST(std, sort, pattern, len1);                \
+    LIST_SORT_DO_TEST(std, sort, pattern, len2);                \
+    LIST_SORT_DO_TEST(std, sort, pattern, len3);                \
+    std::cout << "\n|        mystl        |";                   \
+    LIST_SORT_DO_TEST(mystl, sort, pattern, len1);              \
+    LIST_SORT_DO_TEST(mystl, sort, pattern, len2);              \
+    LIST_SORT_DO_TEST(mystl, sort, pattern, len3);              \
+    std::cout << "\n| mystl pointer_sort  |";                   \
+    LIST_SORT_DO_TEST(mystl, pointer_sort, pattern, len1);      \
+    LIST_SORT_DO_TEST(mystl, pointer_sort, pattern, len2);      \
+    LIST_SORT_DO_TEST(mystl, pointer_sort, pattern, len3);
+
+// 对比 std 与 mystl 的 sort 和 stable_sort，inplace_stable_sort 为申请不到缓冲区时 stable_sort 的做法
+#define SORT_TEST(len1, len2, len3)                             \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|      std::sort      |";                     \
+    SORT_DO_TEST(std::sort, 0, len1);                           \
+    SORT_DO_TEST(std::sort, 0, len2);                           \
+    SORT_DO_TEST(std::sort, 0, len3);                           \
+    std::cout << "\n|     mystl::sort     |";                   \
+    SORT_DO_TEST(mystl::sort, 0, len1);                         \
+    SORT_DO_TEST(mystl::sort, 0, len2);                         \
+    SORT_DO_TEST(mystl::sort, 0, len3);                         \
+    std::cout << "\n|  std::stable_sort   |";                   \
+    SORT_DO_TEST(std::stable_sort, 0, len1);                    \
+    SORT_DO_TEST(std::stable_sort, 0, len2);                    \
+    SORT_DO_TEST(std::stable_sort, 0, len3);                    \
+    std::cout << "\n| mystl::stable_sort  |";                   \
+    SORT_DO_TEST(mystl::stable_sort, 0, len1);                  \
+    SORT_DO_TEST(mystl::stable_sort, 0, len2);                  \
+    SORT_DO_TEST(mystl::stable_sort, 0, len3);                  \
+    std::cout << "\n| inplace_stable_sort |";                   \
+    SORT_DO_TEST(mystl::inplace_stable_sort, 0, len1);          \
+    SORT_DO_TEST(mystl::inplace_stable_sort, 0, len2);          \
+    SORT_DO_TEST(mystl::inplace_stable_sort, 0, len3);
+
+// 对比 std::sort 与 mystl::sort 在不同输入下的表现，pattern 的含义同 sort_input
+#define SORT_PATTERN_TEST(pattern, len1, len2, len3)            \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    SORT_DO_TEST(std::sort, pattern, len1);                     \
+    SORT_DO_TEST(std::sort, pattern, len2);                     \
+    SORT_DO_TEST(std::sort, pattern, len3);                     \
+    std::cout << "\n|        mystl        |";                   \
+    SORT_DO_TEST(mystl::sort, pattern, len1);                   \
+    SORT_DO_TEST(mystl::sort, pattern, len2);                   \
+    SORT_DO_TEST(mystl::sort, pattern, len3);
+
+#define PARTITION_TEST(len1, len2, len3)                        \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    PARTITION_DO_TEST(std::stable_partition, len1);             \
+    PARTITION_DO_TEST(std::stable_partition, len2);             \
+    PARTITION_DO_TEST(std::stable_partition, len3);             \
+    std::cout << "\n|        mystl        |";                   \
+    PARTITION_DO_TEST(mystl::stable_partition, len1);           \
+    PARTITION_DO_TEST(mystl::stable_partition, len2);           \
+    PARTITION_DO_TEST(mystl::stable_partition, len3);
+
+#define P_QUEUE_TEST(len1, len2, len3)                          \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    P_QUEUE_DO_TEST(std::priority_queue<int>, len1);            \
+    P_QUEUE_DO_TEST(std::priority_queue<int>, len2);            \
+    P_QUEUE_DO_TEST(std::priority_queue<int>, len3);            \
+    std::cout << "\n|    mystl (binary)   |";                   \
+    P_QUEUE_DO_TEST(mystl::priority_queue<int>, len1);          \
+    P_QUEUE_DO_TEST(mystl::priority_queue<int>, len2);          \
+    P_QUEUE_DO_TEST(mystl::priority_queue<int>, len3);          \
+    std::cout << "\n|    mystl (4-ary)    |";                   \
+    P_QUEUE_DO_TEST(P_QUEUE_DARY(4), len1);                     \
+    P_QUEUE_DO_TEST(P_QUEUE_DARY(4), len2);                     \
+    P_QUEUE_DO_TEST(P_QUEUE_DARY(4), len3);                     \
+    std::cout << "\n|    mystl (8-ary)    |";                   \
+    P_QUEUE_DO_TEST(P_QUEUE_DARY(8), len1);                     \
+    P_QUEUE_DO_TEST(P_QUEUE_DARY(8), len2);                     \
+    P_QUEUE_DO_TEST(P_QUEUE_DARY(8), len3);                     \
+    std::cout << "\n|    pairing_heap     |";                   \
+    P_QUEUE_DO_TEST(mystl::pairing_heap<int>, len1);            \
+    P_QUEUE_DO_TEST(mystl::pairing_heap<int>, len2);            \
+    P_QUEUE_DO_TEST(mystl::pairing_heap<int>, len3);
+
+// 单个元素搬运时 spsc_queue 只用于一个生产者和一个消费者
+#define MT_QUEUE_TEST(p, c, len1, len2, len3)                   \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|    mutex + queue    |";                     \
+    MT_QUEUE_DO_TEST(locked_queue, p, c, 1, len1);              \
+    MT_QUEUE_DO_TEST(locked_queue, p, c, 1, len2);              \
+    MT_QUEUE_DO_TEST(locked_queue, p, c, 1, len3);              \
+    if(p == 1 && c == 1)                                        \
+    {                                                           \
+        std::cout << "\n|     spsc_queue      |";               \
+        MT_QUEUE_DO_TEST(mystl::spsc_queue<int>, p, c, 1, len1);\
+        MT_QUEUE_DO_TEST(mystl::spsc_queue<int>, p, c, 1, len2);\
+        MT_QUEUE_DO_TEST(mystl::spsc_queue<int>, p, c, 1, len3);\
+        std::cout << "\n|  spsc_queue (x64)   |";               \
+        MT_QUEUE_DO_TEST(mystl::spsc_queue<int>, p, c, 64, len1);\
+        MT_QUEUE_DO_TEST(mystl::spsc_queue<int>, p, c, 64, len2);\
+        MT_QUEUE_DO_TEST(mystl::spsc_queue<int>, p, c, 64, len3);\
+    }                                                           \
+    std::cout << "\n|     mpmc_queue      |";                   \
+    MT_QUEUE_DO_TEST(mystl::mpmc_queue<int>, p, c, 1, len1);    \
+    MT_QUEUE_DO_TEST(mystl::mpmc_queue<int>, p, c, 1, len2);    \
+    MT_QUEUE_DO_TEST(mystl::mpmc_queue<int>, p, c, 1, len3);    \
+    std::cout << "\n|  mpmc_queue (x64)   |";                   \
+    MT_QUEUE_DO_TEST(mystl::mpmc_queue<int>, p, c, 64, len1);   \
+    MT_QUEUE_DO_TEST(mystl::mpmc_queue<int>, p, c, 64, len2);   \
+    MT_QUEUE_DO_TEST(mystl::mpmc_queue<int>, p, c, 64, len3);
+
+#define DEQUE_FIFO_TEST(len1, len2, len3)                       \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|      std (ms)       |";                     \
+    DEQUE_FIFO_DO_TEST(std, len1);                              \
+    DEQUE_FIFO_DO_TEST(std, len2);                              \
+    DEQUE_FIFO_DO_TEST(std, len3);                              \
+    std::cout << "\n|     mystl (ms)      |";                   \
+    DEQUE_FIFO_DO_TEST(mystl, len1);                            \
+    DEQUE_FIFO_DO_TEST(mystl, len2);                            \
+    DEQUE_FIFO_DO_TEST(mystl, len3);                            \
+    std::cout << "\n|    std (allocs)     |";                   \
+    DEQUE_FIFO_ALLOC_DO_TEST(std, len1);                        \
+    DEQUE_FIFO_ALLOC_DO_TEST(std, len2);                        \
+    DEQUE_FIFO_ALLOC_DO_TEST(std, len3);                        \
+    std::cout << "\n|   mystl (allocs)    |";                   \
+    DEQUE_FIFO_ALLOC_DO_TEST(mystl, len1);                      \
+    DEQUE_FIFO_ALLOC_DO_TEST(mystl, len2);                      \
+    DEQUE_FIFO_ALLOC_DO_TEST(mystl, len3);
+
+#define DEQUE_ALGO_TEST(op, len1, len2, len3)                    \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    DEQUE_ALGO_DO_TEST(std, op, len1);                          \
+    DEQUE_ALGO_DO_TEST(std, op, len2);                          \
+    DEQUE_ALGO_DO_TEST(std, op, len3);                          \
+    std::cout << "\n|        mystl        |";                   \
+    DEQUE_ALGO_DO_TEST(mystl, op, len1);                        \
+    DEQUE_ALGO_DO_TEST(mystl, op, len2);                        \
+    DEQUE_ALGO_DO_TEST(mystl, op, len3);
+
+#define STR_SHORT_TEST(len1, len2, len3)                        \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    STR_SHORT_DO_TEST(std, len1);                               \
+    STR_SHORT_DO_TEST(std, len2);                               \
+    STR_SHORT_DO_TEST(std, len3);                               \
+    std::cout << "\n|        mystl        |";                   \
+    STR_SHORT_DO_TEST(mystl, len1);                             \
+    STR_SHORT_DO_TEST(mystl, len2);                             \
+    STR_SHORT_DO_TEST(mystl, len3);
+
+#define STR_HASH_TEST(len1, len2, len3, bytes)                  \
+    TEST_LEN(len1, len2, len3, WIDE);                           \
+    std::cout << "|         std         |";                     \
+    STR_HASH_DO_TEST(std, len1, bytes);                         \
+    STR_HASH_DO_TEST(std, len2, bytes);                         \
+    STR_HASH_DO_TEST(std, len3, bytes);                         \
+    std::cout << "\n|        mystl        |";                   \
+    STR_HASH_DO_TEST(mystl, len1, bytes);                       \
+    STR_HASH_DO_TEST(mystl, len2, bytes);                       \
+    STR_HASH_DO_TEST(mystl, len3, bytes);
+
+#define VECTOR_FOOTPRINT_TEST(len1, len2, len3)                 \
     TEST_LEN(len1, len2, len3, WIDE);                           \
     std::cout << "|         std         |";                     \
-    LIST_SORT_DO_TEST(std, len1);                               \
-    LIST_SORT_DO_TEST(std, len2);                               \
-    LIST_SORT_DO_TEST(std, len3);                               \
+    VECTOR_FOOTPRINT_DO_TEST(std, len1);                        \
+    VECTOR_FOOTPRINT_DO_TEST(std, len2);                        \
+    VECTOR_FOOTPRINT_DO_TEST(std, len3);                        \
     std::cout << "\n|        mystl        |";                   \
-    LIST_SORT_DO_TEST(mystl, len1);                             \
-    LIST_SORT_DO_TEST(mystl, len2);                             \
-    LIST_SORT_DO_TEST(mystl, len3);           
+    VECTOR_FOOTPRINT_DO_TEST(mystl, len1);                      \
+    VECTOR_FOOTPRINT_DO_TEST(mystl, len2);                      \
+    VECTOR_FOOTPRINT_DO_TEST(mystl, len3);
 
 // 简单测试的宏定义
 #define TEST(testcase_name) MYTINYSTL_TEST_(testcase_name)
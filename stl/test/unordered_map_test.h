@@ -1,11 +1,16 @@
 #ifndef MYTINYSTL_UNORDERED_MAP_TEST_H_
 #define MYTINYSTL_UNORDERED_MAP_TEST_H_
 
-// unordered_map test : 测试 unordered_map, unordered_multimap 的接口与它们 insert 的性能
+// unordered_map test : 测试 unordered_map, unordered_multimap, flat_hash_map 的接口与它们 insert 的性能，
+// 以及使用 pool_allocator 时的性能、find 的性能（含 2 的幂次 bucket 策略）、渐进式 rehash 的插入延迟，
+// 用 const char* 异构查找 mystl::string 键值的性能，重复键值插入的性能，以及用 extract 迁移元素的性能
 
 #include <unordered_map>
 
 #include "../mytinystl/unordered_map.h"
+#include "../mytinystl/flat_hash_map.h"
+#include "../mytinystl/pool_allocator.h"
+#include "../mytinystl/astring.h"
 #include "test.h"
 
 namespace mystl
@@ -17,6 +22,15 @@ namespace test
 namespace unordered_map_test
 {
 
+// 记录默认构造次数的实值类型，用于检查 operator[] 只在插入时构造实值
+struct counted_value
+{
+    static int ctor_count;
+    int v;
+    counted_value() : v(0) { ++ctor_count; }
+};
+int counted_value::ctor_count = 0;
+
 void unordered_map_test()
 {
     std::cout << "[===============================================================]" << std::endl;
@@ -42,6 +56,15 @@ void unordered_map_test()
     mystl::unordered_map<int, int> um13 { PAIR(1, 1), PAIR(2 , 3), PAIR(3, 3) };
     mystl::unordered_map<int, int> um14;
     um14 = { PAIR(1, 1), PAIR(2, 3), PAIR(3, 3) };
+    mystl::unordered_map<int, int, mystl::hash<int>, mystl::equal_to<int>,
+        mystl::pool_allocator<mystl::pair<const int, int>>> um15(v.begin(), v.end());
+    mystl::unordered_map<mystl::string, int> um16;
+    mystl::unordered_map<int, int, mystl::hash<int>, mystl::equal_to<int>,
+        mystl::allocator<mystl::pair<const int, int>>, mystl::ht_pow2_policy> um17(v.begin(), v.end());
+    mystl::unordered_map<int, int, mystl::hash<int>, mystl::equal_to<int>,
+        mystl::allocator<mystl::pair<const int, int>>,
+        mystl::ht_incremental_policy<mystl::ht_prime_policy>> um18(v.begin(), v.end());
+    mystl::unordered_map<mystl::string, int, mystl::string_hash<>, mystl::equal_to<>> um19;
 
     MAP_FUN_AFTER(um1, um1.emplace(1, 1));
     MAP_FUN_AFTER(um1, um1.emplace_hint(um1.begin(), 1, 2));
@@ -91,15 +114,137 @@ void unordered_map_test()
     FUN_VALUE(um1.max_load_factor());
     MAP_FUN_AFTER(um1, um1.max_load_factor(1.5f));
     FUN_VALUE(um1.max_load_factor());
+    MAP_FUN_AFTER(um15, um15.emplace(6, 6));
+    MAP_FUN_AFTER(um15, um15.erase(5));
+    MAP_FUN_AFTER(um15, um15.insert(PAIR(1, 2)));
+    MAP_FUN_AFTER(um16, um16.emplace(mystl::string("apple"), 1));
+    MAP_FUN_AFTER(um16, um16.emplace(mystl::string("banana"), 2));
+    MAP_FUN_AFTER(um16, um16[mystl::string("cherry")] = 3);
+    FUN_VALUE(um16.count(mystl::string("banana")));
+    FUN_VALUE(um16.count(mystl::string("durian")));
+    FUN_VALUE(um17.bucket_count());
+    MAP_FUN_AFTER(um17, um17.reserve(1000));
+    FUN_VALUE(um17.bucket_count());
+    FUN_VALUE(um17.count(3));
+    for (int i = 6; i <= 200; ++i)
+        um18.emplace(i, i);
+    FUN_VALUE(um18.size());
+    FUN_VALUE(um18.count(3));
+    FUN_VALUE(um18.count(150));
+    MAP_FUN_AFTER(um18, um18.erase(um18.find(6), um18.end()));
+    FUN_VALUE(um18.size());
+    MAP_FUN_AFTER(um19, um19.emplace(mystl::string("apple"), 1));
+    MAP_FUN_AFTER(um19, um19.emplace(mystl::string("banana"), 2));
+    FUN_VALUE(um19.count("banana"));
+    FUN_VALUE(um19.count("cherry"));
+    FUN_VALUE(um19.find("apple")->second);
+    FUN_VALUE(um19.try_emplace(mystl::string("apple"), 5).second);
+    FUN_VALUE(um19.try_emplace(mystl::string("cherry"), 3).second);
+    FUN_VALUE(um19.insert_or_assign(mystl::string("apple"), 4).second);
+    FUN_VALUE(um19["apple"]);
+    FUN_VALUE(um19["cherry"]);
+    MAP_FUN_AFTER(um13, um13.insert(um17.extract(4)));
+    FUN_VALUE(um13.insert(um17.extract(1)).inserted);
+    MAP_FUN_AFTER(um13, um13.merge(um17));
+    FUN_VALUE(um17.size());
+    // 表格恰好装满时插入重复键值，不应触发扩容
+    mystl::unordered_map<int, int> um20;
+    for (int i = 0; static_cast<float>(um20.size() + 1) <= um20.bucket_count() * um20.max_load_factor(); ++i)
+        um20.emplace(i, i);
+    const size_t bc = um20.bucket_count();
+    um20.emplace(0, 1);
+    um20.insert(PAIR(1, 1));
+    um20.try_emplace(2, 1);
+    um20[3] = 1;
+    EXPECT_TRUE(um20.bucket_count() == bc && um20.at(0) == 0 && um20.at(3) == 1);
+    um20.emplace(-1, -1);
+    EXPECT_TRUE(um20.bucket_count() > bc && um20.count(-1) == 1 && um20.at(2) == 2);
+    // 被移动后的表没有 bucket，之后仍然可以插入
+    mystl::unordered_map<int, int> um21(um20);
+    mystl::unordered_map<int, int> um22(mystl::move(um21));
+    um20 = mystl::move(um22);
+    um21.emplace(1, 1);
+    um22.insert(PAIR(2, 2));
+    um22[3] = 3;
+    EXPECT_TRUE(um21.size() == 1 && um21.at(1) == 1 && um22.size() == 2 && um22.at(3) == 3);
     PASSED;
 #if PERFORMANCE_TEST_ON
+    typedef mystl::unordered_map<int, int, mystl::hash<int>, mystl::equal_to<int>, mystl::pool_allocator<mystl::pair<const int, int>>>
+        pool_unordered_map;
+    typedef mystl::flat_hash_map<int, int> flat_map;
+    typedef mystl::unordered_map<int, int, mystl::hash<int>, mystl::equal_to<int>,
+        mystl::allocator<mystl::pair<const int, int>>, mystl::ht_pow2_policy> pow2_unordered_map;
+    typedef mystl::unordered_map<int, int, mystl::hash<int>, mystl::equal_to<int>,
+        mystl::allocator<mystl::pair<const int, int>>,
+        mystl::ht_incremental_policy<mystl::ht_prime_policy>> inc_unordered_map;
+    typedef mystl::unordered_map<int, int> plain_unordered_map;
+    typedef mystl::unordered_map<mystl::string, int> str_unordered_map;
+    typedef mystl::unordered_map<mystl::string, int, mystl::string_hash<>, mystl::equal_to<>> tr_str_unordered_map;
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     std::cout << "|       emplace       |";
 #if LARGER_TEST_DATA_ON
     MAP_EMPLACE_TEST(unordered_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_unordered_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_EMPLACE_FLAT_TEST(flat_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #else
     MAP_EMPLACE_TEST(unordered_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_unordered_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+    MAP_EMPLACE_FLAT_TEST(flat_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|        find         |";
+#if LARGER_TEST_DATA_ON
+    MAP_FIND_TEST(unordered_map, flat_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_FIND_POW2_TEST(pow2_unordered_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_FIND_TEST(unordered_map, flat_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+    MAP_FIND_POW2_TEST(pow2_unordered_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|    emplace (dup)    |";
+#if LARGER_TEST_DATA_ON
+    MAP_DEDUP_TEST(unordered_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_DEDUP_TEST(unordered_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "| find (const char*)  |";
+#if LARGER_TEST_DATA_ON
+    MAP_CSTR_FIND_TEST(str_unordered_map, tr_str_unordered_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_CSTR_FIND_TEST(str_unordered_map, tr_str_unordered_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|  insert p999 (us)   |";
+#if LARGER_TEST_DATA_ON
+    MAP_INSERT_LATENCY_TEST(plain_unordered_map, inc_unordered_map, 999,
+                            SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_INSERT_LATENCY_TEST(plain_unordered_map, inc_unordered_map, 999,
+                            SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|   insert max (us)   |";
+#if LARGER_TEST_DATA_ON
+    MAP_INSERT_LATENCY_TEST(plain_unordered_map, inc_unordered_map, 1000,
+                            SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_INSERT_LATENCY_TEST(plain_unordered_map, inc_unordered_map, 1000,
+                            SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+#endif
+    std::cout << std::endl;
+    std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
+    std::cout << "|       migrate       |";
+#if LARGER_TEST_DATA_ON
+    MAP_MIGRATE_TEST(plain_unordered_map, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+#else
+    MAP_MIGRATE_TEST(plain_unordered_map, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
@@ -180,15 +325,21 @@ void unordered_multimap_test()
     FUN_VALUE(um1.max_load_factor());
     MAP_FUN_AFTER(um1, um1.max_load_factor(1.5f));
     FUN_VALUE(um1.max_load_factor());
+    MAP_FUN_AFTER(um1, um1.insert(um13.extract(2)));
+    MAP_FUN_AFTER(um1, um1.merge(um14));
     PASSED;
 #if PERFORMANCE_TEST_ON
+    typedef mystl::unordered_multimap<int, int, mystl::hash<int>, mystl::equal_to<int>, mystl::pool_allocator<mystl::pair<const int, int>>>
+        pool_unordered_multimap;
     std::cout << "[--------------------- Performance Testing ---------------------]" << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
     std::cout << "|       emplace       |";
 #if LARGER_TEST_DATA_ON
     MAP_EMPLACE_TEST(unordered_multimap, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_unordered_multimap, SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
 #else
     MAP_EMPLACE_TEST(unordered_multimap, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
+    MAP_EMPLACE_POOL_TEST(pool_unordered_multimap, SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
 #endif
     std::cout << std::endl;
     std::cout << "|---------------------|-------------|-------------|-------------|" << std::endl;
@@ -197,6 +348,87 @@ void unordered_multimap_test()
     std::cout << "[----------- End container test : unordered_multimap -----------]" << std::endl;
 }
 
+void flat_hash_map_test()
+{
+    std::cout << "[===============================================================]" << std::endl;
+    std::cout << "[-------------- Run container test : flat_hash_map -------------]" << std::endl;
+    std::cout << "[-------------------------- API test ---------------------------]" << std::endl;
+    mystl::vector<PAIR> v;
+    for (int i = 0; i < 5; ++i)
+        v.push_back(PAIR(5 - i, 5 - i));
+    mystl::flat_hash_map<int, int> fm1;
+    mystl::flat_hash_map<int, int> fm2(520);
+    mystl::flat_hash_map<int, int> fm3(520, mystl::hash<int>());
+    mystl::flat_hash_map<int, int> fm4(520, mystl::hash<int>(), mystl::equal_to<int>());
+    mystl::flat_hash_map<int, int> fm5(v.begin(), v.end());
+    mystl::flat_hash_map<int, int> fm6(v.begin(), v.end(), 100);
+    mystl::flat_hash_map<int, int> fm7(v.begin(), v.end(), 100, mystl::hash<int>());
+    mystl::flat_hash_map<int, int> fm8(v.begin(), v.end(), 100, mystl::hash<int>(), mystl::equal_to<int>());
+    mystl::flat_hash_map<int, int> fm9(fm5);
+    mystl::flat_hash_map<int, int> fm10(std::move(fm5));
+    mystl::flat_hash_map<int, int> fm11;
+    fm11 = fm6;
+    mystl::flat_hash_map<int, int> fm12;
+    fm12 = std::move(fm6);
+    mystl::flat_hash_map<int, int> fm13 { PAIR(1, 1), PAIR(2 , 3), PAIR(3, 3) };
+    mystl::flat_hash_map<int, int> fm14;
+    fm14 = { PAIR(1, 1), PAIR(2, 3), PAIR(3, 3) };
+    mystl::flat_hash_map<mystl::string, int> fm15;
+
+    MAP_FUN_AFTER(fm1, fm1.emplace(1, 1));
+    MAP_FUN_AFTER(fm1, fm1.emplace_hint(fm1.begin(), 1, 2));
+    MAP_FUN_AFTER(fm1, fm1.insert(PAIR(2, 2)));
+    MAP_FUN_AFTER(fm1, fm1.insert(fm1.end(), PAIR(3, 3)));
+    MAP_FUN_AFTER(fm1, fm1.insert(v.begin(), v.end()));
+    MAP_FUN_AFTER(fm1, fm1.erase(fm1.begin()));
+    MAP_FUN_AFTER(fm1, fm1.erase(fm1.begin(), fm1.find(3)));
+    MAP_FUN_AFTER(fm1, fm1.erase(1));
+    std::cout << std::boolalpha;
+    FUN_VALUE(fm1.empty());
+    std::cout << std::noboolalpha;
+    FUN_VALUE(fm1.size());
+    FUN_VALUE(fm1.bucket_count());
+    FUN_VALUE(fm1.max_bucket_count());
+    MAP_FUN_AFTER(fm1, fm1.clear());
+    MAP_FUN_AFTER(fm1, fm1.swap(fm7));
+    MAP_VALUE(*fm1.begin());
+    FUN_VALUE(fm1.at(1));
+    FUN_VALUE(fm1[1]);
+    MAP_FUN_AFTER(fm1, fm1[6] = 6);
+    std::cout << std::boolalpha;
+    FUN_VALUE(fm1.empty());
+    FUN_VALUE((fm1 == fm8));
+    std::cout << std::noboolalpha;
+    FUN_VALUE(fm1.size());
+    FUN_VALUE(fm1.max_size());
+    MAP_FUN_AFTER(fm1, fm1.reserve(1000));
+    FUN_VALUE(fm1.size());
+    FUN_VALUE(fm1.bucket_count());
+    MAP_FUN_AFTER(fm1, fm1.rehash(150));
+    FUN_VALUE(fm1.bucket_count());
+    FUN_VALUE(fm1.count(1));
+    MAP_VALUE(*fm1.find(3));
+    auto first = *fm1.equal_range(3).first;
+    std::cout << " fm1.equal_range(3).first : <" << first.first << ", " << first.second << ">" << std::endl;
+    FUN_VALUE(fm1.load_factor());
+    FUN_VALUE(fm1.max_load_factor());
+    MAP_FUN_AFTER(fm1, fm1.max_load_factor(0.5f));
+    FUN_VALUE(fm1.max_load_factor());
+    MAP_FUN_AFTER(fm15, fm15.emplace(mystl::string("apple"), 1));
+    MAP_FUN_AFTER(fm15, fm15.emplace(mystl::string("banana"), 2));
+    MAP_FUN_AFTER(fm15, fm15[mystl::string("cherry")] = 3);
+    FUN_VALUE(fm15.count(mystl::string("banana")));
+    FUN_VALUE(fm15.count(mystl::string("durian")));
+    mystl::flat_hash_map<int, counted_value> fm16;
+    fm16[1].v = 1;
+    EXPECT_TRUE(counted_value::ctor_count == 1);
+    fm16[1].v = 2;
+    EXPECT_TRUE(counted_value::ctor_count == 1 && fm16[1].v == 2);
+    static_assert(noexcept(fm1 = std::move(fm2)), "flat_hash_map move assignment should be noexcept");
+    PASSED;
+    std::cout << "[-------------- End container test : flat_hash_map -------------]" << std::endl;
+}
+
 } // namespace unordered_map_test
 
 } // namespace test
@@ -3,9 +3,12 @@
 
 // vector test : 测试 vector 的接口与 push_back 的性能
 
+#include <string>
 #include <vector>
 
 #include "../mytinystl/vector.h"
+#include "../mytinystl/memory_resource.h"
+#include "../mytinystl/astring.h"
 #include "test.h"
 
 namespace mystl
@@ -34,6 +37,8 @@ void vector_test()
     v8 = v3;
     v9 = std::move(v3);
     v10 = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    mystl::pmr::monotonic_buffer_resource arena;
+    mystl::pmr::vector<int> v11(&arena);
 
     FUN_AFTER(v1, v1.assign(8, 8));
     FUN_AFTER(v1, v1.assign(a, a + 5));
@@ -92,6 +97,24 @@ void vector_test()
     FUN_AFTER(v1, v1.shrink_to_fit());
     FUN_VALUE(v1.size());
     FUN_VALUE(v1.capacity());
+    FUN_AFTER(v11, v11.assign(a, a + 5));
+    FUN_AFTER(v11, v11.insert(v11.end(), v7.begin(), v7.end()));
+    FUN_AFTER(v11, v11.erase(v11.begin(), v11.begin() + 3));
+    // 扩容时插入容器自身的元素，元素不可平凡重定位
+    const std::string s0(32, 'a'), s1(32, 'b');
+    mystl::vector<std::string> v12;
+    v12.reserve(4);
+    v12.push_back(s0);
+    while(v12.size() < v12.capacity())
+        v12.push_back(s1);
+    v12.push_back(v12[0]);
+    EXPECT_TRUE((v12.back() == s0 && v12[0] == s0));
+    v12.resize(v12.capacity(), s1);
+    v12.emplace(v12.begin() + 3, v12[0]);
+    EXPECT_TRUE((v12[3] == s0 && v12[0] == s0 && v12[4] == s1));
+    v12.resize(v12.capacity(), s1);
+    v12.insert(v12.begin() + 1, v12[0]);
+    EXPECT_TRUE((v12[1] == s0 && v12[0] == s0 && v12[2] == s1));
     PASSED;
 #if PERFORMANCE_TEST_ON
     std::cout << "[--------------------- Performance Testing ---------------------]\n";
@@ -102,6 +125,14 @@ void vector_test()
 #else
     CON_TEST_P1(vector<int>, push_back, rand(), SCALE_L(LEN1), SCALE_L(LEN2), SCALE_L(LEN3));
 #endif
+    std::cout << "\n";
+    std::cout << "|---------------------|-------------|-------------|-------------|\n";
+    std::cout << "|  push_back(string)  |";
+    CON_TEST_P1(vector<mystl::string>, push_back, mystl::string(32, 'a'), SCALE_M(LEN1), SCALE_M(LEN2), SCALE_M(LEN3));
+    std::cout << "\n";
+    std::cout << "|---------------------|-------------|-------------|-------------|\n";
+    std::cout << "|   empty footprint   |";
+    VECTOR_FOOTPRINT_TEST(SCALE_S(LEN1), SCALE_S(LEN2), SCALE_S(LEN3));
     std::cout << "\n";
     std::cout << "|---------------------|-------------|-------------|-------------|\n";
     PASSED;